@@ -0,0 +1,70 @@
+#pragma once
+
+#include "db/Cache.h"
+#include "db/LogManager.h"
+#include "db/PagedFile.h"
+#include "db/Schema.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace mini_db {
+
+// ALTER TABLE ADD COLUMN 只修改元数据时追加的列（Schema::stored_columns 之后的列）：表数据文件中的记录
+// 保持追加前的定长布局，每个追加列单独存放在 <表文件>.col<列号> 中，行 row_id 的值位于 row_id * 列宽处。
+// 从未写过的位置读出全 0，即该列的默认值（INT 为 0，TEXT 为空字符串），因此追加列不改写已有数据，
+// 行下次被写入时才带上新列的值（惰性升级）。
+// 列文件不单独记日志：写入它的行修改都有整行 redo。一个列文件页包含多个数据页上的行，
+// 分属不同的日志分区，页写出前把全部分区刷盘。
+class AddedColumns {
+ public:
+  // path 为表文件路径，schema 为表的完整结构，cache 为每个列文件的页缓存配置，
+  // log 非空时启用列文件页的 WAL 约束。
+  AddedColumns(const std::string& path, const Schema& schema, size_t page_size, size_t cache_pages,
+               const CacheOptions& cache, LogManager* log);
+
+  AddedColumns(const AddedColumns&) = delete;
+  AddedColumns& operator=(const AddedColumns&) = delete;
+
+  // 为 schema 中新出现的追加列打开列文件（再次 ADD COLUMN 之后调用）。
+  void add(const Schema& schema);
+  // 只读映射全部列文件（压缩文件不映射，经页缓存读取）。
+  bool map_read_only(std::string* err);
+  // 数据文件中记录的长度（追加列之前的部分）。
+  size_t stored_size() const;
+  // 读取 row_id 的追加列，写入完整记录 record 中对应的位置。
+  bool read(uint64_t row_id, char* record, PageAccess access, std::string* err);
+  // 写入从 first_row 起 count 条完整记录（每条间隔 stride 字节）的追加列；logged 表示修改已写日志。
+  bool write(uint64_t first_row, const char* data, size_t stride, size_t count, bool logged,
+             std::string* err);
+  // 刷新全部列文件。
+  void flush(std::string* err);
+  // 列文件（压缩表同时包含各自的页映射）。
+  std::vector<std::string> paths() const;
+  // 全部列文件的 I/O 统计之和。
+  IoStats io_stats() const;
+
+ private:
+  struct Column {
+    size_t offset = 0;
+    size_t width = 0;
+    std::unique_ptr<PagedFile> file;
+  };
+
+  std::string path_;
+  size_t page_size_ = 0;
+  size_t cache_pages_ = 0;
+  CacheOptions cache_;
+  LogManager* log_ = nullptr;
+  size_t stored_size_ = 0;
+  std::vector<Column> columns_;
+  // 已写日志的修改按写入顺序编号，作为列文件页的 LSN：编号不超过某次刷盘时的值的修改，
+  // 其日志记录都已在那次刷盘前追加。
+  std::atomic<uint64_t> write_seq_{0};
+};
+
+}  // namespace mini_db
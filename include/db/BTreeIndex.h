@@ -0,0 +1,89 @@
+#pragma once
+
+#include "db/Index.h"
+#include "db/PagedFile.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace mini_db {
+
+// 磁盘 B+ 树索引：节点按页存放在独立的 PagedFile 中，经 NumaBufferPool 缓存。
+// 树中条目为 (保序键, 行号) 组合键，重复键因此也有唯一位置；叶子按右兄弟指针串联，
+// 支持点查、范围查找与有序遍历。删除只从叶子移除条目，不做合并（空叶子保留在链表中）。
+// 页 0 为元数据页：[魔数 BPT1][u32 键长][u64 根页号][u64 已分配页数][u8 已保存标记]。
+// 节点页：[u8 类型][u8 保留][u16 条目数][u32 保留][u64 右兄弟(叶子)/最左子节点(内部)][条目...]，
+// 叶子条目为组合键，内部节点条目为 组合键 + u64 子节点页号。
+class BTreeIndex : public Index {
+ public:
+  // type 为被索引列类型（决定保序编码），page_size / cache_pages / numa_nodes / cache 为索引文件的页配置。
+  BTreeIndex(const IndexDef& def, const std::string& path, size_t column_index, size_t key_offset,
+             size_t key_size, ColumnType type, size_t page_size, size_t cache_pages,
+             int numa_nodes, const CacheOptions& cache);
+
+  // 检查该键长在给定页大小下能否组成 B+ 树（每个节点至少容纳 4 个条目）。
+  static bool fits(size_t key_size, size_t page_size);
+
+  bool insert(const std::string& key, uint64_t row_id, bool enforce_unique,
+              std::string* err) override;
+  bool erase(const std::string& key, uint64_t row_id, std::string* err) override;
+  // 输出的行号按升序排列（组合键中同一键的条目按行号有序）。
+  bool lookup(const std::string& key, std::vector<uint64_t>* rows, std::string* err) override;
+  bool ordered() const override;
+  bool range(const std::string* low, bool low_inclusive, const std::string* high,
+             bool high_inclusive, std::vector<uint64_t>* rows, std::string* err) override;
+  bool erase_rows(const std::unordered_map<uint64_t, bool>& rows, std::string* err) override;
+  bool clear(std::string* err) override;
+
+  bool dirty() const override;
+  // 刷出全部节点页后写入已保存标记。
+  bool save(std::string* err) override;
+  // 打开索引文件；元数据无效或上次修改后未保存（可能崩溃于页写出中途）时返回 false。
+  bool load() override;
+
+ private:
+  // 解码后的节点：叶子只用 keys；内部节点 children.size() == keys.size() + 1。
+  struct Node {
+    bool leaf = true;
+    uint64_t next = 0;
+    std::vector<std::string> keys;
+    std::vector<uint64_t> children;
+  };
+
+  // 列编码键 <-> 保序键；组合键 = 保序键 + 大端行号。
+  std::string ordered_key(const std::string& key) const;
+  std::string entry_key(const std::string& key, uint64_t row_id) const;
+  uint64_t entry_row(const std::string& entry) const;
+
+  bool read_node(uint64_t page_id, Node* node, std::string* err);
+  bool write_node(uint64_t page_id, const Node& node, std::string* err);
+  bool write_meta(std::string* err);
+  // 首次修改前把已保存标记清零并落盘，保证崩溃后能识别不完整的树。
+  bool begin_modify_locked(std::string* err);
+  // 从根下降到 entry 所在叶子，path 记录经过的内部节点页号。
+  bool find_leaf(const std::string& entry, std::vector<uint64_t>* path, uint64_t* leaf_id,
+                 Node* leaf, std::string* err);
+  bool insert_locked(const std::string& entry, std::string* err);
+  // 顺着叶子链表收集 [start, ...) 中满足上界的行号。
+  bool scan_locked(const std::string& start, const std::string* low, bool low_inclusive,
+                   const std::string* high, bool high_inclusive, std::vector<uint64_t>* rows,
+                   std::string* err);
+  bool reset_locked(std::string* err);
+
+  ColumnType type_ = ColumnType::Int;
+  size_t page_size_ = 0;
+  size_t leaf_capacity_ = 0;
+  size_t internal_capacity_ = 0;
+  PagedFile file_;
+  uint64_t root_ = 1;
+  uint64_t page_count_ = 2;
+  // 磁盘上的元数据是否带有已保存标记。
+  bool saved_ = false;
+  // 树闩：节点读写共用页缓存，所有操作串行执行。
+  mutable std::mutex mutex_;
+};
+
+}  // namespace mini_db
@@ -7,7 +7,7 @@
 namespace mini_db {
 
 // 轻量页缓冲区：使用 NUMA 分配器在指定节点分配内存。
-// 单个页的内存缓冲区，负责按 NUMA 节点分配/释放内存。Page 持有一个 Buffer 对象
+// 按 NUMA 节点分配/释放的一段内存，用作日志缓冲与页缓存分片的帧内存池。
 class Buffer {
  public:
   Buffer() = default;
@@ -23,10 +23,12 @@ class Buffer {
   size_t size() const;
   int node() const;
 
-  // 重新分配缓冲区（原内存会释放）。
-  void reset(size_t size, int node, NumaAllocator* allocator);
+  // 重新分配缓冲区（原内存会释放）。zero 为 false 时不清零：物理页在首次写入时才分配。
+  void reset(size_t size, int node, NumaAllocator* allocator, bool zero = true);
   // 清零缓冲区内容。
   void zero();
+  // 把 [offset, offset + size) 中完整的系统页归还给内核（地址仍然有效，再次访问时内容为 0）。
+  void discard(size_t offset, size_t size);
 
  private:
   void release();
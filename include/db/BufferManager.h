@@ -0,0 +1,83 @@
+#pragma once
+
+#include "db/Cache.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace mini_db {
+
+// 全库共享的帧预算配置。
+struct BufferBudgetOptions {
+  // 是否由全库共享预算管理所有表数据文件的缓存：Database 的 cache_pages 为全库页数
+  // （按节点均分），关闭时每个表各自使用 cache_pages 页。
+  bool shared = true;
+  // 重新分配周期（毫秒），0 表示只在表加入/移除时均分。
+  uint32_t interval_ms = 100;
+  // 每个分片至少保留的页数。
+  size_t min_pages = 8;
+  // 单轮在两个分片之间移动的页数（占节点预算的百分比，至少 1 页）。
+  uint32_t step_percent = 5;
+};
+
+// 返回缓冲预算方式的描述（启动信息使用）。
+const char* buffer_budget_name(const BufferBudgetOptions& options);
+
+// 全库缓冲管理器：按节点把帧预算分给各表缓冲池中该节点的缓存分片。
+// 分片加入或移除时同节点的分片均分预算；后台线程周期统计各分片的缺页数（指数平滑后作为缺页压力），
+// 把帧配额从压力最低（同压力时命中最少）的分片移给已用满配额、压力明显更高的分片。
+class BufferManager {
+ public:
+  BufferManager(size_t total_pages, const BufferBudgetOptions& options);
+  ~BufferManager();
+
+  BufferManager(const BufferManager&) = delete;
+  BufferManager& operator=(const BufferManager&) = delete;
+
+  // 启动/停止后台调整线程。
+  void start();
+  void stop();
+
+  // 登记 / 移除 node 节点上的缓存分片（分片析构前必须移除）。
+  void add_shard(int node, PageCache* shard);
+  void remove_shard(PageCache* shard);
+  // 执行一轮调整。
+  void rebalance();
+
+  // 返回每个节点的预算页数。
+  size_t node_budget() const;
+  // 返回调整线程累计移动的帧配额页数。
+  uint64_t moved_pages() const;
+
+ private:
+  struct Member {
+    PageCache* shard = nullptr;
+    int node = 0;
+    uint64_t last_hits = 0;
+    uint64_t last_misses = 0;
+    // 缺页压力：每轮缺页数的指数平滑。
+    double pressure = 0.0;
+  };
+
+  // 调用方持有 mutex_：把每个节点的预算在该节点的分片间均分。
+  void assign_equal();
+  // 调用方持有 mutex_：按当前登记的最大节点号计算每节点预算。
+  size_t node_budget_locked() const;
+  void run_loop();
+
+  size_t total_pages_ = 0;
+  BufferBudgetOptions options_;
+  mutable std::mutex mutex_;
+  std::vector<Member> members_;
+  uint64_t moved_pages_ = 0;
+  std::thread thread_;
+  std::condition_variable cv_;
+  bool running_ = false;
+  bool stop_ = false;
+};
+
+}  // namespace mini_db
@@ -1,24 +1,46 @@
 #pragma once
 
+#include "db/BufferManager.h"
 #include "db/Cache.h"
 #include "db/Numa.h"
 #include "db/PageRouter.h"
 
+#include <atomic>
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace mini_db {
 
 // NUMA 感知的 BufferPool：将缓存分片到不同节点。整个缓冲池，内部按 NUMA 节点分片成多个 PageCache
+// 页归属节点由 options.placement 选出的 PageNodeSelector 决定；Adaptive 策略下普通访问按访问线程
+// 所在节点计数，远端访问占优的页把页帧迁到该节点的分片（页须干净且未被钉住，否则留待下次）。
 class NumaBufferPool {
  public:
-  // preferred_nodes 可指定节点数量（0 表示自动探测或使用环境变量）。
-  NumaBufferPool(Pager* pager, size_t capacity, size_t page_size, int preferred_nodes);
+  // preferred_nodes 可指定节点数量（0 表示自动探测或使用环境变量），options 为各分片的缓存配置。
+  NumaBufferPool(Pager* pager, size_t capacity, size_t page_size, int preferred_nodes,
+                 const CacheOptions& options);
+  // 从缓冲管理器中移除各分片。
+  ~NumaBufferPool();
 
-  // 获取页缓存（根据页归属节点路由到对应分片）。
-  Page* get_page(size_t page_id, std::string* err);
-  // 标记脏页。
-  void mark_dirty(size_t page_id);
+  NumaBufferPool(const NumaBufferPool&) = delete;
+  NumaBufferPool& operator=(const NumaBufferPool&) = delete;
+
+  // 把各分片登记到全库缓冲管理器，由它按节点分配帧配额（capacity 为单个分片的帧上限）。
+  // nullptr 表示不受管理；已登记的分片会先移除。
+  void set_buffer_manager(BufferManager* manager);
+
+  // 为每个分片设置 WAL 接口：make_gate(node) 返回页所属节点（分片下标）对应日志分区的接口。
+  void set_wal(const std::function<WalGate(int node)>& make_gate);
+  // 获取并钉住页（根据页归属节点路由到对应分片），失败时返回空句柄。
+  // Scan 访问按页号顺序推进时，自动向各页所属分片提交后续页的异步预读。
+  PageGuard get_page(size_t page_id, PageGuard::Mode mode, PageAccess access, std::string* err);
+  // 乐观读页内数据（见 PageCache::read_optimistic）。页帧会迁移的策略查分片要持迁移锁，总是返回 false。
+  bool read_optimistic(size_t page_id, size_t offset, size_t size, char* out);
   // 刷新所有分片中的脏页。
   void flush(std::string* err);
 
@@ -26,16 +48,55 @@ class NumaBufferPool {
   int node_count() const;
   // 返回每个 NUMA 节点缓存中的页数量。
   std::vector<size_t> cached_pages_per_node() const;
+  // 返回页的归属节点（日志分区、扫描分工与文件映射按它划分，同一页始终不变）。
+  int node_for_page(size_t page_id) const;
+  // 返回页帧当前所在的节点（缓存分片下标）：未迁移时即归属节点，按页路由任务时应使用它。
+  int frame_node_for_page(size_t page_id) const;
+  // 返回已完成的页帧迁移次数。
+  uint64_t page_migrations() const;
+  // 返回各分片命中统计之和。
+  CacheStats stats() const;
+  // 返回每个分片（下标为节点）的统计。
+  std::vector<CacheStats> shard_stats() const;
+  // 返回各分片当前缓存中的页号（下标为分片，见 PageCache::resident_pages）。
+  std::vector<std::vector<size_t>> resident_pages() const;
+  // 预热 node 分片：把 page_ids 中页帧位于该节点的页读入（见 PageCache::warm），其余的页忽略。
+  size_t warm(int node, const std::vector<size_t>& page_ids, bool* full);
 
  private:
+  // 迁移表分段：记录页帧不在归属节点的页。访问持共享锁查表并在分片中钉住页，迁移只尝试独占锁，
+  // 不会与等待页闩的访问者互相等待。
+  struct PlacementStripe {
+    mutable std::shared_mutex mutex;
+    std::unordered_map<size_t, int> moved;
+  };
+  static constexpr size_t kPlacementStripes = 64;
+
   // 根据页号选择其所属分片。
   PageCache& shard_for_page(size_t page_id);
+  // 调用方持有 stripe 的锁，返回页帧所在节点。
+  int frame_node_locked(const PlacementStripe& stripe, size_t page_id) const;
+  // 把页帧迁到 target 节点：先从所有分片移除该页（含预读留下的副本），之后的访问在目标分片装入。
+  void migrate(size_t page_id, int target);
+  // 当前线程所在节点：执行器工作线程使用其所属节点，其他线程按所在 CPU 查询。
+  int accessing_node() const;
+  // 顺序扫描检测：扫描进入下一页且已提交的预读不足半个窗口时，把窗口推进并按分片提交预读。
+  void read_ahead(size_t page_id);
 
   std::unique_ptr<NumaTopology> topology_;
   std::unique_ptr<NumaAllocator> allocator_;
   std::unique_ptr<PageNodeSelector> selector_;
   std::vector<std::unique_ptr<PageCache>> shards_;
+  // 迁移表（仅在策略会迁移页帧时使用）。
+  std::unique_ptr<PlacementStripe[]> placement_;
+  std::atomic<uint64_t> migrations_{0};
+  BufferManager* buffer_manager_ = nullptr;
+  Pager* pager_ = nullptr;
   size_t page_size_ = 0;
+  // 预读窗口（0 表示不预读）、上次扫描访问的页与已提交预读的页号上界（不含）。
+  size_t readahead_window_ = 0;
+  std::atomic<size_t> last_scan_page_{SIZE_MAX};
+  std::atomic<size_t> readahead_end_{0};
 };
 
 }  // namespace mini_db
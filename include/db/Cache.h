@@ -1,61 +1,338 @@
 #pragma once
 
 #include "db/Buffer.h"
+#include "db/Metrics.h"
+#include "db/PageRouter.h"
 #include "db/Pager.h"
+#include "db/ReplacementPolicy.h"
 
-#include <list>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
 #include <memory>
 #include <mutex>
+#include <shared_mutex>
 #include <string>
-#include <unordered_map>
+#include <thread>
+#include <utility>
 #include <vector>
 
 namespace mini_db {
 
-// 单页缓存结构，包含页号、数据与脏标记。每个 Page 用一个 Buffer 来管理内存。
+class PageCache;
+
+// 后台写页线程配置。
+struct PageWriterOptions {
+  // 是否为每个缓存分片启动后台写页线程（绑定到分片所在 NUMA 节点）。
+  bool enabled = true;
+  // 周期唤醒间隔（毫秒）。
+  uint32_t interval_ms = 20;
+  // 脏页数达到分片容量的该百分比时提前唤醒。
+  uint32_t dirty_percent = 25;
+  // 单轮最多写出的页数（0 表示不限）。
+  size_t max_batch_pages = 256;
+};
+
+// 顺序扫描预读配置。
+struct ReadAheadOptions {
+  // 是否对顺序扫描预读（每个缓存分片一个绑定到所在 NUMA 节点的预读线程）。
+  bool enabled = true;
+  // 预读窗口（页数）：检测到顺序扫描后保持当前页之后最多这么多页已提交读取。
+  size_t window_pages = 32;
+  // 每个分片的扫描环帧数：扫描装入的页达到该数量后，新扫描页复用环中最早的帧，
+  // 大表扫描不会挤掉热点页（不超过分片容量的 1/4，0 表示不启用）。
+  size_t scan_ring_pages = 64;
+};
+
+// 页缓存配置。
+struct CacheOptions {
+  // 替换策略。
+  CachePolicy policy = CachePolicy::Lru;
+  // 后台写页线程。
+  PageWriterOptions writer;
+  // 页文件 I/O 后端（由 PagedFile 创建 Pager 时使用）。
+  PagerOptions io;
+  // 顺序扫描预读与扫描环。
+  ReadAheadOptions readahead;
+  // 页在各 NUMA 节点间的分布策略。
+  PlacementOptions placement;
+  // 乐观读：命中的页按版本校验无锁复制，不加分片锁、不钉页、不取页闩（关闭时 read_optimistic 总是失败）。
+  bool optimistic_reads = true;
+};
+
+// 缓存分片的命中统计与容量。
+struct CacheStats {
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+  // 淘汰的页数、写出的脏页数（其中缺页时在前台同步写回的页数）、预读与预热读入的页数。
+  uint64_t evictions = 0;
+  uint64_t pages_written = 0;
+  uint64_t sync_writes = 0;
+  uint64_t prefetched = 0;
+  // 当前缓存页数、配额与帧上限。
+  size_t pages = 0;
+  size_t limit = 0;
+  size_t capacity = 0;
+
+  // 累加另一个分片（或表）的统计。
+  void add(const CacheStats& other);
+};
+
+// 数据页与预写日志的协作接口（WAL 规则：页写出前，修改它的日志记录必须已落盘）。
+struct WalGate {
+  // 返回已落盘的最大 LSN（不触发刷盘）。
+  std::function<uint64_t()> durable_lsn;
+  // 刷日志直到 lsn 落盘。
+  std::function<bool(uint64_t lsn, std::string* err)> flush_to;
+};
+
+// 缓存帧：页号、数据与脏标记。帧在分片构造时一次性创建，数据指向分片的帧内存池。
 struct Page {
-  size_t id = 0;
-  // 页数据缓冲区，使用 NUMA 分配器按节点分配。
-  Buffer data;
-  bool dirty = false;
+  // version 的低两位：帧未装入有效页 / 写者持写闩修改中。
+  static constexpr uint64_t kVersionInvalid = 1;
+  static constexpr uint64_t kVersionWriting = 2;
+
+  // 页号（乐观读无锁读取，帧换页时改写）。
+  std::atomic<size_t> id{0};
+  // 页数据，位于所属分片的节点本地连续内存中。
+  char* data = nullptr;
+  size_t size = 0;
+  std::atomic<bool> dirty{false};
+  // 页 LSN：修改该页的最新日志记录（页所属节点的日志分区内），0 表示无需等待日志。
+  std::atomic<uint64_t> lsn{0};
+  // 是否已在分片的脏页队列中（保证每帧最多排队一次）。
+  std::atomic<bool> queued{false};
+  // 是否在分片的扫描环中（扫描装入、尚未被普通访问命中）。
+  std::atomic<bool> in_scan_ring{false};
+  // 预读失败：帧已移出页表，等在页闩上的访问者放弃该帧并重新装载。
+  std::atomic<bool> io_failed{false};
+  // 页 LSN 所属的 WAL 接口下标（页的归属节点；页帧迁移到其他分片后仍按归属节点的日志等待）。
+  int wal_gate = 0;
+  PageCache* owner = nullptr;
+  int32_t frame = -1;
   int numa_node = -1;
+  // 钉住计数：大于 0 时页不会被淘汰（只在分片锁内增加，释放时可无锁减少）。
+  std::atomic<int> pin_count{0};
+  // 页内容闩：读者共享、写者独占；刷盘时共享持有，避免写出更新到一半的页。
+  std::shared_mutex latch;
+  // 页版本：写闩期间置 kVersionWriting、放闩时推进计数，帧淘汰时置 kVersionInvalid、装入新页后清除。
+  // 乐观读者复制页内数据前后各读一次，两次相同且低两位为 0 时复制的内容有效。
+  std::atomic<uint64_t> version{kVersionInvalid};
+  // 乐观读命中过：乐观读不经过替换策略，淘汰选中该帧时先补记一次命中，给它第二次机会。
+  std::atomic<bool> referenced{false};
 };
 
-// 简易 LRU 页缓存，负责与 Pager 协作提升访问性能。单个缓存分片，内部每个缓存页是 Page
+// 页句柄（RAII）：持有期间页被钉住且持有对应模式的页闩，析构时自动释放。
+// 只可移动不可复制；空句柄表示获取失败。
+class PageGuard {
+ public:
+  enum class Mode {
+    Read,
+    Write,
+  };
+
+  PageGuard() = default;
+  // page 须已被钉住（pin_count 已加一），构造时获取页闩。
+  PageGuard(Page* page, Mode mode);
+  ~PageGuard();
+
+  PageGuard(PageGuard&& other) noexcept;
+  PageGuard& operator=(PageGuard&& other) noexcept;
+  PageGuard(const PageGuard&) = delete;
+  PageGuard& operator=(const PageGuard&) = delete;
+
+  explicit operator bool() const;
+  size_t page_id() const;
+  size_t size() const;
+  const char* data() const;
+  // 写模式下返回可修改的页数据，修改后需调用 mark_dirty。
+  char* mutable_data();
+  void mark_dirty();
+  // 标记脏页并记录本次修改对应的日志 LSN，页写出前日志须先持久化到该 LSN。
+  void mark_dirty(uint64_t lsn);
+  // 提前释放页闩与钉住计数。
+  void release();
+
+ private:
+  Page* page_ = nullptr;
+  Mode mode_ = Mode::Read;
+};
+
+// 页缓存分片，负责与 Pager 协作提升访问性能，内部每个缓存页是 Page。替换策略可插拔（见 ReplacementPolicy）。
+// 构造时在节点上一次性分配 capacity 个帧的连续内存池（MINI_DB_HUGE_PAGES=1 时建议内核使用透明大页），
+// 页表为开放寻址哈希，稳态下缺页与淘汰都不做堆分配。
+// 分片锁为读写锁：缺页与淘汰持独占锁；策略支持无锁命中（CLOCK）时，命中只持共享锁查页表并钉住。
+// 脏页进入分片的脏页队列，由后台写页线程按页号排序、相邻页合并写出，缺页时优先淘汰干净页，
+// 前台只在没有干净页可淘汰时才同步写回。任何写出都先按页 LSN 等待日志持久化。
+// 扫描页经预读线程批量读入，并限制在一个小的扫描环内轮换。
 class PageCache {
  public:
-  // capacity 为最大缓存页数，page_size 为每页字节大小。
-  // node_id 为该缓存分片所属 NUMA 节点，allocator 负责在该节点分配内存。
+  // capacity 为最大缓存页数（至少 1），page_size 为每页字节大小。
+  // node_id 为该缓存分片所属 NUMA 节点，allocator 负责在该节点分配内存，options 为策略与写页线程配置。
   PageCache(Pager* pager, size_t capacity, size_t page_size, int node_id,
-            NumaAllocator* allocator);
+            NumaAllocator* allocator, const CacheOptions& options);
+  // 停止后台写页线程（不刷脏页，由调用方先 flush）。
+  ~PageCache();
+
+  PageCache(const PageCache&) = delete;
+  PageCache& operator=(const PageCache&) = delete;
+
+  // 设置该分片对应日志分区的 WAL 接口（未设置表示该文件不受日志保护，可直接写出）。
+  // 须在并发访问开始前调用。
+  void set_wal(WalGate wal);
+  // 同上，分片中的页可能属于不同日志分区：gate_for_page(page_id) 返回页装入时使用的 gates 下标。
+  void set_wal(std::vector<WalGate> gates, std::function<int(size_t page_id)> gate_for_page);
 
-  // 获取指定页；若缓存未命中则从磁盘加载并可能触发淘汰。
-  Page* get_page(size_t page_id, std::string* err);
-  // 标记页为脏页，flush 时会写回磁盘。
-  void mark_dirty(size_t page_id);
+  // 获取并钉住指定页；若缓存未命中则从磁盘加载并可能触发淘汰。失败时返回空句柄。
+  // access 为访问提示（Scan 表示顺序扫描，不应挤掉热点页）。
+  // 所有帧都被钉住时让出 CPU 等待其他线程释放（帧只在单次读写期间被钉住）。
+  PageGuard get_page(size_t page_id, PageGuard::Mode mode, PageAccess access, std::string* err);
+  // 乐观读：page_id 在缓存中时无锁复制页内 [offset, offset + size) 到 out，按页版本校验，
+  // 复制期间页被修改或换出时重试，仍失败（或未命中、页在扫描环中）返回 false，调用方改走 get_page。
+  bool read_optimistic(size_t page_id, size_t offset, size_t size, char* out);
+  // 把 page_ids 加入预读队列，由分片的预读线程批量读入（不在缓存中的页按扫描页装入）。
+  // 未启用预读或队列已满时忽略。
+  void prefetch_async(const std::vector<size_t>& page_ids);
+  // 返回当前缓存中的页号（升序，不含扫描环中的页），用于保存预热列表。
+  std::vector<size_t> resident_pages() const;
+  // 预热：把 page_ids 中不在缓存里的页按普通访问批量读入，只使用配额内的空闲帧、不淘汰已有的页。
+  // 返回读入的页数；full 非空时输出缓存是否已满（剩余的页不再装入）。
+  size_t warm(const std::vector<size_t>& page_ids, bool* full);
   // 刷新所有脏页到磁盘。
   void flush(std::string* err);
+  // 把干净且未被钉住的 page_id 移出缓存（不在缓存中也返回 true）；页被钉住或为脏页时返回 false。
+  bool discard_clean(size_t page_id);
   // 返回当前缓存中的页数量。
   size_t page_count() const;
+  // 返回帧上限（构造时的 capacity）。
+  size_t capacity() const;
+  // 设置配额（1..capacity）：缺页在缓存页数达到配额后改为淘汰，不再占用空闲帧。
+  // 配额降低时立即淘汰多出的干净且未被钉住的页并把帧内存归还给内核，其余在之后的调整中回收。
+  void set_limit(size_t pages);
+  size_t limit() const;
+  // 返回命中统计与容量。
+  CacheStats stats() const;
 
  private:
-  // 单个页对象条目：页对象 + LRU 链表迭代器。
-  struct Entry {
-    Page page;
-    std::list<size_t>::iterator lru_it; // 指向该页在 lru_ 里的位置，便于 O(1) 更新
-  };
+  friend class PageGuard;
+
+  static constexpr int32_t kNoFrame = -1;
+  // 单次合并写出的最大相邻页数。
+  static constexpr size_t kMaxWriteRun = 32;
+  // 乐观读在版本校验失败后的最多尝试次数。
+  static constexpr int kOptimisticAttempts = 3;
+
+  // 页由干净变脏时调用：加入脏页队列，wake_writer 为 true 且超过阈值时唤醒写页线程
+  // （写出失败或日志未落盘而重新排队时不唤醒，避免写页线程空转）。
+  void enqueue_dirty(Page* page, bool wake_writer);
+  // 写出脏页队列中最多 limit 个页（0 表示全部），按页号排序并合并相邻页。
+  // force_wal=false（后台写页）时不主动刷日志，日志尚未落盘的页留在队列中等待下一轮。
+  bool write_dirty(size_t limit, bool force_wal, std::string* err);
+  // 写出一段页号连续、已钉住并持共享闩的脏页。
+  bool write_run(const std::vector<Page*>& run, std::string* err);
+  // 页 LSN 是否已在 gate 对应的日志分区落盘（必要时向日志查询最新的落盘位置，不触发刷盘）。
+  bool wal_durable(int gate, uint64_t lsn);
+  // 后台写页线程主循环。
+  void writer_loop();
+  // 预读一批页：在分片锁内占帧、钉住并持写闩后，于锁外一次批量读取，完成后放闩。
+  void prefetch(const std::vector<size_t>& page_ids);
+  // 批量装入最多 max_pages 个不在缓存中的页：在分片锁内占帧、钉住并持写闩后，于锁外一次批量读取。
+  // free_only 为 true 时只使用空闲帧（取不到时置 *full），否则按 access 取帧（可能淘汰）。返回读入的页数。
+  size_t load_pages(const std::vector<size_t>& page_ids, PageAccess access, size_t max_pages,
+                    bool free_only, bool* full);
+  // 预读线程主循环。
+  void prefetch_loop();
+  // 扫描环已满时从最早进入环的帧中选一个未被钉住的干净帧，没有则返回 kNoFrame。
+  int32_t scan_ring_victim();
+  // 帧装入扫描页时加入扫描环；离开缓存或被普通访问命中时移出。
+  void enter_scan_ring(int32_t frame);
+  void leave_scan_ring(Page& page);
 
-  // 如果缓存已满则淘汰最久未使用页。
-  bool evict_if_needed(std::string* err);
+  // 开放寻址页表：page_id -> 帧下标（线性探测，删除时后移填补空位）。
+  size_t slot_for(size_t page_id) const;
+  int32_t find_frame(size_t page_id) const;
+  // 不持分片锁查页表：并发删除可能漏查，调用方须用页版本与页号确认结果。
+  int32_t find_frame_unlocked(size_t page_id) const;
+  void insert_frame(size_t page_id, int32_t frame);
+  void erase_frame(size_t page_id);
+  // 取得一个可用帧：优先使用空闲帧，扫描页在扫描环满时复用环中最早的帧，
+  // 否则由替换策略选出未被钉住的页淘汰（优先干净页）。
+  // 输出 kNoFrame 表示当前全部帧被钉住，或牺牲页的日志尚未落盘（wal_gate / wal_lsn 输出需等待的
+  // 日志分区与 LSN，调用方须在分片锁外刷日志后重试）。
+  bool acquire_frame(int32_t* frame, int* wal_gate, uint64_t* wal_lsn, PageAccess access,
+                     std::string* err);
+  // 把帧移出页表与替换策略（调用方持独占分片锁，帧未被钉住）。
+  void evict_frame(int32_t frame);
+  // 由替换策略选出牺牲帧；乐观读命中过的帧先补记命中并清除标记，再重新选择。
+  int32_t pick_victim(const std::function<bool(int32_t)>& evictable);
+  // 记一次命中。
+  void count_hit();
+  // 扫描环的实际大小：不超过配额的 1/4。
+  size_t scan_ring_limit() const;
+  // 刷 gate 对应的日志到 lsn（调用方不持分片锁），并记录本分片已确认落盘的 LSN。
+  bool flush_wal(int gate, uint64_t lsn, std::string* err);
+  // 页装入帧时使用的 WAL 接口下标。
+  int wal_gate_for(size_t page_id) const;
 
   Pager* pager_ = nullptr;
   size_t capacity_ = 0;
   size_t page_size_ = 0;
   int node_id_ = 0;                         // 对应的是哪个 numa node， 该页缓存分片绑定在哪个 numa 节点
   NumaAllocator* allocator_ = nullptr;      // 用于在指定节点分配内存的 NUMA 分配器
-  mutable std::mutex mutex_;
-  std::list<size_t> lru_;       // 保存 page_id 的 LRU 顺序， front 是最近使用，back 最久未使用
-  std::unordered_map<size_t, Entry> pages_;
+  mutable std::shared_mutex mutex_;
+  // 帧内存池与固定帧表。
+  Buffer arena_;
+  std::unique_ptr<Page[]> frames_;
+  // 空闲帧栈与页表槽位，均在构造时按容量预分配。
+  std::vector<int32_t> free_frames_;
+  // 页表槽位为原子量：修改只在独占分片锁内，乐观读不持锁查表。
+  std::unique_ptr<std::atomic<int32_t>[]> table_;
+  size_t table_mask_ = 0;
+  bool optimistic_reads_ = true;
+  std::unique_ptr<ReplacementPolicy> policy_;
+  size_t used_ = 0;
+  std::atomic<size_t> limit_{0};
+  // 命中、缺页与写出等计数（按线程分条，无锁命中路径不与分片锁互相争用）。
+  Counter hits_;
+  Counter misses_;
+  Counter evictions_;
+  Counter pages_written_;
+  Counter sync_writes_;
+  Counter prefetched_;
+  // 各日志分区的 WAL 接口（通常只有分片所属节点一个）与页到接口下标的映射。
+  std::vector<WalGate> wal_;
+  std::function<int(size_t page_id)> wal_for_page_;
+  // 本分片已确认落盘的各分区日志 LSN，不超过它的页无需再等待日志。
+  std::unique_ptr<std::atomic<uint64_t>[]> wal_durable_;
+  // 脏页队列（帧下标），容量预分配为帧数。
+  std::mutex dirty_mutex_;
+  std::vector<int32_t> dirty_frames_;
+  // 串行化写出轮次：flush 返回时写页线程已取出的页也已写完。
+  std::mutex write_mutex_;
+  // 后台写页线程。
+  PageWriterOptions writer_options_;
+  size_t dirty_wakeup_ = 0;
+  std::thread writer_;
+  std::condition_variable writer_cv_;
+  bool writer_stop_ = false;
+  bool writer_wakeup_ = false;
+  // 扫描环：按进入顺序记录（帧, 序号），序号与帧当前序号不符的条目已失效，惰性出队。
+  size_t scan_ring_pages_ = 0;
+  std::atomic<size_t> scan_ring_count_{0};
+  std::deque<std::pair<int32_t, uint64_t>> scan_ring_;
+  std::vector<uint64_t> scan_ring_seq_;
+  uint64_t next_ring_seq_ = 0;
+  // 预读失败后仍被访问者钉住的帧，解除钉住后回收到空闲帧栈。
+  std::vector<int32_t> failed_frames_;
+  // 预读线程与预读队列。
+  size_t prefetch_limit_ = 0;
+  std::mutex prefetch_mutex_;
+  std::vector<size_t> prefetch_queue_;
+  std::thread prefetcher_;
+  std::condition_variable prefetch_cv_;
+  bool prefetch_stop_ = false;
 };
 
 }  // namespace mini_db
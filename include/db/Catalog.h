@@ -2,6 +2,7 @@
 
 #include "db/Schema.h"
 
+#include <cstdint>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -9,6 +10,7 @@
 namespace mini_db {
 
 // Catalog 管理器：保存表名与 Schema 的映射，并持久化到元数据文件。
+// 每个表还分配一个稳定的数字 ID，日志记录中用它代替表名。
 class Catalog {
  public:
   // path 为 catalog 文件路径（例如 catalog.meta）。
@@ -23,16 +25,30 @@ class Catalog {
   bool create_table(const std::string& name, const Schema& schema, std::string* err);
   // 删除表结构记录。
   bool drop_table(const std::string& name, std::string* err);
-  // 为表新增列（仅修改元数据）。
-  bool alter_add_column(const std::string& name, const Column& column, std::string* err);
+  // 为表新增列（仅修改元数据），stored_columns 为之后表数据文件中记录包含的列数。
+  bool alter_add_column(const std::string& name, const Column& column, size_t stored_columns,
+                        std::string* err);
   // 获取指定表结构。
   bool get_schema(const std::string& name, Schema* schema) const;
   // 列出所有表名。
   std::vector<std::string> list_tables() const;
+  // 为表登记索引定义 / 删除索引定义。
+  bool create_index(const std::string& table, const IndexDef& index, std::string* err);
+  bool drop_index(const std::string& table, const std::string& index, std::string* err);
+  // 获取表上的全部索引定义。
+  std::vector<IndexDef> get_indexes(const std::string& table) const;
+  // 获取表 ID（表不存在返回 false）。
+  bool get_table_id(const std::string& name, uint32_t* table_id) const;
+  // 加载时是否为旧格式的表补分配了 ID（需要回写 catalog）。
+  bool needs_save() const;
 
  private:
   std::string path_;
   std::unordered_map<std::string, Schema> schemas_;
+  std::unordered_map<std::string, uint32_t> table_ids_;
+  std::unordered_map<std::string, std::vector<IndexDef>> indexes_;
+  uint32_t next_table_id_ = 1;
+  bool needs_save_ = false;
 };
 
 }  // namespace mini_db
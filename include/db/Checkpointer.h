@@ -0,0 +1,65 @@
+#pragma once
+
+#include "db/LogManager.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace mini_db {
+
+// 检查点配置：按时间间隔或日志大小触发后台检查点。
+struct CheckpointOptions {
+  // 周期触发间隔（毫秒），0 表示不按时间触发。
+  uint64_t interval_ms = 1000;
+  // 日志字节阈值，超过后提前触发检查点，0 表示不按日志大小触发。
+  size_t log_bytes_threshold = 64 * 1024 * 1024;
+};
+
+// 后台检查点线程：定期或在日志过大时执行检查点，前台写入无需等待刷盘。
+class Checkpointer {
+ public:
+  // run 执行一次完整检查点，成功时输出各日志分区的检查点 LSN。
+  using CheckpointFn = std::function<bool(std::vector<uint64_t>* lsns, std::string* err)>;
+
+  Checkpointer(LogManager* log, const CheckpointOptions& options, CheckpointFn run);
+  ~Checkpointer();
+
+  Checkpointer(const Checkpointer&) = delete;
+  Checkpointer& operator=(const Checkpointer&) = delete;
+
+  // 启动/停止后台线程（stop 不会执行额外的检查点）。
+  void start();
+  void stop();
+  // 前台写入后调用：所写分区的日志超过其阈值份额时唤醒后台线程（只读该分区的原子变量）。
+  void notify_write(int partition);
+
+  // 返回最近一次成功检查点的各分区 LSN（空表示尚未执行）。
+  std::vector<uint64_t> last_checkpoint_lsns() const;
+  // 返回后台检查点最近一次失败的错误信息。
+  std::string last_error() const;
+
+ private:
+  // 后台线程主循环。
+  void run_loop();
+
+  LogManager* log_ = nullptr;
+  CheckpointOptions options_;
+  CheckpointFn run_;
+  std::thread thread_;
+  mutable std::mutex mutex_;
+  std::condition_variable cv_;
+  bool running_ = false;
+  bool stop_ = false;
+  std::atomic<bool> requested_{false};
+  std::vector<uint64_t> last_lsns_;
+  std::string last_error_;
+};
+
+}  // namespace mini_db
@@ -1,33 +1,94 @@
 #pragma once
 
+#include "db/BufferManager.h"
 #include "db/Catalog.h"
+#include "db/Checkpointer.h"
 #include "db/LogManager.h"
+#include "db/NumaExecutor.h"
 #include "db/TableStorage.h"
+#include "db/Transaction.h"
+#include "db/Warmup.h"
 
+#include <atomic>
+#include <functional>
 #include <memory>
 #include <mutex>
+#include <shared_mutex>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
 namespace mini_db {
 
+// 数据库运行配置（可选项，均有默认值）。
+struct DatabaseOptions {
+  // 后台检查点配置。
+  CheckpointOptions checkpoint;
+  // 预写日志配置（提交持久化模式、组提交延迟等）。
+  LogOptions log;
+  // 表页缓存配置（替换策略、后台写页线程）。
+  CacheOptions cache;
+  // 只读打开（表文件 mmap 直接读取，拒绝 DDL/DML，日志须已全部应用）。
+  ReadOnlyOptions read_only;
+  // 全表扫描的 morsel 并行配置。
+  ScanOptions scan;
+  // 全库共享的缓存帧预算。
+  BufferBudgetOptions buffer;
+  // 重启后的缓冲池预热。
+  WarmupOptions warmup;
+  // 按表覆盖表数据文件的页分布策略（键为小写表名），未列出的表使用 cache.placement。
+  std::unordered_map<std::string, PlacementOptions> table_placement;
+};
+
+// 全库统计快照（见 Database::stats），各项自打开起累计。
+struct DatabaseStats {
+  // 全部表数据文件的缓存统计，以及按节点（缓存分片）汇总的统计。
+  CacheStats cache;
+  std::vector<CacheStats> cache_per_node;
+  uint64_t page_migrations = 0;
+  // 全部表文件的 I/O 统计与表锁 / 页锁等待。
+  IoStats io;
+  LockStats locks;
+  // 日志统计：合计与按分区。
+  LogStats log;
+  std::vector<LogStats> log_per_partition;
+  // 扫描执行器按节点的统计（未启用并行扫描时为空）。
+  std::vector<NumaExecutorStats> executor_per_node;
+};
+
 // 数据库入口：管理 Catalog、日志与多个表实例，提供 DDL/DML 统一接口。
 class Database {
  public:
-  // base_dir 为数据目录，page_size/ cache_pages 用于表文件与缓存配置。
+  // base_dir 为数据目录，page_size/ cache_pages 用于表文件与缓存配置
+  // （buffer.shared 时 cache_pages 为所有表数据文件共享的页数，否则为每个表的页数）。
   // numa_nodes 为 NUMA 节点数配置（便于后续扩展到多路 NUMA）。
   Database(const std::string& base_dir, size_t page_size, size_t cache_pages, int numa_nodes);
+  Database(const std::string& base_dir, size_t page_size, size_t cache_pages, int numa_nodes,
+           const DatabaseOptions& options);
+  ~Database();
+
+  Database(const Database&) = delete;
+  Database& operator=(const Database&) = delete;
 
   // 打开数据库（加载 catalog、表文件，并做恢复）。
+  // 只读打开时不做恢复，日志中仍有未应用的记录则失败。
   bool open(std::string* err);
-  // 关闭数据库（执行检查点与刷盘）。
+  // 关闭数据库（停止后台检查点，执行最终检查点与刷盘）。
   void close(std::string* err);
+  // 立即执行一次检查点（阻塞直到刷盘完成）。
+  bool checkpoint(std::string* err);
 
   // DDL：创建/删除表、添加列。
   bool create_table(const std::string& name, const std::vector<Column>& columns, std::string* err);
+  // 指定表选项（数据页布局、是否压缩）创建表。
+  bool create_table(const std::string& name, const std::vector<Column>& columns,
+                    const TableOptions& options, std::string* err);
   bool drop_table(const std::string& name, std::string* err);
   bool alter_add_column(const std::string& name, const Column& column, std::string* err);
+  // DDL：在表的某一列上创建/删除哈希索引（已有数据会被扫描建立）。
+  bool create_index(const std::string& table, const IndexDef& index, std::string* err);
+  bool drop_index(const std::string& table, const std::string& index, std::string* err);
 
   // DML：插入、查询、更新、删除。
   bool insert(const std::string& table, const std::vector<Value>& values, uint64_t* row_id,
@@ -38,11 +99,68 @@ class Database {
               size_t* updated, std::string* err);
   bool remove(const std::string& table, const Condition& where, size_t* removed, std::string* err);
 
+  // 批量装载：整批校验后按页顺序追加到表尾（见 TableStorage::bulk_insert），只等待一次日志落盘。
+  bool bulk_insert(const std::string& table, const std::vector<std::vector<Value>>& rows,
+                   size_t* inserted, std::string* err);
+  // COPY：从文本文件装载，每行一条记录，列值以逗号分隔（双引号包住的文本可含逗号，"" 表示引号），
+  // 空行跳过。每 kCopyBatchRows 行调用一次批量装载，出错时之前的批次已经写入，loaded 输出已装载行数。
+  bool copy_from(const std::string& table, const std::string& path, size_t* loaded,
+                 std::string* err);
+
+  // 多语句事务：begin 开启事务；txn 非空时 DML 在事务内执行，写入暂存在事务中并为行加锁
+  // （与其他事务或自动提交语句冲突时立即失败），查询读到本事务自己的写入。
+  // commit 为全部暂存行追加 TxnRow 日志与一条提交记录，每个涉及的分区只等待一次落盘，再写回数据页；
+  // 失败时事务已回滚。rollback 丢弃暂存写入。commit/rollback 之后事务不可再用于写入。
+  std::unique_ptr<Transaction> begin(std::string* err);
+  bool commit(Transaction* txn, std::string* err);
+  void rollback(Transaction* txn);
+  bool insert(Transaction* txn, const std::string& table, const std::vector<Value>& values,
+              uint64_t* row_id, std::string* err);
+  // 事务内的多行插入与 COPY 逐行暂存，任一行失败时本语句暂存的行全部撤销。
+  bool bulk_insert(Transaction* txn, const std::string& table,
+                   const std::vector<std::vector<Value>>& rows, size_t* inserted, std::string* err);
+  bool copy_from(Transaction* txn, const std::string& table, const std::string& path,
+                 size_t* loaded, std::string* err);
+  bool select(Transaction* txn, const std::string& table, const Condition& where,
+              std::vector<std::vector<Value>>* rows, std::string* err);
+  // 流式查询：打开表游标（见 TableCursor），txn 为空时是自动提交的读取。
+  // 游标持有表共享锁，使用期间同一会话不能再写该表或执行 DDL。
+  bool open_cursor(Transaction* txn, const std::string& table, const Condition& where,
+                   uint64_t limit, std::unique_ptr<TableCursor>* cursor, std::string* err);
+  bool update(Transaction* txn, const std::string& table, const std::vector<SetClause>& sets,
+              const Condition& where, size_t* updated, std::string* err);
+  bool remove(Transaction* txn, const std::string& table, const Condition& where, size_t* removed,
+              std::string* err);
+
+  // 预备语句的执行（见 BoundDml）：bind_table 读出表结构与表结构版本用于绑定，之后的 DML 直接使用绑定的
+  // 列下标与已归一化的值，txn 为空时自动提交。表结构已不是绑定时的版本时不执行，stale 置 true。
+  bool bind_table(const std::string& table, Schema* schema, uint64_t* schema_epoch,
+                  std::string* err);
+  bool insert(Transaction* txn, const std::string& table, const BoundDml& bound, uint64_t* row_id,
+              bool* stale, std::string* err);
+  bool bulk_insert(Transaction* txn, const std::string& table, const BoundDml& bound,
+                   size_t* inserted, bool* stale, std::string* err);
+  bool open_cursor(Transaction* txn, const std::string& table, const BoundDml& bound,
+                   uint64_t limit, std::unique_ptr<TableCursor>* cursor, bool* stale,
+                   std::string* err);
+  bool update(Transaction* txn, const std::string& table, const BoundDml& bound, size_t* updated,
+              bool* stale, std::string* err);
+  bool remove(Transaction* txn, const std::string& table, const BoundDml& bound, size_t* removed,
+              bool* stale, std::string* err);
+
   // 行级操作：适用于按行号路由的多线程场景。
   bool read_row(const std::string& table, uint64_t row_id, std::vector<Value>* values, bool* valid,
                 std::string* err);
+  // 零拷贝读取：visit 直接拿到页帧上的记录视图，视图只在回调期间有效。
+  bool read_row(const std::string& table, uint64_t row_id,
+                const std::function<void(const RecordView&)>& visit, std::string* err);
   bool update_row(const std::string& table, uint64_t row_id, const std::vector<SetClause>& sets,
                   std::string* err);
+  // 批量行操作：同一页锁分片上的行共用一次页锁，update_rows 整批只等待一次日志落盘。
+  bool read_rows(const std::string& table, const std::vector<uint64_t>& row_ids,
+                 const std::function<void(size_t, const RecordView&)>& visit, std::string* err);
+  bool update_rows(const std::string& table, const std::vector<uint64_t>& row_ids,
+                   const std::vector<SetClause>& sets, size_t* updated, std::string* err);
   bool delete_row(const std::string& table, uint64_t row_id, std::string* err);
   bool write_row(const std::string& table, uint64_t row_id, const std::vector<Value>& values,
                  bool valid, std::string* err);
@@ -50,30 +168,93 @@ class Database {
   // 获取表结构与表列表。
   bool get_schema(const std::string& table, Schema* schema, std::string* err) const;
   std::vector<std::string> list_tables() const;
+  // 表结构版本：每次建表、删表、添加列后递增（预备语句据此判断预先解析的列是否失效）。
+  uint64_t schema_version() const;
   size_t page_size() const;
   // 返回所有表的缓存页分布（按 NUMA 节点汇总）。
   std::vector<size_t> cached_pages_per_node() const;
+  // 返回行所在页的页帧当前所在节点（按页路由任务时使用）。
+  bool node_for_row(const std::string& table, uint64_t row_id, int* node, std::string* err);
+  // 返回所有表的页帧迁移次数之和。
+  uint64_t page_migrations() const;
+  // 返回所有表数据文件缓存的命中统计之和。
+  CacheStats cache_stats() const;
+  // 返回单个表数据文件缓存的命中统计。
+  bool cache_stats(const std::string& table, CacheStats* stats, std::string* err);
+  // 汇总缓冲池、页文件 I/O、表锁、日志与扫描执行器的统计（读取时汇总各线程分条，不阻塞热路径）。
+  DatabaseStats stats() const;
+  // 统计的文本形式：每行 "名称{标签} 值"（Prometheus 文本格式，可直接被采集），
+  // 延迟直方图输出 p50 / p99 分位数（微秒）与样本数、总和。SHOW STATS 输出同样的内容。
+  std::string stats_text() const;
 
  private:
   // 拼接表文件路径。
   std::string table_path(const std::string& name) const;
+  // 表数据文件的缓存配置（应用 table_placement 中的按表策略）。
+  CacheOptions table_cache(const std::string& name) const;
   // 获取已加载表的存储对象。
   TableStorage* get_table(const std::string& name);
   // 加载所有表实例。
   bool load_tables(std::string* err);
+  // 只读打开流程。
+  bool open_read_only(std::string* err);
+  // 只读打开时拒绝修改。
+  bool check_writable(std::string* err) const;
   // 根据日志做 redo 恢复。
   bool recover(std::string* err);
-  // 检查点：刷盘并清理日志。
-  void checkpoint(std::string* err);
+  // 检查点：切换日志段 -> 刷新所有表 -> 删除旧日志段，输出各分区检查点 LSN。
+  bool run_checkpoint(std::vector<uint64_t>* lsns, std::string* err);
+  // 同上，调用方已持有 checkpoint_mutex_（DDL 路径）。
+  bool checkpoint_locked(std::vector<uint64_t>* lsns, std::string* err);
+  // 保存各表数据文件的缓存页号到预热列表（尽力而为，失败时忽略）。
+  void save_warmup();
+  // 读取预热列表，为每个节点启动一个绑定在该节点的线程，把页帧位于该节点的页读回。
+  void start_warmup();
+  // 让预热线程在当前批次后退出并等待它们结束。
+  void stop_warmup();
+  // 节点 node 的预热线程：tables 为（表名, 页号）列表，每批重新按名查找表，缓存已满时跳到下一个表。
+  void warm_node(int node, const std::vector<std::pair<std::string, std::vector<size_t>>>& tables);
+  // 扫描类写入后检查所有日志分区是否需要触发检查点。
+  void notify_all_partitions();
+  // 事务内逐行暂存到 statement_rows（语句成功后再并入事务，失败时由调用方丢弃）。
+  bool stage_rows(Transaction* txn, TableStorage* storage,
+                  const std::vector<std::vector<Value>>& rows, StagedRows* statement_rows,
+                  std::string* err);
+  // COPY 的公共流程：逐行解析并校验文件，每 kCopyBatchRows 行批量装载（txn 为空）或暂存。
+  bool copy_rows(Transaction* txn, const std::string& table, const std::string& path,
+                 size_t* loaded, std::string* err);
 
   std::string base_dir_;
   size_t page_size_ = 0;
   size_t cache_pages_ = 0;
   int numa_nodes_ = 1;
+  DatabaseOptions options_;
   Catalog catalog_;
   LogManager log_;
+  // 全表扫描执行器：每个节点一组绑定在本节点的工作线程（parallel 关闭时为空）。
+  std::unique_ptr<NumaExecutor> scan_executor_;
+  // 全库缓冲管理器（buffer.shared 关闭或只读打开时为空），须在 tables_ 之后析构。
+  std::unique_ptr<BufferManager> buffer_manager_;
   std::unordered_map<std::string, std::unique_ptr<TableStorage>> tables_;
+  // 保护 tables_ 映射本身：建表 / 删表修改映射时持独占锁，按名查找与统计遍历持共享锁
+  // （DDL 之间以及与检查点之间另由 checkpoint_mutex_ 串行化）。get_table 返回的指针在 DROP TABLE 之后失效，
+  // 多会话并发执行 DDL 时由调用方（如 mini_db_server）保证 DROP 期间没有语句在用该表。
+  mutable std::shared_mutex tables_mutex_;
+  // 串行化检查点与 DDL。
   mutable std::mutex checkpoint_mutex_;
+  // 事务提交持共享锁、检查点切换日志段时持独占锁：TxnRow 已写而数据页尚未写回的事务不会跨过检查点。
+  std::shared_mutex commit_mutex_;
+  std::atomic<uint64_t> next_txn_id_{1};
+  std::atomic<uint64_t> schema_version_{0};
+  // COPY 每批装载的行数。
+  static constexpr size_t kCopyBatchRows = 8192;
+  // 预热每批读入的页数（一次批量读取，批次之间检查停止标志）。
+  static constexpr size_t kWarmupBatchPages = 64;
+  // 预热线程（每个节点一个）与停止标志。
+  std::vector<std::thread> warmup_threads_;
+  std::atomic<bool> warmup_stop_{false};
+  // 后台检查点线程（需在 tables_ 之后析构前停止）。
+  Checkpointer checkpointer_;
 };
 
 }  // namespace mini_db
@@ -3,15 +3,62 @@
 #include "db/Database.h"
 #include "db/Types.h"
 
+#include <functional>
+#include <memory>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace mini_db {
 
 // 执行器：将解析后的 Statement 转化为数据库操作，并生成输出文本。
+// 每个会话使用自己的执行器：BEGIN 之后的 DML 在同一事务内执行，直到 COMMIT / ROLLBACK；
+// 执行器析构时未提交的事务回滚（须在 Database 之前析构）。
+// PREPARE 的语句同样属于会话：准备时解析表结构、归一化字面量并确定每个占位符对应的列（BoundDml），
+// EXECUTE 只按列归一化参数，再把列下标与值直接交给存储层执行，不再按列名解析；
+// 表结构变化后（Database::schema_version）首次执行时重新准备。
 class Executor {
  public:
   // 执行一条语句，output 用于可视化输出（如 SELECT）。
   bool execute(const Statement& statement, Database* db, std::string* output, std::string* err);
+  // 是否处于 BEGIN 开启的事务中。
+  bool in_transaction() const;
+  // 设置结果输出：设置后 SELECT 通过游标按批把表头与行文本交给 sink，
+  // output 只含末尾的 "Rows: N"；未设置时完整结果放在 output 中。
+  void set_result_sink(std::function<void(const std::string&)> sink);
+
+ private:
+  // PREPARE 保存的语句。
+  struct Prepared {
+    // 解析得到的语句体（语句类型、表名、LIMIT 与占位符位置；表结构变化后据此重新准备）。
+    std::shared_ptr<const Statement> source;
+    // 绑定到表结构的参数：字面量已按列类型归一化，占位符位置为空值。
+    BoundDml bound;
+    // 每个占位符对应的列下标（与 source->params 一一对应）。
+    std::vector<size_t> param_columns;
+    Schema schema;
+    uint64_t schema_version = 0;
+  };
+
+  // 按当前表结构准备语句体 source。
+  bool prepare(const std::shared_ptr<const Statement>& source, Database* db, Prepared* prepared,
+               std::string* err) const;
+  // EXECUTE：把参数按列归一化后填入绑定参数并执行；绑定后表结构恰好变化（stale）时重新准备一次。
+  bool execute_prepared(const Statement& statement, Database* db, std::string* output,
+                        std::string* err);
+  // 按绑定参数执行预备语句体 statement（INSERT / SELECT / UPDATE / DELETE）。
+  bool execute_bound(const Statement& statement, const Schema& schema, const BoundDml& bound,
+                     Database* db, std::string* output, bool* stale, std::string* err);
+  // SELECT 的结果表格：表头与游标返回的全部行（有 sink 时按批交给 sink）。
+  bool write_rows(const Schema& schema, TableCursor* cursor, std::string* output,
+                  std::string* err);
+
+  // SELECT 每批从游标读取的行数。
+  static constexpr size_t kSelectBatchRows = 1024;
+
+  std::unique_ptr<Transaction> txn_;
+  std::function<void(const std::string&)> sink_;
+  std::unordered_map<std::string, Prepared> prepared_;
 };
 
 }  // namespace mini_db
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "db/Index.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace mini_db {
+
+// 内存哈希索引：列的定长编码字节 -> 行号，按键哈希分片加锁以支持并发行级写入。
+// 检查点时写出快照文件，重启后加载快照，崩溃后由 redo 重放修正涉及的行。
+class HashIndex : public Index {
+ public:
+  // path 为快照文件路径，key_offset / key_size 为被索引列在记录中的位置。
+  HashIndex(const IndexDef& def, const std::string& path, size_t column_index, size_t key_offset,
+            size_t key_size);
+
+  bool insert(const std::string& key, uint64_t row_id, bool enforce_unique,
+              std::string* err) override;
+  bool erase(const std::string& key, uint64_t row_id, std::string* err) override;
+  // 输出的行号按升序排列，与全表扫描顺序一致。
+  bool lookup(const std::string& key, std::vector<uint64_t>* rows, std::string* err) override;
+  bool erase_rows(const std::unordered_map<uint64_t, bool>& rows, std::string* err) override;
+  bool clear(std::string* err) override;
+  // 返回条目总数。
+  size_t size() const;
+
+  bool dirty() const override;
+  // 写出快照（先写临时文件再重命名）。
+  bool save(std::string* err) override;
+  // 读取快照；文件不存在或校验失败时返回 false。
+  bool load() override;
+
+ private:
+  // 单个分片：独立的锁与多值哈希表。
+  struct Shard {
+    mutable std::mutex mutex;
+    std::unordered_multimap<std::string, uint64_t> entries;
+  };
+
+  Shard& shard_for(const std::string& key);
+  const Shard& shard_for(const std::string& key) const;
+
+  std::atomic<bool> dirty_{true};
+
+  static constexpr size_t kShardCount = 16;
+  std::array<Shard, kShardCount> shards_;
+};
+
+}  // namespace mini_db
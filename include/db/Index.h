@@ -0,0 +1,67 @@
+#pragma once
+
+#include "db/Types.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace mini_db {
+
+// 二级索引接口：键为被索引列在记录中的定长编码字节（见 Schema::encode_key），值为行号。
+// 唯一索引中同一键只允许对应一个行号；非唯一索引允许重复键。
+class Index {
+ public:
+  // path 为索引文件路径，key_offset / key_size 为被索引列在记录中的位置。
+  Index(const IndexDef& def, const std::string& path, size_t column_index, size_t key_offset,
+        size_t key_size);
+  virtual ~Index() = default;
+
+  Index(const Index&) = delete;
+  Index& operator=(const Index&) = delete;
+
+  const IndexDef& def() const;
+  const std::string& path() const;
+  // 被索引列在 schema 中的下标。
+  size_t column_index() const;
+  // 从编码后的记录中取出索引键。
+  std::string key_of(const std::vector<char>& record) const;
+
+  // 插入键；唯一索引中键已被其他行占用时报错返回 false（enforce_unique=false 时不检查）。
+  virtual bool insert(const std::string& key, uint64_t row_id, bool enforce_unique,
+                      std::string* err) = 0;
+  // 删除一个 (键, 行号) 条目。
+  virtual bool erase(const std::string& key, uint64_t row_id, std::string* err) = 0;
+  // 查找键对应的所有行号。
+  virtual bool lookup(const std::string& key, std::vector<uint64_t>* rows, std::string* err) = 0;
+  // 是否支持范围查找（有序索引）。
+  virtual bool ordered() const;
+  // 范围查找：按键顺序输出键位于 low..high 之间的行号，low/high 为空指针表示该侧无界。
+  virtual bool range(const std::string* low, bool low_inclusive, const std::string* high,
+                     bool high_inclusive, std::vector<uint64_t>* rows, std::string* err);
+  // 删除所有指向 rows 中行号的条目（恢复时修正被重放的行）。
+  virtual bool erase_rows(const std::unordered_map<uint64_t, bool>& rows, std::string* err) = 0;
+  // 清空索引。
+  virtual bool clear(std::string* err) = 0;
+
+  // 自上次保存以来是否有修改。
+  virtual bool dirty() const = 0;
+  // 持久化索引（检查点时调用）。
+  virtual bool save(std::string* err) = 0;
+  // 打开已持久化的索引；文件不存在、损坏或未正常保存时返回 false（调用方需扫描重建）。
+  virtual bool load() = 0;
+
+ protected:
+  // 唯一键冲突的错误信息。
+  bool duplicate_key(std::string* err) const;
+
+  IndexDef def_;
+  std::string path_;
+  size_t column_index_ = 0;
+  size_t key_offset_ = 0;
+  size_t key_size_ = 0;
+};
+
+}  // namespace mini_db
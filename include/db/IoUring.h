@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace mini_db {
+
+// 一次定位读写请求：在 offset 处读取/写入 size 字节。
+struct IoRequest {
+  bool write = false;
+  char* data = nullptr;
+  size_t size = 0;
+  uint64_t offset = 0;
+};
+
+// 最小 io_uring 封装（直接使用系统调用，不依赖 liburing）：批量提交一组定位读写并等待全部完成。
+// 同一实例的提交串行执行；内核不支持或被禁用 io_uring 时 init 返回 false，调用方退回 pread/pwrite。
+class IoUring {
+ public:
+  IoUring() = default;
+  ~IoUring();
+
+  IoUring(const IoUring&) = delete;
+  IoUring& operator=(const IoUring&) = delete;
+
+  // 创建队列深度为 entries 的提交/完成队列。
+  bool init(unsigned entries, std::string* err);
+  bool ready() const;
+  // 在文件 fd 上提交 requests 并等待全部完成；results[i] 为第 i 个请求的返回值
+  // （传输字节数，或负的 errno）。请求数超过队列深度时分批提交。
+  bool submit_and_wait(int fd, const std::vector<IoRequest>& requests, std::vector<int>* results,
+                       std::string* err);
+
+ private:
+  void release();
+
+  int ring_fd_ = -1;
+  // 提交队列 / 完成队列的共享内存映射。
+  void* sq_ring_ = nullptr;
+  void* cq_ring_ = nullptr;
+  void* sqes_ = nullptr;
+  size_t sq_ring_size_ = 0;
+  size_t cq_ring_size_ = 0;
+  size_t sqes_size_ = 0;
+  unsigned* sq_head_ = nullptr;
+  unsigned* sq_tail_ = nullptr;
+  unsigned* sq_mask_ = nullptr;
+  unsigned* sq_array_ = nullptr;
+  unsigned* cq_head_ = nullptr;
+  unsigned* cq_tail_ = nullptr;
+  unsigned* cq_mask_ = nullptr;
+  void* cqes_ = nullptr;
+  unsigned entries_ = 0;
+  std::mutex mutex_;
+};
+
+}  // namespace mini_db
@@ -1,39 +1,232 @@
 #pragma once
 
+#include "db/Buffer.h"
+#include "db/Metrics.h"
+#include "db/Numa.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
 #include <cstdint>
+#include <functional>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
 namespace mini_db {
 
+// 日志记录类型（写入文件的 1 字节编码，取值不可修改）。
+enum class LogOp : uint8_t {
+  Insert = 1,
+  Update = 2,
+  Delete = 3,
+  // 检查点记录：每个日志段的第一条记录，仅用于延续 LSN。
+  Checkpoint = 4,
+  // 事务内的整行 redo 映像：数据为 [u64 事务号][行记录]，事务的提交记录完整落盘后才生效。
+  TxnRow = 5,
+  // 事务提交记录：行号字段为事务号，数据为各涉及分区的 [u32 分区][u64 该分区最后一条 TxnRow 的 LSN]；
+  // 恢复时只有这些分区都重放到对应 LSN，事务才视为已提交。
+  Commit = 6,
+  // 批量装载的连续新行：行号字段为第一行，数据为按行号连续的若干条整行记录（同一页起始的行合为一条）。
+  // 只由旧版本写入，重放时记录按表的当前结构解析。
+  BulkInsert = 7,
+  // 同 BulkInsert，数据前加 [u32 记录长度]：ADD COLUMN 只修改元数据后，新旧结构的记录长度可能都能整除
+  // 数据长度，重放时按记录自带的长度解析旧结构的记录。
+  SizedBulkInsert = 8,
+};
+
+// 提交持久化模式：在延迟与吞吐之间取舍。
+enum class CommitMode {
+  // 每次提交立即触发写入 + fdatasync（并发提交仍会自然合并）。
+  Sync,
+  // 组提交：首条待刷记录最多等待 group_delay_us，与后续提交共享一次 fdatasync。
+  Group,
+  // 异步：提交不等待落盘，后台线程按 group_delay_us 周期刷盘。
+  Async,
+};
+
+// 日志配置。
+struct LogOptions {
+  CommitMode commit_mode = CommitMode::Group;
+  // 组提交/异步模式下的最大等待时间（微秒）。
+  uint32_t group_delay_us = 200;
+  // 缓冲区达到该字节数时不再等待，立即刷盘。
+  size_t group_flush_bytes = 256 * 1024;
+  // 每个分区的内存日志缓冲大小（双缓冲，按节点分配），写满后追加方等待刷盘（反压）。
+  size_t max_buffer_bytes = 4 * 1024 * 1024;
+};
+
+// 日志统计（自打开起累计）。
+struct LogStats {
+  // 追加的记录数与字节数（含记录头）。
+  uint64_t records = 0;
+  uint64_t bytes = 0;
+  // 缓冲写满、追加方等待刷盘线程交换缓冲的次数。
+  uint64_t buffer_full_waits = 0;
+  // 刷盘线程每批写入 + fdatasync 的耗时（样本数即 fsync 次数）。
+  HistogramSnapshot fsync_latency;
+  // 提交实际等待日志落盘的耗时（记录已落盘、无需等待的提交不计）。
+  HistogramSnapshot commit_wait;
+
+  // 累加另一个分区的统计。
+  void add(const LogStats& other);
+};
+
 // 日志条目：用于崩溃恢复的最小 redo 信息。
 struct LogEntry {
   uint64_t lsn = 0;
-  std::string op;
-  std::string table;
+  LogOp op = LogOp::Update;
+  uint32_t table_id = 0;
   uint64_t row_id = 0;
   std::vector<char> data;
 };
 
-// 简易日志管理器：顺序追加与读取，支持恢复与清空。
-class LogManager {
+// 恢复时按顺序访问日志记录的回调；返回 false 终止遍历。
+// entry 的数据缓冲在记录之间复用，回调不得保留其引用。
+using LogVisitor = std::function<bool(const LogEntry& entry, std::string* err)>;
+
+// 单个日志分区：一个活动段文件 + 一对 NUMA 节点本地的日志缓冲。
+// 二进制预写日志：文件在进程生命周期内保持打开，记录先进入内存缓冲，
+// 由分区自己的刷盘线程（绑定到该节点）合并写入并 fdatasync（组提交）。
+// 记录格式（小端）：[u32 数据长度][u32 CRC32][u64 LSN][u8 op][u32 表ID][u64 行号][数据]。
+// 检查点通过切换日志段实现：活动段为 path，已归档段为 path.<检查点LSN>。
+class alignas(64) LogPartition {
  public:
-  // path 为日志文件路径。
-  explicit LogManager(const std::string& path);
-
-  // 追加一条日志记录（op/表名/行号/记录数据）。
-  bool append(const std::string& op, const std::string& table, uint64_t row_id,
-              const std::vector<char>& data, std::string* err);
-  // 读取全部日志记录，用于恢复。
-  bool read_all(std::vector<LogEntry>* entries, std::string* err) const;
-  // 清空日志文件（检查点之后调用）。
-  void clear(std::string* err);
+  // node 为分区所属 NUMA 节点，缓冲区通过 allocator 在 alloc_node 上分配。
+  LogPartition(const std::string& path, int node, int alloc_node, NumaAllocator* allocator,
+               const LogOptions& options);
+  ~LogPartition();
+
+  LogPartition(const LogPartition&) = delete;
+  LogPartition& operator=(const LogPartition&) = delete;
+
+  // 追加一条日志记录到内存缓冲（不等待落盘），输出分区内 LSN。
+  bool append(LogOp op, uint32_t table_id, uint64_t row_id, const std::vector<char>& data,
+              uint64_t* lsn, std::string* err);
+  // 等待 lsn 及之前的记录持久化（异步模式直接返回）。
+  bool wait_durable(uint64_t lsn, std::string* err);
+  // 强制刷出缓冲区中的全部记录并等待落盘。
+  bool flush(std::string* err);
+  // 保证 lsn 及之前的记录已落盘（与提交模式无关，异步模式下同样等待），用于数据页写出前的 WAL 检查。
+  bool flush_to(uint64_t lsn, std::string* err);
+  // 流式读取本分区全部日志记录（归档段 + 活动段，按 LSN 顺序），逐条交给 visit。
+  bool replay(const LogVisitor& visit, std::string* err);
+  // 清空日志文件并打开新的活动段。
+  bool clear(std::string* err);
+  // 刷出剩余记录、停止刷盘线程并关闭文件。
+  void close();
+  // 归档当前活动段并开启新段，输出检查点 LSN。
+  bool rotate(uint64_t* checkpoint_lsn, std::string* err);
+  // 删除检查点 LSN 之前的归档段。
+  bool purge(uint64_t checkpoint_lsn, std::string* err);
+
+  // 返回自上次检查点以来追加的日志字节数。
+  size_t size_bytes() const;
+  // 返回下一个将要分配的 LSN / 已持久化的最大 LSN。
+  uint64_t next_lsn() const;
+  uint64_t durable_lsn() const;
+  const std::string& path() const;
+  // 返回本分区的日志统计。
+  LogStats stats() const;
 
  private:
+  // 截断并打开活动段，写入段头与检查点记录；调用方持有 mutex_。
+  bool open_active_locked(uint64_t* checkpoint_lsn, std::string* err);
+  // 将缓冲中的记录写入文件并等待完成；调用方持有 lock。
+  bool drain_locked(std::unique_lock<std::mutex>* lock, std::string* err);
+  // 后台刷盘线程主循环。
+  void flush_loop();
+
   std::string path_;
+  int node_ = 0;
+  LogOptions options_;
+  int fd_ = -1;
   uint64_t next_lsn_ = 1;
+  // 已进入缓冲的最大 LSN / 已落盘的最大 LSN。
+  uint64_t buffered_lsn_ = 0;
+  uint64_t durable_lsn_ = 0;
+  // 双缓冲：追加方写 buffer_，刷盘线程在锁外写出 write_buffer_。
+  Buffer buffer_;
+  Buffer write_buffer_;
+  size_t buffer_used_ = 0;
+  size_t write_used_ = 0;
+  bool flushing_ = false;
+  bool flush_requested_ = false;
+  bool stop_ = false;
+  std::string io_error_;
+  std::atomic<size_t> size_bytes_{0};
+  // 日志统计。
+  Counter records_;
+  Counter bytes_;
+  Counter buffer_full_waits_;
+  LatencyHistogram fsync_latency_;
+  LatencyHistogram commit_wait_;
+  std::thread flusher_;
   mutable std::mutex mutex_;
+  // 通知刷盘线程有新记录 / 通知等待方有新的落盘进度。
+  std::condition_variable flush_cv_;
+  std::condition_variable durable_cv_;
+};
+
+// 预写日志管理器：按 NUMA 节点划分日志分区（文件 path.n<分区>），
+// 按页路由到节点 N 的写入只会访问分区 N 的锁、缓冲与文件。
+// LSN 为分区内递增；同一行的页归属固定，其所有记录总在同一分区中，
+// 因此按分区各自顺序重放即可保证每行的最终镜像正确（记录为整行 redo，跨行无依赖）。
+class LogManager {
+ public:
+  // path 为日志文件路径前缀，partitions 为分区数（通常等于缓冲池 NUMA 节点数）。
+  LogManager(const std::string& path, int partitions, const LogOptions& options = LogOptions{});
+  ~LogManager();
+
+  LogManager(const LogManager&) = delete;
+  LogManager& operator=(const LogManager&) = delete;
+
+  // 返回分区数量，以及某个 NUMA 节点对应的分区。
+  int partition_count() const;
+  int partition_for_node(int node) const;
+
+  // 追加一条日志记录到指定分区（不等待落盘），输出分区内 LSN。
+  bool append(int partition, LogOp op, uint32_t table_id, uint64_t row_id,
+              const std::vector<char>& data, uint64_t* lsn, std::string* err);
+  // 等待指定分区中 lsn 及之前的记录持久化（异步模式直接返回）。
+  bool wait_durable(int partition, uint64_t lsn, std::string* err);
+  // 强制刷出所有分区的缓冲并等待落盘。
+  bool flush(std::string* err);
+  // 保证指定分区中 lsn 及之前的记录已落盘（与提交模式无关）。
+  bool flush_to(int partition, uint64_t lsn, std::string* err);
+  // 返回指定分区已落盘的最大 LSN。
+  uint64_t durable_lsn(int partition) const;
+  // 流式读取指定分区的全部日志记录（按 LSN 顺序），不同分区可由不同线程并行读取。
+  bool replay(int partition, const LogVisitor& visit, std::string* err);
+  // 流式读取旧版本遗留的未分区日志文件 path；其记录早于任何分区记录，需最先重放。
+  bool replay_legacy(const LogVisitor& visit, std::string* err);
+  // 清空所有分区并打开新的活动段（恢复完成之后调用）。
+  void clear(std::string* err);
+  // 刷出剩余记录、停止所有刷盘线程并关闭文件。
+  void close();
+
+  // 检查点开始：每个分区刷出缓冲并切换日志段，输出各分区检查点 LSN。
+  // 调用方需保证此时没有进行中的写入（日志已写但数据页未更新）。
+  bool rotate(std::vector<uint64_t>* checkpoint_lsns, std::string* err);
+  // 检查点完成：删除各分区检查点 LSN 之前的归档段。
+  bool purge(const std::vector<uint64_t>& checkpoint_lsns, std::string* err);
+  // 返回所有分区自上次检查点以来的日志字节数之和。
+  size_t size_bytes() const;
+  // 返回单个分区自上次检查点以来的日志字节数（前台只访问自己的分区）。
+  size_t size_bytes(int partition) const;
+  // 返回当前提交模式。
+  CommitMode commit_mode() const;
+  // 返回所有分区的日志统计之和 / 单个分区的日志统计。
+  LogStats stats() const;
+  LogStats stats(int partition) const;
+
+ private:
+  std::string path_;
+  LogOptions options_;
+  std::unique_ptr<NumaAllocator> allocator_;
+  std::vector<std::unique_ptr<LogPartition>> partitions_;
 };
 
 }  // namespace mini_db
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstddef>
+
+namespace mini_db {
+
+// LZ4 块格式（与 liblz4 的 LZ4_compress_default / LZ4_decompress_safe 互通）的最小实现，
+// 供压缩表的页文件使用：单次压缩一整页，输入不超过 64 KB。
+// 压缩采用单层哈希的贪心匹配，速度优先；解压对越界与非法偏移做完整检查。
+
+// 压缩 src 的 size 字节到 dst（容量 capacity），返回压缩后的字节数；放不下时返回 0。
+size_t lz4_compress(const char* src, size_t size, char* dst, size_t capacity);
+// 解压 size 字节的块到 dst，解压结果必须恰好为 expected 字节，否则（含数据损坏）返回 false。
+bool lz4_decompress(const char* src, size_t size, char* dst, size_t expected);
+
+}  // namespace mini_db
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "db/Trace.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace mini_db {
+
+// 内部统计的基本计数器与延迟直方图。
+// 热路径只对当前线程所属分条做 relaxed 累加（每条独占缓存行，线程按编号固定到分条），
+// 不与其他线程争用同一个原子量；读取时汇总全部分条，结果是近似的瞬时值。
+
+// 分条数。
+constexpr size_t kMetricStripes = 16;
+// 直方图的桶数：桶 i 统计 [2^(i-1), 2^i) 纳秒的样本（桶 0 为 0 纳秒），最后一桶包含更长的样本。
+constexpr size_t kHistogramBuckets = 40;
+
+// 当前线程的分条下标（首次调用时按线程编号分配）。
+size_t metric_stripe();
+// 单调时钟的纳秒时间，用于计时。
+uint64_t metric_now_ns();
+
+// 单调递增计数。
+class Counter {
+ public:
+  void add(uint64_t n = 1) {
+    stripes_[metric_stripe()].value.fetch_add(n, std::memory_order_relaxed);
+  }
+  uint64_t value() const;
+
+ private:
+  struct alignas(64) Stripe {
+    std::atomic<uint64_t> value{0};
+  };
+  Stripe stripes_[kMetricStripes];
+};
+
+// 直方图汇总结果。
+struct HistogramSnapshot {
+  uint64_t count = 0;
+  uint64_t sum_ns = 0;
+  std::array<uint64_t, kHistogramBuckets> buckets{};
+
+  // 合并另一个直方图。
+  void add(const HistogramSnapshot& other);
+  // 分位数 q（0..1）所在桶的上界（纳秒），没有样本时为 0。
+  uint64_t percentile_ns(double q) const;
+};
+
+// 纳秒延迟直方图（按 2 的幂分桶）。
+class LatencyHistogram {
+ public:
+  void record(uint64_t ns);
+  HistogramSnapshot snapshot() const;
+
+ private:
+  struct alignas(64) Stripe {
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> sum_ns{0};
+    std::atomic<uint64_t> buckets[kHistogramBuckets] = {};
+  };
+  Stripe stripes_[kMetricStripes];
+};
+
+// 加锁；未能立即取得时把等待时间记入 waits（无竞争时只多一次 try_lock，不读时钟）。
+// 追踪构建中等待同时记为名为 trace_name 的区间。
+template <typename Lock, typename Mutex>
+Lock timed_lock(Mutex& mutex, LatencyHistogram* waits, const char* trace_name) {
+  (void)trace_name;
+  Lock lock(mutex, std::try_to_lock);
+  if (!lock.owns_lock()) {
+    MINI_DB_TRACE_SPAN(trace_name);
+    uint64_t start = metric_now_ns();
+    lock.lock();
+    waits->record(metric_now_ns() - start);
+  }
+  return lock;
+}
+
+}  // namespace mini_db
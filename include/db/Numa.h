@@ -29,5 +29,10 @@ std::unique_ptr<NumaAllocator> create_numa_allocator();
 bool is_numa_enabled();
 // 返回强制分配到指定 NUMA 节点的配置（未设置返回 -1）。
 int forced_numa_alloc_node();
+// 为 [addr, addr + size) 设置优先在 node 上分配物理页的内存策略（mbind），
+// 未启用 NUMA 或没有 libnuma 时返回 false。
+bool bind_memory_to_node(void* addr, size_t size, int node);
+// 查询 addr 所在物理页的节点（不触发缺页）；物理页尚未分配或没有 libnuma 时返回 -1。
+int memory_node_of(const void* addr);
 
 }  // namespace mini_db
@@ -1,23 +1,54 @@
 #pragma once
 
+#include "db/Metrics.h"
 #include "db/NumaThread.h"
+#include "db/TaskQueue.h"
 
+#include <atomic>
 #include <condition_variable>
-#include <deque>
-#include <functional>
+#include <cstdint>
 #include <future>
 #include <memory>
 #include <mutex>
 #include <thread>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
 namespace mini_db {
 
-// NUMA 线程执行器：每个 NUMA 节点有固定线程组与任务队列。
+// 执行器配置。
+struct NumaExecutorOptions {
+  // 每个工作线程本地任务队列的容量（槽位数，向上取整为 2 的幂）。
+  size_t queue_capacity = 1024;
+  // 跨节点窃取阈值，按被窃取线程自身队列中的任务数计（不是节点总积压）：远端某个工作线程的队列
+  // 超过该长度时，空闲线程才从它那里窃取；默认为默认队列容量的一半，0 表示从不跨节点窃取。
+  size_t remote_steal_threshold = 512;
+  // 空闲线程休眠前的自旋轮数。
+  int spin_rounds = 64;
+};
+
+// 执行器统计（自启动起累计）。
+struct NumaExecutorStats {
+  uint64_t executed = 0;
+  // 从本节点其他线程队列窃取的任务数。
+  uint64_t stolen_local = 0;
+  // 跨节点窃取的任务数（为负载均衡牺牲了局部性）。
+  uint64_t stolen_remote = 0;
+  // 当前已提交、尚未被取走的任务数（队列深度，只会高估）。
+  size_t queued = 0;
+  // 工作线程执行每个任务的耗时（队列满时提交方就地执行的任务不计）。
+  HistogramSnapshot task_time;
+};
+
+// NUMA 线程执行器：每个 NUMA 节点有固定线程组，每个工作线程有一个无锁任务队列（见 TaskQueue）。
+// 提交到节点的任务轮转放入该节点各线程的队列（工作线程提交给本节点时放入自己的队列）；
+// 空闲线程先窃取本节点其他线程的任务，远端节点积压超过阈值后才跨节点窃取。
+// 任务闭包就地存放在队列槽位中（见 Task），post 不做堆分配；submit 只额外分配 future 的共享状态。
 class NumaExecutor {
  public:
   NumaExecutor(int nodes, int threads_per_node);
+  NumaExecutor(int nodes, int threads_per_node, const NumaExecutorOptions& options);
   ~NumaExecutor();
 
   NumaExecutor(const NumaExecutor&) = delete;
@@ -25,43 +56,102 @@ class NumaExecutor {
 
   // 启动工作线程。
   void start();
-  // 停止线程并等待退出。
+  // 停止线程并等待退出（各节点已提交的任务执行完后才退出）。
   void stop();
   // 返回节点数量。
   int node_count() const;
 
-  // 提交任务到指定节点的队列；返回 future 供调用方等待。
+  // 提交任务到指定节点；返回 future 供调用方等待。
   template <typename Fn>
   auto submit(int node, Fn&& fn) -> std::future<decltype(fn())> {
     using Result = decltype(fn());
-    auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<Fn>(fn)); // 把传入的函数封装成 packaged_task 可以绑定到一个 future ， 执行时会把结果写入这个 future
-    auto future = task->get_future();     // 获取未来结果句柄返回给调用方
-    if (!running_) { // 如果执行器尚未启动，就在当前线程同步执行，避免任务丢失，同时依然返回 future，保证接口一致
-      (*task)();
+    std::promise<Result> promise;
+    auto future = promise.get_future();
+    if (!running_) {
+      // 执行器尚未启动时在当前线程同步执行，避免任务丢失，同时依然返回 future，保证接口一致。
+      fulfill(&promise, fn);
       return future;
     }
-    enqueue(node, [task]() mutable { (*task)(); }); // 把任务刨床成一个 void() 的可调用对象塞进队列；工作线程执行时就出发 packaged_task ，结果写入 future
+    enqueue(node, Task([fn = std::forward<Fn>(fn), promise = std::move(promise)]() mutable {
+      fulfill(&promise, fn);
+    }));
     return future;
   }
 
+  // 提交不需要结果的任务（不分配 future），执行器未启动时同步执行。
+  template <typename Fn>
+  void post(int node, Fn&& fn) {
+    if (!running_) {
+      fn();
+      return;
+    }
+    enqueue(node, Task(std::forward<Fn>(fn)));
+  }
+
+  // 批量提交：tasks 作为一个任务放入节点队列，由同一个工作线程按顺序执行，全部完成后 future 只就绪一次
+  // （某个任务抛出异常时后续任务不再执行，异常经 future 传出）。执行器未启动时同步执行。
+  std::future<void> submit_batch(int node, std::vector<Task> tasks);
+
+  // 返回全部节点 / 指定节点的执行与窃取计数。
+  NumaExecutorStats stats() const;
+  NumaExecutorStats stats(int node) const;
+
  private:
+  struct Worker {
+    Worker(NumaExecutor* owner, int node, size_t index, size_t capacity)
+        : owner(owner), node(node), index(index), queue(capacity) {}
+    NumaExecutor* owner = nullptr;
+    int node = 0;
+    size_t index = 0;
+    TaskQueue queue;
+    std::thread thread;
+  };
+
   struct WorkerGroup {
     int node = 0;
-    std::mutex mutex;                 // 互斥锁保护任务队列
-    std::condition_variable cv;               // 条件变量用于工作线程等待任务到来
-    std::deque<std::function<void()>> tasks; // 任务队列，FIFO 顺序执行
-    bool stop = false;
-    std::vector<std::thread> threads;         // 工作线程列表
+    std::vector<std::unique_ptr<Worker>> workers;
+    // 已提交到本节点、尚未被取走的任务数（入队前加一，出队后减一，只会高估）。
+    std::atomic<size_t> pending{0};
+    // 外部提交的轮转位置。
+    std::atomic<size_t> next{0};
+    // 空闲线程在此休眠；sleepers 为休眠线程数，提交方只在有人休眠时才加锁唤醒。
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::atomic<int> sleepers{0};
+    std::atomic<uint64_t> executed{0};
+    std::atomic<uint64_t> stolen_local{0};
+    std::atomic<uint64_t> stolen_remote{0};
+    LatencyHistogram task_time;
   };
 
+  template <typename Result, typename Fn>
+  static void fulfill(std::promise<Result>* promise, Fn& fn) {
+    try {
+      if constexpr (std::is_void<Result>::value) {
+        fn();
+        promise->set_value();
+      } else {
+        promise->set_value(fn());
+      }
+    } catch (...) {
+      promise->set_exception(std::current_exception());
+    }
+  }
+
   // 将任务放入对应节点的队列。 （线程池内部私有实现，外部不能直接使用）
-  void enqueue(int node, std::function<void()> task);
+  void enqueue(int node, Task task);
+  // 按 自己的队列 -> 本节点其他线程 -> 积压超过阈值的远端节点 的顺序取一个任务。
+  bool take(Worker* worker, Task* task);
+  // 唤醒组内一个休眠线程（没有休眠线程时不加锁）。
+  void wake(WorkerGroup* group);
   // 节点工作线程主循环。
-  void worker_loop(WorkerGroup* group);
+  void worker_loop(Worker* worker);
 
   int nodes_ = 1;
   int threads_per_node_ = 1;
+  NumaExecutorOptions options_;
   std::vector<std::unique_ptr<WorkerGroup>> groups_;
+  std::atomic<bool> stop_{false};
   bool running_ = false;
 };
 
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace mini_db {
+
+// 引擎 NUMA 计数的共享内存段：设置 MINI_DB_NUMA_METRICS=1 后进程创建 POSIX 共享内存
+// /mini_db.<pid>，mini_db_numa_monitor 以只读方式映射，与 /proc 中的内存分布并列显示。
+// 布局只由本头文件定义（监控工具不链接引擎代码），改动布局时递增 kNumaMetricsVersion。
+
+constexpr uint32_t kNumaMetricsMagic = 0x4D4E4442;  // "BDNM"
+constexpr uint32_t kNumaMetricsVersion = 1;
+// 段中预留的节点数，更大的节点号不计数。
+constexpr size_t kNumaMetricsMaxNodes = 16;
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "shared-memory counters need lock-free 64-bit atomics");
+
+// 单个节点的计数（自进程创建段起累计）。
+struct alignas(64) NumaNodeMetrics {
+  // 本节点缓存分片中的帧被本节点线程访问的次数。
+  std::atomic<uint64_t> local_accesses{0};
+  // 本节点缓存分片中的帧被其他节点线程访问的次数。
+  std::atomic<uint64_t> remote_accesses{0};
+  // 请求在本节点分配的 Buffer 字节数。
+  std::atomic<uint64_t> alloc_bytes{0};
+  // 其中已核对物理页所在节点的字节数（分配时即清零、物理页已存在的缓冲区）。
+  std::atomic<uint64_t> alloc_checked_bytes{0};
+  // 其中物理页实际落在其他节点的字节数。
+  std::atomic<uint64_t> alloc_misplaced_bytes{0};
+  // 提交到本节点执行器的任务中，提交线程同在本节点的任务数。
+  std::atomic<uint64_t> submit_local{0};
+  // 提交到本节点执行器的任务中，提交线程在其他节点的任务数。
+  std::atomic<uint64_t> submit_remote{0};
+};
+
+struct NumaMetricsSegment {
+  uint32_t magic = 0;
+  uint32_t version = 0;
+  int32_t pid = 0;
+  // 已出现过的最大节点号 + 1。
+  std::atomic<uint32_t> nodes{0};
+  NumaNodeMetrics node[kNumaMetricsMaxNodes];
+};
+
+// 进程 pid 的共享内存段名（shm_open 使用）。
+inline std::string numa_metrics_shm_name(int pid) {
+  return "/mini_db." + std::to_string(pid);
+}
+
+// 本进程的计数段；未启用（或创建失败）时返回 nullptr，各埋点据此跳过统计。
+NumaMetricsSegment* numa_metrics();
+// 当前线程所在节点：已绑定节点的线程取绑定节点，否则按所在 CPU 查询。
+int numa_metrics_current_node();
+// 记录一次帧访问：frame_node 为帧所在缓存分片的节点，thread_node 为访问线程的节点。
+// 先在线程本地累计，每满一批或线程退出时再写入共享段。
+void record_numa_frame_access(int frame_node, int thread_node);
+// 记录一次 Buffer 分配；actual_node < 0 表示物理页尚未分配、无法核对。
+void record_numa_allocation(int node, int actual_node, size_t bytes);
+// 记录一次执行器提交。
+void record_numa_submit(int target_node, int submit_node);
+
+}  // namespace mini_db
@@ -6,5 +6,7 @@ namespace mini_db {
 
 // 将当前线程绑定到指定 NUMA 节点的 CPU 列表；失败时返回 false。
 bool bind_thread_to_node(int node, std::string* err);
+// 返回当前线程最近一次请求绑定的节点（绑定失败也会记录，配置的节点可多于实际节点），未请求过返回 -1。
+int thread_bound_node();
 
 }  // namespace mini_db
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "db/Cache.h"
+#include "db/PagedFile.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace mini_db {
+
+// 溢出页文件（<表文件>.ovf）：存放槽页中放不下的长 TEXT 值，每个值占一条页链，
+// 链上每页前 4 字节为下一页的页号（0 表示结束），其余为值的字节。
+// 第 0 页为文件头：魔数、标志、页数与空闲页号列表（flush 时写出，放不下时标记为不完整）。
+// 溢出页不单独记日志：引用它的数据页修改都有日志，崩溃后这些行被重放并写入新的页链。
+// 磁盘上的旧记录可能引用已被复用的页，因此重放期间只从文件末尾分配新页（fresh），不释放旧链，
+// 重放结束后由表扫描全部数据页收集仍被引用的链（rebuild），其余页回收。
+class OverflowFile {
+ public:
+  OverflowFile(const std::string& path, size_t page_size, size_t cache_pages,
+               const CacheOptions& cache);
+
+  OverflowFile(const OverflowFile&) = delete;
+  OverflowFile& operator=(const OverflowFile&) = delete;
+
+  // 打开或新建文件；read_only 时只读映射。complete 输出空闲页列表是否完整，不完整时调用方应 rebuild。
+  bool load(bool read_only, bool* complete, std::string* err);
+  // 把 size 字节写入一条新页链，first_page 输出链首页号；fresh 为 true 时不复用空闲页。
+  bool write(const char* data, size_t size, bool fresh, uint32_t* first_page, std::string* err);
+  // 读取链首为 first_page、长度为 size 的值。
+  bool read(uint32_t first_page, size_t size, char* out, std::string* err);
+  // 回收一条页链。引用它的记录已在持写闩的数据页上被替换，读者不会再跟随该链，页可立即复用。
+  bool release(uint32_t first_page, size_t size, std::string* err);
+  // 按仍被引用的链（链首页号与值长度）重建空闲页列表。
+  bool rebuild(const std::vector<std::pair<uint32_t, uint32_t>>& chains, std::string* err);
+  // 写出文件头并刷盘。
+  void flush(std::string* err);
+  // 已分配的页数（含文件头页）与空闲页数。
+  uint64_t page_count() const;
+  size_t free_pages() const;
+  const std::string& path() const;
+  // 溢出页文件的 I/O 统计。
+  IoStats io_stats() const;
+
+ private:
+  // 每页可存放的值字节数。
+  size_t payload() const;
+  // 值占用的页数。
+  size_t pages_for(size_t size) const;
+  // 读取页链上 page_id 的下一页号。
+  bool next_page(uint32_t page_id, uint32_t* next, std::string* err);
+
+  PagedFile file_;
+  size_t page_size_ = 0;
+  mutable std::mutex mutex_;
+  uint64_t page_count_ = 1;
+  std::vector<uint32_t> free_;
+
+  static constexpr size_t kHeaderSize = 20;
+  static constexpr size_t kLinkSize = 4;
+  // 文件头标志：空闲页列表完整。
+  static constexpr uint32_t kFlagComplete = 1;
+};
+
+}  // namespace mini_db
@@ -1,14 +1,56 @@
 #pragma once
 
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
 
 namespace mini_db {
 
+// 页分布策略。
+enum class PagePlacement {
+  // 按页号取模，相邻页交错分布到各节点。
+  Modulo,
+  // 连续页段：每 range_pages 页为一段，依次分给各节点。
+  Range,
+  // 按页号散列分布。
+  Hash,
+  // 访问驱动：归属节点同 home，页帧迁移到访问最多的节点。
+  Adaptive,
+};
+
+// 表文件的页分布配置。
+struct PlacementOptions {
+  PagePlacement policy = PagePlacement::Modulo;
+  // Range：每段连续页数。
+  size_t range_pages = 1024;
+  // Adaptive：归属节点使用的静态策略（不能为 Adaptive）。
+  PagePlacement home = PagePlacement::Modulo;
+  // Adaptive：某节点对页的访问计数达到该值且超过页帧所在节点访问数的两倍时迁移页帧。
+  uint32_t migrate_threshold = 64;
+  // Adaptive：访问计数表的槽位数（按页号散列，冲突的页共用计数）。
+  size_t tracked_pages = 4096;
+};
+
+// 解析策略名（modulo / range / hash / adaptive）。
+bool parse_page_placement(const std::string& name, PagePlacement* placement);
+// 返回策略名（与 parse_page_placement 接受的名称一致）。
+const char* page_placement_name(PagePlacement placement);
+
 // 页分布策略：决定某个页归属哪个 NUMA 节点。
 class PageNodeSelector {
  public:
   virtual ~PageNodeSelector() = default;
+  // 页的归属节点：决定日志分区、扫描分工与文件映射的 mbind，同一页的结果必须始终不变。
   virtual int node_for_page(size_t page_id, int node_count) const = 0;
+  // 是否会迁移页帧（为 false 时缓冲池不统计访问，页帧始终在归属节点）。
+  virtual bool migrates() const { return false; }
+  // 记录 node 对页的一次访问（frame_node 为页帧当前所在节点），返回页帧应迁往的节点，不迁移返回 -1。
+  virtual int record_access(size_t /*page_id*/, int /*node*/, int /*frame_node*/,
+                            int /*node_count*/) {
+    return -1;
+  }
 };
 
 // 默认策略：按 page_id 做取模分片。
@@ -22,4 +64,50 @@ class ModuloPageSelector : public PageNodeSelector {
   }
 };
 
+// 连续页段分片：顺序扫描与相邻的热点行集中在同一节点。
+class RangePageSelector : public PageNodeSelector {
+ public:
+  explicit RangePageSelector(size_t range_pages) : range_pages_(range_pages > 0 ? range_pages : 1) {}
+
+  int node_for_page(size_t page_id, int node_count) const override {
+    if (node_count <= 0) {
+      return 0;
+    }
+    return static_cast<int>((page_id / range_pages_) % static_cast<size_t>(node_count));
+  }
+
+ private:
+  size_t range_pages_ = 1;
+};
+
+// 按页号散列分片：打散有规律的访问步长，避免其集中到某个节点。
+class HashPageSelector : public PageNodeSelector {
+ public:
+  int node_for_page(size_t page_id, int node_count) const override;
+};
+
+// 访问驱动的迁移策略：归属节点由 home 策略给出，另按节点统计页的访问，
+// 远端访问占优的热点页由缓冲池把页帧迁到访问最多的节点。
+class AdaptivePageSelector : public PageNodeSelector {
+ public:
+  AdaptivePageSelector(std::unique_ptr<PageNodeSelector> home, int node_count,
+                       const PlacementOptions& options);
+
+  int node_for_page(size_t page_id, int node_count) const override;
+  bool migrates() const override { return true; }
+  int record_access(size_t page_id, int node, int frame_node, int node_count) override;
+
+ private:
+  std::unique_ptr<PageNodeSelector> home_;
+  int node_count_ = 1;
+  uint32_t threshold_ = 1;
+  size_t slots_ = 1;
+  // slots_ x node_count_ 的访问计数。
+  std::unique_ptr<std::atomic<uint32_t>[]> counts_;
+};
+
+// 按配置创建页分布策略。
+std::unique_ptr<PageNodeSelector> create_page_selector(const PlacementOptions& options,
+                                                       int node_count);
+
 }  // namespace mini_db
@@ -2,7 +2,10 @@
 
 #include "db/BufferPool.h"
 
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
@@ -18,17 +21,50 @@ struct DataItem {
 // 基于页缓存的文件读写封装，提供按偏移读写的 DataItem 抽象。
 class PagedFile {
  public:
-  // path 为文件路径，page_size 为页大小，cache_pages 为缓存页数，numa_nodes 为 NUMA 节点数。
-  PagedFile(const std::string& path, size_t page_size, size_t cache_pages, int numa_nodes);
+  // path 为文件路径，page_size 为页大小，cache_pages 为缓存页数，numa_nodes 为 NUMA 节点数，
+  // cache 为页缓存配置（替换策略、后台写页线程）。
+  PagedFile(const std::string& path, size_t page_size, size_t cache_pages, int numa_nodes,
+            const CacheOptions& cache);
+  // 解除只读映射。
+  ~PagedFile();
+
+  PagedFile(const PagedFile&) = delete;
+  PagedFile& operator=(const PagedFile&) = delete;
 
   // 从指定偏移读取 size 字节到 item。
   bool read_item(size_t offset, size_t size, DataItem* item, std::string* err);
+  // 从指定偏移读取 size 字节到调用方缓冲 out（不经过 DataItem 中转），access 为缓存访问提示。
+  bool read_into(size_t offset, size_t size, char* out, PageAccess access, std::string* err);
+  // 乐观读：数据落在一页内且页已在缓存中时无锁复制到 out（只读映射模式下直接复制），
+  // 否则返回 false，调用方改用加锁读取。
+  bool read_optimistic(size_t offset, size_t size, char* out);
+  // 返回 offset 处 size 字节的只读指针 data，尽量不复制：只读映射模式下直接指向映射；数据落在一页内时
+  // 钉住该页（持共享闩）并指向页帧，page 已钉住同一页时直接复用；跨页时经 read_into 复制到 scratch。
+  // 返回的指针在 page 释放或 scratch 改写之前有效。
+  bool read_view(size_t offset, size_t size, PageAccess access, PageGuard* page,
+                 std::vector<char>* scratch, const char** data, std::string* err);
   // 将 data 写入指定偏移位置（会跨页写入）。
   bool write_item(size_t offset, const std::vector<char>& data, std::string* err);
+  // lsn 为本次修改对应的日志 LSN（0 表示不受日志保护），页写出前日志须先持久化到该 LSN。
+  bool write_from(size_t offset, const char* data, size_t size, uint64_t lsn, std::string* err);
+  // 钉住指定页并返回页句柄，持有期间可原地读写页数据（写模式修改后需 mark_dirty）。
+  PageGuard pin_page(size_t page_id, PageGuard::Mode mode, PageAccess access, std::string* err);
   // 刷新缓存与底层文件。
   void flush(std::string* err);
   // 重新绑定到新的文件路径或页配置（用于 schema 重建后替换文件）。
-  void reset(const std::string& path, size_t page_size, size_t cache_pages, int numa_nodes);
+  void reset(const std::string& path, size_t page_size, size_t cache_pages, int numa_nodes,
+             const CacheOptions& cache);
+  // 设置各缓存分片的 WAL 接口（见 NumaBufferPool::set_wal），reset 后仍然生效。
+  void set_wal(const std::function<WalGate(int node)>& make_gate);
+  // 把各缓存分片登记到全库缓冲管理器（见 NumaBufferPool::set_buffer_manager），reset 后仍然生效。
+  void set_buffer_manager(BufferManager* manager);
+  // 只读映射模式：以只读方式 mmap 整个文件，此后 read_item / read_into 直接从映射复制，
+  // 不经过 Pager 与页缓存（不加分片锁、不钉页）；写入与钉页返回错误，reset 时解除映射。
+  // 映射整体提示为随机访问，Scan 读取按预读窗口对后续范围提示 MADV_WILLNEED；
+  // numa_bind 为 true 时按页归属节点（PageNodeSelector）对映射分段 mbind。空文件与压缩文件不映射。
+  bool map_read_only(bool numa_bind, std::string* err);
+  // 返回是否处于只读映射模式。
+  bool mapped() const;
 
   // 返回页大小。
   size_t page_size() const;
@@ -38,11 +74,39 @@ class PagedFile {
   const std::string& path() const;
   // 返回每个 NUMA 节点当前缓存页数。
   std::vector<size_t> cached_pages_per_node() const;
+  // 返回页所属的 NUMA 节点。
+  int node_for_page(size_t page_id) const;
+  // 返回页帧当前所在的节点（见 NumaBufferPool::frame_node_for_page）。
+  int frame_node_for_page(size_t page_id) const;
+  // 返回缓冲池已完成的页帧迁移次数。
+  uint64_t page_migrations() const;
+  // 返回缓冲池各分片命中统计之和。
+  CacheStats cache_stats() const;
+  // 返回每个缓存分片（下标为节点）的统计。
+  std::vector<CacheStats> cache_stats_per_node() const;
+  // 返回底层页文件的 I/O 统计（只读映射模式下的读取不经过 Pager，不计入）。
+  IoStats io_stats() const;
+  // 返回各缓存分片中的页号（见 NumaBufferPool::resident_pages），只读映射模式下为空。
+  std::vector<std::vector<size_t>> resident_pages() const;
+  // 预热 node 分片（见 NumaBufferPool::warm），超出文件末尾的页忽略；只读映射模式下不做任何事。
+  size_t warm(int node, const std::vector<size_t>& page_ids, bool* full);
 
  private:
   // PagedFile 是上层封装，用 Pager + NumaBufferPool 提供按偏移读写数据项的接口。
   std::unique_ptr<Pager> pager_;
   std::unique_ptr<NumaBufferPool> cache_;
+  std::function<WalGate(int node)> make_wal_gate_;
+  BufferManager* buffer_manager_ = nullptr;
+  // 解除只读映射。
+  void unmap();
+  // Scan 读取推进到 pos 时，对其后一个预读窗口的映射范围提示 MADV_WILLNEED。
+  void advise_ahead(size_t pos);
+
+  // 只读映射与已提示 MADV_WILLNEED 的范围上界。
+  char* map_ = nullptr;
+  size_t map_size_ = 0;
+  size_t advise_bytes_ = 0;
+  std::atomic<size_t> advised_end_{0};
 };
 
 }  // namespace mini_db
@@ -1,18 +1,71 @@
 #pragma once
 
+#include "db/IoUring.h"
+#include "db/Metrics.h"
+
+#include <atomic>
 #include <cstddef>
-#include <fstream>
+#include <cstdint>
+#include <map>
+#include <memory>
 #include <mutex>
+#include <set>
+#include <shared_mutex>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace mini_db {
 
+// 页文件的 I/O 后端。
+enum class IoBackend {
+  Pread,    // 定位读写 pread/pwrite（批量写用 pwritev）。
+  IoUring,  // 批量读写经 io_uring 一次提交；单页读写仍走 pread/pwrite。
+};
+
+// 解析后端名（pread / uring，大小写不敏感），未知名称返回 false。
+bool parse_io_backend(const std::string& name, IoBackend* backend);
+// 返回后端名（与 parse_io_backend 接受的名称一致）。
+const char* io_backend_name(IoBackend backend);
+
+// 页文件 I/O 配置。
+struct PagerOptions {
+  IoBackend backend = IoBackend::Pread;
+  // 以 O_DIRECT 打开，绕过内核页缓存（数据已由缓冲池缓存）。页大小须为 4096 的整数倍，
+  // 文件系统不支持（如 tmpfs）时自动退回普通读写。缓冲区未对齐时经对齐的中转缓冲区读写。
+  bool direct_io = false;
+  // io_uring 队列深度。
+  unsigned uring_depth = 64;
+  // 压缩模式：每页单独以 LZ4 压缩后存放（压缩后省不出一个存储单元的页原样存放），
+  // 逻辑页号到文件区间的页映射保存在 <path>.pmap。压缩模式不使用 O_DIRECT 与 io_uring。
+  bool compress = false;
+};
+
+// 页文件 I/O 统计（自打开起累计）：页数按逻辑页计，延迟为每次读写调用（单页或一批）与每次 fdatasync 的耗时。
+struct IoStats {
+  uint64_t pages_read = 0;
+  uint64_t pages_written = 0;
+  HistogramSnapshot read_latency;
+  HistogramSnapshot write_latency;
+  HistogramSnapshot sync_latency;
+
+  // 累加另一个文件的统计。
+  void add(const IoStats& other);
+};
+
 // 页式文件访问器：按固定页大小读写磁盘文件。
+// 基于文件描述符的定位读写，没有共享的文件偏移，也没有全局锁，不同分片可并发读写不同页。
+// 压缩模式下文件按 512 字节的存储单元分配，页改写时分配新区间，旧区间在下一次 flush
+// 保存页映射之后才回收：磁盘上的页映射始终指向完整的旧页，异常退出后由 WAL 重放之后的修改。
 class Pager {
  public:
   // path 为文件路径，page_size 为页大小（字节）。
   Pager(const std::string& path, size_t page_size);
+  Pager(const std::string& path, size_t page_size, const PagerOptions& options);
+  ~Pager();
+
+  Pager(const Pager&) = delete;
+  Pager& operator=(const Pager&) = delete;
 
   // 返回文件是否打开成功。
   bool is_open() const;
@@ -20,25 +73,109 @@ class Pager {
   const std::string& path() const;
   // 返回页大小。
   size_t page_size() const;
+  // 返回实际生效的后端（io_uring 初始化失败时为 Pread）。
+  IoBackend backend() const;
+  // 返回是否以 O_DIRECT 打开。
+  bool direct_io() const;
+  // 返回是否为压缩模式。
+  bool compressed() const;
 
   // 读取指定页到 out（size 必须等于 page_size）。
   bool read_page(size_t page_id, char* out, size_t size, std::string* err);
+  // 批量读取 page_ids[i] 到 pages[i]（每页 size 字节，必须等于 page_size）：io_uring 一次提交，
+  // 否则页号连续的部分合并为一次 preadv。
+  bool read_pages(const std::vector<size_t>& page_ids, const std::vector<char*>& pages,
+                  size_t size, std::string* err);
   // 将 data 写入指定页（size 必须等于 page_size）。
   bool write_page(size_t page_id, const char* data, size_t size, std::string* err);
-  // 刷新文件缓冲区。
-  void flush();
-  // 返回文件当前大小（字节）。
+  // 将 pages 依次写入从 first_page_id 开始的连续页（每页 size 字节，必须等于 page_size），一次提交完成。
+  bool write_pages(size_t first_page_id, const std::vector<const char*>& pages, size_t size,
+                   std::string* err);
+  // 将已写入的数据落盘（fdatasync）；压缩模式下随后保存页映射并回收被替换的旧区间。
+  bool flush(std::string* err);
+  // 返回文件当前大小（字节），由内部维护，不访问文件系统；压缩模式下为逻辑大小（页数 * 页大小）。
   size_t file_size() const;
+  // 返回 I/O 统计。
+  IoStats stats() const;
 
  private:
   // 打开文件；不存在则创建。
   bool open_file(std::string* err);
+  // 校验打开状态与页大小。
+  bool check_io(size_t size, std::string* err) const;
+  // 缓冲区与长度是否满足 O_DIRECT 的对齐要求。
+  bool aligned(const void* data, size_t size) const;
+  // 在 offset 处读满 size 字节，遇到文件末尾时补 0。
+  bool read_at(char* out, size_t size, size_t offset, std::string* err);
+  // 在 offset 处写满 size 字节。
+  bool write_at(const char* data, size_t size, size_t offset, std::string* err);
+  // 把连续页用 preadv 读入（只在不需要对齐中转时使用），到达文件末尾时补 0。
+  bool read_vector(const std::vector<char*>& pages, size_t offset, std::string* err);
+  // 把连续页用 pwritev 写出（只在不需要对齐中转时使用）。
+  bool write_vector(const std::vector<const char*>& pages, size_t offset, std::string* err);
+  // 写入成功后推进缓存的文件大小。
+  void extend_size(size_t end);
+  // 生成带 errno 的错误信息。
+  std::string io_error(const char* op, size_t offset, int code) const;
+  // fdatasync 并记录耗时。
+  void sync_file();
+
+  // 压缩页在文件中的区间；size 为 0 表示页从未写入（按全 0 读取）。
+  // epoch 为写入时的页映射版本，大于 snapshot_epoch_ 的区间不在任何（已保存或正在保存的）页映射中。
+  struct Extent {
+    uint64_t offset = 0;
+    uint32_t size = 0;
+    bool compressed = false;
+    uint64_t epoch = 0;
+  };
+  // 加载页映射并由已占用区间推出空闲区间；文件与页映射都不存在时写出空映射。
+  bool load_page_map(std::string* err);
+  // 把页映射快照写入临时文件后原子替换 <path>.pmap。
+  bool save_page_map(const std::vector<Extent>& extents, std::string* err);
+  // 分配 / 归还 units 个连续存储单元（调用方持有 map_mutex_）：归还时与相邻空闲区间合并，
+  // 位于文件末尾时直接缩回 end_unit_。
+  uint64_t allocate_units(uint64_t units);
+  void free_units(uint64_t start, uint64_t units);
+  static uint64_t units_for(size_t size);
+  bool read_compressed(size_t page_id, char* out, std::string* err);
+  bool write_compressed(size_t page_id, const char* data, std::string* err);
+  // 回收 recycle_ 中的区间（调用方持有 reuse_mutex_ 独占锁与 map_mutex_）。
+  void recycle_units();
 
   std::string path_;
   size_t page_size_ = 0;
-  std::fstream file_;
-  bool open_ = false;
-  mutable std::mutex mutex_;
+  PagerOptions options_;
+  int fd_ = -1;
+  bool direct_ = false;
+  std::atomic<size_t> file_size_{0};
+  std::unique_ptr<IoUring> uring_;
+  // 打开阶段的错误（如压缩文件缺少页映射），此后的读写都返回该错误。
+  std::string open_error_;
+  // I/O 统计。
+  Counter pages_read_;
+  Counter pages_written_;
+  LatencyHistogram read_latency_;
+  LatencyHistogram write_latency_;
+  LatencyHistogram sync_latency_;
+
+  // 压缩模式状态：map_mutex_ 保护页映射与空闲区间；读者在读区间期间持有 reuse_mutex_ 共享锁，
+  // flush 回收旧区间时持有独占锁，保证读到一半的区间不会被改写；flush_mutex_ 串行化页映射保存。
+  std::mutex map_mutex_;
+  std::shared_mutex reuse_mutex_;
+  std::mutex flush_mutex_;
+  std::vector<Extent> extents_;
+  // 空闲区间：按起始单元索引（合并相邻区间）与按（单元数，起始单元）索引（取最小可用区间）。
+  std::map<uint64_t, uint64_t> free_by_start_;
+  std::set<std::pair<uint64_t, uint64_t>> free_by_size_;
+  // 已被替换、等待页映射保存后回收的区间（起始单元与单元数）。
+  std::vector<std::pair<uint64_t, uint64_t>> pending_;
+  // 已被替换、不在任何页映射中的区间：没有读者时即可回收（写入时尝试，flush 时一定回收）。
+  std::vector<std::pair<uint64_t, uint64_t>> recycle_;
+  uint64_t write_epoch_ = 1;
+  uint64_t snapshot_epoch_ = 0;
+  // 已分配的存储单元末尾；文件在 flush 时截断到这里。
+  uint64_t end_unit_ = 0;
+  bool map_dirty_ = false;
 };
 
 }  // namespace mini_db
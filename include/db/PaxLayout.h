@@ -0,0 +1,53 @@
+#pragma once
+
+#include "db/Schema.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace mini_db {
+
+// PAX 数据页布局：每个数据页存放 rows_per_page 条记录，页内按字段切成连续的 minipage，
+// 字段 0 为有效标记，字段 i + 1 为第 i 列；每个 minipage 按槽位顺序存放本页全部记录的该字段。
+// 字段都是定长的，minipage 目录（各字段在页内的起始偏移）对每一页都相同，构造时一次算好，不写入页内。
+// 记录不跨页：第 1 页起每页依次存放 rows_per_page 行（第 0 页为表头页）。
+class PaxLayout {
+ public:
+  PaxLayout() = default;
+  // schema 的记录大小不得超过 page_size。
+  PaxLayout(const Schema& schema, size_t page_size);
+
+  // 每页容纳的记录数。
+  size_t rows_per_page() const;
+  // 字段数（有效标记 + 列数）。
+  size_t field_count() const;
+  // 字段的 minipage 在页内的起始偏移与每个值的宽度。
+  size_t minipage_offset(size_t field) const;
+  size_t field_width(size_t field) const;
+  // 行式记录中字节偏移 record_offset 处开始的字段（ScanFilter::offset 换算为 minipage）。
+  size_t field_at(size_t record_offset) const;
+
+  // 行号所在的数据页与页内槽位。
+  size_t page_for_row(uint64_t row_id) const;
+  size_t slot_for_row(uint64_t row_id) const;
+  // 数据页上第一个槽位的行号。
+  uint64_t first_row_in_page(size_t page_id) const;
+
+  // 把页中 slot 的各字段拼成行式记录 record（record_size 字节）/ 把行式记录拆写到页中 slot。
+  void gather(const char* page, size_t slot, char* record) const;
+  void scatter(const char* record, size_t slot, char* page) const;
+
+ private:
+  // 字段在行式记录中的偏移、宽度，以及 minipage 在页内的偏移。
+  struct Field {
+    size_t record_offset = 0;
+    size_t width = 0;
+    size_t page_offset = 0;
+  };
+
+  std::vector<Field> fields_;
+  size_t rows_per_page_ = 1;
+};
+
+}  // namespace mini_db
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "db/Types.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace mini_db {
+
+// mini_db_server 的二进制协议（整数均为小端）。
+// 请求帧：[u32 len][u32 request_id][u8 op][payload]，响应帧：[u32 len][u32 request_id][u8 status][payload]，
+// len 为 len 字段之后的字节数。客户端可以不等响应连续发送请求（流水线），响应按完成顺序返回，
+// 以 request_id 对应请求；同一连接上的 Query 按到达顺序逐条执行，行操作之间不保证顺序。
+//
+// 载荷中的字符串为 [u16 len][bytes]（Query 的 SQL 与响应文本为整个载荷），值为 [u8 type][...]：
+// type 0 为 INT（i32），1 为 TEXT（[u32 len][bytes]）。
+//   Ping   请求无载荷，响应无载荷。
+//   Query  请求为一条 SQL（末尾分号可省略），响应为执行器输出文本；连接即会话，事务与预备语句属于连接。
+//   Get    请求 [table][u64 row_id]，响应 [u8 valid][u16 count][value...]（valid 为 0 时 count 为 0）。
+//   Update 请求 [table][u64 row_id][u16 count]{[column][value]}，响应无载荷。
+//   Delete 请求 [table][u64 row_id]，响应无载荷。
+// 失败时 status 为 Error，载荷为错误文本。
+enum class WireOp : uint8_t {
+  Ping = 0,
+  Query = 1,
+  Get = 2,
+  Update = 3,
+  Delete = 4,
+};
+
+enum class WireStatus : uint8_t {
+  Ok = 0,
+  Error = 1,
+};
+
+// 帧头长度（len + request_id + op/status）。
+constexpr size_t kWireHeaderBytes = 9;
+
+// 一个请求或响应帧（code 为 WireOp 或 WireStatus）。
+struct WireFrame {
+  uint32_t request_id = 0;
+  uint8_t code = 0;
+  std::vector<char> payload;
+};
+
+// 载荷编码：追加到 out。
+void wire_put_u8(std::vector<char>* out, uint8_t value);
+void wire_put_u16(std::vector<char>* out, uint16_t value);
+void wire_put_u32(std::vector<char>* out, uint32_t value);
+void wire_put_u64(std::vector<char>* out, uint64_t value);
+// 字符串超过 65535 字节时截断。
+void wire_put_string(std::vector<char>* out, const std::string& value);
+void wire_put_value(std::vector<char>* out, const Value& value);
+// 追加一个完整的帧。
+void wire_put_frame(std::vector<char>* out, uint32_t request_id, uint8_t code,
+                    const std::vector<char>& payload);
+
+// 载荷解码：按顺序读取，越界或格式错误时返回 false 且位置不变。
+class WireReader {
+ public:
+  WireReader(const char* data, size_t size);
+
+  bool get_u8(uint8_t* value);
+  bool get_u16(uint16_t* value);
+  bool get_u32(uint32_t* value);
+  bool get_u64(uint64_t* value);
+  bool get_string(std::string* value);
+  bool get_value(Value* value);
+  // 是否已读完。
+  bool done() const;
+
+ private:
+  bool get_uint(size_t bytes, uint64_t* value);
+
+  const char* data_ = nullptr;
+  size_t size_ = 0;
+  size_t pos_ = 0;
+};
+
+// 从 data 开头解析一个帧：完整时写入 frame 并通过 consumed 返回帧长；数据不足时 consumed 为 0。
+// 帧长超过 max_frame_bytes 时返回 false（连接应被关闭）。
+bool wire_parse_frame(const char* data, size_t size, uint32_t max_frame_bytes, WireFrame* frame,
+                      size_t* consumed, std::string* err);
+
+}  // namespace mini_db
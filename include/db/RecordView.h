@@ -0,0 +1,88 @@
+#pragma once
+
+#include "db/PagedFile.h"
+#include "db/PaxLayout.h"
+#include "db/Schema.h"
+#include "db/SlottedPage.h"
+#include "db/Types.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace mini_db {
+
+class AddedColumns;
+
+// 记录的零拷贝只读视图：直接指向一条完整记录的字节（首字节为有效标记），按 Schema 的定长布局读取列。
+// 视图不拥有内存，只在底层页被钉住（或中转缓冲未被改写）期间有效。
+class RecordView {
+ public:
+  RecordView() = default;
+  RecordView(const Schema* schema, const char* data);
+
+  explicit operator bool() const;
+  const Schema& schema() const;
+  // 记录原始字节（长度为 schema 的 record_size）。
+  const char* data() const;
+  size_t size() const;
+  // 有效标记。
+  bool valid() const;
+  // INT 列：小端 4 字节。
+  int32_t int_at(size_t col_index) const;
+  // TEXT 列：定长字段中第一个 '\0' 之前的部分。
+  std::string_view text_at(size_t col_index) const;
+  // 物化单列 / 整行为 Value（只在需要返回给上层时调用）。
+  Value value_at(size_t col_index) const;
+  void decode(std::vector<Value>* values) const;
+  // 列值与已归一化为列类型的 value 比较，返回负数/0/正数。
+  int compare(size_t col_index, const Value& value) const;
+  // 列的定长字段是否与 Schema::encode_key 生成的键逐字节相等（等值谓词，不解码列值）。
+  bool equals(size_t col_index, const std::string& key) const;
+  // 判断列值是否满足 WHERE 比较（BETWEEN 使用 value..upper 闭区间），不物化 Value。
+  bool matches(size_t col_index, CompareOp op, const Value& value, const Value& upper) const;
+
+ private:
+  const Schema* schema_ = nullptr;
+  const char* data_ = nullptr;
+};
+
+// 记录读取游标：按偏移逐条返回 RecordView，同一页上的后续记录复用已钉住的页，不重复钉页。
+// 记录完整落在一页内时视图直接指向页帧，跨页记录复制到游标内的中转缓冲，只读映射模式下指向映射；
+// PAX 表与槽页表的记录总是拼到（还原到）中转缓冲。
+// 游标持有页的共享闩：原地写入当前页前必须先 release，否则与写闩自锁。
+class RecordCursor {
+ public:
+  RecordCursor(PagedFile* file, const Schema* schema, PageAccess access);
+
+  RecordCursor(const RecordCursor&) = delete;
+  RecordCursor& operator=(const RecordCursor&) = delete;
+
+  // 读取 offset 处的记录；之前返回的视图随之失效。
+  bool read(size_t offset, RecordView* view, std::string* err);
+  // 同上，只从文件读取记录的前 size 字节（有追加列的表），之后由 extend 补齐。
+  bool read(size_t offset, size_t size, RecordView* view, std::string* err);
+  // PAX 表：读取 page_id 页 slot 槽位的记录，钉住整页后把各 minipage 中的字段拼到中转缓冲。
+  bool read_pax(const PaxLayout& layout, size_t page_id, size_t slot, RecordView* view,
+                std::string* err);
+  // 槽页表：读取 page_id 页 slot 槽位的记录，钉住整页后还原为定长记录（长值从 overflow 读取）。
+  bool read_slotted(const SlottedLayout& layout, OverflowFile* overflow, size_t page_id,
+                    size_t slot, RecordView* view, std::string* err);
+  // 把 view（数据文件中的记录前缀）复制到中转缓冲，并从 added 读取 row_id 的追加列补齐为完整记录。
+  bool extend(AddedColumns* added, uint64_t row_id, RecordView* view, std::string* err);
+  // 释放当前钉住的页。
+  void release();
+
+ private:
+  PagedFile* file_ = nullptr;
+  const Schema* schema_ = nullptr;
+  PageAccess access_ = PageAccess::Normal;
+  PageGuard page_;
+  std::vector<char> scratch_;
+  // PAX / 槽页读取整页时 read_view 的中转缓冲（只读映射范围之外）。
+  std::vector<char> page_scratch_;
+};
+
+}  // namespace mini_db
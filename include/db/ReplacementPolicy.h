@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace mini_db {
+
+// 页缓存替换策略类型。
+enum class CachePolicy {
+  Lru,    // 精确 LRU：每次命中把帧移到链表头部（命中需持分片独占锁）。
+  Clock,  // CLOCK：命中只置引用位，命中路径只需分片共享锁。
+  TwoQ,   // 2Q：新页先进 FIFO 试用队列，再次被访问（在幽灵队列中命中）才进入主 LRU，抗顺序扫描。
+};
+
+// 页访问提示：Scan 表示一次性顺序扫描，策略不应让这些页挤掉热点页。
+enum class PageAccess {
+  Normal,
+  Scan,
+};
+
+// 解析策略名（lru / clock / 2q，大小写不敏感），未知名称返回 false。
+bool parse_cache_policy(const std::string& name, CachePolicy* policy);
+// 返回策略名（与 parse_cache_policy 接受的名称一致）。
+const char* cache_policy_name(CachePolicy policy);
+
+// 替换策略接口：由 PageCache 调用，帧以下标表示（0..capacity-1）。
+// 除 on_hit 外所有方法都在分片独占锁内调用；lock_free_hits() 为 true 时 on_hit 只在共享锁内调用，
+// 实现必须允许多个线程并发命中。
+class ReplacementPolicy {
+ public:
+  virtual ~ReplacementPolicy() = default;
+
+  // 命中路径是否可以只持共享锁。
+  virtual bool lock_free_hits() const = 0;
+  // 页 page_id 被装入帧 frame。
+  virtual void on_insert(int32_t frame, size_t page_id, PageAccess access) = 0;
+  // 帧 frame 被命中。
+  virtual void on_hit(int32_t frame, PageAccess access) = 0;
+  // 帧 frame 中的页被移出缓存（淘汰或装载失败）。
+  virtual void on_erase(int32_t frame, size_t page_id) = 0;
+  // 选择一个可淘汰的帧（evictable 判断帧是否未被钉住），没有可淘汰帧时返回 -1。
+  // 返回的帧仍在策略中，调用方随后调用 on_erase。
+  virtual int32_t pick_victim(const std::function<bool(int32_t)>& evictable) = 0;
+};
+
+// 按类型创建容量为 capacity 帧的替换策略。
+std::unique_ptr<ReplacementPolicy> create_replacement_policy(CachePolicy policy, size_t capacity);
+
+}  // namespace mini_db
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "db/Types.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace mini_db {
+
+// 全表扫描的单列过滤条件，已按列布局与类型编译好，内核直接在记录字节上求值。
+struct ScanFilter {
+  // false 表示没有 WHERE，只按有效标记过滤。
+  bool has = false;
+  ColumnType type = ColumnType::Int;
+  // 列在记录中的字节偏移与定长宽度。
+  size_t offset = 0;
+  size_t width = 0;
+  CompareOp op = CompareOp::Eq;
+  // INT 比较值（BETWEEN 为 int_value..int_upper 闭区间）。
+  int32_t int_value = 0;
+  int32_t int_upper = 0;
+  // TEXT 等值/不等：Schema::encode_key 生成的定长补 0 键，与列字段整段 memcmp。
+  std::string key;
+  // TEXT 范围比较的值（按第一个 '\0' 之前的内容比较）。
+  std::string text_value;
+  std::string text_upper;
+};
+
+// 对 base 起 count 条连续定长记录（每条 record_size 字节，首字节为有效标记，行号从 first_row 起）
+// 批量求值，把有效且满足 filter 的行号依次追加到 selected（选择向量）。
+// INT 列在支持 AVX2 的 CPU 上每条指令处理 8 行（按记录步长 gather 有效标记与列值后比较），
+// 否则使用标量实现；实现在首次调用时按 CPU 特性选定，MINI_DB_SCAN_KERNEL=scalar 强制使用标量实现。
+void filter_records(const char* base, size_t record_size, size_t count, uint64_t first_row,
+                    const ScanFilter& filter, std::vector<uint64_t>* selected);
+// PAX 页的列式求值：flags 为 count 个有效标记（每行 1 字节），column 为 WHERE 列的 minipage
+// （每行 filter.width 字节，filter.has 为 false 时不读取），行号从 first_row 起，结果追加到 selected。
+// INT 列在 AVX2 下直接连续加载 8 个标记与 8 个列值比较，不需要 gather；实现选择同 filter_records。
+void filter_columns(const char* flags, const char* column, size_t count, uint64_t first_row,
+                    const ScanFilter& filter, std::vector<uint64_t>* selected);
+// 返回当前选用的内核实现名（avx2 / scalar）。
+const char* scan_kernel_name();
+
+}  // namespace mini_db
@@ -8,6 +8,13 @@
 
 namespace mini_db {
 
+// 列在记录中的定长布局，Schema 构造时一次算好，编解码与记录视图直接查表。
+struct ColumnLayout {
+  ColumnType type = ColumnType::Int;
+  size_t offset = 0;  // 字节偏移（含 1 字节有效标记）
+  size_t width = 0;   // INT 为 4，TEXT 为列定义长度
+};
+
 // 表结构描述：负责列定义、记录编码/解码与值合法性校验。
 class Schema {
  public:
@@ -23,13 +30,37 @@ class Schema {
   size_t record_size() const;
   // 根据列名查找索引，找不到返回 -1。
   int column_index(const std::string& name) const;
+  // 列在记录中的字节偏移（含 1 字节有效标记）与定长宽度。
+  size_t column_offset(size_t col_index) const;
+  size_t column_width(size_t col_index) const;
+  // 全部列的布局（按列顺序）。
+  const std::vector<ColumnLayout>& layout() const;
+  // 数据页布局（CREATE TABLE ... USING ROW|PAX），默认行式。
+  TableLayout table_layout() const;
+  void set_table_layout(TableLayout table_layout);
+  // 表数据文件是否按页压缩（CREATE TABLE ... COMPRESSED）。
+  bool compressed() const;
+  void set_compressed(bool compressed);
+  // ALTER TABLE ADD COLUMN 只修改元数据时，表数据文件中的记录只含前 stored_columns 列，
+  // 其后的列存放在追加列文件中（见 AddedColumns）；未设置时为全部列。
+  size_t stored_columns() const;
+  void set_stored_columns(size_t count);
+  // 表数据文件中记录的结构：前 stored_columns 列，页布局与压缩选项相同。
+  Schema stored_schema() const;
+  // 将已归一化的列值编码为与记录中相同的定长字节，用作索引键。
+  std::string encode_key(size_t col_index, const Value& value) const;
 
   // 归一化单个列的值（类型转换、长度校验等）。
   bool normalize_value(size_t col_index, Value* value, std::string* err) const;
   // 校验并归一化整行数据（列数与类型匹配）。
   bool validate_values(std::vector<Value>* values, std::string* err) const;
-  // 将一行数据编码为记录字节（包含有效标记）。
-  std::vector<char> encode_record(std::vector<Value> values, bool valid, std::string* err) const;
+  // 将一行数据编码为记录字节（包含有效标记）；类型已匹配的值直接编码，其余先归一化。
+  std::vector<char> encode_record(const std::vector<Value>& values, bool valid,
+                                  std::string* err) const;
+  // 将已归一化的列值原地写入记录字节 record（长度为 record_size），只改动该列的定长字段。
+  void encode_column(size_t col_index, const Value& value, char* record) const;
+  // 记录中该列的定长字段是否与 encode_key 生成的键逐字节相等：等值谓词不解码整行。
+  bool column_equals(const char* record, size_t col_index, const std::string& key) const;
   // 从记录字节解码为一行数据，并输出有效标记。
   bool decode_record(const std::vector<char>& record, std::vector<Value>* values, bool* valid,
                      std::string* err) const;
@@ -40,6 +71,13 @@ class Schema {
   // 列定义与列名索引。
   std::vector<Column> columns_;
   std::unordered_map<std::string, size_t> column_map_;
+  // 预计算的列布局与记录大小。
+  std::vector<ColumnLayout> layout_;
+  size_t record_size_ = 1;
+  TableLayout table_layout_ = TableLayout::Row;
+  bool compressed_ = false;
+  // 0 表示全部列。
+  size_t stored_columns_ = 0;
 };
 
 }  // namespace mini_db
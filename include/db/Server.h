@@ -0,0 +1,109 @@
+#pragma once
+
+#include "db/Database.h"
+#include "db/NumaExecutor.h"
+#include "db/Protocol.h"
+#include "db/SqlParser.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+namespace mini_db {
+
+// 网络服务配置。
+struct ServerOptions {
+  // 监听地址（IPv4）与端口，端口为 0 时由系统分配（见 Server::port）。
+  std::string host = "127.0.0.1";
+  uint16_t port = 7878;
+  // 网络线程数：每个线程一个 epoll，接受连接后由该线程负责其全部收发。
+  int io_threads = 1;
+  // 执行请求的每节点工作线程数。
+  int threads_per_node = 1;
+  // 同时保持的最大连接数，超出时新连接立即关闭。
+  size_t max_connections = 1024;
+  // 每个连接未完成的请求数上限（流水线深度），达到后暂停读取该连接。
+  size_t max_pipeline = 128;
+  // 单帧最大字节数，超出视为协议错误并关闭连接。
+  uint32_t max_frame_bytes = 16u << 20;
+};
+
+// 服务统计（自启动起累计）。
+struct ServerStats {
+  uint64_t accepted = 0;
+  // 因超过 max_connections 被拒绝的连接数。
+  uint64_t rejected = 0;
+  uint64_t active = 0;
+  uint64_t requests = 0;
+};
+
+// TCP 服务（协议见 Protocol.h）：所有连接共享同一个 Database 及其缓冲池与日志。
+// 网络线程只做收发与解帧，不访问存储：行操作按目标行所在页的节点（Database::node_for_row）
+// 投递到 NumaExecutor 对应节点的工作线程；SQL 在连接自己的会话（Executor）中按到达顺序逐条执行，
+// 提交到连接固定的节点。完成的响应交回连接所属的网络线程发送。
+// DDL 语句在执行期间独占服务，其他请求只在执行期间共享持有，因此 DROP TABLE 不会与使用该表的请求重叠。
+// Database 必须比 Server 晚析构。
+class Server {
+ public:
+  Server(Database* db, int numa_nodes, const ServerOptions& options);
+  ~Server();
+
+  Server(const Server&) = delete;
+  Server& operator=(const Server&) = delete;
+
+  // 监听端口并启动网络线程与工作线程。
+  bool start(std::string* err);
+  // 关闭监听与全部连接，等待已投递的请求执行完（连接上未提交的事务回滚）。
+  void stop();
+  // 实际监听的端口。
+  uint16_t port() const;
+  ServerStats stats() const;
+
+ private:
+  struct Connection;
+  struct IoThread;
+
+  // 网络线程主循环。
+  void io_loop(IoThread* io);
+  // 接受监听队列中的全部新连接。
+  void accept_connections(IoThread* io);
+  // 处理连接上的可读 / 可写 / 有新响应：发送积压输出、读取并分派请求，连接出错或结束时关闭。
+  void service(IoThread* io, const std::shared_ptr<Connection>& conn);
+  // 读取并分派请求直到套接字读空、对端关闭或达到流水线上限；协议或套接字错误时返回 false。
+  bool pump_input(const std::shared_ptr<Connection>& conn);
+  // 发送积压输出；套接字错误时返回 false。
+  bool flush(Connection* conn);
+  void dispatch(const std::shared_ptr<Connection>& conn, WireFrame* frame);
+  // 依次执行连接排队的 SQL（在工作线程上运行）。
+  void run_sql(const std::shared_ptr<Connection>& conn);
+  void execute_sql(Connection* conn, const std::string& sql, WireStatus* status,
+                   std::vector<char>* payload);
+  // 工作线程完成请求：把响应放入连接的输出并唤醒所属网络线程。
+  void complete(const std::shared_ptr<Connection>& conn, uint32_t request_id, WireStatus status,
+                const std::vector<char>& payload);
+  void close_connection(IoThread* io, const std::shared_ptr<Connection>& conn);
+
+  Database* db_ = nullptr;
+  int numa_nodes_ = 1;
+  ServerOptions options_;
+  SqlParser parser_;
+  NumaExecutor executor_;
+  // DDL 独占、其他请求共享。
+  std::shared_mutex ddl_mutex_;
+  int listen_fd_ = -1;
+  uint16_t port_ = 0;
+  std::vector<std::unique_ptr<IoThread>> io_threads_;
+  std::atomic<bool> stop_{false};
+  bool running_ = false;
+  std::atomic<uint64_t> next_connection_{0};
+  std::atomic<uint64_t> accepted_{0};
+  std::atomic<uint64_t> rejected_{0};
+  std::atomic<uint64_t> active_{0};
+  std::atomic<uint64_t> requests_{0};
+};
+
+}  // namespace mini_db
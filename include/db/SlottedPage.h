@@ -0,0 +1,111 @@
+#pragma once
+
+#include "db/Overflow.h"
+#include "db/Schema.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace mini_db {
+
+// 槽页布局（TableLayout::Slotted）：TEXT 列按实际长度存放，长值移到溢出页文件。
+// 数据页：页头 8 字节 [u16 槽数][u16 保留][u32 堆顶偏移（0 表示页尾）]，其后为槽目录，
+// 每槽 [u16 记录偏移（0 表示空槽）][u16 分配长度]，记录从页尾向前分配。
+// 记录：[u8 有效标记]，其后依次为各列：INT 4 字节；TEXT 为 [u16 长度][字节]（去掉末尾的补 0），
+// 长度为 0xFFFF 时是溢出引用 [u32 链首页][u32 长度]。内存、日志、索引与版本中仍是定长记录，
+// 只在写页时压缩（store）、读页时还原（unpack）。
+// 行号 = (页号 - 1) * slots_per_page + 槽号。slots_per_page 按记录的最小形式（列宽超过溢出引用的
+// TEXT 值都放到溢出页）计算，任何一页都放得下全部槽位的最小形式，因此写入总能成功：
+// 放不下时先整理页内空间，再改用最小形式，最后把本页其他记录的长值也移到溢出页。
+class SlottedLayout {
+ public:
+  SlottedLayout() = default;
+  SlottedLayout(const Schema& schema, size_t page_size);
+
+  // 每页的槽位数，0 表示页太小（连一条最小形式的记录都放不下）或页大小超过 16 位偏移。
+  size_t slots_per_page() const;
+  // 行号所在的数据页与页内槽位；数据页上第一个槽位的行号。
+  size_t page_for_row(uint64_t row_id) const;
+  size_t slot_for_row(uint64_t row_id) const;
+  uint64_t first_row_in_page(size_t page_id) const;
+
+  // 页上目录的槽数（其后的槽位都为空）。
+  size_t slot_count(const char* page) const;
+  // 槽上是否有记录。
+  bool present(const char* page, size_t slot) const;
+  // 槽上记录的有效标记（空槽为 0）。
+  bool valid(const char* page, size_t slot) const;
+  // 整理页内空间后的空闲字节数（不含已有目录）；空页的可用字节数。
+  size_t free_space(const char* page) const;
+  size_t empty_space() const;
+  // 定长记录 image 写入新槽位时占用的页内字节数（不含目录项，插入选择行号时据此判断页是否放得下）。
+  size_t record_space(const char* image) const;
+
+  // 每个槽目录项的字节数。
+  static constexpr size_t kSlotSize = 4;
+
+  // 把槽上的记录还原为定长记录 image（record_size 字节），空槽还原为全 0（无效行）。
+  bool unpack(const char* page, size_t slot, OverflowFile* overflow, char* image,
+              std::string* err) const;
+  // 把定长记录 image 写入槽位，替换原记录并回收它的溢出页。redo 为 true 时处于日志重放：
+  // 只从溢出文件末尾分配新页，不回收原记录的溢出页（见 OverflowFile）。
+  bool store(char* page, size_t slot, const char* image, OverflowFile* overflow, bool redo,
+             std::string* err) const;
+  // 收集页上全部溢出引用（链首页号与值长度）。
+  void collect_overflow(const char* page, std::vector<std::pair<uint32_t, uint32_t>>* chains) const;
+
+ private:
+  // 列在定长记录中的偏移与宽度，以及最小形式下在页内预留的字节数。
+  struct Field {
+    ColumnType type = ColumnType::Int;
+    size_t offset = 0;
+    size_t width = 0;
+    size_t reserve = 0;
+  };
+
+  // TEXT 值的实际长度（去掉末尾的补 0）。
+  static size_t text_length(const char* value, size_t width);
+  // TEXT 值是否内联存放：compact 为 true 时按最小形式判断。
+  bool inline_text(const Field& field, size_t length, bool compact) const;
+  // 定长记录压缩后的字节数。
+  size_t packed_size(const char* image, bool compact) const;
+  // 压缩定长记录到 out（packed_size 字节），需要溢出的值写入溢出页。
+  bool pack(const char* image, bool compact, OverflowFile* overflow, bool redo, char* out,
+            std::string* err) const;
+  // 页内记录的字节数。
+  size_t record_length(const char* record) const;
+  // 回收页内记录引用的溢出页。
+  bool release(const char* record, OverflowFile* overflow, std::string* err) const;
+
+  // 页头与目录访问。
+  size_t heap_start(const char* page) const;
+  size_t slot_offset(const char* page, size_t slot) const;
+  size_t slot_alloc(const char* page, size_t slot) const;
+  void set_slot(char* page, size_t slot, size_t offset, size_t alloc) const;
+  // 不移动其他记录时，size 字节的记录能否放入 slot（原位覆盖或使用连续空闲区）。
+  bool fits_directly(const char* page, size_t slot, size_t size) const;
+  // 整理页内空间后能否放入。
+  bool fits_compacted(const char* page, size_t slot, size_t size) const;
+  // 为 slot 分配 size 字节并返回记录位置，必要时整理页内空间；放不下返回 nullptr。
+  char* place(char* page, size_t slot, size_t size) const;
+  // 把全部记录紧凑排列到页尾，分配长度缩为 max(记录长度, min_alloc)。
+  void compact(char* page) const;
+  // 把 slot 之外的记录改为最小形式（长值移到溢出页）。
+  bool demote(char* page, size_t slot, OverflowFile* overflow, bool redo, std::string* err) const;
+
+  std::vector<Field> fields_;
+  size_t page_size_ = 0;
+  size_t record_size_ = 0;
+  size_t min_alloc_ = 1;
+  size_t inline_limit_ = 0;
+  size_t slots_per_page_ = 0;
+
+  static constexpr size_t kPageHeaderSize = 8;
+  static constexpr size_t kRefSize = 10;
+  static constexpr uint16_t kRefMarker = 0xFFFF;
+};
+
+}  // namespace mini_db
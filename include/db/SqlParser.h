@@ -2,15 +2,39 @@
 
 #include "db/Types.h"
 
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 
 namespace mini_db {
 
 // 简易 SQL 解析器：将 SQL 文本转换为 Statement 结构。
+// 成功解析的语句按 SQL 文本缓存，重复发送的相同语句直接复制缓存的 Statement（不再词法分析）；
+// 缓存满时淘汰最早加入的语句，过长的语句（如多行 INSERT）不缓存。
 class SqlParser {
  public:
+  // cache_capacity 为缓存的语句数，0 表示不缓存。
+  explicit SqlParser(size_t cache_capacity = kDefaultCacheCapacity);
+
   // 解析 SQL，成功返回 true，失败返回 false 并写入 err。
   bool parse(const std::string& sql, Statement* statement, std::string* err) const;
+  // 解析缓存的命中 / 未命中次数。
+  uint64_t cache_hits() const;
+  uint64_t cache_misses() const;
+
+ private:
+  static constexpr size_t kDefaultCacheCapacity = 256;
+  static constexpr size_t kMaxCachedSqlBytes = 1024;
+
+  size_t cache_capacity_ = 0;
+  mutable std::mutex cache_mutex_;
+  mutable std::unordered_map<std::string, Statement> cache_;
+  mutable std::deque<std::string> cache_order_;
+  mutable uint64_t cache_hits_ = 0;
+  mutable uint64_t cache_misses_ = 0;
 };
 
 }  // namespace mini_db
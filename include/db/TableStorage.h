@@ -1,102 +1,503 @@
 #pragma once
 
+#include "db/AddedColumns.h"
+#include "db/BTreeIndex.h"
+#include "db/HashIndex.h"
 #include "db/LogManager.h"
 #include "db/PagedFile.h"
+#include "db/PaxLayout.h"
+#include "db/RecordView.h"
+#include "db/ScanKernel.h"
 #include "db/Schema.h"
+#include "db/SlottedPage.h"
+#include "db/Transaction.h"
+#include "db/VersionStore.h"
 
 #include <cstdint>
+#include <functional>
+#include <memory>
 #include <mutex>
 #include <shared_mutex>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace mini_db {
 
+// 只读打开配置（分析型只读副本）。
+struct ReadOnlyOptions {
+  // 只读打开：表文件以只读 mmap 直接提供读取（不经过 Pager 与页缓存），拒绝一切修改。
+  bool enabled = false;
+  // 按页归属节点（PageNodeSelector）对表文件映射分段 mbind。
+  bool numa_bind = false;
+};
+
+// 表锁等待统计：只记录未能立即取得的加锁（无竞争的加锁不计时），直方图的样本数即等待次数。
+struct LockStats {
+  HistogramSnapshot table_shared;
+  HistogramSnapshot table_exclusive;
+  HistogramSnapshot page;
+
+  // 累加另一个表的统计。
+  void add(const LockStats& other);
+};
+
+class NumaExecutor;
+class TableStorage;
+
+// 全表扫描的并行配置。
+struct ScanOptions {
+  // 启用 morsel 并行扫描（需要 Database 提供扫描执行器）。
+  bool parallel = true;
+  // 每个节点的扫描线程数，0 表示按在线 CPU 数均分到各节点。
+  int threads_per_node = 0;
+  // 每个 morsel 覆盖的连续页数；每个 morsel 在每个节点上各有一个任务，只处理归属该节点的页。
+  size_t morsel_pages = 64;
+  // 表数据页数少于该值时在调用线程上直接扫描。
+  size_t min_parallel_pages = 256;
+};
+
+// 流式查询游标（TableStorage::open_cursor 创建）：持有表共享锁与打开时的读取快照，按批返回满足 WHERE
+// 的行，返回内容与顺序同 select。全表扫描每次过滤一个 morsel 的页（在调用线程上，不并行），
+// 索引访问按候选行推进；返回 limit 行后不再读取。持有期间与 select 一样阻塞该表的插入与 DDL，
+// 读完或出错时自动释放，提前结束时调用 close。游标不得晚于表对象析构，打开后事务的暂存写入不能再修改。
+class TableCursor {
+ public:
+  ~TableCursor();
+
+  TableCursor(const TableCursor&) = delete;
+  TableCursor& operator=(const TableCursor&) = delete;
+
+  // 读取下一批最多 max_rows 行（rows 先清空）；读完后 rows 为空且 done() 为 true。
+  bool next(size_t max_rows, std::vector<std::vector<Value>>* rows, std::string* err);
+  // 是否已读完（或已关闭）。
+  bool done() const;
+  // 释放快照与表锁，之后 next 不再返回行。
+  void close();
+
+ private:
+  friend class TableStorage;
+
+  explicit TableCursor(TableStorage* table);
+
+  bool next_indexed(size_t want, std::vector<std::vector<Value>>* rows, std::string* err);
+  bool next_scan(size_t want, std::vector<std::vector<Value>>* rows, std::string* err);
+
+  TableStorage* table_ = nullptr;
+  std::shared_lock<std::shared_mutex> lock_;
+  std::unique_ptr<VersionSnapshot> snapshot_;
+  const StagedRows* staged_ = nullptr;
+  // 预解析的 WHERE。
+  Condition where_;
+  int where_idx_ = -1;
+  Value where_value_;
+  Value where_upper_;
+  std::string where_key_;
+  uint64_t limit_ = kNoLimit;
+  uint64_t returned_ = 0;
+  bool done_ = false;
+  // 索引访问：候选行与读取位置。
+  bool indexed_ = false;
+  std::vector<uint64_t> candidates_;
+  size_t pos_ = 0;
+  // 全表扫描：下一个待过滤的页与末页，以及当前 morsel 尚未取走的命中行。
+  ScanFilter filter_;
+  size_t next_page_ = 0;
+  size_t end_page_ = 0;
+  std::vector<uint64_t> pending_rows_;
+  std::vector<std::vector<Value>> pending_values_;
+  size_t pending_pos_ = 0;
+};
+
 // 单表存储引擎：负责表文件读写、记录管理、简单的增删改查与日志写入。
 class TableStorage {
  public:
-  // path 为表文件路径，name 为表名，schema 为表结构，numa_nodes 为 NUMA 节点数。
-  TableStorage(const std::string& path, const std::string& name, const Schema& schema,
-               size_t page_size, size_t cache_pages, int numa_nodes, LogManager* log);
+  // path 为表文件路径，name 为表名，table_id 为日志中使用的表 ID，schema 为表结构，
+  // numa_nodes 为 NUMA 节点数，cache 为表文件的页缓存配置（空闲页映射与索引文件沿用其替换策略），
+  // read_only 启用时表文件只读映射，页缓存只保留最小容量。
+  TableStorage(const std::string& path, const std::string& name, uint32_t table_id,
+               const Schema& schema, size_t page_size, size_t cache_pages, int numa_nodes,
+               const CacheOptions& cache, LogManager* log, const ReadOnlyOptions& read_only);
+
+  // 设置全表扫描使用的执行器（由 Database 持有，各节点工作线程绑定在本节点），nullptr 表示串行扫描。
+  void set_scan_executor(NumaExecutor* executor, const ScanOptions& options);
+  // 把表数据文件的缓存分片交给全库缓冲管理器分配配额（由 Database 持有），nullptr 表示独立使用 cache_pages。
+  void set_buffer_manager(BufferManager* manager);
 
   // 加载表文件（新建或读取头部与重建空闲列表）。
+  // 只读模式下映射表文件并读取表头，不维护空闲列表，只加载已正常保存的索引（其余索引不用，查询退回扫描）。
   bool load(std::string* err);
   // 返回表名。
   const std::string& name() const;
+  // 返回表 ID。
+  uint32_t table_id() const;
   // 返回表结构。
   const Schema& schema() const;
   // 返回当前记录数（包含已删除的逻辑行）。
   uint64_t row_count() const;
+  // 表结构版本：建表与每次修改表结构时取进程内唯一的新值（同名重建的表也不同）。
+  // bind_schema 在表共享锁内一起读出表结构与版本，供预备语句绑定（见 BoundDml）。
+  void bind_schema(Schema* schema, uint64_t* schema_epoch) const;
 
   // 插入一行，返回行号（row_id）。
   bool insert(const std::vector<Value>& values, uint64_t* row_id, std::string* err);
-  // 查询：仅支持单列等值过滤。
+  // 批量装载：整批校验并占用索引键后，把记录按行号连续追加到表尾（不复用空闲行），在内存中拼成整页后
+  // 按页顺序写入；同一页起始的行合为一条 BulkInsert 日志记录，表头只写一次，整批只等待一次日志落盘。
+  // 任一行校验或唯一约束失败时整批不写入。first_row 输出第一行的行号。
+  bool bulk_insert(const std::vector<std::vector<Value>>& rows, uint64_t* first_row,
+                   std::string* err);
+  // 查询：仅支持单列等值过滤。持表共享锁读取开始时的快照（见 VersionStore），
+  // 不阻塞按行号的更新与删除，扫描期间被改写的行返回快照时的版本。
   bool select(const Condition& where, std::vector<std::vector<Value>>* rows, std::string* err);
+  // 事务内的查询：staged 为事务在本表的暂存写入（可为空），暂存行按暂存记录求值（读到自己的写入）。
+  bool select(const Condition& where, const StagedRows* staged,
+              std::vector<std::vector<Value>>* rows, std::string* err);
+  // 打开流式查询游标（见 TableCursor），staged 含义同 select，limit 为最多返回的行数。
+  bool open_cursor(const Condition& where, const StagedRows* staged, uint64_t limit,
+                   std::unique_ptr<TableCursor>* cursor, std::string* err);
   // 更新：支持 SET 多列与可选 WHERE 条件。
   bool update(const std::vector<SetClause>& sets, const Condition& where, size_t* updated,
               std::string* err);
   // 删除：逻辑删除并加入空闲列表。
   bool remove(const Condition& where, size_t* removed, std::string* err);
+  // 按绑定参数执行的 INSERT（rows 的第一行或整批）/ 查询 / UPDATE / DELETE：直接使用 bound 中的列下标与
+  // 已归一化的值。bound.schema_epoch 与当前表结构版本不一致时不执行，置 stale 并返回 false。
+  bool insert(const BoundDml& bound, uint64_t* row_id, bool* stale, std::string* err);
+  bool bulk_insert(const BoundDml& bound, uint64_t* first_row, bool* stale, std::string* err);
+  bool open_cursor(const BoundDml& bound, const StagedRows* staged, uint64_t limit,
+                   std::unique_ptr<TableCursor>* cursor, bool* stale, std::string* err);
+  bool update(const BoundDml& bound, size_t* updated, bool* stale, std::string* err);
+  bool remove(const BoundDml& bound, size_t* removed, bool* stale, std::string* err);
 
   // 按行号读取记录（用于多线程按页路由场景）。
+  // 读路径先做乐观读（不加页锁，按页版本校验复制记录），记录跨页或页不在缓存中时才加页锁读取。
   bool read_row(uint64_t row_id, std::vector<Value>* values, bool* valid, std::string* err);
+  // 按行号读取记录视图并交给 visit（不物化 Value），视图只在回调期间有效。
+  bool read_row(uint64_t row_id, const std::function<void(const RecordView&)>& visit,
+                std::string* err);
   // 按行号更新指定列（不会扫描全表）。
   bool update_row(uint64_t row_id, const std::vector<SetClause>& sets, std::string* err);
+  // 批量按行号读取：逐行先做乐观读，失败时同一页锁分片上的连续行只加一次页锁，visit(i, view) 的 i 为
+  // row_ids 中的下标（按行号顺序回调），视图只在回调期间有效。
+  bool read_rows(const std::vector<uint64_t>& row_ids,
+                 const std::function<void(size_t, const RecordView&)>& visit, std::string* err);
+  // 批量按行号更新相同的列：加锁方式同 read_rows，已删除的行跳过，整批只等待一次日志落盘。
+  bool update_rows(const std::vector<uint64_t>& row_ids, const std::vector<SetClause>& sets,
+                   size_t* updated, std::string* err);
   // 按行号逻辑删除记录。
   bool delete_row(uint64_t row_id, std::string* err);
   // 按行号覆盖写入记录（valid=false 表示逻辑删除）。
   bool write_row(uint64_t row_id, const std::vector<Value>& values, bool valid, std::string* err);
+  // 事务内的写入：持表独占锁暂存到 staged 并为行加锁，不写日志也不修改数据页。
+  // 新键在暂存时占用（唯一约束冲突在语句中报告），旧键保留到写回；行被其他事务锁住时失败。
+  bool stage_insert(uint64_t txn, const std::vector<Value>& values, StagedRows* staged,
+                    uint64_t* row_id, std::string* err);
+  bool stage_update(uint64_t txn, const std::vector<SetClause>& sets, const Condition& where,
+                    StagedRows* staged, size_t* updated, std::string* err);
+  bool stage_remove(uint64_t txn, const Condition& where, StagedRows* staged, size_t* removed,
+                    std::string* err);
+  // 事务内按绑定参数的写入（stale 含义同 update(const BoundDml&)），stage_insert 暂存 bound.rows[row]。
+  bool stage_insert(uint64_t txn, const BoundDml& bound, size_t row, StagedRows* staged,
+                    uint64_t* row_id, bool* stale, std::string* err);
+  bool stage_update(uint64_t txn, const BoundDml& bound, StagedRows* staged, size_t* updated,
+                    bool* stale, std::string* err);
+  bool stage_remove(uint64_t txn, const BoundDml& bound, StagedRows* staged, size_t* removed,
+                    bool* stale, std::string* err);
+  // 提交第一步：为每个暂存行追加 TxnRow 日志记录，lsns 按分区记录本表的最大 LSN。
+  bool log_staged(uint64_t txn, StagedRows* staged, std::vector<uint64_t>* lsns, std::string* err);
+  // 提交最后一步（提交记录已落盘）：写回数据页、释放旧键、维护空闲列表并释放行锁。
+  // 全部暂存行共用一个版本时间戳，快照读要么看到本表的全部修改，要么都看不到。
+  bool apply_staged(uint64_t txn, StagedRows* staged, std::string* err);
+  // 回滚：释放暂存占用的新键、归还本事务分配的行号并释放行锁。
+  void discard_staged(uint64_t txn, StagedRows* staged);
+  // 是否有事务持有本表的行锁（有未提交写入时拒绝 DDL）。
+  bool has_row_locks() const;
   // 根据行号计算其所在页号。
   size_t page_id_for_row(uint64_t row_id) const;
+  // 返回行所在页的 NUMA 节点对应的日志分区（行的所有日志都写入该分区）。
+  int log_partition_for_row(uint64_t row_id) const;
+  // 返回行所在页的页帧当前所在节点（按行路由任务时使用，Adaptive 策略下随页帧迁移变化）。
+  int node_for_row(uint64_t row_id) const;
 
-  // 日志恢复时应用 redo 记录（覆盖指定 row_id）。
+  // 日志恢复时应用 redo 记录（覆盖指定 row_id）；不同页的记录可由多个线程并发应用。
   bool apply_redo(uint64_t row_id, const std::vector<char>& record, std::string* err);
-  // ALTER TABLE 后重建文件（根据新 schema 迁移数据）。
+  // 应用批量装载记录：records 为从 first_row 开始的 size 字节连续整行记录，每条 record_size 字节
+  //（ADD COLUMN 只修改元数据之前写入的记录按当时的结构编码，缺少的尾部列补默认值），count 输出行数。
+  bool apply_redo_range(uint64_t first_row, const char* records, size_t size, size_t record_size,
+                        size_t* count, std::string* err);
+  // 重放结束后根据被重放行的最终有效性更新行数与空闲列表，无需全表扫描。
+  bool finish_redo(const std::unordered_map<uint64_t, bool>& valid_by_row, std::string* err);
+  // ALTER TABLE 后重建文件（根据新 schema 迁移数据，追加列文件中的列并回数据文件）。
   bool rebuild_for_schema(const Schema& new_schema, std::string* err);
+  // 只修改元数据的 ADD COLUMN：new_schema 在当前结构后追加一列且 stored_columns 不变，已有记录不改写，
+  // 新列存放在追加列文件中（见 AddedColumns）。调用方持有 exclusive_lock 且表上没有行锁。
+  void add_column_locked(const Schema& new_schema);
   // 扫描重建空闲列表（删除标记的行）。
   bool rebuild_free_list(std::string* err);
   // 刷新缓存与文件。
   void flush(std::string* err);
   // 返回该表缓存分片中每个 NUMA 节点的页数量。
   std::vector<size_t> cached_pages_per_node() const;
+  // 返回表文件缓冲池已完成的页帧迁移次数。
+  uint64_t page_migrations() const;
+  // 返回表数据文件缓冲池的命中统计。
+  CacheStats cache_stats() const;
+  // 返回表数据文件每个缓存分片（下标为节点）的统计。
+  std::vector<CacheStats> cache_stats_per_node() const;
+  // 返回表的全部文件（数据、空闲页映射、溢出页与追加列文件）的 I/O 统计之和。
+  IoStats io_stats() const;
+  // 返回表锁与页锁的等待统计。
+  LockStats lock_stats() const;
+  // 返回表数据文件各缓存分片中的页号（保存预热列表时使用）。
+  std::vector<std::vector<size_t>> resident_pages() const;
+  // 把 page_ids 中页帧位于 node 的数据页读入缓存（见 PagedFile::warm），持表共享锁。
+  size_t warm(int node, const std::vector<size_t>& page_ids, bool* full);
+  // 独占表锁，阻塞该表所有读写（检查点切换日志段时使用）。等待时间计入锁统计。
+  std::unique_lock<std::shared_mutex> exclusive_lock();
+
+  // 注册 catalog 中已有的索引（在 load 之前调用，load 时加载快照或重建）。
+  bool set_indexes(const std::vector<IndexDef>& defs, std::string* err);
+  // 新建索引：扫描现有数据建立并写出快照。
+  bool create_index(const IndexDef& def, std::string* err);
+  // 删除索引及其快照文件。
+  bool drop_index(const std::string& name, std::string* err);
+  // 返回该表在磁盘上的全部文件（表文件、空闲页映射、索引快照）。
+  std::vector<std::string> data_files() const;
 
  private:
+  friend class TableCursor;
+
   // 表文件头部：魔数、记录大小、行数等元数据。
   struct Header {
     char magic[4];
     uint32_t record_size;
     uint64_t row_count;
-    uint64_t reserved;
+    // 标志位，见 kHeaderFlagFreeMap。
+    uint64_t flags;
   };
 
+  // 只读模式的加载流程。
+  bool load_read_only(std::string* err);
+  // 扫描重建空闲列表（调用方已持有表独占锁）。
+  bool rebuild_free_list_locked(std::string* err);
+  // 读取持久化的空闲列表（.fsm 文件）；映射缺失或无效时 loaded 为 false。
+  bool load_free_list(bool* loaded, std::string* err);
+  // 将内存中的空闲列表整体写入空闲页映射。
+  bool save_free_list(std::string* err);
+  // 增量维护空闲页映射：压入一个空闲行 / 取出一个可复用的空闲行。
+  bool push_free_row(uint64_t row_id, std::string* err);
+  bool take_free_row(uint64_t* row_id, bool* found, std::string* err);
+  // 写回空闲页映射中的条目数。
+  bool store_free_count(std::string* err);
+  // 按定义创建索引对象（校验列是否存在）。
+  bool make_index(const IndexDef& def, std::unique_ptr<Index>* index, std::string* err);
+  // 扫描全表重建索引；调用方持有表独占锁或处于加载阶段。
+  bool build_index(Index* index, std::string* err);
+  // 索引文件路径（哈希索引快照 .hidx / B+ 树 .bpt）。
+  std::string index_path(const IndexDef& def) const;
+  // 若 WHERE 列上有可用索引（等值优先哈希索引，范围需要 B+ 树），输出候选行并置 used。
+  bool index_candidates(const Condition& where, int col_index, const Value& value,
+                        const Value& upper, std::vector<uint64_t>* rows, bool* used,
+                        std::string* err);
+  // 预解析 WHERE：列下标（无 WHERE 时为 -1）、按列类型归一化的比较值，等值条件同时预编码定长键。
+  bool resolve_where(const Condition& where, int* where_idx, Value* value, Value* upper,
+                     std::string* key, std::string* err) const;
+  // 按列名解析 SET：列下标与按列类型归一化后的值。
+  bool bind_sets(const std::vector<SetClause>& sets,
+                 std::vector<std::pair<size_t, Value>>* set_values, std::string* err) const;
+  // 按列名解析 SET 与 WHERE，得到与预备语句相同的绑定参数（schema_epoch 不填）。
+  bool bind(const std::vector<SetClause>& sets, const Condition& where, BoundDml* bound,
+            std::string* err) const;
+  // 核对绑定参数的表结构版本，调用方持表锁（表结构只在表独占锁内修改）。
+  bool check_binding(const BoundDml& bound, bool* stale, std::string* err) const;
+  // 各写入与游标的执行部分：参数已解析，调用方持表锁（写入持独占锁，提交前由这里释放）。
+  bool insert_locked(std::unique_lock<std::shared_mutex>* table_lock,
+                     const std::vector<Value>& values, uint64_t* row_id, std::string* err);
+  bool bulk_insert_locked(std::unique_lock<std::shared_mutex>* table_lock,
+                          const std::vector<std::vector<Value>>& rows, bool normalized,
+                          uint64_t* first_row, std::string* err);
+  bool update_locked(std::unique_lock<std::shared_mutex>* table_lock, const BoundDml& bound,
+                     size_t* updated, std::string* err);
+  bool remove_locked(std::unique_lock<std::shared_mutex>* table_lock, const BoundDml& bound,
+                     size_t* removed, std::string* err);
+  bool stage_insert_locked(uint64_t txn, const std::vector<Value>& values, StagedRows* staged,
+                           uint64_t* row_id, std::string* err);
+  bool stage_update_locked(uint64_t txn, const BoundDml& bound, StagedRows* staged,
+                           size_t* updated, std::string* err);
+  bool stage_remove_locked(uint64_t txn, const BoundDml& bound, StagedRows* staged,
+                           size_t* removed, std::string* err);
+  // 游标已持表共享锁并填好预解析的 WHERE：取快照并规划索引访问或扫描。
+  bool start_cursor(std::unique_ptr<TableCursor> opened, const StagedRows* staged, uint64_t limit,
+                    std::unique_ptr<TableCursor>* cursor, std::string* err);
+  // 把 WHERE 编译为批量过滤内核的条件。
+  ScanFilter make_filter(const Condition& where, int col_index, const Value& value,
+                         const Value& upper, const std::string& key) const;
+  // 索引候选的快照修正：去掉重复行，补上快照之后被改写过的行（旧键可能命中）。调用方持表共享锁。
+  void add_snapshot_candidates(const VersionSnapshot& snapshot,
+                               std::vector<uint64_t>* candidates) const;
+  // 读取候选行对快照（及事务暂存写入）可见的记录视图。
+  bool read_visible(uint64_t row_id, const StagedRows* staged, const VersionSnapshot& snapshot,
+                    RecordCursor* cursor, std::vector<char>* image, RecordView* view,
+                    std::string* err);
+  // 把 [first_row, end_row) 内的暂存行按行号归并进扫描结果 rows / values：暂存行按暂存记录重新判断。
+  void merge_staged(const StagedRows& staged, uint64_t first_row, uint64_t end_row,
+                    const Condition& where, int where_idx, const Value& value, const Value& upper,
+                    const std::string& key, std::vector<uint64_t>* rows,
+                    std::vector<std::vector<Value>>* values) const;
+  // 无可用索引时的全表扫描：逐页把完整落在页内的记录交给批量过滤内核（见 ScanKernel），
+  // 跨页记录复制后单独求值（PAX 表直接在有效标记与 WHERE 列的 minipage 上求值），输出有效且满足 WHERE 的行号（选择向量，按行号有序）。
+  // values 非空时同时物化命中行。页数达到阈值且设置了扫描执行器时按 morsel 并行扫描。
+  // key 为等值条件预编码的定长键（可为空）。snapshot 为空时读取最新内容，调用方持有表独占锁；
+  // 否则按快照读取，调用方持有表共享锁。
+  bool scan_candidates(const Condition& where, int col_index, const Value& value,
+                       const Value& upper, const std::string& key, const VersionSnapshot* snapshot,
+                       std::vector<uint64_t>* rows, std::vector<std::vector<Value>>* values,
+                       std::string* err);
+  // 过滤 [first_page, end_page) 中的记录；node >= 0 时只处理归属该节点的页。
+  bool scan_pages(const ScanFilter& filter, size_t first_page, size_t end_page, int node,
+                  const VersionSnapshot* snapshot, std::vector<uint64_t>* rows,
+                  std::vector<std::vector<Value>>* values, std::string* err);
+  // 快照读：把 page_id 上在快照之后被改写的行换成快照时的版本重新求值。
+  // rows / values 中从 begin 开始是该页按当前内容得到的结果。
+  void apply_snapshot(const ScanFilter& filter, size_t page_id, const VersionSnapshot& snapshot,
+                      size_t begin, std::vector<uint64_t>* rows,
+                      std::vector<std::vector<Value>>* values);
+  // 索引维护：写日志前占用新键（唯一冲突时失败）/ 写入成功后释放旧键 / 删除行的全部键。
+  bool reserve_index_keys(const std::vector<char>* before, const std::vector<char>& after,
+                          uint64_t row_id, std::string* err);
+  bool release_index_keys(const std::vector<char>* before, const std::vector<char>* after,
+                          uint64_t row_id, std::string* err);
+  bool erase_index_keys(const std::vector<char>& record, uint64_t row_id, std::string* err);
+  // 事务改写暂存行时的索引维护：占用 next 中新出现的键（与 prev 或已提交记录 base 相同的键已在索引中），
+  // 再删除只属于上一个暂存记录 prev 的键；base 的键保留到写回，其他会话仍按已提交记录查索引。
+  bool stage_index_keys(const std::vector<char>& base, const std::vector<char>& prev,
+                        const std::vector<char>& next, uint64_t row_id, std::string* err);
+  // 把 row_id 的新记录暂存到 staged（首次改写时加行锁并以 current 作为已提交记录）。
+  bool stage_row(uint64_t txn, StagedRows* staged, uint64_t row_id,
+                 const std::vector<char>& current, std::vector<char> next, std::string* err);
+  // 事务内 UPDATE/DELETE 的目标：按事务视图（暂存行用暂存记录）满足 WHERE 的有效行及其当前记录；
+  // 命中被其他事务锁住的行时失败，语句不暂存任何行。调用方持有表独占锁。
+  bool stage_targets(uint64_t txn, const BoundDml& bound, const StagedRows* staged,
+                     std::vector<std::pair<uint64_t, std::vector<char>>>* targets,
+                     std::string* err);
+  // 自动提交的写入：行被事务锁住时失败（NO_WAIT）。
+  bool check_unlocked(uint64_t row_id, std::string* err) const;
+  // 自动提交的扫描写入：写之前检查全部命中行，避免语句因行锁只执行一部分。
+  bool check_candidates_unlocked(const std::vector<uint64_t>& candidates, const Condition& where,
+                                 int where_idx, const Value& where_value,
+                                 const Value& where_upper, const std::string& where_key,
+                                 std::string* err);
   // 读取/写入表头。
   bool read_header(std::string* err);
   bool write_header(std::string* err);
-  // 按 row_id 读取/写入记录（含有效标记）。
+  // 按 row_id 读取/写入记录（含有效标记）；全表扫描以 PageAccess::Scan 读取，避免冲掉热点页。
   bool read_record(uint64_t row_id, std::vector<char>* record, std::string* err);
+  bool read_record(uint64_t row_id, std::vector<char>* record, PageAccess access,
+                   std::string* err);
   bool write_record(uint64_t row_id, const std::vector<char>& record, std::string* err);
+  // lsn 为该修改对应的日志 LSN，数据页写出前日志须先持久化到该 LSN。
+  bool write_record(uint64_t row_id, const std::vector<char>& record, uint64_t lsn,
+                    std::string* err);
+  // 写入从 first_row 起的 count 条连续记录（data 为行式记录依次拼接），逐页写入。
+  // redo 为 true 时处于日志重放（槽页表只从溢出文件末尾分配新页，不回收旧记录的溢出页）。
+  bool write_records(uint64_t first_row, const char* data, size_t count, uint64_t lsn, bool redo,
+                     std::string* err);
+  // 游标按表布局读取 row_id 的记录视图。
+  bool read_record_view(RecordCursor* cursor, uint64_t row_id, RecordView* view,
+                        std::string* err);
+  // 是否为 PAX 布局 / 槽页布局。
+  bool pax() const;
+  bool slotted() const;
+  bool compressed() const;
+  // 为 count 条新记录（data 为定长记录依次拼接）分配追加的行号，调用方持表独占锁并随后更新 row_count_。
+  // 槽页表按页内剩余空间分配：当前末页放不下时跳到下一页的第一个槽位，跳过的槽位保持为空。
+  bool next_row_ids(const char* data, size_t count, std::vector<uint64_t>* row_ids,
+                    std::string* err);
+  // 槽页表中 row_id 的槽位上是否有记录（从未写入的空槽不进入空闲列表）；其他布局总为 true。
+  bool row_present(uint64_t row_id, bool* present, std::string* err);
+  // 扫描全部数据页收集溢出引用，重建溢出文件的空闲页列表。
+  bool rebuild_overflow(std::string* err);
+  // 等待 lsn 对应的日志记录按提交模式持久化。
+  bool commit(int partition, uint64_t lsn, std::string* err);
+  // 扫描类写入提交：等待每个分区中的最大 LSN 落盘。
+  bool commit_all(const std::vector<uint64_t>& lsns, std::string* err);
   // 预留：用于生成新行号（当前实现直接使用 row_count_ / 空闲列表）。
   uint64_t allocate_row_id();
   // 计算记录在文件中的偏移。
   size_t record_offset(uint64_t row_id) const;
+  // 乐观读一条记录到 out（调用方持表共享锁，不加页锁）：记录跨页、页不在缓存中、表为 PAX / 槽页布局
+  // 或有追加列时返回 false。
+  bool read_record_optimistic(uint64_t row_id, std::vector<char>* out);
+  // 批量行操作的处理顺序：按行号稳定排序后的下标。
+  std::vector<size_t> batch_order(const std::vector<uint64_t>& row_ids) const;
+  // 起始偏移落在该页内的第一条记录的行号。
+  uint64_t first_row_in_page(size_t page_id) const;
   // 根据页号选择锁分片，降低锁开销。
   std::mutex& page_lock(size_t page_id);
+  // 加页锁分片 / 表共享锁，等待时间计入锁统计。
+  std::unique_lock<std::mutex> lock_page(size_t page_id);
+  std::shared_lock<std::shared_mutex> shared_table_lock() const;
 
   std::string path_;
   std::string name_;
+  uint32_t table_id_ = 0;
   Schema schema_;
+  // 表结构版本（见 bind_schema），与 schema_ 一起在表独占锁内修改。
+  uint64_t schema_epoch_ = 0;
+  // 表数据文件中记录的结构（schema_ 的前 stored_columns 列），记录偏移、页布局与表头都按它计算；
+  // 其余列在 added_ 中（没有追加列时为空）。
+  Schema stored_schema_;
+  std::unique_ptr<AddedColumns> added_;
+  // PAX 布局的 minipage 目录（随 stored_schema_ 重建，行式表不使用）。
+  PaxLayout pax_;
+  // 槽页布局与溢出页文件（.ovf，只有槽页表创建）。
+  SlottedLayout slotted_;
+  std::unique_ptr<OverflowFile> overflow_;
   PagedFile file_;
+  // 持久化的空闲列表（与表文件同名的 .fsm 文件），随表一起在检查点刷盘。
+  PagedFile free_map_;
   LogManager* log_ = nullptr;
   uint64_t row_count_ = 0;
+  uint64_t header_flags_ = 0;
   std::vector<uint64_t> free_list_;
   size_t page_size_ = 0;
   size_t cache_pages_ = 0;
   int numa_nodes_ = 1;
+  CacheOptions cache_options_;
+  ReadOnlyOptions read_only_;
+  NumaExecutor* scan_executor_ = nullptr;
+  ScanOptions scan_options_;
   mutable std::shared_mutex table_mutex_;
   std::mutex meta_mutex_;
   std::vector<std::mutex> page_mutexes_;
+  // 表锁与页锁的等待时间。
+  mutable LatencyHistogram table_shared_waits_;
+  LatencyHistogram table_exclusive_waits_;
+  LatencyHistogram page_waits_;
+  // 按行号改写记录时保存的旧版本（select 快照读取）。
+  VersionStore versions_;
+  // 未提交事务持有的行锁。
+  RowLockTable row_locks_;
+  // 表上的索引；集合本身只在 DDL（持有表独占锁）时修改，index_mutex_ 保护与检查点保存的并发。
+  std::vector<std::unique_ptr<Index>> indexes_;
+  mutable std::mutex index_mutex_;
 
   static constexpr size_t kHeaderSize = 32;
+  // 表头标志：空闲列表已由 .fsm 文件增量维护。
+  static constexpr uint64_t kHeaderFlagFreeMap = 1;
+  // 表头标志：数据页为 PAX 布局。
+  static constexpr uint64_t kHeaderFlagPax = 2;
+  // 表头标志：数据页为槽页布局。
+  static constexpr uint64_t kHeaderFlagSlotted = 4;
+  // 表头标志：表数据文件按页压缩。
+  static constexpr uint64_t kHeaderFlagCompressed = 8;
+  static constexpr size_t kFreeMapHeaderSize = 16;
+  static constexpr size_t kFreeMapCachePages = 16;
+  static constexpr size_t kOverflowCachePages = 64;
+  // 每个追加列文件的缓存页数。
+  static constexpr size_t kAddedColumnCachePages = 64;
+  // 每个 B+ 树索引文件的缓存页数。
+  static constexpr size_t kBTreeCachePages = 64;
   static constexpr size_t kPageLockStripes = 64;
 };
 
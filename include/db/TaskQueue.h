@@ -0,0 +1,186 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace mini_db {
+
+// 执行器任务：类型擦除的 void() 可调用对象，闭包不超过 kInlineSize 字节时就地存放（不做堆分配），
+// 更大的闭包才退回堆上。只能移动。
+class Task {
+ public:
+  static constexpr size_t kInlineSize = 160;
+
+  Task() = default;
+  template <typename Fn, typename F = std::decay_t<Fn>,
+            typename = std::enable_if_t<!std::is_same<F, Task>::value>>
+  explicit Task(Fn&& fn) {
+    if constexpr (sizeof(F) <= kInlineSize && alignof(F) <= alignof(std::max_align_t) &&
+        std::is_nothrow_move_constructible<F>::value) {
+      new (storage_) F(std::forward<Fn>(fn));
+      ops_ = inline_ops<F>();
+    } else {
+      *reinterpret_cast<F**>(storage_) = new F(std::forward<Fn>(fn));
+      ops_ = heap_ops<F>();
+    }
+  }
+  ~Task() { reset(); }
+
+  Task(Task&& other) noexcept { take(&other); }
+  Task& operator=(Task&& other) noexcept {
+    if (this != &other) {
+      reset();
+      take(&other);
+    }
+    return *this;
+  }
+  Task(const Task&) = delete;
+  Task& operator=(const Task&) = delete;
+
+  explicit operator bool() const { return ops_ != nullptr; }
+  void operator()() { ops_->invoke(storage_); }
+  void reset() {
+    if (ops_) {
+      ops_->destroy(storage_);
+      ops_ = nullptr;
+    }
+  }
+
+#ifdef MINI_DB_TRACE
+  // 入队时的追踪时钟（0 表示未记录），工作线程取出时据此记录排队区间。
+  uint64_t enqueued_at = 0;
+#endif
+
+ private:
+  struct Ops {
+    void (*invoke)(void* storage);
+    // 把 src 中的闭包移动到 dst，并销毁 src 中的闭包。
+    void (*relocate)(void* dst, void* src);
+    void (*destroy)(void* storage);
+  };
+
+  template <typename F>
+  static const Ops* inline_ops() {
+    static const Ops ops = {
+        [](void* storage) { (*static_cast<F*>(storage))(); },
+        [](void* dst, void* src) {
+          new (dst) F(std::move(*static_cast<F*>(src)));
+          static_cast<F*>(src)->~F();
+        },
+        [](void* storage) { static_cast<F*>(storage)->~F(); },
+    };
+    return &ops;
+  }
+
+  template <typename F>
+  static const Ops* heap_ops() {
+    static const Ops ops = {
+        [](void* storage) { (**static_cast<F**>(storage))(); },
+        [](void* dst, void* src) { *static_cast<F**>(dst) = *static_cast<F**>(src); },
+        [](void* storage) { delete *static_cast<F**>(storage); },
+    };
+    return &ops;
+  }
+
+  void take(Task* other) {
+#ifdef MINI_DB_TRACE
+    enqueued_at = other->enqueued_at;
+#endif
+    ops_ = other->ops_;
+    if (ops_) {
+      ops_->relocate(storage_, other->storage_);
+      other->ops_ = nullptr;
+    }
+  }
+
+  alignas(std::max_align_t) unsigned char storage_[kInlineSize];
+  const Ops* ops_ = nullptr;
+};
+
+// 有界无锁多生产者多消费者任务队列（按序号的环形数组）：任务直接存放在槽位中，入队出队不做堆分配。
+// 所属工作线程与提交方从这里入队，本节点与远端节点的空闲工作线程都可以从这里出队（窃取）。
+class TaskQueue {
+ public:
+  // capacity 向上取整为 2 的幂。
+  explicit TaskQueue(size_t capacity) {
+    size_t size = 2;
+    while (size < capacity) {
+      size <<= 1;
+    }
+    mask_ = size - 1;
+    cells_ = std::make_unique<Cell[]>(size);
+    for (size_t i = 0; i < size; ++i) {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  TaskQueue(const TaskQueue&) = delete;
+  TaskQueue& operator=(const TaskQueue&) = delete;
+
+  // 队列满时返回 false，task 保持不变。
+  bool try_push(Task* task) {
+    size_t pos = tail_.load(std::memory_order_relaxed);
+    for (;;) {
+      Cell& cell = cells_[pos & mask_];
+      size_t seq = cell.sequence.load(std::memory_order_acquire);
+      intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+      if (diff == 0) {
+        if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          cell.task = std::move(*task);
+          cell.sequence.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = tail_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // 队列中的任务数（无锁快照，并发出入队时只是近似值）。
+  size_t size_approx() const {
+    size_t head = head_.load(std::memory_order_relaxed);
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    return tail > head ? tail - head : 0;
+  }
+
+  // 队列空时返回 false。
+  bool try_pop(Task* task) {
+    size_t pos = head_.load(std::memory_order_relaxed);
+    for (;;) {
+      Cell& cell = cells_[pos & mask_];
+      size_t seq = cell.sequence.load(std::memory_order_acquire);
+      intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+      if (diff == 0) {
+        if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          *task = std::move(cell.task);
+          cell.sequence.store(pos + mask_ + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = head_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+ private:
+  struct Cell {
+    std::atomic<size_t> sequence{0};
+    Task task;
+  };
+
+  std::unique_ptr<Cell[]> cells_;
+  size_t mask_ = 0;
+  alignas(64) std::atomic<size_t> tail_{0};
+  alignas(64) std::atomic<size_t> head_{0};
+};
+
+}  // namespace mini_db
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// 热路径分段追踪：以 -DMINI_DB_TRACE=ON 构建时，执行器排队与执行、页锁/表锁等待、缓存未命中读页与同步写回、
+// 日志追加/提交等待/批量 fsync、检查点各自记录一段 [开始, 结束]（TSC 时间戳），写入每线程的环形缓冲，
+// 导出为 Chrome trace / Perfetto 可打开的 JSON。默认构建中埋点宏展开为空，没有任何开销。
+
+#ifdef MINI_DB_TRACE
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+#endif
+
+namespace mini_db {
+
+// 本构建是否编译了追踪埋点。
+#ifdef MINI_DB_TRACE
+constexpr bool kTraceCompiled = true;
+#else
+constexpr bool kTraceCompiled = false;
+#endif
+
+// 每个线程环形缓冲的事件数，写满后覆盖最旧的事件。
+constexpr size_t kTraceRingEvents = 1 << 16;
+
+// 开始/停止记录（未编译追踪时返回 false）。开始时清空已有事件并重新校准时钟。
+bool trace_start(std::string* err);
+void trace_stop();
+// 把各线程缓冲中的事件写成 Chrome trace JSON（traceEvents 数组，时间单位微秒）。
+// 应在停止记录后调用：仍在写入的线程可能覆盖正被导出的旧事件。
+bool trace_export_chrome(const std::string& path, std::string* err);
+
+#ifdef MINI_DB_TRACE
+
+extern std::atomic<bool> g_trace_enabled;
+
+inline bool trace_enabled() {
+  return g_trace_enabled.load(std::memory_order_relaxed);
+}
+
+// 追踪时钟：x86 上为 TSC 计数（导出时按记录期间的墙钟换算），其他平台为单调时钟纳秒。
+inline uint64_t trace_clock() {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                   std::chrono::steady_clock::now().time_since_epoch())
+                                   .count());
+#endif
+}
+
+// 记录一段已结束的区间；name 必须是静态字符串。
+void trace_record(const char* name, uint64_t begin, uint64_t end);
+// 设置当前线程在导出结果中的名字。
+void trace_set_thread_name(const std::string& name);
+
+// 作用域区间：构造时记开始时间，析构时写入事件；构造时未开启记录则什么都不做。
+class TraceSpan {
+ public:
+  explicit TraceSpan(const char* name) : name_(name), begin_(trace_enabled() ? trace_clock() : 0) {}
+  ~TraceSpan() {
+    if (begin_ != 0) {
+      trace_record(name_, begin_, trace_clock());
+    }
+  }
+  TraceSpan(const TraceSpan&) = delete;
+  TraceSpan& operator=(const TraceSpan&) = delete;
+
+ private:
+  const char* name_;
+  uint64_t begin_;
+};
+
+#define MINI_DB_TRACE_CONCAT_INNER(a, b) a##b
+#define MINI_DB_TRACE_CONCAT(a, b) MINI_DB_TRACE_CONCAT_INNER(a, b)
+#define MINI_DB_TRACE_SPAN(name) \
+  ::mini_db::TraceSpan MINI_DB_TRACE_CONCAT(trace_span_, __LINE__)(name)
+#define MINI_DB_TRACE_THREAD_NAME(name) ::mini_db::trace_set_thread_name(name)
+
+#else
+
+#define MINI_DB_TRACE_SPAN(name) \
+  do {                           \
+  } while (0)
+#define MINI_DB_TRACE_THREAD_NAME(name) \
+  do {                                  \
+  } while (0)
+
+#endif
+
+}  // namespace mini_db
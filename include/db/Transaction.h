@@ -0,0 +1,86 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace mini_db {
+
+class TableStorage;
+
+// 事务对一行的暂存写入。
+struct StagedRow {
+  // 事务第一次改写该行之前的已提交记录（本事务插入的行为全零的空行）。
+  std::vector<char> base;
+  // 待提交的记录（有效标记为 0 表示删除）。
+  std::vector<char> image;
+  // 行号由本事务分配（回滚时归还空闲列表）。
+  bool inserted = false;
+  // 提交时该行 TxnRow 日志记录的 LSN，写回数据页时作为页 LSN。
+  uint64_t lsn = 0;
+};
+
+// 事务在单个表上的暂存写入，按行号有序（提交时按页顺序写回）。
+using StagedRows = std::map<uint64_t, StagedRow>;
+
+// 表的行锁：行号 -> 持有的事务号。事务暂存写入时（持表独占锁）加锁，写回数据页或回滚后释放。
+// 冲突时立即失败（NO_WAIT），不会死锁；自动提交的写语句遇到被事务锁住的行同样失败。
+class RowLockTable {
+ public:
+  RowLockTable() = default;
+
+  RowLockTable(const RowLockTable&) = delete;
+  RowLockTable& operator=(const RowLockTable&) = delete;
+
+  // 为事务 txn 加锁（已持有时直接成功）；被其他事务持有时返回 false。
+  bool lock(uint64_t row_id, uint64_t txn);
+  // 释放 txn 持有的行锁。
+  void unlock(uint64_t row_id, uint64_t txn);
+  // 行是否被 txn 以外的事务持有（txn 为 0 表示自动提交的语句）。
+  bool locked_by_other(uint64_t row_id, uint64_t txn) const;
+  // 是否没有任何行锁（无锁检查，为 true 时写者跳过逐行检查）。
+  bool empty() const;
+
+ private:
+  mutable std::mutex mutex_;
+  std::unordered_map<uint64_t, uint64_t> owners_;
+  std::atomic<size_t> count_{0};
+};
+
+// 多语句事务的上下文：BEGIN 之后的写入按表暂存在事务中，不写日志也不修改数据页；
+// COMMIT 时由 Database 为全部暂存行追加日志和一条提交记录，每个涉及的分区只等待一次落盘，
+// 然后写回数据页并释放行锁。只能在创建它的会话中顺序使用，析构时未提交的写入自动回滚。
+class Transaction {
+ public:
+  explicit Transaction(uint64_t id);
+  ~Transaction();
+
+  Transaction(const Transaction&) = delete;
+  Transaction& operator=(const Transaction&) = delete;
+
+  // 事务号（日志中的 TxnRow / Commit 记录与行锁使用）。
+  uint64_t id() const;
+  // 返回事务在表上的暂存写入（不存在时创建）。
+  StagedRows* staged(TableStorage* table);
+  // 返回事务在表上的暂存写入，没有时返回 nullptr。
+  const StagedRows* find_staged(const TableStorage* table) const;
+  // 事务写过的表及其暂存写入（按首次写入顺序）。
+  std::vector<std::pair<TableStorage*, StagedRows>>& tables();
+  // 暂存的行数（同一行多次改写只计一次）。
+  size_t staged_rows() const;
+  // 丢弃全部暂存写入并释放行锁。
+  void rollback();
+  // 提交完成后清空（行锁已在写回数据页时释放）。
+  void clear();
+
+ private:
+  uint64_t id_ = 0;
+  std::vector<std::pair<TableStorage*, StagedRows>> tables_;
+};
+
+}  // namespace mini_db
@@ -1,7 +1,9 @@
 #pragma once
 
 #include <cstdint>
+#include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace mini_db {
@@ -42,11 +44,54 @@ struct Column {
   uint32_t length = 0;
 };
 
-// WHERE 条件，只支持单列等值匹配。
+// 索引结构：内存哈希（等值查找）或磁盘 B+ 树（等值 + 范围查找）。
+enum class IndexKind {
+  Hash,
+  BTree,
+};
+
+// 表数据页布局：行式（记录按行连续存放，可跨页）、PAX（每页按列分成 minipage，记录不跨页），
+// 或槽页（TEXT 按实际长度存放，长值放到溢出页）。
+enum class TableLayout {
+  Row,
+  Pax,
+  Slotted,
+};
+
+// 建表选项：数据页布局，以及是否按页压缩表数据文件（CREATE TABLE ... COMPRESSED）。
+struct TableOptions {
+  TableLayout layout = TableLayout::Row;
+  bool compressed = false;
+};
+
+// 索引定义：索引名、被索引的列、索引结构，以及是否要求键唯一（PRIMARY KEY / UNIQUE）。
+struct IndexDef {
+  std::string name;
+  std::string column;
+  bool unique = false;
+  IndexKind kind = IndexKind::Hash;
+};
+
+// WHERE 比较运算符。
+enum class CompareOp {
+  Eq,
+  Ne,
+  Lt,
+  Le,
+  Gt,
+  Ge,
+  // BETWEEN value AND upper（闭区间）。
+  Between,
+};
+
+// WHERE 条件：单列与常量比较。
 struct Condition {
   bool has = false;
   std::string column;
+  CompareOp op = CompareOp::Eq;
   Value value;
+  // BETWEEN 的上界。
+  Value upper;
 };
 
 // UPDATE 语句的 SET 子句。
@@ -58,15 +103,49 @@ struct SetClause {
 // SQL 语句类型枚举。
 enum class StatementType {
   CreateTable,
+  CreateIndex,
   DropTable,
+  DropIndex,
   AlterTableAdd,
   Insert,
+  // COPY t FROM 'file'：从文本文件批量装载。
+  Copy,
   Select,
   Update,
   Delete,
+  // 事务控制：BEGIN / COMMIT / ROLLBACK。
+  Begin,
+  Commit,
+  Rollback,
+  // 预备语句：PREPARE name AS ... / EXECUTE name (...) / DEALLOCATE name。
+  Prepare,
+  Execute,
+  Deallocate,
+  // SHOW STATS：输出内部统计（见 Database::stats_text）。
+  ShowStats,
   Unknown,
 };
 
+// 预备语句中 ? 占位符所在的位置。
+enum class ParamTarget {
+  // INSERT 第 row 组 VALUES 的第 index 个值。
+  InsertValue,
+  // 第 index 个 SET 子句的值。
+  SetValue,
+  // WHERE 的比较值 / BETWEEN 上界。
+  WhereValue,
+  WhereUpper,
+};
+
+struct ParamSlot {
+  ParamTarget target = ParamTarget::InsertValue;
+  size_t row = 0;
+  size_t index = 0;
+};
+
+// SELECT 不带 LIMIT 时的行数上限。
+constexpr uint64_t kNoLimit = ~static_cast<uint64_t>(0);
+
 // 解析后的 SQL 语句结构，供执行器使用。
 struct Statement {
   StatementType type = StatementType::Unknown;
@@ -74,14 +153,46 @@ struct Statement {
   std::string table;
   // CREATE TABLE 使用的列定义。
   std::vector<Column> columns;
-  // INSERT 使用的值列表。
-  std::vector<Value> values;
+  // CREATE TABLE 的表选项（USING ROW|PAX|SLOTTED、COMPRESSED）。
+  TableOptions table_options;
+  // INSERT 使用的值列表（VALUES (...), (...) 每组一行）。
+  std::vector<std::vector<Value>> rows;
+  // COPY 的源文件路径。
+  std::string path;
   // UPDATE 使用的 set 子句集合。
   std::vector<SetClause> set_clauses;
   // WHERE 条件（可选）。
   Condition where;
+  // SELECT 的 LIMIT（kNoLimit 表示不限）。
+  uint64_t limit = kNoLimit;
   // ALTER TABLE ADD COLUMN 使用的列定义。
   Column alter_column;
+  // CREATE/DROP INDEX 的索引定义，以及 CREATE TABLE 中 PRIMARY KEY 列生成的索引。
+  std::vector<IndexDef> indexes;
+  // PREPARE / EXECUTE / DEALLOCATE 的预备语句名。
+  std::string name;
+  // PREPARE 的语句体（INSERT / SELECT / UPDATE / DELETE，可含 ? 占位符）。
+  std::shared_ptr<const Statement> body;
+  // 语句体中 ? 占位符的位置，按出现顺序对应 EXECUTE 的参数。
+  std::vector<ParamSlot> params;
+  // EXECUTE 的参数值。
+  std::vector<Value> args;
+};
+
+// 预备语句绑定到表结构后的 DML 参数（见 Executor::prepare）：列下标与按列类型归一化后的值在 PREPARE 时确定，
+// EXECUTE 填入参数后直接交给存储层，不再按列名查找列、也不再转换类型。
+struct BoundDml {
+  // 绑定时的表结构版本（TableStorage::schema_epoch），存储层在表锁内核对，表结构已变化时不执行。
+  uint64_t schema_epoch = 0;
+  // INSERT 的各行（整行已归一化）。
+  std::vector<std::vector<Value>> rows;
+  // UPDATE 的 SET：列下标与归一化后的值。
+  std::vector<std::pair<size_t, Value>> sets;
+  // WHERE：where.value / where.upper 已归一化，where_idx 为列下标（无 WHERE 时为 -1），
+  // 等值条件附带预编码的定长键。
+  Condition where;
+  int where_idx = -1;
+  std::string where_key;
 };
 
 }  // namespace mini_db
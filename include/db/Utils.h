@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -24,4 +26,7 @@ bool hex_decode(const std::string& hex, std::vector<char>* out);
 // 判断字符串是否为整数（允许前导 + / -）。
 bool is_number(const std::string& input);
 
+// 计算 CRC32 校验值（IEEE 802.3 多项式），seed 用于分段累加计算。
+uint32_t crc32(const char* data, size_t size, uint32_t seed = 0);
+
 }  // namespace mini_db
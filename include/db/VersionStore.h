@@ -0,0 +1,128 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace mini_db {
+
+// 表的多版本存储：记录原地更新，被覆盖的旧记录映像按时间戳保存在内存中，供快照读取。
+// 时间戳按写语句分配；快照时间戳 S 之前的写语句都已完成，S 之后开始或仍在进行的写语句对快照不可见。
+// 读者先读当前记录，再查找是否有时间戳晚于快照的旧版本：写者在覆盖记录之前保存旧映像，
+// 因此读者读到的只要含有快照之后的写入，随后一定能查到对应的旧版本。
+// 没有快照时写者不保存旧版本；开始快照时先等待这些写者结束，之后开始的写者都会保存。
+// 快照时间戳取最早的进行中写语句之前，晚于它的写语句可能已经结束，所以只要还有保存旧版本的写语句
+// 在进行，新开始的写语句也保存：时间戳晚于快照的写语句都有旧版本，快照总是写语句的一个完整前缀。
+// 旧版本不落盘（重启后没有活跃快照），不再被任何快照需要时回收。
+class VersionStore {
+ public:
+  VersionStore() = default;
+
+  VersionStore(const VersionStore&) = delete;
+  VersionStore& operator=(const VersionStore&) = delete;
+
+  // 写语句开始：返回时间戳，*keep 表示本语句覆盖记录前是否需要保存旧版本。
+  uint64_t begin_write(bool* keep);
+  // 写语句结束（必须与 begin_write 配对）。
+  void end_write(uint64_t ts, bool keep);
+  // 保存时间戳为 ts 的写语句覆盖 row_id 之前的记录映像（page_id 为记录起始页）。
+  // 同一行的写入由调用方的页锁串行化，旧版本按写入顺序追加。
+  void save(size_t page_id, uint64_t row_id, uint64_t ts, const std::vector<char>& record);
+
+  // 开始快照：等待不保存旧版本的写语句结束，返回快照时间戳。
+  uint64_t begin_snapshot();
+  // 结束快照并回收不再需要的旧版本。
+  void end_snapshot(uint64_t snapshot);
+
+  // 是否存在旧版本（无锁检查，为 false 时读者可以跳过查找）。
+  bool empty() const;
+  // 若 row_id 在快照之后被覆盖过，把快照时的记录映像复制到 out 并返回 true。
+  bool lookup(size_t page_id, uint64_t row_id, uint64_t snapshot, std::vector<char>* out) const;
+  // 起始页为 page_id 且在快照之后被覆盖过的行及其快照时映像，按行号升序输出。
+  bool collect(size_t page_id, uint64_t snapshot,
+               std::vector<std::pair<uint64_t, std::vector<char>>>* out) const;
+  // 所有在快照之后被覆盖过的行号（升序）：索引按当前键查找，需要补上旧键命中的行。
+  std::vector<uint64_t> changed_rows(uint64_t snapshot) const;
+  // 当前保存的旧版本数。
+  size_t version_count() const;
+  // 重启、重建表文件等没有并发读写时丢弃全部旧版本。
+  void clear();
+
+ private:
+  struct Version {
+    uint64_t row_id = 0;
+    uint64_t ts = 0;
+    std::vector<char> record;
+  };
+  // 按起始页分条：同页行的旧版本放在一起，按页扫描时每页只查一次。
+  struct alignas(64) Stripe {
+    mutable std::mutex mutex;
+    std::unordered_map<size_t, std::vector<Version>> pages;
+  };
+  static constexpr size_t kStripes = 64;
+
+  // 调用方持有 mutex_：快照可见的最大时间戳（最早的进行中写语句之前）。
+  uint64_t visible_locked() const;
+  // 回收时间戳不超过 horizon 的旧版本（快照只需要时间戳晚于自身的版本）。
+  void prune(uint64_t horizon);
+  const Stripe& stripe_for(size_t page_id) const;
+  Stripe& stripe_for(size_t page_id);
+
+  mutable std::mutex mutex_;
+  std::condition_variable drained_;
+  uint64_t last_ts_ = 0;
+  // 进行中的写语句时间戳。
+  std::set<uint64_t> writers_;
+  // 进行中且不保存 / 保存旧版本的写语句数。
+  size_t plain_writers_ = 0;
+  size_t keep_writers_ = 0;
+  // 等待开始的快照数：期间开始的写语句都保存旧版本，快照不会被后来的写者饿死。
+  size_t pending_snapshots_ = 0;
+  std::multiset<uint64_t> snapshots_;
+  std::atomic<size_t> versions_{0};
+  Stripe stripes_[kStripes];
+};
+
+// 写语句的时间戳登记（RAII）：构造时 begin_write，finish 或析构时 end_write。
+class VersionWrite {
+ public:
+  explicit VersionWrite(VersionStore* store);
+  ~VersionWrite();
+
+  VersionWrite(const VersionWrite&) = delete;
+  VersionWrite& operator=(const VersionWrite&) = delete;
+
+  // 覆盖记录前调用：需要时保存旧映像。
+  void save(size_t page_id, uint64_t row_id, const std::vector<char>& record);
+  // 提前结束（写入已全部完成，之后只等待日志落盘）。
+  void finish();
+
+ private:
+  VersionStore* store_ = nullptr;
+  uint64_t ts_ = 0;
+  bool keep_ = false;
+};
+
+// 快照登记（RAII）：持有期间快照需要的旧版本不会被回收。
+class VersionSnapshot {
+ public:
+  explicit VersionSnapshot(VersionStore* store);
+  ~VersionSnapshot();
+
+  VersionSnapshot(const VersionSnapshot&) = delete;
+  VersionSnapshot& operator=(const VersionSnapshot&) = delete;
+
+  uint64_t ts() const;
+
+ private:
+  VersionStore* store_ = nullptr;
+  uint64_t ts_ = 0;
+};
+
+}  // namespace mini_db
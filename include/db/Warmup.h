@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace mini_db {
+
+// 缓冲池预热配置：关闭时把各表数据文件缓存中的页号写入 <数据目录>/warmup.dat，
+// 下次打开后由每个节点一个的后台线程按页号批量读回，重启后不必从冷缓存开始。
+struct WarmupOptions {
+  // 关闭时保存预热列表、打开时装入。
+  bool enabled = true;
+  // 每次检查点也保存一次（进程被杀死时仍有较新的列表）。
+  bool save_on_checkpoint = false;
+  // open 等待预热完成后再返回（默认在后台进行，不推迟打开）。
+  bool wait = false;
+};
+
+// 预热列表中的一项：某个表在某个缓存分片中的页号（升序）。
+struct WarmupEntry {
+  std::string table;
+  uint32_t shard = 0;
+  std::vector<size_t> pages;
+};
+
+// 写出预热列表（先写临时文件再改名替换）。
+bool save_warmup_list(const std::string& path, const std::vector<WarmupEntry>& entries,
+                      std::string* err);
+// 读取预热列表；文件不存在时输出空列表并返回 true，格式或校验不符时返回 false。
+bool load_warmup_list(const std::string& path, std::vector<WarmupEntry>* entries,
+                      std::string* err);
+
+}  // namespace mini_db
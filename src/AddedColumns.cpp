@@ -0,0 +1,111 @@
+#include "db/AddedColumns.h"
+
+#include <algorithm>
+
+namespace mini_db {
+
+AddedColumns::AddedColumns(const std::string& path, const Schema& schema, size_t page_size,
+                           size_t cache_pages, const CacheOptions& cache, LogManager* log)
+    : path_(path),
+      page_size_(page_size),
+      cache_pages_(cache_pages),
+      cache_(cache),
+      log_(log),
+      stored_size_(schema.column_offset(schema.stored_columns())) {
+  add(schema);
+}
+
+void AddedColumns::add(const Schema& schema) {
+  LogManager* log_manager = log_;
+  for (size_t col = schema.stored_columns() + columns_.size(); col < schema.columns().size();
+       ++col) {
+    Column column;
+    column.offset = schema.column_offset(col);
+    column.width = schema.column_width(col);
+    column.file = std::make_unique<PagedFile>(path_ + ".col" + std::to_string(col), page_size_,
+                                              cache_pages_, 1, cache_);
+    if (log_manager) {
+      // 页 LSN 为写入序号而不是分区内 LSN：写出前刷全部分区。
+      column.file->set_wal([log_manager](int) {
+        WalGate gate;
+        gate.flush_to = [log_manager](uint64_t, std::string* err) {
+          return log_manager->flush(err);
+        };
+        return gate;
+      });
+    }
+    columns_.push_back(std::move(column));
+  }
+}
+
+bool AddedColumns::map_read_only(std::string* err) {
+  for (auto& column : columns_) {
+    if (!column.file->map_read_only(false, err)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+size_t AddedColumns::stored_size() const {
+  return stored_size_;
+}
+
+bool AddedColumns::read(uint64_t row_id, char* record, PageAccess access, std::string* err) {
+  for (auto& column : columns_) {
+    if (!column.file->read_into(static_cast<size_t>(row_id) * column.width, column.width,
+                                record + column.offset, access, err)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool AddedColumns::write(uint64_t first_row, const char* data, size_t stride, size_t count,
+                         bool logged, std::string* err) {
+  uint64_t lsn = logged ? write_seq_.fetch_add(1) + 1 : 0;
+  std::vector<char> values;
+  for (auto& column : columns_) {
+    // 连续的行在列文件中同样连续，每列一次写入。
+    values.resize(count * column.width);
+    for (size_t i = 0; i < count; ++i) {
+      std::copy(data + i * stride + column.offset, data + i * stride + column.offset + column.width,
+                values.begin() + static_cast<std::ptrdiff_t>(i * column.width));
+    }
+    if (!column.file->write_from(static_cast<size_t>(first_row) * column.width, values.data(),
+                                 values.size(), lsn, err)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void AddedColumns::flush(std::string* err) {
+  for (auto& column : columns_) {
+    column.file->flush(err);
+    if (err && !err->empty()) {
+      return;
+    }
+  }
+}
+
+std::vector<std::string> AddedColumns::paths() const {
+  std::vector<std::string> files;
+  for (const auto& column : columns_) {
+    files.push_back(column.file->path());
+    if (cache_.io.compress) {
+      files.push_back(column.file->path() + ".pmap");
+    }
+  }
+  return files;
+}
+
+IoStats AddedColumns::io_stats() const {
+  IoStats stats;
+  for (const auto& column : columns_) {
+    stats.add(column.file->io_stats());
+  }
+  return stats;
+}
+
+}  // namespace mini_db
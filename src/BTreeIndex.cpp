@@ -0,0 +1,487 @@
+#include "db/BTreeIndex.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace mini_db {
+
+namespace {
+
+constexpr char kMetaMagic[4] = {'B', 'P', 'T', '1'};
+constexpr size_t kMetaSize = 29;
+constexpr size_t kNodeHeaderSize = 16;
+constexpr uint8_t kLeafNode = 1;
+constexpr uint8_t kInternalNode = 2;
+// 组合键中行号所占字节数。
+constexpr size_t kRowBytes = 8;
+
+void put_uint(char* out, uint64_t value, size_t bytes) {
+  for (size_t i = 0; i < bytes; ++i) {
+    out[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+  }
+}
+
+uint64_t get_uint(const char* data, size_t bytes) {
+  uint64_t value = 0;
+  for (size_t i = 0; i < bytes; ++i) {
+    value |= static_cast<uint64_t>(static_cast<unsigned char>(data[i])) << (8 * i);
+  }
+  return value;
+}
+
+// 大端写入，使字节序比较与数值比较一致。
+void put_big_endian(std::string* out, uint64_t value, size_t bytes) {
+  for (size_t i = bytes; i > 0; --i) {
+    out->push_back(static_cast<char>((value >> (8 * (i - 1))) & 0xFF));
+  }
+}
+
+// 按无符号字节序比较（std::string::compare 在 char 为有符号时不保序）。
+int compare_bytes(const std::string& a, const std::string& b) {
+  size_t n = std::min(a.size(), b.size());
+  int cmp = n ? std::memcmp(a.data(), b.data(), n) : 0;
+  if (cmp != 0) {
+    return cmp;
+  }
+  return a.size() < b.size() ? -1 : (a.size() > b.size() ? 1 : 0);
+}
+
+bool bytes_less(const std::string& a, const std::string& b) {
+  return compare_bytes(a, b) < 0;
+}
+
+}  // namespace
+
+BTreeIndex::BTreeIndex(const IndexDef& def, const std::string& path, size_t column_index,
+                       size_t key_offset, size_t key_size, ColumnType type, size_t page_size,
+                       size_t cache_pages, int numa_nodes, const CacheOptions& cache)
+    : Index(def, path, column_index, key_offset, key_size),
+      type_(type),
+      page_size_(page_size),
+      leaf_capacity_((page_size - kNodeHeaderSize) / (key_size + kRowBytes)),
+      internal_capacity_((page_size - kNodeHeaderSize) / (key_size + kRowBytes + 8)),
+      file_(path, page_size, cache_pages, numa_nodes, cache) {}
+
+bool BTreeIndex::fits(size_t key_size, size_t page_size) {
+  return page_size > kNodeHeaderSize + kMetaSize &&
+         (page_size - kNodeHeaderSize) / (key_size + kRowBytes + 8) >= 4;
+}
+
+bool BTreeIndex::insert(const std::string& key, uint64_t row_id, bool enforce_unique,
+                        std::string* err) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::string ordered = ordered_key(key);
+  if (def_.unique && enforce_unique) {
+    // 唯一索引：同一键下若已有其他行号则冲突。
+    std::vector<uint64_t> rows;
+    if (!scan_locked(entry_key(ordered, 0), &ordered, true, &ordered, true, &rows, err)) {
+      return false;
+    }
+    for (uint64_t existing : rows) {
+      if (existing != row_id) {
+        return duplicate_key(err);
+      }
+    }
+    if (!rows.empty()) {
+      return true;
+    }
+  }
+  return begin_modify_locked(err) && insert_locked(entry_key(ordered, row_id), err);
+}
+
+bool BTreeIndex::erase(const std::string& key, uint64_t row_id, std::string* err) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::string entry = entry_key(ordered_key(key), row_id);
+  std::vector<uint64_t> path;
+  uint64_t leaf_id = 0;
+  Node leaf;
+  if (!find_leaf(entry, &path, &leaf_id, &leaf, err)) {
+    return false;
+  }
+  auto it = std::lower_bound(leaf.keys.begin(), leaf.keys.end(), entry, bytes_less);
+  if (it == leaf.keys.end() || *it != entry) {
+    return true;
+  }
+  if (!begin_modify_locked(err)) {
+    return false;
+  }
+  leaf.keys.erase(it);
+  return write_node(leaf_id, leaf, err);
+}
+
+bool BTreeIndex::lookup(const std::string& key, std::vector<uint64_t>* rows, std::string* err) {
+  return range(&key, true, &key, true, rows, err);
+}
+
+bool BTreeIndex::ordered() const {
+  return true;
+}
+
+bool BTreeIndex::range(const std::string* low, bool low_inclusive, const std::string* high,
+                       bool high_inclusive, std::vector<uint64_t>* rows, std::string* err) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  rows->clear();
+  std::string low_key = low ? ordered_key(*low) : std::string();
+  std::string high_key = high ? ordered_key(*high) : std::string();
+  // 无下界时从最左叶子开始（空串小于任何组合键）。
+  std::string start = low ? entry_key(low_key, 0) : std::string();
+  return scan_locked(start, low ? &low_key : nullptr, low_inclusive, high ? &high_key : nullptr,
+                     high_inclusive, rows, err);
+}
+
+bool BTreeIndex::erase_rows(const std::unordered_map<uint64_t, bool>& rows, std::string* err) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!begin_modify_locked(err)) {
+    return false;
+  }
+  // 顺着叶子链表过滤条目，叶子内删除不影响上层分隔键。
+  std::vector<uint64_t> path;
+  uint64_t leaf_id = 0;
+  Node leaf;
+  if (!find_leaf(std::string(), &path, &leaf_id, &leaf, err)) {
+    return false;
+  }
+  for (;;) {
+    size_t before = leaf.keys.size();
+    leaf.keys.erase(std::remove_if(leaf.keys.begin(), leaf.keys.end(),
+                                   [this, &rows](const std::string& entry) {
+                                     return rows.find(entry_row(entry)) != rows.end();
+                                   }),
+                    leaf.keys.end());
+    if (leaf.keys.size() != before && !write_node(leaf_id, leaf, err)) {
+      return false;
+    }
+    if (leaf.next == 0) {
+      return true;
+    }
+    leaf_id = leaf.next;
+    if (!read_node(leaf_id, &leaf, err)) {
+      return false;
+    }
+  }
+}
+
+bool BTreeIndex::clear(std::string* err) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return reset_locked(err);
+}
+
+bool BTreeIndex::dirty() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return !saved_;
+}
+
+bool BTreeIndex::save(std::string* err) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (saved_) {
+    return true;
+  }
+  // 先写出所有节点页，再写已保存标记。
+  std::string flush_err;
+  file_.flush(&flush_err);
+  if (!flush_err.empty()) {
+    if (err) {
+      *err = flush_err;
+    }
+    return false;
+  }
+  saved_ = true;
+  if (!write_meta(err)) {
+    saved_ = false;
+    return false;
+  }
+  file_.flush(&flush_err);
+  if (!flush_err.empty()) {
+    if (err) {
+      *err = flush_err;
+    }
+    return false;
+  }
+  return true;
+}
+
+bool BTreeIndex::load() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (file_.file_size() < page_size_) {
+    return false;
+  }
+  DataItem meta;
+  if (!file_.read_item(0, kMetaSize, &meta, nullptr)) {
+    return false;
+  }
+  const char* data = meta.data.data();
+  if (std::memcmp(data, kMetaMagic, sizeof(kMetaMagic)) != 0 ||
+      get_uint(data + 4, 4) != key_size_ || data[28] != 1) {
+    return false;
+  }
+  root_ = get_uint(data + 8, 8);
+  page_count_ = get_uint(data + 16, 8);
+  if (root_ == 0 || root_ >= page_count_) {
+    return false;
+  }
+  saved_ = true;
+  return true;
+}
+
+std::string BTreeIndex::ordered_key(const std::string& key) const {
+  if (type_ != ColumnType::Int) {
+    // 定长文本以 0 填充，字节序即字典序。
+    return key;
+  }
+  // INT 列编码为小端 int32：翻转符号位并转为大端，使负数排在正数之前。
+  uint32_t value = static_cast<uint32_t>(get_uint(key.data(), 4)) ^ 0x80000000u;
+  std::string out;
+  put_big_endian(&out, value, 4);
+  return out;
+}
+
+std::string BTreeIndex::entry_key(const std::string& key, uint64_t row_id) const {
+  std::string entry = key;
+  put_big_endian(&entry, row_id, kRowBytes);
+  return entry;
+}
+
+uint64_t BTreeIndex::entry_row(const std::string& entry) const {
+  uint64_t row_id = 0;
+  for (size_t i = key_size_; i < key_size_ + kRowBytes; ++i) {
+    row_id = (row_id << 8) | static_cast<unsigned char>(entry[i]);
+  }
+  return row_id;
+}
+
+bool BTreeIndex::read_node(uint64_t page_id, Node* node, std::string* err) {
+  // 节点页大小与文件页大小一致：钉住页后原地解码，不复制整页。
+  PageGuard page = file_.pin_page(static_cast<size_t>(page_id), PageGuard::Mode::Read,
+                                  PageAccess::Normal, err);
+  if (!page) {
+    return false;
+  }
+  const char* data = page.data();
+  uint8_t type = static_cast<uint8_t>(data[0]);
+  size_t count = static_cast<size_t>(get_uint(data + 2, 2));
+  bool leaf = type == kLeafNode;
+  if ((type != kLeafNode && type != kInternalNode) ||
+      count > (leaf ? leaf_capacity_ : internal_capacity_) || (!leaf && count == 0)) {
+    if (err) {
+      *err = "corrupt btree page " + std::to_string(page_id) + " in " + path_;
+    }
+    return false;
+  }
+  node->leaf = leaf;
+  node->next = get_uint(data + 8, 8);
+  node->keys.clear();
+  node->children.clear();
+  size_t entry_size = key_size_ + kRowBytes;
+  size_t stride = leaf ? entry_size : entry_size + 8;
+  if (!leaf) {
+    node->children.push_back(node->next);
+  }
+  for (size_t i = 0; i < count; ++i) {
+    const char* entry = data + kNodeHeaderSize + i * stride;
+    node->keys.emplace_back(entry, entry_size);
+    if (!leaf) {
+      node->children.push_back(get_uint(entry + entry_size, 8));
+    }
+  }
+  return true;
+}
+
+bool BTreeIndex::write_node(uint64_t page_id, const Node& node, std::string* err) {
+  // 持写闩直接编码到缓存页中。
+  PageGuard page = file_.pin_page(static_cast<size_t>(page_id), PageGuard::Mode::Write,
+                                  PageAccess::Normal, err);
+  if (!page) {
+    return false;
+  }
+  char* data = page.mutable_data();
+  std::memset(data, 0, page_size_);
+  data[0] = static_cast<char>(node.leaf ? kLeafNode : kInternalNode);
+  put_uint(data + 2, node.keys.size(), 2);
+  put_uint(data + 8, node.leaf ? node.next : node.children.front(), 8);
+  size_t entry_size = key_size_ + kRowBytes;
+  size_t stride = node.leaf ? entry_size : entry_size + 8;
+  for (size_t i = 0; i < node.keys.size(); ++i) {
+    char* entry = data + kNodeHeaderSize + i * stride;
+    std::memcpy(entry, node.keys[i].data(), entry_size);
+    if (!node.leaf) {
+      put_uint(entry + entry_size, node.children[i + 1], 8);
+    }
+  }
+  page.mark_dirty();
+  return true;
+}
+
+bool BTreeIndex::write_meta(std::string* err) {
+  std::vector<char> meta(kMetaSize, 0);
+  std::memcpy(meta.data(), kMetaMagic, sizeof(kMetaMagic));
+  put_uint(meta.data() + 4, key_size_, 4);
+  put_uint(meta.data() + 8, root_, 8);
+  put_uint(meta.data() + 16, page_count_, 8);
+  meta[28] = saved_ ? 1 : 0;
+  return file_.write_item(0, meta, err);
+}
+
+bool BTreeIndex::begin_modify_locked(std::string* err) {
+  if (!saved_) {
+    return true;
+  }
+  // 此时缓存中只有元数据页是脏的，刷盘代价很小。
+  saved_ = false;
+  if (!write_meta(err)) {
+    return false;
+  }
+  std::string flush_err;
+  file_.flush(&flush_err);
+  if (!flush_err.empty()) {
+    if (err) {
+      *err = flush_err;
+    }
+    return false;
+  }
+  return true;
+}
+
+bool BTreeIndex::find_leaf(const std::string& entry, std::vector<uint64_t>* path,
+                           uint64_t* leaf_id, Node* leaf, std::string* err) {
+  uint64_t page_id = root_;
+  if (!read_node(page_id, leaf, err)) {
+    return false;
+  }
+  while (!leaf->leaf) {
+    // 子节点 i 覆盖 [keys[i-1], keys[i])。
+    path->push_back(page_id);
+    size_t idx = static_cast<size_t>(
+        std::upper_bound(leaf->keys.begin(), leaf->keys.end(), entry, bytes_less) -
+        leaf->keys.begin());
+    page_id = leaf->children[idx];
+    if (!read_node(page_id, leaf, err)) {
+      return false;
+    }
+  }
+  *leaf_id = page_id;
+  return true;
+}
+
+bool BTreeIndex::insert_locked(const std::string& entry, std::string* err) {
+  std::vector<uint64_t> path;
+  uint64_t leaf_id = 0;
+  Node leaf;
+  if (!find_leaf(entry, &path, &leaf_id, &leaf, err)) {
+    return false;
+  }
+  auto it = std::lower_bound(leaf.keys.begin(), leaf.keys.end(), entry, bytes_less);
+  if (it != leaf.keys.end() && *it == entry) {
+    return true;
+  }
+  leaf.keys.insert(it, entry);
+  if (leaf.keys.size() <= leaf_capacity_) {
+    return write_node(leaf_id, leaf, err);
+  }
+
+  // 叶子分裂：右半部分移到新页，右页首键作为分隔键上推。
+  Node right;
+  size_t mid = leaf.keys.size() / 2;
+  right.keys.assign(leaf.keys.begin() + static_cast<std::ptrdiff_t>(mid), leaf.keys.end());
+  leaf.keys.resize(mid);
+  uint64_t right_id = page_count_++;
+  right.next = leaf.next;
+  leaf.next = right_id;
+  if (!write_node(right_id, right, err) || !write_node(leaf_id, leaf, err)) {
+    return false;
+  }
+  std::string separator = right.keys.front();
+  uint64_t child = right_id;
+  while (!path.empty()) {
+    uint64_t parent_id = path.back();
+    path.pop_back();
+    Node parent;
+    if (!read_node(parent_id, &parent, err)) {
+      return false;
+    }
+    size_t idx = static_cast<size_t>(
+        std::upper_bound(parent.keys.begin(), parent.keys.end(), separator, bytes_less) -
+        parent.keys.begin());
+    parent.keys.insert(parent.keys.begin() + static_cast<std::ptrdiff_t>(idx), separator);
+    parent.children.insert(parent.children.begin() + static_cast<std::ptrdiff_t>(idx) + 1, child);
+    if (parent.keys.size() <= internal_capacity_) {
+      return write_node(parent_id, parent, err) && write_meta(err);
+    }
+    // 内部节点分裂：中间键上推，不保留在任一侧。
+    Node sibling;
+    sibling.leaf = false;
+    size_t split = parent.keys.size() / 2;
+    std::string up = parent.keys[split];
+    sibling.keys.assign(parent.keys.begin() + static_cast<std::ptrdiff_t>(split) + 1,
+                        parent.keys.end());
+    sibling.children.assign(parent.children.begin() + static_cast<std::ptrdiff_t>(split) + 1,
+                            parent.children.end());
+    parent.keys.resize(split);
+    parent.children.resize(split + 1);
+    uint64_t sibling_id = page_count_++;
+    if (!write_node(sibling_id, sibling, err) || !write_node(parent_id, parent, err)) {
+      return false;
+    }
+    separator = up;
+    child = sibling_id;
+  }
+  // 根分裂：树高加一。
+  Node root;
+  root.leaf = false;
+  root.keys.push_back(separator);
+  root.children = {root_, child};
+  uint64_t root_id = page_count_++;
+  if (!write_node(root_id, root, err)) {
+    return false;
+  }
+  root_ = root_id;
+  return write_meta(err);
+}
+
+bool BTreeIndex::scan_locked(const std::string& start, const std::string* low,
+                             bool low_inclusive, const std::string* high, bool high_inclusive,
+                             std::vector<uint64_t>* rows, std::string* err) {
+  std::vector<uint64_t> path;
+  uint64_t leaf_id = 0;
+  Node leaf;
+  if (!find_leaf(start, &path, &leaf_id, &leaf, err)) {
+    return false;
+  }
+  size_t pos = static_cast<size_t>(
+      std::lower_bound(leaf.keys.begin(), leaf.keys.end(), start, bytes_less) - leaf.keys.begin());
+  for (;;) {
+    for (; pos < leaf.keys.size(); ++pos) {
+      std::string key = leaf.keys[pos].substr(0, key_size_);
+      if (low && !low_inclusive && key == *low) {
+        continue;
+      }
+      if (high) {
+        int cmp = compare_bytes(key, *high);
+        if (cmp > 0 || (cmp == 0 && !high_inclusive)) {
+          return true;
+        }
+      }
+      rows->push_back(entry_row(leaf.keys[pos]));
+    }
+    if (leaf.next == 0) {
+      return true;
+    }
+    leaf_id = leaf.next;
+    if (!read_node(leaf_id, &leaf, err)) {
+      return false;
+    }
+    pos = 0;
+  }
+}
+
+bool BTreeIndex::reset_locked(std::string* err) {
+  // 重置为单个空叶子；旧页留作垃圾，之后按 page_count_ 覆盖复用。
+  if (!begin_modify_locked(err)) {
+    return false;
+  }
+  root_ = 1;
+  page_count_ = 2;
+  Node leaf;
+  return write_node(root_, leaf, err) && write_meta(err);
+}
+
+}  // namespace mini_db
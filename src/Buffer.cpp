@@ -1,5 +1,12 @@
 #include "db/Buffer.h"
 
+#include "db/NumaMetrics.h"
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
 #include <cstring>
 
 namespace mini_db {
@@ -59,7 +66,7 @@ int Buffer::node() const {
 }
 
 // 用来重新分配一块缓冲区，并把内容清空，同时维护 Buffer 对象内部的状态字段（指针，大小，NUMA 节点，分配器）
-void Buffer::reset(size_t size, int node, NumaAllocator* allocator) {
+void Buffer::reset(size_t size, int node, NumaAllocator* allocator, bool zero) {
   // 重新分配缓冲区并清零。
   // size 希望分配的新缓冲区大小（字节数）
   // node NUMA 节点编号（告诉分配器尽量在该 numa node 上分配内存）
@@ -84,7 +91,13 @@ void Buffer::reset(size_t size, int node, NumaAllocator* allocator) {
     return;
   }
   // 把新分配的缓冲区全部写成 0
-  std::memset(data_, 0, size_);
+  if (zero) {
+    std::memset(data_, 0, size_);
+  }
+  if (numa_metrics()) {
+    // 清零后物理页已分配，可核对首页实际所在节点；未清零的缓冲区只计请求量。
+    record_numa_allocation(node_, zero ? memory_node_of(data_) : -1, size_);
+  }
 }
 
 void Buffer::zero() {
@@ -93,6 +106,22 @@ void Buffer::zero() {
   }
 }
 
+void Buffer::discard(size_t offset, size_t size) {
+  if (!data_ || offset >= size_) {
+    return;
+  }
+  size = std::min(size, size_ - offset);
+  // madvise 只接受系统页对齐的范围：向内取整，不足一页的部分保持不变。
+  uintptr_t os_page = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+  uintptr_t begin = reinterpret_cast<uintptr_t>(data_ + offset);
+  uintptr_t end = begin + size;
+  begin = (begin + os_page - 1) & ~(os_page - 1);
+  end &= ~(os_page - 1);
+  if (begin < end) {
+    madvise(reinterpret_cast<void*>(begin), end - begin, MADV_DONTNEED);
+  }
+}
+
 void Buffer::release() {
   if (data_ && allocator_) {
     allocator_->deallocate(data_, size_);
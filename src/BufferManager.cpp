@@ -0,0 +1,174 @@
+#include "db/BufferManager.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace mini_db {
+
+BufferManager::BufferManager(size_t total_pages, const BufferBudgetOptions& options)
+    : total_pages_(total_pages > 0 ? total_pages : 1), options_(options) {}
+
+BufferManager::~BufferManager() {
+  stop();
+}
+
+void BufferManager::start() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (running_ || options_.interval_ms == 0) {
+    return;
+  }
+  stop_ = false;
+  running_ = true;
+  thread_ = std::thread([this]() { run_loop(); });
+}
+
+void BufferManager::stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!running_) {
+      return;
+    }
+    stop_ = true;
+  }
+  cv_.notify_all();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  running_ = false;
+}
+
+void BufferManager::add_shard(int node, PageCache* shard) {
+  if (!shard) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  Member member;
+  member.shard = shard;
+  member.node = node > 0 ? node : 0;
+  CacheStats stats = shard->stats();
+  member.last_hits = stats.hits;
+  member.last_misses = stats.misses;
+  members_.push_back(member);
+  assign_equal();
+}
+
+void BufferManager::remove_shard(PageCache* shard) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = std::find_if(members_.begin(), members_.end(),
+                         [shard](const Member& member) { return member.shard == shard; });
+  if (it == members_.end()) {
+    return;
+  }
+  members_.erase(it);
+  assign_equal();
+}
+
+size_t BufferManager::node_budget() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return node_budget_locked();
+}
+
+uint64_t BufferManager::moved_pages() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return moved_pages_;
+}
+
+size_t BufferManager::node_budget_locked() const {
+  int nodes = 1;
+  for (const auto& member : members_) {
+    nodes = std::max(nodes, member.node + 1);
+  }
+  return std::max<size_t>(1, total_pages_ / static_cast<size_t>(nodes));
+}
+
+void BufferManager::assign_equal() {
+  // 最大节点号变化时每节点预算随之改变，因此所有节点一起重新均分。
+  size_t budget = node_budget_locked();
+  std::vector<size_t> counts;
+  for (const auto& member : members_) {
+    if (static_cast<size_t>(member.node) >= counts.size()) {
+      counts.resize(static_cast<size_t>(member.node) + 1, 0);
+    }
+    ++counts[static_cast<size_t>(member.node)];
+  }
+  for (auto& member : members_) {
+    size_t share = budget / counts[static_cast<size_t>(member.node)];
+    member.shard->set_limit(std::max(share, options_.min_pages));
+    member.pressure = 0.0;
+  }
+}
+
+void BufferManager::rebalance() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  size_t budget = node_budget_locked();
+  size_t step = std::max<size_t>(1, budget * options_.step_percent / 100);
+  int nodes = 0;
+  for (const auto& member : members_) {
+    nodes = std::max(nodes, member.node + 1);
+  }
+  for (int node = 0; node < nodes; ++node) {
+    Member* recipient = nullptr;
+    Member* donor = nullptr;
+    uint64_t donor_hits = 0;
+    for (auto& member : members_) {
+      if (member.node != node) {
+        continue;
+      }
+      CacheStats stats = member.shard->stats();
+      uint64_t hits = stats.hits - member.last_hits;
+      uint64_t misses = stats.misses - member.last_misses;
+      member.last_hits = stats.hits;
+      member.last_misses = stats.misses;
+      member.pressure = member.pressure * 0.5 + static_cast<double>(misses) * 0.5;
+      // 只有已用满配额的分片多给帧才会减少缺页。
+      if (stats.pages >= stats.limit && stats.limit < stats.capacity &&
+          (!recipient || member.pressure > recipient->pressure)) {
+        recipient = &member;
+      }
+      if (stats.limit > options_.min_pages &&
+          (!donor || member.pressure < donor->pressure ||
+           (member.pressure == donor->pressure && hits < donor_hits))) {
+        donor = &member;
+        donor_hits = hits;
+      }
+    }
+    // 压力差足够大才移动，避免两个分片之间来回摆动。
+    if (!recipient || !donor || recipient == donor ||
+        recipient->pressure <= donor->pressure * 2 + 1) {
+      continue;
+    }
+    size_t donor_limit = donor->shard->limit();
+    size_t recipient_limit = recipient->shard->limit();
+    size_t move = std::min({step, donor_limit - options_.min_pages,
+                            recipient->shard->capacity() - recipient_limit});
+    if (move == 0) {
+      continue;
+    }
+    donor->shard->set_limit(donor_limit - move);
+    recipient->shard->set_limit(recipient_limit + move);
+    moved_pages_ += move;
+  }
+}
+
+void BufferManager::run_loop() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!stop_) {
+    cv_.wait_for(lock, std::chrono::milliseconds(options_.interval_ms), [this]() { return stop_; });
+    if (stop_) {
+      break;
+    }
+    lock.unlock();
+    rebalance();
+    lock.lock();
+  }
+}
+
+const char* buffer_budget_name(const BufferBudgetOptions& options) {
+  if (!options.shared) {
+    return "per-table";
+  }
+  return options.interval_ms > 0 ? "shared, rebalanced by miss pressure" : "shared, split evenly";
+}
+
+}  // namespace mini_db
@@ -1,15 +1,20 @@
 #include "db/BufferPool.h"
 
 #include "db/Numa.h"
+#include "db/NumaMetrics.h"
+#include "db/NumaThread.h"
+
+#include <algorithm>
 
 namespace mini_db {
 
 NumaBufferPool::NumaBufferPool(Pager* pager, size_t capacity, size_t page_size,
-                               int preferred_nodes)
+                               int preferred_nodes, const CacheOptions& options)
     : topology_(create_numa_topology(preferred_nodes)),
       allocator_(create_numa_allocator()),
-      selector_(std::make_unique<ModuloPageSelector>()),
-      page_size_(page_size) {
+      pager_(pager),
+      page_size_(page_size),
+      readahead_window_(options.readahead.enabled ? options.readahead.window_pages : 0) {
   // 根据拓扑信息创建分片缓存；每个分片对应一个 NUMA 节点。
   int nodes = topology_ ? topology_->node_count() : 1;
   if (nodes <= 0) {
@@ -32,23 +37,154 @@ NumaBufferPool::NumaBufferPool(Pager* pager, size_t capacity, size_t page_size,
     alloc_node = 0;
   }
   for (int i = 0; i < nodes; ++i) {
-    // 每个分片维护自身的 LRU 与页内存分配。
+    // 每个分片维护自身的替换策略与页内存分配。
     int node_id = (alloc_node >= 0) ? alloc_node : i;
-    auto shard = std::make_unique<PageCache>(pager, per_node, page_size, node_id, allocator_.get());
+    auto shard = std::make_unique<PageCache>(pager, per_node, page_size, node_id, allocator_.get(),
+                                             options);
     shards_.push_back(std::move(shard));
   }
+  selector_ = create_page_selector(options.placement, nodes);
+  if (selector_->migrates() && nodes > 1) {
+    placement_ = std::make_unique<PlacementStripe[]>(kPlacementStripes);
+  }
 }
 
-Page* NumaBufferPool::get_page(size_t page_id, std::string* err) {
-  // 按页归属节点路由到对应缓存分片。
-  PageCache& shard = shard_for_page(page_id);
-  return shard.get_page(page_id, err);
+NumaBufferPool::~NumaBufferPool() {
+  set_buffer_manager(nullptr);
 }
 
-void NumaBufferPool::mark_dirty(size_t page_id) {
-  // 脏页标记路由到归属分片。
-  PageCache& shard = shard_for_page(page_id);
-  shard.mark_dirty(page_id);
+void NumaBufferPool::set_buffer_manager(BufferManager* manager) {
+  if (buffer_manager_) {
+    for (auto& shard : shards_) {
+      buffer_manager_->remove_shard(shard.get());
+    }
+  }
+  buffer_manager_ = manager;
+  if (buffer_manager_) {
+    for (size_t i = 0; i < shards_.size(); ++i) {
+      buffer_manager_->add_shard(static_cast<int>(i), shards_[i].get());
+    }
+  }
+}
+
+PageGuard NumaBufferPool::get_page(size_t page_id, PageGuard::Mode mode, PageAccess access,
+                                   std::string* err) {
+  if (access == PageAccess::Scan && readahead_window_ > 0) {
+    read_ahead(page_id);
+  }
+  if (!placement_) {
+    // 按页归属节点路由到对应缓存分片。
+    int node = node_for_page(page_id);
+    if (numa_metrics()) {
+      record_numa_frame_access(node, accessing_node());
+    }
+    return shards_[static_cast<size_t>(node)]->get_page(page_id, mode, access, err);
+  }
+  PlacementStripe& stripe = placement_[page_id % kPlacementStripes];
+  if (access == PageAccess::Normal) {
+    // 只统计普通访问：扫描按归属节点分工，不代表页的热点节点。
+    int frame_node = frame_node_for_page(page_id);
+    int target = selector_->record_access(page_id, accessing_node(), frame_node,
+                                          static_cast<int>(shards_.size()));
+    if (target >= 0 && target != frame_node) {
+      migrate(page_id, target);
+    }
+  }
+  // 查表与钉页在同一把共享锁内完成，迁移不会在两者之间把页移走。
+  std::shared_lock<std::shared_mutex> lock(stripe.mutex);
+  int node = frame_node_locked(stripe, page_id);
+  if (numa_metrics()) {
+    record_numa_frame_access(node, accessing_node());
+  }
+  return shards_[static_cast<size_t>(node)]->get_page(page_id, mode, access, err);
+}
+
+bool NumaBufferPool::read_optimistic(size_t page_id, size_t offset, size_t size, char* out) {
+  if (placement_) {
+    return false;
+  }
+  int node = node_for_page(page_id);
+  if (numa_metrics()) {
+    record_numa_frame_access(node, accessing_node());
+  }
+  return shards_[static_cast<size_t>(node)]->read_optimistic(page_id, offset, size, out);
+}
+
+void NumaBufferPool::migrate(size_t page_id, int target) {
+  PlacementStripe& stripe = placement_[page_id % kPlacementStripes];
+  std::unique_lock<std::shared_mutex> lock(stripe.mutex, std::try_to_lock);
+  if (!lock.owns_lock() || frame_node_locked(stripe, page_id) == target) {
+    return;
+  }
+  // 各分片中的副本都干净才能丢弃（磁盘内容即最新），脏页等写页线程写回后再迁移。
+  for (auto& shard : shards_) {
+    if (!shard->discard_clean(page_id)) {
+      return;
+    }
+  }
+  if (target == node_for_page(page_id)) {
+    stripe.moved.erase(page_id);
+  } else {
+    stripe.moved[page_id] = target;
+  }
+  migrations_.fetch_add(1, std::memory_order_relaxed);
+}
+
+int NumaBufferPool::accessing_node() const {
+  int nodes = static_cast<int>(shards_.size());
+  int node = thread_bound_node();
+  if (node < 0) {
+    node = topology_ ? topology_->current_node() : 0;
+  }
+  return node >= 0 ? node % nodes : 0;
+}
+
+void NumaBufferPool::read_ahead(size_t page_id) {
+  // 同一页上的连续记录不重复检测；跳转到非相邻页时重新开始。
+  size_t last = last_scan_page_.exchange(page_id);
+  if (last == page_id) {
+    return;
+  }
+  if (last == SIZE_MAX || page_id != last + 1) {
+    readahead_end_.store(page_id + 1);
+    return;
+  }
+  size_t submitted = readahead_end_.load();
+  size_t start = std::max(submitted, page_id + 1);
+  if (start > page_id + readahead_window_ / 2) {
+    return;
+  }
+  // 文件末尾之后的页没有内容可读。
+  size_t file_pages = page_size_ > 0 ? (pager_->file_size() + page_size_ - 1) / page_size_ : 0;
+  size_t end = std::min(page_id + 1 + readahead_window_, file_pages);
+  if (start >= end || !readahead_end_.compare_exchange_strong(submitted, end)) {
+    return;
+  }
+  // 按页帧所在分片拆分，由各分片的预读线程在本节点读入。
+  std::vector<std::vector<size_t>> per_shard(shards_.size());
+  for (size_t id = start; id < end; ++id) {
+    per_shard[static_cast<size_t>(frame_node_for_page(id))].push_back(id);
+  }
+  for (size_t i = 0; i < shards_.size(); ++i) {
+    shards_[i]->prefetch_async(per_shard[i]);
+  }
+}
+
+void NumaBufferPool::set_wal(const std::function<WalGate(int node)>& make_gate) {
+  if (!placement_) {
+    for (size_t i = 0; i < shards_.size(); ++i) {
+      shards_[i]->set_wal(make_gate(static_cast<int>(i)));
+    }
+    return;
+  }
+  // 迁移后的页帧仍按归属节点的日志分区等待：每个分片持有全部分区的接口，按页归属节点选择。
+  std::vector<WalGate> gates;
+  for (size_t i = 0; i < shards_.size(); ++i) {
+    gates.push_back(make_gate(static_cast<int>(i)));
+  }
+  for (auto& shard : shards_) {
+    shard->set_wal(gates, [this](size_t page_id) { return node_for_page(page_id); });
+  }
 }
 
 void NumaBufferPool::flush(std::string* err) {
@@ -75,8 +211,77 @@ std::vector<size_t> NumaBufferPool::cached_pages_per_node() const {
 }
 
 PageCache& NumaBufferPool::shard_for_page(size_t page_id) {
+  return *shards_.at(static_cast<size_t>(node_for_page(page_id)));
+}
+
+int NumaBufferPool::frame_node_for_page(size_t page_id) const {
+  if (!placement_) {
+    return node_for_page(page_id);
+  }
+  const PlacementStripe& stripe = placement_[page_id % kPlacementStripes];
+  std::shared_lock<std::shared_mutex> lock(stripe.mutex);
+  return frame_node_locked(stripe, page_id);
+}
+
+int NumaBufferPool::frame_node_locked(const PlacementStripe& stripe, size_t page_id) const {
+  auto it = stripe.moved.find(page_id);
+  return it != stripe.moved.end() ? it->second : node_for_page(page_id);
+}
+
+CacheStats NumaBufferPool::stats() const {
+  CacheStats total;
+  for (const auto& shard : shards_) {
+    total.add(shard->stats());
+  }
+  return total;
+}
+
+std::vector<CacheStats> NumaBufferPool::shard_stats() const {
+  std::vector<CacheStats> stats;
+  stats.reserve(shards_.size());
+  for (const auto& shard : shards_) {
+    stats.push_back(shard ? shard->stats() : CacheStats{});
+  }
+  return stats;
+}
+
+std::vector<std::vector<size_t>> NumaBufferPool::resident_pages() const {
+  std::vector<std::vector<size_t>> pages;
+  pages.reserve(shards_.size());
+  for (const auto& shard : shards_) {
+    pages.push_back(shard ? shard->resident_pages() : std::vector<size_t>());
+  }
+  return pages;
+}
+
+size_t NumaBufferPool::warm(int node, const std::vector<size_t>& page_ids, bool* full) {
+  if (full) {
+    *full = false;
+  }
+  if (node < 0 || static_cast<size_t>(node) >= shards_.size() || !shards_[node]) {
+    return 0;
+  }
+  // 按页帧所在节点筛选：节点数变化或页帧迁移后，页不一定仍在保存时的分片。
+  std::vector<size_t> ids;
+  ids.reserve(page_ids.size());
+  for (size_t page_id : page_ids) {
+    if (frame_node_for_page(page_id) == node) {
+      ids.push_back(page_id);
+    }
+  }
+  if (ids.empty()) {
+    return 0;
+  }
+  return shards_[static_cast<size_t>(node)]->warm(ids, full);
+}
+
+uint64_t NumaBufferPool::page_migrations() const {
+  return migrations_.load(std::memory_order_relaxed);
+}
+
+int NumaBufferPool::node_for_page(size_t page_id) const {
   // 按策略选择页所属节点。
-  int nodes = node_count();
+  int nodes = static_cast<int>(shards_.size());
   int node = selector_ ? selector_->node_for_page(page_id, nodes) : 0;
   if (node < 0) {
     node = 0;
@@ -86,7 +291,7 @@ PageCache& NumaBufferPool::shard_for_page(size_t page_id) {
   } else if (node >= nodes) {
     node = node % nodes;
   }
-  return *shards_.at(static_cast<size_t>(node));
+  return node;
 }
 
 }  // namespace mini_db
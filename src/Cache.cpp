@@ -1,104 +1,1030 @@
 #include "db/Cache.h"
 
+#include "db/Numa.h"
+#include "db/NumaThread.h"
+#include "db/Trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <sys/mman.h>
+#include <thread>
+#include <unistd.h>
+#include <utility>
+
 namespace mini_db {
 
+namespace {
+
+// MINI_DB_HUGE_PAGES=1 时为帧内存池申请透明大页。
+bool huge_pages_requested() {
+  const char* value = std::getenv("MINI_DB_HUGE_PAGES");
+  return value && std::strcmp(value, "1") == 0;
+}
+
+void advise_huge_pages(char* data, size_t size) {
+#ifdef MADV_HUGEPAGE
+  // madvise 要求起始地址按系统页对齐，只对齐后的区间生效；失败时保持普通页。
+  uintptr_t page = static_cast<uintptr_t>(::sysconf(_SC_PAGESIZE));
+  uintptr_t begin = (reinterpret_cast<uintptr_t>(data) + page - 1) & ~(page - 1);
+  uintptr_t end = (reinterpret_cast<uintptr_t>(data) + size) & ~(page - 1);
+  if (end > begin) {
+    ::madvise(reinterpret_cast<void*>(begin), end - begin, MADV_HUGEPAGE);
+  }
+#else
+  (void)data;
+  (void)size;
+#endif
+}
+
+// 帧移出缓存：置无效位，之后对帧数据的改写都排在置位之后，乐观读者复制后能看到版本变化。
+void invalidate_frame(Page& page) {
+  page.version.fetch_or(Page::kVersionInvalid, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+}
+
+// 帧装入新页完成（此时无人持写闩）：清除无效位并推进计数。
+void validate_frame(Page& page) {
+  uint64_t version = page.version.load(std::memory_order_relaxed);
+  page.version.store((version | Page::kVersionInvalid | Page::kVersionWriting) + 1,
+                     std::memory_order_release);
+}
+
+}  // namespace
+
+void CacheStats::add(const CacheStats& other) {
+  hits += other.hits;
+  misses += other.misses;
+  evictions += other.evictions;
+  pages_written += other.pages_written;
+  sync_writes += other.sync_writes;
+  prefetched += other.prefetched;
+  pages += other.pages;
+  limit += other.limit;
+  capacity += other.capacity;
+}
+
+PageGuard::PageGuard(Page* page, Mode mode) : page_(page), mode_(mode) {
+  if (!page_) {
+    return;
+  }
+  if (mode_ == Mode::Write) {
+    page_->latch.lock();
+    // 写闩内置写入位：之后的修改排在置位之后，乐观读者据此放弃读到一半的内容。
+    page_->version.fetch_add(Page::kVersionWriting, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+  } else {
+    page_->latch.lock_shared();
+  }
+}
+
+PageGuard::~PageGuard() {
+  release();
+}
+
+PageGuard::PageGuard(PageGuard&& other) noexcept : page_(other.page_), mode_(other.mode_) {
+  other.page_ = nullptr;
+}
+
+PageGuard& PageGuard::operator=(PageGuard&& other) noexcept {
+  if (this != &other) {
+    release();
+    page_ = other.page_;
+    mode_ = other.mode_;
+    other.page_ = nullptr;
+  }
+  return *this;
+}
+
+PageGuard::operator bool() const {
+  return page_ != nullptr;
+}
+
+size_t PageGuard::page_id() const {
+  return page_ ? page_->id.load() : 0;
+}
+
+size_t PageGuard::size() const {
+  return page_ ? page_->size : 0;
+}
+
+const char* PageGuard::data() const {
+  return page_ ? page_->data : nullptr;
+}
+
+char* PageGuard::mutable_data() {
+  return (page_ && mode_ == Mode::Write) ? page_->data : nullptr;
+}
+
+void PageGuard::mark_dirty() {
+  if (page_ && mode_ == Mode::Write) {
+    // 只有由干净变脏时入队，已在队列中的页不重复入队。
+    if (!page_->dirty.exchange(true) && page_->owner) {
+      page_->owner->enqueue_dirty(page_, true);
+    }
+  }
+}
+
+void PageGuard::mark_dirty(uint64_t lsn) {
+  if (page_ && mode_ == Mode::Write) {
+    // 写闩独占，页 LSN 只会在此处增大。
+    if (lsn > page_->lsn.load()) {
+      page_->lsn.store(lsn);
+    }
+    mark_dirty();
+  }
+}
+
+void PageGuard::release() {
+  if (!page_) {
+    return;
+  }
+  // 先放闩再解除钉住：解除后页随时可能被淘汰。
+  if (mode_ == Mode::Write) {
+    // 写入位进位到计数位：读者前后两次读到的版本必然不同。
+    page_->version.fetch_add(Page::kVersionWriting, std::memory_order_release);
+    page_->latch.unlock();
+  } else {
+    page_->latch.unlock_shared();
+  }
+  page_->pin_count.fetch_sub(1);
+  page_ = nullptr;
+}
+
 PageCache::PageCache(Pager* pager, size_t capacity, size_t page_size, int node_id,
-                     NumaAllocator* allocator)
+                     NumaAllocator* allocator, const CacheOptions& options)
     : pager_(pager),
-      capacity_(capacity),
+      capacity_(capacity == 0 ? 1 : capacity),
       page_size_(page_size),
       node_id_(node_id),
-      allocator_(allocator) {}
+      allocator_(allocator),
+      optimistic_reads_(options.optimistic_reads) {
+  // 一次性在节点上分配全部帧内存，之后缺页只复用帧，不再分配。
+  // 不清零：帧在装入时才写入，未使用的帧不占物理内存（共享预算下配额可远小于帧上限）。
+  arena_.reset(capacity_ * page_size_, node_id_, allocator_, false);
+  limit_.store(capacity_);
+  if (arena_.data() && huge_pages_requested()) {
+    advise_huge_pages(arena_.data(), arena_.size());
+  }
+  frames_ = std::make_unique<Page[]>(capacity_);
+  free_frames_.reserve(capacity_);
+  for (size_t i = capacity_; i > 0; --i) {
+    Page& frame = frames_[i - 1];
+    frame.data = arena_.data() ? arena_.data() + (i - 1) * page_size_ : nullptr;
+    frame.size = page_size_;
+    frame.numa_node = node_id_;
+    frame.owner = this;
+    frame.frame = static_cast<int32_t>(i - 1);
+    free_frames_.push_back(static_cast<int32_t>(i - 1));
+  }
+  // 页表槽位数取不小于 2 倍容量的 2 的幂，负载因子不超过 0.5。
+  size_t slots = 1;
+  while (slots < capacity_ * 2) {
+    slots <<= 1;
+  }
+  table_ = std::make_unique<std::atomic<int32_t>[]>(slots);
+  for (size_t i = 0; i < slots; ++i) {
+    table_[i].store(kNoFrame, std::memory_order_relaxed);
+  }
+  table_mask_ = slots - 1;
+  policy_ = create_replacement_policy(options.policy, capacity_);
+  dirty_frames_.reserve(capacity_);
+  writer_options_ = options.writer;
+  dirty_wakeup_ = capacity_ * writer_options_.dirty_percent / 100;
+  if (dirty_wakeup_ == 0) {
+    dirty_wakeup_ = 1;
+  }
+  if (writer_options_.enabled) {
+    writer_ = std::thread(&PageCache::writer_loop, this);
+  }
+  const ReadAheadOptions& readahead = options.readahead;
+  scan_ring_pages_ = std::min(readahead.scan_ring_pages, capacity_ / 4);
+  scan_ring_seq_.assign(capacity_, 0);
+  // 单批预读不超过扫描环的一半，预读页在被扫描消费前不会被后续扫描页挤出环。
+  size_t limit = scan_ring_pages_ > 0 ? scan_ring_pages_ / 2 : capacity_ / 4;
+  prefetch_limit_ = std::min(readahead.window_pages, limit);
+  if (readahead.enabled && prefetch_limit_ > 0) {
+    prefetch_queue_.reserve(readahead.window_pages * 2);
+    prefetcher_ = std::thread(&PageCache::prefetch_loop, this);
+  }
+}
+
+PageCache::~PageCache() {
+  {
+    std::lock_guard<std::mutex> lock(dirty_mutex_);
+    writer_stop_ = true;
+  }
+  writer_cv_.notify_one();
+  if (writer_.joinable()) {
+    writer_.join();
+  }
+  {
+    std::lock_guard<std::mutex> lock(prefetch_mutex_);
+    prefetch_stop_ = true;
+  }
+  prefetch_cv_.notify_one();
+  if (prefetcher_.joinable()) {
+    prefetcher_.join();
+  }
+}
 
-bool PageCache::evict_if_needed(std::string* err) {
-  // 缓存未满时无需淘汰。
-  if (capacity_ == 0 || pages_.size() < capacity_) {
+void PageCache::set_wal(WalGate wal) {
+  std::vector<WalGate> gates;
+  gates.push_back(std::move(wal));
+  set_wal(std::move(gates), nullptr);
+}
+
+void PageCache::set_wal(std::vector<WalGate> gates,
+                        std::function<int(size_t page_id)> gate_for_page) {
+  wal_ = std::move(gates);
+  wal_for_page_ = std::move(gate_for_page);
+  wal_durable_ = std::make_unique<std::atomic<uint64_t>[]>(wal_.size());
+  for (size_t i = 0; i < wal_.size(); ++i) {
+    wal_durable_[i].store(0);
+  }
+}
+
+int PageCache::wal_gate_for(size_t page_id) const {
+  if (!wal_for_page_) {
+    return 0;
+  }
+  int gate = wal_for_page_(page_id);
+  return gate >= 0 && static_cast<size_t>(gate) < wal_.size() ? gate : 0;
+}
+
+size_t PageCache::slot_for(size_t page_id) const {
+  uint64_t hash = static_cast<uint64_t>(page_id) * 0x9E3779B97F4A7C15ull;
+  return static_cast<size_t>(hash ^ (hash >> 32)) & table_mask_;
+}
+
+int32_t PageCache::find_frame(size_t page_id) const {
+  for (size_t slot = slot_for(page_id);; slot = (slot + 1) & table_mask_) {
+    int32_t frame = table_[slot].load(std::memory_order_relaxed);
+    if (frame == kNoFrame || frames_[static_cast<size_t>(frame)].id == page_id) {
+      return frame;
+    }
+  }
+}
+
+int32_t PageCache::find_frame_unlocked(size_t page_id) const {
+  // 探测步数以表长为界：并发后移删除期间探测链可能暂时断开或重复。
+  size_t slot = slot_for(page_id);
+  for (size_t step = 0; step <= table_mask_; ++step, slot = (slot + 1) & table_mask_) {
+    int32_t frame = table_[slot].load(std::memory_order_acquire);
+    if (frame == kNoFrame) {
+      return kNoFrame;
+    }
+    if (frames_[static_cast<size_t>(frame)].id.load(std::memory_order_relaxed) == page_id) {
+      return frame;
+    }
+  }
+  return kNoFrame;
+}
+
+void PageCache::insert_frame(size_t page_id, int32_t frame) {
+  size_t slot = slot_for(page_id);
+  while (table_[slot].load(std::memory_order_relaxed) != kNoFrame) {
+    slot = (slot + 1) & table_mask_;
+  }
+  table_[slot].store(frame, std::memory_order_release);
+}
+
+void PageCache::erase_frame(size_t page_id) {
+  size_t slot = slot_for(page_id);
+  int32_t frame = kNoFrame;
+  while ((frame = table_[slot].load(std::memory_order_relaxed)) != kNoFrame &&
+         frames_[static_cast<size_t>(frame)].id != page_id) {
+    slot = (slot + 1) & table_mask_;
+  }
+  if (frame == kNoFrame) {
+    return;
+  }
+  // 后移删除：把探测链上后续可前移的条目填到空位，避免墓碑累积。
+  table_[slot].store(kNoFrame, std::memory_order_relaxed);
+  size_t hole = slot;
+  for (size_t next = (hole + 1) & table_mask_;
+       (frame = table_[next].load(std::memory_order_relaxed)) != kNoFrame;
+       next = (next + 1) & table_mask_) {
+    size_t home = slot_for(frames_[static_cast<size_t>(frame)].id);
+    bool movable = hole <= next ? (home <= hole || home > next) : (home <= hole && home > next);
+    if (movable) {
+      table_[hole].store(frame, std::memory_order_release);
+      table_[next].store(kNoFrame, std::memory_order_relaxed);
+      hole = next;
+    }
+  }
+}
+
+bool PageCache::wal_durable(int gate, uint64_t lsn) {
+  if (static_cast<size_t>(gate) >= wal_.size()) {
+    return true;
+  }
+  const WalGate& wal = wal_[static_cast<size_t>(gate)];
+  std::atomic<uint64_t>& known_durable = wal_durable_[static_cast<size_t>(gate)];
+  if (!wal.flush_to || lsn <= known_durable.load()) {
+    return true;
+  }
+  uint64_t durable = wal.durable_lsn ? wal.durable_lsn() : 0;
+  uint64_t known = known_durable.load();
+  while (known < durable && !known_durable.compare_exchange_weak(known, durable)) {
+  }
+  return lsn <= durable;
+}
+
+bool PageCache::flush_wal(int gate, uint64_t lsn, std::string* err) {
+  if (wal_durable(gate, lsn)) {
     return true;
   }
-  // 淘汰 LRU 链表尾部（最久未使用）。
-  size_t victim_id = lru_.back();
-  auto it = pages_.find(victim_id);
-  if (it != pages_.end()) {
-    if (it->second.page.dirty) {
-      // 脏页需要先写回。
-      if (!pager_->write_page(victim_id, it->second.page.data.data(),
-                              it->second.page.data.size(), err)) {
-        return false;
+  if (!wal_[static_cast<size_t>(gate)].flush_to(lsn, err)) {
+    return false;
+  }
+  std::atomic<uint64_t>& known_durable = wal_durable_[static_cast<size_t>(gate)];
+  uint64_t known = known_durable.load();
+  while (known < lsn && !known_durable.compare_exchange_weak(known, lsn)) {
+  }
+  return true;
+}
+
+bool PageCache::acquire_frame(int32_t* frame, int* wal_gate, uint64_t* wal_lsn,
+                              PageAccess access, std::string* err) {
+  if (!failed_frames_.empty()) {
+    // 回收预读失败且已无人钉住的帧。
+    size_t kept = 0;
+    for (int32_t failed : failed_frames_) {
+      Page& page = frames_[static_cast<size_t>(failed)];
+      if (page.pin_count.load() == 0) {
+        page.io_failed.store(false);
+        free_frames_.push_back(failed);
+      } else {
+        failed_frames_[kept++] = failed;
       }
     }
-    lru_.pop_back();
-    pages_.erase(it);
+    failed_frames_.resize(kept);
+  }
+  if (!free_frames_.empty() && used_ < limit_.load()) {
+    *frame = free_frames_.back();
+    free_frames_.pop_back();
+    return true;
+  }
+  // 扫描页优先复用扫描环中的帧；否则由替换策略选出牺牲帧，优先淘汰干净页，避免在缺页路径上同步写盘。
+  // 钉住计数只在持有分片锁（共享或独占）时增加，而淘汰持独占锁，
+  // 因此判定为未钉住的页在淘汰期间不会被重新钉住。
+  int32_t victim = kNoFrame;
+  if (access == PageAccess::Scan && scan_ring_pages_ > 0 &&
+      scan_ring_count_.load() >= scan_ring_limit()) {
+    victim = scan_ring_victim();
   }
+  if (victim == kNoFrame) {
+    victim = pick_victim([this](int32_t candidate) {
+      const Page& page = frames_[static_cast<size_t>(candidate)];
+      return page.pin_count.load() == 0 && !page.dirty.load();
+    });
+  }
+  if (victim == kNoFrame) {
+    victim = pick_victim([this](int32_t candidate) {
+      return frames_[static_cast<size_t>(candidate)].pin_count.load() == 0;
+    });
+  }
+  if (victim == kNoFrame) {
+    if (!free_frames_.empty()) {
+      // 已达配额但全部页被钉住：暂时超出配额使用空闲帧，之后的配额调整再收回。
+      *frame = free_frames_.back();
+      free_frames_.pop_back();
+      return true;
+    }
+    *frame = kNoFrame;
+    return true;
+  }
+  Page& page = frames_[static_cast<size_t>(victim)];
+  if (page.dirty.load()) {
+    // 没有干净页可淘汰：日志未落盘时不在分片锁内等待，交给调用方刷日志后重试；
+    // 否则同步写回，并唤醒写页线程提前清理。
+    if (!wal_durable(page.wal_gate, page.lsn.load())) {
+      *wal_gate = page.wal_gate;
+      *wal_lsn = page.lsn.load();
+      *frame = kNoFrame;
+      return true;
+    }
+    bool write_ok;
+    {
+      MINI_DB_TRACE_SPAN("cache.evict_write");
+      write_ok = pager_->write_page(page.id, page.data, page.size, err);
+    }
+    if (!write_ok) {
+      return false;
+    }
+    page.dirty.store(false);
+    pages_written_.add();
+    sync_writes_.add();
+    {
+      std::lock_guard<std::mutex> lock(dirty_mutex_);
+      writer_wakeup_ = true;
+    }
+    writer_cv_.notify_one();
+  }
+  evict_frame(victim);
+  *frame = victim;
   return true;
 }
 
-Page* PageCache::get_page(size_t page_id, std::string* err) {
+int32_t PageCache::pick_victim(const std::function<bool(int32_t)>& evictable) {
+  // 每次补记命中都会清掉一个标记，最多重选 used_ 次。
+  int32_t victim = policy_->pick_victim(evictable);
+  for (size_t retry = 0; victim != kNoFrame && retry < used_; ++retry) {
+    Page& page = frames_[static_cast<size_t>(victim)];
+    if (!page.referenced.load(std::memory_order_relaxed)) {
+      break;
+    }
+    page.referenced.store(false, std::memory_order_relaxed);
+    policy_->on_hit(victim, PageAccess::Normal);
+    victim = policy_->pick_victim(evictable);
+  }
+  return victim;
+}
+
+void PageCache::count_hit() {
+  hits_.add();
+}
+
+void PageCache::evict_frame(int32_t frame) {
+  Page& page = frames_[static_cast<size_t>(frame)];
+  invalidate_frame(page);
+  page.referenced.store(false, std::memory_order_relaxed);
+  erase_frame(page.id);
+  policy_->on_erase(frame, page.id);
+  leave_scan_ring(page);
+  --used_;
+  evictions_.add();
+}
+
+size_t PageCache::scan_ring_limit() const {
+  return std::min(scan_ring_pages_, std::max<size_t>(1, limit_.load() / 4));
+}
+
+int32_t PageCache::scan_ring_victim() {
+  // 先丢弃队首的失效条目，再从最早的有效条目开始找可淘汰的帧。
+  while (!scan_ring_.empty()) {
+    const auto& oldest = scan_ring_.front();
+    const Page& page = frames_[static_cast<size_t>(oldest.first)];
+    if (page.in_scan_ring.load() && scan_ring_seq_[static_cast<size_t>(oldest.first)] == oldest.second) {
+      break;
+    }
+    scan_ring_.pop_front();
+  }
+  for (const auto& entry : scan_ring_) {
+    const Page& page = frames_[static_cast<size_t>(entry.first)];
+    if (page.in_scan_ring.load() && scan_ring_seq_[static_cast<size_t>(entry.first)] == entry.second &&
+        page.pin_count.load() == 0 && !page.dirty.load()) {
+      return entry.first;
+    }
+  }
+  return kNoFrame;
+}
+
+void PageCache::enter_scan_ring(int32_t frame) {
+  if (scan_ring_pages_ == 0) {
+    return;
+  }
+  Page& page = frames_[static_cast<size_t>(frame)];
+  uint64_t seq = ++next_ring_seq_;
+  scan_ring_seq_[static_cast<size_t>(frame)] = seq;
+  page.in_scan_ring.store(true);
+  scan_ring_count_.fetch_add(1);
+  scan_ring_.emplace_back(frame, seq);
+  // 失效条目过多时整体压缩，队列长度保持在帧数的两倍以内。
+  if (scan_ring_.size() > capacity_ * 2) {
+    std::deque<std::pair<int32_t, uint64_t>> live;
+    for (const auto& entry : scan_ring_) {
+      if (frames_[static_cast<size_t>(entry.first)].in_scan_ring.load() &&
+          scan_ring_seq_[static_cast<size_t>(entry.first)] == entry.second) {
+        live.push_back(entry);
+      }
+    }
+    scan_ring_.swap(live);
+  }
+}
+
+void PageCache::leave_scan_ring(Page& page) {
+  // 普通访问命中时只持共享锁，标记与计数用原子操作维护，队列条目留待惰性清理。
+  if (page.in_scan_ring.load() && page.in_scan_ring.exchange(false)) {
+    scan_ring_count_.fetch_sub(1);
+  }
+}
+
+PageGuard PageCache::get_page(size_t page_id, PageGuard::Mode mode, PageAccess access,
+                              std::string* err) {
   // get_page 用于从页缓存（内存里）里获取一个页对象 Page ，如果缓存里没有该页，就从磁盘加载该页到缓存里
-  std::lock_guard<std::mutex> lock(mutex_);   // 保护缓存结构的互斥锁（线程安全）
-  // 命中缓存：更新 LRU 顺序。
-  auto it = pages_.find(page_id);   // 查 哈希表
-  if (it != pages_.end()) {
-    // 如果缓存命中：返回缓存中的 Page * ，并更新 LRU
-    lru_.erase(it->second.lru_it);  // 把它从 LRU 链表原位置删掉 O(1)
-    lru_.push_front(page_id);    // 把 page_id 放到 LRU 链表头部，表示最近使用
-    it->second.lru_it = lru_.begin();   // 更新 Entry 里保存的迭代器，指向新的位置。
-    return &it->second.page;  // 返回页地址
-  }
-  // 未命中缓存：可能需要淘汰旧页。
-  if (!evict_if_needed(err)) {
-    // evict_if_needed 会检查缓存是否已满，如果满则按 lru_.back() 淘汰最久未使用的页
-    return nullptr;
-  }
-  // 未命中：从磁盘加载新页。
-  // 使用 NUMA 分配器在指定节点创建页缓冲区。
-  Entry entry;
-  entry.page.id = page_id;
-  entry.page.data.reset(page_size_, node_id_, allocator_);  // 分配页缓冲区
-  entry.page.dirty = false;
-  entry.page.numa_node = node_id_;
-  if (!entry.page.data.data()) {
-    if (err) {
-      *err = "failed to allocate page buffer";
-    }
-    return nullptr;
-  }
-  // 从磁盘读取页数据进来，放入缓存并返回
-  if (!pager_->read_page(page_id, entry.page.data.data(), entry.page.data.size(), err)) {
-    return nullptr;
-  }
-  lru_.push_front(page_id);
-  entry.lru_it = lru_.begin();
-  auto result = pages_.emplace(page_id, std::move(entry));
-  return &result.first->second.page;
-}
-
-void PageCache::mark_dirty(size_t page_id) {
-  std::lock_guard<std::mutex> lock(mutex_);
-  // 标记脏页，flush 时写回。
-  auto it = pages_.find(page_id);
-  if (it != pages_.end()) {
-    it->second.page.dirty = true;
+  Page* page = nullptr;
+  int wal_gate = 0;
+  uint64_t wal_lsn = 0;
+  if (policy_->lock_free_hits()) {
+    // 快速路径：共享锁内查页表并钉住，命中时只通知策略（置引用位），不修改共享结构。
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    int32_t frame = find_frame(page_id);
+    if (frame != kNoFrame) {
+      page = &frames_[static_cast<size_t>(frame)];
+      page->pin_count.fetch_add(1);
+      policy_->on_hit(frame, access);
+      if (access == PageAccess::Normal) {
+        leave_scan_ring(*page);
+      }
+      count_hit();
+    }
+  }
+  while (!page) {
+    {
+      std::unique_lock<std::shared_mutex> lock(mutex_);   // 保护缓存结构的互斥锁（线程安全）
+      int32_t frame = find_frame(page_id);   // 查开放寻址页表
+      if (frame != kNoFrame) {
+        // 命中缓存：通知替换策略（LRU 会把帧挪到链表头部）；普通访问命中的扫描页移出扫描环。
+        policy_->on_hit(frame, access);
+        if (access == PageAccess::Normal) {
+          leave_scan_ring(frames_[static_cast<size_t>(frame)]);
+        }
+        count_hit();
+      } else {
+        if (!arena_.data()) {
+          if (err) {
+            *err = "failed to allocate page buffer";
+          }
+          return PageGuard();
+        }
+        // 未命中缓存：取空闲帧或淘汰旧页。
+        if (!acquire_frame(&frame, &wal_gate, &wal_lsn, access, err)) {
+          return PageGuard();
+        }
+        if (frame != kNoFrame) {
+          // 从磁盘读取页数据到帧中
+          Page& loaded = frames_[static_cast<size_t>(frame)];
+          loaded.id = page_id;
+          loaded.lsn.store(0);
+          loaded.wal_gate = wal_gate_for(page_id);
+          bool read_ok;
+          {
+            MINI_DB_TRACE_SPAN("cache.miss_read");
+            read_ok = pager_->read_page(page_id, loaded.data, loaded.size, err);
+          }
+          if (!read_ok) {
+            free_frames_.push_back(frame);
+            return PageGuard();
+          }
+          validate_frame(loaded);
+          insert_frame(page_id, frame);
+          policy_->on_insert(frame, page_id, access);
+          if (access == PageAccess::Scan) {
+            enter_scan_ring(frame);
+          }
+          ++used_;
+          misses_.add();
+        }
+      }
+      if (frame != kNoFrame) {
+        // 在分片锁内钉住，保证返回前不会被其他线程淘汰。
+        page = &frames_[static_cast<size_t>(frame)];
+        page->pin_count.fetch_add(1);
+      }
+    }
+    if (!page && wal_lsn > 0) {
+      // 牺牲页的日志尚未落盘：锁外刷日志（与其他等待者共享一次组提交）后重试。
+      if (!flush_wal(wal_gate, wal_lsn, err)) {
+        return PageGuard();
+      }
+      wal_lsn = 0;
+    } else if (!page) {
+      // 全部帧被钉住：等待持有者完成当前读写。
+      std::this_thread::yield();
+    }
+  }
+  // 页闩在分片锁外获取，等待同页的读写者不阻塞整个分片；预读中的页在读完前持有写闩。
+  PageGuard guard(page, mode);
+  if (page->io_failed.load()) {
+    // 预读失败的帧已移出页表：放弃它，重新走缺页路径同步装载并报告错误。
+    guard.release();
+    return get_page(page_id, mode, access, err);
+  }
+  return guard;
+}
+
+void PageCache::prefetch_async(const std::vector<size_t>& page_ids) {
+  if (!prefetcher_.joinable() || page_ids.empty()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(prefetch_mutex_);
+    // 预读线程跟不上时丢弃新的请求，扫描会在缺页时同步读取。
+    if (prefetch_queue_.size() + page_ids.size() > prefetch_queue_.capacity()) {
+      return;
+    }
+    prefetch_queue_.insert(prefetch_queue_.end(), page_ids.begin(), page_ids.end());
+  }
+  prefetch_cv_.notify_one();
+}
+
+void PageCache::prefetch(const std::vector<size_t>& page_ids) {
+  load_pages(page_ids, PageAccess::Scan, prefetch_limit_, false, nullptr);
+}
+
+std::vector<size_t> PageCache::resident_pages() const {
+  std::vector<size_t> pages;
+  std::shared_lock<std::shared_mutex> lock(mutex_);
+  pages.reserve(used_);
+  for (size_t slot = 0; slot <= table_mask_; ++slot) {
+    int32_t frame = table_[slot].load(std::memory_order_relaxed);
+    if (frame == kNoFrame) {
+      continue;
+    }
+    // 扫描环中的页只是顺序扫描经过，不算热点。
+    const Page& page = frames_[static_cast<size_t>(frame)];
+    if (!page.in_scan_ring.load(std::memory_order_relaxed)) {
+      pages.push_back(page.id.load(std::memory_order_relaxed));
+    }
+  }
+  std::sort(pages.begin(), pages.end());
+  return pages;
+}
+
+size_t PageCache::warm(const std::vector<size_t>& page_ids, bool* full) {
+  return load_pages(page_ids, PageAccess::Normal, page_ids.size(), true, full);
+}
+
+size_t PageCache::load_pages(const std::vector<size_t>& page_ids, PageAccess access,
+                             size_t max_pages, bool free_only, bool* full) {
+  std::vector<Page*> loading;
+  std::vector<size_t> ids;
+  std::vector<char*> buffers;
+  if (full) {
+    *full = false;
+  }
+  {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    if (!arena_.data()) {
+      return 0;
+    }
+    for (size_t page_id : page_ids) {
+      if (loading.size() >= max_pages) {
+        break;
+      }
+      if (find_frame(page_id) != kNoFrame) {
+        continue;
+      }
+      int32_t frame = kNoFrame;
+      int wal_gate = 0;
+      uint64_t wal_lsn = 0;
+      if (free_only) {
+        // 预热只占用配额内的空闲帧，不淘汰已有的页。
+        if (free_frames_.empty() || used_ >= limit_.load()) {
+          if (full) {
+            *full = true;
+          }
+          break;
+        }
+        frame = free_frames_.back();
+        free_frames_.pop_back();
+      } else {
+        // 预读不等待日志、不抢占被钉住的帧：取不到帧时放弃本批剩余的页。
+        std::string acquire_err;
+        if (!acquire_frame(&frame, &wal_gate, &wal_lsn, access, &acquire_err) ||
+            frame == kNoFrame) {
+          break;
+        }
+      }
+      // 帧未被钉住，页闩必然空闲；持写闩直到读完，先到的访问者在页闩上等待。
+      Page& page = frames_[static_cast<size_t>(frame)];
+      page.id = page_id;
+      page.lsn.store(0);
+      page.wal_gate = wal_gate_for(page_id);
+      page.pin_count.fetch_add(1);
+      page.latch.lock();
+      insert_frame(page_id, frame);
+      policy_->on_insert(frame, page_id, access);
+      if (access == PageAccess::Scan) {
+        enter_scan_ring(frame);
+      }
+      ++used_;
+      loading.push_back(&page);
+      ids.push_back(page_id);
+      buffers.push_back(page.data);
+    }
+  }
+  if (loading.empty()) {
+    return 0;
+  }
+  size_t loaded = loading.size();
+  std::string read_err;
+  bool read_ok;
+  {
+    MINI_DB_TRACE_SPAN("cache.prefetch_read");
+    read_ok = pager_->read_pages(ids, buffers, page_size_, &read_err);
+  }
+  if (!read_ok) {
+    // 读取失败：移出页表，等待者看到 io_failed 后自行重新装载。
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    for (Page* page : loading) {
+      erase_frame(page->id);
+      policy_->on_erase(page->frame, page->id);
+      leave_scan_ring(*page);
+      --used_;
+      page->io_failed.store(true);
+      failed_frames_.push_back(page->frame);
+    }
+    loaded = 0;
+  }
+  prefetched_.add(loaded);
+  for (Page* page : loading) {
+    if (!page->io_failed.load()) {
+      validate_frame(*page);
+    }
+    page->latch.unlock();
+    page->pin_count.fetch_sub(1);
+  }
+  return loaded;
+}
+
+bool PageCache::read_optimistic(size_t page_id, size_t offset, size_t size, char* out) {
+  if (!optimistic_reads_ || offset + size > page_size_) {
+    return false;
+  }
+  for (int attempt = 0; attempt < kOptimisticAttempts; ++attempt) {
+    int32_t frame = find_frame_unlocked(page_id);
+    if (frame == kNoFrame) {
+      return false;
+    }
+    Page& page = frames_[static_cast<size_t>(frame)];
+    uint64_t before = page.version.load(std::memory_order_acquire);
+    if (before & Page::kVersionInvalid) {
+      return false;
+    }
+    if (before & Page::kVersionWriting) {
+      std::this_thread::yield();
+      continue;
+    }
+    // 扫描环中的页交给加锁路径：普通访问命中时要移出扫描环。
+    if (page.id.load(std::memory_order_relaxed) != page_id ||
+        page.in_scan_ring.load(std::memory_order_relaxed)) {
+      return false;
+    }
+    std::memcpy(out, page.data + offset, size);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (page.version.load(std::memory_order_relaxed) == before) {
+      // 已置位时只读不写，热点页的标记不在读者之间来回失效。
+      if (!page.referenced.load(std::memory_order_relaxed)) {
+        page.referenced.store(true, std::memory_order_relaxed);
+      }
+      count_hit();
+      return true;
+    }
+  }
+  return false;
+}
+
+void PageCache::prefetch_loop() {
+  if (is_numa_enabled()) {
+    // 预读线程与分片的帧内存位于同一节点。
+    std::string bind_err;
+    bind_thread_to_node(node_id_, &bind_err);
+  }
+  std::vector<size_t> batch;
+  batch.reserve(prefetch_queue_.capacity());
+  std::unique_lock<std::mutex> lock(prefetch_mutex_);
+  while (true) {
+    prefetch_cv_.wait(lock, [this]() { return prefetch_stop_ || !prefetch_queue_.empty(); });
+    if (prefetch_stop_) {
+      break;
+    }
+    batch.assign(prefetch_queue_.begin(), prefetch_queue_.end());
+    prefetch_queue_.clear();
+    lock.unlock();
+    prefetch(batch);
+    lock.lock();
   }
 }
 
 void PageCache::flush(std::string* err) {
-  std::lock_guard<std::mutex> lock(mutex_);
-  // 写回所有脏页并刷新底层文件。
-  for (auto& pair : pages_) {
-    if (pair.second.page.dirty) {
-      if (!pager_->write_page(pair.first, pair.second.page.data.data(),
-                              pair.second.page.data.size(), err)) {
-        return;
+  // 写回脏页队列中的全部页并刷新底层文件。
+  if (write_dirty(0, true, err)) {
+    pager_->flush(err);
+  }
+}
+
+void PageCache::enqueue_dirty(Page* page, bool wake_writer) {
+  if (page->queued.exchange(true)) {
+    return;
+  }
+  bool wakeup = false;
+  {
+    std::lock_guard<std::mutex> lock(dirty_mutex_);
+    dirty_frames_.push_back(page->frame);
+    if (wake_writer && writer_options_.enabled && !writer_wakeup_ &&
+        dirty_frames_.size() >= dirty_wakeup_) {
+      writer_wakeup_ = true;
+      wakeup = true;
+    }
+  }
+  if (wakeup) {
+    writer_cv_.notify_one();
+  }
+}
+
+bool PageCache::write_dirty(size_t limit, bool force_wal, std::string* err) {
+  std::lock_guard<std::mutex> round(write_mutex_);
+  // 按入队顺序（最早变脏的先写）取出一批帧。
+  std::vector<int32_t> batch;
+  {
+    std::lock_guard<std::mutex> lock(dirty_mutex_);
+    size_t count = dirty_frames_.size();
+    if (limit > 0 && limit < count) {
+      count = limit;
+    }
+    batch.assign(dirty_frames_.begin(), dirty_frames_.begin() + static_cast<std::ptrdiff_t>(count));
+    dirty_frames_.erase(dirty_frames_.begin(),
+                        dirty_frames_.begin() + static_cast<std::ptrdiff_t>(count));
+  }
+  if (batch.empty()) {
+    return true;
+  }
+  // 在分片锁内钉住仍为脏的帧（帧可能已被淘汰写回或装入了其他页）。
+  // 先清除排队标记：之后再变脏的页会重新入队，不会丢失。
+  std::vector<Page*> pages;
+  pages.reserve(batch.size());
+  {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    for (int32_t frame : batch) {
+      Page& page = frames_[static_cast<size_t>(frame)];
+      page.queued.store(false);
+      if (page.dirty.load()) {
+        page.pin_count.fetch_add(1);
+        pages.push_back(&page);
+      }
+    }
+  }
+  if (!force_wal) {
+    // 后台写页不打断日志的组提交：日志尚未落盘的页重新排队，下一轮再写。
+    size_t kept = 0;
+    for (Page* page : pages) {
+      if (wal_durable(page->wal_gate, page->lsn.load())) {
+        pages[kept++] = page;
+      } else {
+        enqueue_dirty(page, false);
+        page->pin_count.fetch_sub(1);
       }
-      pair.second.page.dirty = false;
     }
+    pages.resize(kept);
   }
-  pager_->flush();
+  // 按页号排序后，连续页号合并为一次写出；逐页持共享闩，不会写出修改到一半的页。
+  // 按页号升序加闩。load_pages（预取、预热）会同时持有一批页的写闩，但只对在分片独占锁下取得的
+  // 未钉住帧加闩：帧未钉住时页闩必然空闲，它从不等待；而这里的页已被钉住，不会被它选中，因而不会死锁。
+  // TSan 会把两者报告为锁顺序反转（lock-order-inversion），属于这种不会等待的加锁顺序，非真实死锁。
+  std::sort(pages.begin(), pages.end(), [](const Page* a, const Page* b) { return a->id < b->id; });
+  bool ok = true;
+  size_t start = 0;
+  while (start < pages.size()) {
+    size_t end = start + 1;
+    while (end < pages.size() && end - start < kMaxWriteRun &&
+           pages[end]->id == pages[end - 1]->id + 1) {
+      ++end;
+    }
+    std::vector<Page*> run(pages.begin() + static_cast<std::ptrdiff_t>(start),
+                           pages.begin() + static_cast<std::ptrdiff_t>(end));
+    for (Page* page : run) {
+      page->latch.lock_shared();
+    }
+    if (ok && !write_run(run, err)) {
+      ok = false;
+    } else if (!ok) {
+      // 前面的写出已失败：剩余页重新入队，留给下一轮或检查点。
+      for (Page* page : run) {
+        enqueue_dirty(page, false);
+      }
+    }
+    for (Page* page : run) {
+      page->latch.unlock_shared();
+      page->pin_count.fetch_sub(1);
+    }
+    start = end;
+  }
+  return ok;
+}
+
+bool PageCache::write_run(const std::vector<Page*>& run, std::string* err) {
+  // 每个日志分区取本段页的最大 LSN（页帧迁移后同一分片中可能有多个分区的页）。
+  std::vector<uint64_t> max_lsn(wal_.size(), 0);
+  std::vector<const char*> data;
+  data.reserve(run.size());
+  for (Page* page : run) {
+    page->dirty.store(false);
+    if (static_cast<size_t>(page->wal_gate) < max_lsn.size()) {
+      uint64_t& lsn = max_lsn[static_cast<size_t>(page->wal_gate)];
+      lsn = std::max(lsn, page->lsn.load());
+    }
+    data.push_back(page->data);
+  }
+  // WAL：页中最新修改对应的日志必须先落盘。
+  bool ok = true;
+  for (size_t gate = 0; ok && gate < max_lsn.size(); ++gate) {
+    ok = flush_wal(static_cast<int>(gate), max_lsn[gate], err);
+  }
+  if (ok) {
+    ok = pager_->write_pages(run.front()->id, data, page_size_, err);
+  }
+  if (ok) {
+    pages_written_.add(run.size());
+  }
+  if (!ok) {
+    for (Page* page : run) {
+      page->dirty.store(true);
+      enqueue_dirty(page, false);
+    }
+  }
+  return ok;
+}
+
+void PageCache::writer_loop() {
+  if (is_numa_enabled()) {
+    // 写页线程与分片的帧内存位于同一节点。
+    std::string bind_err;
+    bind_thread_to_node(node_id_, &bind_err);
+  }
+  std::unique_lock<std::mutex> lock(dirty_mutex_);
+  while (!writer_stop_) {
+    writer_cv_.wait_for(lock, std::chrono::milliseconds(writer_options_.interval_ms),
+                        [this]() { return writer_stop_ || writer_wakeup_; });
+    if (writer_stop_) {
+      break;
+    }
+    writer_wakeup_ = false;
+    if (dirty_frames_.empty()) {
+      continue;
+    }
+    lock.unlock();
+    // 写出失败的页已重新入队，由下一轮或检查点重试并报告错误。
+    std::string write_err;
+    write_dirty(writer_options_.max_batch_pages, false, &write_err);
+    lock.lock();
+  }
+}
+
+bool PageCache::discard_clean(size_t page_id) {
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  int32_t frame = find_frame(page_id);
+  if (frame == kNoFrame) {
+    return true;
+  }
+  // 钉住计数只在分片锁内增加，独占锁下判定为未钉住的页不会被重新钉住。
+  Page& page = frames_[static_cast<size_t>(frame)];
+  if (page.pin_count.load() != 0 || page.dirty.load()) {
+    return false;
+  }
+  evict_frame(frame);
+  free_frames_.push_back(frame);
+  return true;
 }
 
 size_t PageCache::page_count() const {
-  std::lock_guard<std::mutex> lock(mutex_);
-  return pages_.size();
+  std::shared_lock<std::shared_mutex> lock(mutex_);
+  return used_;
+}
+
+size_t PageCache::capacity() const {
+  return capacity_;
+}
+
+void PageCache::set_limit(size_t pages) {
+  pages = std::max<size_t>(1, std::min(pages, capacity_));
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  limit_.store(pages);
+  // 只淘汰干净页，不在调整路径上写盘；脏页由写页线程写回后在之后的调整中回收。
+  while (used_ > pages) {
+    int32_t victim = pick_victim([this](int32_t candidate) {
+      const Page& page = frames_[static_cast<size_t>(candidate)];
+      return page.pin_count.load() == 0 && !page.dirty.load();
+    });
+    if (victim == kNoFrame) {
+      break;
+    }
+    evict_frame(victim);
+    arena_.discard(static_cast<size_t>(victim) * page_size_, page_size_);
+    free_frames_.push_back(victim);
+  }
+}
+
+size_t PageCache::limit() const {
+  return limit_.load();
+}
+
+CacheStats PageCache::stats() const {
+  CacheStats stats;
+  stats.hits = hits_.value();
+  stats.misses = misses_.value();
+  stats.evictions = evictions_.value();
+  stats.pages_written = pages_written_.value();
+  stats.sync_writes = sync_writes_.value();
+  stats.prefetched = prefetched_.value();
+  stats.pages = page_count();
+  stats.limit = limit_.load();
+  stats.capacity = capacity_;
+  return stats;
 }
 
 }  // namespace mini_db
@@ -57,8 +57,14 @@ std::string format_column_type(const Column& column) {
 Catalog::Catalog(const std::string& path) : path_(path) {}
 
 bool Catalog::load(std::string* err) {
-  // catalog 格式：table|col:type|col:type...
+  // catalog 格式：table#id|col:type|col:type...|@index:col[:unique][:btree]
+  // （旧格式没有 #id，加载时补分配）。
   schemas_.clear();
+  table_ids_.clear();
+  indexes_.clear();
+  next_table_id_ = 1;
+  needs_save_ = false;
+  std::vector<std::string> missing_ids;
   std::ifstream file(path_);
   if (!file.is_open()) {
     return true;
@@ -79,9 +85,79 @@ bool Catalog::load(std::string* err) {
       continue;
     }
     std::string table = to_lower(trim(parts[0]));
+    uint32_t table_id = 0;
+    size_t hash = table.find('#');
+    if (hash != std::string::npos) {
+      std::string id_text = trim(table.substr(hash + 1));
+      table = trim(table.substr(0, hash));
+      if (!is_number(id_text)) {
+        if (err) {
+          *err = "invalid table id in catalog: " + table;
+        }
+        return false;
+      }
+      table_id = static_cast<uint32_t>(std::stoul(id_text));
+    }
     std::vector<Column> columns;
+    std::vector<IndexDef> indexes;
+    TableLayout table_layout = TableLayout::Row;
+    bool compressed = false;
+    size_t stored_columns = 0;
     for (size_t i = 1; i < parts.size(); ++i) {
       std::string part = trim(parts[i]);
+      if (iequals(part, "!pax")) {
+        // 表选项：PAX 数据页布局。
+        table_layout = TableLayout::Pax;
+        continue;
+      }
+      if (iequals(part, "!slotted")) {
+        // 表选项：槽页布局。
+        table_layout = TableLayout::Slotted;
+        continue;
+      }
+      if (iequals(part, "!compressed")) {
+        // 表选项：按页压缩表数据文件。
+        compressed = true;
+        continue;
+      }
+      if (part.size() > 8 && iequals(part.substr(0, 8), "!stored=")) {
+        // 表选项：数据文件中的记录只含前 N 列（ADD COLUMN 只修改了元数据）。
+        std::string count_text = trim(part.substr(8));
+        if (!is_number(count_text)) {
+          if (err) {
+            *err = "invalid stored columns in catalog: " + table;
+          }
+          return false;
+        }
+        stored_columns = static_cast<size_t>(std::stoul(count_text));
+        continue;
+      }
+      if (!part.empty() && part[0] == '@') {
+        // 索引定义：@name:column[:unique][:btree]。
+        std::stringstream index_ss(part.substr(1));
+        std::vector<std::string> fields;
+        while (std::getline(index_ss, segment, ':')) {
+          fields.push_back(trim(segment));
+        }
+        if (fields.size() < 2 || fields[0].empty() || fields[1].empty()) {
+          if (err) {
+            *err = "invalid index in catalog: " + table;
+          }
+          return false;
+        }
+        IndexDef index;
+        index.name = to_lower(fields[0]);
+        index.column = fields[1];
+        for (size_t f = 2; f < fields.size(); ++f) {
+          if (iequals(fields[f], "unique")) {
+            index.unique = true;
+          } else if (iequals(fields[f], "btree")) {
+            index.kind = IndexKind::BTree;
+          }
+        }
+        indexes.push_back(index);
+        continue;
+      }
       size_t colon = part.find(':');
       if (colon == std::string::npos) {
         continue;
@@ -99,6 +175,25 @@ bool Catalog::load(std::string* err) {
       columns.push_back(col);
     }
     schemas_[table] = Schema(columns);
+    schemas_[table].set_table_layout(table_layout);
+    schemas_[table].set_compressed(compressed);
+    schemas_[table].set_stored_columns(stored_columns);
+    if (!indexes.empty()) {
+      indexes_[table] = std::move(indexes);
+    }
+    if (table_id == 0) {
+      missing_ids.push_back(table);
+    } else {
+      table_ids_[table] = table_id;
+      if (table_id >= next_table_id_) {
+        next_table_id_ = table_id + 1;
+      }
+    }
+  }
+  for (const auto& table : missing_ids) {
+    // 按文件中出现的顺序分配，保证结果确定。
+    table_ids_[table] = next_table_id_++;
+    needs_save_ = true;
   }
   return true;
 }
@@ -114,10 +209,37 @@ bool Catalog::save(std::string* err) const {
   }
   for (const auto& pair : schemas_) {
     file << pair.first;
+    auto id_it = table_ids_.find(pair.first);
+    if (id_it != table_ids_.end()) {
+      file << "#" << id_it->second;
+    }
     const auto& cols = pair.second.columns();
     for (const auto& col : cols) {
       file << "|" << col.name << ":" << format_column_type(col);
     }
+    if (pair.second.table_layout() == TableLayout::Pax) {
+      file << "|!pax";
+    } else if (pair.second.table_layout() == TableLayout::Slotted) {
+      file << "|!slotted";
+    }
+    if (pair.second.compressed()) {
+      file << "|!compressed";
+    }
+    if (pair.second.stored_columns() < cols.size()) {
+      file << "|!stored=" << pair.second.stored_columns();
+    }
+    auto index_it = indexes_.find(pair.first);
+    if (index_it != indexes_.end()) {
+      for (const auto& index : index_it->second) {
+        file << "|@" << index.name << ":" << index.column;
+        if (index.unique) {
+          file << ":unique";
+        }
+        if (index.kind == IndexKind::BTree) {
+          file << ":btree";
+        }
+      }
+    }
     file << "\n";
   }
   return true;
@@ -132,6 +254,7 @@ bool Catalog::create_table(const std::string& name, const Schema& schema, std::s
     return false;
   }
   schemas_[key] = schema;
+  table_ids_[key] = next_table_id_++;
   return save(err);
 }
 
@@ -143,10 +266,14 @@ bool Catalog::drop_table(const std::string& name, std::string* err) {
     }
     return false;
   }
+  // 删除前 Database 已做检查点，日志中不会残留该 ID 的记录。
+  table_ids_.erase(key);
+  indexes_.erase(key);
   return save(err);
 }
 
-bool Catalog::alter_add_column(const std::string& name, const Column& column, std::string* err) {
+bool Catalog::alter_add_column(const std::string& name, const Column& column,
+                               size_t stored_columns, std::string* err) {
   std::string key = to_lower(name);
   auto it = schemas_.find(key);
   if (it == schemas_.end()) {
@@ -165,7 +292,12 @@ bool Catalog::alter_add_column(const std::string& name, const Column& column, st
     }
   }
   cols.push_back(column);
+  TableLayout table_layout = it->second.table_layout();
+  bool compressed = it->second.compressed();
   it->second = Schema(cols);
+  it->second.set_table_layout(table_layout);
+  it->second.set_compressed(compressed);
+  it->second.set_stored_columns(stored_columns);
   return save(err);
 }
 
@@ -188,4 +320,62 @@ std::vector<std::string> Catalog::list_tables() const {
   return tables;
 }
 
+bool Catalog::create_index(const std::string& table, const IndexDef& index, std::string* err) {
+  std::string key = to_lower(table);
+  if (schemas_.find(key) == schemas_.end()) {
+    if (err) {
+      *err = "table not found: " + table;
+    }
+    return false;
+  }
+  auto& indexes = indexes_[key];
+  for (const auto& existing : indexes) {
+    if (existing.name == index.name) {
+      if (err) {
+        *err = "index already exists: " + index.name;
+      }
+      return false;
+    }
+  }
+  indexes.push_back(index);
+  return save(err);
+}
+
+bool Catalog::drop_index(const std::string& table, const std::string& index, std::string* err) {
+  auto it = indexes_.find(to_lower(table));
+  if (it != indexes_.end()) {
+    for (auto index_it = it->second.begin(); index_it != it->second.end(); ++index_it) {
+      if (index_it->name == index) {
+        it->second.erase(index_it);
+        return save(err);
+      }
+    }
+  }
+  if (err) {
+    *err = "index not found: " + index;
+  }
+  return false;
+}
+
+std::vector<IndexDef> Catalog::get_indexes(const std::string& table) const {
+  auto it = indexes_.find(to_lower(table));
+  if (it == indexes_.end()) {
+    return {};
+  }
+  return it->second;
+}
+
+bool Catalog::get_table_id(const std::string& name, uint32_t* table_id) const {
+  auto it = table_ids_.find(to_lower(name));
+  if (it == table_ids_.end() || !table_id) {
+    return false;
+  }
+  *table_id = it->second;
+  return true;
+}
+
+bool Catalog::needs_save() const {
+  return needs_save_;
+}
+
 }  // namespace mini_db
@@ -0,0 +1,102 @@
+#include "db/Checkpointer.h"
+
+#include <chrono>
+
+namespace mini_db {
+
+Checkpointer::Checkpointer(LogManager* log, const CheckpointOptions& options, CheckpointFn run)
+    : log_(log), options_(options), run_(std::move(run)) {}
+
+Checkpointer::~Checkpointer() {
+  stop();
+}
+
+void Checkpointer::start() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (running_) {
+    return;
+  }
+  if (options_.interval_ms == 0 && options_.log_bytes_threshold == 0) {
+    // 两种触发条件都关闭时不启动线程，由调用方显式执行检查点。
+    return;
+  }
+  stop_ = false;
+  running_ = true;
+  thread_ = std::thread([this]() { run_loop(); });
+}
+
+void Checkpointer::stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!running_) {
+      return;
+    }
+    stop_ = true;
+  }
+  cv_.notify_all();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  running_ = false;
+}
+
+void Checkpointer::notify_write(int partition) {
+  if (options_.log_bytes_threshold == 0 || !log_) {
+    return;
+  }
+  // 阈值按分区均分，任一分区超过份额即触发，避免前台汇总其他节点的计数。
+  size_t share = options_.log_bytes_threshold / static_cast<size_t>(log_->partition_count());
+  if (log_->size_bytes(partition) < share) {
+    return;
+  }
+  // 只有第一个发现超限的线程负责唤醒，避免大量 notify。
+  if (requested_.exchange(true)) {
+    return;
+  }
+  cv_.notify_one();
+}
+
+std::vector<uint64_t> Checkpointer::last_checkpoint_lsns() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return last_lsns_;
+}
+
+std::string Checkpointer::last_error() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return last_error_;
+}
+
+void Checkpointer::run_loop() {
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      auto ready = [this]() { return stop_ || requested_.load(); };
+      if (options_.interval_ms > 0) {
+        cv_.wait_for(lock, std::chrono::milliseconds(options_.interval_ms), ready);
+      } else {
+        cv_.wait(lock, ready);
+      }
+      if (stop_) {
+        return;
+      }
+    }
+    requested_.store(false);
+    if (log_ && log_->size_bytes() == 0) {
+      // 自上次检查点以来没有新日志，跳过本轮。
+      continue;
+    }
+    std::vector<uint64_t> lsns;
+    std::string err;
+    bool ok = run_ && run_(&lsns, &err);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (ok) {
+      last_lsns_ = std::move(lsns);
+      last_error_.clear();
+    } else {
+      last_error_ = err.empty() ? "checkpoint failed" : err;
+    }
+  }
+}
+
+}  // namespace mini_db
@@ -1,15 +1,51 @@
 #include "db/Database.h"
 
+#include "db/Numa.h"
+#include "db/NumaExecutor.h"
+#include "db/NumaThread.h"
+#include "db/Trace.h"
 #include "db/Utils.h"
 
+#include <algorithm>
 #include <cerrno>
 #include <cstdio>
+#include <fstream>
+#include <future>
+#include <map>
+#include <sstream>
 #include <sys/stat.h>
+#include <thread>
+#include <unordered_set>
 
 namespace mini_db {
 
 namespace {
 
+// 只修改元数据的 ADD COLUMN 最多留在追加列文件中的列数：每个追加列在读取时多一次列文件访问，
+// 超过后的 ADD COLUMN 重建表文件，把追加列并回记录。
+constexpr size_t kMaxAddedColumns = 8;
+
+// 输出一行统计：name{labels} value。
+template <typename T>
+void put_metric(std::ostringstream* out, const std::string& name, const std::string& labels,
+                T value) {
+  *out << name;
+  if (!labels.empty()) {
+    *out << "{" << labels << "}";
+  }
+  *out << " " << value << "\n";
+}
+
+// 输出延迟直方图：p50 / p99 分位数（所在桶上界）、样本数与总和，单位微秒。
+void put_histogram(std::ostringstream* out, const std::string& name, const std::string& labels,
+                   const HistogramSnapshot& histogram) {
+  std::string prefix = labels.empty() ? "" : labels + ",";
+  put_metric(out, name, prefix + "quantile=\"0.5\"", histogram.percentile_ns(0.5) / 1000.0);
+  put_metric(out, name, prefix + "quantile=\"0.99\"", histogram.percentile_ns(0.99) / 1000.0);
+  put_metric(out, name + "_count", labels, histogram.count);
+  put_metric(out, name + "_sum", labels, histogram.sum_ns / 1000.0);
+}
+
 // 递归创建目录（支持简单路径如 ./data 或 data/sub）。
 bool ensure_dir(const std::string& path, std::string* err) {
   if (path.empty()) {
@@ -47,6 +83,73 @@ bool ensure_dir(const std::string& path, std::string* err) {
   return true;
 }
 
+// 小端读写定长整数（提交记录与事务记录的数据部分）。
+void put_uint(std::vector<char>* out, uint64_t value, size_t bytes) {
+  for (size_t i = 0; i < bytes; ++i) {
+    out->push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+  }
+}
+
+uint64_t get_uint(const std::vector<char>& data, size_t offset, size_t bytes) {
+  uint64_t value = 0;
+  for (size_t i = 0; i < bytes; ++i) {
+    value |= static_cast<uint64_t>(static_cast<unsigned char>(data[offset + i])) << (8 * i);
+  }
+  return value;
+}
+
+// 把 COPY 文件中的一行按逗号拆成列值（统一为 TEXT，由 Schema 归一化为列类型）。
+// 双引号包住的字段原样保留（可含逗号，"" 表示一个引号），未加引号的字段去掉首尾空白。
+bool parse_copy_line(const std::string& line, std::vector<Value>* values, std::string* err) {
+  values->clear();
+  size_t i = 0;
+  while (true) {
+    std::string field;
+    while (i < line.size() && (line[i] == ' ' || line[i] == '\t')) {
+      ++i;
+    }
+    if (i < line.size() && line[i] == '"') {
+      ++i;
+      while (true) {
+        if (i >= line.size()) {
+          if (err) {
+            *err = "unterminated quoted field";
+          }
+          return false;
+        }
+        if (line[i] == '"') {
+          if (i + 1 < line.size() && line[i + 1] == '"') {
+            field.push_back('"');
+            i += 2;
+            continue;
+          }
+          ++i;
+          break;
+        }
+        field.push_back(line[i++]);
+      }
+      while (i < line.size() && line[i] != ',') {
+        if (line[i] != ' ' && line[i] != '\t') {
+          if (err) {
+            *err = "unexpected character after quoted field";
+          }
+          return false;
+        }
+        ++i;
+      }
+    } else {
+      size_t end = line.find(',', i);
+      field = trim(line.substr(i, end == std::string::npos ? std::string::npos : end - i));
+      i = end == std::string::npos ? line.size() : end;
+    }
+    values->push_back(Value::Text(field));
+    if (i >= line.size()) {
+      return true;
+    }
+    ++i;
+  }
+}
+
 // 检查列名是否重复，避免 schema 冲突。
 bool has_duplicate_columns(const std::vector<Column>& columns, std::string* err) {
   std::unordered_map<std::string, bool> seen;
@@ -69,18 +172,60 @@ bool has_duplicate_columns(const std::vector<Column>& columns, std::string* err)
   return false;
 }
 
+// 日志分区数与缓冲池的 NUMA 节点数一致，使页所属节点与日志分区一一对应。
+int log_partition_count(int numa_nodes) {
+  auto topology = create_numa_topology(numa_nodes);
+  int nodes = topology ? topology->node_count() : 1;
+  return nodes > 0 ? nodes : 1;
+}
+
 }  // namespace
 
 Database::Database(const std::string& base_dir, size_t page_size, size_t cache_pages,
                    int numa_nodes)
+    : Database(base_dir, page_size, cache_pages, numa_nodes, DatabaseOptions{}) {}
+
+Database::Database(const std::string& base_dir, size_t page_size, size_t cache_pages,
+                   int numa_nodes, const DatabaseOptions& options)
     : base_dir_(base_dir),
       page_size_(page_size),
       cache_pages_(cache_pages),
       numa_nodes_(numa_nodes),
+      options_(options),
       catalog_(base_dir + "/catalog.meta"),
-      log_(base_dir + "/db.log") {}
+      log_(base_dir + "/db.log", log_partition_count(numa_nodes), options.log),
+      checkpointer_(&log_, options.checkpoint, [this](std::vector<uint64_t>* lsns, std::string* err) {
+        return run_checkpoint(lsns, err);
+      }) {
+  if (options_.scan.parallel) {
+    int nodes = numa_nodes_ > 0 ? numa_nodes_ : 1;
+    int threads = options_.scan.threads_per_node;
+    if (threads <= 0) {
+      threads = static_cast<int>(std::thread::hardware_concurrency()) / nodes;
+    }
+    scan_executor_ = std::make_unique<NumaExecutor>(nodes, std::max(threads, 1));
+  }
+  if (options_.buffer.shared && !options_.read_only.enabled) {
+    buffer_manager_ = std::make_unique<BufferManager>(cache_pages_, options_.buffer);
+  }
+}
+
+Database::~Database() {
+  // 析构前必须停止后台线程，避免其访问已释放的表对象。
+  checkpointer_.stop();
+  stop_warmup();
+  if (scan_executor_) {
+    scan_executor_->stop();
+  }
+  if (buffer_manager_) {
+    buffer_manager_->stop();
+  }
+}
 
 bool Database::open(std::string* err) {
+  if (options_.read_only.enabled) {
+    return open_read_only(err);
+  }
   // 打开数据库：创建目录 -> 读取 catalog -> 加载表 -> 日志恢复。
   if (!ensure_dir(base_dir_, err)) {
     return false;
@@ -88,19 +233,222 @@ bool Database::open(std::string* err) {
   if (!catalog_.load(err)) {
     return false;
   }
+  if (catalog_.needs_save() && !catalog_.save(err)) {
+    // 旧格式 catalog 补分配了表 ID，写回后日志才能引用它们。
+    return false;
+  }
+  if (!load_tables(err)) {
+    return false;
+  }
+  if (!recover(err)) {
+    return false;
+  }
+  if (scan_executor_) {
+    scan_executor_->start();
+  }
+  if (buffer_manager_) {
+    buffer_manager_->start();
+  }
+  if (options_.warmup.enabled) {
+    start_warmup();
+  }
+  checkpointer_.start();
+  return true;
+}
+
+bool Database::open_read_only(std::string* err) {
+  // 只读打开：不创建目录、不写 catalog、不重放也不清理日志，不启动后台检查点。
+  struct stat st;
+  if (::stat(base_dir_.c_str(), &st) != 0 || !S_ISDIR(st.st_mode)) {
+    if (err) {
+      *err = "data directory not found: " + base_dir_;
+    }
+    return false;
+  }
+  if (!catalog_.load(err)) {
+    return false;
+  }
   if (!load_tables(err)) {
     return false;
   }
-  return recover(err);
+  // 表文件只反映最近一次检查点；日志中仍有未应用的修改时拒绝打开，避免读到过期数据。
+  auto reject_records = [this](const LogEntry& entry, std::string* visit_err) {
+    if (entry.op == LogOp::Checkpoint) {
+      return true;
+    }
+    if (visit_err) {
+      *visit_err = "log has unapplied records; open " + base_dir_ +
+                   " read-write once to recover before opening it read-only";
+    }
+    return false;
+  };
+  if (!log_.replay_legacy(reject_records, err)) {
+    return false;
+  }
+  for (int i = 0; i < log_.partition_count(); ++i) {
+    if (!log_.replay(i, reject_records, err)) {
+      return false;
+    }
+  }
+  if (scan_executor_) {
+    scan_executor_->start();
+  }
+  return true;
+}
+
+bool Database::check_writable(std::string* err) const {
+  if (options_.read_only.enabled) {
+    if (err) {
+      *err = "database is opened read-only";
+    }
+    return false;
+  }
+  return true;
 }
 
 void Database::close(std::string* err) {
-  // 关闭时执行检查点，清理日志。
+  // 关闭时先停止后台线程，再执行最终检查点，清理日志；只读打开没有需要落盘的内容。
+  checkpointer_.stop();
+  stop_warmup();
+  if (scan_executor_) {
+    // 执行器停止后扫描退回调用线程串行执行。
+    scan_executor_->stop();
+  }
+  if (buffer_manager_) {
+    buffer_manager_->stop();
+  }
+  if (options_.read_only.enabled) {
+    return;
+  }
+  if (options_.warmup.enabled) {
+    // 检查点只写回脏页、不淘汰，先后不影响保存的页集合。
+    save_warmup();
+  }
   checkpoint(err);
+  log_.close();
+}
+
+void Database::save_warmup() {
+  std::vector<WarmupEntry> entries;
+  {
+    std::shared_lock<std::shared_mutex> tables_lock(tables_mutex_);
+    for (const auto& pair : tables_) {
+      std::vector<std::vector<size_t>> shards = pair.second->resident_pages();
+      for (size_t shard = 0; shard < shards.size(); ++shard) {
+        if (shards[shard].empty()) {
+          continue;
+        }
+        WarmupEntry entry;
+        entry.table = pair.first;
+        entry.shard = static_cast<uint32_t>(shard);
+        entry.pages = std::move(shards[shard]);
+        entries.push_back(std::move(entry));
+      }
+    }
+  }
+  save_warmup_list(base_dir_ + "/warmup.dat", entries, nullptr);
+}
+
+void Database::start_warmup() {
+  std::vector<WarmupEntry> entries;
+  if (!load_warmup_list(base_dir_ + "/warmup.dat", &entries, nullptr) || entries.empty()) {
+    return;
+  }
+  // 同一表各分片的页合并后交给每个节点的线程，由缓冲池按页帧所在节点筛选：
+  // 节点数或页分布策略与保存时不同也能装回。
+  std::map<std::string, std::vector<size_t>> pages_by_table;
+  for (auto& entry : entries) {
+    auto& pages = pages_by_table[entry.table];
+    pages.insert(pages.end(), entry.pages.begin(), entry.pages.end());
+  }
+  std::vector<std::pair<std::string, std::vector<size_t>>> tables;
+  size_t nodes = 1;
+  {
+    std::shared_lock<std::shared_mutex> tables_lock(tables_mutex_);
+    for (auto& pair : pages_by_table) {
+      auto it = tables_.find(pair.first);
+      if (it == tables_.end()) {
+        continue;
+      }
+      nodes = std::max(nodes, it->second->cached_pages_per_node().size());
+      std::sort(pair.second.begin(), pair.second.end());
+      pair.second.erase(std::unique(pair.second.begin(), pair.second.end()), pair.second.end());
+      tables.emplace_back(pair.first, std::move(pair.second));
+    }
+  }
+  if (tables.empty()) {
+    return;
+  }
+  warmup_stop_.store(false);
+  for (size_t node = 0; node < nodes; ++node) {
+    warmup_threads_.emplace_back(
+        [this, node, tables]() { warm_node(static_cast<int>(node), tables); });
+  }
+  if (options_.warmup.wait) {
+    for (auto& thread : warmup_threads_) {
+      thread.join();
+    }
+    warmup_threads_.clear();
+  }
+}
+
+void Database::stop_warmup() {
+  warmup_stop_.store(true);
+  for (auto& thread : warmup_threads_) {
+    if (thread.joinable()) {
+      thread.join();
+    }
+  }
+  warmup_threads_.clear();
+}
+
+void Database::warm_node(int node,
+                         const std::vector<std::pair<std::string, std::vector<size_t>>>& tables) {
+  // 绑定到节点后读取，页帧内存已在分片所属节点上，读入的拷贝也由本节点 CPU 完成。
+  bind_thread_to_node(node, nullptr);
+  for (const auto& table : tables) {
+    const std::vector<size_t>& pages = table.second;
+    for (size_t pos = 0; pos < pages.size(); pos += kWarmupBatchPages) {
+      if (warmup_stop_.load()) {
+        return;
+      }
+      size_t end = std::min(pages.size(), pos + kWarmupBatchPages);
+      std::vector<size_t> batch(pages.begin() + static_cast<std::ptrdiff_t>(pos),
+                                pages.begin() + static_cast<std::ptrdiff_t>(end));
+      bool full = false;
+      {
+        // 持映射共享锁完成本批：DROP TABLE 等到本批结束才移除表对象。
+        std::shared_lock<std::shared_mutex> tables_lock(tables_mutex_);
+        auto it = tables_.find(table.first);
+        if (it == tables_.end()) {
+          break;
+        }
+        it->second->warm(node, batch, &full);
+      }
+      if (full) {
+        break;
+      }
+    }
+  }
+}
+
+bool Database::checkpoint(std::string* err) {
+  if (options_.read_only.enabled) {
+    return true;
+  }
+  return run_checkpoint(nullptr, err);
 }
 
 bool Database::create_table(const std::string& name, const std::vector<Column>& columns,
                             std::string* err) {
+  return create_table(name, columns, TableOptions{}, err);
+}
+
+bool Database::create_table(const std::string& name, const std::vector<Column>& columns,
+                            const TableOptions& options, std::string* err) {
+  if (!check_writable(err)) {
+    return false;
+  }
   // 基础校验：列不能为空、列名不重复。
   if (columns.empty()) {
     if (err) {
@@ -112,40 +460,86 @@ bool Database::create_table(const std::string& name, const std::vector<Column>&
     return false;
   }
   Schema schema(columns);
+  schema.set_table_layout(options.layout);
+  schema.set_compressed(options.compressed);
+  // DDL 与后台检查点互斥，避免检查点遍历 tables_ 时被修改。
+  std::lock_guard<std::mutex> lock(checkpoint_mutex_);
   if (!catalog_.create_table(name, schema, err)) {
     return false;
   }
   // 创建并加载表文件。
   std::string key = to_lower(name);
-  auto table = std::make_unique<TableStorage>(table_path(key), key, schema, page_size_,
-                                              cache_pages_, numa_nodes_, &log_);
+  uint32_t table_id = 0;
+  catalog_.get_table_id(key, &table_id);
+  auto table = std::make_unique<TableStorage>(table_path(key), key, table_id, schema, page_size_,
+                                              cache_pages_, numa_nodes_, table_cache(key),
+                                              &log_, options_.read_only);
+  table->set_scan_executor(scan_executor_.get(), options_.scan);
+  table->set_buffer_manager(buffer_manager_.get());
   if (!table->load(err)) {
     return false;
   }
-  tables_[key] = std::move(table);
+  {
+    std::unique_lock<std::shared_mutex> tables_lock(tables_mutex_);
+    tables_[key] = std::move(table);
+  }
+  schema_version_.fetch_add(1);
   return true;
 }
 
 bool Database::drop_table(const std::string& name, std::string* err) {
-  // 先删除 catalog 元数据，再删除表文件。
+  if (!check_writable(err)) {
+    return false;
+  }
+  // 先做检查点（日志中不再残留该表记录），再删除 catalog 元数据与表文件。
   std::string key = to_lower(name);
+  std::lock_guard<std::mutex> lock(checkpoint_mutex_);
+  TableStorage* storage = get_table(key);
+  if (storage && storage->has_row_locks()) {
+    // 未提交事务仍引用该表的存储对象。
+    if (err) {
+      *err = "table has uncommitted transaction writes: " + name;
+    }
+    return false;
+  }
+  if (!checkpoint_locked(nullptr, err)) {
+    return false;
+  }
   if (!catalog_.drop_table(key, err)) {
     return false;
   }
-  auto it = tables_.find(key);
-  if (it != tables_.end()) {
-    tables_.erase(it);
+  // 空闲页映射、溢出页文件、压缩页映射与索引快照随表一起删除，避免同名新表误用。
+  std::vector<std::string> files = {table_path(key), table_path(key) + ".fsm",
+                                    table_path(key) + ".ovf", table_path(key) + ".pmap",
+                                    table_path(key) + ".ovf.pmap"};
+  std::unique_ptr<TableStorage> dropped;
+  {
+    std::unique_lock<std::shared_mutex> tables_lock(tables_mutex_);
+    auto it = tables_.find(key);
+    if (it != tables_.end()) {
+      files = it->second->data_files();
+      dropped = std::move(it->second);
+      tables_.erase(it);
+    }
   }
-  if (std::remove(table_path(key).c_str()) != 0 && errno != ENOENT) {
-    if (err) {
-      *err = "failed to remove table file";
+  // 表对象在映射锁之外析构（关闭文件、刷新缓存），不阻塞其他表的查找。
+  dropped.reset();
+  schema_version_.fetch_add(1);
+  for (const auto& file : files) {
+    if (std::remove(file.c_str()) != 0 && errno != ENOENT) {
+      if (err) {
+        *err = "failed to remove table file: " + file;
+      }
+      return false;
     }
-    return false;
   }
   return true;
 }
 
 bool Database::alter_add_column(const std::string& name, const Column& column, std::string* err) {
+  if (!check_writable(err)) {
+    return false;
+  }
   // ALTER TABLE 需要先读取旧 schema，再做迁移。
   std::string key = to_lower(name);
   Schema schema;
@@ -166,8 +560,15 @@ bool Database::alter_add_column(const std::string& name, const Column& column, s
   }
   cols.push_back(column);
   Schema new_schema(cols);
+  new_schema.set_table_layout(schema.table_layout());
+  new_schema.set_compressed(schema.compressed());
+  if (new_schema.table_layout() != TableLayout::Slotted && new_schema.record_size() > page_size_) {
+    if (err) {
+      *err = "record size exceeds page size";
+    }
+    return false;
+  }
 
-  // 重建表文件以应用新结构。
   TableStorage* table = get_table(key);
   if (!table) {
     if (err) {
@@ -175,61 +576,86 @@ bool Database::alter_add_column(const std::string& name, const Column& column, s
     }
     return false;
   }
+  std::lock_guard<std::mutex> lock(checkpoint_mutex_);
+  if (cols.size() - schema.stored_columns() <= kMaxAddedColumns) {
+    // 只修改元数据：已有记录不改写，新列存放在追加列文件中，未写过的行读出默认值（见 AddedColumns）。
+    // 日志中旧结构的记录在重放时按长度识别并补齐，无需检查点；缓存中的数据页保持不变。
+    new_schema.set_stored_columns(schema.stored_columns());
+    auto table_lock = table->exclusive_lock();
+    // 暂存写入按当前结构编码，有未提交事务时拒绝。
+    if (table->has_row_locks()) {
+      if (err) {
+        *err = "table has uncommitted transaction writes: " + name;
+      }
+      return false;
+    }
+    if (!catalog_.alter_add_column(key, column, new_schema.stored_columns(), err)) {
+      return false;
+    }
+    table->add_column_locked(new_schema);
+    schema_version_.fetch_add(1);
+    return true;
+  }
+  // 追加列过多时重建表文件，把追加列并回记录；先做检查点清空日志。
+  if (!checkpoint_locked(nullptr, err)) {
+    return false;
+  }
   if (!table->rebuild_for_schema(new_schema, err)) {
     return false;
   }
-  return catalog_.alter_add_column(key, column, err);
+  schema_version_.fetch_add(1);
+  return catalog_.alter_add_column(key, column, new_schema.stored_columns(), err);
 }
 
-bool Database::insert(const std::string& table, const std::vector<Value>& values, uint64_t* row_id,
-                      std::string* err) {
-  // 插入后进行检查点，简化恢复逻辑。
-  TableStorage* storage = get_table(table);
+bool Database::create_index(const std::string& table, const IndexDef& index, std::string* err) {
+  if (!check_writable(err)) {
+    return false;
+  }
+  std::string key = to_lower(table);
+  TableStorage* storage = get_table(key);
   if (!storage) {
     if (err) {
       *err = "table not found: " + table;
     }
     return false;
   }
-  if (!storage->insert(values, row_id, err)) {
+  // 与检查点互斥：检查点会写出索引快照。
+  std::lock_guard<std::mutex> lock(checkpoint_mutex_);
+  if (!storage->create_index(index, err)) {
     return false;
   }
-  checkpoint(err);
-  return err ? err->empty() : true;
-}
-
-bool Database::select(const std::string& table, const Condition& where,
-                      std::vector<std::vector<Value>>* rows, std::string* err) {
-  TableStorage* storage = get_table(table);
-  if (!storage) {
-    if (err) {
-      *err = "table not found: " + table;
-    }
+  if (!catalog_.create_index(key, index, err)) {
+    storage->drop_index(index.name, nullptr);
     return false;
   }
-  return storage->select(where, rows, err);
+  return true;
 }
 
-bool Database::update(const std::string& table, const std::vector<SetClause>& sets,
-                      const Condition& where, size_t* updated, std::string* err) {
-  // 更新后进行检查点。
-  TableStorage* storage = get_table(table);
+bool Database::drop_index(const std::string& table, const std::string& index, std::string* err) {
+  if (!check_writable(err)) {
+    return false;
+  }
+  std::string key = to_lower(table);
+  TableStorage* storage = get_table(key);
   if (!storage) {
     if (err) {
       *err = "table not found: " + table;
     }
     return false;
   }
-  if (!storage->update(sets, where, updated, err)) {
+  std::lock_guard<std::mutex> lock(checkpoint_mutex_);
+  if (!catalog_.drop_index(key, index, err)) {
     return false;
   }
-  checkpoint(err);
-  return err ? err->empty() : true;
+  return storage->drop_index(index, err);
 }
 
-bool Database::remove(const std::string& table, const Condition& where, size_t* removed,
+bool Database::insert(const std::string& table, const std::vector<Value>& values, uint64_t* row_id,
                       std::string* err) {
-  // 删除后进行检查点。
+  if (!check_writable(err)) {
+    return false;
+  }
+  // 插入只需日志写入成功即可返回，刷盘交给后台检查点。
   TableStorage* storage = get_table(table);
   if (!storage) {
     if (err) {
@@ -237,15 +663,15 @@ bool Database::remove(const std::string& table, const Condition& where, size_t*
     }
     return false;
   }
-  if (!storage->remove(where, removed, err)) {
+  if (!storage->insert(values, row_id, err)) {
     return false;
   }
-  checkpoint(err);
-  return err ? err->empty() : true;
+  checkpointer_.notify_write(storage->log_partition_for_row(*row_id));
+  return true;
 }
 
-bool Database::read_row(const std::string& table, uint64_t row_id, std::vector<Value>* values,
-                        bool* valid, std::string* err) {
+bool Database::select(const std::string& table, const Condition& where,
+                      std::vector<std::vector<Value>>* rows, std::string* err) {
   TableStorage* storage = get_table(table);
   if (!storage) {
     if (err) {
@@ -253,11 +679,14 @@ bool Database::read_row(const std::string& table, uint64_t row_id, std::vector<V
     }
     return false;
   }
-  return storage->read_row(row_id, values, valid, err);
+  return storage->select(where, rows, err);
 }
 
-bool Database::update_row(const std::string& table, uint64_t row_id,
-                          const std::vector<SetClause>& sets, std::string* err) {
+bool Database::update(const std::string& table, const std::vector<SetClause>& sets,
+                      const Condition& where, size_t* updated, std::string* err) {
+  if (!check_writable(err)) {
+    return false;
+  }
   TableStorage* storage = get_table(table);
   if (!storage) {
     if (err) {
@@ -265,14 +694,18 @@ bool Database::update_row(const std::string& table, uint64_t row_id,
     }
     return false;
   }
-  if (!storage->update_row(row_id, sets, err)) {
+  if (!storage->update(sets, where, updated, err)) {
     return false;
   }
-  checkpoint(err);
-  return err ? err->empty() : true;
+  notify_all_partitions();
+  return true;
 }
 
-bool Database::delete_row(const std::string& table, uint64_t row_id, std::string* err) {
+bool Database::remove(const std::string& table, const Condition& where, size_t* removed,
+                      std::string* err) {
+  if (!check_writable(err)) {
+    return false;
+  }
   TableStorage* storage = get_table(table);
   if (!storage) {
     if (err) {
@@ -280,15 +713,18 @@ bool Database::delete_row(const std::string& table, uint64_t row_id, std::string
     }
     return false;
   }
-  if (!storage->delete_row(row_id, err)) {
+  if (!storage->remove(where, removed, err)) {
     return false;
   }
-  checkpoint(err);
-  return err ? err->empty() : true;
+  notify_all_partitions();
+  return true;
 }
 
-bool Database::write_row(const std::string& table, uint64_t row_id,
-                         const std::vector<Value>& values, bool valid, std::string* err) {
+bool Database::bulk_insert(const std::string& table, const std::vector<std::vector<Value>>& rows,
+                           size_t* inserted, std::string* err) {
+  if (!check_writable(err)) {
+    return false;
+  }
   TableStorage* storage = get_table(table);
   if (!storage) {
     if (err) {
@@ -296,41 +732,496 @@ bool Database::write_row(const std::string& table, uint64_t row_id,
     }
     return false;
   }
-  if (!storage->write_row(row_id, values, valid, err)) {
+  if (!storage->bulk_insert(rows, nullptr, err)) {
     return false;
   }
-  checkpoint(err);
-  return err ? err->empty() : true;
-}
-
-bool Database::get_schema(const std::string& table, Schema* schema, std::string* err) const {
-  if (!catalog_.get_schema(table, schema)) {
-    if (err) {
-      *err = "table not found: " + table;
-    }
-    return false;
+  if (inserted) {
+    *inserted = rows.size();
   }
+  notify_all_partitions();
   return true;
 }
 
-std::vector<std::string> Database::list_tables() const {
-  return catalog_.list_tables();
+bool Database::copy_from(const std::string& table, const std::string& path, size_t* loaded,
+                         std::string* err) {
+  return copy_rows(nullptr, table, path, loaded, err);
 }
 
-size_t Database::page_size() const {
-  return page_size_;
+std::unique_ptr<Transaction> Database::begin(std::string* err) {
+  if (!check_writable(err)) {
+    return nullptr;
+  }
+  return std::make_unique<Transaction>(next_txn_id_.fetch_add(1));
 }
 
-std::vector<size_t> Database::cached_pages_per_node() const {
-  size_t nodes = numa_nodes_ > 0 ? static_cast<size_t>(numa_nodes_) : 1;
-  std::vector<size_t> totals(nodes, 0);
-  for (const auto& pair : tables_) {
-    const auto& storage = pair.second;
-    if (!storage) {
-      continue;
+bool Database::commit(Transaction* txn, std::string* err) {
+  if (!txn) {
+    if (err) {
+      *err = "no transaction in progress";
     }
-    std::vector<size_t> per_table = storage->cached_pages_per_node();
-    if (per_table.size() > totals.size()) {
+    return false;
+  }
+  if (txn->staged_rows() == 0) {
+    // 只读事务：无需写日志。
+    txn->clear();
+    return true;
+  }
+  int partitions = log_.partition_count();
+  std::vector<uint64_t> lsns(static_cast<size_t>(partitions), 0);
+  bool ok = true;
+  {
+    // 持有期间检查点不会切换日志段：日志已写、数据页未写回的事务不会被截断在归档段中。
+    std::shared_lock<std::shared_mutex> commit_lock(commit_mutex_);
+    for (auto& pair : txn->tables()) {
+      if (!pair.second.empty() && !pair.first->log_staged(txn->id(), &pair.second, &lsns, err)) {
+        txn->rollback();
+        return false;
+      }
+    }
+    // 唯一的提交记录写入最后一个涉及的分区，并记下每个分区最后一条 TxnRow 的 LSN：
+    // 恢复时这些分区都重放到对应位置才算提交，因此各分区可以同时刷盘。
+    std::vector<char> parts;
+    int commit_partition = 0;
+    for (int i = 0; i < partitions; ++i) {
+      if (lsns[static_cast<size_t>(i)] != 0) {
+        put_uint(&parts, static_cast<uint64_t>(i), 4);
+        put_uint(&parts, lsns[static_cast<size_t>(i)], 8);
+        commit_partition = i;
+      }
+    }
+    if (!log_.append(commit_partition, LogOp::Commit, 0, txn->id(), parts,
+                     &lsns[static_cast<size_t>(commit_partition)], err)) {
+      txn->rollback();
+      return false;
+    }
+    // 每个涉及的分区只等待一次落盘。提交记录落盘之前数据页不能写回，异步模式下同样等待。
+    for (int i = 0; i < partitions; ++i) {
+      uint64_t lsn = lsns[static_cast<size_t>(i)];
+      if (lsn == 0) {
+        continue;
+      }
+      bool durable = log_.commit_mode() == CommitMode::Async ? log_.flush_to(i, lsn, err)
+                                                             : log_.wait_durable(i, lsn, err);
+      if (!durable) {
+        txn->rollback();
+        return false;
+      }
+    }
+    for (auto& pair : txn->tables()) {
+      std::string apply_err;
+      if (!pair.second.empty() && !pair.first->apply_staged(txn->id(), &pair.second, &apply_err) && ok) {
+        ok = false;
+        if (err) {
+          *err = apply_err;
+        }
+      }
+    }
+  }
+  txn->clear();
+  for (int i = 0; i < partitions; ++i) {
+    if (lsns[static_cast<size_t>(i)] != 0) {
+      checkpointer_.notify_write(i);
+    }
+  }
+  return ok;
+}
+
+void Database::rollback(Transaction* txn) {
+  if (txn) {
+    txn->rollback();
+  }
+}
+
+bool Database::insert(Transaction* txn, const std::string& table, const std::vector<Value>& values,
+                      uint64_t* row_id, std::string* err) {
+  if (!txn) {
+    return insert(table, values, row_id, err);
+  }
+  if (!check_writable(err)) {
+    return false;
+  }
+  TableStorage* storage = get_table(table);
+  if (!storage) {
+    if (err) {
+      *err = "table not found: " + table;
+    }
+    return false;
+  }
+  return storage->stage_insert(txn->id(), values, txn->staged(storage), row_id, err);
+}
+
+bool Database::bulk_insert(Transaction* txn, const std::string& table,
+                           const std::vector<std::vector<Value>>& rows, size_t* inserted,
+                           std::string* err) {
+  if (!txn) {
+    return bulk_insert(table, rows, inserted, err);
+  }
+  if (!check_writable(err)) {
+    return false;
+  }
+  TableStorage* storage = get_table(table);
+  if (!storage) {
+    if (err) {
+      *err = "table not found: " + table;
+    }
+    return false;
+  }
+  StagedRows statement_rows;
+  if (!stage_rows(txn, storage, rows, &statement_rows, err)) {
+    storage->discard_staged(txn->id(), &statement_rows);
+    return false;
+  }
+  txn->staged(storage)->merge(statement_rows);
+  if (inserted) {
+    *inserted = rows.size();
+  }
+  return true;
+}
+
+bool Database::copy_from(Transaction* txn, const std::string& table, const std::string& path,
+                         size_t* loaded, std::string* err) {
+  return copy_rows(txn, table, path, loaded, err);
+}
+
+bool Database::select(Transaction* txn, const std::string& table, const Condition& where,
+                      std::vector<std::vector<Value>>* rows, std::string* err) {
+  if (!txn) {
+    return select(table, where, rows, err);
+  }
+  TableStorage* storage = get_table(table);
+  if (!storage) {
+    if (err) {
+      *err = "table not found: " + table;
+    }
+    return false;
+  }
+  return storage->select(where, txn->find_staged(storage), rows, err);
+}
+
+bool Database::open_cursor(Transaction* txn, const std::string& table, const Condition& where,
+                           uint64_t limit, std::unique_ptr<TableCursor>* cursor,
+                           std::string* err) {
+  TableStorage* storage = get_table(table);
+  if (!storage) {
+    if (err) {
+      *err = "table not found: " + table;
+    }
+    return false;
+  }
+  const StagedRows* staged = txn ? txn->find_staged(storage) : nullptr;
+  return storage->open_cursor(where, staged, limit, cursor, err);
+}
+
+bool Database::update(Transaction* txn, const std::string& table,
+                      const std::vector<SetClause>& sets, const Condition& where, size_t* updated,
+                      std::string* err) {
+  if (!txn) {
+    return update(table, sets, where, updated, err);
+  }
+  if (!check_writable(err)) {
+    return false;
+  }
+  TableStorage* storage = get_table(table);
+  if (!storage) {
+    if (err) {
+      *err = "table not found: " + table;
+    }
+    return false;
+  }
+  return storage->stage_update(txn->id(), sets, where, txn->staged(storage), updated, err);
+}
+
+bool Database::remove(Transaction* txn, const std::string& table, const Condition& where,
+                      size_t* removed, std::string* err) {
+  if (!txn) {
+    return remove(table, where, removed, err);
+  }
+  if (!check_writable(err)) {
+    return false;
+  }
+  TableStorage* storage = get_table(table);
+  if (!storage) {
+    if (err) {
+      *err = "table not found: " + table;
+    }
+    return false;
+  }
+  return storage->stage_remove(txn->id(), where, txn->staged(storage), removed, err);
+}
+
+bool Database::bind_table(const std::string& table, Schema* schema, uint64_t* schema_epoch,
+                          std::string* err) {
+  TableStorage* storage = get_table(table);
+  if (!storage) {
+    if (err) {
+      *err = "table not found: " + table;
+    }
+    return false;
+  }
+  storage->bind_schema(schema, schema_epoch);
+  return true;
+}
+
+bool Database::insert(Transaction* txn, const std::string& table, const BoundDml& bound,
+                      uint64_t* row_id, bool* stale, std::string* err) {
+  if (!check_writable(err)) {
+    return false;
+  }
+  TableStorage* storage = get_table(table);
+  if (!storage) {
+    if (err) {
+      *err = "table not found: " + table;
+    }
+    return false;
+  }
+  if (txn) {
+    return storage->stage_insert(txn->id(), bound, 0, txn->staged(storage), row_id, stale, err);
+  }
+  if (!storage->insert(bound, row_id, stale, err)) {
+    return false;
+  }
+  checkpointer_.notify_write(storage->log_partition_for_row(*row_id));
+  return true;
+}
+
+bool Database::bulk_insert(Transaction* txn, const std::string& table, const BoundDml& bound,
+                           size_t* inserted, bool* stale, std::string* err) {
+  if (!check_writable(err)) {
+    return false;
+  }
+  TableStorage* storage = get_table(table);
+  if (!storage) {
+    if (err) {
+      *err = "table not found: " + table;
+    }
+    return false;
+  }
+  if (txn) {
+    // 同 bulk_insert(txn, ...)：逐行暂存，任一行失败时本语句暂存的行全部撤销。
+    StagedRows statement_rows;
+    for (size_t i = 0; i < bound.rows.size(); ++i) {
+      if (!storage->stage_insert(txn->id(), bound, i, &statement_rows, nullptr, stale, err)) {
+        storage->discard_staged(txn->id(), &statement_rows);
+        return false;
+      }
+    }
+    txn->staged(storage)->merge(statement_rows);
+  } else {
+    if (!storage->bulk_insert(bound, nullptr, stale, err)) {
+      return false;
+    }
+    notify_all_partitions();
+  }
+  if (inserted) {
+    *inserted = bound.rows.size();
+  }
+  return true;
+}
+
+bool Database::open_cursor(Transaction* txn, const std::string& table, const BoundDml& bound,
+                           uint64_t limit, std::unique_ptr<TableCursor>* cursor, bool* stale,
+                           std::string* err) {
+  TableStorage* storage = get_table(table);
+  if (!storage) {
+    if (err) {
+      *err = "table not found: " + table;
+    }
+    return false;
+  }
+  const StagedRows* staged = txn ? txn->find_staged(storage) : nullptr;
+  return storage->open_cursor(bound, staged, limit, cursor, stale, err);
+}
+
+bool Database::update(Transaction* txn, const std::string& table, const BoundDml& bound,
+                      size_t* updated, bool* stale, std::string* err) {
+  if (!check_writable(err)) {
+    return false;
+  }
+  TableStorage* storage = get_table(table);
+  if (!storage) {
+    if (err) {
+      *err = "table not found: " + table;
+    }
+    return false;
+  }
+  if (txn) {
+    return storage->stage_update(txn->id(), bound, txn->staged(storage), updated, stale, err);
+  }
+  if (!storage->update(bound, updated, stale, err)) {
+    return false;
+  }
+  notify_all_partitions();
+  return true;
+}
+
+bool Database::remove(Transaction* txn, const std::string& table, const BoundDml& bound,
+                      size_t* removed, bool* stale, std::string* err) {
+  if (!check_writable(err)) {
+    return false;
+  }
+  TableStorage* storage = get_table(table);
+  if (!storage) {
+    if (err) {
+      *err = "table not found: " + table;
+    }
+    return false;
+  }
+  if (txn) {
+    return storage->stage_remove(txn->id(), bound, txn->staged(storage), removed, stale, err);
+  }
+  if (!storage->remove(bound, removed, stale, err)) {
+    return false;
+  }
+  notify_all_partitions();
+  return true;
+}
+
+bool Database::read_row(const std::string& table, uint64_t row_id, std::vector<Value>* values,
+                        bool* valid, std::string* err) {
+  TableStorage* storage = get_table(table);
+  if (!storage) {
+    if (err) {
+      *err = "table not found: " + table;
+    }
+    return false;
+  }
+  return storage->read_row(row_id, values, valid, err);
+}
+
+bool Database::read_row(const std::string& table, uint64_t row_id,
+                        const std::function<void(const RecordView&)>& visit, std::string* err) {
+  TableStorage* storage = get_table(table);
+  if (!storage) {
+    if (err) {
+      *err = "table not found: " + table;
+    }
+    return false;
+  }
+  return storage->read_row(row_id, visit, err);
+}
+
+bool Database::update_row(const std::string& table, uint64_t row_id,
+                          const std::vector<SetClause>& sets, std::string* err) {
+  if (!check_writable(err)) {
+    return false;
+  }
+  TableStorage* storage = get_table(table);
+  if (!storage) {
+    if (err) {
+      *err = "table not found: " + table;
+    }
+    return false;
+  }
+  if (!storage->update_row(row_id, sets, err)) {
+    return false;
+  }
+  checkpointer_.notify_write(storage->log_partition_for_row(row_id));
+  return true;
+}
+
+bool Database::read_rows(const std::string& table, const std::vector<uint64_t>& row_ids,
+                         const std::function<void(size_t, const RecordView&)>& visit,
+                         std::string* err) {
+  TableStorage* storage = get_table(table);
+  if (!storage) {
+    if (err) {
+      *err = "table not found: " + table;
+    }
+    return false;
+  }
+  return storage->read_rows(row_ids, visit, err);
+}
+
+bool Database::update_rows(const std::string& table, const std::vector<uint64_t>& row_ids,
+                           const std::vector<SetClause>& sets, size_t* updated,
+                           std::string* err) {
+  if (!check_writable(err)) {
+    return false;
+  }
+  TableStorage* storage = get_table(table);
+  if (!storage) {
+    if (err) {
+      *err = "table not found: " + table;
+    }
+    return false;
+  }
+  if (!storage->update_rows(row_ids, sets, updated, err)) {
+    return false;
+  }
+  notify_all_partitions();
+  return true;
+}
+
+bool Database::delete_row(const std::string& table, uint64_t row_id, std::string* err) {
+  if (!check_writable(err)) {
+    return false;
+  }
+  TableStorage* storage = get_table(table);
+  if (!storage) {
+    if (err) {
+      *err = "table not found: " + table;
+    }
+    return false;
+  }
+  if (!storage->delete_row(row_id, err)) {
+    return false;
+  }
+  checkpointer_.notify_write(storage->log_partition_for_row(row_id));
+  return true;
+}
+
+bool Database::write_row(const std::string& table, uint64_t row_id,
+                         const std::vector<Value>& values, bool valid, std::string* err) {
+  if (!check_writable(err)) {
+    return false;
+  }
+  TableStorage* storage = get_table(table);
+  if (!storage) {
+    if (err) {
+      *err = "table not found: " + table;
+    }
+    return false;
+  }
+  if (!storage->write_row(row_id, values, valid, err)) {
+    return false;
+  }
+  checkpointer_.notify_write(storage->log_partition_for_row(row_id));
+  return true;
+}
+
+bool Database::get_schema(const std::string& table, Schema* schema, std::string* err) const {
+  if (!catalog_.get_schema(table, schema)) {
+    if (err) {
+      *err = "table not found: " + table;
+    }
+    return false;
+  }
+  return true;
+}
+
+uint64_t Database::schema_version() const {
+  return schema_version_.load();
+}
+
+std::vector<std::string> Database::list_tables() const {
+  return catalog_.list_tables();
+}
+
+size_t Database::page_size() const {
+  return page_size_;
+}
+
+std::vector<size_t> Database::cached_pages_per_node() const {
+  size_t nodes = numa_nodes_ > 0 ? static_cast<size_t>(numa_nodes_) : 1;
+  std::vector<size_t> totals(nodes, 0);
+  std::shared_lock<std::shared_mutex> tables_lock(tables_mutex_);
+  for (const auto& pair : tables_) {
+    const auto& storage = pair.second;
+    if (!storage) {
+      continue;
+    }
+    std::vector<size_t> per_table = storage->cached_pages_per_node();
+    if (per_table.size() > totals.size()) {
       totals.resize(per_table.size(), 0);
     }
     for (size_t i = 0; i < per_table.size(); ++i) {
@@ -340,6 +1231,152 @@ std::vector<size_t> Database::cached_pages_per_node() const {
   return totals;
 }
 
+CacheStats Database::cache_stats() const {
+  CacheStats total;
+  std::shared_lock<std::shared_mutex> tables_lock(tables_mutex_);
+  for (const auto& pair : tables_) {
+    if (!pair.second) {
+      continue;
+    }
+    total.add(pair.second->cache_stats());
+  }
+  return total;
+}
+
+uint64_t Database::page_migrations() const {
+  uint64_t total = 0;
+  std::shared_lock<std::shared_mutex> tables_lock(tables_mutex_);
+  for (const auto& pair : tables_) {
+    if (pair.second) {
+      total += pair.second->page_migrations();
+    }
+  }
+  return total;
+}
+
+bool Database::node_for_row(const std::string& table, uint64_t row_id, int* node,
+                            std::string* err) {
+  // 查找与路由都在映射锁内完成：并发 DROP TABLE 时不会用到已析构的表对象。
+  std::shared_lock<std::shared_mutex> tables_lock(tables_mutex_);
+  auto it = tables_.find(to_lower(table));
+  if (it == tables_.end()) {
+    if (err) {
+      *err = "table not found: " + table;
+    }
+    return false;
+  }
+  if (node) {
+    *node = it->second->node_for_row(row_id);
+  }
+  return true;
+}
+
+DatabaseStats Database::stats() const {
+  DatabaseStats stats;
+  {
+    std::shared_lock<std::shared_mutex> tables_lock(tables_mutex_);
+    for (const auto& pair : tables_) {
+      if (!pair.second) {
+        continue;
+      }
+      std::vector<CacheStats> per_node = pair.second->cache_stats_per_node();
+      if (stats.cache_per_node.size() < per_node.size()) {
+        stats.cache_per_node.resize(per_node.size());
+      }
+      for (size_t node = 0; node < per_node.size(); ++node) {
+        stats.cache.add(per_node[node]);
+        stats.cache_per_node[node].add(per_node[node]);
+      }
+      stats.page_migrations += pair.second->page_migrations();
+      stats.io.add(pair.second->io_stats());
+      stats.locks.add(pair.second->lock_stats());
+    }
+  }
+  stats.log = log_.stats();
+  for (int partition = 0; partition < log_.partition_count(); ++partition) {
+    stats.log_per_partition.push_back(log_.stats(partition));
+  }
+  if (scan_executor_) {
+    for (int node = 0; node < scan_executor_->node_count(); ++node) {
+      stats.executor_per_node.push_back(scan_executor_->stats(node));
+    }
+  }
+  return stats;
+}
+
+std::string Database::stats_text() const {
+  DatabaseStats stats = this->stats();
+  std::ostringstream out;
+  for (size_t node = 0; node < stats.cache_per_node.size(); ++node) {
+    const CacheStats& cache = stats.cache_per_node[node];
+    std::string label = "node=\"" + std::to_string(node) + "\"";
+    put_metric(&out, "mini_db_cache_hits_total", label, cache.hits);
+    put_metric(&out, "mini_db_cache_misses_total", label, cache.misses);
+    put_metric(&out, "mini_db_cache_evictions_total", label, cache.evictions);
+    put_metric(&out, "mini_db_cache_pages_written_total", label, cache.pages_written);
+    put_metric(&out, "mini_db_cache_sync_writes_total", label, cache.sync_writes);
+    put_metric(&out, "mini_db_cache_prefetched_total", label, cache.prefetched);
+    put_metric(&out, "mini_db_cache_pages", label, cache.pages);
+    put_metric(&out, "mini_db_cache_limit_pages", label, cache.limit);
+    put_metric(&out, "mini_db_cache_capacity_pages", label, cache.capacity);
+  }
+  uint64_t lookups = stats.cache.hits + stats.cache.misses;
+  put_metric(&out, "mini_db_cache_hit_ratio", "",
+             lookups == 0 ? 0.0 : static_cast<double>(stats.cache.hits) / lookups);
+  put_metric(&out, "mini_db_page_migrations_total", "", stats.page_migrations);
+  put_metric(&out, "mini_db_io_pages_read_total", "", stats.io.pages_read);
+  put_metric(&out, "mini_db_io_pages_written_total", "", stats.io.pages_written);
+  put_histogram(&out, "mini_db_io_read_us", "", stats.io.read_latency);
+  put_histogram(&out, "mini_db_io_write_us", "", stats.io.write_latency);
+  put_histogram(&out, "mini_db_io_sync_us", "", stats.io.sync_latency);
+  put_histogram(&out, "mini_db_lock_wait_us", "lock=\"table_shared\"", stats.locks.table_shared);
+  put_histogram(&out, "mini_db_lock_wait_us", "lock=\"table_exclusive\"",
+                stats.locks.table_exclusive);
+  put_histogram(&out, "mini_db_lock_wait_us", "lock=\"page\"", stats.locks.page);
+  for (size_t partition = 0; partition < stats.log_per_partition.size(); ++partition) {
+    const LogStats& log = stats.log_per_partition[partition];
+    std::string label = "partition=\"" + std::to_string(partition) + "\"";
+    put_metric(&out, "mini_db_log_records_total", label, log.records);
+    put_metric(&out, "mini_db_log_bytes_total", label, log.bytes);
+    put_metric(&out, "mini_db_log_buffer_full_waits_total", label, log.buffer_full_waits);
+    put_histogram(&out, "mini_db_log_fsync_us", label, log.fsync_latency);
+    put_histogram(&out, "mini_db_log_commit_wait_us", label, log.commit_wait);
+  }
+  for (size_t node = 0; node < stats.executor_per_node.size(); ++node) {
+    const NumaExecutorStats& executor = stats.executor_per_node[node];
+    std::string label = "node=\"" + std::to_string(node) + "\"";
+    put_metric(&out, "mini_db_executor_executed_total", label, executor.executed);
+    put_metric(&out, "mini_db_executor_stolen_local_total", label, executor.stolen_local);
+    put_metric(&out, "mini_db_executor_stolen_remote_total", label, executor.stolen_remote);
+    put_metric(&out, "mini_db_executor_queued", label, executor.queued);
+    put_histogram(&out, "mini_db_executor_task_us", label, executor.task_time);
+  }
+  return out.str();
+}
+
+bool Database::cache_stats(const std::string& table, CacheStats* stats, std::string* err) {
+  TableStorage* storage = get_table(table);
+  if (!storage) {
+    if (err) {
+      *err = "table not found: " + table;
+    }
+    return false;
+  }
+  if (stats) {
+    *stats = storage->cache_stats();
+  }
+  return true;
+}
+
+CacheOptions Database::table_cache(const std::string& name) const {
+  CacheOptions cache = options_.cache;
+  auto it = options_.table_placement.find(to_lower(name));
+  if (it != options_.table_placement.end()) {
+    cache.placement = it->second;
+  }
+  return cache;
+}
+
 std::string Database::table_path(const std::string& name) const {
   // 统一表文件命名规则：<table>.tbl
   return base_dir_ + "/" + name + ".tbl";
@@ -347,6 +1384,7 @@ std::string Database::table_path(const std::string& name) const {
 
 TableStorage* Database::get_table(const std::string& name) {
   std::string key = to_lower(name);
+  std::shared_lock<std::shared_mutex> tables_lock(tables_mutex_);
   auto it = tables_.find(key);
   if (it == tables_.end()) {
     return nullptr;
@@ -359,12 +1397,17 @@ bool Database::load_tables(std::string* err) {
   tables_.clear();
   for (const auto& table_name : catalog_.list_tables()) {
     Schema schema;
-    if (!catalog_.get_schema(table_name, &schema)) {
+    uint32_t table_id = 0;
+    if (!catalog_.get_schema(table_name, &schema) ||
+        !catalog_.get_table_id(table_name, &table_id)) {
       continue;
     }
-    auto table = std::make_unique<TableStorage>(table_path(table_name), table_name, schema,
-                                                page_size_, cache_pages_, numa_nodes_, &log_);
-    if (!table->load(err)) {
+    auto table = std::make_unique<TableStorage>(table_path(table_name), table_name, table_id,
+                                                schema, page_size_, cache_pages_, numa_nodes_,
+                                                table_cache(table_name), &log_, options_.read_only);
+    table->set_scan_executor(scan_executor_.get(), options_.scan);
+    table->set_buffer_manager(buffer_manager_.get());
+    if (!table->set_indexes(catalog_.get_indexes(table_name), err) || !table->load(err)) {
       return false;
     }
     tables_[table_name] = std::move(table);
@@ -373,47 +1416,347 @@ bool Database::load_tables(std::string* err) {
 }
 
 bool Database::recover(std::string* err) {
-  // 读取日志并重放所有记录，保证一致性。
-  std::vector<LogEntry> entries;
-  if (!log_.read_all(&entries, err)) {
-    return false;
+  // 流式读取日志并重放：旧版本未分区日志先在当前线程重放，
+  // 各分区随后在其 NUMA 节点的工作线程上并行重放（分区内记录只涉及该节点的页）。
+  std::unordered_map<uint32_t, TableStorage*> tables_by_id;
+  for (auto& pair : tables_) {
+    tables_by_id[pair.second->table_id()] = pair.second.get();
   }
-  if (entries.empty()) {
-    return true;
+  // 每个重放任务记录所触及行的最终有效性，用于修正空闲列表。
+  using RedoRows = std::unordered_map<uint32_t, std::unordered_map<uint64_t, bool>>;
+  // 事务记录先按行暂存，所有分区读完、确定哪些事务已提交后再应用。
+  // 行的某条普通记录之后的事务记录都在该记录之后（事务持有行锁直到写回），普通记录出现时丢弃之前的事务记录。
+  struct RedoTask {
+    RedoRows rows;
+    std::map<std::pair<uint32_t, uint64_t>, std::vector<std::pair<uint64_t, std::vector<char>>>>
+        txn_rows;
+    // 提交记录：事务号 -> 各涉及分区及其最后一条 TxnRow 的 LSN。
+    std::unordered_map<uint64_t, std::vector<std::pair<uint32_t, uint64_t>>> commits;
+    uint64_t last_lsn = 0;
+  };
+  auto make_visitor = [&tables_by_id](RedoTask* task) {
+    return [&tables_by_id, task](const LogEntry& entry, std::string* visit_err) {
+      task->last_lsn = entry.lsn;
+      // CHECKPOINT 记录仅用于延续 LSN。
+      if (entry.op == LogOp::Checkpoint) {
+        return true;
+      }
+      if (entry.op == LogOp::Commit) {
+        auto& parts = task->commits[entry.row_id];
+        for (size_t offset = 0; offset + 12 <= entry.data.size(); offset += 12) {
+          parts.emplace_back(static_cast<uint32_t>(get_uint(entry.data, offset, 4)),
+                             get_uint(entry.data, offset + 4, 8));
+        }
+        return true;
+      }
+      auto it = tables_by_id.find(entry.table_id);
+      if (it == tables_by_id.end()) {
+        if (visit_err) {
+          *visit_err = "table missing during recovery: id " + std::to_string(entry.table_id);
+        }
+        return false;
+      }
+      if (entry.op == LogOp::BulkInsert || entry.op == LogOp::SizedBulkInsert) {
+        const char* records = entry.data.data();
+        size_t size = entry.data.size();
+        size_t record_size = it->second->schema().record_size();
+        if (entry.op == LogOp::SizedBulkInsert) {
+          if (size < 4) {
+            if (visit_err) {
+              *visit_err = "corrupt bulk insert log record";
+            }
+            return false;
+          }
+          record_size = static_cast<size_t>(get_uint(entry.data, 0, 4));
+          records += 4;
+          size -= 4;
+        }
+        size_t count = 0;
+        if (!it->second->apply_redo_range(entry.row_id, records, size, record_size, &count,
+                                          visit_err)) {
+          return false;
+        }
+        // 批量装载只追加从未写过的新行，这些行之前不会有事务记录。
+        auto& rows = task->rows[entry.table_id];
+        for (size_t i = 0; i < count; ++i) {
+          rows[entry.row_id + i] = true;
+        }
+        return true;
+      }
+      auto key = std::make_pair(entry.table_id, entry.row_id);
+      if (entry.op == LogOp::TxnRow) {
+        if (entry.data.size() < 8) {
+          if (visit_err) {
+            *visit_err = "corrupt transaction log record";
+          }
+          return false;
+        }
+        task->txn_rows[key].emplace_back(get_uint(entry.data, 0, 8),
+                                         std::vector<char>(entry.data.begin() + 8, entry.data.end()));
+        return true;
+      }
+      if (!it->second->apply_redo(entry.row_id, entry.data, visit_err)) {
+        return false;
+      }
+      task->txn_rows.erase(key);
+      task->rows[entry.table_id][entry.row_id] = !entry.data.empty() && entry.data[0] != 0;
+      return true;
+    };
+  };
+
+  int partitions = log_.partition_count();
+  std::vector<RedoTask> tasks(static_cast<size_t>(partitions) + 1);
+  if (!log_.replay_legacy(make_visitor(&tasks[0]), err)) {
+    return false;
   }
-  for (const auto& entry : entries) {
-    // 逐条日志找到对应表并覆盖行数据。
-    TableStorage* table = get_table(entry.table);
-    if (!table) {
-      if (err) {
-        *err = "table missing during recovery: " + entry.table;
+  std::vector<std::string> errors(static_cast<size_t>(partitions));
+  {
+    NumaExecutor executor(partitions, 1);
+    executor.start();
+    std::vector<std::future<bool>> results;
+    results.reserve(static_cast<size_t>(partitions));
+    for (int i = 0; i < partitions; ++i) {
+      RedoTask* task = &tasks[static_cast<size_t>(i) + 1];
+      std::string* task_err = &errors[static_cast<size_t>(i)];
+      results.push_back(executor.submit(i, [this, i, task, task_err, &make_visitor]() {
+        return log_.replay(i, make_visitor(task), task_err);
+      }));
+    }
+    bool ok = true;
+    for (size_t i = 0; i < results.size(); ++i) {
+      if (!results[i].get() && ok) {
+        ok = false;
+        if (err) {
+          *err = errors[i];
+        }
       }
-      return false;
     }
-    if (!table->apply_redo(entry.row_id, entry.data, err)) {
+    executor.stop();
+    if (!ok) {
       return false;
     }
   }
-  for (auto& pair : tables_) {
-    // 恢复后重建空闲列表。
-    if (!pair.second->rebuild_free_list(err)) {
-      return false;
+
+  // 提交记录中的每个分区都已重放到该分区最后一条 TxnRow 时事务才算提交（否则崩溃时部分记录未落盘）。
+  std::unordered_set<uint64_t> committed;
+  for (const auto& task : tasks) {
+    for (const auto& commit : task.commits) {
+      bool complete = std::all_of(commit.second.begin(), commit.second.end(),
+                                  [&tasks, partitions](const std::pair<uint32_t, uint64_t>& part) {
+                                    return part.first < static_cast<uint32_t>(partitions) &&
+                                           tasks[part.first + 1].last_lsn >= part.second;
+                                  });
+      if (complete) {
+        committed.insert(commit.first);
+      }
+    }
+  }
+  // 每行应用最后一个已提交事务的记录；未提交事务的记录从未写回数据页，直接丢弃。
+  for (auto& task : tasks) {
+    for (const auto& pair : task.txn_rows) {
+      const std::vector<char>* image = nullptr;
+      for (const auto& txn_row : pair.second) {
+        if (committed.count(txn_row.first) != 0) {
+          image = &txn_row.second;
+        }
+      }
+      if (!image) {
+        continue;
+      }
+      if (!tables_by_id[pair.first.first]->apply_redo(pair.first.second, *image, err)) {
+        return false;
+      }
+      task.rows[pair.first.first][pair.first.second] = (*image)[0] != 0;
     }
   }
+
+  // 合并各任务的结果：同一行的记录只会出现在一个分区中，旧日志中的状态被分区记录覆盖。
+  RedoRows merged = std::move(tasks[0].rows);
+  for (size_t i = 1; i < tasks.size(); ++i) {
+    for (auto& table_rows : tasks[i].rows) {
+      auto& target = merged[table_rows.first];
+      for (const auto& row : table_rows.second) {
+        target[row.first] = row.second;
+      }
+    }
+  }
+  if (!merged.empty()) {
+    for (auto& table_rows : merged) {
+      if (!tables_by_id[table_rows.first]->finish_redo(table_rows.second, err)) {
+        return false;
+      }
+    }
+    // 重放结果落盘后再清空日志。
+    std::string flush_err;
+    for (auto& pair : tables_) {
+      pair.second->flush(&flush_err);
+      if (!flush_err.empty()) {
+        if (err) {
+          *err = flush_err;
+        }
+        return false;
+      }
+    }
+  }
+  // 无论是否重放都重建活动日志段，并打开日志供后续写入。
   log_.clear(err);
   return err ? err->empty() : true;
 }
 
-void Database::checkpoint(std::string* err) {
+bool Database::run_checkpoint(std::vector<uint64_t>* lsns, std::string* err) {
   std::lock_guard<std::mutex> lock(checkpoint_mutex_);
-  // 刷新所有表并清空日志。
+  if (!checkpoint_locked(lsns, err)) {
+    return false;
+  }
+  if (options_.warmup.enabled && options_.warmup.save_on_checkpoint) {
+    save_warmup();
+  }
+  return true;
+}
+
+bool Database::stage_rows(Transaction* txn, TableStorage* storage,
+                          const std::vector<std::vector<Value>>& rows, StagedRows* statement_rows,
+                          std::string* err) {
+  // 新插入的行号不会出现在事务已有的暂存写入中，合并时不会冲突。
+  for (const auto& row : rows) {
+    if (!storage->stage_insert(txn->id(), row, statement_rows, nullptr, err)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool Database::copy_rows(Transaction* txn, const std::string& table, const std::string& path,
+                         size_t* loaded, std::string* err) {
+  if (loaded) {
+    *loaded = 0;
+  }
+  if (!check_writable(err)) {
+    return false;
+  }
+  TableStorage* storage = get_table(table);
+  if (!storage) {
+    if (err) {
+      *err = "table not found: " + table;
+    }
+    return false;
+  }
+  std::ifstream file(path);
+  if (!file.is_open()) {
+    if (err) {
+      *err = "failed to open file: " + path;
+    }
+    return false;
+  }
+  const Schema& schema = storage->schema();
+  StagedRows statement_rows;
+  std::vector<std::vector<Value>> batch;
+  batch.reserve(kCopyBatchRows);
+  size_t count = 0;
+  size_t line_no = 0;
+  bool ok = true;
+  auto load_batch = [&]() {
+    if (batch.empty()) {
+      return true;
+    }
+    bool loaded_batch = txn ? stage_rows(txn, storage, batch, &statement_rows, err)
+                            : storage->bulk_insert(batch, nullptr, err);
+    if (!loaded_batch) {
+      return false;
+    }
+    count += batch.size();
+    batch.clear();
+    return true;
+  };
+  std::string line;
+  while (ok && std::getline(file, line)) {
+    ++line_no;
+    if (!line.empty() && line.back() == '\r') {
+      line.pop_back();
+    }
+    if (trim(line).empty()) {
+      continue;
+    }
+    // 逐行校验，错误信息带上行号；批量装载时已归一化的值不再转换。
+    std::vector<Value> values;
+    std::string line_err;
+    if (!parse_copy_line(line, &values, &line_err) || !schema.validate_values(&values, &line_err)) {
+      if (err) {
+        *err = "line " + std::to_string(line_no) + ": " + line_err;
+      }
+      ok = false;
+      break;
+    }
+    batch.push_back(std::move(values));
+    if (batch.size() >= kCopyBatchRows) {
+      ok = load_batch();
+    }
+  }
+  if (ok && file.bad()) {
+    if (err) {
+      *err = "failed to read file: " + path;
+    }
+    ok = false;
+  }
+  ok = ok && load_batch();
+  if (txn) {
+    // 事务内整条语句一起生效或撤销。
+    if (ok) {
+      txn->staged(storage)->merge(statement_rows);
+    } else {
+      storage->discard_staged(txn->id(), &statement_rows);
+      count = 0;
+    }
+  } else if (count > 0) {
+    notify_all_partitions();
+  }
+  if (loaded) {
+    *loaded = count;
+  }
+  return ok;
+}
+
+void Database::notify_all_partitions() {
+  // 扫描类写入可能触及任意分区。
+  for (int i = 0; i < log_.partition_count(); ++i) {
+    checkpointer_.notify_write(i);
+  }
+}
+
+bool Database::checkpoint_locked(std::vector<uint64_t>* lsns, std::string* err) {
+  MINI_DB_TRACE_SPAN("checkpoint");
+  std::vector<uint64_t> checkpoint_lsns;
+  {
+    // 短暂持有所有表的独占锁切换日志段：此后已归档段中的每条记录都已写入缓存页。
+    // 提交锁保证事务的 TxnRow 与提交记录和数据页写回都落在切换的同一侧。
+    std::unique_lock<std::shared_mutex> commit_lock(commit_mutex_);
+    std::vector<std::unique_lock<std::shared_mutex>> write_locks;
+    write_locks.reserve(tables_.size());
+    for (auto& pair : tables_) {
+      write_locks.push_back(pair.second->exclusive_lock());
+    }
+    if (!log_.rotate(&checkpoint_lsns, err)) {
+      return false;
+    }
+  }
+  // 模糊检查点：刷盘期间前台写入继续进行，新记录落在新日志段中。
+  std::string flush_err;
   for (auto& pair : tables_) {
-    pair.second->flush(err);
-    if (err && !err->empty()) {
-      return;
+    pair.second->flush(&flush_err);
+    if (!flush_err.empty()) {
+      if (err) {
+        *err = flush_err;
+      }
+      return false;
     }
   }
-  log_.clear(err);
+  if (!log_.purge(checkpoint_lsns, err)) {
+    return false;
+  }
+  if (lsns) {
+    *lsns = std::move(checkpoint_lsns);
+  }
+  return true;
 }
 
 }  // namespace mini_db
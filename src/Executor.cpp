@@ -1,6 +1,9 @@
 #include "db/Executor.h"
 
+#include "db/Utils.h"
+
 #include <sstream>
+#include <utility>
 
 namespace mini_db {
 
@@ -14,8 +17,283 @@ std::string value_to_string(const Value& value) {
   return value.text_value;
 }
 
+// 绑定参数中 ? 占位符所在位置的值。
+Value* param_value(BoundDml* bound, const ParamSlot& slot) {
+  switch (slot.target) {
+    case ParamTarget::InsertValue:
+      return &bound->rows[slot.row][slot.index];
+    case ParamTarget::SetValue:
+      return &bound->sets[slot.index].second;
+    case ParamTarget::WhereValue:
+      return &bound->where.value;
+    case ParamTarget::WhereUpper:
+      return &bound->where.upper;
+  }
+  return nullptr;
+}
+
 }  // namespace
 
+bool Executor::in_transaction() const {
+  return txn_ != nullptr;
+}
+
+void Executor::set_result_sink(std::function<void(const std::string&)> sink) {
+  sink_ = std::move(sink);
+}
+
+bool Executor::prepare(const std::shared_ptr<const Statement>& source, Database* db,
+                       Prepared* prepared, std::string* err) const {
+  // 先取版本再读表结构：期间发生的 DDL 只会让下一次执行多准备一次。
+  prepared->schema_version = db->schema_version();
+  BoundDml& bound = prepared->bound;
+  bound = BoundDml();
+  if (!db->bind_table(source->table, &prepared->schema, &bound.schema_epoch, err)) {
+    return false;
+  }
+  const Schema& schema = prepared->schema;
+  prepared->source = source;
+  const Statement& statement = *source;
+  auto is_param = [&statement](ParamTarget target, size_t row, size_t index) {
+    for (const auto& slot : statement.params) {
+      if (slot.target == target && slot.row == row && slot.index == index) {
+        return true;
+      }
+    }
+    return false;
+  };
+  // 解析各值所在的列：字面量在这里归一化一次，占位符记下列下标。
+  for (size_t i = 0; i < statement.set_clauses.size(); ++i) {
+    const SetClause& set = statement.set_clauses[i];
+    int idx = schema.column_index(set.column);
+    if (idx < 0) {
+      if (err) {
+        *err = "unknown column in SET: " + set.column;
+      }
+      return false;
+    }
+    bound.sets.emplace_back(static_cast<size_t>(idx), set.value);
+  }
+  bound.where = statement.where;
+  if (statement.where.has) {
+    bound.where_idx = schema.column_index(statement.where.column);
+    if (bound.where_idx < 0) {
+      if (err) {
+        *err = "unknown column in WHERE: " + statement.where.column;
+      }
+      return false;
+    }
+  }
+  bound.rows = statement.rows;
+  for (size_t r = 0; r < bound.rows.size(); ++r) {
+    std::vector<Value>& row = bound.rows[r];
+    if (row.size() != schema.columns().size()) {
+      if (err) {
+        *err = "value count does not match column count";
+      }
+      return false;
+    }
+    for (size_t c = 0; c < row.size(); ++c) {
+      if (!is_param(ParamTarget::InsertValue, r, c) && !schema.normalize_value(c, &row[c], err)) {
+        return false;
+      }
+    }
+  }
+  for (size_t i = 0; i < bound.sets.size(); ++i) {
+    if (!is_param(ParamTarget::SetValue, 0, i) &&
+        !schema.normalize_value(bound.sets[i].first, &bound.sets[i].second, err)) {
+      return false;
+    }
+  }
+  if (bound.where_idx >= 0) {
+    size_t col = static_cast<size_t>(bound.where_idx);
+    if (!is_param(ParamTarget::WhereValue, 0, 0)) {
+      if (!schema.normalize_value(col, &bound.where.value, err)) {
+        return false;
+      }
+      if (bound.where.op == CompareOp::Eq) {
+        bound.where_key = schema.encode_key(col, bound.where.value);
+      }
+    }
+    if (bound.where.op == CompareOp::Between && !is_param(ParamTarget::WhereUpper, 0, 0) &&
+        !schema.normalize_value(col, &bound.where.upper, err)) {
+      return false;
+    }
+  }
+  prepared->param_columns.clear();
+  for (const auto& slot : statement.params) {
+    switch (slot.target) {
+      case ParamTarget::InsertValue:
+        prepared->param_columns.push_back(slot.index);
+        break;
+      case ParamTarget::SetValue:
+        prepared->param_columns.push_back(bound.sets[slot.index].first);
+        break;
+      case ParamTarget::WhereValue:
+      case ParamTarget::WhereUpper:
+        prepared->param_columns.push_back(static_cast<size_t>(bound.where_idx));
+        break;
+    }
+  }
+  return true;
+}
+
+bool Executor::execute_prepared(const Statement& statement, Database* db, std::string* output,
+                                std::string* err) {
+  auto it = prepared_.find(to_lower(statement.name));
+  if (it == prepared_.end()) {
+    if (err) {
+      *err = "prepared statement not found: " + statement.name;
+    }
+    return false;
+  }
+  Prepared& prepared = it->second;
+  // 第二轮只在绑定后、执行前恰好发生 DDL 时出现（存储层报告 stale）。
+  for (int attempt = 0;; ++attempt) {
+    if (attempt > 0 || prepared.schema_version != db->schema_version()) {
+      // 表结构变化（或表被删除重建）后重新解析列并归一化字面量。
+      Prepared refreshed;
+      if (!prepare(prepared.source, db, &refreshed, err)) {
+        return false;
+      }
+      prepared = std::move(refreshed);
+    }
+    const std::vector<ParamSlot>& params = prepared.source->params;
+    if (statement.args.size() != params.size()) {
+      if (err) {
+        *err = "expected " + std::to_string(params.size()) + " parameters, got " +
+               std::to_string(statement.args.size());
+      }
+      return false;
+    }
+    BoundDml bound = prepared.bound;
+    for (size_t i = 0; i < params.size(); ++i) {
+      Value* value = param_value(&bound, params[i]);
+      *value = statement.args[i];
+      std::string param_err;
+      if (!prepared.schema.normalize_value(prepared.param_columns[i], value, &param_err)) {
+        if (err) {
+          *err = "parameter " + std::to_string(i + 1) + ": " + param_err;
+        }
+        return false;
+      }
+      if (params[i].target == ParamTarget::WhereValue && bound.where.op == CompareOp::Eq) {
+        bound.where_key = prepared.schema.encode_key(prepared.param_columns[i], *value);
+      }
+    }
+    bool stale = false;
+    if (execute_bound(*prepared.source, prepared.schema, bound, db, output, &stale, err)) {
+      return true;
+    }
+    if (!stale || attempt > 0) {
+      return false;
+    }
+  }
+}
+
+bool Executor::execute_bound(const Statement& statement, const Schema& schema,
+                             const BoundDml& bound, Database* db, std::string* output, bool* stale,
+                             std::string* err) {
+  // 与 execute 中对应的 DML 相同，只是列与值取自绑定参数。
+  switch (statement.type) {
+    case StatementType::Insert: {
+      if (bound.rows.size() > 1) {
+        size_t inserted = 0;
+        if (!db->bulk_insert(txn_.get(), statement.table, bound, &inserted, stale, err)) {
+          return false;
+        }
+        if (output) {
+          *output = "Inserted " + std::to_string(inserted) + " rows";
+        }
+        return true;
+      }
+      uint64_t row_id = 0;
+      if (!db->insert(txn_.get(), statement.table, bound, &row_id, stale, err)) {
+        return false;
+      }
+      if (output) {
+        *output = "Inserted row " + std::to_string(row_id);
+      }
+      return true;
+    }
+    case StatementType::Select: {
+      std::unique_ptr<TableCursor> cursor;
+      if (!db->open_cursor(txn_.get(), statement.table, bound, statement.limit, &cursor, stale,
+                           err)) {
+        return false;
+      }
+      return write_rows(schema, cursor.get(), output, err);
+    }
+    case StatementType::Update: {
+      size_t updated = 0;
+      if (!db->update(txn_.get(), statement.table, bound, &updated, stale, err)) {
+        return false;
+      }
+      if (output) {
+        *output = "Updated " + std::to_string(updated) + " rows";
+      }
+      return true;
+    }
+    case StatementType::Delete: {
+      size_t removed = 0;
+      if (!db->remove(txn_.get(), statement.table, bound, &removed, stale, err)) {
+        return false;
+      }
+      if (output) {
+        *output = "Deleted " + std::to_string(removed) + " rows";
+      }
+      return true;
+    }
+    default:
+      if (err) {
+        *err = "unsupported statement";
+      }
+      return false;
+  }
+}
+
+bool Executor::write_rows(const Schema& schema, TableCursor* cursor, std::string* output,
+                          std::string* err) {
+  std::ostringstream oss;
+  const auto& cols = schema.columns();
+  // 输出表头。
+  for (size_t i = 0; i < cols.size(); ++i) {
+    oss << cols[i].name;
+    if (i + 1 < cols.size()) {
+      oss << "\t";
+    }
+  }
+  oss << "\n";
+  std::vector<std::vector<Value>> rows;
+  uint64_t count = 0;
+  while (!cursor->done()) {
+    if (!cursor->next(kSelectBatchRows, &rows, err)) {
+      return false;
+    }
+    for (const auto& row : rows) {
+      // 输出每一行的列值。
+      for (size_t i = 0; i < row.size(); ++i) {
+        oss << value_to_string(row[i]);
+        if (i + 1 < row.size()) {
+          oss << "\t";
+        }
+      }
+      oss << "\n";
+    }
+    count += rows.size();
+    // 有 sink 时每批输出后清空缓冲。
+    if (sink_) {
+      sink_(oss.str());
+      oss.str(std::string());
+    }
+  }
+  oss << "Rows: " << count;
+  if (output) {
+    *output = oss.str();
+  }
+  return true;
+}
+
 bool Executor::execute(const Statement& statement, Database* db, std::string* output,
                        std::string* err) {
   // 根据语句类型调用 Database 对应接口，并组织输出。
@@ -28,10 +306,126 @@ bool Executor::execute(const Statement& statement, Database* db, std::string* ou
   if (output) {
     output->clear();
   }
+  bool ddl = statement.type == StatementType::CreateTable ||
+             statement.type == StatementType::CreateIndex ||
+             statement.type == StatementType::DropTable ||
+             statement.type == StatementType::DropIndex ||
+             statement.type == StatementType::AlterTableAdd;
+  if (ddl && txn_) {
+    // DDL 会检查点并重建表文件，不能与暂存写入混在一个事务里。
+    if (err) {
+      *err = "DDL is not allowed inside a transaction";
+    }
+    return false;
+  }
   switch (statement.type) {
+    case StatementType::Begin: {
+      if (txn_) {
+        if (err) {
+          *err = "transaction already in progress";
+        }
+        return false;
+      }
+      txn_ = db->begin(err);
+      if (!txn_) {
+        return false;
+      }
+      if (output) {
+        *output = "BEGIN";
+      }
+      return true;
+    }
+    case StatementType::Commit: {
+      if (!txn_) {
+        if (err) {
+          *err = "no transaction in progress";
+        }
+        return false;
+      }
+      // 提交失败时事务已回滚，会话同样回到自动提交。
+      std::unique_ptr<Transaction> txn = std::move(txn_);
+      if (!db->commit(txn.get(), err)) {
+        return false;
+      }
+      if (output) {
+        *output = "COMMIT";
+      }
+      return true;
+    }
+    case StatementType::Rollback: {
+      if (!txn_) {
+        if (err) {
+          *err = "no transaction in progress";
+        }
+        return false;
+      }
+      db->rollback(txn_.get());
+      txn_.reset();
+      if (output) {
+        *output = "ROLLBACK";
+      }
+      return true;
+    }
+    case StatementType::Prepare: {
+      std::string key = to_lower(statement.name);
+      if (prepared_.count(key) != 0) {
+        if (err) {
+          *err = "prepared statement already exists: " + statement.name;
+        }
+        return false;
+      }
+      Prepared prepared;
+      if (!prepare(statement.body, db, &prepared, err)) {
+        return false;
+      }
+      prepared_.emplace(key, std::move(prepared));
+      if (output) {
+        *output = "PREPARE";
+      }
+      return true;
+    }
+    case StatementType::Execute:
+      return execute_prepared(statement, db, output, err);
+    case StatementType::Deallocate: {
+      if (prepared_.erase(to_lower(statement.name)) == 0) {
+        if (err) {
+          *err = "prepared statement not found: " + statement.name;
+        }
+        return false;
+      }
+      if (output) {
+        *output = "DEALLOCATE";
+      }
+      return true;
+    }
     case StatementType::CreateTable: {
-      // DDL：创建表。
-      if (!db->create_table(statement.table, statement.columns, err)) {
+      // DDL：创建表，并为 PRIMARY KEY 列建立索引。
+      if (!db->create_table(statement.table, statement.columns, statement.table_options, err)) {
+        return false;
+      }
+      for (const auto& index : statement.indexes) {
+        if (!db->create_index(statement.table, index, err)) {
+          return false;
+        }
+      }
+      if (output) {
+        *output = "OK";
+      }
+      return true;
+    }
+    case StatementType::CreateIndex: {
+      // DDL：创建索引。
+      if (!db->create_index(statement.table, statement.indexes.front(), err)) {
+        return false;
+      }
+      if (output) {
+        *output = "OK";
+      }
+      return true;
+    }
+    case StatementType::DropIndex: {
+      // DDL：删除索引。
+      if (!db->drop_index(statement.table, statement.indexes.front().name, err)) {
         return false;
       }
       if (output) {
@@ -60,9 +454,19 @@ bool Executor::execute(const Statement& statement, Database* db, std::string* ou
       return true;
     }
     case StatementType::Insert: {
-      // DML：插入记录。
+      // DML：插入记录；多组 VALUES 走批量装载。
+      if (statement.rows.size() > 1) {
+        size_t inserted = 0;
+        if (!db->bulk_insert(txn_.get(), statement.table, statement.rows, &inserted, err)) {
+          return false;
+        }
+        if (output) {
+          *output = "Inserted " + std::to_string(inserted) + " rows";
+        }
+        return true;
+      }
       uint64_t row_id = 0;
-      if (!db->insert(statement.table, statement.values, &row_id, err)) {
+      if (!db->insert(txn_.get(), statement.table, statement.rows.front(), &row_id, err)) {
         return false;
       }
       if (output) {
@@ -70,37 +474,46 @@ bool Executor::execute(const Statement& statement, Database* db, std::string* ou
       }
       return true;
     }
-    case StatementType::Select: {
-      // DML：查询并打印结果表格。
-      std::vector<std::vector<Value>> rows;
-      if (!db->select(statement.table, statement.where, &rows, err)) {
+    case StatementType::Copy: {
+      // DML：从文件批量装载。
+      size_t loaded = 0;
+      if (!db->copy_from(txn_.get(), statement.table, statement.path, &loaded, err)) {
+        if (err && loaded > 0) {
+          *err += " (" + std::to_string(loaded) + " rows loaded)";
+        }
         return false;
       }
+      if (output) {
+        *output = "Copied " + std::to_string(loaded) + " rows";
+      }
+      return true;
+    }
+    case StatementType::Select: {
+      // DML：通过游标按批读取并输出结果表格，不一次物化全部行。
       Schema schema;
       if (!db->get_schema(statement.table, &schema, err)) {
         return false;
       }
-      std::ostringstream oss;
-      const auto& cols = schema.columns();
-      // 输出表头。
-      for (size_t i = 0; i < cols.size(); ++i) {
-        oss << cols[i].name;
-        if (i + 1 < cols.size()) {
-          oss << "\t";
-        }
+      std::unique_ptr<TableCursor> cursor;
+      if (!db->open_cursor(txn_.get(), statement.table, statement.where, statement.limit, &cursor,
+                           err)) {
+        return false;
       }
-      oss << "\n";
-      for (const auto& row : rows) {
-        // 输出每一行的列值。
-        for (size_t i = 0; i < row.size(); ++i) {
-          oss << value_to_string(row[i]);
-          if (i + 1 < row.size()) {
-            oss << "\t";
-          }
-        }
-        oss << "\n";
+      return write_rows(schema, cursor.get(), output, err);
+    }
+    case StatementType::ShowStats: {
+      // 每行统计拆成名称与值两列，与 SELECT 的结果表格格式一致。
+      std::istringstream lines(db->stats_text());
+      std::ostringstream oss;
+      oss << "metric\tvalue\n";
+      uint64_t count = 0;
+      std::string line;
+      while (std::getline(lines, line)) {
+        size_t space = line.rfind(' ');
+        oss << line.substr(0, space) << "\t" << line.substr(space + 1) << "\n";
+        ++count;
       }
-      oss << "Rows: " << rows.size();
+      oss << "Rows: " << count;
       if (output) {
         *output = oss.str();
       }
@@ -109,7 +522,8 @@ bool Executor::execute(const Statement& statement, Database* db, std::string* ou
     case StatementType::Update: {
       // DML：更新记录。
       size_t updated = 0;
-      if (!db->update(statement.table, statement.set_clauses, statement.where, &updated, err)) {
+      if (!db->update(txn_.get(), statement.table, statement.set_clauses, statement.where,
+                      &updated, err)) {
         return false;
       }
       if (output) {
@@ -120,7 +534,7 @@ bool Executor::execute(const Statement& statement, Database* db, std::string* ou
     case StatementType::Delete: {
       // DML：删除记录。
       size_t removed = 0;
-      if (!db->remove(statement.table, statement.where, &removed, err)) {
+      if (!db->remove(txn_.get(), statement.table, statement.where, &removed, err)) {
         return false;
       }
       if (output) {
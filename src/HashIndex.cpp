@@ -0,0 +1,236 @@
+#include "db/HashIndex.h"
+
+#include "db/Utils.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <unistd.h>
+
+namespace mini_db {
+
+namespace {
+
+// 快照文件头：魔数(4) + 键长(4) + 条目数(8)，之后为条目数组与 CRC32(4)。
+constexpr char kSnapshotMagic[4] = {'H', 'I', 'X', '1'};
+constexpr size_t kSnapshotHeaderSize = 16;
+
+void put_uint(std::vector<char>* out, uint64_t value, size_t bytes) {
+  for (size_t i = 0; i < bytes; ++i) {
+    out->push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+  }
+}
+
+uint64_t get_uint(const char* data, size_t bytes) {
+  uint64_t value = 0;
+  for (size_t i = 0; i < bytes; ++i) {
+    value |= static_cast<uint64_t>(static_cast<unsigned char>(data[i])) << (8 * i);
+  }
+  return value;
+}
+
+// 写出并 fsync 整个文件。
+bool write_file_synced(const std::string& path, const std::vector<char>& data, std::string* err) {
+  int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    if (err) {
+      *err = "failed to open index snapshot: " + path;
+    }
+    return false;
+  }
+  size_t written = 0;
+  while (written < data.size()) {
+    ssize_t n = ::write(fd, data.data() + written, data.size() - written);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      ::close(fd);
+      if (err) {
+        *err = std::string("failed to write index snapshot: ") + std::strerror(errno);
+      }
+      return false;
+    }
+    written += static_cast<size_t>(n);
+  }
+  bool ok = ::fsync(fd) == 0;
+  ::close(fd);
+  if (!ok && err) {
+    *err = std::string("failed to sync index snapshot: ") + std::strerror(errno);
+  }
+  return ok;
+}
+
+}  // namespace
+
+HashIndex::HashIndex(const IndexDef& def, const std::string& path, size_t column_index,
+                     size_t key_offset, size_t key_size)
+    : Index(def, path, column_index, key_offset, key_size) {}
+
+bool HashIndex::insert(const std::string& key, uint64_t row_id, bool enforce_unique,
+                       std::string* err) {
+  Shard& shard = shard_for(key);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  auto range = shard.entries.equal_range(key);
+  for (auto it = range.first; it != range.second; ++it) {
+    if (it->second == row_id) {
+      return true;
+    }
+    if (def_.unique && enforce_unique) {
+      return duplicate_key(err);
+    }
+  }
+  shard.entries.emplace(key, row_id);
+  dirty_.store(true);
+  return true;
+}
+
+bool HashIndex::erase(const std::string& key, uint64_t row_id, std::string*) {
+  Shard& shard = shard_for(key);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  auto range = shard.entries.equal_range(key);
+  for (auto it = range.first; it != range.second; ++it) {
+    if (it->second == row_id) {
+      shard.entries.erase(it);
+      dirty_.store(true);
+      break;
+    }
+  }
+  return true;
+}
+
+bool HashIndex::lookup(const std::string& key, std::vector<uint64_t>* rows, std::string*) {
+  rows->clear();
+  const Shard& shard = shard_for(key);
+  {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto range = shard.entries.equal_range(key);
+    for (auto it = range.first; it != range.second; ++it) {
+      rows->push_back(it->second);
+    }
+  }
+  // 按行号排序，与全表扫描的输出顺序一致。
+  std::sort(rows->begin(), rows->end());
+  return true;
+}
+
+bool HashIndex::erase_rows(const std::unordered_map<uint64_t, bool>& rows, std::string*) {
+  for (auto& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    for (auto it = shard.entries.begin(); it != shard.entries.end();) {
+      if (rows.find(it->second) != rows.end()) {
+        it = shard.entries.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+  dirty_.store(true);
+  return true;
+}
+
+bool HashIndex::clear(std::string*) {
+  for (auto& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.entries.clear();
+  }
+  dirty_.store(true);
+  return true;
+}
+
+size_t HashIndex::size() const {
+  size_t total = 0;
+  for (const auto& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    total += shard.entries.size();
+  }
+  return total;
+}
+
+bool HashIndex::dirty() const {
+  return dirty_.load();
+}
+
+bool HashIndex::save(std::string* err) {
+  // 先清除脏标记：序列化期间的并发修改会重新置位，由下一次检查点写出。
+  dirty_.store(false);
+  std::vector<char> data;
+  data.insert(data.end(), kSnapshotMagic, kSnapshotMagic + sizeof(kSnapshotMagic));
+  put_uint(&data, key_size_, 4);
+  put_uint(&data, 0, 8);
+  uint64_t count = 0;
+  for (const auto& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    data.reserve(data.size() + shard.entries.size() * (key_size_ + 8));
+    for (const auto& entry : shard.entries) {
+      data.insert(data.end(), entry.first.begin(), entry.first.end());
+      put_uint(&data, entry.second, 8);
+      ++count;
+    }
+  }
+  for (size_t i = 0; i < 8; ++i) {
+    data[8 + i] = static_cast<char>((count >> (8 * i)) & 0xFF);
+  }
+  uint32_t crc = crc32(data.data() + kSnapshotHeaderSize, data.size() - kSnapshotHeaderSize);
+  put_uint(&data, crc, 4);
+  std::string temp_path = path_ + ".tmp";
+  if (!write_file_synced(temp_path, data, err)) {
+    dirty_.store(true);
+    return false;
+  }
+  if (std::rename(temp_path.c_str(), path_.c_str()) != 0) {
+    dirty_.store(true);
+    if (err) {
+      *err = "failed to replace index snapshot: " + path_;
+    }
+    return false;
+  }
+  return true;
+}
+
+bool HashIndex::load() {
+  std::ifstream file(path_, std::ios::binary);
+  if (!file.is_open()) {
+    return false;
+  }
+  std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  if (data.size() < kSnapshotHeaderSize + 4 ||
+      std::memcmp(data.data(), kSnapshotMagic, sizeof(kSnapshotMagic)) != 0 ||
+      get_uint(data.data() + 4, 4) != key_size_) {
+    return false;
+  }
+  uint64_t count = get_uint(data.data() + 8, 8);
+  size_t entry_size = key_size_ + 8;
+  if (data.size() != kSnapshotHeaderSize + count * entry_size + 4) {
+    return false;
+  }
+  size_t body = data.size() - 4;
+  uint32_t crc = static_cast<uint32_t>(get_uint(data.data() + body, 4));
+  if (crc32(data.data() + kSnapshotHeaderSize, body - kSnapshotHeaderSize) != crc) {
+    return false;
+  }
+  clear(nullptr);
+  for (size_t pos = kSnapshotHeaderSize; pos < body; pos += entry_size) {
+    std::string key(data.data() + pos, key_size_);
+    uint64_t row_id = get_uint(data.data() + pos + key_size_, 8);
+    Shard& shard = shard_for(key);
+    shard.entries.emplace(std::move(key), row_id);
+  }
+  dirty_.store(false);
+  return true;
+}
+
+HashIndex::Shard& HashIndex::shard_for(const std::string& key) {
+  return shards_[std::hash<std::string>()(key) % kShardCount];
+}
+
+const HashIndex::Shard& HashIndex::shard_for(const std::string& key) const {
+  return shards_[std::hash<std::string>()(key) % kShardCount];
+}
+
+}  // namespace mini_db
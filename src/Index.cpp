@@ -0,0 +1,48 @@
+#include "db/Index.h"
+
+namespace mini_db {
+
+Index::Index(const IndexDef& def, const std::string& path, size_t column_index, size_t key_offset,
+             size_t key_size)
+    : def_(def),
+      path_(path),
+      column_index_(column_index),
+      key_offset_(key_offset),
+      key_size_(key_size) {}
+
+const IndexDef& Index::def() const {
+  return def_;
+}
+
+const std::string& Index::path() const {
+  return path_;
+}
+
+size_t Index::column_index() const {
+  return column_index_;
+}
+
+std::string Index::key_of(const std::vector<char>& record) const {
+  return std::string(record.data() + key_offset_, key_size_);
+}
+
+bool Index::ordered() const {
+  return false;
+}
+
+bool Index::range(const std::string*, bool, const std::string*, bool, std::vector<uint64_t>*,
+                  std::string* err) {
+  if (err) {
+    *err = "index does not support range scans: " + def_.name;
+  }
+  return false;
+}
+
+bool Index::duplicate_key(std::string* err) const {
+  if (err) {
+    *err = "duplicate key for unique index: " + def_.name;
+  }
+  return false;
+}
+
+}  // namespace mini_db
@@ -0,0 +1,183 @@
+#include "db/IoUring.h"
+
+#include <cerrno>
+#include <cstring>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace mini_db {
+
+namespace {
+
+int sys_io_uring_setup(unsigned entries, io_uring_params* params) {
+  return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+}
+
+int sys_io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+  return static_cast<int>(
+      ::syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+unsigned* ring_field(void* ring, uint32_t offset) {
+  return reinterpret_cast<unsigned*>(static_cast<char*>(ring) + offset);
+}
+
+}  // namespace
+
+IoUring::~IoUring() {
+  release();
+}
+
+bool IoUring::init(unsigned entries, std::string* err) {
+  release();
+  io_uring_params params;
+  std::memset(&params, 0, sizeof(params));
+  int fd = sys_io_uring_setup(entries, &params);
+  if (fd < 0) {
+    if (err) {
+      *err = "io_uring_setup failed: " + std::string(std::strerror(errno));
+    }
+    return false;
+  }
+  ring_fd_ = fd;
+  entries_ = params.sq_entries;
+  sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single_mmap && cq_ring_size_ > sq_ring_size_) {
+    sq_ring_size_ = cq_ring_size_;
+  }
+  sq_ring_ = ::mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                    ring_fd_, IORING_OFF_SQ_RING);
+  if (sq_ring_ == MAP_FAILED) {
+    sq_ring_ = nullptr;
+  }
+  if (sq_ring_ && single_mmap) {
+    cq_ring_ = sq_ring_;
+  } else if (sq_ring_) {
+    cq_ring_ = ::mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      ring_fd_, IORING_OFF_CQ_RING);
+    if (cq_ring_ == MAP_FAILED) {
+      cq_ring_ = nullptr;
+    }
+  }
+  sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+  if (cq_ring_) {
+    sqes_ = ::mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                   ring_fd_, IORING_OFF_SQES);
+    if (sqes_ == MAP_FAILED) {
+      sqes_ = nullptr;
+    }
+  }
+  if (!sqes_) {
+    if (err) {
+      *err = "io_uring mmap failed: " + std::string(std::strerror(errno));
+    }
+    release();
+    return false;
+  }
+  sq_head_ = ring_field(sq_ring_, params.sq_off.head);
+  sq_tail_ = ring_field(sq_ring_, params.sq_off.tail);
+  sq_mask_ = ring_field(sq_ring_, params.sq_off.ring_mask);
+  sq_array_ = ring_field(sq_ring_, params.sq_off.array);
+  cq_head_ = ring_field(cq_ring_, params.cq_off.head);
+  cq_tail_ = ring_field(cq_ring_, params.cq_off.tail);
+  cq_mask_ = ring_field(cq_ring_, params.cq_off.ring_mask);
+  cqes_ = static_cast<char*>(cq_ring_) + params.cq_off.cqes;
+  return true;
+}
+
+bool IoUring::ready() const {
+  return ring_fd_ >= 0;
+}
+
+bool IoUring::submit_and_wait(int fd, const std::vector<IoRequest>& requests,
+                              std::vector<int>* results, std::string* err) {
+  if (!ready()) {
+    if (err) {
+      *err = "io_uring not initialized";
+    }
+    return false;
+  }
+  results->assign(requests.size(), 0);
+  std::lock_guard<std::mutex> lock(mutex_);
+  size_t next = 0;
+  while (next < requests.size()) {
+    // 每批最多填满提交队列；提交与完成一一对应，批内全部完成后再提交下一批。
+    size_t batch = requests.size() - next;
+    if (batch > entries_) {
+      batch = entries_;
+    }
+    unsigned tail = __atomic_load_n(sq_tail_, __ATOMIC_RELAXED);
+    unsigned mask = *sq_mask_;
+    io_uring_sqe* sqes = static_cast<io_uring_sqe*>(sqes_);
+    for (size_t i = 0; i < batch; ++i) {
+      const IoRequest& request = requests[next + i];
+      unsigned index = tail & mask;
+      io_uring_sqe* sqe = &sqes[index];
+      std::memset(sqe, 0, sizeof(*sqe));
+      sqe->opcode = request.write ? IORING_OP_WRITE : IORING_OP_READ;
+      sqe->fd = fd;
+      sqe->addr = reinterpret_cast<uint64_t>(request.data);
+      sqe->len = static_cast<uint32_t>(request.size);
+      sqe->off = request.offset;
+      sqe->user_data = next + i;
+      sq_array_[index] = index;
+      ++tail;
+    }
+    __atomic_store_n(sq_tail_, tail, __ATOMIC_RELEASE);
+    size_t to_submit = batch;
+    size_t completed = 0;
+    while (completed < batch) {
+      int ret = sys_io_uring_enter(ring_fd_, static_cast<unsigned>(to_submit),
+                                   static_cast<unsigned>(batch - completed),
+                                   IORING_ENTER_GETEVENTS);
+      if (ret < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        if (err) {
+          *err = "io_uring_enter failed: " + std::string(std::strerror(errno));
+        }
+        return false;
+      }
+      to_submit -= static_cast<size_t>(ret) < to_submit ? static_cast<size_t>(ret) : to_submit;
+      // 收割完成队列。
+      unsigned head = __atomic_load_n(cq_head_, __ATOMIC_RELAXED);
+      unsigned cq_tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+      io_uring_cqe* cqes = static_cast<io_uring_cqe*>(cqes_);
+      while (head != cq_tail) {
+        const io_uring_cqe& cqe = cqes[head & *cq_mask_];
+        (*results)[static_cast<size_t>(cqe.user_data)] = cqe.res;
+        ++head;
+        ++completed;
+      }
+      __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+    }
+    next += batch;
+  }
+  return true;
+}
+
+void IoUring::release() {
+  if (sqes_) {
+    ::munmap(sqes_, sqes_size_);
+    sqes_ = nullptr;
+  }
+  if (cq_ring_ && cq_ring_ != sq_ring_) {
+    ::munmap(cq_ring_, cq_ring_size_);
+  }
+  cq_ring_ = nullptr;
+  if (sq_ring_) {
+    ::munmap(sq_ring_, sq_ring_size_);
+    sq_ring_ = nullptr;
+  }
+  if (ring_fd_ >= 0) {
+    ::close(ring_fd_);
+    ring_fd_ = -1;
+  }
+}
+
+}  // namespace mini_db
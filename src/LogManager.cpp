@@ -1,95 +1,684 @@
 #include "db/LogManager.h"
 
+#include "db/NumaThread.h"
+#include "db/Trace.h"
 #include "db/Utils.h"
 
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
 #include <fstream>
-#include <sstream>
+#include <unistd.h>
 
 namespace mini_db {
 
-LogManager::LogManager(const std::string& path) : path_(path) {}
+namespace {
 
-bool LogManager::append(const std::string& op, const std::string& table, uint64_t row_id,
-                        const std::vector<char>& data, std::string* err) {
-  std::lock_guard<std::mutex> lock(mutex_);
-  // 日志格式：LSN|OP|TABLE|ROW_ID|HEX(DATA)
-  std::ofstream file(path_, std::ios::app | std::ios::out);
+// 段文件头魔数，用于识别日志格式版本。
+constexpr char kSegmentMagic[8] = {'M', 'D', 'B', 'W', 'A', 'L', '0', '1'};
+// 记录头长度：长度(4) + CRC(4) + LSN(8) + op(1) + 表ID(4) + 行号(8)。
+constexpr size_t kRecordHeaderSize = 29;
+// CRC 覆盖范围从 LSN 字段开始。
+constexpr size_t kCrcOffset = 8;
+
+// 将路径拆分为目录与文件名。
+void split_path(const std::string& path, std::string* dir, std::string* base) {
+  size_t slash = path.find_last_of('/');
+  if (slash == std::string::npos) {
+    *dir = ".";
+    *base = path;
+    return;
+  }
+  *dir = slash == 0 ? "/" : path.substr(0, slash);
+  *base = path.substr(slash + 1);
+}
+
+// 按小端序写入整数。
+void write_uint(char* out, uint64_t value, size_t bytes) {
+  for (size_t i = 0; i < bytes; ++i) {
+    out[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+  }
+}
+
+// 按小端序读取整数。
+uint64_t read_uint(const char* data, size_t bytes) {
+  uint64_t value = 0;
+  for (size_t i = 0; i < bytes; ++i) {
+    value |= static_cast<uint64_t>(static_cast<unsigned char>(data[i])) << (8 * i);
+  }
+  return value;
+}
+
+// 完整写出缓冲区（处理部分写与 EINTR）。
+bool write_fully(int fd, const char* data, size_t size, std::string* err) {
+  size_t written = 0;
+  while (written < size) {
+    ssize_t n = ::write(fd, data + written, size - written);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      if (err) {
+        *err = std::string("failed to write log: ") + std::strerror(errno);
+      }
+      return false;
+    }
+    written += static_cast<size_t>(n);
+  }
+  return true;
+}
+
+bool sync_fd(int fd, std::string* err) {
+  if (::fdatasync(fd) != 0) {
+    if (err) {
+      *err = std::string("failed to sync log: ") + std::strerror(errno);
+    }
+    return false;
+  }
+  return true;
+}
+
+// 编码一条记录到 out（调用方保证空间足够），返回记录长度。
+size_t encode_record(LogOp op, uint64_t lsn, uint32_t table_id, uint64_t row_id, const char* data,
+                     size_t size, char* out) {
+  write_uint(out, size, 4);
+  write_uint(out + 8, lsn, 8);
+  out[16] = static_cast<char>(op);
+  write_uint(out + 17, table_id, 4);
+  write_uint(out + 21, row_id, 8);
+  if (size > 0) {
+    std::memcpy(out + kRecordHeaderSize, data, size);
+  }
+  // 回填 CRC（覆盖 LSN 到数据末尾）。
+  write_uint(out + 4, crc32(out + kCrcOffset, kRecordHeaderSize - kCrcOffset + size), 4);
+  return kRecordHeaderSize + size;
+}
+
+// 列出 path.<LSN> 形式的归档段，按 LSN 升序返回。
+std::vector<std::pair<uint64_t, std::string>> archived_segments(const std::string& path) {
+  std::vector<std::pair<uint64_t, std::string>> segments;
+  std::string dir;
+  std::string base;
+  split_path(path, &dir, &base);
+  DIR* handle = opendir(dir.c_str());
+  if (!handle) {
+    return segments;
+  }
+  std::string prefix = base + ".";
+  while (dirent* ent = readdir(handle)) {
+    std::string name = ent->d_name;
+    if (name.size() <= prefix.size() || name.compare(0, prefix.size(), prefix) != 0) {
+      continue;
+    }
+    std::string suffix = name.substr(prefix.size());
+    if (!is_number(suffix) || suffix[0] == '-' || suffix[0] == '+') {
+      continue;
+    }
+    segments.emplace_back(std::stoull(suffix), dir + "/" + name);
+  }
+  closedir(handle);
+  std::sort(segments.begin(), segments.end());
+  return segments;
+}
+
+// 流式读取一个段文件中的全部完整记录，逐条交给 visit；max_lsn 输出见到的最大 LSN。
+bool replay_segment(const std::string& path, const LogVisitor& visit, uint64_t* max_lsn,
+                    std::string* err) {
+  std::ifstream file(path, std::ios::binary);
   if (!file.is_open()) {
+    return true;
+  }
+  char magic[sizeof(kSegmentMagic)];
+  file.read(magic, sizeof(magic));
+  if (file.gcount() == 0) {
+    return true;
+  }
+  if (static_cast<size_t>(file.gcount()) < sizeof(magic) ||
+      std::memcmp(magic, kSegmentMagic, sizeof(kSegmentMagic)) != 0) {
     if (err) {
-      *err = "failed to open log file";
+      *err = "unrecognized log format: " + path;
     }
     return false;
   }
-  std::string hex = hex_encode(data);
-  file << next_lsn_++ << "|" << op << "|" << table << "|" << row_id << "|" << hex << "\n";
-  file.flush();
-  if (!file) {
+  char head[kRecordHeaderSize];
+  LogEntry entry;
+  for (;;) {
+    file.read(head, sizeof(head));
+    if (static_cast<size_t>(file.gcount()) < sizeof(head)) {
+      break;
+    }
+    size_t size = static_cast<size_t>(read_uint(head, 4));
+    entry.data.resize(size);
+    file.read(entry.data.data(), static_cast<std::streamsize>(size));
+    if (static_cast<size_t>(file.gcount()) < size) {
+      // 尾部记录不完整（写入过程中崩溃），之后的内容全部丢弃。
+      break;
+    }
+    uint32_t crc = static_cast<uint32_t>(read_uint(head + 4, 4));
+    uint32_t actual = crc32(head + kCrcOffset, kRecordHeaderSize - kCrcOffset);
+    if (crc32(entry.data.data(), size, actual) != crc) {
+      break;
+    }
+    entry.lsn = read_uint(head + 8, 8);
+    entry.op = static_cast<LogOp>(static_cast<uint8_t>(head[16]));
+    entry.table_id = static_cast<uint32_t>(read_uint(head + 17, 4));
+    entry.row_id = read_uint(head + 21, 8);
+    if (max_lsn && entry.lsn > *max_lsn) {
+      *max_lsn = entry.lsn;
+    }
+    if (!visit(entry, err)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// 流式读取 path 的归档段与活动段（按 LSN 顺序）。
+bool replay_segments(const std::string& path, const LogVisitor& visit, uint64_t* max_lsn,
+                     std::string* err) {
+  for (const auto& segment : archived_segments(path)) {
+    if (!replay_segment(segment.second, visit, max_lsn, err)) {
+      return false;
+    }
+  }
+  return replay_segment(path, visit, max_lsn, err);
+}
+
+// 删除 path 的全部归档段；remove_active 为 true 时同时删除活动段。
+bool remove_segments(const std::string& path, bool remove_active, std::string* err) {
+  for (const auto& segment : archived_segments(path)) {
+    if (std::remove(segment.second.c_str()) != 0 && errno != ENOENT) {
+      if (err) {
+        *err = "failed to remove log segment: " + segment.second;
+      }
+      return false;
+    }
+  }
+  if (remove_active && std::remove(path.c_str()) != 0 && errno != ENOENT) {
     if (err) {
-      *err = "failed to write log entry";
+      *err = "failed to remove log segment: " + path;
     }
     return false;
   }
   return true;
 }
 
-bool LogManager::read_all(std::vector<LogEntry>* entries, std::string* err) const {
-  std::lock_guard<std::mutex> lock(mutex_);
-  // 顺序读取日志文件并解析。
-  if (!entries) {
+}  // namespace
+
+void LogStats::add(const LogStats& other) {
+  records += other.records;
+  bytes += other.bytes;
+  buffer_full_waits += other.buffer_full_waits;
+  fsync_latency.add(other.fsync_latency);
+  commit_wait.add(other.commit_wait);
+}
+
+LogPartition::LogPartition(const std::string& path, int node, int alloc_node,
+                           NumaAllocator* allocator, const LogOptions& options)
+    : path_(path),
+      node_(node),
+      options_(options),
+      buffer_(options.max_buffer_bytes, alloc_node, allocator),
+      write_buffer_(options.max_buffer_bytes, alloc_node, allocator) {}
+
+LogPartition::~LogPartition() {
+  close();
+}
+
+bool LogPartition::append(LogOp op, uint32_t table_id, uint64_t row_id,
+                          const std::vector<char>& data, uint64_t* lsn, std::string* err) {
+  size_t record_size = kRecordHeaderSize + data.size();
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (fd_ < 0) {
     if (err) {
-      *err = "entries output missing";
+      *err = "log not open";
     }
     return false;
   }
-  entries->clear();
-  std::ifstream file(path_);
-  if (!file.is_open()) {
+  // 刷盘线程在锁内交换 buffer_ 与 write_buffer_，缓冲大小须在持锁后读取。
+  if (record_size > buffer_.size()) {
+    if (err) {
+      *err = "log record too large";
+    }
+    return false;
+  }
+  if (buffer_used_ + record_size > buffer_.size()) {
+    // 反压：缓冲区写满时等待刷盘线程交换缓冲。
+    buffer_full_waits_.add();
+    flush_requested_ = true;
+    flush_cv_.notify_one();
+    durable_cv_.wait(lock, [this, record_size]() {
+      return buffer_used_ + record_size <= buffer_.size() || !io_error_.empty();
+    });
+  }
+  if (!io_error_.empty()) {
+    if (err) {
+      *err = io_error_;
+    }
+    return false;
+  }
+  bool was_empty = buffer_used_ == 0;
+  uint64_t record_lsn = next_lsn_++;
+  buffer_used_ += encode_record(op, record_lsn, table_id, row_id, data.data(), data.size(),
+                                buffer_.data() + buffer_used_);
+  buffered_lsn_ = record_lsn;
+  size_bytes_.fetch_add(record_size);
+  records_.add();
+  bytes_.add(record_size);
+  if (lsn) {
+    *lsn = record_lsn;
+  }
+  // 只在需要时唤醒刷盘线程：同步模式每次提交、其余模式首条记录或缓冲达到阈值。
+  if (options_.commit_mode == CommitMode::Sync || was_empty ||
+      buffer_used_ >= options_.group_flush_bytes) {
+    flush_cv_.notify_one();
+  }
+  return true;
+}
+
+bool LogPartition::wait_durable(uint64_t lsn, std::string* err) {
+  if (lsn == 0) {
     return true;
   }
-  std::string line;
-  while (std::getline(file, line)) {
-    if (line.empty()) {
-      continue;
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (options_.commit_mode != CommitMode::Async && durable_lsn_ < lsn) {
+    uint64_t start = metric_now_ns();
+    durable_cv_.wait(lock, [this, lsn]() { return durable_lsn_ >= lsn || !io_error_.empty(); });
+    commit_wait_.record(metric_now_ns() - start);
+  }
+  if (!io_error_.empty()) {
+    if (err) {
+      *err = io_error_;
+    }
+    return false;
+  }
+  return true;
+}
+
+bool LogPartition::flush(std::string* err) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  return drain_locked(&lock, err);
+}
+
+bool LogPartition::flush_to(uint64_t lsn, std::string* err) {
+  if (lsn == 0) {
+    return true;
+  }
+  std::unique_lock<std::mutex> lock(mutex_);
+  // 超出已追加范围的 LSN 不可能再落盘，按已追加的最大 LSN 处理。
+  lsn = std::min(lsn, buffered_lsn_);
+  if (durable_lsn_ < lsn && fd_ >= 0) {
+    // 只等到 lsn 落盘，不等待其后追加的记录（与 drain 不同，持续写入时也能及时返回）。
+    flush_requested_ = true;
+    flush_cv_.notify_one();
+    durable_cv_.wait(lock, [this, lsn]() { return durable_lsn_ >= lsn || !io_error_.empty(); });
+  }
+  if (!io_error_.empty()) {
+    if (err) {
+      *err = io_error_;
+    }
+    return false;
+  }
+  return true;
+}
+
+bool LogPartition::drain_locked(std::unique_lock<std::mutex>* lock, std::string* err) {
+  if (fd_ < 0) {
+    return true;
+  }
+  if (buffer_used_ > 0 || flushing_) {
+    flush_requested_ = true;
+    flush_cv_.notify_one();
+    durable_cv_.wait(*lock, [this]() {
+      return (buffer_used_ == 0 && !flushing_) || !io_error_.empty();
+    });
+  }
+  if (!io_error_.empty()) {
+    if (err) {
+      *err = io_error_;
     }
-    // 以 '|' 分隔字段，解析失败则忽略该行。
-    std::vector<std::string> parts;
-    std::stringstream ss(line);
-    std::string segment;
-    while (std::getline(ss, segment, '|')) {
-      parts.push_back(segment);
+    return false;
+  }
+  return true;
+}
+
+void LogPartition::flush_loop() {
+  if (is_numa_enabled()) {
+    // 刷盘线程与该分区的缓冲、写入方位于同一节点。
+    std::string bind_err;
+    bind_thread_to_node(node_, &bind_err);
+  }
+  MINI_DB_TRACE_THREAD_NAME("log flusher node " + std::to_string(node_));
+  std::unique_lock<std::mutex> lock(mutex_);
+  for (;;) {
+    flush_cv_.wait(lock, [this]() { return stop_ || buffer_used_ > 0; });
+    if (buffer_used_ == 0) {
+      return;
     }
-    if (parts.size() < 5) {
-      continue;
+    if (options_.commit_mode != CommitMode::Sync && !stop_ && !flush_requested_) {
+      // 组提交：等待更多提交加入本批，直到超时、缓冲达到阈值或有人要求立即刷盘。
+      auto deadline =
+          std::chrono::steady_clock::now() + std::chrono::microseconds(options_.group_delay_us);
+      flush_cv_.wait_until(lock, deadline, [this]() {
+        return stop_ || flush_requested_ || buffer_used_ >= options_.group_flush_bytes;
+      });
     }
-    LogEntry entry;
-    try {
-      entry.lsn = std::stoull(parts[0]);
-      entry.op = parts[1];
-      entry.table = parts[2];
-      entry.row_id = std::stoull(parts[3]);
-    } catch (...) {
-      continue;
+    flush_requested_ = false;
+    std::swap(buffer_, write_buffer_);
+    write_used_ = buffer_used_;
+    buffer_used_ = 0;
+    uint64_t target = buffered_lsn_;
+    int fd = fd_;
+    flushing_ = true;
+    // 缓冲已交换，唤醒因反压等待的追加方。
+    durable_cv_.notify_all();
+    lock.unlock();
+    // 在锁外完成写入与 fdatasync，期间追加方继续写入 buffer_。
+    std::string io_err;
+    uint64_t start = metric_now_ns();
+    bool ok;
+    {
+      MINI_DB_TRACE_SPAN("log.flush");
+      ok = write_fully(fd, write_buffer_.data(), write_used_, &io_err) && sync_fd(fd, &io_err);
     }
-    std::vector<char> data;
-    if (!hex_decode(parts[4], &data)) {
-      continue;
+    fsync_latency_.record(metric_now_ns() - start);
+    lock.lock();
+    write_used_ = 0;
+    flushing_ = false;
+    if (ok) {
+      durable_lsn_ = target;
+    } else {
+      io_error_ = io_err;
     }
-    entry.data = std::move(data);
-    entries->push_back(std::move(entry));
+    durable_cv_.notify_all();
+  }
+}
+
+bool LogPartition::open_active_locked(uint64_t* checkpoint_lsn, std::string* err) {
+  fd_ = ::open(path_.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+  if (fd_ < 0) {
+    if (err) {
+      *err = "failed to open log file: " + path_;
+    }
+    return false;
+  }
+  // 新段以 CHECKPOINT 记录开头，重启后 LSN 仍能保持递增。
+  uint64_t lsn = next_lsn_++;
+  char head[sizeof(kSegmentMagic) + kRecordHeaderSize];
+  std::memcpy(head, kSegmentMagic, sizeof(kSegmentMagic));
+  encode_record(LogOp::Checkpoint, lsn, 0, 0, nullptr, 0, head + sizeof(kSegmentMagic));
+  if (!write_fully(fd_, head, sizeof(head), err) || !sync_fd(fd_, err)) {
+    ::close(fd_);
+    fd_ = -1;
+    return false;
+  }
+  durable_lsn_ = lsn;
+  buffered_lsn_ = lsn;
+  size_bytes_.store(0);
+  if (checkpoint_lsn) {
+    *checkpoint_lsn = lsn;
+  }
+  if (!flusher_.joinable()) {
+    stop_ = false;
+    flusher_ = std::thread([this]() { flush_loop(); });
   }
   return true;
 }
 
-void LogManager::clear(std::string* err) {
+bool LogPartition::replay(const LogVisitor& visit, std::string* err) {
   std::lock_guard<std::mutex> lock(mutex_);
-  // 截断日志文件，用于检查点之后清理。
-  std::ofstream file(path_, std::ios::out | std::ios::trunc);
-  if (!file.is_open()) {
+  // 先读归档段再读活动段，保证按 LSN 顺序重放。
+  uint64_t max_lsn = 0;
+  if (!replay_segments(path_, visit, &max_lsn, err)) {
+    return false;
+  }
+  // 重启后继续沿用递增的 LSN。
+  if (max_lsn >= next_lsn_) {
+    next_lsn_ = max_lsn + 1;
+  }
+  return true;
+}
+
+bool LogPartition::clear(std::string* err) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  // 删除全部归档段并重建活动段，用于恢复完成之后清理。
+  if (!drain_locked(&lock, err)) {
+    return false;
+  }
+  if (fd_ >= 0) {
+    ::close(fd_);
+    fd_ = -1;
+  }
+  if (!remove_segments(path_, false, err)) {
+    return false;
+  }
+  return open_active_locked(nullptr, err);
+}
+
+void LogPartition::close() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  std::string err;
+  drain_locked(&lock, &err);
+  stop_ = true;
+  flush_cv_.notify_all();
+  lock.unlock();
+  if (flusher_.joinable()) {
+    flusher_.join();
+  }
+  lock.lock();
+  if (fd_ >= 0) {
+    ::close(fd_);
+    fd_ = -1;
+  }
+}
+
+bool LogPartition::rotate(uint64_t* checkpoint_lsn, std::string* err) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  // 先让缓冲中的记录全部落盘，检查点 LSN 之前的记录全部位于被归档的段中。
+  if (!drain_locked(&lock, err)) {
+    return false;
+  }
+  if (fd_ >= 0) {
+    ::close(fd_);
+    fd_ = -1;
+  }
+  std::string archived = path_ + "." + std::to_string(next_lsn_);
+  if (std::rename(path_.c_str(), archived.c_str()) != 0 && errno != ENOENT) {
     if (err) {
-      *err = "failed to truncate log";
+      *err = "failed to archive log segment";
+    }
+    return false;
+  }
+  return open_active_locked(checkpoint_lsn, err);
+}
+
+bool LogPartition::purge(uint64_t checkpoint_lsn, std::string* err) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (const auto& segment : archived_segments(path_)) {
+    if (segment.first > checkpoint_lsn) {
+      continue;
+    }
+    if (std::remove(segment.second.c_str()) != 0 && errno != ENOENT) {
+      if (err) {
+        *err = "failed to remove log segment: " + segment.second;
+      }
+      return false;
+    }
+  }
+  return true;
+}
+
+size_t LogPartition::size_bytes() const {
+  return size_bytes_.load();
+}
+
+uint64_t LogPartition::next_lsn() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return next_lsn_;
+}
+
+uint64_t LogPartition::durable_lsn() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return durable_lsn_;
+}
+
+const std::string& LogPartition::path() const {
+  return path_;
+}
+
+LogStats LogPartition::stats() const {
+  LogStats stats;
+  stats.records = records_.value();
+  stats.bytes = bytes_.value();
+  stats.buffer_full_waits = buffer_full_waits_.value();
+  stats.fsync_latency = fsync_latency_.snapshot();
+  stats.commit_wait = commit_wait_.snapshot();
+  return stats;
+}
+
+LogManager::LogManager(const std::string& path, int partitions, const LogOptions& options)
+    : path_(path), options_(options), allocator_(create_numa_allocator()) {
+  if (partitions <= 0) {
+    partitions = 1;
+  }
+  // 与缓冲池一致：未启用 NUMA 时所有分区缓冲分配在强制节点（默认 0）上。
+  int alloc_node = is_numa_enabled() ? -1 : forced_numa_alloc_node();
+  if (!is_numa_enabled() && alloc_node < 0) {
+    alloc_node = 0;
+  }
+  partitions_.reserve(static_cast<size_t>(partitions));
+  for (int i = 0; i < partitions; ++i) {
+    int node_id = (alloc_node >= 0) ? alloc_node : i;
+    partitions_.push_back(std::make_unique<LogPartition>(path_ + ".n" + std::to_string(i), i,
+                                                         node_id, allocator_.get(), options_));
+  }
+}
+
+LogManager::~LogManager() {
+  close();
+}
+
+int LogManager::partition_count() const {
+  return static_cast<int>(partitions_.size());
+}
+
+int LogManager::partition_for_node(int node) const {
+  int count = partition_count();
+  if (node < 0) {
+    return 0;
+  }
+  return node % count;
+}
+
+bool LogManager::append(int partition, LogOp op, uint32_t table_id, uint64_t row_id,
+                        const std::vector<char>& data, uint64_t* lsn, std::string* err) {
+  MINI_DB_TRACE_SPAN("log.append");
+  return partitions_[static_cast<size_t>(partition_for_node(partition))]->append(
+      op, table_id, row_id, data, lsn, err);
+}
+
+bool LogManager::wait_durable(int partition, uint64_t lsn, std::string* err) {
+  MINI_DB_TRACE_SPAN("log.commit_wait");
+  return partitions_[static_cast<size_t>(partition_for_node(partition))]->wait_durable(lsn, err);
+}
+
+bool LogManager::flush(std::string* err) {
+  for (auto& partition : partitions_) {
+    if (!partition->flush(err)) {
+      return false;
     }
+  }
+  return true;
+}
+
+bool LogManager::flush_to(int partition, uint64_t lsn, std::string* err) {
+  return partitions_[static_cast<size_t>(partition_for_node(partition))]->flush_to(lsn, err);
+}
+
+uint64_t LogManager::durable_lsn(int partition) const {
+  return partitions_[static_cast<size_t>(partition_for_node(partition))]->durable_lsn();
+}
+
+bool LogManager::replay(int partition, const LogVisitor& visit, std::string* err) {
+  return partitions_[static_cast<size_t>(partition_for_node(partition))]->replay(visit, err);
+}
+
+bool LogManager::replay_legacy(const LogVisitor& visit, std::string* err) {
+  return replay_segments(path_, visit, nullptr, err);
+}
+
+void LogManager::clear(std::string* err) {
+  if (!remove_segments(path_, true, err)) {
     return;
   }
+  for (auto& partition : partitions_) {
+    if (!partition->clear(err)) {
+      return;
+    }
+  }
+}
+
+void LogManager::close() {
+  for (auto& partition : partitions_) {
+    partition->close();
+  }
+}
+
+bool LogManager::rotate(std::vector<uint64_t>* checkpoint_lsns, std::string* err) {
+  std::vector<uint64_t> lsns(partitions_.size(), 0);
+  for (size_t i = 0; i < partitions_.size(); ++i) {
+    if (!partitions_[i]->rotate(&lsns[i], err)) {
+      return false;
+    }
+  }
+  if (checkpoint_lsns) {
+    *checkpoint_lsns = std::move(lsns);
+  }
+  return true;
+}
+
+bool LogManager::purge(const std::vector<uint64_t>& checkpoint_lsns, std::string* err) {
+  for (size_t i = 0; i < partitions_.size() && i < checkpoint_lsns.size(); ++i) {
+    if (!partitions_[i]->purge(checkpoint_lsns[i], err)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+size_t LogManager::size_bytes() const {
+  size_t total = 0;
+  for (const auto& partition : partitions_) {
+    total += partition->size_bytes();
+  }
+  return total;
+}
+
+size_t LogManager::size_bytes(int partition) const {
+  return partitions_[static_cast<size_t>(partition_for_node(partition))]->size_bytes();
+}
+
+CommitMode LogManager::commit_mode() const {
+  return options_.commit_mode;
+}
+
+LogStats LogManager::stats() const {
+  LogStats total;
+  for (const auto& partition : partitions_) {
+    total.add(partition->stats());
+  }
+  return total;
+}
+
+LogStats LogManager::stats(int partition) const {
+  if (partition < 0 || partition >= static_cast<int>(partitions_.size())) {
+    return LogStats{};
+  }
+  return partitions_[static_cast<size_t>(partition)]->stats();
 }
 
 }  // namespace mini_db
@@ -0,0 +1,172 @@
+#include "db/Lz4.h"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace mini_db {
+
+namespace {
+
+// 最短匹配长度；最后一个匹配须在块尾 12 字节之前开始，块尾 5 字节总是字面量（LZ4 块格式约束）。
+constexpr size_t kMinMatch = 4;
+constexpr size_t kMatchStartLimit = 12;
+constexpr size_t kLastLiterals = 5;
+constexpr size_t kMaxOffset = 65535;
+constexpr size_t kHashBits = 12;
+
+uint32_t read32(const char* p) {
+  uint32_t value;
+  std::memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+uint32_t hash32(uint32_t value) {
+  return (value * 2654435761u) >> (32 - kHashBits);
+}
+
+// 写出长度字段超过 15 的部分（每字节 255，最后一字节为余数）。
+bool write_length(size_t length, char* dst, size_t capacity, size_t* pos) {
+  while (length >= 255) {
+    if (*pos >= capacity) {
+      return false;
+    }
+    dst[(*pos)++] = static_cast<char>(255);
+    length -= 255;
+  }
+  if (*pos >= capacity) {
+    return false;
+  }
+  dst[(*pos)++] = static_cast<char>(length);
+  return true;
+}
+
+// 写出一个序列：literal_size 字节字面量，之后是偏移为 offset、长度为 match_size 的匹配
+//（match_size 为 0 表示块尾的纯字面量序列）。
+bool write_sequence(const char* literals, size_t literal_size, size_t offset, size_t match_size,
+                    char* dst, size_t capacity, size_t* pos) {
+  if (*pos >= capacity) {
+    return false;
+  }
+  size_t token_pos = (*pos)++;
+  size_t match_code = match_size > 0 ? match_size - kMinMatch : 0;
+  uint8_t token = static_cast<uint8_t>((literal_size >= 15 ? 15 : literal_size) << 4);
+  token |= static_cast<uint8_t>(match_code >= 15 ? 15 : match_code);
+  dst[token_pos] = static_cast<char>(token);
+  if (literal_size >= 15 && !write_length(literal_size - 15, dst, capacity, pos)) {
+    return false;
+  }
+  if (*pos + literal_size > capacity) {
+    return false;
+  }
+  std::memcpy(dst + *pos, literals, literal_size);
+  *pos += literal_size;
+  if (match_size == 0) {
+    return true;
+  }
+  if (*pos + 2 > capacity) {
+    return false;
+  }
+  dst[(*pos)++] = static_cast<char>(offset & 0xFF);
+  dst[(*pos)++] = static_cast<char>((offset >> 8) & 0xFF);
+  return match_code < 15 || write_length(match_code - 15, dst, capacity, pos);
+}
+
+// 读取长度字段的扩展字节。
+bool read_length(const char* src, size_t size, size_t* pos, size_t* length) {
+  for (;;) {
+    if (*pos >= size) {
+      return false;
+    }
+    uint8_t byte = static_cast<uint8_t>(src[(*pos)++]);
+    *length += byte;
+    if (byte != 255) {
+      return true;
+    }
+  }
+}
+
+}  // namespace
+
+size_t lz4_compress(const char* src, size_t size, char* dst, size_t capacity) {
+  // 哈希表记录最近出现过的 4 字节序列的位置，每线程复用。
+  thread_local std::vector<int32_t> table;
+  table.assign(static_cast<size_t>(1) << kHashBits, -1);
+  size_t pos = 0;
+  size_t anchor = 0;
+  size_t ip = 0;
+  if (size > kMatchStartLimit) {
+    size_t match_limit = size - kMatchStartLimit;
+    size_t match_end_limit = size - kLastLiterals;
+    while (ip <= match_limit) {
+      uint32_t sequence = read32(src + ip);
+      uint32_t h = hash32(sequence);
+      int32_t ref = table[h];
+      table[h] = static_cast<int32_t>(ip);
+      if (ref < 0 || ip - static_cast<size_t>(ref) > kMaxOffset ||
+          read32(src + ref) != sequence) {
+        ++ip;
+        continue;
+      }
+      size_t match = static_cast<size_t>(ref);
+      size_t length = kMinMatch;
+      while (ip + length < match_end_limit && src[match + length] == src[ip + length]) {
+        ++length;
+      }
+      if (!write_sequence(src + anchor, ip - anchor, ip - match, length, dst, capacity, &pos)) {
+        return 0;
+      }
+      ip += length;
+      anchor = ip;
+    }
+  }
+  if (!write_sequence(src + anchor, size - anchor, 0, 0, dst, capacity, &pos)) {
+    return 0;
+  }
+  return pos;
+}
+
+bool lz4_decompress(const char* src, size_t size, char* dst, size_t expected) {
+  size_t ip = 0;
+  size_t op = 0;
+  while (ip < size) {
+    uint8_t token = static_cast<uint8_t>(src[ip++]);
+    size_t literal_size = token >> 4;
+    if (literal_size == 15 && !read_length(src, size, &ip, &literal_size)) {
+      return false;
+    }
+    if (ip + literal_size > size || op + literal_size > expected) {
+      return false;
+    }
+    std::memcpy(dst + op, src + ip, literal_size);
+    ip += literal_size;
+    op += literal_size;
+    if (ip == size) {
+      // 最后一个序列只有字面量。
+      break;
+    }
+    if (ip + 2 > size) {
+      return false;
+    }
+    size_t offset = static_cast<uint8_t>(src[ip]) |
+                    (static_cast<size_t>(static_cast<uint8_t>(src[ip + 1])) << 8);
+    ip += 2;
+    size_t match_size = token & 0x0F;
+    if (match_size == 15 && !read_length(src, size, &ip, &match_size)) {
+      return false;
+    }
+    match_size += kMinMatch;
+    if (offset == 0 || offset > op || op + match_size > expected) {
+      return false;
+    }
+    // 匹配可能与输出重叠（偏移小于长度），逐字节复制。
+    const char* match = dst + op - offset;
+    for (size_t i = 0; i < match_size; ++i) {
+      dst[op + i] = match[i];
+    }
+    op += match_size;
+  }
+  return op == expected;
+}
+
+}  // namespace mini_db
@@ -0,0 +1,89 @@
+#include "db/Metrics.h"
+
+#include <chrono>
+
+namespace mini_db {
+
+namespace {
+
+size_t bucket_for(uint64_t ns) {
+  size_t bucket = 0;
+  while (ns > 0 && bucket + 1 < kHistogramBuckets) {
+    ns >>= 1;
+    ++bucket;
+  }
+  return bucket;
+}
+
+}  // namespace
+
+size_t metric_stripe() {
+  static std::atomic<size_t> next{0};
+  thread_local size_t index = next.fetch_add(1, std::memory_order_relaxed) % kMetricStripes;
+  return index;
+}
+
+uint64_t metric_now_ns() {
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                   std::chrono::steady_clock::now().time_since_epoch())
+                                   .count());
+}
+
+uint64_t Counter::value() const {
+  uint64_t total = 0;
+  for (const Stripe& stripe : stripes_) {
+    total += stripe.value.load(std::memory_order_relaxed);
+  }
+  return total;
+}
+
+void HistogramSnapshot::add(const HistogramSnapshot& other) {
+  count += other.count;
+  sum_ns += other.sum_ns;
+  for (size_t i = 0; i < kHistogramBuckets; ++i) {
+    buckets[i] += other.buckets[i];
+  }
+}
+
+uint64_t HistogramSnapshot::percentile_ns(double q) const {
+  uint64_t total = 0;
+  for (uint64_t bucket : buckets) {
+    total += bucket;
+  }
+  if (total == 0) {
+    return 0;
+  }
+  uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(total));
+  if (rank >= total) {
+    rank = total - 1;
+  }
+  uint64_t seen = 0;
+  for (size_t i = 0; i < kHistogramBuckets; ++i) {
+    seen += buckets[i];
+    if (seen > rank) {
+      return i == 0 ? 0 : (static_cast<uint64_t>(1) << i) - 1;
+    }
+  }
+  return (static_cast<uint64_t>(1) << (kHistogramBuckets - 1)) - 1;
+}
+
+void LatencyHistogram::record(uint64_t ns) {
+  Stripe& stripe = stripes_[metric_stripe()];
+  stripe.count.fetch_add(1, std::memory_order_relaxed);
+  stripe.sum_ns.fetch_add(ns, std::memory_order_relaxed);
+  stripe.buckets[bucket_for(ns)].fetch_add(1, std::memory_order_relaxed);
+}
+
+HistogramSnapshot LatencyHistogram::snapshot() const {
+  HistogramSnapshot snapshot;
+  for (const Stripe& stripe : stripes_) {
+    snapshot.count += stripe.count.load(std::memory_order_relaxed);
+    snapshot.sum_ns += stripe.sum_ns.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < kHistogramBuckets; ++i) {
+      snapshot.buckets[i] += stripe.buckets[i].load(std::memory_order_relaxed);
+    }
+  }
+  return snapshot;
+}
+
+}  // namespace mini_db
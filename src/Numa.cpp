@@ -7,6 +7,7 @@
 
 #ifdef HAVE_LIBNUMA
 #include <numa.h>
+#include <numaif.h>
 #include <sched.h>
 #else
 #include <sched.h>
@@ -177,4 +178,32 @@ std::unique_ptr<NumaAllocator> create_numa_allocator() {
   return std::make_unique<FallbackAllocator>();
 }
 
+bool bind_memory_to_node(void* addr, size_t size, int node) {
+#ifdef HAVE_LIBNUMA
+  if (is_numa_enabled() && numa_available() >= 0 && node >= 0 && node <= numa_max_node()) {
+    numa_tonode_memory(addr, size, node);
+    return true;
+  }
+#endif
+  (void)addr;
+  (void)size;
+  (void)node;
+  return false;
+}
+
+int memory_node_of(const void* addr) {
+#ifdef HAVE_LIBNUMA
+  if (addr && numa_available() >= 0) {
+    // nodes 为空时 move_pages 只查询：status 为所在节点，未分配的页为负的错误码。
+    void* pages[1] = {const_cast<void*>(addr)};
+    int status[1] = {-1};
+    if (numa_move_pages(0, 1, pages, nullptr, status, 0) == 0 && status[0] >= 0) {
+      return status[0];
+    }
+  }
+#endif
+  (void)addr;
+  return -1;
+}
+
 }  // namespace mini_db
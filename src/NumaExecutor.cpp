@@ -1,12 +1,27 @@
 #include "db/NumaExecutor.h"
 
 #include "db/Numa.h"
+#include "db/NumaMetrics.h"
+#include "db/Trace.h"
+
+#include <chrono>
 
 namespace mini_db {
 
+namespace {
+
+// 当前线程所属的工作线程（非工作线程为 nullptr），用于把工作线程自己提交的任务放入本地队列。
+thread_local void* tls_worker = nullptr;
+
+}  // namespace
+
 NumaExecutor::NumaExecutor(int nodes, int threads_per_node)
+    : NumaExecutor(nodes, threads_per_node, NumaExecutorOptions{}) {}
+
+NumaExecutor::NumaExecutor(int nodes, int threads_per_node, const NumaExecutorOptions& options)
     : nodes_(nodes > 0 ? nodes : 1),
-      threads_per_node_(threads_per_node > 0 ? threads_per_node : 1) {}
+      threads_per_node_(threads_per_node > 0 ? threads_per_node : 1),
+      options_(options) {}
 
 NumaExecutor::~NumaExecutor() {
   stop();
@@ -20,24 +35,27 @@ void NumaExecutor::start() {
     // 如果已经启动了，就直接返回，避免重复创建线程
     return;
   }
-  running_ = true;
-  // 清空并预分配 groups_
+  stop_.store(false);
+  // 先建好全部线程组与队列再启动线程：工作线程会跨组窃取。
   groups_.clear();
   groups_.reserve(static_cast<size_t>(nodes_));
   for (int node = 0; node < nodes_; ++node) {
-    // 为每个 NUMA 节点创建一个 WorkerGroup
     auto group = std::make_unique<WorkerGroup>();
-    group->node = node;  // 记录这个组属于哪个 numa 节点（后续可能用于绑核/绑内存）
-    group->stop = false; // 初始化停止标志，让 worker_loop 能正常跑
-    group->threads.reserve(static_cast<size_t>(threads_per_node_)); // 每个 WorkerGroup 里启动 threads_per_node_ 个工作线程
+    group->node = node;  // 记录这个组属于哪个 numa 节点，工作线程启动后绑定到该节点
+    group->workers.reserve(static_cast<size_t>(threads_per_node_));
     for (int i = 0; i < threads_per_node_; ++i) {
-      // 每个节点启动 threads_per_node 个工作线程。
-      WorkerGroup* group_ptr = group.get();
-      // 每个工作线程都跑同一个 worker_loop(group_ptr) ，从对应 group 的任务队列里取任务执行
-      group->threads.emplace_back([this, group_ptr]() { worker_loop(group_ptr); });
+      group->workers.push_back(std::make_unique<Worker>(this, node, static_cast<size_t>(i),
+                                                        options_.queue_capacity));
     }
     groups_.push_back(std::move(group));
   }
+  running_ = true;
+  for (auto& group : groups_) {
+    for (auto& worker : group->workers) {
+      Worker* worker_ptr = worker.get();
+      worker->thread = std::thread([this, worker_ptr]() { worker_loop(worker_ptr); });
+    }
+  }
 }
 
 void NumaExecutor::stop() {
@@ -45,22 +63,17 @@ void NumaExecutor::stop() {
   if (!running_) {
     return;
   }
-  for (auto& group_ptr : groups_) {
-    WorkerGroup& group = *group_ptr;
-    {
-      std::lock_guard<std::mutex> lock(group.mutex);
-      group.stop = true;
-    }
-    group.cv.notify_all();
+  stop_.store(true);
+  for (auto& group : groups_) {
+    std::lock_guard<std::mutex> lock(group->mutex);
+    group->cv.notify_all();
   }
-  for (auto& group_ptr : groups_) {
-    WorkerGroup& group = *group_ptr;
-    for (auto& thread : group.threads) {
-      if (thread.joinable()) {
-        thread.join();
+  for (auto& group : groups_) {
+    for (auto& worker : group->workers) {
+      if (worker->thread.joinable()) {
+        worker->thread.join();
       }
     }
-    group.threads.clear();
   }
   groups_.clear();
   running_ = false;
@@ -70,8 +83,43 @@ int NumaExecutor::node_count() const {
   return nodes_;
 }
 
-void NumaExecutor::enqueue(int node, std::function<void()> task) {
-  // 将任务路由到指定节点队列。
+std::future<void> NumaExecutor::submit_batch(int node, std::vector<Task> tasks) {
+  return submit(node, [tasks = std::move(tasks)]() mutable {
+    for (auto& task : tasks) {
+      task();
+    }
+  });
+}
+
+NumaExecutorStats NumaExecutor::stats() const {
+  NumaExecutorStats total;
+  for (int node = 0; node < static_cast<int>(groups_.size()); ++node) {
+    NumaExecutorStats stats_node = stats(node);
+    total.executed += stats_node.executed;
+    total.stolen_local += stats_node.stolen_local;
+    total.stolen_remote += stats_node.stolen_remote;
+    total.queued += stats_node.queued;
+    total.task_time.add(stats_node.task_time);
+  }
+  return total;
+}
+
+NumaExecutorStats NumaExecutor::stats(int node) const {
+  NumaExecutorStats stats_node;
+  if (node < 0 || node >= static_cast<int>(groups_.size())) {
+    return stats_node;
+  }
+  const WorkerGroup& group = *groups_[static_cast<size_t>(node)];
+  stats_node.executed = group.executed.load(std::memory_order_relaxed);
+  stats_node.stolen_local = group.stolen_local.load(std::memory_order_relaxed);
+  stats_node.stolen_remote = group.stolen_remote.load(std::memory_order_relaxed);
+  stats_node.queued = group.pending.load(std::memory_order_relaxed);
+  stats_node.task_time = group.task_time.snapshot();
+  return stats_node;
+}
+
+void NumaExecutor::enqueue(int node, Task task) {
+  // 将任务路由到指定节点。
   if (!running_) {
     return;
   }
@@ -83,45 +131,152 @@ void NumaExecutor::enqueue(int node, std::function<void()> task) {
     target = target % nodes_;
   }
   WorkerGroup& group = *groups_[static_cast<size_t>(target)];
-  {
-    std::lock_guard<std::mutex> lock(group.mutex);  // 加锁保护队列
-    group.tasks.push_back(std::move(task));         // 把任务入队 FIFO
+  size_t count = group.workers.size();
+  Worker* self = static_cast<Worker*>(tls_worker);
+  if (self && self->owner != this) {
+    self = nullptr;
+  }
+  if (numa_metrics()) {
+    record_numa_submit(target, self ? self->node : numa_metrics_current_node());
+  }
+#ifdef MINI_DB_TRACE
+  task.enqueued_at = trace_enabled() ? trace_clock() : 0;
+#endif
+  // 工作线程提交给本节点时放入自己的队列，其余提交在本节点各线程间轮转。
+  size_t first = self && self->node == target
+                     ? self->index
+                     : group.next.fetch_add(1, std::memory_order_relaxed) % count;
+  group.pending.fetch_add(1);
+  for (;;) {
+    for (size_t i = 0; i < count; ++i) {
+      Worker* worker = group.workers[(first + i) % count].get();
+      if (worker->queue.try_push(&task)) {
+        wake(&group);
+        if (options_.remote_steal_threshold > 0 &&
+            worker->queue.size_approx() > options_.remote_steal_threshold) {
+          // 该线程队列积压过多：唤醒其他节点的一个休眠线程来窃取。
+          for (auto& other : groups_) {
+            if (other.get() != &group && other->sleepers.load() > 0) {
+              wake(other.get());
+              break;
+            }
+          }
+        }
+        return;
+      }
+    }
+    if (self) {
+      // 队列全满且提交方是工作线程：就地执行，避免所有线程都在等待队列空位。
+      group.pending.fetch_sub(1);
+      task();
+      group.executed.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    // 队列全满：让出 CPU 等待工作线程消费。
+    std::this_thread::yield();
   }
-  group.cv.notify_one();    // 唤醒该节点上一个等待中的工作线程来执行任务
+}
+
+void NumaExecutor::wake(WorkerGroup* group) {
+  if (group->sleepers.load() == 0) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(group->mutex);
+  group->cv.notify_one();
+}
+
+bool NumaExecutor::take(Worker* worker, Task* task) {
+  WorkerGroup& group = *groups_[static_cast<size_t>(worker->node)];
+  if (worker->queue.try_pop(task)) {
+    group.pending.fetch_sub(1);
+    return true;
+  }
+  // 本节点其他线程的队列：任务访问的仍是本节点内存。
+  size_t count = group.workers.size();
+  for (size_t i = 1; i < count; ++i) {
+    Worker* victim = group.workers[(worker->index + i) % count].get();
+    if (victim->queue.try_pop(task)) {
+      group.pending.fetch_sub(1);
+      group.stolen_local.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+  }
+  if (options_.remote_steal_threshold == 0) {
+    return false;
+  }
+  // 远端节点：只从自身队列积压超过阈值的线程窃取，以局部性换取负载均衡。
+  // 按单个线程的队列长度判断：节点总积压随在途任务数与线程数增长，不能说明某个线程处理不过来。
+  for (int i = 1; i < nodes_; ++i) {
+    WorkerGroup& other = *groups_[static_cast<size_t>((worker->node + i) % nodes_)];
+    for (auto& victim : other.workers) {
+      if (victim->queue.size_approx() <= options_.remote_steal_threshold) {
+        continue;
+      }
+      if (victim->queue.try_pop(task)) {
+        other.pending.fetch_sub(1);
+        group.stolen_remote.fetch_add(1, std::memory_order_relaxed);
+        return true;
+      }
+    }
+  }
+  return false;
 }
 
 /**
  * @brief worker_loop 是每个 NUMA 节点工作线程的主循环，职责是绑定线程 + 循环取任务执行
- * 
- * @param group 
+ *
+ * @param worker
  */
-void NumaExecutor::worker_loop(WorkerGroup* group) {
-  if (!group) {
-    return;
-  }
+void NumaExecutor::worker_loop(Worker* worker) {
+  tls_worker = worker;
   // 将线程绑定到对应 NUMA 节点。
   std::string err;
-  bind_thread_to_node(group->node, &err);
-  // 线程绑定到固定 NUMA 节点后，按队列顺序执行任务，只有在 stop 且队列空时退出
+  bind_thread_to_node(worker->node, &err);
+  MINI_DB_TRACE_THREAD_NAME("executor node " + std::to_string(worker->node) + " #" +
+                            std::to_string(worker->index));
+  WorkerGroup& group = *groups_[static_cast<size_t>(worker->node)];
+  int idle = 0;
   for (;;) {
-    std::function<void()> task;
-    {
-      // 在 lock 的作用域内，当前线程独占 group->mutex ，其他线程如果也试图锁同一个 mutext，会被阻塞（同一个 group 对象里只有一把锁 mutex）
-      std::unique_lock<std::mutex> lock(group->mutex);
-      group->cv.wait(lock, [&group]() { return group->stop || !group->tasks.empty(); });
-      if (group->stop && group->tasks.empty()) {
-        return;
+    Task task;
+    if (take(worker, &task)) {
+#ifdef MINI_DB_TRACE
+      if (task.enqueued_at != 0) {
+        trace_record("executor.queue", task.enqueued_at, trace_clock());
       }
-
-      // 从队列头取出一个任务并移除
-      task = std::move(group->tasks.front());
-      group->tasks.pop_front();
+#endif
+      uint64_t start = metric_now_ns();
+      {
+        MINI_DB_TRACE_SPAN("executor.task");
+        task();
+      }
+      group.task_time.record(metric_now_ns() - start);
+      group.executed.fetch_add(1, std::memory_order_relaxed);
+      idle = 0;
+      continue;
     }
-    // 任务从队列中取出后，就由该worker线程同步执行，执行完后才会取下一个
-    if (task) {
-      task();
+    if (stop_.load()) {
+      // 停止时本节点已提交的任务全部执行完才退出。
+      if (group.pending.load() == 0) {
+        break;
+      }
+      std::this_thread::yield();
+      continue;
+    }
+    if (++idle < options_.spin_rounds) {
+      std::this_thread::yield();
+      continue;
+    }
+    // 休眠：先登记 sleepers 再检查 pending，与提交方“先加 pending 再看 sleepers”配对，不会漏掉唤醒；
+    // 超时醒来以便检查远端节点是否积压。
+    std::unique_lock<std::mutex> lock(group.mutex);
+    group.sleepers.fetch_add(1);
+    if (group.pending.load() == 0 && !stop_.load()) {
+      group.cv.wait_for(lock, std::chrono::milliseconds(10));
     }
+    group.sleepers.fetch_sub(1);
+    idle = 0;
   }
+  tls_worker = nullptr;
 }
 
 }  // namespace mini_db
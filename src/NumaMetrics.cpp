@@ -0,0 +1,190 @@
+#include "db/NumaMetrics.h"
+
+#include "db/Numa.h"
+#include "db/NumaThread.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+
+namespace mini_db {
+
+namespace {
+
+// 帧访问在线程本地累计到该次数后写入共享段。
+constexpr uint32_t kAccessFlushBatch = 64;
+
+bool metrics_enabled_by_env() {
+  // 环境变量 MINI_DB_NUMA_METRICS=1/true/on 开启共享内存计数。
+  const char* env = std::getenv("MINI_DB_NUMA_METRICS");
+  if (!env || std::strlen(env) == 0) {
+    return false;
+  }
+  std::string value(env);
+  for (auto& ch : value) {
+    ch = static_cast<char>(std::tolower(static_cast<unsigned char>(ch)));
+  }
+  return value == "1" || value == "true" || value == "on";
+}
+
+// 进程内唯一的共享段：进程正常退出时删除段名（映射保留到进程结束，退出中的线程仍可写入）。
+// 进程被杀死时段名残留在 /dev/shm，监控工具通过 pid 与进程是否存在判断是否过期。
+class SharedSegment {
+ public:
+  SharedSegment() {
+    if (!metrics_enabled_by_env()) {
+      return;
+    }
+    pid_ = static_cast<int>(getpid());
+    name_ = numa_metrics_shm_name(pid_);
+    int fd = shm_open(name_.c_str(), O_CREAT | O_TRUNC | O_RDWR, 0644);
+    if (fd < 0) {
+      return;
+    }
+    void* addr = MAP_FAILED;
+    if (ftruncate(fd, static_cast<off_t>(sizeof(NumaMetricsSegment))) == 0) {
+      addr = mmap(nullptr, sizeof(NumaMetricsSegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (addr == MAP_FAILED) {
+      shm_unlink(name_.c_str());
+      return;
+    }
+    segment_ = new (addr) NumaMetricsSegment();
+    segment_->pid = pid_;
+    segment_->version = kNumaMetricsVersion;
+    // 魔数最后写入：监控工具看到魔数时其余头部字段已就绪。
+    std::atomic_thread_fence(std::memory_order_release);
+    segment_->magic = kNumaMetricsMagic;
+  }
+
+  ~SharedSegment() {
+    // fork 出的子进程继承了映射但段名属于父进程，不删除。
+    if (segment_ && static_cast<int>(getpid()) == pid_) {
+      shm_unlink(name_.c_str());
+    }
+  }
+
+  NumaMetricsSegment* segment() const { return segment_; }
+
+ private:
+  NumaMetricsSegment* segment_ = nullptr;
+  std::string name_;
+  int pid_ = 0;
+};
+
+SharedSegment& shared_segment() {
+  static SharedSegment segment;
+  return segment;
+}
+
+void note_node(NumaMetricsSegment* segment, int node) {
+  uint32_t needed = static_cast<uint32_t>(node) + 1;
+  uint32_t seen = segment->nodes.load(std::memory_order_relaxed);
+  while (seen < needed &&
+         !segment->nodes.compare_exchange_weak(seen, needed, std::memory_order_relaxed)) {
+  }
+}
+
+bool valid_node(int node) {
+  return node >= 0 && static_cast<size_t>(node) < kNumaMetricsMaxNodes;
+}
+
+// 线程本地的帧访问计数，批量写入共享段以免每次访问都争用同一缓存行。
+struct LocalAccesses {
+  uint32_t local[kNumaMetricsMaxNodes] = {};
+  uint32_t remote[kNumaMetricsMaxNodes] = {};
+  uint32_t pending = 0;
+
+  ~LocalAccesses() { flush(); }
+
+  void flush() {
+    NumaMetricsSegment* segment = numa_metrics();
+    if (!segment || pending == 0) {
+      return;
+    }
+    for (size_t node = 0; node < kNumaMetricsMaxNodes; ++node) {
+      NumaNodeMetrics& metrics = segment->node[node];
+      if (local[node] > 0) {
+        metrics.local_accesses.fetch_add(local[node], std::memory_order_relaxed);
+        local[node] = 0;
+      }
+      if (remote[node] > 0) {
+        metrics.remote_accesses.fetch_add(remote[node], std::memory_order_relaxed);
+        remote[node] = 0;
+      }
+    }
+    pending = 0;
+  }
+};
+
+}  // namespace
+
+NumaMetricsSegment* numa_metrics() {
+  return shared_segment().segment();
+}
+
+int numa_metrics_current_node() {
+  int node = thread_bound_node();
+  if (node >= 0) {
+    return node;
+  }
+  static std::unique_ptr<NumaTopology> topology = create_numa_topology(0);
+  return topology->current_node();
+}
+
+void record_numa_frame_access(int frame_node, int thread_node) {
+  NumaMetricsSegment* segment = numa_metrics();
+  if (!segment || !valid_node(frame_node)) {
+    return;
+  }
+  thread_local LocalAccesses accesses;
+  if (frame_node == thread_node) {
+    ++accesses.local[frame_node];
+  } else {
+    ++accesses.remote[frame_node];
+  }
+  if (++accesses.pending >= kAccessFlushBatch) {
+    note_node(segment, std::max(frame_node, valid_node(thread_node) ? thread_node : 0));
+    accesses.flush();
+  }
+}
+
+void record_numa_allocation(int node, int actual_node, size_t bytes) {
+  NumaMetricsSegment* segment = numa_metrics();
+  if (!segment || !valid_node(node)) {
+    return;
+  }
+  note_node(segment, node);
+  NumaNodeMetrics& metrics = segment->node[node];
+  metrics.alloc_bytes.fetch_add(bytes, std::memory_order_relaxed);
+  if (actual_node >= 0) {
+    metrics.alloc_checked_bytes.fetch_add(bytes, std::memory_order_relaxed);
+    if (actual_node != node) {
+      metrics.alloc_misplaced_bytes.fetch_add(bytes, std::memory_order_relaxed);
+    }
+  }
+}
+
+void record_numa_submit(int target_node, int submit_node) {
+  NumaMetricsSegment* segment = numa_metrics();
+  if (!segment || !valid_node(target_node)) {
+    return;
+  }
+  note_node(segment, target_node);
+  NumaNodeMetrics& metrics = segment->node[target_node];
+  if (target_node == submit_node) {
+    metrics.submit_local.fetch_add(1, std::memory_order_relaxed);
+  } else {
+    metrics.submit_remote.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+}  // namespace mini_db
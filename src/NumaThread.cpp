@@ -8,7 +8,18 @@
 
 namespace mini_db {
 
+namespace {
+
+thread_local int tls_bound_node = -1;
+
+}  // namespace
+
+int thread_bound_node() {
+  return tls_bound_node;
+}
+
 bool bind_thread_to_node(int node, std::string* err) {
+  tls_bound_node = node;
 #ifdef HAVE_LIBNUMA
   // 使用 libnuma 将当前线程绑定到指定节点。
   if (numa_available() < 0) {
@@ -17,6 +28,13 @@ bool bind_thread_to_node(int node, std::string* err) {
     }
     return false;
   }
+  if (node < 0 || node > numa_max_node()) {
+    // 配置的节点数可以多于机器实际节点数，此时不绑定（libnuma 会对不存在的节点打印警告）。
+    if (err) {
+      *err = "NUMA node out of range";
+    }
+    return false;
+  }
   if (numa_run_on_node(node) != 0) {
     if (err) {
       *err = "failed to bind thread to NUMA node";
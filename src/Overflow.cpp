@@ -0,0 +1,257 @@
+#include "db/Overflow.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace mini_db {
+
+namespace {
+
+// 溢出文件头魔数。
+constexpr char kOverflowMagic[4] = {'O', 'V', 'F', '1'};
+
+// 按小端序写入 / 读取 32 位无符号整数。
+void store_uint32(char* out, uint32_t value) {
+  for (size_t i = 0; i < 4; ++i) {
+    out[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+  }
+}
+
+uint32_t load_uint32(const char* data) {
+  uint32_t value = 0;
+  for (size_t i = 0; i < 4; ++i) {
+    value |= static_cast<uint32_t>(static_cast<unsigned char>(data[i])) << (8 * i);
+  }
+  return value;
+}
+
+// 按小端序写入 / 读取 64 位无符号整数。
+void store_uint64(char* out, uint64_t value) {
+  for (size_t i = 0; i < 8; ++i) {
+    out[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+  }
+}
+
+uint64_t load_uint64(const char* data) {
+  uint64_t value = 0;
+  for (size_t i = 0; i < 8; ++i) {
+    value |= static_cast<uint64_t>(static_cast<unsigned char>(data[i])) << (8 * i);
+  }
+  return value;
+}
+
+}  // namespace
+
+OverflowFile::OverflowFile(const std::string& path, size_t page_size, size_t cache_pages,
+                           const CacheOptions& cache)
+    : file_(path, page_size, cache_pages, 1, cache), page_size_(page_size) {}
+
+bool OverflowFile::load(bool read_only, bool* complete, std::string* err) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  *complete = true;
+  free_.clear();
+  page_count_ = 1;
+  if (read_only && !file_.map_read_only(false, err)) {
+    return false;
+  }
+  if (file_.file_size() < page_size_) {
+    if (read_only) {
+      return true;
+    }
+    // 新文件：写出空的文件头。
+    std::vector<char> header(page_size_, 0);
+    std::memcpy(header.data(), kOverflowMagic, sizeof(kOverflowMagic));
+    store_uint32(header.data() + 4, kFlagComplete);
+    store_uint64(header.data() + 8, page_count_);
+    return file_.write_item(0, header, err);
+  }
+  DataItem header;
+  if (!file_.read_item(0, page_size_, &header, err)) {
+    return false;
+  }
+  const char* data = header.data.data();
+  if (std::memcmp(data, kOverflowMagic, sizeof(kOverflowMagic)) != 0) {
+    if (err) {
+      *err = "invalid overflow file: " + file_.path();
+    }
+    return false;
+  }
+  uint32_t flags = load_uint32(data + 4);
+  uint64_t saved_pages = load_uint64(data + 8);
+  uint32_t free_count = load_uint32(data + 16);
+  page_count_ = std::max<uint64_t>(saved_pages, file_.file_size() / page_size_);
+  // 文件头之后还分配过页（异常退出），或空闲页号没有全部写入文件头：需要按数据页重新统计。
+  if ((flags & kFlagComplete) == 0 || page_count_ != saved_pages ||
+      kHeaderSize + static_cast<size_t>(free_count) * 4 > page_size_) {
+    *complete = false;
+    return true;
+  }
+  free_.reserve(free_count);
+  for (uint32_t i = 0; i < free_count; ++i) {
+    free_.push_back(load_uint32(data + kHeaderSize + i * 4));
+  }
+  return true;
+}
+
+bool OverflowFile::write(const char* data, size_t size, bool fresh, uint32_t* first_page,
+                         std::string* err) {
+  size_t count = pages_for(size);
+  std::vector<uint32_t> pages;
+  pages.reserve(count);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    while (pages.size() < count && !fresh && !free_.empty()) {
+      pages.push_back(free_.back());
+      free_.pop_back();
+    }
+    while (pages.size() < count) {
+      if (page_count_ >= UINT32_MAX) {
+        free_.insert(free_.end(), pages.begin(), pages.end());
+        if (err) {
+          *err = "overflow file is full: " + file_.path();
+        }
+        return false;
+      }
+      pages.push_back(static_cast<uint32_t>(page_count_++));
+    }
+  }
+  std::vector<char> page(page_size_, 0);
+  size_t chunk = payload();
+  for (size_t i = 0; i < count; ++i) {
+    size_t begin = i * chunk;
+    size_t length = std::min(chunk, size - begin);
+    store_uint32(page.data(), i + 1 < count ? pages[i + 1] : 0);
+    std::memcpy(page.data() + kLinkSize, data + begin, length);
+    std::memset(page.data() + kLinkSize + length, 0, chunk - length);
+    if (!file_.write_from(static_cast<size_t>(pages[i]) * page_size_, page.data(), page_size_, 0,
+                          err)) {
+      return false;
+    }
+  }
+  *first_page = pages.front();
+  return true;
+}
+
+bool OverflowFile::read(uint32_t first_page, size_t size, char* out, std::string* err) {
+  // 每页的下一页号与值字节连续存放，逐页读入后拆开。
+  std::vector<char> page(page_size_);
+  size_t chunk = payload();
+  uint32_t page_id = first_page;
+  for (size_t begin = 0; begin < size; begin += chunk) {
+    if (page_id == 0 || page_id >= page_count()) {
+      if (err) {
+        *err = "broken overflow chain: " + file_.path();
+      }
+      return false;
+    }
+    if (!file_.read_into(static_cast<size_t>(page_id) * page_size_, page_size_, page.data(),
+                         PageAccess::Normal, err)) {
+      return false;
+    }
+    std::memcpy(out + begin, page.data() + kLinkSize, std::min(chunk, size - begin));
+    page_id = load_uint32(page.data());
+  }
+  return true;
+}
+
+bool OverflowFile::release(uint32_t first_page, size_t size, std::string* err) {
+  std::vector<uint32_t> pages;
+  size_t count = pages_for(size);
+  uint32_t page_id = first_page;
+  for (size_t i = 0; i < count && page_id != 0 && page_id < page_count(); ++i) {
+    pages.push_back(page_id);
+    if (i + 1 < count && !next_page(page_id, &page_id, err)) {
+      return false;
+    }
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  free_.insert(free_.end(), pages.begin(), pages.end());
+  return true;
+}
+
+bool OverflowFile::rebuild(const std::vector<std::pair<uint32_t, uint32_t>>& chains,
+                           std::string* err) {
+  uint64_t total = page_count();
+  std::vector<bool> used(static_cast<size_t>(total), false);
+  used[0] = true;
+  for (const auto& chain : chains) {
+    size_t count = pages_for(chain.second);
+    uint32_t page_id = chain.first;
+    // 链损坏（页号越界或成环）时只保留已走过的页。
+    for (size_t i = 0; i < count && page_id != 0 && page_id < total && !used[page_id]; ++i) {
+      used[page_id] = true;
+      if (i + 1 < count && !next_page(page_id, &page_id, err)) {
+        return false;
+      }
+    }
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  free_.clear();
+  for (size_t page_id = 1; page_id < used.size(); ++page_id) {
+    if (!used[page_id]) {
+      free_.push_back(static_cast<uint32_t>(page_id));
+    }
+  }
+  return true;
+}
+
+void OverflowFile::flush(std::string* err) {
+  if (file_.mapped()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<char> header(page_size_, 0);
+    std::memcpy(header.data(), kOverflowMagic, sizeof(kOverflowMagic));
+    size_t capacity = (page_size_ - kHeaderSize) / 4;
+    size_t count = std::min(free_.size(), capacity);
+    store_uint32(header.data() + 4, free_.size() <= capacity ? kFlagComplete : 0);
+    store_uint64(header.data() + 8, page_count_);
+    store_uint32(header.data() + 16, static_cast<uint32_t>(count));
+    for (size_t i = 0; i < count; ++i) {
+      store_uint32(header.data() + kHeaderSize + i * 4, free_[i]);
+    }
+    if (!file_.write_item(0, header, err)) {
+      return;
+    }
+  }
+  file_.flush(err);
+}
+
+uint64_t OverflowFile::page_count() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return page_count_;
+}
+
+size_t OverflowFile::free_pages() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return free_.size();
+}
+
+const std::string& OverflowFile::path() const {
+  return file_.path();
+}
+
+IoStats OverflowFile::io_stats() const {
+  return file_.io_stats();
+}
+
+size_t OverflowFile::payload() const {
+  return page_size_ - kLinkSize;
+}
+
+size_t OverflowFile::pages_for(size_t size) const {
+  return std::max<size_t>(1, (size + payload() - 1) / payload());
+}
+
+bool OverflowFile::next_page(uint32_t page_id, uint32_t* next, std::string* err) {
+  char link[kLinkSize];
+  if (!file_.read_into(static_cast<size_t>(page_id) * page_size_, kLinkSize, link,
+                       PageAccess::Normal, err)) {
+    return false;
+  }
+  *next = load_uint32(link);
+  return true;
+}
+
+}  // namespace mini_db
@@ -0,0 +1,123 @@
+#include "db/PageRouter.h"
+
+#include "db/Utils.h"
+
+namespace mini_db {
+
+namespace {
+
+uint64_t mix_page_id(size_t page_id) {
+  // splitmix64 的终结函数：相邻页号散列后分布均匀。
+  uint64_t x = static_cast<uint64_t>(page_id);
+  x ^= x >> 30;
+  x *= 0xBF58476D1CE4E5B9ull;
+  x ^= x >> 27;
+  x *= 0x94D049BB133111EBull;
+  x ^= x >> 31;
+  return x;
+}
+
+}  // namespace
+
+bool parse_page_placement(const std::string& name, PagePlacement* placement) {
+  std::string lowered = to_lower(name);
+  if (lowered == "modulo") {
+    *placement = PagePlacement::Modulo;
+  } else if (lowered == "range") {
+    *placement = PagePlacement::Range;
+  } else if (lowered == "hash") {
+    *placement = PagePlacement::Hash;
+  } else if (lowered == "adaptive") {
+    *placement = PagePlacement::Adaptive;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+const char* page_placement_name(PagePlacement placement) {
+  switch (placement) {
+    case PagePlacement::Modulo:
+      return "modulo";
+    case PagePlacement::Range:
+      return "range";
+    case PagePlacement::Hash:
+      return "hash";
+    case PagePlacement::Adaptive:
+      return "adaptive";
+  }
+  return "modulo";
+}
+
+int HashPageSelector::node_for_page(size_t page_id, int node_count) const {
+  if (node_count <= 0) {
+    return 0;
+  }
+  return static_cast<int>(mix_page_id(page_id) % static_cast<uint64_t>(node_count));
+}
+
+AdaptivePageSelector::AdaptivePageSelector(std::unique_ptr<PageNodeSelector> home, int node_count,
+                                           const PlacementOptions& options)
+    : home_(std::move(home)),
+      node_count_(node_count > 0 ? node_count : 1),
+      threshold_(options.migrate_threshold > 0 ? options.migrate_threshold : 1),
+      slots_(options.tracked_pages > 0 ? options.tracked_pages : 1) {
+  size_t count = slots_ * static_cast<size_t>(node_count_);
+  counts_ = std::make_unique<std::atomic<uint32_t>[]>(count);
+  for (size_t i = 0; i < count; ++i) {
+    counts_[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+int AdaptivePageSelector::node_for_page(size_t page_id, int node_count) const {
+  return home_->node_for_page(page_id, node_count);
+}
+
+int AdaptivePageSelector::record_access(size_t page_id, int node, int frame_node,
+                                        int node_count) {
+  if (node_count > node_count_ || node < 0 || node >= node_count || frame_node < 0 ||
+      frame_node >= node_count) {
+    return -1;
+  }
+  // 计数只作迁移启发：并发更新不加锁，偶尔丢失或冲突槽位共用计数都可以接受。
+  std::atomic<uint32_t>* slot =
+      &counts_[(mix_page_id(page_id) % slots_) * static_cast<size_t>(node_count_)];
+  uint32_t count = slot[node].fetch_add(1, std::memory_order_relaxed) + 1;
+  if (node == frame_node) {
+    // 本地计数过大时整体减半，访问模式改变后远端节点仍能在有限次访问内占优。
+    if (count >= threshold_ * 4) {
+      for (int i = 0; i < node_count; ++i) {
+        slot[i].store(slot[i].load(std::memory_order_relaxed) / 2, std::memory_order_relaxed);
+      }
+    }
+    return -1;
+  }
+  if (count < threshold_ || count <= 2 * slot[frame_node].load(std::memory_order_relaxed)) {
+    return -1;
+  }
+  for (int i = 0; i < node_count; ++i) {
+    slot[i].store(0, std::memory_order_relaxed);
+  }
+  return node;
+}
+
+std::unique_ptr<PageNodeSelector> create_page_selector(const PlacementOptions& options,
+                                                       int node_count) {
+  switch (options.policy) {
+    case PagePlacement::Range:
+      return std::make_unique<RangePageSelector>(options.range_pages);
+    case PagePlacement::Hash:
+      return std::make_unique<HashPageSelector>();
+    case PagePlacement::Adaptive: {
+      PlacementOptions home = options;
+      home.policy = options.home == PagePlacement::Adaptive ? PagePlacement::Modulo : options.home;
+      return std::make_unique<AdaptivePageSelector>(create_page_selector(home, node_count),
+                                                    node_count, options);
+    }
+    case PagePlacement::Modulo:
+      break;
+  }
+  return std::make_unique<ModuloPageSelector>();
+}
+
+}  // namespace mini_db
@@ -1,15 +1,27 @@
 #include "db/PagedFile.h"
 
+#include "db/Numa.h"
+
+#include <algorithm>
+#include <cerrno>
 #include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace mini_db {
 
-PagedFile::PagedFile(const std::string& path, size_t page_size, size_t cache_pages, int numa_nodes) {
-  reset(path, page_size, cache_pages, numa_nodes);
+PagedFile::PagedFile(const std::string& path, size_t page_size, size_t cache_pages, int numa_nodes,
+                     const CacheOptions& cache) {
+  reset(path, page_size, cache_pages, numa_nodes, cache);
+}
+
+PagedFile::~PagedFile() {
+  unmap();
 }
 
 bool PagedFile::read_item(size_t offset, size_t size, DataItem* item, std::string* err) {
-  // 按偏移跨页读取，拼接为连续的数据块。
   if (!item) {
     if (err) {
       *err = "data item missing";
@@ -18,6 +30,26 @@ bool PagedFile::read_item(size_t offset, size_t size, DataItem* item, std::strin
   }
   item->offset = offset;
   item->data.assign(size, 0);
+  return read_into(offset, size, item->data.data(), PageAccess::Normal, err);
+}
+
+bool PagedFile::read_into(size_t offset, size_t size, char* out, PageAccess access,
+                          std::string* err) {
+  if (map_) {
+    // 只读映射：直接复制，映射之外（文件末尾之后）的部分按全 0 返回，与 Pager 一致。
+    size_t available = offset < map_size_ ? std::min(size, map_size_ - offset) : 0;
+    if (available > 0) {
+      std::memcpy(out, map_ + offset, available);
+    }
+    if (available < size) {
+      std::memset(out + available, 0, size - available);
+    }
+    if (access == PageAccess::Scan) {
+      advise_ahead(offset + size);
+    }
+    return true;
+  }
+  // 按偏移跨页读取，逐页钉住并持共享闩复制，复制期间页不会被淘汰或修改。
   size_t remaining = size;
   size_t current_offset = offset;
   size_t dest_offset = 0;
@@ -28,12 +60,11 @@ bool PagedFile::read_item(size_t offset, size_t size, DataItem* item, std::strin
     if (chunk > remaining) {
       chunk = remaining;
     }
-    Page* page = cache_->get_page(page_id, err);
+    PageGuard page = cache_->get_page(page_id, PageGuard::Mode::Read, access, err);
     if (!page) {
       return false;
     }
-    // 复制当前页片段到输出缓冲。
-    std::memcpy(item->data.data() + dest_offset, page->data.data() + page_offset, chunk);
+    std::memcpy(out + dest_offset, page.data() + page_offset, chunk);
     current_offset += chunk;
     dest_offset += chunk;
     remaining -= chunk;
@@ -41,9 +72,64 @@ bool PagedFile::read_item(size_t offset, size_t size, DataItem* item, std::strin
   return true;
 }
 
+bool PagedFile::read_optimistic(size_t offset, size_t size, char* out) {
+  if (map_) {
+    return read_into(offset, size, out, PageAccess::Normal, nullptr);
+  }
+  size_t page_offset = offset % page_size();
+  if (page_offset + size > page_size()) {
+    return false;
+  }
+  return cache_->read_optimistic(offset / page_size(), page_offset, size, out);
+}
+
+bool PagedFile::read_view(size_t offset, size_t size, PageAccess access, PageGuard* page,
+                          std::vector<char>* scratch, const char** data, std::string* err) {
+  if (map_ && offset + size <= map_size_) {
+    if (access == PageAccess::Scan) {
+      advise_ahead(offset + size);
+    }
+    *data = map_ + offset;
+    return true;
+  }
+  size_t page_id = offset / page_size();
+  size_t page_offset = offset % page_size();
+  if (!map_ && page_offset + size <= page_size()) {
+    if (!*page || page->page_id() != page_id) {
+      // 先放掉上一页再钉新页，游标任何时刻只持有一页的闩。
+      page->release();
+      *page = cache_->get_page(page_id, PageGuard::Mode::Read, access, err);
+      if (!*page) {
+        return false;
+      }
+    }
+    *data = page->data() + page_offset;
+    return true;
+  }
+  // 跨页记录（或映射范围之外）复制到中转缓冲。
+  page->release();
+  scratch->resize(size);
+  if (!read_into(offset, size, scratch->data(), access, err)) {
+    return false;
+  }
+  *data = scratch->data();
+  return true;
+}
+
 bool PagedFile::write_item(size_t offset, const std::vector<char>& data, std::string* err) {
-  // 按偏移跨页写入，逐页写回到缓存。
-  size_t remaining = data.size();
+  return write_from(offset, data.data(), data.size(), 0, err);
+}
+
+bool PagedFile::write_from(size_t offset, const char* data, size_t size, uint64_t lsn,
+                           std::string* err) {
+  if (map_) {
+    if (err) {
+      *err = "file is mapped read-only: " + path();
+    }
+    return false;
+  }
+  // 按偏移跨页写入，逐页持独占闩覆盖并标记脏页。
+  size_t remaining = size;
   size_t current_offset = offset;
   size_t src_offset = 0;
   while (remaining > 0) {
@@ -53,13 +139,12 @@ bool PagedFile::write_item(size_t offset, const std::vector<char>& data, std::st
     if (chunk > remaining) {
       chunk = remaining;
     }
-    Page* page = cache_->get_page(page_id, err);
+    PageGuard page = cache_->get_page(page_id, PageGuard::Mode::Write, PageAccess::Normal, err);
     if (!page) {
       return false;
     }
-    // 覆盖页内指定区间并标记脏页。
-    std::memcpy(page->data.data() + page_offset, data.data() + src_offset, chunk);
-    cache_->mark_dirty(page_id);
+    std::memcpy(page.mutable_data() + page_offset, data + src_offset, chunk);
+    page.mark_dirty(lsn);
     current_offset += chunk;
     src_offset += chunk;
     remaining -= chunk;
@@ -67,16 +152,141 @@ bool PagedFile::write_item(size_t offset, const std::vector<char>& data, std::st
   return true;
 }
 
+PageGuard PagedFile::pin_page(size_t page_id, PageGuard::Mode mode, PageAccess access,
+                              std::string* err) {
+  if (map_) {
+    if (err) {
+      *err = "file is mapped read-only: " + path();
+    }
+    return PageGuard();
+  }
+  return cache_->get_page(page_id, mode, access, err);
+}
+
 void PagedFile::flush(std::string* err) {
-  // 将缓存中的脏页写回磁盘。
-  cache_->flush(err);
+  // 将缓存中的脏页写回磁盘（只读映射没有脏页）。
+  if (!map_) {
+    cache_->flush(err);
+  }
 }
 
-void PagedFile::reset(const std::string& path, size_t page_size, size_t cache_pages, int numa_nodes) {
+void PagedFile::reset(const std::string& path, size_t page_size, size_t cache_pages, int numa_nodes,
+                      const CacheOptions& cache) {
   // 重新初始化底层 pager 与 cache，用于切换文件。
+  unmap();
+  advise_bytes_ = cache.readahead.enabled ? cache.readahead.window_pages * page_size : 0;
   cache_.reset();
-  pager_ = std::make_unique<Pager>(path, page_size);
-  cache_ = std::make_unique<NumaBufferPool>(pager_.get(), cache_pages, page_size, numa_nodes);
+  pager_ = std::make_unique<Pager>(path, page_size, cache.io);
+  cache_ = std::make_unique<NumaBufferPool>(pager_.get(), cache_pages, page_size, numa_nodes,
+                                            cache);
+  if (make_wal_gate_) {
+    cache_->set_wal(make_wal_gate_);
+  }
+  if (buffer_manager_) {
+    cache_->set_buffer_manager(buffer_manager_);
+  }
+}
+
+void PagedFile::set_wal(const std::function<WalGate(int node)>& make_gate) {
+  make_wal_gate_ = make_gate;
+  cache_->set_wal(make_wal_gate_);
+}
+
+void PagedFile::set_buffer_manager(BufferManager* manager) {
+  buffer_manager_ = manager;
+  cache_->set_buffer_manager(buffer_manager_);
+}
+
+bool PagedFile::map_read_only(bool numa_bind, std::string* err) {
+  unmap();
+  if (pager_->compressed()) {
+    // 压缩文件的页不能直接映射，仍经页缓存读取（解压后的页留在缓存中）。
+    return true;
+  }
+  int fd = ::open(path().c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    if (err) {
+      *err = "failed to open file for mapping: " + path() + " (" + std::strerror(errno) + ")";
+    }
+    return false;
+  }
+  struct stat st;
+  if (::fstat(fd, &st) != 0) {
+    ::close(fd);
+    if (err) {
+      *err = "failed to stat file for mapping: " + path();
+    }
+    return false;
+  }
+  size_t size = static_cast<size_t>(st.st_size);
+  if (size == 0) {
+    ::close(fd);
+    return true;
+  }
+  void* addr = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  // 映射建立后文件描述符即可关闭。
+  ::close(fd);
+  if (addr == MAP_FAILED) {
+    if (err) {
+      *err = "failed to map file: " + path() + " (" + std::strerror(errno) + ")";
+    }
+    return false;
+  }
+  map_ = static_cast<char*>(addr);
+  map_size_ = size;
+  advised_end_.store(0);
+  // 点查随机访问，关闭内核的缺页预读；顺序扫描由 advise_ahead 显式提示。
+  ::madvise(map_, map_size_, MADV_RANDOM);
+  if (numa_bind && cache_->node_count() > 1) {
+    // 页号相邻且归属同一节点的页合并为一段。
+    size_t page_bytes = page_size();
+    size_t pages = (map_size_ + page_bytes - 1) / page_bytes;
+    size_t start = 0;
+    while (start < pages) {
+      int node = node_for_page(start);
+      size_t end = start + 1;
+      while (end < pages && node_for_page(end) == node) {
+        ++end;
+      }
+      size_t bytes = std::min(end * page_bytes, map_size_) - start * page_bytes;
+      bind_memory_to_node(map_ + start * page_bytes, bytes, node);
+      start = end;
+    }
+  }
+  return true;
+}
+
+bool PagedFile::mapped() const {
+  return map_ != nullptr;
+}
+
+void PagedFile::unmap() {
+  if (map_) {
+    ::munmap(map_, map_size_);
+    map_ = nullptr;
+    map_size_ = 0;
+  }
+}
+
+void PagedFile::advise_ahead(size_t pos) {
+  if (advise_bytes_ == 0 || pos >= map_size_) {
+    return;
+  }
+  // 已提示范围还剩超过半个窗口时不重复提示；向后跳转（新一轮扫描）时重新开始。
+  size_t end = advised_end_.load();
+  if (pos < end && end - pos > advise_bytes_ / 2 && end - pos <= advise_bytes_) {
+    return;
+  }
+  size_t target = std::min(pos + advise_bytes_, map_size_);
+  if (!advised_end_.compare_exchange_strong(end, target)) {
+    return;
+  }
+  size_t begin = pos >= end || end - pos > advise_bytes_ ? pos : end;
+  size_t os_page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+  begin -= begin % os_page;
+  if (target > begin) {
+    ::madvise(map_ + begin, target - begin, MADV_WILLNEED);
+  }
 }
 
 size_t PagedFile::page_size() const {
@@ -84,6 +294,9 @@ size_t PagedFile::page_size() const {
 }
 
 size_t PagedFile::file_size() const {
+  if (map_) {
+    return map_size_;
+  }
   return pager_ ? pager_->file_size() : 0;
 }
 
@@ -96,4 +309,53 @@ std::vector<size_t> PagedFile::cached_pages_per_node() const {
   return cache_ ? cache_->cached_pages_per_node() : std::vector<size_t>{};
 }
 
+int PagedFile::node_for_page(size_t page_id) const {
+  return cache_ ? cache_->node_for_page(page_id) : 0;
+}
+
+int PagedFile::frame_node_for_page(size_t page_id) const {
+  return cache_ ? cache_->frame_node_for_page(page_id) : 0;
+}
+
+uint64_t PagedFile::page_migrations() const {
+  return cache_ ? cache_->page_migrations() : 0;
+}
+
+CacheStats PagedFile::cache_stats() const {
+  return cache_ ? cache_->stats() : CacheStats{};
+}
+
+std::vector<CacheStats> PagedFile::cache_stats_per_node() const {
+  return cache_ ? cache_->shard_stats() : std::vector<CacheStats>{};
+}
+
+IoStats PagedFile::io_stats() const {
+  return pager_ ? pager_->stats() : IoStats{};
+}
+
+std::vector<std::vector<size_t>> PagedFile::resident_pages() const {
+  if (!cache_ || map_) {
+    return {};
+  }
+  return cache_->resident_pages();
+}
+
+size_t PagedFile::warm(int node, const std::vector<size_t>& page_ids, bool* full) {
+  if (full) {
+    *full = false;
+  }
+  if (!cache_ || map_) {
+    return 0;
+  }
+  size_t pages = (file_size() + page_size() - 1) / page_size();
+  std::vector<size_t> ids;
+  ids.reserve(page_ids.size());
+  for (size_t page_id : page_ids) {
+    if (page_id < pages) {
+      ids.push_back(page_id);
+    }
+  }
+  return cache_->warm(node, ids, full);
+}
+
 }  // namespace mini_db
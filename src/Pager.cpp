@@ -1,37 +1,177 @@
 #include "db/Pager.h"
 
-#include <cstring>
-#include <sys/stat.h>
+#include "db/Lz4.h"
+#include "db/Utils.h"
+
+#include <algorithm>
 #include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iterator>
 #include <string>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
 
 namespace mini_db {
 
-Pager::Pager(const std::string& path, size_t page_size) : path_(path), page_size_(page_size) {
+namespace {
+
+// O_DIRECT 要求缓冲区地址、长度与文件偏移按逻辑块对齐，这里统一按 4096 处理。
+constexpr size_t kDirectAlignment = 4096;
+
+// 压缩模式的存储单元：压缩后的页按单元对齐存放，省不出一个单元的页原样存放。
+constexpr size_t kUnitSize = 512;
+
+// 页映射文件：魔数(4) + 页大小(4) + 页数(8) + 条目 CRC32(4) + 保留(4)，
+// 之后每页一个条目：偏移(8，最高位为压缩标记) + 存放字节数(4)。
+constexpr char kPageMapMagic[4] = {'P', 'M', 'P', '1'};
+constexpr size_t kPageMapHeaderSize = 24;
+constexpr size_t kPageMapEntrySize = 12;
+constexpr uint64_t kCompressedBit = 1ULL << 63;
+
+// 按小端序写入 / 读取 bytes 字节的无符号整数。
+void store_uint(char* out, uint64_t value, size_t bytes) {
+  for (size_t i = 0; i < bytes; ++i) {
+    out[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+  }
+}
+
+uint64_t load_uint(const char* data, size_t bytes) {
+  uint64_t value = 0;
+  for (size_t i = 0; i < bytes; ++i) {
+    value |= static_cast<uint64_t>(static_cast<unsigned char>(data[i])) << (8 * i);
+  }
+  return value;
+}
+
+// O_DIRECT 下未对齐缓冲区使用的对齐中转缓冲区。
+class AlignedBuffer {
+ public:
+  explicit AlignedBuffer(size_t size) {
+    if (posix_memalign(&data_, kDirectAlignment, size) != 0) {
+      data_ = nullptr;
+    }
+  }
+  ~AlignedBuffer() { std::free(data_); }
+
+  AlignedBuffer(const AlignedBuffer&) = delete;
+  AlignedBuffer& operator=(const AlignedBuffer&) = delete;
+
+  char* data() const { return static_cast<char*>(data_); }
+
+ private:
+  void* data_ = nullptr;
+};
+
+// 记录一次读写调用：析构时累加页数并记下耗时（失败的调用同样计入）。
+class IoTimer {
+ public:
+  IoTimer(Counter* pages, LatencyHistogram* latency, size_t count)
+      : pages_(pages), latency_(latency), count_(count), start_(metric_now_ns()) {}
+  ~IoTimer() {
+    pages_->add(count_);
+    latency_->record(metric_now_ns() - start_);
+  }
+
+ private:
+  Counter* pages_;
+  LatencyHistogram* latency_;
+  size_t count_;
+  uint64_t start_;
+};
+
+}  // namespace
+
+void IoStats::add(const IoStats& other) {
+  pages_read += other.pages_read;
+  pages_written += other.pages_written;
+  read_latency.add(other.read_latency);
+  write_latency.add(other.write_latency);
+  sync_latency.add(other.sync_latency);
+}
+
+bool parse_io_backend(const std::string& name, IoBackend* backend) {
+  std::string lowered = to_lower(name);
+  if (lowered == "pread" || lowered == "pwrite") {
+    *backend = IoBackend::Pread;
+  } else if (lowered == "uring" || lowered == "io_uring") {
+    *backend = IoBackend::IoUring;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+const char* io_backend_name(IoBackend backend) {
+  switch (backend) {
+    case IoBackend::Pread:
+      return "pread";
+    case IoBackend::IoUring:
+      return "uring";
+  }
+  return "pread";
+}
+
+Pager::Pager(const std::string& path, size_t page_size)
+    : Pager(path, page_size, PagerOptions{}) {}
+
+Pager::Pager(const std::string& path, size_t page_size, const PagerOptions& options)
+    : path_(path), page_size_(page_size), options_(options) {
+  if (options_.compress) {
+    // 压缩区间既不按 4096 对齐也不定长，不能使用 O_DIRECT。
+    options_.direct_io = false;
+  }
   // 构造时尝试打开或创建文件。
   std::string err;
-  open_ = open_file(&err);
+  open_file(&err);
+  if (fd_ >= 0 && options_.compress && !load_page_map(&err)) {
+    open_error_ = err;
+  }
+  if (fd_ >= 0 && options_.backend == IoBackend::IoUring && !options_.compress) {
+    // 内核不支持或禁用 io_uring 时退回 pread/pwrite。
+    uring_ = std::make_unique<IoUring>();
+    if (!uring_->init(options_.uring_depth, &err)) {
+      uring_.reset();
+    }
+  }
+}
+
+Pager::~Pager() {
+  uring_.reset();
+  if (fd_ >= 0) {
+    ::close(fd_);
+  }
 }
 
 bool Pager::open_file(std::string* err) {
-  // 以读写二进制方式打开文件，不存在则创建。
-  file_.open(path_, std::ios::in | std::ios::out | std::ios::binary);
-  if (!file_.is_open()) {
-    std::ofstream create(path_, std::ios::out | std::ios::binary);
-    create.close();
-    file_.open(path_, std::ios::in | std::ios::out | std::ios::binary);
-  }
-  if (!file_.is_open()) {
+  // 以读写方式打开文件，不存在则创建；O_DIRECT 不可用时退回普通读写。
+  int flags = O_RDWR | O_CREAT | O_CLOEXEC;
+  if (options_.direct_io && page_size_ % kDirectAlignment == 0) {
+    fd_ = ::open(path_.c_str(), flags | O_DIRECT, 0644);
+    direct_ = fd_ >= 0;
+  }
+  if (fd_ < 0) {
+    fd_ = ::open(path_.c_str(), flags, 0644);
+  }
+  if (fd_ < 0) {
     if (err) {
       *err = "failed to open file: " + path_;
     }
     return false;
   }
+  struct stat st;
+  if (::fstat(fd_, &st) == 0) {
+    file_size_.store(static_cast<size_t>(st.st_size));
+  }
   return true;
 }
 
 bool Pager::is_open() const {
-  return open_;
+  return fd_ >= 0 && open_error_.empty();
 }
 
 const std::string& Pager::path() const {
@@ -42,26 +182,48 @@ size_t Pager::page_size() const {
   return page_size_;
 }
 
+IoBackend Pager::backend() const {
+  return uring_ ? IoBackend::IoUring : IoBackend::Pread;
+}
+
+bool Pager::direct_io() const {
+  return direct_;
+}
+
+bool Pager::compressed() const {
+  return options_.compress;
+}
+
+IoStats Pager::stats() const {
+  IoStats stats;
+  stats.pages_read = pages_read_.value();
+  stats.pages_written = pages_written_.value();
+  stats.read_latency = read_latency_.snapshot();
+  stats.write_latency = write_latency_.snapshot();
+  stats.sync_latency = sync_latency_.snapshot();
+  return stats;
+}
+
+void Pager::sync_file() {
+  uint64_t start = metric_now_ns();
+  ::fdatasync(fd_);
+  sync_latency_.record(metric_now_ns() - start);
+}
+
 size_t Pager::file_size() const {
-  // 使用 stat 获取文件大小，失败视为 0。
-  struct stat st;
-  if (stat(path_.c_str(), &st) != 0) {
-    return 0;
-  }
-  return static_cast<size_t>(st.st_size);
+  return file_size_.load(std::memory_order_acquire);
 }
 
-bool Pager::read_page(size_t page_id, char* out, size_t size, std::string* err) {
-  // 读取指定页，不足部分用 0 填充。
-  if (!open_) {
+bool Pager::check_io(size_t size, std::string* err) const {
+  if (fd_ < 0) {
     if (err) {
       *err = "pager not open";
     }
     return false;
   }
-  if (!out) {
+  if (!open_error_.empty()) {
     if (err) {
-      *err = "output buffer missing";
+      *err = open_error_;
     }
     return false;
   }
@@ -71,96 +233,666 @@ bool Pager::read_page(size_t page_id, char* out, size_t size, std::string* err)
     }
     return false;
   }
-  std::lock_guard<std::mutex> lock(mutex_);
-  std::memset(out, 0, page_size_);
+  return true;
+}
+
+bool Pager::aligned(const void* data, size_t size) const {
+  return !direct_ || (reinterpret_cast<uintptr_t>(data) % kDirectAlignment == 0 &&
+                      size % kDirectAlignment == 0);
+}
+
+void Pager::extend_size(size_t end) {
+  size_t current = file_size_.load(std::memory_order_relaxed);
+  while (current < end &&
+         !file_size_.compare_exchange_weak(current, end, std::memory_order_release,
+                                           std::memory_order_relaxed)) {
+  }
+}
+
+std::string Pager::io_error(const char* op, size_t offset, int code) const {
+  std::string message = std::string("failed to ") + op + " page: file=" + path_ +
+                        ", offset=" + std::to_string(offset);
+  if (code != 0) {
+    message += ", errno=" + std::to_string(code) + " (" + std::string(std::strerror(code)) + ")";
+  }
+  return message;
+}
+
+bool Pager::read_at(char* out, size_t size, size_t offset, std::string* err) {
+  if (!aligned(out, size)) {
+    AlignedBuffer bounce(size);
+    if (!bounce.data()) {
+      if (err) {
+        *err = "failed to allocate aligned buffer";
+      }
+      return false;
+    }
+    if (!read_at(bounce.data(), size, offset, err)) {
+      return false;
+    }
+    std::memcpy(out, bounce.data(), size);
+    return true;
+  }
+  size_t done = 0;
+  while (done < size) {
+    ssize_t n = ::pread(fd_, out + done, size - done, static_cast<off_t>(offset + done));
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      if (err) {
+        *err = io_error("read", offset, errno);
+      }
+      return false;
+    }
+    if (n == 0) {
+      // 读到文件末尾时补 0，确保页大小一致。
+      std::memset(out + done, 0, size - done);
+      break;
+    }
+    done += static_cast<size_t>(n);
+  }
+  return true;
+}
+
+bool Pager::write_at(const char* data, size_t size, size_t offset, std::string* err) {
+  if (!aligned(data, size)) {
+    AlignedBuffer bounce(size);
+    if (!bounce.data()) {
+      if (err) {
+        *err = "failed to allocate aligned buffer";
+      }
+      return false;
+    }
+    std::memcpy(bounce.data(), data, size);
+    return write_at(bounce.data(), size, offset, err);
+  }
+  size_t done = 0;
+  while (done < size) {
+    ssize_t n = ::pwrite(fd_, data + done, size - done, static_cast<off_t>(offset + done));
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      if (err) {
+        *err = io_error("write", offset, errno);
+      }
+      return false;
+    }
+    done += static_cast<size_t>(n);
+  }
+  if (!options_.compress) {
+    // 压缩模式下文件大小是逻辑大小，由 write_compressed 推进。
+    extend_size(offset + size);
+  }
+  return true;
+}
+
+bool Pager::read_page(size_t page_id, char* out, size_t size, std::string* err) {
+  // 读取指定页，不足部分用 0 填充。
+  IoTimer timer(&pages_read_, &read_latency_, 1);
+  if (!check_io(size, err)) {
+    return false;
+  }
+  if (!out) {
+    if (err) {
+      *err = "output buffer missing";
+    }
+    return false;
+  }
+  if (options_.compress) {
+    return read_compressed(page_id, out, err);
+  }
   size_t offset = page_id * page_size_;
-  size_t file_bytes = file_size();
-  if (offset >= file_bytes) {
-    // 读取超出文件末尾时返回全 0 页。
+  if (offset >= file_size()) {
+    // 读取超出文件末尾时返回全 0 页，不发起系统调用。
+    std::memset(out, 0, page_size_);
     return true;
   }
-  // 清理流状态，避免上次 EOF/fail 影响本次读。
-  file_.clear();
-  file_.seekg(static_cast<std::streamoff>(offset), std::ios::beg);
-  file_.read(out, static_cast<std::streamsize>(page_size_));
-  std::streamsize read_bytes = file_.gcount();
-  if (read_bytes < 0) {
+  return read_at(out, page_size_, offset, err);
+}
+
+bool Pager::read_pages(const std::vector<size_t>& page_ids, const std::vector<char*>& pages,
+                       size_t size, std::string* err) {
+  IoTimer timer(&pages_read_, &read_latency_, page_ids.size());
+  if (!check_io(size, err)) {
+    return false;
+  }
+  if (page_ids.size() != pages.size()) {
     if (err) {
-      *err = "failed to read page";
+      *err = "page batch size mismatch";
     }
     return false;
   }
-  if (static_cast<size_t>(read_bytes) < page_size_) {
-    // 读到文件末尾时补 0，确保页大小一致。
-    std::memset(out + read_bytes, 0, page_size_ - static_cast<size_t>(read_bytes));
+  if (options_.compress) {
+    // 压缩页逐页读取解压。
+    for (size_t i = 0; i < pages.size(); ++i) {
+      if (!read_compressed(page_ids[i], pages[i], err)) {
+        return false;
+      }
+    }
+    return true;
+  }
+  size_t file_bytes = file_size();
+  // 文件末尾之后的页直接补 0，其余页组成一批读取。
+  std::vector<IoRequest> requests;
+  requests.reserve(pages.size());
+  bool direct_ok = true;
+  for (size_t i = 0; i < pages.size(); ++i) {
+    size_t offset = page_ids[i] * page_size_;
+    if (offset >= file_bytes) {
+      std::memset(pages[i], 0, page_size_);
+    } else {
+      requests.push_back(IoRequest{false, pages[i], page_size_, offset});
+      direct_ok = direct_ok && aligned(pages[i], page_size_);
+    }
+  }
+  if (!direct_ok) {
+    // O_DIRECT 且缓冲区未对齐：逐页经对齐中转缓冲区读取。
+    for (const IoRequest& request : requests) {
+      if (!read_at(request.data, request.size, request.offset, err)) {
+        return false;
+      }
+    }
+    return true;
+  }
+  if (uring_ && requests.size() > 1) {
+    std::vector<int> results;
+    if (!uring_->submit_and_wait(fd_, requests, &results, err)) {
+      return false;
+    }
+    for (size_t i = 0; i < requests.size(); ++i) {
+      const IoRequest& request = requests[i];
+      if (results[i] < 0) {
+        if (err) {
+          *err = io_error("read", request.offset, -results[i]);
+        }
+        return false;
+      }
+      size_t done = static_cast<size_t>(results[i]);
+      // 短读（到达文件末尾）交给同步路径补齐。
+      if (done < request.size &&
+          !read_at(request.data + done, request.size - done, request.offset + done, err)) {
+        return false;
+      }
+    }
+    return true;
+  }
+  // 偏移相邻的请求合并为一次 preadv。
+  size_t start = 0;
+  while (start < requests.size()) {
+    size_t end = start + 1;
+    while (end < requests.size() &&
+           requests[end].offset == requests[end - 1].offset + page_size_) {
+      ++end;
+    }
+    std::vector<char*> run;
+    run.reserve(end - start);
+    for (size_t i = start; i < end; ++i) {
+      run.push_back(requests[i].data);
+    }
+    if (!read_vector(run, requests[start].offset, err)) {
+      return false;
+    }
+    start = end;
+  }
+  return true;
+}
+
+bool Pager::read_vector(const std::vector<char*>& pages, size_t offset, std::string* err) {
+  size_t start = 0;
+  while (start < pages.size()) {
+    size_t count = std::min(pages.size() - start, static_cast<size_t>(IOV_MAX));
+    std::vector<iovec> iov(count);
+    for (size_t i = 0; i < count; ++i) {
+      iov[i].iov_base = pages[start + i];
+      iov[i].iov_len = page_size_;
+    }
+    size_t chunk_offset = offset + start * page_size_;
+    ssize_t n = ::preadv(fd_, iov.data(), static_cast<int>(count),
+                         static_cast<off_t>(chunk_offset));
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      if (err) {
+        *err = io_error("read", chunk_offset, errno);
+      }
+      return false;
+    }
+    // 短读时逐页补齐剩余部分（到达文件末尾的部分补 0）。
+    size_t done = static_cast<size_t>(n);
+    for (size_t i = 0; i < count; ++i) {
+      size_t page_start = i * page_size_;
+      if (done >= page_start + page_size_) {
+        continue;
+      }
+      size_t skip = done > page_start ? done - page_start : 0;
+      if (!read_at(pages[start + i] + skip, page_size_ - skip, chunk_offset + page_start + skip,
+                   err)) {
+        return false;
+      }
+    }
+    start += count;
   }
-  // 读取到 EOF 时会设置 eof/fail 标志，后续写需要先清理。
-  file_.clear();
   return true;
 }
 
 bool Pager::write_page(size_t page_id, const char* data, size_t size, std::string* err) {
   // 将整页写入指定偏移位置。
-  if (!open_) {
+  IoTimer timer(&pages_written_, &write_latency_, 1);
+  if (!check_io(size, err)) {
+    return false;
+  }
+  if (options_.compress) {
+    return write_compressed(page_id, data, err);
+  }
+  return write_at(data, page_size_, page_id * page_size_, err);
+}
+
+bool Pager::write_pages(size_t first_page_id, const std::vector<const char*>& pages, size_t size,
+                        std::string* err) {
+  // 连续页一次提交：io_uring 批量提交，否则 pwritev 一次写出。
+  IoTimer timer(&pages_written_, &write_latency_, pages.size());
+  if (!check_io(size, err)) {
+    return false;
+  }
+  if (pages.empty()) {
+    return true;
+  }
+  if (options_.compress) {
+    // 压缩后各页长度不同、区间不连续，逐页写出。
+    for (size_t i = 0; i < pages.size(); ++i) {
+      if (!write_compressed(first_page_id + i, pages[i], err)) {
+        return false;
+      }
+    }
+    return true;
+  }
+  size_t offset = first_page_id * page_size_;
+  bool direct_ok = true;
+  for (const char* data : pages) {
+    direct_ok = direct_ok && aligned(data, page_size_);
+  }
+  if (!direct_ok) {
+    // O_DIRECT 且缓冲区未对齐：拷贝进一块对齐的连续缓冲区后一次写出。
+    AlignedBuffer bounce(pages.size() * page_size_);
+    if (!bounce.data()) {
+      if (err) {
+        *err = "failed to allocate aligned buffer";
+      }
+      return false;
+    }
+    for (size_t i = 0; i < pages.size(); ++i) {
+      std::memcpy(bounce.data() + i * page_size_, pages[i], page_size_);
+    }
+    return write_at(bounce.data(), pages.size() * page_size_, offset, err);
+  }
+  if (uring_ && pages.size() > 1) {
+    std::vector<IoRequest> requests;
+    requests.reserve(pages.size());
+    for (size_t i = 0; i < pages.size(); ++i) {
+      requests.push_back(
+          IoRequest{true, const_cast<char*>(pages[i]), page_size_, offset + i * page_size_});
+    }
+    std::vector<int> results;
+    if (!uring_->submit_and_wait(fd_, requests, &results, err)) {
+      return false;
+    }
+    for (size_t i = 0; i < requests.size(); ++i) {
+      const IoRequest& request = requests[i];
+      if (results[i] < 0) {
+        if (err) {
+          *err = io_error("write", request.offset, -results[i]);
+        }
+        return false;
+      }
+      size_t done = static_cast<size_t>(results[i]);
+      if (done < request.size &&
+          !write_at(request.data + done, request.size - done, request.offset + done, err)) {
+        return false;
+      }
+    }
+    extend_size(offset + pages.size() * page_size_);
+    return true;
+  }
+  return write_vector(pages, offset, err);
+}
+
+bool Pager::write_vector(const std::vector<const char*>& pages, size_t offset, std::string* err) {
+  size_t start = 0;
+  while (start < pages.size()) {
+    size_t count = std::min(pages.size() - start, static_cast<size_t>(IOV_MAX));
+    std::vector<iovec> iov(count);
+    for (size_t i = 0; i < count; ++i) {
+      iov[i].iov_base = const_cast<char*>(pages[start + i]);
+      iov[i].iov_len = page_size_;
+    }
+    size_t chunk_offset = offset + start * page_size_;
+    ssize_t n = ::pwritev(fd_, iov.data(), static_cast<int>(count),
+                          static_cast<off_t>(chunk_offset));
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      if (err) {
+        *err = io_error("write", chunk_offset, errno);
+      }
+      return false;
+    }
+    // 短写时逐页补齐剩余部分。
+    size_t written = static_cast<size_t>(n);
+    for (size_t i = 0; i < count; ++i) {
+      size_t page_start = i * page_size_;
+      if (written >= page_start + page_size_) {
+        continue;
+      }
+      size_t skip = written > page_start ? written - page_start : 0;
+      if (!write_at(pages[start + i] + skip, page_size_ - skip, chunk_offset + page_start + skip,
+                    err)) {
+        return false;
+      }
+    }
+    extend_size(chunk_offset + count * page_size_);
+    start += count;
+  }
+  return true;
+}
+
+bool Pager::flush(std::string* err) {
+  if (fd_ < 0) {
+    return true;
+  }
+  if (!options_.compress) {
+    sync_file();
+    return true;
+  }
+  std::lock_guard<std::mutex> flush_lock(flush_mutex_);
+  std::vector<Extent> snapshot;
+  size_t released = 0;
+  {
+    std::lock_guard<std::mutex> lock(map_mutex_);
+    if (!map_dirty_) {
+      return true;
+    }
+    snapshot = extents_;
+    released = pending_.size();
+    map_dirty_ = false;
+    snapshot_epoch_ = write_epoch_++;
+  }
+  // 快照中的区间都已写完：先让数据落盘，再保存指向它们的页映射。
+  sync_file();
+  if (!save_page_map(snapshot, err)) {
+    std::lock_guard<std::mutex> lock(map_mutex_);
+    map_dirty_ = true;
+    return false;
+  }
+  // 快照之前被替换的区间已不被磁盘上的页映射引用，等正在读取的读者结束后回收。
+  std::unique_lock<std::shared_mutex> reuse_lock(reuse_mutex_);
+  std::lock_guard<std::mutex> lock(map_mutex_);
+  for (size_t i = 0; i < released; ++i) {
+    free_units(pending_[i].first, pending_[i].second);
+  }
+  recycle_units();
+  pending_.erase(pending_.begin(), pending_.begin() + static_cast<std::ptrdiff_t>(released));
+  // 文件末尾的区间已回收时截断文件；持锁进行，避免截掉刚从末尾分配、正在写入的区间。
+  struct stat st;
+  if (::fstat(fd_, &st) == 0 && static_cast<uint64_t>(st.st_size) > end_unit_ * kUnitSize) {
+    if (::ftruncate(fd_, static_cast<off_t>(end_unit_ * kUnitSize)) != 0) {
+      if (err) {
+        *err = io_error("truncate", static_cast<size_t>(end_unit_ * kUnitSize), errno);
+      }
+      return false;
+    }
+  }
+  return true;
+}
+
+uint64_t Pager::units_for(size_t size) {
+  return (size + kUnitSize - 1) / kUnitSize;
+}
+
+uint64_t Pager::allocate_units(uint64_t units) {
+  // 取能放下的最小空闲区间，剩余部分放回；没有时从文件末尾分配。
+  auto it = free_by_size_.lower_bound({units, 0});
+  if (it == free_by_size_.end()) {
+    uint64_t start = end_unit_;
+    end_unit_ += units;
+    return start;
+  }
+  uint64_t size = it->first;
+  uint64_t start = it->second;
+  free_by_size_.erase(it);
+  free_by_start_.erase(start);
+  if (size > units) {
+    free_by_start_[start + units] = size - units;
+    free_by_size_.insert({size - units, start + units});
+  }
+  return start;
+}
+
+void Pager::recycle_units() {
+  for (const auto& range : recycle_) {
+    free_units(range.first, range.second);
+  }
+  recycle_.clear();
+}
+
+void Pager::free_units(uint64_t start, uint64_t units) {
+  auto next = free_by_start_.lower_bound(start);
+  if (next != free_by_start_.end() && next->first == start + units) {
+    units += next->second;
+    free_by_size_.erase({next->second, next->first});
+    next = free_by_start_.erase(next);
+  }
+  if (next != free_by_start_.begin()) {
+    auto prev = std::prev(next);
+    if (prev->first + prev->second == start) {
+      start = prev->first;
+      units += prev->second;
+      free_by_size_.erase({prev->second, prev->first});
+      free_by_start_.erase(prev);
+    }
+  }
+  if (start + units == end_unit_) {
+    end_unit_ = start;
+    return;
+  }
+  free_by_start_[start] = units;
+  free_by_size_.insert({units, start});
+}
+
+bool Pager::read_compressed(size_t page_id, char* out, std::string* err) {
+  std::shared_lock<std::shared_mutex> reuse_lock(reuse_mutex_);
+  Extent extent;
+  {
+    std::lock_guard<std::mutex> lock(map_mutex_);
+    if (page_id < extents_.size()) {
+      extent = extents_[page_id];
+    }
+  }
+  if (extent.size == 0) {
+    std::memset(out, 0, page_size_);
+    return true;
+  }
+  if (!extent.compressed) {
+    return read_at(out, page_size_, static_cast<size_t>(extent.offset), err);
+  }
+  thread_local std::vector<char> buffer;
+  buffer.resize(extent.size);
+  if (!read_at(buffer.data(), extent.size, static_cast<size_t>(extent.offset), err)) {
+    return false;
+  }
+  if (!lz4_decompress(buffer.data(), extent.size, out, page_size_)) {
     if (err) {
-      *err = "pager not open";
+      *err = "corrupt compressed page: file=" + path_ + ", page=" + std::to_string(page_id);
     }
     return false;
   }
-  if (size != page_size_) {
+  return true;
+}
+
+bool Pager::write_compressed(size_t page_id, const char* data, std::string* err) {
+  thread_local std::vector<char> buffer;
+  buffer.resize(page_size_);
+  size_t size = page_size_ > kUnitSize
+                    ? lz4_compress(data, page_size_, buffer.data(), page_size_ - kUnitSize)
+                    : 0;
+  bool compressed = size > 0;
+  if (!compressed) {
+    size = page_size_;
+  }
+  uint64_t units = units_for(size);
+  uint64_t start = 0;
+  {
+    std::lock_guard<std::mutex> lock(map_mutex_);
+    start = allocate_units(units);
+  }
+  // 新区间不被任何页映射引用，可以在锁外写入。
+  if (!write_at(compressed ? buffer.data() : data, size, start * kUnitSize, err)) {
+    std::lock_guard<std::mutex> lock(map_mutex_);
+    free_units(start, units);
+    return false;
+  }
+  {
+    std::lock_guard<std::mutex> lock(map_mutex_);
+    if (extents_.size() <= page_id) {
+      extents_.resize(page_id + 1);
+    }
+    Extent& extent = extents_[page_id];
+    if (extent.size > 0) {
+      // 两次保存之间反复改写的页（如批量装载中逐渐写满的页），旧区间不被任何页映射引用，
+      // 不必等到下一次保存。
+      auto& released = extent.epoch > snapshot_epoch_ ? recycle_ : pending_;
+      released.emplace_back(extent.offset / kUnitSize, units_for(extent.size));
+    }
+    extent.offset = start * kUnitSize;
+    extent.size = static_cast<uint32_t>(size);
+    extent.compressed = compressed;
+    extent.epoch = write_epoch_;
+    map_dirty_ = true;
+    extend_size((page_id + 1) * page_size_);
+  }
+  // 没有读者时顺带回收；有读者时不等待，留给之后的写入或 flush。
+  std::unique_lock<std::shared_mutex> reuse_lock(reuse_mutex_, std::try_to_lock);
+  if (reuse_lock.owns_lock()) {
+    std::lock_guard<std::mutex> lock(map_mutex_);
+    recycle_units();
+  }
+  return true;
+}
+
+bool Pager::load_page_map(std::string* err) {
+  std::string map_path = path_ + ".pmap";
+  std::ifstream in(map_path, std::ios::binary);
+  if (!in) {
+    if (file_size() > 0) {
+      if (err) {
+        *err = "page map missing for compressed file: " + path_;
+      }
+      return false;
+    }
+    // 新文件：先写出空映射，之后任何时刻异常退出都能找到页映射。
+    return save_page_map({}, err);
+  }
+  std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+  uint64_t count = data.size() >= kPageMapHeaderSize ? load_uint(data.data() + 8, 8) : 0;
+  if (data.size() < kPageMapHeaderSize ||
+      std::memcmp(data.data(), kPageMapMagic, sizeof(kPageMapMagic)) != 0 ||
+      (data.size() - kPageMapHeaderSize) / kPageMapEntrySize != count ||
+      (data.size() - kPageMapHeaderSize) % kPageMapEntrySize != 0 ||
+      crc32(data.data() + kPageMapHeaderSize, data.size() - kPageMapHeaderSize) !=
+          static_cast<uint32_t>(load_uint(data.data() + 16, 4))) {
     if (err) {
-      *err = "page size mismatch";
+      *err = "corrupt page map: " + map_path;
     }
     return false;
   }
-  std::lock_guard<std::mutex> lock(mutex_);
-  size_t offset = page_id * page_size_;
-  // 清理流状态，避免上次 EOF/fail 影响本次写。
-  file_.clear();
-  file_.seekp(static_cast<std::streamoff>(offset), std::ios::beg);
-  file_.write(data, static_cast<std::streamsize>(size));
-  if (!file_) {
+  if (load_uint(data.data() + 4, 4) != page_size_) {
     if (err) {
-      int code = errno;
-      if (code == 0) {
-        std::string state;
-        if (file_.bad()) {
-          state = "bad";
-        } else if (file_.fail()) {
-          state = "fail";
-        } else if (file_.eof()) {
-          state = "eof";
-        } else {
-          state = "unknown";
-        }
-        *err = "failed to write page: file=" + path_ + ", state=" + state +
-               ", offset=" + std::to_string(offset);
-      } else {
-        std::string state;
-        if (file_.bad()) {
-          state = "bad";
-        } else if (file_.fail()) {
-          state = "fail";
-        } else if (file_.eof()) {
-          state = "eof";
-        } else {
-          state = "unknown";
-        }
-        *err = "failed to write page: file=" + path_ + ", state=" + state +
-               ", offset=" + std::to_string(offset) + ", errno=" +
-               std::to_string(code) + " (" + std::string(std::strerror(code)) + ")";
-      }
+      *err = "page map page size mismatch: " + map_path;
     }
     return false;
   }
+  extents_.assign(static_cast<size_t>(count), Extent{});
+  std::vector<std::pair<uint64_t, uint64_t>> used;
+  for (size_t i = 0; i < extents_.size(); ++i) {
+    const char* entry = data.data() + kPageMapHeaderSize + i * kPageMapEntrySize;
+    uint64_t offset = load_uint(entry, 8);
+    Extent& extent = extents_[i];
+    extent.compressed = (offset & kCompressedBit) != 0;
+    extent.offset = offset & ~kCompressedBit;
+    extent.size = static_cast<uint32_t>(load_uint(entry + 8, 4));
+    if (extent.size > page_size_ || extent.offset % kUnitSize != 0) {
+      if (err) {
+        *err = "corrupt page map: " + map_path;
+      }
+      return false;
+    }
+    if (extent.size > 0) {
+      used.emplace_back(extent.offset / kUnitSize, units_for(extent.size));
+    }
+  }
+  // 已占用区间之间的空隙（含上次保存之后写入、未被引用的区间）都是空闲区间。
+  std::sort(used.begin(), used.end());
+  uint64_t cursor = 0;
+  for (const auto& range : used) {
+    if (range.first > cursor) {
+      free_units(cursor, range.first - cursor);
+    }
+    cursor = std::max(cursor, range.first + range.second);
+  }
+  end_unit_ = cursor;
+  file_size_.store(static_cast<size_t>(count) * page_size_);
   return true;
 }
 
-void Pager::flush() {
-  if (open_) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    file_.flush();
+bool Pager::save_page_map(const std::vector<Extent>& extents, std::string* err) {
+  std::vector<char> data(kPageMapHeaderSize + extents.size() * kPageMapEntrySize, 0);
+  std::memcpy(data.data(), kPageMapMagic, sizeof(kPageMapMagic));
+  store_uint(data.data() + 4, page_size_, 4);
+  store_uint(data.data() + 8, extents.size(), 8);
+  for (size_t i = 0; i < extents.size(); ++i) {
+    char* entry = data.data() + kPageMapHeaderSize + i * kPageMapEntrySize;
+    store_uint(entry, extents[i].offset | (extents[i].compressed ? kCompressedBit : 0), 8);
+    store_uint(entry + 8, extents[i].size, 4);
+  }
+  store_uint(data.data() + 16,
+             crc32(data.data() + kPageMapHeaderSize, data.size() - kPageMapHeaderSize), 4);
+  // 写临时文件并落盘后改名，异常退出时磁盘上总有一份完整的页映射。
+  std::string map_path = path_ + ".pmap";
+  std::string temp_path = map_path + ".tmp";
+  int fd = ::open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    if (err) {
+      *err = "failed to open page map: " + temp_path;
+    }
+    return false;
+  }
+  size_t written = 0;
+  while (written < data.size()) {
+    ssize_t n = ::write(fd, data.data() + written, data.size() - written);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      ::close(fd);
+      if (err) {
+        *err = std::string("failed to write page map: ") + std::strerror(errno);
+      }
+      return false;
+    }
+    written += static_cast<size_t>(n);
+  }
+  bool ok = ::fdatasync(fd) == 0;
+  ::close(fd);
+  if (!ok || std::rename(temp_path.c_str(), map_path.c_str()) != 0) {
+    if (err) {
+      *err = "failed to save page map: " + map_path;
+    }
+    return false;
   }
+  return true;
 }
 
 }  // namespace mini_db
@@ -0,0 +1,68 @@
+#include "db/PaxLayout.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace mini_db {
+
+PaxLayout::PaxLayout(const Schema& schema, size_t page_size) {
+  rows_per_page_ = std::max<size_t>(1, page_size / schema.record_size());
+  // minipage 按字段在记录中的顺序排列，字段在页内的偏移为其记录内偏移乘以每页行数。
+  fields_.push_back({0, 1, 0});
+  for (const auto& col : schema.layout()) {
+    fields_.push_back({col.offset, col.width, col.offset * rows_per_page_});
+  }
+}
+
+size_t PaxLayout::rows_per_page() const {
+  return rows_per_page_;
+}
+
+size_t PaxLayout::field_count() const {
+  return fields_.size();
+}
+
+size_t PaxLayout::minipage_offset(size_t field) const {
+  return fields_[field].page_offset;
+}
+
+size_t PaxLayout::field_width(size_t field) const {
+  return fields_[field].width;
+}
+
+size_t PaxLayout::field_at(size_t record_offset) const {
+  for (size_t i = 0; i < fields_.size(); ++i) {
+    if (fields_[i].record_offset == record_offset) {
+      return i;
+    }
+  }
+  return 0;
+}
+
+size_t PaxLayout::page_for_row(uint64_t row_id) const {
+  return 1 + static_cast<size_t>(row_id / rows_per_page_);
+}
+
+size_t PaxLayout::slot_for_row(uint64_t row_id) const {
+  return static_cast<size_t>(row_id % rows_per_page_);
+}
+
+uint64_t PaxLayout::first_row_in_page(size_t page_id) const {
+  return page_id <= 1 ? 0 : static_cast<uint64_t>(page_id - 1) * rows_per_page_;
+}
+
+void PaxLayout::gather(const char* page, size_t slot, char* record) const {
+  for (const auto& field : fields_) {
+    std::memcpy(record + field.record_offset, page + field.page_offset + slot * field.width,
+                field.width);
+  }
+}
+
+void PaxLayout::scatter(const char* record, size_t slot, char* page) const {
+  for (const auto& field : fields_) {
+    std::memcpy(page + field.page_offset + slot * field.width, record + field.record_offset,
+                field.width);
+  }
+}
+
+}  // namespace mini_db
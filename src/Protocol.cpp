@@ -0,0 +1,169 @@
+#include "db/Protocol.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace mini_db {
+
+namespace {
+
+void put_uint(std::vector<char>* out, uint64_t value, size_t bytes) {
+  for (size_t i = 0; i < bytes; ++i) {
+    out->push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+  }
+}
+
+uint64_t load_uint(const char* data, size_t bytes) {
+  uint64_t value = 0;
+  for (size_t i = 0; i < bytes; ++i) {
+    value |= static_cast<uint64_t>(static_cast<unsigned char>(data[i])) << (8 * i);
+  }
+  return value;
+}
+
+}  // namespace
+
+void wire_put_u8(std::vector<char>* out, uint8_t value) {
+  put_uint(out, value, 1);
+}
+
+void wire_put_u16(std::vector<char>* out, uint16_t value) {
+  put_uint(out, value, 2);
+}
+
+void wire_put_u32(std::vector<char>* out, uint32_t value) {
+  put_uint(out, value, 4);
+}
+
+void wire_put_u64(std::vector<char>* out, uint64_t value) {
+  put_uint(out, value, 8);
+}
+
+void wire_put_string(std::vector<char>* out, const std::string& value) {
+  size_t size = std::min<size_t>(value.size(), std::numeric_limits<uint16_t>::max());
+  wire_put_u16(out, static_cast<uint16_t>(size));
+  out->insert(out->end(), value.data(), value.data() + size);
+}
+
+void wire_put_value(std::vector<char>* out, const Value& value) {
+  if (value.type == ColumnType::Int) {
+    wire_put_u8(out, 0);
+    wire_put_u32(out, static_cast<uint32_t>(value.int_value));
+    return;
+  }
+  wire_put_u8(out, 1);
+  wire_put_u32(out, static_cast<uint32_t>(value.text_value.size()));
+  out->insert(out->end(), value.text_value.begin(), value.text_value.end());
+}
+
+void wire_put_frame(std::vector<char>* out, uint32_t request_id, uint8_t code,
+                    const std::vector<char>& payload) {
+  wire_put_u32(out, static_cast<uint32_t>(kWireHeaderBytes - 4 + payload.size()));
+  wire_put_u32(out, request_id);
+  wire_put_u8(out, code);
+  out->insert(out->end(), payload.begin(), payload.end());
+}
+
+WireReader::WireReader(const char* data, size_t size) : data_(data), size_(size) {}
+
+bool WireReader::get_uint(size_t bytes, uint64_t* value) {
+  if (size_ - pos_ < bytes) {
+    return false;
+  }
+  *value = load_uint(data_ + pos_, bytes);
+  pos_ += bytes;
+  return true;
+}
+
+bool WireReader::get_u8(uint8_t* value) {
+  uint64_t raw = 0;
+  if (!get_uint(1, &raw)) {
+    return false;
+  }
+  *value = static_cast<uint8_t>(raw);
+  return true;
+}
+
+bool WireReader::get_u16(uint16_t* value) {
+  uint64_t raw = 0;
+  if (!get_uint(2, &raw)) {
+    return false;
+  }
+  *value = static_cast<uint16_t>(raw);
+  return true;
+}
+
+bool WireReader::get_u32(uint32_t* value) {
+  uint64_t raw = 0;
+  if (!get_uint(4, &raw)) {
+    return false;
+  }
+  *value = static_cast<uint32_t>(raw);
+  return true;
+}
+
+bool WireReader::get_u64(uint64_t* value) {
+  return get_uint(8, value);
+}
+
+bool WireReader::get_string(std::string* value) {
+  size_t start = pos_;
+  uint16_t size = 0;
+  if (!get_u16(&size) || size_ - pos_ < size) {
+    pos_ = start;
+    return false;
+  }
+  value->assign(data_ + pos_, size);
+  pos_ += size;
+  return true;
+}
+
+bool WireReader::get_value(Value* value) {
+  size_t start = pos_;
+  uint8_t type = 0;
+  uint32_t raw = 0;
+  if (!get_u8(&type) || type > 1 || !get_u32(&raw)) {
+    pos_ = start;
+    return false;
+  }
+  if (type == 0) {
+    *value = Value::Int(static_cast<int32_t>(raw));
+    return true;
+  }
+  if (size_ - pos_ < raw) {
+    pos_ = start;
+    return false;
+  }
+  *value = Value::Text(std::string(data_ + pos_, raw));
+  pos_ += raw;
+  return true;
+}
+
+bool WireReader::done() const {
+  return pos_ == size_;
+}
+
+bool wire_parse_frame(const char* data, size_t size, uint32_t max_frame_bytes, WireFrame* frame,
+                      size_t* consumed, std::string* err) {
+  *consumed = 0;
+  if (size < 4) {
+    return true;
+  }
+  uint64_t length = load_uint(data, 4);
+  if (length < kWireHeaderBytes - 4 || length > max_frame_bytes) {
+    if (err) {
+      *err = "invalid frame length: " + std::to_string(length);
+    }
+    return false;
+  }
+  if (size - 4 < length) {
+    return true;
+  }
+  frame->request_id = static_cast<uint32_t>(load_uint(data + 4, 4));
+  frame->code = static_cast<uint8_t>(data[8]);
+  frame->payload.assign(data + kWireHeaderBytes, data + 4 + length);
+  *consumed = static_cast<size_t>(4 + length);
+  return true;
+}
+
+}  // namespace mini_db
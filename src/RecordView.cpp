@@ -0,0 +1,167 @@
+#include "db/RecordView.h"
+
+#include "db/AddedColumns.h"
+
+#include <cstring>
+
+namespace mini_db {
+
+RecordView::RecordView(const Schema* schema, const char* data) : schema_(schema), data_(data) {}
+
+RecordView::operator bool() const {
+  return data_ != nullptr;
+}
+
+const Schema& RecordView::schema() const {
+  return *schema_;
+}
+
+const char* RecordView::data() const {
+  return data_;
+}
+
+size_t RecordView::size() const {
+  return schema_ ? schema_->record_size() : 0;
+}
+
+bool RecordView::valid() const {
+  return data_[0] != 0;
+}
+
+int32_t RecordView::int_at(size_t col_index) const {
+  // 与 Schema 的编码一致：小端序 4 字节，逐字节拼接，不依赖对齐与主机字节序。
+  const unsigned char* p =
+      reinterpret_cast<const unsigned char*>(data_ + schema_->layout()[col_index].offset);
+  uint32_t bits = static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+                  (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+  return static_cast<int32_t>(bits);
+}
+
+std::string_view RecordView::text_at(size_t col_index) const {
+  const ColumnLayout& col = schema_->layout()[col_index];
+  const char* p = data_ + col.offset;
+  const void* end = std::memchr(p, '\0', col.width);
+  size_t length = end ? static_cast<size_t>(static_cast<const char*>(end) - p) : col.width;
+  return std::string_view(p, length);
+}
+
+Value RecordView::value_at(size_t col_index) const {
+  if (schema_->layout()[col_index].type == ColumnType::Int) {
+    return Value::Int(int_at(col_index));
+  }
+  std::string_view text = text_at(col_index);
+  Value value;
+  value.type = ColumnType::Text;
+  value.text_value.assign(text.data(), text.size());
+  return value;
+}
+
+void RecordView::decode(std::vector<Value>* values) const {
+  size_t count = schema_->columns().size();
+  values->clear();
+  values->reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    values->push_back(value_at(i));
+  }
+}
+
+int RecordView::compare(size_t col_index, const Value& value) const {
+  if (schema_->layout()[col_index].type == ColumnType::Int) {
+    int32_t v = int_at(col_index);
+    return v < value.int_value ? -1 : (v > value.int_value ? 1 : 0);
+  }
+  int cmp = text_at(col_index).compare(value.text_value);
+  return cmp < 0 ? -1 : (cmp > 0 ? 1 : 0);
+}
+
+bool RecordView::equals(size_t col_index, const std::string& key) const {
+  return schema_->column_equals(data_, col_index, key);
+}
+
+bool RecordView::matches(size_t col_index, CompareOp op, const Value& value,
+                         const Value& upper) const {
+  int cmp = compare(col_index, value);
+  switch (op) {
+    case CompareOp::Eq:
+      return cmp == 0;
+    case CompareOp::Ne:
+      return cmp != 0;
+    case CompareOp::Lt:
+      return cmp < 0;
+    case CompareOp::Le:
+      return cmp <= 0;
+    case CompareOp::Gt:
+      return cmp > 0;
+    case CompareOp::Ge:
+      return cmp >= 0;
+    case CompareOp::Between:
+      return cmp >= 0 && compare(col_index, upper) <= 0;
+  }
+  return false;
+}
+
+RecordCursor::RecordCursor(PagedFile* file, const Schema* schema, PageAccess access)
+    : file_(file), schema_(schema), access_(access) {}
+
+bool RecordCursor::read(size_t offset, RecordView* view, std::string* err) {
+  return read(offset, schema_->record_size(), view, err);
+}
+
+bool RecordCursor::read(size_t offset, size_t size, RecordView* view, std::string* err) {
+  const char* data = nullptr;
+  if (!file_->read_view(offset, size, access_, &page_, &scratch_, &data, err)) {
+    return false;
+  }
+  *view = RecordView(schema_, data);
+  return true;
+}
+
+bool RecordCursor::read_pax(const PaxLayout& layout, size_t page_id, size_t slot,
+                            RecordView* view, std::string* err) {
+  size_t page_size = file_->page_size();
+  const char* page = nullptr;
+  if (!file_->read_view(page_id * page_size, page_size, access_, &page_, &page_scratch_, &page,
+                        err)) {
+    return false;
+  }
+  scratch_.resize(schema_->record_size());
+  layout.gather(page, slot, scratch_.data());
+  *view = RecordView(schema_, scratch_.data());
+  return true;
+}
+
+bool RecordCursor::read_slotted(const SlottedLayout& layout, OverflowFile* overflow,
+                                size_t page_id, size_t slot, RecordView* view, std::string* err) {
+  size_t page_size = file_->page_size();
+  const char* page = nullptr;
+  if (!file_->read_view(page_id * page_size, page_size, access_, &page_, &page_scratch_, &page,
+                        err)) {
+    return false;
+  }
+  scratch_.resize(schema_->record_size());
+  if (!layout.unpack(page, slot, overflow, scratch_.data(), err)) {
+    return false;
+  }
+  *view = RecordView(schema_, scratch_.data());
+  return true;
+}
+
+bool RecordCursor::extend(AddedColumns* added, uint64_t row_id, RecordView* view,
+                          std::string* err) {
+  // 跨页记录与 PAX / 槽页记录已经在中转缓冲中。
+  if (view->data() != scratch_.data()) {
+    scratch_.assign(view->data(), view->data() + added->stored_size());
+  }
+  scratch_.resize(schema_->record_size());
+  if (!added->read(row_id, scratch_.data(), access_, err)) {
+    return false;
+  }
+  *view = RecordView(schema_, scratch_.data());
+  return true;
+}
+
+void RecordCursor::release() {
+  page_.release();
+}
+
+}  // namespace mini_db
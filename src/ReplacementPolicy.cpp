@@ -0,0 +1,336 @@
+#include "db/ReplacementPolicy.h"
+
+#include "db/Utils.h"
+
+#include <atomic>
+#include <deque>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace mini_db {
+
+namespace {
+
+constexpr int32_t kNoFrame = -1;
+
+// 帧下标组成的侵入式双向链表；多个链表可共用同一组链接数组（每个帧同一时刻只在一个链表中）。
+struct FrameLinks {
+  explicit FrameLinks(size_t capacity) : prev(capacity, kNoFrame), next(capacity, kNoFrame) {}
+
+  std::vector<int32_t> prev;
+  std::vector<int32_t> next;
+};
+
+// head 为最近放入的一端，tail 为最早放入（最先淘汰）的一端。
+class FrameList {
+ public:
+  explicit FrameList(FrameLinks* links) : links_(links) {}
+
+  void push_front(int32_t frame) {
+    size_t index = static_cast<size_t>(frame);
+    links_->prev[index] = kNoFrame;
+    links_->next[index] = head_;
+    if (head_ != kNoFrame) {
+      links_->prev[static_cast<size_t>(head_)] = frame;
+    }
+    head_ = frame;
+    if (tail_ == kNoFrame) {
+      tail_ = frame;
+    }
+    ++size_;
+  }
+
+  void push_back(int32_t frame) {
+    size_t index = static_cast<size_t>(frame);
+    links_->next[index] = kNoFrame;
+    links_->prev[index] = tail_;
+    if (tail_ != kNoFrame) {
+      links_->next[static_cast<size_t>(tail_)] = frame;
+    }
+    tail_ = frame;
+    if (head_ == kNoFrame) {
+      head_ = frame;
+    }
+    ++size_;
+  }
+
+  void unlink(int32_t frame) {
+    size_t index = static_cast<size_t>(frame);
+    int32_t prev = links_->prev[index];
+    int32_t next = links_->next[index];
+    if (prev != kNoFrame) {
+      links_->next[static_cast<size_t>(prev)] = next;
+    } else {
+      head_ = next;
+    }
+    if (next != kNoFrame) {
+      links_->prev[static_cast<size_t>(next)] = prev;
+    } else {
+      tail_ = prev;
+    }
+    links_->prev[index] = kNoFrame;
+    links_->next[index] = kNoFrame;
+    --size_;
+  }
+
+  // 从尾部向头部找第一个可淘汰的帧。
+  int32_t find_victim(const std::function<bool(int32_t)>& evictable) const {
+    for (int32_t frame = tail_; frame != kNoFrame;
+         frame = links_->prev[static_cast<size_t>(frame)]) {
+      if (evictable(frame)) {
+        return frame;
+      }
+    }
+    return kNoFrame;
+  }
+
+  size_t size() const { return size_; }
+
+ private:
+  FrameLinks* links_ = nullptr;
+  int32_t head_ = kNoFrame;
+  int32_t tail_ = kNoFrame;
+  size_t size_ = 0;
+};
+
+// 精确 LRU。扫描页放在冷端，扫描命中不提升，避免全表扫描冲掉热点页。
+class LruPolicy : public ReplacementPolicy {
+ public:
+  explicit LruPolicy(size_t capacity) : links_(capacity), lru_(&links_) {}
+
+  bool lock_free_hits() const override { return false; }
+
+  void on_insert(int32_t frame, size_t, PageAccess access) override {
+    if (access == PageAccess::Scan) {
+      lru_.push_back(frame);
+    } else {
+      lru_.push_front(frame);
+    }
+  }
+
+  void on_hit(int32_t frame, PageAccess access) override {
+    if (access == PageAccess::Scan) {
+      return;
+    }
+    lru_.unlink(frame);
+    lru_.push_front(frame);
+  }
+
+  void on_erase(int32_t frame, size_t) override { lru_.unlink(frame); }
+
+  int32_t pick_victim(const std::function<bool(int32_t)>& evictable) override {
+    return lru_.find_victim(evictable);
+  }
+
+ private:
+  FrameLinks links_;
+  FrameList lru_;
+};
+
+// CLOCK（二次机会）：命中只置引用位（原子变量），淘汰时时钟指针清除引用位直到遇到未被引用的帧。
+// 扫描装入与扫描命中都不置引用位，扫描页在指针第一次经过时即可被淘汰。
+class ClockPolicy : public ReplacementPolicy {
+ public:
+  explicit ClockPolicy(size_t capacity)
+      : capacity_(capacity),
+        referenced_(std::make_unique<std::atomic<uint8_t>[]>(capacity)),
+        resident_(capacity, 0) {
+    for (size_t i = 0; i < capacity_; ++i) {
+      referenced_[i].store(0, std::memory_order_relaxed);
+    }
+  }
+
+  bool lock_free_hits() const override { return true; }
+
+  void on_insert(int32_t frame, size_t, PageAccess access) override {
+    size_t index = static_cast<size_t>(frame);
+    resident_[index] = 1;
+    referenced_[index].store(access == PageAccess::Scan ? 0 : 1, std::memory_order_relaxed);
+  }
+
+  void on_hit(int32_t frame, PageAccess access) override {
+    if (access == PageAccess::Scan) {
+      return;
+    }
+    // 先读后写，已置位时不写，避免热点页的缓存行在核间来回失效。
+    std::atomic<uint8_t>& bit = referenced_[static_cast<size_t>(frame)];
+    if (bit.load(std::memory_order_relaxed) == 0) {
+      bit.store(1, std::memory_order_relaxed);
+    }
+  }
+
+  void on_erase(int32_t frame, size_t) override {
+    size_t index = static_cast<size_t>(frame);
+    resident_[index] = 0;
+    referenced_[index].store(0, std::memory_order_relaxed);
+  }
+
+  int32_t pick_victim(const std::function<bool(int32_t)>& evictable) override {
+    // 最多转两圈：第一圈清除引用位，第二圈必能遇到未被引用且未被钉住的帧（若存在）。
+    for (size_t step = 0; step < capacity_ * 2; ++step) {
+      size_t index = hand_;
+      hand_ = (hand_ + 1) % capacity_;
+      int32_t frame = static_cast<int32_t>(index);
+      if (!resident_[index] || !evictable(frame)) {
+        continue;
+      }
+      if (referenced_[index].exchange(0, std::memory_order_relaxed) != 0) {
+        continue;
+      }
+      return frame;
+    }
+    return kNoFrame;
+  }
+
+ private:
+  size_t capacity_ = 0;
+  std::unique_ptr<std::atomic<uint8_t>[]> referenced_;
+  std::vector<uint8_t> resident_;
+  size_t hand_ = 0;
+};
+
+// 2Q（Johnson & Shasha 完整版）：A1in 为新页的 FIFO 试用队列（约 1/4 容量），
+// A1out 为从 A1in 淘汰页的页号幽灵队列（约 1/2 容量，只记页号不占帧），Am 为主 LRU。
+// 缺页时页号在 A1out 中说明它被再次访问，直接进入 Am；否则进入 A1in。A1in 内的命中不提升。
+// 扫描页总是进入 A1in 且淘汰后不进入 A1out，因此一次性扫描只会轮换 A1in。
+class TwoQPolicy : public ReplacementPolicy {
+ public:
+  explicit TwoQPolicy(size_t capacity)
+      : links_(capacity),
+        a1in_(&links_),
+        am_(&links_),
+        in_am_(capacity, 0),
+        scan_(capacity, 0),
+        kin_(capacity / 4 > 0 ? capacity / 4 : 1),
+        kout_(capacity / 2 > 0 ? capacity / 2 : 1) {
+    ghost_.reserve(kout_ * 2);
+  }
+
+  bool lock_free_hits() const override { return false; }
+
+  void on_insert(int32_t frame, size_t page_id, PageAccess access) override {
+    size_t index = static_cast<size_t>(frame);
+    scan_[index] = access == PageAccess::Scan ? 1 : 0;
+    auto it = access == PageAccess::Scan ? ghost_.end() : ghost_.find(page_id);
+    if (it != ghost_.end()) {
+      ghost_.erase(it);
+      in_am_[index] = 1;
+      am_.push_front(frame);
+    } else {
+      in_am_[index] = 0;
+      a1in_.push_front(frame);
+    }
+  }
+
+  void on_hit(int32_t frame, PageAccess access) override {
+    size_t index = static_cast<size_t>(frame);
+    if (!in_am_[index]) {
+      // 普通访问命中扫描装入的页时，视为真正的访问，之后按普通页处理。
+      if (access == PageAccess::Normal) {
+        scan_[index] = 0;
+      }
+      return;
+    }
+    if (access == PageAccess::Normal) {
+      am_.unlink(frame);
+      am_.push_front(frame);
+    }
+  }
+
+  void on_erase(int32_t frame, size_t page_id) override {
+    size_t index = static_cast<size_t>(frame);
+    if (in_am_[index]) {
+      am_.unlink(frame);
+      return;
+    }
+    a1in_.unlink(frame);
+    if (!scan_[index]) {
+      remember(page_id);
+    }
+  }
+
+  int32_t pick_victim(const std::function<bool(int32_t)>& evictable) override {
+    int32_t frame = kNoFrame;
+    if (a1in_.size() > kin_) {
+      frame = a1in_.find_victim(evictable);
+    }
+    if (frame == kNoFrame) {
+      frame = am_.find_victim(evictable);
+    }
+    if (frame == kNoFrame) {
+      frame = a1in_.find_victim(evictable);
+    }
+    return frame;
+  }
+
+ private:
+  // 把页号加入 A1out，超出容量时按 FIFO 丢弃最早的页号。
+  void remember(size_t page_id) {
+    uint64_t seq = next_seq_++;
+    ghost_[page_id] = seq;
+    ghost_order_.emplace_back(page_id, seq);
+    // 队列中可能残留已被重新装入或重复记录的旧条目，序号不匹配时只出队不删除。
+    while (ghost_.size() > kout_ || ghost_order_.size() > kout_ * 2) {
+      auto oldest = ghost_order_.front();
+      ghost_order_.pop_front();
+      auto it = ghost_.find(oldest.first);
+      if (it != ghost_.end() && it->second == oldest.second) {
+        ghost_.erase(it);
+      }
+    }
+  }
+
+  FrameLinks links_;
+  FrameList a1in_;
+  FrameList am_;
+  std::vector<uint8_t> in_am_;
+  std::vector<uint8_t> scan_;
+  size_t kin_ = 1;
+  size_t kout_ = 1;
+  std::unordered_map<size_t, uint64_t> ghost_;
+  std::deque<std::pair<size_t, uint64_t>> ghost_order_;
+  uint64_t next_seq_ = 0;
+};
+
+}  // namespace
+
+bool parse_cache_policy(const std::string& name, CachePolicy* policy) {
+  std::string lowered = to_lower(name);
+  if (lowered == "lru") {
+    *policy = CachePolicy::Lru;
+  } else if (lowered == "clock") {
+    *policy = CachePolicy::Clock;
+  } else if (lowered == "2q" || lowered == "twoq") {
+    *policy = CachePolicy::TwoQ;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+const char* cache_policy_name(CachePolicy policy) {
+  switch (policy) {
+    case CachePolicy::Lru:
+      return "lru";
+    case CachePolicy::Clock:
+      return "clock";
+    case CachePolicy::TwoQ:
+      return "2q";
+  }
+  return "lru";
+}
+
+std::unique_ptr<ReplacementPolicy> create_replacement_policy(CachePolicy policy, size_t capacity) {
+  switch (policy) {
+    case CachePolicy::Clock:
+      return std::make_unique<ClockPolicy>(capacity);
+    case CachePolicy::TwoQ:
+      return std::make_unique<TwoQPolicy>(capacity);
+    case CachePolicy::Lru:
+      break;
+  }
+  return std::make_unique<LruPolicy>(capacity);
+}
+
+}  // namespace mini_db
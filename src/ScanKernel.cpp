@@ -0,0 +1,253 @@
+#include "db/ScanKernel.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MINI_DB_SCAN_AVX2 1
+#endif
+
+namespace mini_db {
+
+namespace {
+
+// 按小端序读取 32 位整数（与 Schema 编码一致）。
+int32_t load_int32(const char* p) {
+  const unsigned char* b = reinterpret_cast<const unsigned char*>(p);
+  uint32_t bits = static_cast<uint32_t>(b[0]) | (static_cast<uint32_t>(b[1]) << 8) |
+                  (static_cast<uint32_t>(b[2]) << 16) | (static_cast<uint32_t>(b[3]) << 24);
+  return static_cast<int32_t>(bits);
+}
+
+bool int_matches(int32_t v, const ScanFilter& filter) {
+  switch (filter.op) {
+    case CompareOp::Eq:
+      return v == filter.int_value;
+    case CompareOp::Ne:
+      return v != filter.int_value;
+    case CompareOp::Lt:
+      return v < filter.int_value;
+    case CompareOp::Le:
+      return v <= filter.int_value;
+    case CompareOp::Gt:
+      return v > filter.int_value;
+    case CompareOp::Ge:
+      return v >= filter.int_value;
+    case CompareOp::Between:
+      return v >= filter.int_value && v <= filter.int_upper;
+  }
+  return false;
+}
+
+bool text_matches(const char* field, const ScanFilter& filter) {
+  if (filter.op == CompareOp::Eq || filter.op == CompareOp::Ne) {
+    // 定长字段整段比较，补 0 部分一并参与。
+    bool equal = std::memcmp(field, filter.key.data(), filter.width) == 0;
+    return filter.op == CompareOp::Eq ? equal : !equal;
+  }
+  const void* end = std::memchr(field, '\0', filter.width);
+  size_t length = end ? static_cast<size_t>(static_cast<const char*>(end) - field) : filter.width;
+  std::string_view text(field, length);
+  int cmp = text.compare(filter.text_value);
+  switch (filter.op) {
+    case CompareOp::Lt:
+      return cmp < 0;
+    case CompareOp::Le:
+      return cmp <= 0;
+    case CompareOp::Gt:
+      return cmp > 0;
+    case CompareOp::Ge:
+      return cmp >= 0;
+    case CompareOp::Between:
+      return cmp >= 0 && text.compare(filter.text_upper) <= 0;
+    default:
+      break;
+  }
+  return false;
+}
+
+void filter_scalar(const char* base, size_t record_size, size_t count, uint64_t first_row,
+                   const ScanFilter& filter, std::vector<uint64_t>* selected) {
+  const char* record = base;
+  for (size_t i = 0; i < count; ++i, record += record_size) {
+    if (record[0] == 0) {
+      continue;
+    }
+    if (filter.has) {
+      const char* field = record + filter.offset;
+      bool match = filter.type == ColumnType::Int ? int_matches(load_int32(field), filter)
+                                                  : text_matches(field, filter);
+      if (!match) {
+        continue;
+      }
+    }
+    selected->push_back(first_row + i);
+  }
+}
+
+void filter_columns_scalar(const char* flags, const char* column, size_t count,
+                           uint64_t first_row, const ScanFilter& filter,
+                           std::vector<uint64_t>* selected) {
+  for (size_t i = 0; i < count; ++i) {
+    if (flags[i] == 0) {
+      continue;
+    }
+    if (filter.has) {
+      const char* field = column + i * filter.width;
+      bool match = filter.type == ColumnType::Int ? int_matches(load_int32(field), filter)
+                                                  : text_matches(field, filter);
+      if (!match) {
+        continue;
+      }
+    }
+    selected->push_back(first_row + i);
+  }
+}
+
+#ifdef MINI_DB_SCAN_AVX2
+// INT 比较：op 对应的 8 路比较掩码。
+__attribute__((target("avx2"))) __m256i int_match_avx2(__m256i v, __m256i lo, __m256i hi,
+                                                       CompareOp op) {
+  const __m256i ones = _mm256_set1_epi32(-1);
+  switch (op) {
+    case CompareOp::Eq:
+      return _mm256_cmpeq_epi32(v, lo);
+    case CompareOp::Ne:
+      return _mm256_xor_si256(_mm256_cmpeq_epi32(v, lo), ones);
+    case CompareOp::Lt:
+      return _mm256_cmpgt_epi32(lo, v);
+    case CompareOp::Le:
+      return _mm256_xor_si256(_mm256_cmpgt_epi32(v, lo), ones);
+    case CompareOp::Gt:
+      return _mm256_cmpgt_epi32(v, lo);
+    case CompareOp::Ge:
+      return _mm256_xor_si256(_mm256_cmpgt_epi32(lo, v), ones);
+    case CompareOp::Between:
+    default:
+      break;
+  }
+  return _mm256_andnot_si256(
+      _mm256_or_si256(_mm256_cmpgt_epi32(lo, v), _mm256_cmpgt_epi32(v, hi)), ones);
+}
+
+// INT 列的 AVX2 内核：每轮按记录步长 gather 8 行的有效标记（记录首 4 字节取低 8 位）与列值，
+// 比较结果合成 8 位掩码后按位输出行号。gather 每行读取的 4 字节都落在该记录内
+// （INT 列使记录至少 5 字节），不会越过页帧。调用方保证 filter 为 INT 列。
+__attribute__((target("avx2"))) void filter_int_avx2(const char* base, size_t record_size,
+                                                     size_t count, uint64_t first_row,
+                                                     const ScanFilter& filter,
+                                                     std::vector<uint64_t>* selected) {
+  const int stride = static_cast<int>(record_size);
+  const __m256i steps = _mm256_setr_epi32(0, stride, 2 * stride, 3 * stride, 4 * stride,
+                                          5 * stride, 6 * stride, 7 * stride);
+  const __m256i column = _mm256_add_epi32(steps, _mm256_set1_epi32(static_cast<int>(filter.offset)));
+  const __m256i flag_mask = _mm256_set1_epi32(0xFF);
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i ones = _mm256_set1_epi32(-1);
+  const __m256i lo = _mm256_set1_epi32(filter.int_value);
+  const __m256i hi = _mm256_set1_epi32(filter.int_upper);
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    const int* chunk = reinterpret_cast<const int*>(base + i * record_size);
+    __m256i flags = _mm256_and_si256(_mm256_i32gather_epi32(chunk, steps, 1), flag_mask);
+    __m256i valid = _mm256_xor_si256(_mm256_cmpeq_epi32(flags, zero), ones);
+    __m256i v = _mm256_i32gather_epi32(chunk, column, 1);
+    __m256i match = int_match_avx2(v, lo, hi, filter.op);
+    unsigned mask = static_cast<unsigned>(
+        _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_and_si256(valid, match))));
+    while (mask != 0) {
+      unsigned bit = static_cast<unsigned>(__builtin_ctz(mask));
+      selected->push_back(first_row + i + bit);
+      mask &= mask - 1;
+    }
+  }
+  filter_scalar(base + i * record_size, record_size, count - i, first_row + i, filter, selected);
+}
+
+// PAX 页的 INT 列 AVX2 内核：标记与列值在各自的 minipage 中连续存放，每轮连续加载 8 个标记
+// （零扩展为 32 位）与 8 个列值。调用方保证 filter 为 INT 列。
+__attribute__((target("avx2"))) void filter_columns_int_avx2(const char* flags,
+                                                             const char* column, size_t count,
+                                                             uint64_t first_row,
+                                                             const ScanFilter& filter,
+                                                             std::vector<uint64_t>* selected) {
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i ones = _mm256_set1_epi32(-1);
+  const __m256i lo = _mm256_set1_epi32(filter.int_value);
+  const __m256i hi = _mm256_set1_epi32(filter.int_upper);
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m128i flag_bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(flags + i));
+    __m256i valid = _mm256_xor_si256(_mm256_cmpeq_epi32(_mm256_cvtepu8_epi32(flag_bytes), zero),
+                                     ones);
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(column + i * 4));
+    __m256i match = int_match_avx2(v, lo, hi, filter.op);
+    unsigned mask = static_cast<unsigned>(
+        _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_and_si256(valid, match))));
+    while (mask != 0) {
+      unsigned bit = static_cast<unsigned>(__builtin_ctz(mask));
+      selected->push_back(first_row + i + bit);
+      mask &= mask - 1;
+    }
+  }
+  filter_columns_scalar(flags + i, column + i * 4, count - i, first_row + i, filter, selected);
+}
+#endif
+
+enum class Kernel {
+  Scalar,
+  Avx2,
+};
+
+Kernel detect_kernel() {
+  const char* env = std::getenv("MINI_DB_SCAN_KERNEL");
+  if (env && std::strcmp(env, "scalar") == 0) {
+    return Kernel::Scalar;
+  }
+#ifdef MINI_DB_SCAN_AVX2
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return Kernel::Avx2;
+  }
+#endif
+  return Kernel::Scalar;
+}
+
+Kernel active_kernel() {
+  static const Kernel kernel = detect_kernel();
+  return kernel;
+}
+
+}  // namespace
+
+void filter_records(const char* base, size_t record_size, size_t count, uint64_t first_row,
+                    const ScanFilter& filter, std::vector<uint64_t>* selected) {
+#ifdef MINI_DB_SCAN_AVX2
+  // gather 的下标为 32 位，单批记录跨度不超过一页，远小于该范围。
+  if (filter.has && filter.type == ColumnType::Int && active_kernel() == Kernel::Avx2 &&
+      count * record_size <= static_cast<size_t>(INT32_MAX)) {
+    filter_int_avx2(base, record_size, count, first_row, filter, selected);
+    return;
+  }
+#endif
+  filter_scalar(base, record_size, count, first_row, filter, selected);
+}
+
+void filter_columns(const char* flags, const char* column, size_t count, uint64_t first_row,
+                    const ScanFilter& filter, std::vector<uint64_t>* selected) {
+#ifdef MINI_DB_SCAN_AVX2
+  if (filter.has && filter.type == ColumnType::Int && active_kernel() == Kernel::Avx2) {
+    filter_columns_int_avx2(flags, column, count, first_row, filter, selected);
+    return;
+  }
+#endif
+  filter_columns_scalar(flags, column, count, first_row, filter, selected);
+}
+
+const char* scan_kernel_name() {
+  return active_kernel() == Kernel::Avx2 ? "avx2" : "scalar";
+}
+
+}  // namespace mini_db
@@ -2,6 +2,7 @@
 
 #include "db/Utils.h"
 
+#include <algorithm>
 #include <cstring>
 #include <limits>
 
@@ -10,28 +11,37 @@ namespace mini_db {
 namespace {
 
 // 按小端序写入 32 位整数。
-void write_int32(std::vector<char>* out, size_t offset, int32_t value) {
-  (*out)[offset] = static_cast<char>(value & 0xFF);
-  (*out)[offset + 1] = static_cast<char>((value >> 8) & 0xFF);
-  (*out)[offset + 2] = static_cast<char>((value >> 16) & 0xFF);
-  (*out)[offset + 3] = static_cast<char>((value >> 24) & 0xFF);
+void write_int32(char* out, int32_t value) {
+  uint32_t bits = static_cast<uint32_t>(value);
+  out[0] = static_cast<char>(bits & 0xFF);
+  out[1] = static_cast<char>((bits >> 8) & 0xFF);
+  out[2] = static_cast<char>((bits >> 16) & 0xFF);
+  out[3] = static_cast<char>((bits >> 24) & 0xFF);
 }
 
 // 按小端序读取 32 位整数。
-int32_t read_int32(const std::vector<char>& data, size_t offset) {
-  uint32_t b0 = static_cast<unsigned char>(data[offset]);
-  uint32_t b1 = static_cast<unsigned char>(data[offset + 1]);
-  uint32_t b2 = static_cast<unsigned char>(data[offset + 2]);
-  uint32_t b3 = static_cast<unsigned char>(data[offset + 3]);
+int32_t read_int32(const char* data) {
+  uint32_t b0 = static_cast<unsigned char>(data[0]);
+  uint32_t b1 = static_cast<unsigned char>(data[1]);
+  uint32_t b2 = static_cast<unsigned char>(data[2]);
+  uint32_t b3 = static_cast<unsigned char>(data[3]);
   return static_cast<int32_t>(b0 | (b1 << 8) | (b2 << 16) | (b3 << 24));
 }
 
 }  // namespace
 
 Schema::Schema(const std::vector<Column>& columns) : columns_(columns) {
-  // 预构建列名索引，便于快速查找。
+  // 预构建列名索引与列布局，便于快速查找。
+  layout_.reserve(columns_.size());
   for (size_t i = 0; i < columns_.size(); ++i) {
     column_map_[to_lower(columns_[i].name)] = i;
+    ColumnLayout col;
+    col.type = columns_[i].type;
+    col.offset = record_size_;
+    // INT 固定 4 字节，TEXT 使用列定义的固定长度。
+    col.width = col.type == ColumnType::Int ? sizeof(int32_t) : columns_[i].length;
+    record_size_ += col.width;
+    layout_.push_back(col);
   }
 }
 
@@ -40,21 +50,12 @@ const std::vector<Column>& Schema::columns() const {
 }
 
 size_t Schema::data_size() const {
-  // INT 固定 4 字节，TEXT 使用列定义的固定长度。
-  size_t size = 0;
-  for (const auto& col : columns_) {
-    if (col.type == ColumnType::Int) {
-      size += sizeof(int32_t);
-    } else {
-      size += col.length;
-    }
-  }
-  return size;
+  return record_size_ - 1;
 }
 
 size_t Schema::record_size() const {
   // 记录首字节为有效标记。
-  return 1 + data_size();
+  return record_size_;
 }
 
 int Schema::column_index(const std::string& name) const {
@@ -65,6 +66,66 @@ int Schema::column_index(const std::string& name) const {
   return static_cast<int>(it->second);
 }
 
+size_t Schema::column_offset(size_t col_index) const {
+  return col_index < layout_.size() ? layout_[col_index].offset : record_size_;
+}
+
+size_t Schema::column_width(size_t col_index) const {
+  return layout_[col_index].width;
+}
+
+const std::vector<ColumnLayout>& Schema::layout() const {
+  return layout_;
+}
+
+TableLayout Schema::table_layout() const {
+  return table_layout_;
+}
+
+void Schema::set_table_layout(TableLayout table_layout) {
+  table_layout_ = table_layout;
+}
+
+bool Schema::compressed() const {
+  return compressed_;
+}
+
+void Schema::set_compressed(bool compressed) {
+  compressed_ = compressed;
+}
+
+size_t Schema::stored_columns() const {
+  return stored_columns_ == 0 || stored_columns_ > columns_.size() ? columns_.size()
+                                                                   : stored_columns_;
+}
+
+void Schema::set_stored_columns(size_t count) {
+  stored_columns_ = count >= columns_.size() ? 0 : count;
+}
+
+Schema Schema::stored_schema() const {
+  // 列布局按顺序累加偏移，前缀列的偏移与完整结构一致。
+  auto end = columns_.begin() + static_cast<std::ptrdiff_t>(stored_columns());
+  Schema stored(std::vector<Column>(columns_.begin(), end));
+  stored.set_table_layout(table_layout_);
+  stored.set_compressed(compressed_);
+  return stored;
+}
+
+std::string Schema::encode_key(size_t col_index, const Value& value) const {
+  // 与 encode_record 的列编码保持一致：INT 小端 4 字节，TEXT 定长补 0。
+  std::string key(column_width(col_index), '\0');
+  if (columns_[col_index].type == ColumnType::Int) {
+    uint32_t bits = static_cast<uint32_t>(value.int_value);
+    for (size_t i = 0; i < sizeof(int32_t); ++i) {
+      key[i] = static_cast<char>((bits >> (8 * i)) & 0xFF);
+    }
+  } else {
+    std::memcpy(&key[0], value.text_value.data(), std::min(value.text_value.size(), key.size()));
+  }
+  return key;
+}
+
 bool Schema::normalize_value(size_t col_index, Value* value, std::string* err) const {
   // 将输入值转换为目标列类型并校验长度/范围。
   if (col_index >= columns_.size()) {
@@ -162,76 +223,81 @@ bool Schema::validate_values(std::vector<Value>* values, std::string* err) const
   return true;
 }
 
-std::vector<char> Schema::encode_record(std::vector<Value> values, bool valid, std::string* err) const {
-  // 先归一化数据，再按列顺序编码到固定长度记录中。
-  if (!validate_values(&values, err)) {
+std::vector<char> Schema::encode_record(const std::vector<Value>& values, bool valid,
+                                        std::string* err) const {
+  // 按列布局编码到固定长度记录中；只有类型不符或超长的值才复制一份归一化。
+  if (values.size() != columns_.size()) {
+    if (err) {
+      *err = "value count does not match column count";
+    }
     return {};
   }
-  std::vector<char> record(record_size(), 0);
+  std::vector<char> record(record_size_, 0);
   record[0] = valid ? 1 : 0;
-  size_t offset = 1;
   for (size_t i = 0; i < columns_.size(); ++i) {
-    const Column& col = columns_[i];
-    const Value& val = values[i];
-    if (col.type == ColumnType::Int) {
-      write_int32(&record, offset, val.int_value);
-      offset += sizeof(int32_t);
-    } else {
-      std::string text = val.text_value;
-      if (col.length > 0 && text.size() > col.length) {
-        if (err) {
-          *err = "TEXT value too long for column " + col.name;
-        }
+    const ColumnLayout& col = layout_[i];
+    const Value* value = &values[i];
+    Value normalized;
+    if (value->type != col.type ||
+        (col.type == ColumnType::Text && value->text_value.size() > col.width)) {
+      normalized = *value;
+      if (!normalize_value(i, &normalized, err)) {
         return {};
       }
-      // TEXT 列使用固定长度，不足补 0。
-      std::memset(record.data() + offset, 0, col.length);
-      std::memcpy(record.data() + offset, text.data(), text.size());
-      offset += col.length;
+      value = &normalized;
     }
+    encode_column(i, *value, record.data());
   }
   return record;
 }
 
+void Schema::encode_column(size_t col_index, const Value& value, char* record) const {
+  const ColumnLayout& col = layout_[col_index];
+  char* out = record + col.offset;
+  if (col.type == ColumnType::Int) {
+    write_int32(out, value.int_value);
+    return;
+  }
+  // TEXT 列使用固定长度，不足补 0。
+  size_t length = std::min(value.text_value.size(), col.width);
+  std::memcpy(out, value.text_value.data(), length);
+  std::memset(out + length, 0, col.width - length);
+}
+
+bool Schema::column_equals(const char* record, size_t col_index, const std::string& key) const {
+  const ColumnLayout& col = layout_[col_index];
+  return key.size() == col.width && std::memcmp(record + col.offset, key.data(), col.width) == 0;
+}
+
 bool Schema::decode_record(const std::vector<char>& record, std::vector<Value>* values, bool* valid,
                            std::string* err) const {
-  // 按列定义读取记录，并还原为 Value 列表。
-  if (record.size() < record_size()) {
+  // 按列布局读取记录，并还原为 Value 列表。
+  if (record.size() < record_size_) {
     if (err) {
       *err = "record size mismatch";
     }
     return false;
   }
-  if (values) {
-    values->clear();
-    values->reserve(columns_.size());
-  }
   if (valid) {
     *valid = record[0] != 0;
   }
-  size_t offset = 1;
-  for (const auto& col : columns_) {
+  if (!values) {
+    return true;
+  }
+  values->clear();
+  values->reserve(columns_.size());
+  for (const auto& col : layout_) {
+    const char* field = record.data() + col.offset;
     if (col.type == ColumnType::Int) {
-      int32_t val = read_int32(record, offset);
-      if (values) {
-        values->push_back(Value::Int(val));
-      }
-      offset += sizeof(int32_t);
+      values->push_back(Value::Int(read_int32(field)));
     } else {
       // TEXT 列读取到第一个 '\0' 结束。
-      std::string text;
-      text.reserve(col.length);
-      for (size_t i = 0; i < col.length; ++i) {
-        char c = record[offset + i];
-        if (c == '\0') {
-          break;
-        }
-        text.push_back(c);
-      }
-      if (values) {
-        values->push_back(Value::Text(text));
-      }
-      offset += col.length;
+      const void* end = std::memchr(field, '\0', col.width);
+      size_t length = end ? static_cast<size_t>(static_cast<const char*>(end) - field) : col.width;
+      Value value;
+      value.type = ColumnType::Text;
+      value.text_value.assign(field, length);
+      values->push_back(std::move(value));
     }
   }
   return true;
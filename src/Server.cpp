@@ -0,0 +1,612 @@
+#include "db/Server.h"
+
+#include "db/Executor.h"
+#include "db/Utils.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+namespace mini_db {
+
+namespace {
+
+// epoll 事件标记：监听套接字与唤醒用 eventfd，连接使用从 kFirstConnection 开始的编号。
+constexpr uint64_t kListenTag = 0;
+constexpr uint64_t kWakeTag = 1;
+constexpr uint64_t kFirstConnection = 2;
+// 每次 recv 的缓冲大小。
+constexpr size_t kReadChunk = 64 * 1024;
+// 连接积压的待发送字节超过该值时暂停读取，避免不读响应的客户端撑大输出缓冲。
+constexpr size_t kMaxPendingOutput = 4u << 20;
+
+bool is_ddl(StatementType type) {
+  return type == StatementType::CreateTable || type == StatementType::CreateIndex ||
+         type == StatementType::DropTable || type == StatementType::DropIndex ||
+         type == StatementType::AlterTableAdd;
+}
+
+std::vector<char> text_payload(const std::string& text) {
+  return std::vector<char>(text.begin(), text.end());
+}
+
+std::string errno_text(const std::string& what) {
+  return what + ": " + std::strerror(errno);
+}
+
+// 排队等待执行的 SQL；close 表示连接已关闭，销毁会话（回滚未提交的事务）。
+struct SqlRequest {
+  uint32_t request_id = 0;
+  std::string sql;
+  bool close = false;
+};
+
+}  // namespace
+
+struct Server::Connection {
+  uint64_t id = 0;
+  int fd = -1;
+  IoThread* owner = nullptr;
+  // SQL 会话执行所在的节点。
+  int node = 0;
+  // 以下只由所属网络线程访问：收到尚未分派的字节、正在发送的字节。
+  std::vector<char> input;
+  std::vector<char> sending;
+  size_t sent = 0;
+  bool read_eof = false;
+  // 已分派、尚未完成的请求数。
+  std::atomic<size_t> inflight{0};
+  // 以下受 mutex 保护。
+  std::mutex mutex;
+  std::vector<char> output;
+  bool closed = false;
+  // 已在所属网络线程的待处理列表中。
+  bool notified = false;
+  std::deque<SqlRequest> sql_queue;
+  bool sql_running = false;
+  bool has_session = false;
+  // 连接的会话，只由执行 run_sql 的工作线程访问（sql_running 保证同一时刻只有一个）。
+  std::unique_ptr<Executor> session;
+};
+
+struct Server::IoThread {
+  int epoll_fd = -1;
+  int wake_fd = -1;
+  std::thread thread;
+  // 本线程负责的连接（只由本线程访问）。
+  std::unordered_map<uint64_t, std::shared_ptr<Connection>> connections;
+  // 有新响应待发送或可以继续读取的连接。
+  std::mutex mutex;
+  std::vector<std::shared_ptr<Connection>> ready;
+};
+
+Server::Server(Database* db, int numa_nodes, const ServerOptions& options)
+    : db_(db),
+      numa_nodes_(numa_nodes > 0 ? numa_nodes : 1),
+      options_(options),
+      executor_(numa_nodes_, options.threads_per_node > 0 ? options.threads_per_node : 1) {
+  if (options_.io_threads <= 0) {
+    options_.io_threads = 1;
+  }
+  if (options_.max_pipeline == 0) {
+    options_.max_pipeline = 1;
+  }
+}
+
+Server::~Server() {
+  stop();
+}
+
+bool Server::start(std::string* err) {
+  if (running_) {
+    return true;
+  }
+  sockaddr_in addr;
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(options_.port);
+  if (inet_pton(AF_INET, options_.host.c_str(), &addr.sin_addr) != 1) {
+    if (err) {
+      *err = "invalid listen address: " + options_.host;
+    }
+    return false;
+  }
+  listen_fd_ = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (listen_fd_ < 0) {
+    if (err) {
+      *err = errno_text("failed to create socket");
+    }
+    return false;
+  }
+  int one = 1;
+  setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  if (::bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+      ::listen(listen_fd_, SOMAXCONN) != 0) {
+    if (err) {
+      *err = errno_text("failed to listen on " + options_.host + ":" +
+                        std::to_string(options_.port));
+    }
+    ::close(listen_fd_);
+    listen_fd_ = -1;
+    return false;
+  }
+  socklen_t len = sizeof(addr);
+  getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&addr), &len);
+  port_ = ntohs(addr.sin_port);
+
+  for (int i = 0; i < options_.io_threads; ++i) {
+    auto io = std::make_unique<IoThread>();
+    io->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    io->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (io->epoll_fd < 0 || io->wake_fd < 0) {
+      if (err) {
+        *err = errno_text("failed to create epoll");
+      }
+      if (io->epoll_fd >= 0) {
+        ::close(io->epoll_fd);
+      }
+      if (io->wake_fd >= 0) {
+        ::close(io->wake_fd);
+      }
+      stop();
+      return false;
+    }
+    // 监听套接字加入每个网络线程的 epoll，EPOLLEXCLUSIVE 使新连接只唤醒其中一个线程。
+    epoll_event listen_event;
+    listen_event.events = EPOLLIN | EPOLLEXCLUSIVE;
+    listen_event.data.u64 = kListenTag;
+    epoll_event wake_event;
+    wake_event.events = EPOLLIN;
+    wake_event.data.u64 = kWakeTag;
+    epoll_ctl(io->epoll_fd, EPOLL_CTL_ADD, listen_fd_, &listen_event);
+    epoll_ctl(io->epoll_fd, EPOLL_CTL_ADD, io->wake_fd, &wake_event);
+    io_threads_.push_back(std::move(io));
+  }
+  stop_ = false;
+  executor_.start();
+  for (auto& io : io_threads_) {
+    IoThread* raw = io.get();
+    io->thread = std::thread([this, raw]() { io_loop(raw); });
+  }
+  running_ = true;
+  return true;
+}
+
+void Server::stop() {
+  stop_ = true;
+  for (auto& io : io_threads_) {
+    uint64_t one = 1;
+    ssize_t ignored = ::write(io->wake_fd, &one, sizeof(one));
+    (void)ignored;
+  }
+  for (auto& io : io_threads_) {
+    if (io->thread.joinable()) {
+      io->thread.join();
+    }
+  }
+  // 网络线程退出时已关闭全部连接；等待已投递的请求（含销毁会话）执行完。
+  executor_.stop();
+  for (auto& io : io_threads_) {
+    io->ready.clear();
+    ::close(io->epoll_fd);
+    ::close(io->wake_fd);
+  }
+  io_threads_.clear();
+  if (listen_fd_ >= 0) {
+    ::close(listen_fd_);
+    listen_fd_ = -1;
+  }
+  running_ = false;
+}
+
+uint16_t Server::port() const {
+  return port_;
+}
+
+ServerStats Server::stats() const {
+  ServerStats stats;
+  stats.accepted = accepted_.load();
+  stats.rejected = rejected_.load();
+  stats.active = active_.load();
+  stats.requests = requests_.load();
+  return stats;
+}
+
+void Server::io_loop(IoThread* io) {
+  epoll_event events[64];
+  while (!stop_.load()) {
+    int count = epoll_wait(io->epoll_fd, events, 64, -1);
+    if (count < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      break;
+    }
+    for (int i = 0; i < count; ++i) {
+      uint64_t tag = events[i].data.u64;
+      if (tag == kListenTag) {
+        accept_connections(io);
+        continue;
+      }
+      if (tag == kWakeTag) {
+        uint64_t value = 0;
+        ssize_t ignored = ::read(io->wake_fd, &value, sizeof(value));
+        (void)ignored;
+        std::vector<std::shared_ptr<Connection>> ready;
+        {
+          std::lock_guard<std::mutex> lock(io->mutex);
+          ready.swap(io->ready);
+        }
+        for (const auto& conn : ready) {
+          if (conn->fd >= 0) {
+            service(io, conn);
+          }
+        }
+        continue;
+      }
+      auto it = io->connections.find(tag);
+      if (it == io->connections.end()) {
+        continue;
+      }
+      std::shared_ptr<Connection> conn = it->second;
+      if (events[i].events & EPOLLERR) {
+        close_connection(io, conn);
+        continue;
+      }
+      service(io, conn);
+    }
+  }
+  std::vector<std::shared_ptr<Connection>> remaining;
+  for (const auto& pair : io->connections) {
+    remaining.push_back(pair.second);
+  }
+  for (const auto& conn : remaining) {
+    close_connection(io, conn);
+  }
+}
+
+void Server::accept_connections(IoThread* io) {
+  while (true) {
+    int fd = ::accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      // EAGAIN：已被其他网络线程取走或队列为空。
+      return;
+    }
+    if (active_.load() >= options_.max_connections) {
+      ::close(fd);
+      rejected_.fetch_add(1);
+      continue;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    auto conn = std::make_shared<Connection>();
+    uint64_t number = next_connection_.fetch_add(1);
+    conn->id = kFirstConnection + number;
+    conn->fd = fd;
+    conn->owner = io;
+    conn->node = static_cast<int>(number % static_cast<uint64_t>(numa_nodes_));
+    epoll_event event;
+    event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+    event.data.u64 = conn->id;
+    if (epoll_ctl(io->epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0) {
+      ::close(fd);
+      continue;
+    }
+    io->connections[conn->id] = conn;
+    active_.fetch_add(1);
+    accepted_.fetch_add(1);
+  }
+}
+
+void Server::service(IoThread* io, const std::shared_ptr<Connection>& conn) {
+  // 取走工作线程放入的响应，与尚未发完的输出一起发送；之后继续读取（可能因流水线已满而暂停过）。
+  {
+    std::lock_guard<std::mutex> lock(conn->mutex);
+    conn->notified = false;
+    if (!conn->output.empty()) {
+      conn->sending.insert(conn->sending.end(), conn->output.begin(), conn->output.end());
+      conn->output.clear();
+    }
+  }
+  if (!flush(conn.get()) || !pump_input(conn) || !flush(conn.get())) {
+    close_connection(io, conn);
+    return;
+  }
+  if (conn->read_eof && conn->inflight.load() == 0 && conn->sending.empty()) {
+    bool drained = false;
+    {
+      std::lock_guard<std::mutex> lock(conn->mutex);
+      drained = conn->output.empty();
+    }
+    if (drained) {
+      close_connection(io, conn);
+    }
+  }
+}
+
+bool Server::pump_input(const std::shared_ptr<Connection>& conn) {
+  char buffer[kReadChunk];
+  while (true) {
+    size_t offset = 0;
+    while (conn->inflight.load() < options_.max_pipeline) {
+      WireFrame frame;
+      size_t consumed = 0;
+      std::string err;
+      if (!wire_parse_frame(conn->input.data() + offset, conn->input.size() - offset,
+                            options_.max_frame_bytes, &frame, &consumed, &err)) {
+        return false;
+      }
+      if (consumed == 0) {
+        break;
+      }
+      offset += consumed;
+      dispatch(conn, &frame);
+    }
+    conn->input.erase(conn->input.begin(), conn->input.begin() + static_cast<long>(offset));
+    // 暂停读取：请求完成或输出发出后 service 会再次进入这里。
+    if (conn->inflight.load() >= options_.max_pipeline ||
+        conn->sending.size() - conn->sent > kMaxPendingOutput || conn->read_eof) {
+      return true;
+    }
+    ssize_t n = ::recv(conn->fd, buffer, sizeof(buffer), 0);
+    if (n > 0) {
+      conn->input.insert(conn->input.end(), buffer, buffer + n);
+      continue;
+    }
+    if (n == 0) {
+      conn->read_eof = true;
+      return true;
+    }
+    if (errno == EINTR) {
+      continue;
+    }
+    return errno == EAGAIN || errno == EWOULDBLOCK;
+  }
+}
+
+bool Server::flush(Connection* conn) {
+  while (conn->sent < conn->sending.size()) {
+    ssize_t n = ::send(conn->fd, conn->sending.data() + conn->sent,
+                       conn->sending.size() - conn->sent, MSG_NOSIGNAL);
+    if (n > 0) {
+      conn->sent += static_cast<size_t>(n);
+      continue;
+    }
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      // 等待 EPOLLOUT。
+      return true;
+    }
+    return false;
+  }
+  conn->sending.clear();
+  conn->sent = 0;
+  return true;
+}
+
+void Server::dispatch(const std::shared_ptr<Connection>& conn, WireFrame* frame) {
+  requests_.fetch_add(1);
+  conn->inflight.fetch_add(1);
+  uint32_t request_id = frame->request_id;
+  WireOp op = static_cast<WireOp>(frame->code);
+  if (op == WireOp::Ping) {
+    complete(conn, request_id, WireStatus::Ok, {});
+    return;
+  }
+  if (op == WireOp::Query) {
+    bool start = false;
+    {
+      std::lock_guard<std::mutex> lock(conn->mutex);
+      conn->sql_queue.push_back(
+          SqlRequest{request_id, std::string(frame->payload.begin(), frame->payload.end()), false});
+      conn->has_session = true;
+      if (!conn->sql_running) {
+        conn->sql_running = true;
+        start = true;
+      }
+    }
+    if (start) {
+      executor_.post(conn->node, [this, conn]() { run_sql(conn); });
+    }
+    return;
+  }
+  if (op != WireOp::Get && op != WireOp::Update && op != WireOp::Delete) {
+    complete(conn, request_id, WireStatus::Error,
+             text_payload("unknown op: " + std::to_string(frame->code)));
+    return;
+  }
+  // 行操作：网络线程只解码并查出目标行所在页的节点，读写在该节点的工作线程上执行。
+  WireReader reader(frame->payload.data(), frame->payload.size());
+  std::string table;
+  uint64_t row_id = 0;
+  std::vector<SetClause> sets;
+  bool ok = reader.get_string(&table) && reader.get_u64(&row_id);
+  if (ok && op == WireOp::Update) {
+    uint16_t count = 0;
+    ok = reader.get_u16(&count);
+    for (uint16_t i = 0; ok && i < count; ++i) {
+      SetClause set;
+      ok = reader.get_string(&set.column) && reader.get_value(&set.value);
+      sets.push_back(std::move(set));
+    }
+  }
+  if (!ok || !reader.done()) {
+    complete(conn, request_id, WireStatus::Error, text_payload("malformed request"));
+    return;
+  }
+  int node = 0;
+  std::string err;
+  if (!db_->node_for_row(table, row_id, &node, &err)) {
+    complete(conn, request_id, WireStatus::Error, text_payload(err));
+    return;
+  }
+  executor_.post(node, [this, conn, request_id, op, table = std::move(table), row_id,
+                        sets = std::move(sets)]() {
+    std::shared_lock<std::shared_mutex> gate(ddl_mutex_);
+    std::string task_err;
+    std::vector<char> payload;
+    bool done = false;
+    if (op == WireOp::Get) {
+      std::vector<Value> values;
+      bool valid = false;
+      done = db_->read_row(table, row_id, &values, &valid, &task_err);
+      if (done) {
+        wire_put_u8(&payload, valid ? 1 : 0);
+        wire_put_u16(&payload, static_cast<uint16_t>(valid ? values.size() : 0));
+        for (size_t i = 0; valid && i < values.size(); ++i) {
+          wire_put_value(&payload, values[i]);
+        }
+      }
+    } else if (op == WireOp::Update) {
+      done = db_->update_row(table, row_id, sets, &task_err);
+    } else {
+      done = db_->delete_row(table, row_id, &task_err);
+    }
+    gate.unlock();
+    if (done) {
+      complete(conn, request_id, WireStatus::Ok, payload);
+    } else {
+      complete(conn, request_id, WireStatus::Error, text_payload(task_err));
+    }
+  });
+}
+
+void Server::run_sql(const std::shared_ptr<Connection>& conn) {
+  while (true) {
+    SqlRequest request;
+    bool closed = false;
+    {
+      std::lock_guard<std::mutex> lock(conn->mutex);
+      if (conn->sql_queue.empty()) {
+        conn->sql_running = false;
+        return;
+      }
+      request = std::move(conn->sql_queue.front());
+      conn->sql_queue.pop_front();
+      closed = conn->closed;
+    }
+    if (request.close) {
+      std::shared_lock<std::shared_mutex> gate(ddl_mutex_);
+      conn->session.reset();
+      continue;
+    }
+    if (closed) {
+      // 连接已关闭：不再执行排队的语句。
+      conn->inflight.fetch_sub(1);
+      continue;
+    }
+    WireStatus status = WireStatus::Ok;
+    std::vector<char> payload;
+    execute_sql(conn.get(), request.sql, &status, &payload);
+    complete(conn, request.request_id, status, payload);
+  }
+}
+
+void Server::execute_sql(Connection* conn, const std::string& sql, WireStatus* status,
+                         std::vector<char>* payload) {
+  std::string text = trim(sql);
+  while (!text.empty() && text.back() == ';') {
+    text.pop_back();
+    text = trim(text);
+  }
+  Statement statement;
+  std::string err;
+  if (!parser_.parse(text, &statement, &err)) {
+    *status = WireStatus::Error;
+    *payload = text_payload(err);
+    return;
+  }
+  std::unique_lock<std::shared_mutex> exclusive(ddl_mutex_, std::defer_lock);
+  std::shared_lock<std::shared_mutex> shared(ddl_mutex_, std::defer_lock);
+  if (is_ddl(statement.type)) {
+    exclusive.lock();
+  } else {
+    shared.lock();
+  }
+  if (!conn->session) {
+    conn->session = std::make_unique<Executor>();
+  }
+  std::string output;
+  if (!conn->session->execute(statement, db_, &output, &err)) {
+    *status = WireStatus::Error;
+    *payload = text_payload(err);
+    return;
+  }
+  *status = WireStatus::Ok;
+  *payload = text_payload(output);
+}
+
+void Server::complete(const std::shared_ptr<Connection>& conn, uint32_t request_id,
+                      WireStatus status, const std::vector<char>& payload) {
+  bool wake = false;
+  {
+    std::lock_guard<std::mutex> lock(conn->mutex);
+    conn->inflight.fetch_sub(1);
+    if (conn->closed) {
+      return;
+    }
+    wire_put_frame(&conn->output, request_id, static_cast<uint8_t>(status), payload);
+    if (!conn->notified) {
+      conn->notified = true;
+      wake = true;
+    }
+  }
+  if (!wake) {
+    return;
+  }
+  IoThread* io = conn->owner;
+  {
+    std::lock_guard<std::mutex> lock(io->mutex);
+    io->ready.push_back(conn);
+  }
+  uint64_t one = 1;
+  ssize_t ignored = ::write(io->wake_fd, &one, sizeof(one));
+  (void)ignored;
+}
+
+void Server::close_connection(IoThread* io, const std::shared_ptr<Connection>& conn) {
+  if (conn->fd < 0) {
+    return;
+  }
+  epoll_ctl(io->epoll_fd, EPOLL_CTL_DEL, conn->fd, nullptr);
+  ::close(conn->fd);
+  conn->fd = -1;
+  bool start = false;
+  {
+    std::lock_guard<std::mutex> lock(conn->mutex);
+    conn->closed = true;
+    conn->output.clear();
+    // 会话在工作线程上销毁（回滚未提交的事务会访问存储）。
+    if (conn->has_session) {
+      conn->sql_queue.push_back(SqlRequest{0, std::string(), true});
+      if (!conn->sql_running) {
+        conn->sql_running = true;
+        start = true;
+      }
+    }
+  }
+  if (start) {
+    executor_.post(conn->node, [this, conn]() { run_sql(conn); });
+  }
+  io->connections.erase(conn->id);
+  active_.fetch_sub(1);
+}
+
+}  // namespace mini_db
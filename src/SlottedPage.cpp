@@ -0,0 +1,430 @@
+#include "db/SlottedPage.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace mini_db {
+
+namespace {
+
+// 按小端序写入 / 读取 16 位与 32 位无符号整数。
+void store_uint16(char* out, size_t value) {
+  out[0] = static_cast<char>(value & 0xFF);
+  out[1] = static_cast<char>((value >> 8) & 0xFF);
+}
+
+size_t load_uint16(const char* data) {
+  return static_cast<size_t>(static_cast<unsigned char>(data[0])) |
+         (static_cast<size_t>(static_cast<unsigned char>(data[1])) << 8);
+}
+
+void store_uint32(char* out, uint32_t value) {
+  for (size_t i = 0; i < 4; ++i) {
+    out[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+  }
+}
+
+uint32_t load_uint32(const char* data) {
+  uint32_t value = 0;
+  for (size_t i = 0; i < 4; ++i) {
+    value |= static_cast<uint32_t>(static_cast<unsigned char>(data[i])) << (8 * i);
+  }
+  return value;
+}
+
+// 槽页偏移与分配长度为 16 位，页大小上限。
+constexpr size_t kMaxSlottedPageSize = 65536;
+
+}  // namespace
+
+SlottedLayout::SlottedLayout(const Schema& schema, size_t page_size)
+    : page_size_(page_size), record_size_(schema.record_size()) {
+  for (const auto& col : schema.layout()) {
+    Field field;
+    field.type = col.type;
+    field.offset = col.offset;
+    field.width = col.width;
+    // 最小形式：INT 定长；TEXT 短于溢出引用的列总是内联，其余预留一个溢出引用。
+    field.reserve = col.type == ColumnType::Int ? col.width : std::min(col.width + 2, kRefSize);
+    min_alloc_ += field.reserve;
+    fields_.push_back(field);
+  }
+  // 单个值内联的上限：超过页的四分之一就放到溢出页，避免一条记录独占整页。
+  inline_limit_ = std::min<size_t>(page_size / 4, kRefMarker - 1);
+  if (page_size <= kMaxSlottedPageSize && page_size > kPageHeaderSize) {
+    slots_per_page_ = (page_size - kPageHeaderSize) / (kSlotSize + min_alloc_);
+  }
+}
+
+size_t SlottedLayout::slots_per_page() const {
+  return slots_per_page_;
+}
+
+size_t SlottedLayout::page_for_row(uint64_t row_id) const {
+  return 1 + static_cast<size_t>(row_id / slots_per_page_);
+}
+
+size_t SlottedLayout::slot_for_row(uint64_t row_id) const {
+  return static_cast<size_t>(row_id % slots_per_page_);
+}
+
+uint64_t SlottedLayout::first_row_in_page(size_t page_id) const {
+  return page_id <= 1 ? 0 : static_cast<uint64_t>(page_id - 1) * slots_per_page_;
+}
+
+size_t SlottedLayout::slot_count(const char* page) const {
+  return load_uint16(page);
+}
+
+bool SlottedLayout::present(const char* page, size_t slot) const {
+  return slot < slot_count(page) && slot_offset(page, slot) != 0;
+}
+
+bool SlottedLayout::valid(const char* page, size_t slot) const {
+  return present(page, slot) && page[slot_offset(page, slot)] != 0;
+}
+
+size_t SlottedLayout::free_space(const char* page) const {
+  size_t count = slot_count(page);
+  size_t used = kPageHeaderSize + count * kSlotSize;
+  for (size_t i = 0; i < count; ++i) {
+    size_t offset = slot_offset(page, i);
+    if (offset != 0) {
+      used += std::max(record_length(page + offset), min_alloc_);
+    }
+  }
+  return page_size_ - std::min(used, page_size_);
+}
+
+size_t SlottedLayout::empty_space() const {
+  return page_size_ - kPageHeaderSize;
+}
+
+size_t SlottedLayout::record_space(const char* image) const {
+  size_t full = std::max(packed_size(image, false), min_alloc_);
+  return kPageHeaderSize + kSlotSize + full <= page_size_ ? full : min_alloc_;
+}
+
+bool SlottedLayout::unpack(const char* page, size_t slot, OverflowFile* overflow, char* image,
+                           std::string* err) const {
+  std::memset(image, 0, record_size_);
+  if (!present(page, slot)) {
+    return true;
+  }
+  const char* record = page + slot_offset(page, slot);
+  image[0] = record[0];
+  size_t pos = 1;
+  for (const auto& field : fields_) {
+    if (field.type == ColumnType::Int) {
+      std::memcpy(image + field.offset, record + pos, field.width);
+      pos += field.width;
+      continue;
+    }
+    size_t length = load_uint16(record + pos);
+    if (length == kRefMarker) {
+      uint32_t first_page = load_uint32(record + pos + 2);
+      size_t size = load_uint32(record + pos + 6);
+      if (size > field.width) {
+        if (err) {
+          *err = "corrupt slotted record";
+        }
+        return false;
+      }
+      if (!overflow || !overflow->read(first_page, size, image + field.offset, err)) {
+        return false;
+      }
+      pos += kRefSize;
+      continue;
+    }
+    if (length > field.width) {
+      if (err) {
+        *err = "corrupt slotted record";
+      }
+      return false;
+    }
+    std::memcpy(image + field.offset, record + pos + 2, length);
+    pos += 2 + length;
+  }
+  return true;
+}
+
+bool SlottedLayout::store(char* page, size_t slot, const char* image, OverflowFile* overflow,
+                          bool redo, std::string* err) const {
+  // 先保存原记录：放置新记录时可能原位覆盖或整理页内空间，写完后再回收它的溢出页。
+  std::vector<char> old;
+  if (present(page, slot)) {
+    const char* record = page + slot_offset(page, slot);
+    old.assign(record, record + record_length(record));
+  }
+  bool compact = !fits_compacted(page, slot, packed_size(image, false));
+  if (compact && !fits_compacted(page, slot, packed_size(image, true)) &&
+      !demote(page, slot, overflow, redo, err)) {
+    return false;
+  }
+  std::vector<char> packed(packed_size(image, compact));
+  if (!pack(image, compact, overflow, redo, packed.data(), err)) {
+    return false;
+  }
+  char* dest = place(page, slot, packed.size());
+  if (!dest) {
+    if (err) {
+      *err = "slotted page overflow";
+    }
+    return false;
+  }
+  std::memcpy(dest, packed.data(), packed.size());
+  if (!old.empty() && !redo) {
+    return release(old.data(), overflow, err);
+  }
+  return true;
+}
+
+void SlottedLayout::collect_overflow(const char* page,
+                                     std::vector<std::pair<uint32_t, uint32_t>>* chains) const {
+  size_t count = slot_count(page);
+  for (size_t slot = 0; slot < count; ++slot) {
+    size_t offset = slot_offset(page, slot);
+    if (offset == 0) {
+      continue;
+    }
+    const char* record = page + offset;
+    size_t pos = 1;
+    for (const auto& field : fields_) {
+      if (field.type == ColumnType::Int) {
+        pos += field.width;
+        continue;
+      }
+      size_t length = load_uint16(record + pos);
+      if (length == kRefMarker) {
+        chains->emplace_back(load_uint32(record + pos + 2), load_uint32(record + pos + 6));
+        pos += kRefSize;
+      } else {
+        pos += 2 + length;
+      }
+    }
+  }
+}
+
+size_t SlottedLayout::text_length(const char* value, size_t width) {
+  size_t length = width;
+  while (length > 0 && value[length - 1] == 0) {
+    --length;
+  }
+  return length;
+}
+
+bool SlottedLayout::inline_text(const Field& field, size_t length, bool compact) const {
+  return compact ? length + 2 <= field.reserve : length <= inline_limit_;
+}
+
+size_t SlottedLayout::packed_size(const char* image, bool compact) const {
+  size_t size = 1;
+  for (const auto& field : fields_) {
+    if (field.type == ColumnType::Int) {
+      size += field.width;
+      continue;
+    }
+    size_t length = text_length(image + field.offset, field.width);
+    size += inline_text(field, length, compact) ? 2 + length : kRefSize;
+  }
+  return size;
+}
+
+bool SlottedLayout::pack(const char* image, bool compact, OverflowFile* overflow, bool redo,
+                         char* out, std::string* err) const {
+  out[0] = image[0];
+  size_t pos = 1;
+  for (const auto& field : fields_) {
+    const char* value = image + field.offset;
+    if (field.type == ColumnType::Int) {
+      std::memcpy(out + pos, value, field.width);
+      pos += field.width;
+      continue;
+    }
+    size_t length = text_length(value, field.width);
+    if (inline_text(field, length, compact)) {
+      store_uint16(out + pos, length);
+      std::memcpy(out + pos + 2, value, length);
+      pos += 2 + length;
+      continue;
+    }
+    uint32_t first_page = 0;
+    if (!overflow || !overflow->write(value, length, redo, &first_page, err)) {
+      return false;
+    }
+    store_uint16(out + pos, kRefMarker);
+    store_uint32(out + pos + 2, first_page);
+    store_uint32(out + pos + 6, static_cast<uint32_t>(length));
+    pos += kRefSize;
+  }
+  return true;
+}
+
+size_t SlottedLayout::record_length(const char* record) const {
+  size_t pos = 1;
+  for (const auto& field : fields_) {
+    if (field.type == ColumnType::Int) {
+      pos += field.width;
+      continue;
+    }
+    size_t length = load_uint16(record + pos);
+    pos += length == kRefMarker ? kRefSize : 2 + length;
+  }
+  return pos;
+}
+
+bool SlottedLayout::release(const char* record, OverflowFile* overflow, std::string* err) const {
+  size_t pos = 1;
+  for (const auto& field : fields_) {
+    if (field.type == ColumnType::Int) {
+      pos += field.width;
+      continue;
+    }
+    size_t length = load_uint16(record + pos);
+    if (length != kRefMarker) {
+      pos += 2 + length;
+      continue;
+    }
+    if (overflow &&
+        !overflow->release(load_uint32(record + pos + 2), load_uint32(record + pos + 6), err)) {
+      return false;
+    }
+    pos += kRefSize;
+  }
+  return true;
+}
+
+size_t SlottedLayout::heap_start(const char* page) const {
+  uint32_t heap = load_uint32(page + 4);
+  return heap == 0 ? page_size_ : heap;
+}
+
+size_t SlottedLayout::slot_offset(const char* page, size_t slot) const {
+  return load_uint16(page + kPageHeaderSize + slot * kSlotSize);
+}
+
+size_t SlottedLayout::slot_alloc(const char* page, size_t slot) const {
+  return load_uint16(page + kPageHeaderSize + slot * kSlotSize + 2);
+}
+
+void SlottedLayout::set_slot(char* page, size_t slot, size_t offset, size_t alloc) const {
+  store_uint16(page + kPageHeaderSize + slot * kSlotSize, offset);
+  store_uint16(page + kPageHeaderSize + slot * kSlotSize + 2, alloc);
+}
+
+bool SlottedLayout::fits_directly(const char* page, size_t slot, size_t size) const {
+  size = std::max(size, min_alloc_);
+  size_t count = slot_count(page);
+  if (present(page, slot) && slot_alloc(page, slot) >= size) {
+    return true;
+  }
+  size_t dir_end = kPageHeaderSize + std::max(count, slot + 1) * kSlotSize;
+  return heap_start(page) >= dir_end + size;
+}
+
+bool SlottedLayout::fits_compacted(const char* page, size_t slot, size_t size) const {
+  if (fits_directly(page, slot, size)) {
+    return true;
+  }
+  size_t count = slot_count(page);
+  size_t used = kPageHeaderSize + std::max(count, slot + 1) * kSlotSize;
+  for (size_t i = 0; i < count; ++i) {
+    size_t offset = slot_offset(page, i);
+    if (i != slot && offset != 0) {
+      used += std::max(record_length(page + offset), min_alloc_);
+    }
+  }
+  return page_size_ >= used + std::max(size, min_alloc_);
+}
+
+char* SlottedLayout::place(char* page, size_t slot, size_t size) const {
+  size = std::max(size, min_alloc_);
+  if (present(page, slot) && slot_alloc(page, slot) >= size) {
+    return page + slot_offset(page, slot);
+  }
+  if (!fits_directly(page, slot, size)) {
+    if (!fits_compacted(page, slot, size)) {
+      return nullptr;
+    }
+    // 丢弃槽上的原记录（调用方已保存），整理后连续空闲区一定放得下。
+    if (slot < slot_count(page)) {
+      set_slot(page, slot, 0, 0);
+    }
+    compact(page);
+  }
+  size_t count = slot_count(page);
+  if (slot >= count) {
+    std::memset(page + kPageHeaderSize + count * kSlotSize, 0, (slot + 1 - count) * kSlotSize);
+    store_uint16(page, slot + 1);
+  }
+  size_t heap = heap_start(page) - size;
+  store_uint32(page + 4, static_cast<uint32_t>(heap));
+  set_slot(page, slot, heap, size);
+  return page + heap;
+}
+
+void SlottedLayout::compact(char* page) const {
+  std::vector<char> copy(page, page + page_size_);
+  size_t count = slot_count(page);
+  size_t heap = page_size_;
+  for (size_t i = 0; i < count; ++i) {
+    size_t offset = slot_offset(copy.data(), i);
+    if (offset == 0) {
+      continue;
+    }
+    size_t length = record_length(copy.data() + offset);
+    size_t alloc = std::max(length, min_alloc_);
+    heap -= alloc;
+    std::memcpy(page + heap, copy.data() + offset, length);
+    set_slot(page, i, heap, alloc);
+  }
+  store_uint32(page + 4, static_cast<uint32_t>(heap));
+}
+
+bool SlottedLayout::demote(char* page, size_t slot, OverflowFile* overflow, bool redo,
+                           std::string* err) const {
+  size_t count = slot_count(page);
+  std::vector<char> out;
+  for (size_t i = 0; i < count; ++i) {
+    size_t offset = slot_offset(page, i);
+    if (i == slot || offset == 0) {
+      continue;
+    }
+    char* record = page + offset;
+    out.assign(1, record[0]);
+    size_t pos = 1;
+    bool changed = false;
+    for (const auto& field : fields_) {
+      if (field.type == ColumnType::Int) {
+        out.insert(out.end(), record + pos, record + pos + field.width);
+        pos += field.width;
+        continue;
+      }
+      size_t length = load_uint16(record + pos);
+      if (length == kRefMarker || length + 2 <= field.reserve) {
+        size_t size = length == kRefMarker ? kRefSize : 2 + length;
+        out.insert(out.end(), record + pos, record + pos + size);
+        pos += size;
+        continue;
+      }
+      uint32_t first_page = 0;
+      if (!overflow || !overflow->write(record + pos + 2, length, redo, &first_page, err)) {
+        return false;
+      }
+      char ref[kRefSize];
+      store_uint16(ref, kRefMarker);
+      store_uint32(ref + 2, first_page);
+      store_uint32(ref + 6, static_cast<uint32_t>(length));
+      out.insert(out.end(), ref, ref + kRefSize);
+      pos += 2 + length;
+      changed = true;
+    }
+    // 最小形式不长于原记录，原位改写即可，腾出的空间由随后的整理回收。
+    if (changed) {
+      std::memcpy(record, out.data(), out.size());
+    }
+  }
+  return true;
+}
+
+}  // namespace mini_db
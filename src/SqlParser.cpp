@@ -26,7 +26,8 @@ struct Token {
 
 // SQL 中支持的单字符符号。
 bool is_symbol(char c) {
-  return c == '(' || c == ')' || c == ',' || c == '=' || c == '*';
+  return c == '(' || c == ')' || c == ',' || c == '=' || c == '*' || c == '<' || c == '>' ||
+         c == '?';
 }
 
 // 简单词法分析：按空白分隔、识别符号、字符串与数字。
@@ -39,6 +40,13 @@ std::vector<Token> tokenize(const std::string& sql, std::string* err) {
       ++i;
       continue;
     }
+    if ((c == '<' || c == '>' || c == '!') && i + 1 < sql.size() &&
+        (sql[i + 1] == '=' || (c == '<' && sql[i + 1] == '>'))) {
+      // 双字符比较运算符：<= >= != <>。
+      tokens.push_back({TokenType::Symbol, sql.substr(i, 2)});
+      i += 2;
+      continue;
+    }
     if (is_symbol(c)) {
       tokens.push_back({TokenType::Symbol, std::string(1, c)});
       ++i;
@@ -93,9 +101,11 @@ std::vector<Token> tokenize(const std::string& sql, std::string* err) {
 }
 
 // 递归下降式解析器，按 token 序列解析 SQL。
+// placeholders 为 true 时（PREPARE 的语句体）值的位置可以是 ? 占位符，由调用方用 note_param 登记位置。
 class Parser {
  public:
-  explicit Parser(std::vector<Token> tokens) : tokens_(std::move(tokens)) {}
+  Parser(std::vector<Token> tokens, bool placeholders)
+      : tokens_(std::move(tokens)), placeholders_(placeholders) {}
 
   // 是否已到达 token 末尾。
   bool eof() const { return pos_ >= tokens_.size(); }
@@ -135,7 +145,8 @@ class Parser {
       return false;
     }
     const Token& tok = tokens_[pos_];
-    if (tok.type == TokenType::Identifier && to_upper(tok.text) == keyword) {
+    // 逐字符忽略大小写比较，不为每次匹配生成大写副本。
+    if (tok.type == TokenType::Identifier && iequals(tok.text, keyword)) {
       ++pos_;
       return true;
     }
@@ -196,8 +207,42 @@ class Parser {
     return true;
   }
 
+  bool expect_string(std::string* out, std::string* err) {
+    // 读取字符串字面量（文件路径等）。
+    if (eof() || tokens_[pos_].type != TokenType::String) {
+      if (err) {
+        *err = "expected string";
+      }
+      return false;
+    }
+    if (out) {
+      *out = tokens_[pos_].text;
+    }
+    ++pos_;
+    return true;
+  }
+
+  // 剩余的 token（PREPARE 的语句体）。
+  std::vector<Token> rest() const {
+    return std::vector<Token>(tokens_.begin() + static_cast<std::ptrdiff_t>(pos_), tokens_.end());
+  }
+
+  // 上一个 parse_value 读到的是 ? 占位符时，登记其位置。
+  void note_param(ParamTarget target, size_t row, size_t index) {
+    if (pending_param_) {
+      ParamSlot slot;
+      slot.target = target;
+      slot.row = row;
+      slot.index = index;
+      params_.push_back(slot);
+      pending_param_ = false;
+    }
+  }
+
+  const std::vector<ParamSlot>& params() const { return params_; }
+
   bool parse_value(Value* value, std::string* err) {
-    // 解析常量值：数字/字符串/标识符（作为 TEXT）。
+    // 解析常量值：数字/字符串/标识符（作为 TEXT），PREPARE 中还可以是 ? 占位符。
     if (eof()) {
       if (err) {
         *err = "expected value";
@@ -205,6 +250,21 @@ class Parser {
       return false;
     }
     const Token& tok = tokens_[pos_];
+    if (tok.type == TokenType::Symbol && tok.text == "?") {
+      if (!placeholders_) {
+        if (err) {
+          *err = "placeholder ? is only allowed in PREPARE";
+        }
+        return false;
+      }
+      // 占位符先留空值，EXECUTE 时按 params 的位置填入参数。
+      if (value) {
+        *value = Value{};
+      }
+      pending_param_ = true;
+      ++pos_;
+      return true;
+    }
     if (tok.type == TokenType::Number) {
       // 数值范围限制为 int32。
       long long parsed = 0;
@@ -250,6 +310,60 @@ class Parser {
     return false;
   }
 
+  bool parse_condition(Condition* where, std::string* err) {
+    // 解析 WHERE 条件：col op value 或 col BETWEEN low AND high。
+    where->has = true;
+    if (!expect_identifier(&where->column, err)) {
+      return false;
+    }
+    if (match_keyword("BETWEEN")) {
+      where->op = CompareOp::Between;
+      if (!parse_value(&where->value, err)) {
+        return false;
+      }
+      note_param(ParamTarget::WhereValue, 0, 0);
+      if (!expect_keyword("AND", err)) {
+        return false;
+      }
+      if (!parse_value(&where->upper, err)) {
+        return false;
+      }
+      note_param(ParamTarget::WhereUpper, 0, 0);
+      return true;
+    }
+    if (eof() || tokens_[pos_].type != TokenType::Symbol) {
+      if (err) {
+        *err = "expected comparison operator";
+      }
+      return false;
+    }
+    const std::string& op = tokens_[pos_].text;
+    if (op == "=") {
+      where->op = CompareOp::Eq;
+    } else if (op == "!=" || op == "<>") {
+      where->op = CompareOp::Ne;
+    } else if (op == "<") {
+      where->op = CompareOp::Lt;
+    } else if (op == "<=") {
+      where->op = CompareOp::Le;
+    } else if (op == ">") {
+      where->op = CompareOp::Gt;
+    } else if (op == ">=") {
+      where->op = CompareOp::Ge;
+    } else {
+      if (err) {
+        *err = "expected comparison operator";
+      }
+      return false;
+    }
+    ++pos_;
+    if (!parse_value(&where->value, err)) {
+      return false;
+    }
+    note_param(ParamTarget::WhereValue, 0, 0);
+    return true;
+  }
+
   bool parse_column_type(Column* column, std::string* err) {
     // 解析列类型描述（INT / TEXT(n)）。
     std::string type;
@@ -292,37 +406,137 @@ class Parser {
  private:
   std::vector<Token> tokens_;
   size_t pos_ = 0;
+  bool placeholders_ = false;
+  bool pending_param_ = false;
+  std::vector<ParamSlot> params_;
 };
 
-}  // namespace
-
-bool SqlParser::parse(const std::string& sql, Statement* statement, std::string* err) const {
-  // 顶层语法入口：根据关键字分派不同语句。
-  if (!statement) {
-    if (err) {
-      *err = "statement output missing";
+// 按关键字分派解析一条语句（PREPARE 的语句体递归使用）。
+bool parse_statement(Parser& parser, Statement* statement, std::string* err) {
+  if (parser.match_keyword("PREPARE")) {
+    // PREPARE name AS <INSERT | SELECT | UPDATE | DELETE>，值的位置可以写 ? 占位符。
+    statement->type = StatementType::Prepare;
+    if (!parser.expect_identifier(&statement->name, err)) {
+      return false;
     }
-    return false;
-  }
-  if (err) {
-    err->clear();
-  }
-  *statement = Statement{};
-  std::vector<Token> tokens = tokenize(sql, err);
-  if (!err || err->empty()) {
-    if (tokens.empty()) {
+    if (!parser.expect_keyword("AS", err)) {
+      return false;
+    }
+    auto body = std::make_shared<Statement>();
+    Parser body_parser(parser.rest(), true);
+    if (!parse_statement(body_parser, body.get(), err)) {
+      return false;
+    }
+    if (body->type != StatementType::Insert && body->type != StatementType::Select &&
+        body->type != StatementType::Update && body->type != StatementType::Delete) {
       if (err) {
-        *err = "empty statement";
+        *err = "only INSERT, SELECT, UPDATE and DELETE can be prepared";
       }
       return false;
     }
-  } else {
-    return false;
+    body->params = body_parser.params();
+    statement->body = std::move(body);
+    return true;
+  }
+  if (parser.match_keyword("EXECUTE")) {
+    // EXECUTE name [(v, ...) | USING v, ...];
+    statement->type = StatementType::Execute;
+    if (!parser.expect_identifier(&statement->name, err)) {
+      return false;
+    }
+    bool parenthesized = parser.match_symbol('(');
+    if (!parenthesized && !parser.match_keyword("USING")) {
+      return true;
+    }
+    while (true) {
+      Value value;
+      if (!parser.parse_value(&value, err)) {
+        return false;
+      }
+      statement->args.push_back(std::move(value));
+      if (parser.match_symbol(',')) {
+        continue;
+      }
+      break;
+    }
+    return !parenthesized || parser.expect_symbol(')', err);
+  }
+  if (parser.match_keyword("DEALLOCATE")) {
+    // DEALLOCATE [PREPARE] name;
+    statement->type = StatementType::Deallocate;
+    parser.match_keyword("PREPARE");
+    return parser.expect_identifier(&statement->name, err);
+  }
+  if (parser.match_keyword("SHOW")) {
+    // SHOW STATS;
+    statement->type = StatementType::ShowStats;
+    return parser.expect_keyword("STATS", err);
+  }
+  if (parser.match_keyword("BEGIN")) {
+    // BEGIN [TRANSACTION | WORK];
+    statement->type = StatementType::Begin;
+    if (!parser.match_keyword("TRANSACTION")) {
+      parser.match_keyword("WORK");
+    }
+    return true;
+  }
+  if (parser.match_keyword("START")) {
+    // START TRANSACTION;
+    statement->type = StatementType::Begin;
+    return parser.expect_keyword("TRANSACTION", err);
+  }
+  if (parser.match_keyword("COMMIT")) {
+    // COMMIT [WORK];
+    statement->type = StatementType::Commit;
+    parser.match_keyword("WORK");
+    return true;
+  }
+  if (parser.match_keyword("ROLLBACK")) {
+    // ROLLBACK [WORK];
+    statement->type = StatementType::Rollback;
+    parser.match_keyword("WORK");
+    return true;
   }
-
-  Parser parser(std::move(tokens));
   if (parser.match_keyword("CREATE")) {
-    // CREATE TABLE t (col TYPE, ...);
+    bool unique = parser.match_keyword("UNIQUE");
+    if (unique || parser.match_keyword("INDEX")) {
+      // CREATE [UNIQUE] INDEX idx ON t (col) [USING HASH|BTREE];
+      statement->type = StatementType::CreateIndex;
+      if (unique && !parser.expect_keyword("INDEX", err)) {
+        return false;
+      }
+      IndexDef index;
+      index.unique = unique;
+      if (!parser.expect_identifier(&index.name, err)) {
+        return false;
+      }
+      index.name = to_lower(index.name);
+      if (!parser.expect_keyword("ON", err)) {
+        return false;
+      }
+      if (!parser.expect_identifier(&statement->table, err)) {
+        return false;
+      }
+      if (!parser.expect_symbol('(', err)) {
+        return false;
+      }
+      if (!parser.expect_identifier(&index.column, err)) {
+        return false;
+      }
+      if (!parser.expect_symbol(')', err)) {
+        return false;
+      }
+      if (parser.match_keyword("USING")) {
+        if (parser.match_keyword("BTREE")) {
+          index.kind = IndexKind::BTree;
+        } else if (!parser.expect_keyword("HASH", err)) {
+          return false;
+        }
+      }
+      statement->indexes.push_back(index);
+      return true;
+    }
+    // CREATE TABLE t (col TYPE [PRIMARY KEY], ...) [USING ROW|PAX];
     statement->type = StatementType::CreateTable;
     if (!parser.expect_keyword("TABLE", err)) {
       return false;
@@ -341,6 +555,19 @@ bool SqlParser::parse(const std::string& sql, Statement* statement, std::string*
       if (!parser.parse_column_type(&col, err)) {
         return false;
       }
+      if (parser.match_keyword("PRIMARY")) {
+        // 主键列自动建立名为 primary 的唯一哈希索引。
+        if (!parser.expect_keyword("KEY", err)) {
+          return false;
+        }
+        if (!statement->indexes.empty()) {
+          if (err) {
+            *err = "multiple primary keys";
+          }
+          return false;
+        }
+        statement->indexes.push_back({"primary", col.name, true});
+      }
       statement->columns.push_back(col);
       if (parser.match_symbol(',')) {
         continue;
@@ -350,9 +577,35 @@ bool SqlParser::parse(const std::string& sql, Statement* statement, std::string*
     if (!parser.expect_symbol(')', err)) {
       return false;
     }
+    if (parser.match_keyword("USING")) {
+      if (parser.match_keyword("PAX")) {
+        statement->table_options.layout = TableLayout::Pax;
+      } else if (parser.match_keyword("SLOTTED")) {
+        statement->table_options.layout = TableLayout::Slotted;
+      } else if (!parser.expect_keyword("ROW", err)) {
+        return false;
+      }
+    }
+    if (parser.match_keyword("COMPRESSED")) {
+      statement->table_options.compressed = true;
+    }
     return true;
   }
   if (parser.match_keyword("DROP")) {
+    if (parser.match_keyword("INDEX")) {
+      // DROP INDEX idx ON t;
+      statement->type = StatementType::DropIndex;
+      IndexDef index;
+      if (!parser.expect_identifier(&index.name, err)) {
+        return false;
+      }
+      index.name = to_lower(index.name);
+      statement->indexes.push_back(index);
+      if (!parser.expect_keyword("ON", err)) {
+        return false;
+      }
+      return parser.expect_identifier(&statement->table, err);
+    }
     // DROP TABLE t;
     statement->type = StatementType::DropTable;
     if (!parser.expect_keyword("TABLE", err)) {
@@ -382,7 +635,7 @@ bool SqlParser::parse(const std::string& sql, Statement* statement, std::string*
     return true;
   }
   if (parser.match_keyword("INSERT")) {
-    // INSERT INTO t VALUES (...);
+    // INSERT INTO t VALUES (...) [, (...)];
     statement->type = StatementType::Insert;
     if (!parser.expect_keyword("INTO", err)) {
       return false;
@@ -393,27 +646,43 @@ bool SqlParser::parse(const std::string& sql, Statement* statement, std::string*
     if (!parser.expect_keyword("VALUES", err)) {
       return false;
     }
-    if (!parser.expect_symbol('(', err)) {
-      return false;
-    }
-    while (true) {
-      Value value;
-      if (!parser.parse_value(&value, err)) {
+    do {
+      if (!parser.expect_symbol('(', err)) {
         return false;
       }
-      statement->values.push_back(std::move(value));
-      if (parser.match_symbol(',')) {
-        continue;
+      std::vector<Value> row;
+      while (true) {
+        Value value;
+        if (!parser.parse_value(&value, err)) {
+          return false;
+        }
+        parser.note_param(ParamTarget::InsertValue, statement->rows.size(), row.size());
+        row.push_back(std::move(value));
+        if (parser.match_symbol(',')) {
+          continue;
+        }
+        break;
       }
-      break;
+      if (!parser.expect_symbol(')', err)) {
+        return false;
+      }
+      statement->rows.push_back(std::move(row));
+    } while (parser.match_symbol(','));
+    return true;
+  }
+  if (parser.match_keyword("COPY")) {
+    // COPY t FROM 'file';
+    statement->type = StatementType::Copy;
+    if (!parser.expect_identifier(&statement->table, err)) {
+      return false;
     }
-    if (!parser.expect_symbol(')', err)) {
+    if (!parser.expect_keyword("FROM", err)) {
       return false;
     }
-    return true;
+    return parser.expect_string(&statement->path, err);
   }
   if (parser.match_keyword("SELECT")) {
-    // SELECT * FROM t [WHERE col = value];
+    // SELECT * FROM t [WHERE col op value | col BETWEEN a AND b] [LIMIT n];
     statement->type = StatementType::Select;
     if (!parser.expect_symbol('*', err)) {
       return false;
@@ -424,22 +693,28 @@ bool SqlParser::parse(const std::string& sql, Statement* statement, std::string*
     if (!parser.expect_identifier(&statement->table, err)) {
       return false;
     }
-    if (parser.match_keyword("WHERE")) {
-      statement->where.has = true;
-      if (!parser.expect_identifier(&statement->where.column, err)) {
-        return false;
-      }
-      if (!parser.expect_symbol('=', err)) {
+    if (parser.match_keyword("WHERE") && !parser.parse_condition(&statement->where, err)) {
+      return false;
+    }
+    if (parser.match_keyword("LIMIT")) {
+      std::string limit_token;
+      if (!parser.expect_number_text(&limit_token, err)) {
         return false;
       }
-      if (!parser.parse_value(&statement->where.value, err)) {
+      // 只接受不超过 19 位的非负整数，避免转换溢出。
+      if (!is_number(limit_token) || limit_token[0] == '-' || limit_token[0] == '+' ||
+          limit_token.size() > 19) {
+        if (err) {
+          *err = "invalid LIMIT";
+        }
         return false;
       }
+      statement->limit = std::stoull(limit_token);
     }
     return true;
   }
   if (parser.match_keyword("UPDATE")) {
-    // UPDATE t SET col=value [, ...] [WHERE col=value];
+    // UPDATE t SET col=value [, ...] [WHERE cond];
     statement->type = StatementType::Update;
     if (!parser.expect_identifier(&statement->table, err)) {
       return false;
@@ -458,28 +733,20 @@ bool SqlParser::parse(const std::string& sql, Statement* statement, std::string*
       if (!parser.parse_value(&set.value, err)) {
         return false;
       }
+      parser.note_param(ParamTarget::SetValue, 0, statement->set_clauses.size());
       statement->set_clauses.push_back(std::move(set));
       if (parser.match_symbol(',')) {
         continue;
       }
       break;
     }
-    if (parser.match_keyword("WHERE")) {
-      statement->where.has = true;
-      if (!parser.expect_identifier(&statement->where.column, err)) {
-        return false;
-      }
-      if (!parser.expect_symbol('=', err)) {
-        return false;
-      }
-      if (!parser.parse_value(&statement->where.value, err)) {
-        return false;
-      }
+    if (parser.match_keyword("WHERE") && !parser.parse_condition(&statement->where, err)) {
+      return false;
     }
     return true;
   }
   if (parser.match_keyword("DELETE")) {
-    // DELETE FROM t [WHERE col=value];
+    // DELETE FROM t [WHERE cond];
     statement->type = StatementType::Delete;
     if (!parser.expect_keyword("FROM", err)) {
       return false;
@@ -487,17 +754,8 @@ bool SqlParser::parse(const std::string& sql, Statement* statement, std::string*
     if (!parser.expect_identifier(&statement->table, err)) {
       return false;
     }
-    if (parser.match_keyword("WHERE")) {
-      statement->where.has = true;
-      if (!parser.expect_identifier(&statement->where.column, err)) {
-        return false;
-      }
-      if (!parser.expect_symbol('=', err)) {
-        return false;
-      }
-      if (!parser.parse_value(&statement->where.value, err)) {
-        return false;
-      }
+    if (parser.match_keyword("WHERE") && !parser.parse_condition(&statement->where, err)) {
+      return false;
     }
     return true;
   }
@@ -508,4 +766,72 @@ bool SqlParser::parse(const std::string& sql, Statement* statement, std::string*
   return false;
 }
 
+
+}  // namespace
+
+SqlParser::SqlParser(size_t cache_capacity) : cache_capacity_(cache_capacity) {}
+
+bool SqlParser::parse(const std::string& sql, Statement* statement, std::string* err) const {
+  // 顶层语法入口：先查解析缓存，未命中时词法分析后根据关键字分派不同语句。
+  if (!statement) {
+    if (err) {
+      *err = "statement output missing";
+    }
+    return false;
+  }
+  if (err) {
+    err->clear();
+  }
+  bool cacheable = cache_capacity_ > 0 && sql.size() <= kMaxCachedSqlBytes;
+  if (cacheable) {
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    auto it = cache_.find(sql);
+    if (it != cache_.end()) {
+      ++cache_hits_;
+      *statement = it->second;
+      return true;
+    }
+    ++cache_misses_;
+  }
+  *statement = Statement{};
+  std::vector<Token> tokens = tokenize(sql, err);
+  if (!err || err->empty()) {
+    if (tokens.empty()) {
+      if (err) {
+        *err = "empty statement";
+      }
+      return false;
+    }
+  } else {
+    return false;
+  }
+
+  Parser parser(std::move(tokens), false);
+  if (!parse_statement(parser, statement, err)) {
+    return false;
+  }
+  if (cacheable) {
+    // 按插入顺序淘汰最早的语句。
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    if (cache_.emplace(sql, *statement).second) {
+      cache_order_.push_back(sql);
+      if (cache_order_.size() > cache_capacity_) {
+        cache_.erase(cache_order_.front());
+        cache_order_.pop_front();
+      }
+    }
+  }
+  return true;
+}
+
+uint64_t SqlParser::cache_hits() const {
+  std::lock_guard<std::mutex> lock(cache_mutex_);
+  return cache_hits_;
+}
+
+uint64_t SqlParser::cache_misses() const {
+  std::lock_guard<std::mutex> lock(cache_mutex_);
+  return cache_misses_;
+}
+
 }  // namespace mini_db
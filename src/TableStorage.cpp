@@ -1,8 +1,10 @@
 #include "db/TableStorage.h"
 
+#include "db/NumaExecutor.h"
 #include "db/Utils.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cerrno>
 #include <cstdio>
 #include <cstring>
@@ -45,51 +47,234 @@ uint64_t read_uint64(const std::vector<char>& data, size_t offset) {
   return value;
 }
 
-// 按列类型比较两个 Value 是否相等。
-bool values_equal(const Value& a, const Value& b, ColumnType type) {
-  if (type == ColumnType::Int) {
-    return a.int_value == b.int_value;
+// 表结构版本：进程内全局递增，删表后同名重建的表也不会沿用旧表的版本。
+uint64_t next_schema_epoch() {
+  static std::atomic<uint64_t> epoch{0};
+  return epoch.fetch_add(1) + 1;
+}
+
+// 乐观读的记录缓冲：每线程复用一块，回调内嵌套读取时借用方拿到新的空缓冲。
+class RecordBuffer {
+ public:
+  RecordBuffer() { buffer_.swap(cached()); }
+  ~RecordBuffer() { buffer_.swap(cached()); }
+
+  std::vector<char>* get() { return &buffer_; }
+
+ private:
+  static std::vector<char>& cached() {
+    thread_local std::vector<char> buffer;
+    return buffer;
+  }
+
+  std::vector<char> buffer_;
+};
+
+// 判断记录视图是否满足 WHERE：等值比较直接对预编码的定长键 key 做逐字节比较，不解码列值。
+bool where_matches(const RecordView& view, const Condition& where, int where_idx,
+                   const Value& value, const Value& upper, const std::string& key) {
+  if (!where.has) {
+    return true;
   }
-  return a.text_value == b.text_value;
+  size_t col = static_cast<size_t>(where_idx);
+  if (where.op == CompareOp::Eq) {
+    return view.equals(col, key);
+  }
+  return view.matches(col, where.op, value, upper);
+}
+
+// 空闲页映射与索引文件缓存很小，不单独启动后台写页线程与预读线程（检查点时统一刷盘）。
+CacheOptions auxiliary_cache(const CacheOptions& cache) {
+  CacheOptions options = cache;
+  options.writer.enabled = false;
+  options.readahead.enabled = false;
+  // 页分布策略只作用于表数据文件。
+  options.placement = PlacementOptions{};
+  return options;
+}
+
+// 只读映射的表文件不经过页缓存读取，也不会产生脏页。
+CacheOptions mapped_cache(const CacheOptions& cache) {
+  CacheOptions options = cache;
+  options.writer.enabled = false;
+  return options;
+}
+
+// 压缩表的数据文件与溢出页文件按页压缩存放，页缓存中保存解压后的页。
+CacheOptions compressed_cache(const CacheOptions& cache, bool compressed) {
+  CacheOptions options = cache;
+  options.io.compress = compressed;
+  return options;
 }
 
 }  // namespace
 
-TableStorage::TableStorage(const std::string& path, const std::string& name, const Schema& schema,
-                           size_t page_size, size_t cache_pages, int numa_nodes, LogManager* log)
+void LockStats::add(const LockStats& other) {
+  table_shared.add(other.table_shared);
+  table_exclusive.add(other.table_exclusive);
+  page.add(other.page);
+}
+
+TableStorage::TableStorage(const std::string& path, const std::string& name, uint32_t table_id,
+                           const Schema& schema, size_t page_size, size_t cache_pages,
+                           int numa_nodes, const CacheOptions& cache, LogManager* log,
+                           const ReadOnlyOptions& read_only)
     : path_(path),
       name_(name),
+      table_id_(table_id),
       schema_(schema),
-      file_(path, page_size, cache_pages, numa_nodes),
+      schema_epoch_(next_schema_epoch()),
+      stored_schema_(schema.stored_schema()),
+      pax_(stored_schema_, page_size),
+      slotted_(stored_schema_, page_size),
+      // 压缩文件不能只读映射，只读打开时仍需要完整的页缓存。
+      file_(path, page_size, read_only.enabled && !schema.compressed() ? 1 : cache_pages,
+            numa_nodes,
+            compressed_cache(read_only.enabled ? mapped_cache(cache) : cache,
+                             schema.compressed())),
+      free_map_(path + ".fsm", page_size, kFreeMapCachePages, 1, auxiliary_cache(cache)),
       log_(log),
       page_size_(page_size),
       cache_pages_(cache_pages),
       numa_nodes_(numa_nodes),
-      page_mutexes_(kPageLockStripes) {}
+      cache_options_(cache),
+      read_only_(read_only),
+      page_mutexes_(kPageLockStripes) {
+  if (slotted()) {
+    overflow_ = std::make_unique<OverflowFile>(
+        path + ".ovf", page_size, kOverflowCachePages,
+        compressed_cache(auxiliary_cache(cache), schema.compressed()));
+  }
+  if (schema.stored_columns() < schema.columns().size()) {
+    added_ = std::make_unique<AddedColumns>(
+        path, schema, page_size, kAddedColumnCachePages,
+        compressed_cache(auxiliary_cache(cache), schema.compressed()), log);
+  }
+  if (log_) {
+    // WAL：数据页写出前，按页所属节点的日志分区把日志刷到页 LSN。
+    LogManager* log_manager = log_;
+    file_.set_wal([log_manager](int node) {
+      int partition = log_manager->partition_for_node(node);
+      WalGate gate;
+      gate.durable_lsn = [log_manager, partition]() { return log_manager->durable_lsn(partition); };
+      gate.flush_to = [log_manager, partition](uint64_t lsn, std::string* err) {
+        return log_manager->flush_to(partition, lsn, err);
+      };
+      return gate;
+    });
+  }
+}
+
+void TableStorage::set_scan_executor(NumaExecutor* executor, const ScanOptions& options) {
+  scan_executor_ = executor;
+  scan_options_ = options;
+}
+
+void TableStorage::set_buffer_manager(BufferManager* manager) {
+  file_.set_buffer_manager(manager);
+}
 
 bool TableStorage::load(std::string* err) {
-  // 检查记录大小是否超过页大小，避免无法存储。
-  if (schema_.record_size() > page_size_) { 
+  // 检查记录大小是否超过页大小，避免无法存储；槽页表只要求一页放得下一条最小形式的记录。
+  if (slotted() && slotted_.slots_per_page() == 0) {
+    if (err) {
+      *err = "record too large for slotted page";
+    }
+    return false;
+  }
+  if (!slotted() && stored_schema_.record_size() > page_size_) {
     if (err) {
       *err = "record size exceeds page size";
     }
     return false;
   }
+  if (read_only_.enabled) {
+    return load_read_only(err);
+  }
   if (file_.file_size() == 0) {
-    // 新建表文件时写入表头。
+    // 新建表文件时写入表头与空的空闲页映射。
     row_count_ = 0;
-    return write_header(err);
+    free_list_.clear();
+    for (auto& index : indexes_) {
+      if (!index->clear(err)) {
+        return false;
+      }
+    }
+    bool complete = true;
+    return save_free_list(err) && write_header(err) &&
+           (!overflow_ || overflow_->load(false, &complete, err));
+  }
+  if (!read_header(err)) {
+    return false;
+  }
+  if (overflow_) {
+    // 溢出文件的空闲页列表没有完整保存时（空闲页过多或异常退出），按数据页上的引用重新统计。
+    bool complete = true;
+    if (!overflow_->load(false, &complete, err)) {
+      return false;
+    }
+    if (!complete && !rebuild_overflow(err)) {
+      return false;
+    }
+  }
+  bool loaded = false;
+  if (!load_free_list(&loaded, err)) {
+    return false;
+  }
+  if (!loaded) {
+    // 旧版本表文件没有空闲页映射：扫描一次并持久化，之后的打开不再扫描。
+    if (!rebuild_free_list(err) || !write_header(err)) {
+      return false;
+    }
+  }
+  for (auto& index : indexes_) {
+    // 优先加载已保存的索引，缺失、损坏或未正常保存时扫描重建。
+    if (!index->load() && !build_index(index.get(), err)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool TableStorage::load_read_only(std::string* err) {
+  if (!file_.map_read_only(read_only_.numa_bind, err)) {
+    return false;
+  }
+  if (added_ && !added_->map_read_only(err)) {
+    return false;
+  }
+  bool complete = true;
+  if (overflow_ && !overflow_->load(true, &complete, err)) {
+    return false;
+  }
+  if (file_.file_size() == 0) {
+    // 表尚未写出任何页（建表后未做过检查点）：视为空表。
+    row_count_ = 0;
+    indexes_.clear();
+    return true;
   }
   if (!read_header(err)) {
     return false;
   }
-  return rebuild_free_list(err);
+  // 只读打开不重建索引（B+ 树重建要写文件），缺失或未正常保存的索引直接不用。
+  std::vector<std::unique_ptr<Index>> usable;
+  for (auto& index : indexes_) {
+    if (index->load()) {
+      usable.push_back(std::move(index));
+    }
+  }
+  indexes_.swap(usable);
+  return true;
 }
 
 const std::string& TableStorage::name() const {
   return name_;
 }
 
+uint32_t TableStorage::table_id() const {
+  return table_id_;
+}
+
 const Schema& TableStorage::schema() const {
   return schema_;
 }
@@ -98,36 +283,74 @@ uint64_t TableStorage::row_count() const {
   return row_count_;
 }
 
+void TableStorage::bind_schema(Schema* schema, uint64_t* schema_epoch) const {
+  auto table_lock = shared_table_lock();
+  *schema = schema_;
+  *schema_epoch = schema_epoch_;
+}
+
 bool TableStorage::insert(const std::vector<Value>& values, uint64_t* row_id, std::string* err) {
-  std::unique_lock<std::shared_mutex> table_lock(table_mutex_);
+  auto table_lock = exclusive_lock();
   // 插入时先做类型与长度校验。
   std::vector<Value> normalized = values;
   if (!schema_.validate_values(&normalized, err)) {
     return false;
   }
+  return insert_locked(&table_lock, normalized, row_id, err);
+}
+
+bool TableStorage::insert(const BoundDml& bound, uint64_t* row_id, bool* stale,
+                          std::string* err) {
+  auto table_lock = exclusive_lock();
+  if (!check_binding(bound, stale, err)) {
+    return false;
+  }
+  return insert_locked(&table_lock, bound.rows.front(), row_id, err);
+}
+
+bool TableStorage::insert_locked(std::unique_lock<std::shared_mutex>* table_lock,
+                                 const std::vector<Value>& values, uint64_t* row_id,
+                                 std::string* err) {
+  uint64_t lsn = 0;
+  int partition = 0;
+  std::vector<char> record = schema_.encode_record(values, true, err);
+  if (record.empty()) {
+    return false;
+  }
   uint64_t new_row_id = 0;
   bool reused = false;
-  if (!free_list_.empty()) {
-    // 复用已删除记录的空位。
-    new_row_id = free_list_.back();
-    free_list_.pop_back();
-    reused = true;
-  } else {
-    // 追加新行。
-    new_row_id = row_count_;
-    row_count_++;
+  uint64_t old_count = row_count_;
+  // 复用已删除记录的空位。
+  if (!take_free_row(&new_row_id, &reused, err)) {
+    return false;
   }
-  std::vector<char> record = schema_.encode_record(normalized, true, err);
-  if (record.empty()) {
+  if (!reused) {
+    // 追加新行。
+    std::vector<uint64_t> row_ids;
+    if (!next_row_ids(record.data(), 1, &row_ids, err)) {
+      return false;
+    }
+    new_row_id = row_ids[0];
+    row_count_ = new_row_id + 1;
+  }
+  if (!reserve_index_keys(nullptr, record, new_row_id, err)) {
+    // 唯一键冲突：归还刚取得的行号。
+    if (reused) {
+      push_free_row(new_row_id, nullptr);
+    } else {
+      row_count_ = old_count;
+    }
     return false;
   }
   if (log_) {
     // 先写日志再写数据，保证恢复时可重放。
-    if (!log_->append("INSERT", name_, new_row_id, record, err)) {
+    partition = log_partition_for_row(new_row_id);
+    if (!log_->append(partition, LogOp::Insert, table_id_, new_row_id, record, &lsn, err)) {
+      release_index_keys(&record, nullptr, new_row_id, nullptr);
       return false;
     }
   }
-  if (!write_record(new_row_id, record, err)) {
+  if (!write_record(new_row_id, record, lsn, err)) {
     return false;
   }
   if (!reused) {
@@ -139,13 +362,130 @@ bool TableStorage::insert(const std::vector<Value>& values, uint64_t* row_id, st
   if (row_id) {
     *row_id = new_row_id;
   }
-  return true;
+  // 释放锁后再等待日志落盘，组提交期间不阻塞同页/同表的其他线程。
+  table_lock->unlock();
+  return commit(partition, lsn, err);
+}
+
+bool TableStorage::bulk_insert(const std::vector<std::vector<Value>>& rows, uint64_t* first_row,
+                               std::string* err) {
+  auto table_lock = exclusive_lock();
+  return bulk_insert_locked(&table_lock, rows, false, first_row, err);
+}
+
+bool TableStorage::bulk_insert(const BoundDml& bound, uint64_t* first_row, bool* stale,
+                               std::string* err) {
+  auto table_lock = exclusive_lock();
+  if (!check_binding(bound, stale, err)) {
+    return false;
+  }
+  return bulk_insert_locked(&table_lock, bound.rows, true, first_row, err);
+}
+
+bool TableStorage::bulk_insert_locked(std::unique_lock<std::shared_mutex>* table_lock,
+                                      const std::vector<std::vector<Value>>& rows,
+                                      bool normalized, uint64_t* first_row, std::string* err) {
+  if (first_row) {
+    *first_row = row_count_;
+  }
+  if (rows.empty()) {
+    return true;
+  }
+  // 整批编码到一块连续缓冲：追加的行在文件中同样连续，页内容直接取自缓冲。
+  size_t record_size = schema_.record_size();
+  std::vector<char> data(rows.size() * record_size);
+  std::vector<char> record;
+  std::vector<Value> values;
+  for (size_t i = 0; i < rows.size(); ++i) {
+    // 绑定参数的行已按列类型归一化，直接编码。
+    const std::vector<Value>* row = &rows[i];
+    if (!normalized) {
+      values = rows[i];
+      if (!schema_.validate_values(&values, err)) {
+        return false;
+      }
+      row = &values;
+    }
+    record = schema_.encode_record(*row, true, err);
+    if (record.empty()) {
+      return false;
+    }
+    std::copy(record.begin(), record.end(), data.begin() + i * record_size);
+  }
+  std::vector<uint64_t> row_ids;
+  if (!next_row_ids(data.data(), rows.size(), &row_ids, err)) {
+    return false;
+  }
+  if (first_row) {
+    *first_row = row_ids[0];
+  }
+  uint64_t old_count = row_count_;
+  // 先占用全部新键：唯一约束冲突时释放已占用的键，整批不写入。
+  for (size_t i = 0; i < rows.size(); ++i) {
+    record.assign(data.begin() + i * record_size, data.begin() + (i + 1) * record_size);
+    if (!reserve_index_keys(nullptr, record, row_ids[i], err)) {
+      for (size_t j = 0; j < i; ++j) {
+        record.assign(data.begin() + j * record_size, data.begin() + (j + 1) * record_size);
+        release_index_keys(&record, nullptr, row_ids[j], nullptr);
+      }
+      return false;
+    }
+  }
+  std::vector<uint64_t> lsns(log_ ? static_cast<size_t>(log_->partition_count()) : 0, 0);
+  size_t begin = 0;
+  bool ok = true;
+  while (ok && begin < rows.size()) {
+    // 起始于同一页的连续行为一段：一条日志记录、一次按页写入。
+    size_t page_id = page_id_for_row(row_ids[begin]);
+    size_t end = begin + 1;
+    while (end < rows.size() && row_ids[end] == row_ids[end - 1] + 1 &&
+           page_id_for_row(row_ids[end]) == page_id) {
+      ++end;
+    }
+    const char* run = data.data() + begin * record_size;
+    size_t run_size = (end - begin) * record_size;
+    uint64_t lsn = 0;
+    if (log_) {
+      int partition = log_partition_for_row(row_ids[begin]);
+      std::vector<char> payload(4 + run_size);
+      write_uint32(&payload, 0, static_cast<uint32_t>(record_size));
+      std::copy(run, run + run_size, payload.begin() + 4);
+      ok = log_->append(partition, LogOp::SizedBulkInsert, table_id_, row_ids[begin], payload,
+                        &lsn, err);
+      if (ok) {
+        lsns[static_cast<size_t>(partition)] = lsn;
+      }
+    }
+    if (ok) {
+      ok = write_records(row_ids[begin], run, end - begin, lsn, false, err);
+    }
+    if (ok) {
+      begin = end;
+    }
+  }
+  // 出错时保留已写日志的段（重启后同样会按日志重放），其余行归还索引键。
+  for (size_t i = begin; i < rows.size(); ++i) {
+    record.assign(data.begin() + i * record_size, data.begin() + (i + 1) * record_size);
+    release_index_keys(&record, nullptr, row_ids[i], nullptr);
+  }
+  row_count_ = begin > 0 ? row_ids[begin - 1] + 1 : old_count;
+  if (begin > 0 && !write_header(ok ? err : nullptr)) {
+    return false;
+  }
+  table_lock->unlock();
+  return ok && commit_all(lsns, err);
 }
 
 bool TableStorage::select(const Condition& where, std::vector<std::vector<Value>>* rows,
                           std::string* err) {
-  std::unique_lock<std::shared_mutex> table_lock(table_mutex_);
-  // 全表扫描 + 单列等值过滤。
+  return select(where, nullptr, rows, err);
+}
+
+bool TableStorage::select(const Condition& where, const StagedRows* staged,
+                          std::vector<std::vector<Value>>* rows, std::string* err) {
+  // 共享锁只排除插入与 DDL；按行号的写入可以并发进行，读取按快照返回。
+  auto table_lock = shared_table_lock();
+  // 全表扫描或索引访问 + 单列比较过滤。
   if (!rows) {
     if (err) {
       *err = "rows output missing";
@@ -153,125 +493,304 @@ bool TableStorage::select(const Condition& where, std::vector<std::vector<Value>
     return false;
   }
   rows->clear();
+  VersionSnapshot snapshot(&versions_);
   int where_idx = -1;
   Value where_value;
-  if (where.has) {
-    // 预解析 WHERE 列索引与值类型。
-    where_idx = schema_.column_index(where.column);
-    if (where_idx < 0) {
-      if (err) {
-        *err = "unknown column in WHERE: " + where.column;
-      }
-      return false;
-    }
-    where_value = where.value;
-    if (!schema_.normalize_value(static_cast<size_t>(where_idx), &where_value, err)) {
-      return false;
-    }
+  Value where_upper;
+  std::string where_key;
+  if (!resolve_where(where, &where_idx, &where_value, &where_upper, &where_key, err)) {
+    return false;
   }
-  for (uint64_t row_id = 0; row_id < row_count_; ++row_id) {
-    // 逐行读取记录并解码。
-    std::vector<char> record;
-    if (!read_record(row_id, &record, err)) {
+  // WHERE 列有可用索引时只访问候选行，否则由批量过滤内核全表扫描得到选择向量。
+  std::vector<uint64_t> candidates;
+  bool indexed = false;
+  if (!index_candidates(where, where_idx, where_value, where_upper, &candidates, &indexed, err)) {
+    return false;
+  }
+  if (staged && staged->empty()) {
+    staged = nullptr;
+  }
+  if (!indexed && !staged) {
+    // 全表扫描在页帧上过滤并直接物化命中行（按行号有序）。
+    return scan_candidates(where, where_idx, where_value, where_upper, where_key, &snapshot,
+                           &candidates, rows, err);
+  }
+  if (!indexed) {
+    // 事务内的扫描：与暂存行按行号归并，暂存行以暂存记录代替已提交记录重新判断。
+    if (!scan_candidates(where, where_idx, where_value, where_upper, where_key, &snapshot,
+                         &candidates, rows, err)) {
       return false;
     }
-    bool valid = false;
-    std::vector<Value> values;
-    if (!schema_.decode_record(record, &values, &valid, err)) {
+    merge_staged(*staged, 0, row_count_, where, where_idx, where_value, where_upper, where_key,
+                 &candidates, rows);
+    return true;
+  }
+  add_snapshot_candidates(snapshot, &candidates);
+  std::vector<char> image;
+  // 有效标记与 WHERE 直接在页帧上的记录视图中判断，只有命中的行才物化为 Value。
+  RecordCursor cursor(&file_, &schema_, PageAccess::Normal);
+  RecordView view;
+  for (uint64_t row_id : candidates) {
+    if (!read_visible(row_id, staged, snapshot, &cursor, &image, &view, err)) {
       return false;
     }
-    if (!valid) {
+    if (!view.valid()) {
       continue;
     }
-    if (where.has) {
-      if (!values_equal(values[where_idx], where_value, schema_.columns()[where_idx].type)) {
-        continue;
-      }
+    if (!where_matches(view, where, where_idx, where_value, where_upper, where_key)) {
+      continue;
     }
-    rows->push_back(std::move(values));
+    rows->emplace_back();
+    view.decode(&rows->back());
   }
   return true;
 }
 
-bool TableStorage::update(const std::vector<SetClause>& sets, const Condition& where,
-                          size_t* updated, std::string* err) {
-  std::unique_lock<std::shared_mutex> table_lock(table_mutex_);
-  // 预解析 SET 列并转换类型。
-  if (sets.empty()) {
-    if (err) {
-      *err = "no columns to update";
-    }
+bool TableStorage::open_cursor(const Condition& where, const StagedRows* staged, uint64_t limit,
+                               std::unique_ptr<TableCursor>* cursor, std::string* err) {
+  std::unique_ptr<TableCursor> opened(new TableCursor(this));
+  opened->lock_ = shared_table_lock();
+  opened->where_ = where;
+  if (!resolve_where(where, &opened->where_idx_, &opened->where_value_, &opened->where_upper_,
+                     &opened->where_key_, err)) {
     return false;
   }
-  std::vector<std::pair<size_t, Value>> set_values;
-  set_values.reserve(sets.size());
-  for (const auto& set : sets) {
-    int idx = schema_.column_index(set.column);
-    if (idx < 0) {
-      if (err) {
-        *err = "unknown column in SET: " + set.column;
-      }
-      return false;
+  return start_cursor(std::move(opened), staged, limit, cursor, err);
+}
+
+bool TableStorage::open_cursor(const BoundDml& bound, const StagedRows* staged, uint64_t limit,
+                               std::unique_ptr<TableCursor>* cursor, bool* stale,
+                               std::string* err) {
+  std::unique_ptr<TableCursor> opened(new TableCursor(this));
+  opened->lock_ = shared_table_lock();
+  if (!check_binding(bound, stale, err)) {
+    return false;
+  }
+  opened->where_ = bound.where;
+  opened->where_idx_ = bound.where_idx;
+  opened->where_value_ = bound.where.value;
+  opened->where_upper_ = bound.where.upper;
+  opened->where_key_ = bound.where_key;
+  return start_cursor(std::move(opened), staged, limit, cursor, err);
+}
+
+bool TableStorage::start_cursor(std::unique_ptr<TableCursor> opened, const StagedRows* staged,
+                                uint64_t limit, std::unique_ptr<TableCursor>* cursor,
+                                std::string* err) {
+  // 游标持有共享锁与快照直到关闭，规划与 select 相同：有可用索引时先取候选行，否则按页推进扫描。
+  opened->snapshot_ = std::make_unique<VersionSnapshot>(&versions_);
+  opened->limit_ = limit;
+  if (!index_candidates(opened->where_, opened->where_idx_, opened->where_value_,
+                        opened->where_upper_, &opened->candidates_, &opened->indexed_, err)) {
+    return false;
+  }
+  opened->staged_ = staged && !staged->empty() ? staged : nullptr;
+  if (opened->indexed_) {
+    add_snapshot_candidates(*opened->snapshot_, &opened->candidates_);
+  } else {
+    opened->filter_ = make_filter(opened->where_, opened->where_idx_, opened->where_value_,
+                                  opened->where_upper_, opened->where_key_);
+    if (row_count_ > 0) {
+      opened->next_page_ = page_id_for_row(0);
+      opened->end_page_ = page_id_for_row(row_count_ - 1) + 1;
     }
-    Value normalized = set.value;
-    if (!schema_.normalize_value(static_cast<size_t>(idx), &normalized, err)) {
+  }
+  opened->done_ = limit == 0;
+  *cursor = std::move(opened);
+  return true;
+}
+
+TableCursor::TableCursor(TableStorage* table) : table_(table) {}
+
+TableCursor::~TableCursor() {
+  close();
+}
+
+bool TableCursor::next(size_t max_rows, std::vector<std::vector<Value>>* rows, std::string* err) {
+  rows->clear();
+  if (done_) {
+    return true;
+  }
+  size_t want = static_cast<size_t>(std::min<uint64_t>(std::max<size_t>(max_rows, 1),
+                                                       limit_ - returned_));
+  bool ok = indexed_ ? next_indexed(want, rows, err) : next_scan(want, rows, err);
+  returned_ += rows->size();
+  if (returned_ >= limit_) {
+    done_ = true;
+  }
+  // 读完（或出错）立即释放表锁与快照，不必等调用方 close。
+  if (!ok || done_) {
+    close();
+  }
+  return ok;
+}
+
+bool TableCursor::done() const {
+  return done_;
+}
+
+void TableCursor::close() {
+  done_ = true;
+  pending_values_.clear();
+  candidates_.clear();
+  snapshot_.reset();
+  if (lock_.owns_lock()) {
+    lock_.unlock();
+  }
+}
+
+bool TableCursor::next_indexed(size_t want, std::vector<std::vector<Value>>* rows,
+                               std::string* err) {
+  // 每批单独钉页，批与批之间不占用页帧。
+  RecordCursor cursor(&table_->file_, &table_->schema_, PageAccess::Normal);
+  std::vector<char> image;
+  RecordView view;
+  while (rows->size() < want && pos_ < candidates_.size()) {
+    uint64_t row_id = candidates_[pos_++];
+    if (!table_->read_visible(row_id, staged_, *snapshot_, &cursor, &image, &view, err)) {
       return false;
     }
-    set_values.emplace_back(static_cast<size_t>(idx), std::move(normalized));
+    if (view.valid() &&
+        where_matches(view, where_, where_idx_, where_value_, where_upper_, where_key_)) {
+      rows->emplace_back();
+      view.decode(&rows->back());
+    }
+  }
+  if (pos_ >= candidates_.size()) {
+    done_ = true;
   }
+  return true;
+}
 
-  int where_idx = -1;
-  Value where_value;
-  if (where.has) {
-    // 预解析 WHERE 条件。
-    where_idx = schema_.column_index(where.column);
-    if (where_idx < 0) {
-      if (err) {
-        *err = "unknown column in WHERE: " + where.column;
-      }
-      return false;
+bool TableCursor::next_scan(size_t want, std::vector<std::vector<Value>>* rows,
+                            std::string* err) {
+  // 每次过滤一个 morsel 的页，命中行先放在 pending_values_ 中按批取走。
+  size_t chunk = std::max<size_t>(1, table_->scan_options_.morsel_pages);
+  while (rows->size() < want) {
+    if (pending_pos_ < pending_values_.size()) {
+      rows->push_back(std::move(pending_values_[pending_pos_++]));
+      continue;
+    }
+    if (next_page_ >= end_page_) {
+      done_ = true;
+      break;
     }
-    where_value = where.value;
-    if (!schema_.normalize_value(static_cast<size_t>(where_idx), &where_value, err)) {
+    size_t hi = std::min(next_page_ + chunk, end_page_);
+    pending_rows_.clear();
+    pending_values_.clear();
+    pending_pos_ = 0;
+    if (!table_->scan_pages(filter_, next_page_, hi, -1, snapshot_.get(), &pending_rows_,
+                            &pending_values_, err)) {
       return false;
     }
+    if (staged_) {
+      uint64_t first_row = table_->first_row_in_page(next_page_);
+      uint64_t end_row = hi >= end_page_ ? table_->row_count_ : table_->first_row_in_page(hi);
+      table_->merge_staged(*staged_, first_row, end_row, where_, where_idx_, where_value_,
+                           where_upper_, where_key_, &pending_rows_, &pending_values_);
+    }
+    next_page_ = hi;
+  }
+  if (pending_pos_ >= pending_values_.size() && next_page_ >= end_page_) {
+    done_ = true;
   }
+  return true;
+}
 
-  size_t count = 0;
-  for (uint64_t row_id = 0; row_id < row_count_; ++row_id) {
-    // 遍历所有有效记录，匹配条件后更新。
-    std::vector<char> record;
-    if (!read_record(row_id, &record, err)) {
-      return false;
+bool TableStorage::update(const std::vector<SetClause>& sets, const Condition& where,
+                          size_t* updated, std::string* err) {
+  auto table_lock = exclusive_lock();
+  // 预解析 SET 列与 WHERE 条件并转换类型。
+  BoundDml bound;
+  if (!bind(sets, where, &bound, err)) {
+    return false;
+  }
+  return update_locked(&table_lock, bound, updated, err);
+}
+
+bool TableStorage::update(const BoundDml& bound, size_t* updated, bool* stale, std::string* err) {
+  auto table_lock = exclusive_lock();
+  if (!check_binding(bound, stale, err)) {
+    return false;
+  }
+  return update_locked(&table_lock, bound, updated, err);
+}
+
+bool TableStorage::update_locked(std::unique_lock<std::shared_mutex>* table_lock,
+                                 const BoundDml& bound, size_t* updated, std::string* err) {
+  if (bound.sets.empty()) {
+    if (err) {
+      *err = "no columns to update";
     }
-    bool valid = false;
-    std::vector<Value> values;
-    if (!schema_.decode_record(record, &values, &valid, err)) {
+    return false;
+  }
+  const std::vector<std::pair<size_t, Value>>& set_values = bound.sets;
+  const Condition& where = bound.where;
+  int where_idx = bound.where_idx;
+  const Value& where_value = bound.where.value;
+  const Value& where_upper = bound.where.upper;
+  const std::string& where_key = bound.where_key;
+  // 扫描写入可能跨多个日志分区，分别记录每个分区的最大 LSN。
+  std::vector<uint64_t> lsns(log_ ? static_cast<size_t>(log_->partition_count()) : 0, 0);
+  size_t count = 0;
+  // WHERE 列有可用索引时只访问候选行，否则由批量过滤内核全表扫描得到选择向量。
+  std::vector<uint64_t> candidates;
+  bool indexed = false;
+  if (!index_candidates(where, where_idx, where_value, where_upper, &candidates, &indexed, err)) {
+    return false;
+  }
+  if (!indexed &&
+      !scan_candidates(where, where_idx, where_value, where_upper, where_key, nullptr, &candidates,
+                       nullptr, err)) {
+    return false;
+  }
+  if (!check_candidates_unlocked(candidates, where, where_idx, where_value, where_upper, where_key,
+                                 err)) {
+    return false;
+  }
+  uint64_t scan_count = candidates.size();
+  RecordCursor cursor(&file_, &schema_, indexed ? PageAccess::Normal : PageAccess::Scan);
+  RecordView view;
+  std::vector<char> record;
+  std::vector<char> updated_record;
+  for (uint64_t i = 0; i < scan_count; ++i) {
+    uint64_t row_id = candidates[static_cast<size_t>(i)];
+    // 遍历所有有效记录，在视图上匹配条件，命中后才复制旧记录并更新。
+    if (!read_record_view(&cursor, row_id, &view, err)) {
       return false;
     }
-    if (!valid) {
+    if (!view.valid()) {
       continue;
     }
-    if (where.has) {
-      if (!values_equal(values[where_idx], where_value, schema_.columns()[where_idx].type)) {
-        continue;
-      }
+    if (!where_matches(view, where, where_idx, where_value, where_upper, where_key)) {
+      continue;
     }
+    record.assign(view.data(), view.data() + view.size());
+    // 写回同一页需要写闩，先放掉游标持有的共享闩。
+    cursor.release();
+    // 只重新编码被 SET 的列，其余字节沿用旧记录。
+    updated_record = record;
     for (const auto& pair : set_values) {
-      // 覆盖对应列的值。
-      values[pair.first] = pair.second;
+      schema_.encode_column(pair.first, pair.second, updated_record.data());
     }
-    std::vector<char> updated_record = schema_.encode_record(values, true, err);
-    if (updated_record.empty()) {
+    if (!reserve_index_keys(&record, updated_record, row_id, err)) {
       return false;
     }
+    uint64_t lsn = 0;
     if (log_) {
       // 记录更新后的整行，用于 redo。
-      if (!log_->append("UPDATE", name_, row_id, updated_record, err)) {
+      int partition = log_partition_for_row(row_id);
+      if (!log_->append(partition, LogOp::Update, table_id_, row_id, updated_record,
+                        &lsns[static_cast<size_t>(partition)], err)) {
+        release_index_keys(&updated_record, &record, row_id, nullptr);
         return false;
       }
+      lsn = lsns[static_cast<size_t>(partition)];
+    }
+    if (!write_record(row_id, updated_record, lsn, err)) {
+      return false;
     }
-    if (!write_record(row_id, updated_record, err)) {
+    if (!release_index_keys(&record, &updated_record, row_id, err)) {
       return false;
     }
     ++count;
@@ -279,105 +798,179 @@ bool TableStorage::update(const std::vector<SetClause>& sets, const Condition& w
   if (updated) {
     *updated = count;
   }
-  return true;
+  // 释放锁后再等待日志落盘，组提交期间不阻塞同页/同表的其他线程。
+  table_lock->unlock();
+  return commit_all(lsns, err);
 }
 
 bool TableStorage::remove(const Condition& where, size_t* removed, std::string* err) {
-  std::unique_lock<std::shared_mutex> table_lock(table_mutex_);
-  // 删除同样使用全表扫描。
-  int where_idx = -1;
-  Value where_value;
-  if (where.has) {
-    where_idx = schema_.column_index(where.column);
-    if (where_idx < 0) {
-      if (err) {
-        *err = "unknown column in WHERE: " + where.column;
-      }
-      return false;
-    }
-    where_value = where.value;
-    if (!schema_.normalize_value(static_cast<size_t>(where_idx), &where_value, err)) {
-      return false;
-    }
+  auto table_lock = exclusive_lock();
+  BoundDml bound;
+  if (!bind({}, where, &bound, err)) {
+    return false;
   }
+  return remove_locked(&table_lock, bound, removed, err);
+}
+
+bool TableStorage::remove(const BoundDml& bound, size_t* removed, bool* stale, std::string* err) {
+  auto table_lock = exclusive_lock();
+  if (!check_binding(bound, stale, err)) {
+    return false;
+  }
+  return remove_locked(&table_lock, bound, removed, err);
+}
 
+bool TableStorage::remove_locked(std::unique_lock<std::shared_mutex>* table_lock,
+                                 const BoundDml& bound, size_t* removed, std::string* err) {
+  const Condition& where = bound.where;
+  int where_idx = bound.where_idx;
+  const Value& where_value = bound.where.value;
+  const Value& where_upper = bound.where.upper;
+  const std::string& where_key = bound.where_key;
+  // 扫描写入可能跨多个日志分区，分别记录每个分区的最大 LSN。
+  std::vector<uint64_t> lsns(log_ ? static_cast<size_t>(log_->partition_count()) : 0, 0);
+  // 删除同样使用全表扫描。
   size_t count = 0;
-  for (uint64_t row_id = 0; row_id < row_count_; ++row_id) {
-    std::vector<char> record;
-    if (!read_record(row_id, &record, err)) {
-      return false;
-    }
-    bool valid = false;
-    std::vector<Value> values;
-    if (!schema_.decode_record(record, &values, &valid, err)) {
+  // WHERE 列有可用索引时只访问候选行，否则由批量过滤内核全表扫描得到选择向量。
+  std::vector<uint64_t> candidates;
+  bool indexed = false;
+  if (!index_candidates(where, where_idx, where_value, where_upper, &candidates, &indexed, err)) {
+    return false;
+  }
+  if (!indexed &&
+      !scan_candidates(where, where_idx, where_value, where_upper, where_key, nullptr, &candidates,
+                       nullptr, err)) {
+    return false;
+  }
+  if (!check_candidates_unlocked(candidates, where, where_idx, where_value, where_upper, where_key,
+                                 err)) {
+    return false;
+  }
+  uint64_t scan_count = candidates.size();
+  RecordCursor cursor(&file_, &schema_, indexed ? PageAccess::Normal : PageAccess::Scan);
+  RecordView view;
+  std::vector<char> record;
+  for (uint64_t i = 0; i < scan_count; ++i) {
+    uint64_t row_id = candidates[static_cast<size_t>(i)];
+    if (!read_record_view(&cursor, row_id, &view, err)) {
       return false;
     }
-    if (!valid) {
+    if (!view.valid()) {
       continue;
     }
-    if (where.has) {
-      if (!values_equal(values[where_idx], where_value, schema_.columns()[where_idx].type)) {
-        continue;
-      }
+    if (!where_matches(view, where, where_idx, where_value, where_upper, where_key)) {
+      continue;
     }
+    record.assign(view.data(), view.data() + view.size());
+    cursor.release();
     // 逻辑删除：将有效标记置 0。
     record[0] = 0;
+    uint64_t lsn = 0;
     if (log_) {
       // 记录删除后的行镜像（有效标记为 0）。
-      if (!log_->append("DELETE", name_, row_id, record, err)) {
+      int partition = log_partition_for_row(row_id);
+      if (!log_->append(partition, LogOp::Delete, table_id_, row_id, record,
+                        &lsns[static_cast<size_t>(partition)], err)) {
         return false;
       }
+      lsn = lsns[static_cast<size_t>(partition)];
     }
-    if (!write_record(row_id, record, err)) {
+    if (!write_record(row_id, record, lsn, err)) {
+      return false;
+    }
+    if (!erase_index_keys(record, row_id, err)) {
+      return false;
+    }
+    if (!push_free_row(row_id, err)) {
       return false;
     }
-    free_list_.push_back(row_id);
     ++count;
   }
   if (removed) {
     *removed = count;
   }
-  return true;
+  // 释放锁后再等待日志落盘，组提交期间不阻塞同页/同表的其他线程。
+  table_lock->unlock();
+  return commit_all(lsns, err);
 }
 
 bool TableStorage::read_row(uint64_t row_id, std::vector<Value>* values, bool* valid,
                             std::string* err) {
-  std::shared_lock<std::shared_mutex> table_lock(table_mutex_);
+  auto table_lock = shared_table_lock();
   if (row_id >= row_count_) {
     if (err) {
       *err = "row_id out of range";
     }
     return false;
   }
-  size_t page_id = page_id_for_row(row_id);
-  std::lock_guard<std::mutex> page_guard(page_lock(page_id));
-  std::vector<char> record;
-  if (!read_record(row_id, &record, err)) {
-    return false;
+  RecordBuffer buffer;
+  RecordView view;
+  if (read_record_optimistic(row_id, buffer.get())) {
+    view = RecordView(&schema_, buffer.get()->data());
+    if (values) {
+      view.decode(values);
+    }
+    if (valid) {
+      *valid = view.valid();
+    }
+    return true;
   }
-  bool local_valid = false;
-  std::vector<Value> local_values;
-  if (!schema_.decode_record(record, &local_values, &local_valid, err)) {
+  size_t page_id = page_id_for_row(row_id);
+  auto page_guard = lock_page(page_id);
+  RecordCursor cursor(&file_, &schema_, PageAccess::Normal);
+  if (!read_record_view(&cursor, row_id, &view, err)) {
     return false;
   }
   if (values) {
-    *values = std::move(local_values);
+    view.decode(values);
   }
   if (valid) {
-    *valid = local_valid;
+    *valid = view.valid();
+  }
+  return true;
+}
+
+bool TableStorage::read_row(uint64_t row_id, const std::function<void(const RecordView&)>& visit,
+                            std::string* err) {
+  auto table_lock = shared_table_lock();
+  if (row_id >= row_count_) {
+    if (err) {
+      *err = "row_id out of range";
+    }
+    return false;
+  }
+  RecordBuffer buffer;
+  if (read_record_optimistic(row_id, buffer.get())) {
+    visit(RecordView(&schema_, buffer.get()->data()));
+    return true;
+  }
+  size_t page_id = page_id_for_row(row_id);
+  auto page_guard = lock_page(page_id);
+  // 回调期间页保持钉住，视图不得带出回调。
+  RecordCursor cursor(&file_, &schema_, PageAccess::Normal);
+  RecordView view;
+  if (!read_record_view(&cursor, row_id, &view, err)) {
+    return false;
   }
+  visit(view);
   return true;
 }
 
 bool TableStorage::update_row(uint64_t row_id, const std::vector<SetClause>& sets,
                               std::string* err) {
-  std::shared_lock<std::shared_mutex> table_lock(table_mutex_);
+  auto table_lock = shared_table_lock();
+  VersionWrite version(&versions_);
+  uint64_t lsn = 0;
+  int partition = 0;
   if (row_id >= row_count_) {
     if (err) {
       *err = "row_id out of range";
     }
     return false;
   }
+  if (!check_unlocked(row_id, err)) {
+    return false;
+  }
   if (sets.empty()) {
     if (err) {
       *err = "no columns to update";
@@ -385,64 +978,199 @@ bool TableStorage::update_row(uint64_t row_id, const std::vector<SetClause>& set
     return false;
   }
   std::vector<std::pair<size_t, Value>> set_values;
-  set_values.reserve(sets.size());
-  for (const auto& set : sets) {
-    int idx = schema_.column_index(set.column);
-    if (idx < 0) {
+  if (!bind_sets(sets, &set_values, err)) {
+    return false;
+  }
+
+  size_t page_id = page_id_for_row(row_id);
+  auto page_guard = lock_page(page_id);
+  std::vector<char> record;
+  {
+    RecordCursor cursor(&file_, &schema_, PageAccess::Normal);
+    RecordView view;
+    if (!read_record_view(&cursor, row_id, &view, err)) {
+      return false;
+    }
+    if (!view.valid()) {
       if (err) {
-        *err = "unknown column in SET: " + set.column;
+        *err = "row is deleted";
       }
       return false;
     }
-    Value normalized = set.value;
-    if (!schema_.normalize_value(static_cast<size_t>(idx), &normalized, err)) {
+    // 旧记录用于索引维护，复制后随游标析构放掉共享闩，再写回同一页。
+    record.assign(view.data(), view.data() + view.size());
+  }
+  // 只重新编码被 SET 的列，其余字节沿用旧记录。
+  std::vector<char> updated_record = record;
+  for (const auto& pair : set_values) {
+    schema_.encode_column(pair.first, pair.second, updated_record.data());
+  }
+  if (!reserve_index_keys(&record, updated_record, row_id, err)) {
+    return false;
+  }
+  if (log_) {
+    partition = log_partition_for_row(row_id);
+    if (!log_->append(partition, LogOp::Update, table_id_, row_id, updated_record, &lsn, err)) {
+      release_index_keys(&updated_record, &record, row_id, nullptr);
       return false;
     }
-    set_values.emplace_back(static_cast<size_t>(idx), std::move(normalized));
   }
-
-  size_t page_id = page_id_for_row(row_id);
-  std::lock_guard<std::mutex> page_guard(page_lock(page_id));
-  std::vector<char> record;
-  if (!read_record(row_id, &record, err)) {
+  version.save(page_id, row_id, record);
+  if (!write_record(row_id, updated_record, lsn, err)) {
     return false;
   }
-  bool valid = false;
-  std::vector<Value> values;
-  if (!schema_.decode_record(record, &values, &valid, err)) {
+  if (!release_index_keys(&record, &updated_record, row_id, err)) {
     return false;
   }
-  if (!valid) {
+  version.finish();
+  // 释放锁后再等待日志落盘，组提交期间不阻塞同页/同表的其他线程。
+  page_guard.unlock();
+  table_lock.unlock();
+  return commit(partition, lsn, err);
+}
+
+bool TableStorage::read_rows(const std::vector<uint64_t>& row_ids,
+                             const std::function<void(size_t, const RecordView&)>& visit,
+                             std::string* err) {
+  auto table_lock = shared_table_lock();
+  for (uint64_t row_id : row_ids) {
+    if (row_id >= row_count_) {
+      if (err) {
+        *err = "row_id out of range";
+      }
+      return false;
+    }
+  }
+  // 按行号排序后逐行乐观读；失败时同一页锁分片上的连续行只加一次页锁，同一页只钉一次。
+  std::vector<size_t> order = batch_order(row_ids);
+  RecordBuffer buffer;
+  RecordCursor cursor(&file_, &schema_, PageAccess::Normal);
+  RecordView view;
+  size_t i = 0;
+  while (i < order.size()) {
+    if (read_record_optimistic(row_ids[order[i]], buffer.get())) {
+      visit(order[i], RecordView(&schema_, buffer.get()->data()));
+      ++i;
+      continue;
+    }
+    std::mutex& lock = page_lock(page_id_for_row(row_ids[order[i]]));
+    auto page_guard = timed_lock<std::unique_lock<std::mutex>>(lock, &page_waits_, "lock.page");
+    for (; i < order.size() && &page_lock(page_id_for_row(row_ids[order[i]])) == &lock; ++i) {
+      if (!read_record_view(&cursor, row_ids[order[i]], &view, err)) {
+        return false;
+      }
+      visit(order[i], view);
+    }
+    // 放页锁前先放页闩，保持“先页锁后页闩”的加锁顺序。
+    cursor.release();
+  }
+  return true;
+}
+
+bool TableStorage::update_rows(const std::vector<uint64_t>& row_ids,
+                               const std::vector<SetClause>& sets, size_t* updated,
+                               std::string* err) {
+  auto table_lock = shared_table_lock();
+  VersionWrite version(&versions_);
+  std::vector<uint64_t> lsns(log_ ? static_cast<size_t>(log_->partition_count()) : 0, 0);
+  for (uint64_t row_id : row_ids) {
+    if (row_id >= row_count_) {
+      if (err) {
+        *err = "row_id out of range";
+      }
+      return false;
+    }
+    // 事务加行锁需要表独占锁，持共享锁期间检查一次即可。
+    if (!check_unlocked(row_id, err)) {
+      return false;
+    }
+  }
+  if (sets.empty()) {
     if (err) {
-      *err = "row is deleted";
+      *err = "no columns to update";
     }
     return false;
   }
-  for (const auto& pair : set_values) {
-    values[pair.first] = pair.second;
-  }
-  std::vector<char> updated_record = schema_.encode_record(values, true, err);
-  if (updated_record.empty()) {
+  std::vector<std::pair<size_t, Value>> set_values;
+  if (!bind_sets(sets, &set_values, err)) {
     return false;
   }
-  if (log_) {
-    if (!log_->append("UPDATE", name_, row_id, updated_record, err)) {
-      return false;
+
+  std::vector<size_t> order = batch_order(row_ids);
+  RecordCursor cursor(&file_, &schema_, PageAccess::Normal);
+  RecordView view;
+  std::vector<char> record;
+  std::vector<char> updated_record;
+  size_t count = 0;
+  size_t i = 0;
+  while (i < order.size()) {
+    std::mutex& lock = page_lock(page_id_for_row(row_ids[order[i]]));
+    auto page_guard = timed_lock<std::unique_lock<std::mutex>>(lock, &page_waits_, "lock.page");
+    for (; i < order.size() && &page_lock(page_id_for_row(row_ids[order[i]])) == &lock; ++i) {
+      uint64_t row_id = row_ids[order[i]];
+      if (!read_record_view(&cursor, row_id, &view, err)) {
+        return false;
+      }
+      // 已删除的行跳过（不计入 updated）。
+      if (!view.valid()) {
+        continue;
+      }
+      record.assign(view.data(), view.data() + view.size());
+      // 写回同一页需要写闩，先放掉游标持有的共享闩。
+      cursor.release();
+      updated_record = record;
+      for (const auto& pair : set_values) {
+        schema_.encode_column(pair.first, pair.second, updated_record.data());
+      }
+      if (!reserve_index_keys(&record, updated_record, row_id, err)) {
+        return false;
+      }
+      uint64_t lsn = 0;
+      if (log_) {
+        int partition = log_partition_for_row(row_id);
+        if (!log_->append(partition, LogOp::Update, table_id_, row_id, updated_record,
+                          &lsns[static_cast<size_t>(partition)], err)) {
+          release_index_keys(&updated_record, &record, row_id, nullptr);
+          return false;
+        }
+        lsn = lsns[static_cast<size_t>(partition)];
+      }
+      version.save(page_id_for_row(row_id), row_id, record);
+      if (!write_record(row_id, updated_record, lsn, err)) {
+        return false;
+      }
+      if (!release_index_keys(&record, &updated_record, row_id, err)) {
+        return false;
+      }
+      ++count;
     }
+    cursor.release();
   }
-  return write_record(row_id, updated_record, err);
+  if (updated) {
+    *updated = count;
+  }
+  version.finish();
+  // 整批只等待一次日志落盘（每个涉及的分区等到本批最大的 LSN）。
+  table_lock.unlock();
+  return commit_all(lsns, err);
 }
 
 bool TableStorage::delete_row(uint64_t row_id, std::string* err) {
-  std::shared_lock<std::shared_mutex> table_lock(table_mutex_);
+  auto table_lock = shared_table_lock();
+  VersionWrite version(&versions_);
+  uint64_t lsn = 0;
+  int partition = 0;
   if (row_id >= row_count_) {
     if (err) {
       *err = "row_id out of range";
     }
     return false;
   }
+  if (!check_unlocked(row_id, err)) {
+    return false;
+  }
   size_t page_id = page_id_for_row(row_id);
-  std::lock_guard<std::mutex> page_guard(page_lock(page_id));
+  auto page_guard = lock_page(page_id);
   std::vector<char> record;
   if (!read_record(row_id, &record, err)) {
     return false;
@@ -454,175 +1182,1589 @@ bool TableStorage::delete_row(uint64_t row_id, std::string* err) {
   if (!valid) {
     return true;
   }
+  version.save(page_id, row_id, record);
   record[0] = 0;
   if (log_) {
-    if (!log_->append("DELETE", name_, row_id, record, err)) {
+    partition = log_partition_for_row(row_id);
+    if (!log_->append(partition, LogOp::Delete, table_id_, row_id, record, &lsn, err)) {
       return false;
     }
   }
-  if (!write_record(row_id, record, err)) {
+  if (!write_record(row_id, record, lsn, err)) {
+    return false;
+  }
+  if (!erase_index_keys(record, row_id, err)) {
     return false;
   }
   {
     std::lock_guard<std::mutex> meta_lock(meta_mutex_);
-    free_list_.push_back(row_id);
+    if (!push_free_row(row_id, err)) {
+      return false;
+    }
   }
-  return true;
+  version.finish();
+  // 释放锁后再等待日志落盘，组提交期间不阻塞同页/同表的其他线程。
+  page_guard.unlock();
+  table_lock.unlock();
+  return commit(partition, lsn, err);
 }
 
 bool TableStorage::write_row(uint64_t row_id, const std::vector<Value>& values, bool valid,
                              std::string* err) {
-  std::shared_lock<std::shared_mutex> table_lock(table_mutex_);
+  auto table_lock = shared_table_lock();
+  VersionWrite version(&versions_);
+  uint64_t lsn = 0;
+  int partition = 0;
   if (row_id >= row_count_) {
     if (err) {
       *err = "row_id out of range";
     }
     return false;
   }
+  if (!check_unlocked(row_id, err)) {
+    return false;
+  }
   std::vector<char> record = schema_.encode_record(values, valid, err);
   if (record.empty()) {
     return false;
   }
   size_t page_id = page_id_for_row(row_id);
-  std::lock_guard<std::mutex> page_guard(page_lock(page_id));
+  auto page_guard = lock_page(page_id);
+  std::vector<char> old_record;
+  if (!read_record(row_id, &old_record, err)) {
+    return false;
+  }
+  bool was_valid = old_record[0] != 0;
+  if (!reserve_index_keys(&old_record, record, row_id, err)) {
+    return false;
+  }
   if (log_) {
-    const char* op = valid ? "UPDATE" : "DELETE";
-    if (!log_->append(op, name_, row_id, record, err)) {
+    LogOp op = valid ? LogOp::Update : LogOp::Delete;
+    partition = log_partition_for_row(row_id);
+    if (!log_->append(partition, op, table_id_, row_id, record, &lsn, err)) {
+      release_index_keys(&record, &old_record, row_id, nullptr);
       return false;
     }
   }
-  return write_record(row_id, record, err);
-}
-
-size_t TableStorage::page_id_for_row(uint64_t row_id) const {
-  return record_offset(row_id) / page_size_;
-}
-
-bool TableStorage::apply_redo(uint64_t row_id, const std::vector<char>& record, std::string* err) {
-  std::unique_lock<std::shared_mutex> table_lock(table_mutex_);
-  // 恢复时直接覆盖指定行。
-  if (record.size() != schema_.record_size()) {
-    if (err) {
-      *err = "redo record size mismatch";
-    }
+  version.save(page_id, row_id, old_record);
+  if (!write_record(row_id, record, lsn, err)) {
     return false;
   }
-  if (row_id >= row_count_) {
-    // 日志中可能包含新增行，需扩展 row_count_。
-    row_count_ = row_id + 1;
-    if (!write_header(err)) {
+  if (!release_index_keys(&old_record, &record, row_id, err)) {
+    return false;
+  }
+  if (was_valid && !valid) {
+    // 有效行被置为删除时加入空闲列表；空位被重新写入有效值时，
+    // 旧条目由 take_free_row 惰性跳过。
+    std::lock_guard<std::mutex> meta_lock(meta_mutex_);
+    if (!push_free_row(row_id, err)) {
       return false;
     }
   }
-  return write_record(row_id, record, err);
+  version.finish();
+  // 释放锁后再等待日志落盘，组提交期间不阻塞同页/同表的其他线程。
+  page_guard.unlock();
+  table_lock.unlock();
+  return commit(partition, lsn, err);
 }
 
-bool TableStorage::rebuild_for_schema(const Schema& new_schema, std::string* err) {
-  std::unique_lock<std::shared_mutex> table_lock(table_mutex_);
-  // 通过创建临时表文件并迁移数据完成 schema 变更。
-  std::string temp_path = path_ + ".tmp";
-  TableStorage temp_table(temp_path, name_, new_schema, page_size_, cache_pages_, numa_nodes_,
-                          nullptr);
-  if (!temp_table.load(err)) {
+bool TableStorage::stage_insert(uint64_t txn, const std::vector<Value>& values,
+                                StagedRows* staged, uint64_t* row_id, std::string* err) {
+  auto table_lock = exclusive_lock();
+  std::vector<Value> normalized = values;
+  if (!schema_.validate_values(&normalized, err)) {
     return false;
   }
+  return stage_insert_locked(txn, normalized, staged, row_id, err);
+}
 
-  for (uint64_t row_id = 0; row_id < row_count_; ++row_id) {
-    // 逐行读取旧记录并映射到新 schema。
-    std::vector<char> record;
-    if (!read_record(row_id, &record, err)) {
-      return false;
-    }
-    bool valid = false;
-    std::vector<Value> values;
-    if (!schema_.decode_record(record, &values, &valid, err)) {
-      return false;
-    }
-    std::vector<Value> new_values;
-    new_values.reserve(new_schema.columns().size());
-    for (const auto& col : new_schema.columns()) {
-      int old_idx = schema_.column_index(col.name);
-      if (old_idx >= 0 && static_cast<size_t>(old_idx) < values.size()) {
-        new_values.push_back(values[static_cast<size_t>(old_idx)]);
-      } else {
-        // 新增列填充默认值。
-        if (col.type == ColumnType::Int) {
-          new_values.push_back(Value::Int(0));
-        } else {
-          new_values.push_back(Value::Text(""));
-        }
-      }
-    }
-    std::vector<char> new_record = new_schema.encode_record(new_values, valid, err);
-    if (new_record.empty()) {
+bool TableStorage::stage_insert(uint64_t txn, const BoundDml& bound, size_t row,
+                                StagedRows* staged, uint64_t* row_id, bool* stale,
+                                std::string* err) {
+  auto table_lock = exclusive_lock();
+  if (!check_binding(bound, stale, err)) {
+    return false;
+  }
+  return stage_insert_locked(txn, bound.rows[row], staged, row_id, err);
+}
+
+bool TableStorage::stage_insert_locked(uint64_t txn, const std::vector<Value>& values,
+                                       StagedRows* staged, uint64_t* row_id, std::string* err) {
+  std::vector<char> record = schema_.encode_record(values, true, err);
+  if (record.empty()) {
+    return false;
+  }
+  // 行号在暂存时分配：空位在提交前保持无效，其他会话的插入不会复用。
+  uint64_t new_row_id = 0;
+  bool reused = false;
+  uint64_t old_count = row_count_;
+  if (!take_free_row(&new_row_id, &reused, err)) {
+    return false;
+  }
+  if (!reused) {
+    std::vector<uint64_t> row_ids;
+    if (!next_row_ids(record.data(), 1, &row_ids, err)) {
       return false;
     }
-    if (!temp_table.write_record(row_id, new_record, err)) {
-      return false;
+    new_row_id = row_ids[0];
+    row_count_ = new_row_id + 1;
+  }
+  std::vector<char> empty(schema_.record_size(), 0);
+  if (!stage_row(txn, staged, new_row_id, empty, record, err)) {
+    if (reused) {
+      push_free_row(new_row_id, nullptr);
+    } else {
+      row_count_ = old_count;
     }
+    return false;
   }
-  temp_table.row_count_ = row_count_;
-  if (!temp_table.write_header(err)) {
+  (*staged)[new_row_id].inserted = true;
+  if (row_id) {
+    *row_id = new_row_id;
+  }
+  return true;
+}
+
+bool TableStorage::stage_update(uint64_t txn, const std::vector<SetClause>& sets,
+                                const Condition& where, StagedRows* staged, size_t* updated,
+                                std::string* err) {
+  auto table_lock = exclusive_lock();
+  BoundDml bound;
+  if (!bind(sets, where, &bound, err)) {
     return false;
   }
-  temp_table.flush(err);
-  if (err && !err->empty()) {
+  return stage_update_locked(txn, bound, staged, updated, err);
+}
+
+bool TableStorage::stage_update(uint64_t txn, const BoundDml& bound, StagedRows* staged,
+                                size_t* updated, bool* stale, std::string* err) {
+  auto table_lock = exclusive_lock();
+  if (!check_binding(bound, stale, err)) {
     return false;
   }
+  return stage_update_locked(txn, bound, staged, updated, err);
+}
 
-  // 用临时文件替换旧表文件（带简单备份回滚）。
-  std::string backup_path = path_ + ".bak";
-  std::remove(backup_path.c_str());
-  if (std::rename(path_.c_str(), backup_path.c_str()) != 0) {
+bool TableStorage::stage_update_locked(uint64_t txn, const BoundDml& bound, StagedRows* staged,
+                                       size_t* updated, std::string* err) {
+  if (bound.sets.empty()) {
     if (err) {
-      *err = "failed to backup table file";
+      *err = "no columns to update";
     }
     return false;
   }
-  if (std::rename(temp_path.c_str(), path_.c_str()) != 0) {
-    std::rename(backup_path.c_str(), path_.c_str());
-    if (err) {
-      *err = "failed to replace table file";
-    }
+  std::vector<std::pair<uint64_t, std::vector<char>>> targets;
+  if (!stage_targets(txn, bound, staged, &targets, err)) {
     return false;
   }
-  std::remove(backup_path.c_str());
-
-  schema_ = new_schema;
-  file_.reset(path_, page_size_, cache_pages_, numa_nodes_);
-  return rebuild_free_list(err);
-}
-
-bool TableStorage::rebuild_free_list(std::string* err) {
-  std::unique_lock<std::shared_mutex> table_lock(table_mutex_);
-  // 扫描所有记录，重建空闲列表。
-  free_list_.clear();
-  for (uint64_t row_id = 0; row_id < row_count_; ++row_id) {
-    std::vector<char> record;
-    if (!read_record(row_id, &record, err)) {
-      return false;
+  size_t count = 0;
+  for (const auto& target : targets) {
+    std::vector<char> updated_record = target.second;
+    for (const auto& pair : bound.sets) {
+      schema_.encode_column(pair.first, pair.second, updated_record.data());
     }
-    bool valid = false;
-    if (!schema_.decode_record(record, nullptr, &valid, err)) {
+    if (!stage_row(txn, staged, target.first, target.second, std::move(updated_record), err)) {
       return false;
     }
-    if (!valid) {
-      free_list_.push_back(row_id);
-    }
+    ++count;
+  }
+  if (updated) {
+    *updated = count;
   }
   return true;
 }
 
-void TableStorage::flush(std::string* err) {
-  // 刷新底层文件缓存。
-  file_.flush(err);
+bool TableStorage::stage_remove(uint64_t txn, const Condition& where, StagedRows* staged,
+                                size_t* removed, std::string* err) {
+  auto table_lock = exclusive_lock();
+  BoundDml bound;
+  if (!bind({}, where, &bound, err)) {
+    return false;
+  }
+  return stage_remove_locked(txn, bound, staged, removed, err);
+}
+
+bool TableStorage::stage_remove(uint64_t txn, const BoundDml& bound, StagedRows* staged,
+                                size_t* removed, bool* stale, std::string* err) {
+  auto table_lock = exclusive_lock();
+  if (!check_binding(bound, stale, err)) {
+    return false;
+  }
+  return stage_remove_locked(txn, bound, staged, removed, err);
+}
+
+bool TableStorage::stage_remove_locked(uint64_t txn, const BoundDml& bound, StagedRows* staged,
+                                       size_t* removed, std::string* err) {
+  std::vector<std::pair<uint64_t, std::vector<char>>> targets;
+  if (!stage_targets(txn, bound, staged, &targets, err)) {
+    return false;
+  }
+  for (auto& target : targets) {
+    std::vector<char> record = target.second;
+    record[0] = 0;
+    if (!stage_row(txn, staged, target.first, target.second, std::move(record), err)) {
+      return false;
+    }
+  }
+  if (removed) {
+    *removed = targets.size();
+  }
+  return true;
+}
+
+bool TableStorage::log_staged(uint64_t txn, StagedRows* staged, std::vector<uint64_t>* lsns,
+                              std::string* err) {
+  auto table_lock = shared_table_lock();
+  if (!log_) {
+    return true;
+  }
+  // 记录数据为 [u64 事务号][整行记录]，与普通 redo 记录一样写入行所在页的分区。
+  std::vector<char> data(8 + schema_.record_size(), 0);
+  write_uint64(&data, 0, txn);
+  for (auto& pair : *staged) {
+    std::copy(pair.second.image.begin(), pair.second.image.end(), data.begin() + 8);
+    int partition = log_partition_for_row(pair.first);
+    if (!log_->append(partition, LogOp::TxnRow, table_id_, pair.first, data, &pair.second.lsn,
+                      err)) {
+      return false;
+    }
+    (*lsns)[static_cast<size_t>(partition)] = pair.second.lsn;
+  }
+  return true;
+}
+
+bool TableStorage::apply_staged(uint64_t txn, StagedRows* staged, std::string* err) {
+  auto table_lock = shared_table_lock();
+  VersionWrite version(&versions_);
+  bool ok = true;
+  bool appended = false;
+  for (auto& pair : *staged) {
+    uint64_t row_id = pair.first;
+    StagedRow& row = pair.second;
+    if (ok) {
+      // 行锁保证页上仍是 base，旧版本直接用它保存。
+      size_t page_id = page_id_for_row(row_id);
+      auto page_guard = lock_page(page_id);
+      version.save(page_id, row_id, row.base);
+      ok = write_record(row_id, row.image, row.lsn, err);
+    }
+    if (ok) {
+      ok = release_index_keys(&row.base, &row.image, row_id, err);
+    }
+    if (ok && row.image[0] == 0 && (row.base[0] != 0 || row.inserted)) {
+      std::lock_guard<std::mutex> meta_lock(meta_mutex_);
+      ok = push_free_row(row_id, err);
+    }
+    appended = appended || row.inserted;
+    // 出错时同样释放剩余行锁：日志已落盘，重启后按日志恢复。
+    row_locks_.unlock(row_id, txn);
+  }
+  if (ok && appended) {
+    std::lock_guard<std::mutex> meta_lock(meta_mutex_);
+    ok = write_header(err);
+  }
+  return ok;
+}
+
+void TableStorage::discard_staged(uint64_t txn, StagedRows* staged) {
+  auto table_lock = exclusive_lock();
+  for (auto& pair : *staged) {
+    // 暂存占用的新键：暂存记录中不属于已提交记录的键。
+    release_index_keys(&pair.second.image, &pair.second.base, pair.first, nullptr);
+    if (pair.second.inserted) {
+      push_free_row(pair.first, nullptr);
+    }
+    row_locks_.unlock(pair.first, txn);
+  }
+  staged->clear();
+}
+
+bool TableStorage::has_row_locks() const {
+  return !row_locks_.empty();
+}
+
+bool TableStorage::stage_row(uint64_t txn, StagedRows* staged, uint64_t row_id,
+                             const std::vector<char>& current, std::vector<char> next,
+                             std::string* err) {
+  auto it = staged->find(row_id);
+  if (it == staged->end()) {
+    if (!row_locks_.lock(row_id, txn)) {
+      if (err) {
+        *err = "row " + std::to_string(row_id) + " is locked by another transaction";
+      }
+      return false;
+    }
+    if (!stage_index_keys(current, current, next, row_id, err)) {
+      row_locks_.unlock(row_id, txn);
+      return false;
+    }
+    StagedRow row;
+    row.base = current;
+    row.image = std::move(next);
+    staged->emplace(row_id, std::move(row));
+    return true;
+  }
+  if (!stage_index_keys(it->second.base, it->second.image, next, row_id, err)) {
+    return false;
+  }
+  it->second.image = std::move(next);
+  return true;
+}
+
+bool TableStorage::stage_targets(uint64_t txn, const BoundDml& bound, const StagedRows* staged,
+                                 std::vector<std::pair<uint64_t, std::vector<char>>>* targets,
+                                 std::string* err) {
+  targets->clear();
+  const Condition& where = bound.where;
+  int where_idx = bound.where_idx;
+  const Value& where_value = bound.where.value;
+  const Value& where_upper = bound.where.upper;
+  const std::string& where_key = bound.where_key;
+  std::vector<uint64_t> candidates;
+  bool indexed = false;
+  if (!index_candidates(where, where_idx, where_value, where_upper, &candidates, &indexed, err)) {
+    return false;
+  }
+  if (!indexed &&
+      !scan_candidates(where, where_idx, where_value, where_upper, where_key, nullptr, &candidates,
+                       nullptr, err)) {
+    return false;
+  }
+  // 扫描按已提交记录过滤：暂存行全部补入，按暂存记录重新判断。
+  for (const auto& pair : *staged) {
+    candidates.push_back(pair.first);
+  }
+  std::sort(candidates.begin(), candidates.end());
+  candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+  RecordCursor cursor(&file_, &schema_, indexed ? PageAccess::Normal : PageAccess::Scan);
+  RecordView view;
+  for (uint64_t row_id : candidates) {
+    auto own = staged->find(row_id);
+    if (own != staged->end()) {
+      view = RecordView(&schema_, own->second.image.data());
+    } else if (!read_record_view(&cursor, row_id, &view, err)) {
+      return false;
+    }
+    if (!view.valid() ||
+        !where_matches(view, where, where_idx, where_value, where_upper, where_key)) {
+      continue;
+    }
+    if (own == staged->end() && row_locks_.locked_by_other(row_id, txn)) {
+      if (err) {
+        *err = "row " + std::to_string(row_id) + " is locked by another transaction";
+      }
+      return false;
+    }
+    targets->emplace_back(row_id, std::vector<char>(view.data(), view.data() + view.size()));
+  }
+  return true;
+}
+
+bool TableStorage::check_unlocked(uint64_t row_id, std::string* err) const {
+  if (!row_locks_.locked_by_other(row_id, 0)) {
+    return true;
+  }
+  if (err) {
+    *err = "row " + std::to_string(row_id) + " is locked by another transaction";
+  }
+  return false;
+}
+
+bool TableStorage::check_candidates_unlocked(const std::vector<uint64_t>& candidates,
+                                             const Condition& where, int where_idx,
+                                             const Value& where_value, const Value& where_upper,
+                                             const std::string& where_key, std::string* err) {
+  if (row_locks_.empty()) {
+    return true;
+  }
+  RecordCursor cursor(&file_, &schema_, PageAccess::Normal);
+  RecordView view;
+  for (uint64_t row_id : candidates) {
+    if (!row_locks_.locked_by_other(row_id, 0)) {
+      continue;
+    }
+    if (!read_record_view(&cursor, row_id, &view, err)) {
+      return false;
+    }
+    if (view.valid() && where_matches(view, where, where_idx, where_value, where_upper, where_key)) {
+      return check_unlocked(row_id, err);
+    }
+  }
+  return true;
+}
+
+bool TableStorage::commit(int partition, uint64_t lsn, std::string* err) {
+  if (!log_ || lsn == 0) {
+    return true;
+  }
+  return log_->wait_durable(partition, lsn, err);
+}
+
+bool TableStorage::commit_all(const std::vector<uint64_t>& lsns, std::string* err) {
+  for (size_t i = 0; i < lsns.size(); ++i) {
+    if (!commit(static_cast<int>(i), lsns[i], err)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+size_t TableStorage::page_id_for_row(uint64_t row_id) const {
+  if (pax()) {
+    return pax_.page_for_row(row_id);
+  }
+  if (slotted()) {
+    return slotted_.page_for_row(row_id);
+  }
+  return record_offset(row_id) / page_size_;
+}
+
+int TableStorage::log_partition_for_row(uint64_t row_id) const {
+  if (!log_) {
+    return 0;
+  }
+  return log_->partition_for_node(file_.node_for_page(page_id_for_row(row_id)));
+}
+
+int TableStorage::node_for_row(uint64_t row_id) const {
+  auto table_lock = shared_table_lock();
+  return file_.frame_node_for_page(page_id_for_row(row_id));
+}
+
+bool TableStorage::apply_redo(uint64_t row_id, const std::vector<char>& record, std::string* err) {
+  // 恢复时直接覆盖指定行；行数在 finish_redo 中统一更新。
+  if (record.size() == schema_.record_size()) {
+    auto table_lock = shared_table_lock();
+    auto page_guard = lock_page(page_id_for_row(row_id));
+    return write_records(row_id, record.data(), 1, 0, true, err);
+  }
+  size_t count = 0;
+  return apply_redo_range(row_id, record.data(), record.size(), record.size(), &count, err);
+}
+
+bool TableStorage::apply_redo_range(uint64_t first_row, const char* records, size_t size,
+                                    size_t record_size, size_t* count, std::string* err) {
+  auto table_lock = shared_table_lock();
+  // ADD COLUMN 只修改元数据之后，之前写入的记录仍按旧结构编码：其长度是某个列前缀的记录长度，
+  // 且不短于数据文件中的记录。
+  bool prefix = false;
+  for (size_t col = stored_schema_.columns().size(); col <= schema_.columns().size(); ++col) {
+    prefix = prefix || schema_.column_offset(col) == record_size;
+  }
+  if (!prefix || size == 0 || size % record_size != 0) {
+    if (err) {
+      *err = "redo record size mismatch";
+    }
+    return false;
+  }
+  *count = size / record_size;
+  std::vector<char> padded;
+  if (record_size != schema_.record_size()) {
+    // 缺少的尾部列按默认值（全 0）补齐。
+    padded.assign(*count * schema_.record_size(), 0);
+    for (size_t i = 0; i < *count; ++i) {
+      std::copy(records + i * record_size, records + (i + 1) * record_size,
+                padded.begin() + static_cast<std::ptrdiff_t>(i * schema_.record_size()));
+    }
+    records = padded.data();
+  }
+  // 一条记录中的行起始于同一页，与 apply_redo 一样只锁起始页。
+  auto page_guard = lock_page(page_id_for_row(first_row));
+  return write_records(first_row, records, *count, 0, true, err);
+}
+
+bool TableStorage::finish_redo(const std::unordered_map<uint64_t, bool>& valid_by_row,
+                               std::string* err) {
+  auto table_lock = exclusive_lock();
+  uint64_t old_count = row_count_;
+  for (const auto& pair : valid_by_row) {
+    if (pair.first >= row_count_) {
+      // 日志中可能包含新增行，需扩展 row_count_。
+      row_count_ = pair.first + 1;
+    }
+  }
+  // 仅修正被重放行的空闲状态：其余行仍保持打开表时的状态。
+  std::vector<uint64_t> free_list;
+  free_list.reserve(free_list_.size());
+  for (uint64_t row_id : free_list_) {
+    if (valid_by_row.find(row_id) == valid_by_row.end()) {
+      free_list.push_back(row_id);
+    }
+  }
+  for (const auto& pair : valid_by_row) {
+    if (!pair.second) {
+      free_list.push_back(pair.first);
+    }
+  }
+  for (uint64_t row_id = old_count; row_id < row_count_ && !slotted(); ++row_id) {
+    // 新增范围内没有日志的行从未写入（全零），同样可复用；槽页表中这些是分配时跳过的空槽。
+    if (valid_by_row.find(row_id) == valid_by_row.end()) {
+      free_list.push_back(row_id);
+    }
+  }
+  free_list_ = std::move(free_list);
+  if (!save_free_list(err)) {
+    return false;
+  }
+  // 重放写入的溢出页都是新分配的，被覆盖的旧记录引用的页在此统一回收。
+  if (overflow_ && !rebuild_overflow(err)) {
+    return false;
+  }
+  if (!indexes_.empty()) {
+    // 索引快照可能落后于重放结果：丢弃被重放行的全部条目，再按最终镜像重新插入。
+    for (auto& index : indexes_) {
+      if (!index->erase_rows(valid_by_row, err)) {
+        return false;
+      }
+    }
+    for (const auto& pair : valid_by_row) {
+      if (!pair.second) {
+        continue;
+      }
+      std::vector<char> record;
+      if (!read_record(pair.first, &record, err)) {
+        return false;
+      }
+      for (auto& index : indexes_) {
+        if (!index->insert(index->key_of(record), pair.first, false, err)) {
+          return false;
+        }
+      }
+    }
+  }
+  if (row_count_ != old_count) {
+    return write_header(err);
+  }
+  return true;
+}
+
+bool TableStorage::rebuild_for_schema(const Schema& new_schema, std::string* err) {
+  auto table_lock = exclusive_lock();
+  // 暂存写入按当前结构编码，且新建索引看不到暂存行，有未提交事务时拒绝。
+  if (!row_locks_.empty()) {
+    if (err) {
+      *err = "table has uncommitted transaction writes: " + name_;
+    }
+    return false;
+  }
+  // 通过创建临时表文件并迁移数据完成 schema 变更。
+  std::string temp_path = path_ + ".tmp";
+  TableStorage temp_table(temp_path, name_, table_id_, new_schema, page_size_, cache_pages_,
+                          numa_nodes_, cache_options_, nullptr, ReadOnlyOptions{});
+  if (!temp_table.load(err)) {
+    return false;
+  }
+
+  for (uint64_t row_id = 0; row_id < row_count_; ++row_id) {
+    // 逐行读取旧记录并映射到新 schema。
+    std::vector<char> record;
+    bool present = true;
+    if (!row_present(row_id, &present, err)) {
+      return false;
+    }
+    if (!present) {
+      continue;
+    }
+    if (!read_record(row_id, &record, PageAccess::Scan, err)) {
+      return false;
+    }
+    bool valid = false;
+    std::vector<Value> values;
+    if (!schema_.decode_record(record, &values, &valid, err)) {
+      return false;
+    }
+    std::vector<Value> new_values;
+    new_values.reserve(new_schema.columns().size());
+    for (const auto& col : new_schema.columns()) {
+      int old_idx = schema_.column_index(col.name);
+      if (old_idx >= 0 && static_cast<size_t>(old_idx) < values.size()) {
+        new_values.push_back(values[static_cast<size_t>(old_idx)]);
+      } else {
+        // 新增列填充默认值。
+        if (col.type == ColumnType::Int) {
+          new_values.push_back(Value::Int(0));
+        } else {
+          new_values.push_back(Value::Text(""));
+        }
+      }
+    }
+    std::vector<char> new_record = new_schema.encode_record(new_values, valid, err);
+    if (new_record.empty()) {
+      return false;
+    }
+    if (!temp_table.write_record(row_id, new_record, err)) {
+      return false;
+    }
+    if (!valid) {
+      // 迁移时顺带收集空闲行，无需在替换后再扫描一遍。
+      temp_table.free_list_.push_back(row_id);
+    }
+  }
+  temp_table.row_count_ = row_count_;
+  if (!temp_table.save_free_list(err) || !temp_table.write_header(err)) {
+    return false;
+  }
+  temp_table.flush(err);
+  if (err && !err->empty()) {
+    return false;
+  }
+
+  // 用临时文件替换旧表文件（带简单备份回滚）。
+  std::string backup_path = path_ + ".bak";
+  std::remove(backup_path.c_str());
+  if (std::rename(path_.c_str(), backup_path.c_str()) != 0) {
+    if (err) {
+      *err = "failed to backup table file";
+    }
+    return false;
+  }
+  if (std::rename(temp_path.c_str(), path_.c_str()) != 0) {
+    std::rename(backup_path.c_str(), path_.c_str());
+    if (err) {
+      *err = "failed to replace table file";
+    }
+    return false;
+  }
+  std::remove(backup_path.c_str());
+  if (new_schema.compressed() &&
+      std::rename((temp_path + ".pmap").c_str(), (path_ + ".pmap").c_str()) != 0) {
+    if (err) {
+      *err = "failed to replace page map";
+    }
+    return false;
+  }
+  std::string free_map_path = path_ + ".fsm";
+  if (std::rename(temp_table.free_map_.path().c_str(), free_map_path.c_str()) != 0) {
+    if (err) {
+      *err = "failed to replace free space map";
+    }
+    return false;
+  }
+  std::string overflow_path = path_ + ".ovf";
+  if (temp_table.overflow_) {
+    if (std::rename(temp_table.overflow_->path().c_str(), overflow_path.c_str()) != 0) {
+      if (err) {
+        *err = "failed to replace overflow file";
+      }
+      return false;
+    }
+    if (new_schema.compressed() &&
+        std::rename((temp_table.overflow_->path() + ".pmap").c_str(),
+                    (overflow_path + ".pmap").c_str()) != 0) {
+      if (err) {
+        *err = "failed to replace overflow page map";
+      }
+      return false;
+    }
+  } else {
+    std::remove(overflow_path.c_str());
+  }
+
+  if (added_) {
+    // 追加列已并回数据文件。
+    std::vector<std::string> added_paths = added_->paths();
+    added_.reset();
+    for (const auto& added_path : added_paths) {
+      std::remove(added_path.c_str());
+    }
+  }
+  schema_ = new_schema;
+  schema_epoch_ = next_schema_epoch();
+  stored_schema_ = schema_.stored_schema();
+  pax_ = PaxLayout(stored_schema_, page_size_);
+  slotted_ = SlottedLayout(stored_schema_, page_size_);
+  // 表独占锁下没有快照，旧版本（按旧记录长度）已无用。
+  versions_.clear();
+  file_.reset(path_, page_size_, cache_pages_, numa_nodes_,
+              compressed_cache(cache_options_, compressed()));
+  free_map_.reset(free_map_path, page_size_, kFreeMapCachePages, 1, auxiliary_cache(cache_options_));
+  free_list_ = std::move(temp_table.free_list_);
+  overflow_.reset();
+  if (slotted()) {
+    overflow_ = std::make_unique<OverflowFile>(
+        overflow_path, page_size_, kOverflowCachePages,
+        compressed_cache(auxiliary_cache(cache_options_), compressed()));
+    bool complete = true;
+    if (!overflow_->load(false, &complete, err)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void TableStorage::add_column_locked(const Schema& new_schema) {
+  schema_ = new_schema;
+  schema_epoch_ = next_schema_epoch();
+  // 快照读取的旧版本按旧记录长度保存，表独占锁下没有快照，直接丢弃。
+  versions_.clear();
+  if (added_) {
+    added_->add(schema_);
+    return;
+  }
+  added_ = std::make_unique<AddedColumns>(
+      path_, schema_, page_size_, kAddedColumnCachePages,
+      compressed_cache(auxiliary_cache(cache_options_), compressed()), log_);
+}
+
+bool TableStorage::rebuild_free_list(std::string* err) {
+  auto table_lock = exclusive_lock();
+  return rebuild_free_list_locked(err);
+}
+
+bool TableStorage::rebuild_free_list_locked(std::string* err) {
+  // 扫描所有记录，重建空闲列表并整体写入空闲页映射。
+  free_list_.clear();
+  for (uint64_t row_id = 0; row_id < row_count_; ++row_id) {
+    bool present = true;
+    if (!row_present(row_id, &present, err)) {
+      return false;
+    }
+    if (!present) {
+      continue;
+    }
+    std::vector<char> record;
+    if (!read_record(row_id, &record, PageAccess::Scan, err)) {
+      return false;
+    }
+    bool valid = false;
+    if (!schema_.decode_record(record, nullptr, &valid, err)) {
+      return false;
+    }
+    if (!valid) {
+      free_list_.push_back(row_id);
+    }
+  }
+  return save_free_list(err);
+}
+
+void TableStorage::flush(std::string* err) {
+  // 刷新底层文件缓存、空闲页映射，并写出有修改的索引快照。
+  file_.flush(err);
+  if (err && !err->empty()) {
+    return;
+  }
+  free_map_.flush(err);
+  if (err && !err->empty()) {
+    return;
+  }
+  if (overflow_) {
+    overflow_->flush(err);
+    if (err && !err->empty()) {
+      return;
+    }
+  }
+  if (added_) {
+    added_->flush(err);
+    if (err && !err->empty()) {
+      return;
+    }
+  }
+  std::lock_guard<std::mutex> index_lock(index_mutex_);
+  for (auto& index : indexes_) {
+    if (index->dirty() && !index->save(err)) {
+      return;
+    }
+  }
 }
 
 std::vector<size_t> TableStorage::cached_pages_per_node() const {
-  std::shared_lock<std::shared_mutex> table_lock(table_mutex_);
+  auto table_lock = shared_table_lock();
   return file_.cached_pages_per_node();
 }
 
+uint64_t TableStorage::page_migrations() const {
+  auto table_lock = shared_table_lock();
+  return file_.page_migrations();
+}
+
+CacheStats TableStorage::cache_stats() const {
+  auto table_lock = shared_table_lock();
+  return file_.cache_stats();
+}
+
+std::vector<CacheStats> TableStorage::cache_stats_per_node() const {
+  auto table_lock = shared_table_lock();
+  return file_.cache_stats_per_node();
+}
+
+IoStats TableStorage::io_stats() const {
+  auto table_lock = shared_table_lock();
+  IoStats stats = file_.io_stats();
+  stats.add(free_map_.io_stats());
+  if (overflow_) {
+    stats.add(overflow_->io_stats());
+  }
+  if (added_) {
+    stats.add(added_->io_stats());
+  }
+  return stats;
+}
+
+std::vector<std::vector<size_t>> TableStorage::resident_pages() const {
+  auto table_lock = shared_table_lock();
+  return file_.resident_pages();
+}
+
+size_t TableStorage::warm(int node, const std::vector<size_t>& page_ids, bool* full) {
+  auto table_lock = shared_table_lock();
+  return file_.warm(node, page_ids, full);
+}
+
+std::unique_lock<std::shared_mutex> TableStorage::exclusive_lock() {
+  return timed_lock<std::unique_lock<std::shared_mutex>>(table_mutex_, &table_exclusive_waits_,
+                                                         "lock.table_exclusive");
+}
+
+std::shared_lock<std::shared_mutex> TableStorage::shared_table_lock() const {
+  return timed_lock<std::shared_lock<std::shared_mutex>>(table_mutex_, &table_shared_waits_,
+                                                         "lock.table_shared");
+}
+
+LockStats TableStorage::lock_stats() const {
+  LockStats stats;
+  stats.table_shared = table_shared_waits_.snapshot();
+  stats.table_exclusive = table_exclusive_waits_.snapshot();
+  stats.page = page_waits_.snapshot();
+  return stats;
+}
+
+bool TableStorage::set_indexes(const std::vector<IndexDef>& defs, std::string* err) {
+  std::lock_guard<std::mutex> index_lock(index_mutex_);
+  indexes_.clear();
+  for (const auto& def : defs) {
+    std::unique_ptr<Index> index;
+    if (!make_index(def, &index, err)) {
+      return false;
+    }
+    indexes_.push_back(std::move(index));
+  }
+  return true;
+}
+
+bool TableStorage::create_index(const IndexDef& def, std::string* err) {
+  auto table_lock = exclusive_lock();
+  // 暂存写入按当前结构编码，且新建索引看不到暂存行，有未提交事务时拒绝。
+  if (!row_locks_.empty()) {
+    if (err) {
+      *err = "table has uncommitted transaction writes: " + name_;
+    }
+    return false;
+  }
+  for (const auto& existing : indexes_) {
+    if (existing->def().name == def.name) {
+      if (err) {
+        *err = "index already exists: " + def.name;
+      }
+      return false;
+    }
+  }
+  std::unique_ptr<Index> index;
+  if (!make_index(def, &index, err)) {
+    return false;
+  }
+  // 扫描现有数据建立索引并立即保存，之后由写入路径增量维护。
+  if (!build_index(index.get(), err) || !index->save(err)) {
+    std::string path = index->path();
+    index.reset();
+    std::remove(path.c_str());
+    return false;
+  }
+  std::lock_guard<std::mutex> index_lock(index_mutex_);
+  indexes_.push_back(std::move(index));
+  return true;
+}
+
+bool TableStorage::drop_index(const std::string& name, std::string* err) {
+  auto table_lock = exclusive_lock();
+  std::lock_guard<std::mutex> index_lock(index_mutex_);
+  for (auto it = indexes_.begin(); it != indexes_.end(); ++it) {
+    if ((*it)->def().name == name) {
+      std::string path = (*it)->path();
+      indexes_.erase(it);
+      std::remove(path.c_str());
+      return true;
+    }
+  }
+  if (err) {
+    *err = "index not found: " + name;
+  }
+  return false;
+}
+
+std::vector<std::string> TableStorage::data_files() const {
+  std::vector<std::string> files = {path_, path_ + ".fsm"};
+  if (overflow_) {
+    files.push_back(overflow_->path());
+  }
+  if (compressed()) {
+    // 压缩文件的页映射。
+    files.push_back(path_ + ".pmap");
+    if (overflow_) {
+      files.push_back(overflow_->path() + ".pmap");
+    }
+  }
+  if (added_) {
+    std::vector<std::string> added_paths = added_->paths();
+    files.insert(files.end(), added_paths.begin(), added_paths.end());
+  }
+  std::lock_guard<std::mutex> index_lock(index_mutex_);
+  for (const auto& index : indexes_) {
+    files.push_back(index->path());
+  }
+  return files;
+}
+
+bool TableStorage::make_index(const IndexDef& def, std::unique_ptr<Index>* index,
+                              std::string* err) {
+  int col = schema_.column_index(def.column);
+  if (col < 0) {
+    if (err) {
+      *err = "unknown column in index: " + def.column;
+    }
+    return false;
+  }
+  size_t col_index = static_cast<size_t>(col);
+  size_t key_offset = schema_.column_offset(col_index);
+  size_t key_size = schema_.column_width(col_index);
+  if (def.kind == IndexKind::Hash) {
+    *index = std::make_unique<HashIndex>(def, index_path(def), col_index, key_offset, key_size);
+    return true;
+  }
+  if (!BTreeIndex::fits(key_size, page_size_)) {
+    if (err) {
+      *err = "index key too large for page size: " + def.column;
+    }
+    return false;
+  }
+  // B+ 树节点页与表使用相同的页大小与 NUMA 分片数。
+  *index = std::make_unique<BTreeIndex>(def, index_path(def), col_index, key_offset, key_size,
+                                        schema_.columns()[col_index].type, page_size_,
+                                        kBTreeCachePages, numa_nodes_,
+                                        auxiliary_cache(cache_options_));
+  return true;
+}
+
+bool TableStorage::build_index(Index* index, std::string* err) {
+  // 扫描全部有效行建立索引（唯一索引遇到重复键时失败）。
+  if (!index->clear(err)) {
+    return false;
+  }
+  for (uint64_t row_id = 0; row_id < row_count_; ++row_id) {
+    std::vector<char> record;
+    if (!read_record(row_id, &record, PageAccess::Scan, err)) {
+      return false;
+    }
+    if (record[0] == 0) {
+      continue;
+    }
+    if (!index->insert(index->key_of(record), row_id, true, err)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::string TableStorage::index_path(const IndexDef& def) const {
+  return path_ + "." + def.name + (def.kind == IndexKind::BTree ? ".bpt" : ".hidx");
+}
+
+bool TableStorage::index_candidates(const Condition& where, int col_index, const Value& value,
+                                    const Value& upper, std::vector<uint64_t>* rows, bool* used,
+                                    std::string* err) {
+  *used = false;
+  if (!where.has || col_index < 0 || where.op == CompareOp::Ne) {
+    return true;
+  }
+  // 等值条件优先使用哈希索引，其余比较只能使用有序的 B+ 树。
+  size_t col = static_cast<size_t>(col_index);
+  Index* chosen = nullptr;
+  for (const auto& index : indexes_) {
+    if (index->column_index() != col) {
+      continue;
+    }
+    if (where.op == CompareOp::Eq && !index->ordered()) {
+      chosen = index.get();
+      break;
+    }
+    if (index->ordered() && !chosen) {
+      chosen = index.get();
+    }
+  }
+  if (!chosen) {
+    return true;
+  }
+  *used = true;
+  std::string key = schema_.encode_key(col, value);
+  switch (where.op) {
+    case CompareOp::Eq:
+      return chosen->lookup(key, rows, err);
+    case CompareOp::Lt:
+      return chosen->range(nullptr, false, &key, false, rows, err);
+    case CompareOp::Le:
+      return chosen->range(nullptr, false, &key, true, rows, err);
+    case CompareOp::Gt:
+      return chosen->range(&key, false, nullptr, false, rows, err);
+    case CompareOp::Ge:
+      return chosen->range(&key, true, nullptr, false, rows, err);
+    case CompareOp::Between: {
+      std::string upper_key = schema_.encode_key(col, upper);
+      return chosen->range(&key, true, &upper_key, true, rows, err);
+    }
+    case CompareOp::Ne:
+      break;
+  }
+  *used = false;
+  return true;
+}
+
+bool TableStorage::resolve_where(const Condition& where, int* where_idx, Value* value,
+                                 Value* upper, std::string* key, std::string* err) const {
+  // 预解析 WHERE 列索引与值类型，等值条件预编码定长键。
+  *where_idx = -1;
+  if (!where.has) {
+    return true;
+  }
+  *where_idx = schema_.column_index(where.column);
+  if (*where_idx < 0) {
+    if (err) {
+      *err = "unknown column in WHERE: " + where.column;
+    }
+    return false;
+  }
+  size_t col = static_cast<size_t>(*where_idx);
+  *value = where.value;
+  if (!schema_.normalize_value(col, value, err)) {
+    return false;
+  }
+  *upper = where.upper;
+  if (where.op == CompareOp::Between && !schema_.normalize_value(col, upper, err)) {
+    return false;
+  }
+  if (where.op == CompareOp::Eq) {
+    *key = schema_.encode_key(col, *value);
+  }
+  return true;
+}
+
+bool TableStorage::bind_sets(const std::vector<SetClause>& sets,
+                             std::vector<std::pair<size_t, Value>>* set_values,
+                             std::string* err) const {
+  set_values->clear();
+  set_values->reserve(sets.size());
+  for (const auto& set : sets) {
+    int idx = schema_.column_index(set.column);
+    if (idx < 0) {
+      if (err) {
+        *err = "unknown column in SET: " + set.column;
+      }
+      return false;
+    }
+    Value normalized = set.value;
+    if (!schema_.normalize_value(static_cast<size_t>(idx), &normalized, err)) {
+      return false;
+    }
+    set_values->emplace_back(static_cast<size_t>(idx), std::move(normalized));
+  }
+  return true;
+}
+
+bool TableStorage::bind(const std::vector<SetClause>& sets, const Condition& where,
+                        BoundDml* bound, std::string* err) const {
+  if (!bind_sets(sets, &bound->sets, err)) {
+    return false;
+  }
+  bound->where = where;
+  return resolve_where(where, &bound->where_idx, &bound->where.value, &bound->where.upper,
+                       &bound->where_key, err);
+}
+
+bool TableStorage::check_binding(const BoundDml& bound, bool* stale, std::string* err) const {
+  if (stale) {
+    *stale = bound.schema_epoch != schema_epoch_;
+  }
+  if (bound.schema_epoch == schema_epoch_) {
+    return true;
+  }
+  if (err) {
+    *err = "table schema changed since prepare: " + name_;
+  }
+  return false;
+}
+
+void TableStorage::add_snapshot_candidates(const VersionSnapshot& snapshot,
+                                           std::vector<uint64_t>* candidates) const {
+  // 并发改写索引列时，行在新键占用后、旧键释放前同时挂在两个键下：候选去重（保留首次出现的顺序）。
+  std::vector<uint64_t> sorted = *candidates;
+  std::sort(sorted.begin(), sorted.end());
+  if (std::adjacent_find(sorted.begin(), sorted.end()) != sorted.end()) {
+    sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+    std::vector<bool> seen(sorted.size(), false);
+    size_t kept = 0;
+    for (uint64_t row_id : *candidates) {
+      size_t pos = static_cast<size_t>(std::lower_bound(sorted.begin(), sorted.end(), row_id) -
+                                       sorted.begin());
+      if (!seen[pos]) {
+        seen[pos] = true;
+        (*candidates)[kept++] = row_id;
+      }
+    }
+    candidates->resize(kept);
+  }
+  if (!versions_.empty()) {
+    // 索引按当前键查找：快照之后被改写过的行（旧键可能命中）补入候选，按快照版本重新判断。
+    // 在查索引之后取：查索引时已改写的行此时必然已保存旧版本。
+    for (uint64_t row_id : versions_.changed_rows(snapshot.ts())) {
+      if (row_id < row_count_ && !std::binary_search(sorted.begin(), sorted.end(), row_id)) {
+        candidates->push_back(row_id);
+      }
+    }
+  }
+}
+
+bool TableStorage::read_visible(uint64_t row_id, const StagedRows* staged,
+                                const VersionSnapshot& snapshot, RecordCursor* cursor,
+                                std::vector<char>* image, RecordView* view, std::string* err) {
+  // 暂存行的已提交键与暂存时占用的新键都在索引中，索引候选必然包含它们。
+  if (staged) {
+    auto own = staged->find(row_id);
+    if (own != staged->end()) {
+      *view = RecordView(&schema_, own->second.image.data());
+      return true;
+    }
+  }
+  if (!read_record_view(cursor, row_id, view, err)) {
+    return false;
+  }
+  // 先读当前记录再查旧版本：当前内容若含快照之后的写入，旧版本一定已经保存。
+  if (versions_.lookup(page_id_for_row(row_id), row_id, snapshot.ts(), image)) {
+    *view = RecordView(&schema_, image->data());
+  }
+  return true;
+}
+
+void TableStorage::merge_staged(const StagedRows& staged, uint64_t first_row, uint64_t end_row,
+                                const Condition& where, int where_idx, const Value& value,
+                                const Value& upper, const std::string& key,
+                                std::vector<uint64_t>* rows,
+                                std::vector<std::vector<Value>>* values) const {
+  std::vector<uint64_t> merged_rows;
+  std::vector<std::vector<Value>> merged_values;
+  merged_rows.reserve(rows->size());
+  merged_values.reserve(values->size());
+  size_t i = 0;
+  auto it = staged.lower_bound(first_row);
+  auto end = staged.lower_bound(end_row);
+  while (i < rows->size() || it != end) {
+    if (it == end || (i < rows->size() && (*rows)[i] < it->first)) {
+      merged_rows.push_back((*rows)[i]);
+      merged_values.push_back(std::move((*values)[i++]));
+      continue;
+    }
+    if (i < rows->size() && (*rows)[i] == it->first) {
+      ++i;
+    }
+    RecordView view(&schema_, it->second.image.data());
+    if (view.valid() && where_matches(view, where, where_idx, value, upper, key)) {
+      merged_rows.push_back(it->first);
+      merged_values.emplace_back();
+      view.decode(&merged_values.back());
+    }
+    ++it;
+  }
+  rows->swap(merged_rows);
+  values->swap(merged_values);
+}
+
+ScanFilter TableStorage::make_filter(const Condition& where, int col_index, const Value& value,
+                                     const Value& upper, const std::string& key) const {
+  ScanFilter filter;
+  if (where.has && col_index >= 0) {
+    const ColumnLayout& col = schema_.layout()[static_cast<size_t>(col_index)];
+    filter.has = true;
+    filter.type = col.type;
+    filter.offset = col.offset;
+    filter.width = col.width;
+    filter.op = where.op;
+    if (col.type == ColumnType::Int) {
+      filter.int_value = value.int_value;
+      filter.int_upper = upper.int_value;
+    } else {
+      filter.key = key.empty() ? schema_.encode_key(static_cast<size_t>(col_index), value) : key;
+      filter.text_value = value.text_value;
+      filter.text_upper = upper.text_value;
+    }
+  }
+  return filter;
+}
+
+bool TableStorage::scan_candidates(const Condition& where, int col_index, const Value& value,
+                                   const Value& upper, const std::string& key,
+                                   const VersionSnapshot* snapshot, std::vector<uint64_t>* rows,
+                                   std::vector<std::vector<Value>>* values, std::string* err) {
+  rows->clear();
+  if (values) {
+    values->clear();
+  }
+  ScanFilter filter = make_filter(where, col_index, value, upper, key);
+  if (row_count_ == 0) {
+    return true;
+  }
+  size_t first_page = page_id_for_row(0);
+  size_t end_page = page_id_for_row(row_count_ - 1) + 1;
+  size_t pages = end_page - first_page;
+  if (!scan_executor_ || !scan_options_.parallel || pages < scan_options_.min_parallel_pages) {
+    return scan_pages(filter, first_page, end_page, -1, snapshot, rows, values, err);
+  }
+
+  // 按页范围切分成 morsel，每个 morsel 在每个节点上各派发一个任务，只处理归属该节点的页，
+  // 工作线程因此只访问本节点的缓存帧；各任务写独立的结果缓冲，最后按行号归并。
+  struct MorselResult {
+    std::vector<uint64_t> rows;
+    std::vector<std::vector<Value>> values;
+    std::string err;
+  };
+  size_t morsel_pages = std::max<size_t>(1, scan_options_.morsel_pages);
+  size_t morsels = (pages + morsel_pages - 1) / morsel_pages;
+  size_t nodes = static_cast<size_t>(scan_executor_->node_count());
+  std::vector<MorselResult> results(morsels * nodes);
+  std::vector<std::future<bool>> futures;
+  futures.reserve(results.size());
+  for (size_t m = 0; m < morsels; ++m) {
+    size_t lo = first_page + m * morsel_pages;
+    size_t hi = std::min(lo + morsel_pages, end_page);
+    for (size_t node = 0; node < nodes; ++node) {
+      MorselResult* out = &results[m * nodes + node];
+      futures.push_back(scan_executor_->submit(
+          static_cast<int>(node), [this, &filter, lo, hi, node, snapshot, out, values]() {
+            return scan_pages(filter, lo, hi, static_cast<int>(node), snapshot, &out->rows,
+                              values ? &out->values : nullptr, &out->err);
+          }));
+    }
+  }
+  // 必须等待全部任务结束（任务引用着 filter 与结果缓冲）。
+  bool ok = true;
+  for (size_t i = 0; i < futures.size(); ++i) {
+    if (!futures[i].get() && ok) {
+      ok = false;
+      if (err) {
+        *err = results[i].err;
+      }
+    }
+  }
+  if (!ok) {
+    return false;
+  }
+  size_t total = 0;
+  for (const auto& result : results) {
+    total += result.rows.size();
+  }
+  rows->reserve(total);
+  if (values) {
+    values->reserve(total);
+  }
+  // 同一 morsel 内各节点的结果各自有序，按行号多路归并；morsel 之间本身有序。
+  std::vector<size_t> next(nodes);
+  for (size_t m = 0; m < morsels; ++m) {
+    MorselResult* group = &results[m * nodes];
+    std::fill(next.begin(), next.end(), 0);
+    for (;;) {
+      size_t best = nodes;
+      for (size_t node = 0; node < nodes; ++node) {
+        if (next[node] < group[node].rows.size() &&
+            (best == nodes || group[node].rows[next[node]] < group[best].rows[next[best]])) {
+          best = node;
+        }
+      }
+      if (best == nodes) {
+        break;
+      }
+      rows->push_back(group[best].rows[next[best]]);
+      if (values) {
+        values->push_back(std::move(group[best].values[next[best]]));
+      }
+      ++next[best];
+    }
+  }
+  return true;
+}
+
+bool TableStorage::scan_pages(const ScanFilter& filter, size_t first_page, size_t end_page,
+                              int node, const VersionSnapshot* snapshot,
+                              std::vector<uint64_t>* rows,
+                              std::vector<std::vector<Value>>* values, std::string* err) {
+  // 逐页处理：完整落在页内的一段记录直接在页帧（或只读映射）上批量过滤，跨页记录复制后单独过滤。
+  // 记录归属其起始偏移所在的页。
+  // PAX 表只读取有效标记与 WHERE 列的 minipage，命中行再从各 minipage 拼出整行。
+  // 槽页表把整页记录还原为定长记录后批量过滤。
+  // 有追加列的表在页上按记录前缀过滤（WHERE 落在追加列上时只筛有效行），命中行补齐追加列后
+  // 再求值并物化。
+  size_t record_size = stored_schema_.record_size();
+  bool added_filter = added_ && filter.has && filter.offset >= record_size;
+  ScanFilter page_filter = filter;
+  page_filter.has = filter.has && !added_filter;
+  std::vector<std::vector<Value>>* page_values = added_ ? nullptr : values;
+  size_t filter_minipage =
+      page_filter.has ? pax_.minipage_offset(pax_.field_at(page_filter.offset)) : 0;
+  PageGuard page;
+  std::vector<char> scratch;
+  std::vector<char> record;
+  RecordCursor cursor(&file_, &schema_, PageAccess::Scan);
+  std::vector<uint64_t> selected;
+  for (size_t page_id = first_page; page_id < end_page; ++page_id) {
+    if (node >= 0 && file_.node_for_page(page_id) != node) {
+      continue;
+    }
+    uint64_t row_id = first_row_in_page(page_id);
+    uint64_t end_row = std::min<uint64_t>(first_row_in_page(page_id + 1), row_count_);
+    size_t page_end = (page_id + 1) * page_size_;
+    size_t page_begin = rows->size();
+    if (pax() && row_id < end_row) {
+      const char* data = nullptr;
+      if (!file_.read_view(page_id * page_size_, page_size_, PageAccess::Scan, &page, &scratch,
+                           &data, err)) {
+        return false;
+      }
+      filter_columns(data, data + filter_minipage, static_cast<size_t>(end_row - row_id), row_id,
+                     page_filter, rows);
+      if (page_values) {
+        record.resize(record_size);
+        for (size_t i = page_begin; i < rows->size(); ++i) {
+          pax_.gather(data, static_cast<size_t>((*rows)[i] - row_id), record.data());
+          values->emplace_back();
+          RecordView(&schema_, record.data()).decode(&values->back());
+        }
+      }
+      row_id = end_row;
+    }
+    if (slotted() && row_id < end_row) {
+      const char* data = nullptr;
+      if (!file_.read_view(page_id * page_size_, page_size_, PageAccess::Scan, &page, &scratch,
+                           &data, err)) {
+        return false;
+      }
+      // 目录之后的槽位都为空，不必还原。
+      size_t count = std::min<size_t>(static_cast<size_t>(end_row - row_id),
+                                      slotted_.slot_count(data));
+      record.resize(count * record_size);
+      for (size_t slot = 0; slot < count; ++slot) {
+        if (!slotted_.unpack(data, slot, overflow_.get(), record.data() + slot * record_size,
+                             err)) {
+          return false;
+        }
+      }
+      filter_records(record.data(), record_size, count, row_id, page_filter, rows);
+      if (page_values) {
+        for (size_t i = page_begin; i < rows->size(); ++i) {
+          values->emplace_back();
+          RecordView(&schema_, record.data() + ((*rows)[i] - row_id) * record_size)
+              .decode(&values->back());
+        }
+      }
+      row_id = end_row;
+    }
+    while (row_id < end_row) {
+      size_t offset = record_offset(row_id);
+      uint64_t count = offset < page_end ? (page_end - offset) / record_size : 0;
+      if (count > end_row - row_id) {
+        count = end_row - row_id;
+      }
+      if (count == 0) {
+        count = 1;
+      }
+      const char* data = nullptr;
+      if (!file_.read_view(offset, static_cast<size_t>(count) * record_size, PageAccess::Scan,
+                           &page, &scratch, &data, err)) {
+        return false;
+      }
+      size_t selected = rows->size();
+      filter_records(data, record_size, static_cast<size_t>(count), row_id, page_filter, rows);
+      if (page_values) {
+        // 页仍被钉住，命中行直接从页帧物化。
+        for (size_t i = selected; i < rows->size(); ++i) {
+          values->emplace_back();
+          RecordView(&schema_, data + ((*rows)[i] - row_id) * record_size).decode(&values->back());
+        }
+      }
+      row_id += count;
+    }
+    if (added_ && page_begin < rows->size()) {
+      page.release();
+      size_t kept = page_begin;
+      for (size_t i = page_begin; i < rows->size(); ++i) {
+        RecordView view;
+        if (!read_record_view(&cursor, (*rows)[i], &view, err)) {
+          return false;
+        }
+        if (added_filter) {
+          selected.clear();
+          filter_records(view.data(), view.size(), 1, (*rows)[i], filter, &selected);
+          if (selected.empty()) {
+            continue;
+          }
+        }
+        (*rows)[kept++] = (*rows)[i];
+        if (values) {
+          values->emplace_back();
+          view.decode(&values->back());
+        }
+      }
+      rows->resize(kept);
+      cursor.release();
+    }
+    // 整页读完后再查旧版本（与单行快照读相同的先后顺序）。
+    if (snapshot && !versions_.empty()) {
+      apply_snapshot(filter, page_id, *snapshot, page_begin, rows, values);
+    }
+  }
+  return true;
+}
+
+void TableStorage::apply_snapshot(const ScanFilter& filter, size_t page_id,
+                                  const VersionSnapshot& snapshot, size_t begin,
+                                  std::vector<uint64_t>* rows,
+                                  std::vector<std::vector<Value>>* values) {
+  std::vector<std::pair<uint64_t, std::vector<char>>> images;
+  if (!versions_.collect(page_id, snapshot.ts(), &images)) {
+    return;
+  }
+  std::vector<uint64_t> current(rows->begin() + static_cast<std::ptrdiff_t>(begin), rows->end());
+  std::vector<std::vector<Value>> current_values;
+  if (values) {
+    current_values.assign(
+        std::make_move_iterator(values->begin() + static_cast<std::ptrdiff_t>(begin)),
+        std::make_move_iterator(values->end()));
+    values->resize(begin);
+  }
+  rows->resize(begin);
+  // 按行号归并：有旧版本的行以快照版本的求值结果为准，其余行沿用当前内容的结果。
+  size_t next = 0;
+  auto keep_current = [&](size_t i) {
+    rows->push_back(current[i]);
+    if (values) {
+      values->push_back(std::move(current_values[i]));
+    }
+  };
+  std::vector<uint64_t> selected;
+  for (const auto& image : images) {
+    for (; next < current.size() && current[next] <= image.first; ++next) {
+      if (current[next] < image.first) {
+        keep_current(next);
+      }
+    }
+    selected.clear();
+    filter_records(image.second.data(), image.second.size(), 1, image.first, filter, &selected);
+    if (!selected.empty()) {
+      rows->push_back(image.first);
+      if (values) {
+        values->emplace_back();
+        RecordView(&schema_, image.second.data()).decode(&values->back());
+      }
+    }
+  }
+  for (; next < current.size(); ++next) {
+    keep_current(next);
+  }
+}
+
+bool TableStorage::reserve_index_keys(const std::vector<char>* before,
+                                      const std::vector<char>& after, uint64_t row_id,
+                                      std::string* err) {
+  // 写日志之前先占用新键，唯一键冲突时回滚已占用的键并报错。
+  if (after[0] == 0) {
+    return true;
+  }
+  bool had_before = before && (*before)[0] != 0;
+  for (size_t i = 0; i < indexes_.size(); ++i) {
+    Index* index = indexes_[i].get();
+    std::string key = index->key_of(after);
+    if (had_before && index->key_of(*before) == key) {
+      continue;
+    }
+    if (!index->insert(key, row_id, true, err)) {
+      for (size_t j = 0; j < i; ++j) {
+        std::string added = indexes_[j]->key_of(after);
+        if (!had_before || indexes_[j]->key_of(*before) != added) {
+          indexes_[j]->erase(added, row_id, nullptr);
+        }
+      }
+      return false;
+    }
+  }
+  return true;
+}
+
+bool TableStorage::release_index_keys(const std::vector<char>* before,
+                                      const std::vector<char>* after, uint64_t row_id,
+                                      std::string* err) {
+  // 删除 before 中与 after 不同的旧键（after 为空或无效时删除全部旧键）。
+  if (!before || (*before)[0] == 0) {
+    return true;
+  }
+  bool has_after = after && (*after)[0] != 0;
+  for (auto& index : indexes_) {
+    std::string key = index->key_of(*before);
+    if (has_after && index->key_of(*after) == key) {
+      continue;
+    }
+    if (!index->erase(key, row_id, err)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool TableStorage::erase_index_keys(const std::vector<char>& record, uint64_t row_id,
+                                    std::string* err) {
+  // 删除记录对应的索引条目（不看有效标记，用于已置删除标记的记录）。
+  for (auto& index : indexes_) {
+    if (!index->erase(index->key_of(record), row_id, err)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool TableStorage::stage_index_keys(const std::vector<char>& base,
+                                    const std::vector<char>& prev,
+                                    const std::vector<char>& next, uint64_t row_id,
+                                    std::string* err) {
+  bool has_base = base[0] != 0;
+  bool has_prev = prev[0] != 0;
+  bool has_next = next[0] != 0;
+  if (has_next) {
+    for (size_t i = 0; i < indexes_.size(); ++i) {
+      Index* index = indexes_[i].get();
+      std::string key = index->key_of(next);
+      if ((has_prev && index->key_of(prev) == key) || (has_base && index->key_of(base) == key)) {
+        continue;
+      }
+      if (!index->insert(key, row_id, true, err)) {
+        for (size_t j = 0; j < i; ++j) {
+          std::string added = indexes_[j]->key_of(next);
+          if ((!has_prev || indexes_[j]->key_of(prev) != added) &&
+              (!has_base || indexes_[j]->key_of(base) != added)) {
+            indexes_[j]->erase(added, row_id, nullptr);
+          }
+        }
+        return false;
+      }
+    }
+  }
+  if (!has_prev) {
+    return true;
+  }
+  for (auto& index : indexes_) {
+    std::string key = index->key_of(prev);
+    if ((has_next && index->key_of(next) == key) || (has_base && index->key_of(base) == key)) {
+      continue;
+    }
+    if (!index->erase(key, row_id, err)) {
+      return false;
+    }
+  }
+  return true;
+}
+
 bool TableStorage::read_header(std::string* err) {
   // 表头位于文件第一个页的起始位置。
   DataItem item;
@@ -642,13 +2784,22 @@ bool TableStorage::read_header(std::string* err) {
     return false;
   }
   uint32_t record_size = read_uint32(item.data, 4);
-  if (record_size != schema_.record_size()) {
+  if (record_size != stored_schema_.record_size()) {
     if (err) {
       *err = "record size mismatch with schema";
     }
     return false;
   }
   row_count_ = read_uint64(item.data, 8);
+  header_flags_ = read_uint64(item.data, 16);
+  if (((header_flags_ & kHeaderFlagPax) != 0) != pax() ||
+      ((header_flags_ & kHeaderFlagSlotted) != 0) != slotted() ||
+      ((header_flags_ & kHeaderFlagCompressed) != 0) != compressed()) {
+    if (err) {
+      *err = "table layout mismatch with schema";
+    }
+    return false;
+  }
   return true;
 }
 
@@ -659,13 +2810,105 @@ bool TableStorage::write_header(std::string* err) {
   header[1] = 'B';
   header[2] = 'L';
   header[3] = '1';
-  write_uint32(&header, 4, static_cast<uint32_t>(schema_.record_size()));
+  write_uint32(&header, 4, static_cast<uint32_t>(stored_schema_.record_size()));
   write_uint64(&header, 8, row_count_);
-  write_uint64(&header, 16, 0);
+  write_uint64(&header, 16, kHeaderFlagFreeMap | (pax() ? kHeaderFlagPax : 0) |
+                                (slotted() ? kHeaderFlagSlotted : 0) |
+                                (compressed() ? kHeaderFlagCompressed : 0));
   return file_.write_item(0, header, err);
 }
 
+bool TableStorage::load_free_list(bool* loaded, std::string* err) {
+  // 空闲页映射布局：魔数(4) + 保留(4) + 条目数(8) + 行号数组(8 * 条目数)。
+  *loaded = false;
+  if ((header_flags_ & kHeaderFlagFreeMap) == 0 || free_map_.file_size() < kFreeMapHeaderSize) {
+    return true;
+  }
+  DataItem head;
+  if (!free_map_.read_item(0, kFreeMapHeaderSize, &head, err)) {
+    return false;
+  }
+  if (head.data[0] != 'F' || head.data[1] != 'S' || head.data[2] != 'M' || head.data[3] != '1') {
+    return true;
+  }
+  uint64_t count = read_uint64(head.data, 8);
+  if (free_map_.file_size() < kFreeMapHeaderSize + count * 8) {
+    return true;
+  }
+  DataItem entries;
+  if (!free_map_.read_item(kFreeMapHeaderSize, static_cast<size_t>(count) * 8, &entries, err)) {
+    return false;
+  }
+  free_list_.clear();
+  free_list_.reserve(static_cast<size_t>(count));
+  for (uint64_t i = 0; i < count; ++i) {
+    uint64_t row_id = read_uint64(entries.data, static_cast<size_t>(i) * 8);
+    if (row_id < row_count_) {
+      free_list_.push_back(row_id);
+    }
+  }
+  *loaded = true;
+  return true;
+}
+
+bool TableStorage::save_free_list(std::string* err) {
+  // 整体写出空闲列表（重建或恢复之后调用）。
+  std::vector<char> data(kFreeMapHeaderSize + free_list_.size() * 8, 0);
+  data[0] = 'F';
+  data[1] = 'S';
+  data[2] = 'M';
+  data[3] = '1';
+  write_uint64(&data, 8, free_list_.size());
+  for (size_t i = 0; i < free_list_.size(); ++i) {
+    write_uint64(&data, kFreeMapHeaderSize + i * 8, free_list_[i]);
+  }
+  return free_map_.write_item(0, data, err);
+}
+
+bool TableStorage::push_free_row(uint64_t row_id, std::string* err) {
+  // 空闲列表按栈使用：追加条目后更新条目数，只写两个小区间。
+  free_list_.push_back(row_id);
+  std::vector<char> entry(8, 0);
+  write_uint64(&entry, 0, row_id);
+  if (!free_map_.write_item(kFreeMapHeaderSize + (free_list_.size() - 1) * 8, entry, err)) {
+    return false;
+  }
+  return store_free_count(err);
+}
+
+bool TableStorage::take_free_row(uint64_t* row_id, bool* found, std::string* err) {
+  *found = false;
+  bool popped = false;
+  while (!free_list_.empty()) {
+    uint64_t candidate = free_list_.back();
+    free_list_.pop_back();
+    popped = true;
+    // write_row 可能已在空位上写入有效记录，这类过期条目直接丢弃。
+    std::vector<char> record;
+    if (!read_record(candidate, &record, err)) {
+      return false;
+    }
+    if (record[0] == 0) {
+      *row_id = candidate;
+      *found = true;
+      break;
+    }
+  }
+  return popped ? store_free_count(err) : true;
+}
+
+bool TableStorage::store_free_count(std::string* err) {
+  std::vector<char> count(8, 0);
+  write_uint64(&count, 0, free_list_.size());
+  return free_map_.write_item(8, count, err);
+}
+
 bool TableStorage::read_record(uint64_t row_id, std::vector<char>* record, std::string* err) {
+  return read_record(row_id, record, PageAccess::Normal, err);
+}
+
+bool TableStorage::read_record(uint64_t row_id, std::vector<char>* record, PageAccess access,
+                               std::string* err) {
   // 记录偏移 = 页大小（预留表头页）+ row_id * 记录大小。
   if (!record) {
     if (err) {
@@ -673,15 +2916,26 @@ bool TableStorage::read_record(uint64_t row_id, std::vector<char>* record, std::
     }
     return false;
   }
-  DataItem item;
-  if (!file_.read_item(record_offset(row_id), schema_.record_size(), &item, err)) {
-    return false;
+  // 直接从钉住的页复制到输出缓冲，不经过 DataItem 中转。
+  record->resize(schema_.record_size());
+  if (pax() || slotted() || added_) {
+    RecordCursor cursor(&file_, &schema_, access);
+    RecordView view;
+    if (!read_record_view(&cursor, row_id, &view, err)) {
+      return false;
+    }
+    std::copy(view.data(), view.data() + view.size(), record->begin());
+    return true;
   }
-  *record = std::move(item.data);
-  return true;
+  return file_.read_into(record_offset(row_id), record->size(), record->data(), access, err);
 }
 
 bool TableStorage::write_record(uint64_t row_id, const std::vector<char>& record, std::string* err) {
+  return write_record(row_id, record, 0, err);
+}
+
+bool TableStorage::write_record(uint64_t row_id, const std::vector<char>& record, uint64_t lsn,
+                                std::string* err) {
   // 直接覆盖对应行记录。
   if (record.size() != schema_.record_size()) {
     if (err) {
@@ -689,12 +2943,226 @@ bool TableStorage::write_record(uint64_t row_id, const std::vector<char>& record
     }
     return false;
   }
-  return file_.write_item(record_offset(row_id), record, err);
+  return write_records(row_id, record.data(), 1, lsn, false, err);
+}
+
+bool TableStorage::write_records(uint64_t first_row, const char* data, size_t count, uint64_t lsn,
+                                 bool redo, std::string* err) {
+  size_t record_size = schema_.record_size();
+  // 追加列写入各自的列文件，数据页只存放记录的前缀（PAX 与槽页布局本身只取前缀列）。
+  if (added_ && !added_->write(first_row, data, record_size, count, lsn != 0, err)) {
+    return false;
+  }
+  if (slotted()) {
+    // 槽页：同一页的行在一次写闩内压缩写入各自的槽位。
+    size_t i = 0;
+    while (i < count) {
+      uint64_t row_id = first_row + i;
+      PageGuard page = file_.pin_page(slotted_.page_for_row(row_id), PageGuard::Mode::Write,
+                                      PageAccess::Normal, err);
+      if (!page) {
+        return false;
+      }
+      size_t slot = slotted_.slot_for_row(row_id);
+      bool ok = true;
+      for (; ok && i < count && slot < slotted_.slots_per_page(); ++i, ++slot) {
+        ok = slotted_.store(page.mutable_data(), slot, data + i * record_size, overflow_.get(),
+                            redo, err);
+      }
+      // 出错前已写入的槽位同样要标脏。
+      page.mark_dirty(lsn);
+      if (!ok) {
+        return false;
+      }
+    }
+    return true;
+  }
+  if (!pax()) {
+    // 行式布局中连续的行在文件中同样连续，按偏移一次写入（跨页时逐页写）。
+    if (!added_) {
+      return file_.write_from(record_offset(first_row), data, count * record_size, lsn, err);
+    }
+    size_t stored_size = stored_schema_.record_size();
+    std::vector<char> stored(count * stored_size);
+    for (size_t i = 0; i < count; ++i) {
+      std::copy(data + i * record_size, data + i * record_size + stored_size,
+                stored.begin() + static_cast<std::ptrdiff_t>(i * stored_size));
+    }
+    return file_.write_from(record_offset(first_row), stored.data(), stored.size(), lsn, err);
+  }
+  // PAX：同一页的行在一次写闩内拆写到各 minipage。
+  size_t i = 0;
+  while (i < count) {
+    uint64_t row_id = first_row + i;
+    PageGuard page = file_.pin_page(pax_.page_for_row(row_id), PageGuard::Mode::Write,
+                                    PageAccess::Normal, err);
+    if (!page) {
+      return false;
+    }
+    size_t slot = pax_.slot_for_row(row_id);
+    for (; i < count && slot < pax_.rows_per_page(); ++i, ++slot) {
+      pax_.scatter(data + i * record_size, slot, page.mutable_data());
+    }
+    page.mark_dirty(lsn);
+  }
+  return true;
+}
+
+bool TableStorage::read_record_view(RecordCursor* cursor, uint64_t row_id, RecordView* view,
+                                    std::string* err) {
+  bool ok = false;
+  if (pax()) {
+    ok = cursor->read_pax(pax_, pax_.page_for_row(row_id), pax_.slot_for_row(row_id), view, err);
+  } else if (slotted()) {
+    ok = cursor->read_slotted(slotted_, overflow_.get(), slotted_.page_for_row(row_id),
+                              slotted_.slot_for_row(row_id), view, err);
+  } else {
+    ok = cursor->read(record_offset(row_id), stored_schema_.record_size(), view, err);
+  }
+  // 数据页中只有记录前缀，追加列从列文件补齐。
+  return ok && (!added_ || cursor->extend(added_.get(), row_id, view, err));
+}
+
+bool TableStorage::pax() const {
+  return schema_.table_layout() == TableLayout::Pax;
+}
+
+bool TableStorage::slotted() const {
+  return schema_.table_layout() == TableLayout::Slotted;
+}
+
+bool TableStorage::compressed() const {
+  return schema_.compressed();
+}
+
+bool TableStorage::next_row_ids(const char* data, size_t count, std::vector<uint64_t>* row_ids,
+                                std::string* err) {
+  row_ids->resize(count);
+  if (!slotted()) {
+    for (size_t i = 0; i < count; ++i) {
+      (*row_ids)[i] = row_count_ + i;
+    }
+    return true;
+  }
+  // 按页模拟放置：free 为当前页整理后的剩余字节，slots 为目录已覆盖的槽数。
+  // 末页上已分配但尚未写入的行（事务暂存的插入）不计入，提交时放不下会把本页长值移到溢出页。
+  size_t record_size = schema_.record_size();
+  uint64_t next = row_count_;
+  size_t current_page = 0;
+  size_t free = 0;
+  size_t slots = 0;
+  for (size_t i = 0; i < count; ++i) {
+    size_t space = slotted_.record_space(data + i * record_size);
+    for (;;) {
+      size_t page_id = slotted_.page_for_row(next);
+      size_t slot = slotted_.slot_for_row(next);
+      if (page_id != current_page) {
+        current_page = page_id;
+        free = slotted_.empty_space();
+        slots = 0;
+        if (slot > 0) {
+          // 末页已有记录：读取目录统计剩余空间。
+          PageGuard page = file_.pin_page(page_id, PageGuard::Mode::Read, PageAccess::Normal, err);
+          if (!page) {
+            return false;
+          }
+          free = slotted_.free_space(page.data());
+          slots = slotted_.slot_count(page.data());
+        }
+      }
+      size_t directory = slot + 1 > slots ? (slot + 1 - slots) * SlottedLayout::kSlotSize : 0;
+      if (directory + space <= free) {
+        free -= directory + space;
+        slots = std::max(slots, slot + 1);
+        (*row_ids)[i] = next++;
+        break;
+      }
+      // 当前页放不下：跳到下一页的第一个槽位（空页一定放得下 record_space 字节）。
+      next = slotted_.first_row_in_page(page_id + 1);
+    }
+  }
+  return true;
+}
+
+bool TableStorage::row_present(uint64_t row_id, bool* present, std::string* err) {
+  *present = true;
+  if (!slotted()) {
+    return true;
+  }
+  PageGuard page;
+  std::vector<char> scratch;
+  const char* data = nullptr;
+  if (!file_.read_view(slotted_.page_for_row(row_id) * page_size_, page_size_, PageAccess::Scan,
+                       &page, &scratch, &data, err)) {
+    return false;
+  }
+  *present = slotted_.present(data, slotted_.slot_for_row(row_id));
+  return true;
+}
+
+bool TableStorage::rebuild_overflow(std::string* err) {
+  std::vector<std::pair<uint32_t, uint32_t>> chains;
+  if (row_count_ > 0) {
+    size_t end_page = slotted_.page_for_row(row_count_ - 1) + 1;
+    PageGuard page;
+    std::vector<char> scratch;
+    for (size_t page_id = 1; page_id < end_page; ++page_id) {
+      const char* data = nullptr;
+      if (!file_.read_view(page_id * page_size_, page_size_, PageAccess::Scan, &page, &scratch,
+                           &data, err)) {
+        return false;
+      }
+      slotted_.collect_overflow(data, &chains);
+    }
+  }
+  return overflow_->rebuild(chains, err);
+}
+
+std::vector<size_t> TableStorage::batch_order(const std::vector<uint64_t>& row_ids) const {
+  std::vector<size_t> order(row_ids.size());
+  for (size_t i = 0; i < order.size(); ++i) {
+    order[i] = i;
+  }
+  std::stable_sort(order.begin(), order.end(),
+                   [&row_ids](size_t a, size_t b) { return row_ids[a] < row_ids[b]; });
+  return order;
+}
+
+uint64_t TableStorage::first_row_in_page(size_t page_id) const {
+  // 数据页从第 1 页开始，返回起始偏移落在该页内的第一条记录。
+  if (pax()) {
+    return pax_.first_row_in_page(page_id);
+  }
+  if (slotted()) {
+    return slotted_.first_row_in_page(page_id);
+  }
+  if (page_id <= 1) {
+    return 0;
+  }
+  size_t record_size = stored_schema_.record_size();
+  return ((page_id - 1) * page_size_ + record_size - 1) / record_size;
 }
 
 size_t TableStorage::record_offset(uint64_t row_id) const {
   // 第一页保留为表头页，数据从第二页开始。
-  return page_size_ + static_cast<size_t>(row_id) * schema_.record_size();
+  return page_size_ + static_cast<size_t>(row_id) * stored_schema_.record_size();
+}
+
+bool TableStorage::read_record_optimistic(uint64_t row_id, std::vector<char>* out) {
+  // 单页内的记录由页版本保证读到的是某次写入完成后的内容；跨页记录的两段可能来自不同的写入，
+  // 仍由页锁保证一致。
+  // PAX 记录分散在页内各 minipage，槽页记录需要解压，都没有连续字节可供校验复制；
+  // 有追加列时记录不在同一页中。
+  if (pax() || slotted() || added_) {
+    return false;
+  }
+  size_t record_size = schema_.record_size();
+  out->resize(record_size);
+  return file_.read_optimistic(record_offset(row_id), record_size, out->data());
+}
+
+std::unique_lock<std::mutex> TableStorage::lock_page(size_t page_id) {
+  return timed_lock<std::unique_lock<std::mutex>>(page_lock(page_id), &page_waits_, "lock.page");
 }
 
 std::mutex& TableStorage::page_lock(size_t page_id) {
@@ -0,0 +1,228 @@
+#include "db/Trace.h"
+
+#ifdef MINI_DB_TRACE
+
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace mini_db {
+
+std::atomic<bool> g_trace_enabled{false};
+
+namespace {
+
+// 保留缓冲的线程数上限，之后新出现的线程不再记录。
+constexpr size_t kTraceMaxThreads = 256;
+
+static_assert((kTraceRingEvents & (kTraceRingEvents - 1)) == 0, "ring size must be a power of two");
+
+struct TraceEvent {
+  const char* name;
+  uint64_t begin;
+  uint64_t end;
+};
+
+// 单个线程的环形缓冲：只有所属线程写入，导出方按 next 读取。
+// epoch 与全局记录轮次不同时，缓冲中是上一轮的事件，所属线程写入前先清空。
+struct TraceRing {
+  std::unique_ptr<TraceEvent[]> events{new TraceEvent[kTraceRingEvents]};
+  std::atomic<uint64_t> next{0};
+  std::atomic<uint64_t> epoch{0};
+  uint32_t tid = 0;
+  std::string name;
+};
+
+std::mutex g_rings_mutex;
+std::vector<std::shared_ptr<TraceRing>> g_rings;
+std::atomic<uint64_t> g_epoch{0};
+
+// 时钟校准点：开始与停止时各记一对（追踪时钟, 墙钟纳秒）。
+uint64_t g_start_ticks = 0;
+uint64_t g_start_ns = 0;
+uint64_t g_stop_ticks = 0;
+uint64_t g_stop_ns = 0;
+
+thread_local TraceRing* t_ring = nullptr;
+thread_local bool t_ring_failed = false;
+thread_local std::string t_thread_name;
+
+uint64_t wall_ns() {
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                   std::chrono::steady_clock::now().time_since_epoch())
+                                   .count());
+}
+
+TraceRing* thread_ring() {
+  if (t_ring || t_ring_failed) {
+    return t_ring;
+  }
+  std::lock_guard<std::mutex> lock(g_rings_mutex);
+  if (g_rings.size() >= kTraceMaxThreads) {
+    t_ring_failed = true;
+    return nullptr;
+  }
+  auto ring = std::make_shared<TraceRing>();
+  ring->tid = static_cast<uint32_t>(g_rings.size() + 1);
+  ring->epoch.store(g_epoch.load());
+  ring->name = t_thread_name.empty() ? "thread " + std::to_string(ring->tid) : t_thread_name;
+  g_rings.push_back(ring);
+  t_ring = ring.get();
+  return t_ring;
+}
+
+void append_escaped(std::string* out, const std::string& text) {
+  for (char ch : text) {
+    if (ch == '"' || ch == '\\') {
+      out->push_back('\\');
+      out->push_back(ch);
+    } else if (static_cast<unsigned char>(ch) < 0x20) {
+      out->push_back(' ');
+    } else {
+      out->push_back(ch);
+    }
+  }
+}
+
+}  // namespace
+
+bool trace_start(std::string* /*err*/) {
+  std::lock_guard<std::mutex> lock(g_rings_mutex);
+  g_epoch.fetch_add(1);
+  g_start_ns = wall_ns();
+  g_start_ticks = trace_clock();
+  g_stop_ticks = 0;
+  g_trace_enabled.store(true);
+  return true;
+}
+
+void trace_stop() {
+  g_trace_enabled.store(false);
+  std::lock_guard<std::mutex> lock(g_rings_mutex);
+  g_stop_ticks = trace_clock();
+  g_stop_ns = wall_ns();
+}
+
+void trace_record(const char* name, uint64_t begin, uint64_t end) {
+  TraceRing* ring = thread_ring();
+  if (!ring) {
+    return;
+  }
+  uint64_t epoch = g_epoch.load(std::memory_order_relaxed);
+  uint64_t next = ring->next.load(std::memory_order_relaxed);
+  if (ring->epoch.load(std::memory_order_relaxed) != epoch) {
+    ring->epoch.store(epoch, std::memory_order_relaxed);
+    next = 0;
+  }
+  ring->events[next & (kTraceRingEvents - 1)] = TraceEvent{name, begin, end};
+  ring->next.store(next + 1, std::memory_order_release);
+}
+
+void trace_set_thread_name(const std::string& name) {
+  t_thread_name = name;
+  if (t_ring) {
+    std::lock_guard<std::mutex> lock(g_rings_mutex);
+    t_ring->name = name;
+  }
+}
+
+bool trace_export_chrome(const std::string& path, std::string* err) {
+  std::lock_guard<std::mutex> lock(g_rings_mutex);
+  uint64_t end_ticks = g_stop_ticks;
+  uint64_t end_ns = g_stop_ns;
+  if (end_ticks == 0) {
+    end_ticks = trace_clock();
+    end_ns = wall_ns();
+  }
+  // 按记录期间的实测频率把时钟计数换算为微秒。
+  double ticks_per_us = 1000.0;
+  if (end_ns > g_start_ns && end_ticks > g_start_ticks) {
+    ticks_per_us = static_cast<double>(end_ticks - g_start_ticks) * 1000.0 /
+                   static_cast<double>(end_ns - g_start_ns);
+  }
+  auto to_us = [&](uint64_t ticks) {
+    return (static_cast<double>(ticks) - static_cast<double>(g_start_ticks)) / ticks_per_us;
+  };
+  std::ofstream file(path, std::ios::trunc);
+  if (!file.is_open()) {
+    if (err) {
+      *err = "failed to open trace file: " + path;
+    }
+    return false;
+  }
+  int pid = static_cast<int>(getpid());
+  uint64_t epoch = g_epoch.load();
+  std::string out = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+  bool first = true;
+  char number[64];
+  for (const auto& ring : g_rings) {
+    uint64_t next = ring->next.load(std::memory_order_acquire);
+    if (ring->epoch.load() != epoch || next == 0) {
+      continue;
+    }
+    out += first ? "" : ",\n";
+    first = false;
+    out += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" + std::to_string(pid) +
+           ",\"tid\":" + std::to_string(ring->tid) + ",\"args\":{\"name\":\"";
+    append_escaped(&out, ring->name);
+    out += "\"}}";
+    uint64_t count = next < kTraceRingEvents ? next : kTraceRingEvents;
+    for (uint64_t i = next - count; i < next; ++i) {
+      const TraceEvent& event = ring->events[i & (kTraceRingEvents - 1)];
+      out += ",\n{\"name\":\"";
+      append_escaped(&out, event.name);
+      std::snprintf(number, sizeof(number), "%.3f", to_us(event.begin));
+      out += "\",\"cat\":\"mini_db\",\"ph\":\"X\",\"ts\":";
+      out += number;
+      std::snprintf(number, sizeof(number), "%.3f",
+                    static_cast<double>(event.end - event.begin) / ticks_per_us);
+      out += ",\"dur\":";
+      out += number;
+      out += ",\"pid\":" + std::to_string(pid) + ",\"tid\":" + std::to_string(ring->tid) + "}";
+    }
+    if (out.size() > (1u << 20)) {
+      file << out;
+      out.clear();
+    }
+  }
+  out += "\n]}\n";
+  file << out;
+  if (!file) {
+    if (err) {
+      *err = "failed to write trace file: " + path;
+    }
+    return false;
+  }
+  return true;
+}
+
+}  // namespace mini_db
+
+#else
+
+namespace mini_db {
+
+bool trace_start(std::string* err) {
+  if (err) {
+    *err = "tracing is not compiled in (configure with -DMINI_DB_TRACE=ON)";
+  }
+  return false;
+}
+
+void trace_stop() {}
+
+bool trace_export_chrome(const std::string& /*path*/, std::string* err) {
+  if (err) {
+    *err = "tracing is not compiled in (configure with -DMINI_DB_TRACE=ON)";
+  }
+  return false;
+}
+
+}  // namespace mini_db
+
+#endif
@@ -0,0 +1,94 @@
+#include "db/Transaction.h"
+
+#include "db/TableStorage.h"
+
+namespace mini_db {
+
+bool RowLockTable::lock(uint64_t row_id, uint64_t txn) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto inserted = owners_.emplace(row_id, txn);
+  if (inserted.second) {
+    count_.fetch_add(1);
+    return true;
+  }
+  return inserted.first->second == txn;
+}
+
+void RowLockTable::unlock(uint64_t row_id, uint64_t txn) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = owners_.find(row_id);
+  if (it != owners_.end() && it->second == txn) {
+    owners_.erase(it);
+    count_.fetch_sub(1);
+  }
+}
+
+bool RowLockTable::locked_by_other(uint64_t row_id, uint64_t txn) const {
+  if (empty()) {
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = owners_.find(row_id);
+  return it != owners_.end() && it->second != txn;
+}
+
+bool RowLockTable::empty() const {
+  return count_.load(std::memory_order_acquire) == 0;
+}
+
+Transaction::Transaction(uint64_t id) : id_(id) {}
+
+Transaction::~Transaction() {
+  rollback();
+}
+
+uint64_t Transaction::id() const {
+  return id_;
+}
+
+StagedRows* Transaction::staged(TableStorage* table) {
+  for (auto& pair : tables_) {
+    if (pair.first == table) {
+      return &pair.second;
+    }
+  }
+  tables_.emplace_back(table, StagedRows{});
+  return &tables_.back().second;
+}
+
+const StagedRows* Transaction::find_staged(const TableStorage* table) const {
+  for (const auto& pair : tables_) {
+    if (pair.first == table) {
+      return &pair.second;
+    }
+  }
+  return nullptr;
+}
+
+std::vector<std::pair<TableStorage*, StagedRows>>& Transaction::tables() {
+  return tables_;
+}
+
+size_t Transaction::staged_rows() const {
+  size_t count = 0;
+  for (const auto& pair : tables_) {
+    count += pair.second.size();
+  }
+  return count;
+}
+
+void Transaction::rollback() {
+  for (auto& pair : tables_) {
+    // 没有暂存行的表不持有行锁，可能已被删除。
+    if (!pair.second.empty()) {
+      pair.first->discard_staged(id_, &pair.second);
+    }
+  }
+  tables_.clear();
+}
+
+void Transaction::clear() {
+  tables_.clear();
+}
+
+}  // namespace mini_db
@@ -0,0 +1,229 @@
+#include "db/VersionStore.h"
+
+#include <algorithm>
+
+namespace mini_db {
+
+uint64_t VersionStore::begin_write(bool* keep) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  uint64_t ts = ++last_ts_;
+  writers_.insert(ts);
+  // 还有进行中的保存旧版本的写语句时同样保存：之后的快照时间戳不晚于那条语句之前，
+  // 本语句的时间戳在快照之后，即使先于它结束，也必须能按旧版本对快照隐藏。
+  *keep = !snapshots_.empty() || pending_snapshots_ > 0 || keep_writers_ > 0;
+  if (*keep) {
+    ++keep_writers_;
+  } else {
+    ++plain_writers_;
+  }
+  return ts;
+}
+
+void VersionStore::end_write(uint64_t ts, bool keep) {
+  uint64_t horizon = 0;
+  bool collect = false;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    writers_.erase(ts);
+    if (keep) {
+      --keep_writers_;
+    } else if (--plain_writers_ == 0 && pending_snapshots_ > 0) {
+      drained_.notify_all();
+    }
+    // 快照都已结束时，本语句保存的旧版本只可能被之后的快照需要，而之后的快照都不早于 horizon。
+    collect = keep && snapshots_.empty() && versions_.load() > 0;
+    horizon = visible_locked();
+  }
+  if (collect) {
+    prune(horizon);
+  }
+}
+
+void VersionStore::save(size_t page_id, uint64_t row_id, uint64_t ts,
+                        const std::vector<char>& record) {
+  Stripe& stripe = stripe_for(page_id);
+  std::lock_guard<std::mutex> lock(stripe.mutex);
+  Version version;
+  version.row_id = row_id;
+  version.ts = ts;
+  version.record = record;
+  stripe.pages[page_id].push_back(std::move(version));
+  versions_.fetch_add(1);
+}
+
+uint64_t VersionStore::begin_snapshot() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  ++pending_snapshots_;
+  drained_.wait(lock, [this]() { return plain_writers_ == 0; });
+  --pending_snapshots_;
+  uint64_t snapshot = visible_locked();
+  snapshots_.insert(snapshot);
+  return snapshot;
+}
+
+void VersionStore::end_snapshot(uint64_t snapshot) {
+  uint64_t horizon = 0;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = snapshots_.find(snapshot);
+    if (it != snapshots_.end()) {
+      snapshots_.erase(it);
+    }
+    horizon = snapshots_.empty() ? visible_locked() : *snapshots_.begin();
+  }
+  if (versions_.load() > 0) {
+    prune(horizon);
+  }
+}
+
+bool VersionStore::empty() const {
+  return versions_.load(std::memory_order_acquire) == 0;
+}
+
+bool VersionStore::lookup(size_t page_id, uint64_t row_id, uint64_t snapshot,
+                          std::vector<char>* out) const {
+  if (empty()) {
+    return false;
+  }
+  const Stripe& stripe = stripe_for(page_id);
+  std::lock_guard<std::mutex> lock(stripe.mutex);
+  auto it = stripe.pages.find(page_id);
+  if (it == stripe.pages.end()) {
+    return false;
+  }
+  // 按写入顺序第一个晚于快照的版本保存的就是快照时的记录。
+  for (const Version& version : it->second) {
+    if (version.row_id == row_id && version.ts > snapshot) {
+      *out = version.record;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool VersionStore::collect(size_t page_id, uint64_t snapshot,
+                           std::vector<std::pair<uint64_t, std::vector<char>>>* out) const {
+  out->clear();
+  if (empty()) {
+    return false;
+  }
+  const Stripe& stripe = stripe_for(page_id);
+  std::lock_guard<std::mutex> lock(stripe.mutex);
+  auto it = stripe.pages.find(page_id);
+  if (it == stripe.pages.end()) {
+    return false;
+  }
+  for (const Version& version : it->second) {
+    if (version.ts <= snapshot) {
+      continue;
+    }
+    bool seen = std::any_of(out->begin(), out->end(),
+                            [&version](const auto& entry) { return entry.first == version.row_id; });
+    if (!seen) {
+      out->emplace_back(version.row_id, version.record);
+    }
+  }
+  std::sort(out->begin(), out->end(),
+            [](const auto& a, const auto& b) { return a.first < b.first; });
+  return !out->empty();
+}
+
+std::vector<uint64_t> VersionStore::changed_rows(uint64_t snapshot) const {
+  std::vector<uint64_t> rows;
+  if (empty()) {
+    return rows;
+  }
+  for (const Stripe& stripe : stripes_) {
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    for (const auto& pair : stripe.pages) {
+      for (const Version& version : pair.second) {
+        if (version.ts > snapshot) {
+          rows.push_back(version.row_id);
+        }
+      }
+    }
+  }
+  std::sort(rows.begin(), rows.end());
+  rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+  return rows;
+}
+
+size_t VersionStore::version_count() const {
+  return versions_.load();
+}
+
+void VersionStore::clear() {
+  for (Stripe& stripe : stripes_) {
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    stripe.pages.clear();
+  }
+  versions_.store(0);
+}
+
+uint64_t VersionStore::visible_locked() const {
+  return writers_.empty() ? last_ts_ : *writers_.begin() - 1;
+}
+
+void VersionStore::prune(uint64_t horizon) {
+  for (Stripe& stripe : stripes_) {
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    for (auto it = stripe.pages.begin(); it != stripe.pages.end();) {
+      std::vector<Version>& versions = it->second;
+      size_t before = versions.size();
+      versions.erase(std::remove_if(versions.begin(), versions.end(),
+                                    [horizon](const Version& v) { return v.ts <= horizon; }),
+                     versions.end());
+      versions_.fetch_sub(before - versions.size());
+      it = versions.empty() ? stripe.pages.erase(it) : std::next(it);
+    }
+  }
+}
+
+const VersionStore::Stripe& VersionStore::stripe_for(size_t page_id) const {
+  return stripes_[page_id % kStripes];
+}
+
+VersionStore::Stripe& VersionStore::stripe_for(size_t page_id) {
+  return stripes_[page_id % kStripes];
+}
+
+VersionWrite::VersionWrite(VersionStore* store) : store_(store) {
+  if (store_) {
+    ts_ = store_->begin_write(&keep_);
+  }
+}
+
+VersionWrite::~VersionWrite() {
+  finish();
+}
+
+void VersionWrite::save(size_t page_id, uint64_t row_id, const std::vector<char>& record) {
+  if (store_ && keep_) {
+    store_->save(page_id, row_id, ts_, record);
+  }
+}
+
+void VersionWrite::finish() {
+  if (store_) {
+    store_->end_write(ts_, keep_);
+    store_ = nullptr;
+  }
+}
+
+VersionSnapshot::VersionSnapshot(VersionStore* store) : store_(store) {
+  if (store_) {
+    ts_ = store_->begin_snapshot();
+  }
+}
+
+VersionSnapshot::~VersionSnapshot() {
+  if (store_) {
+    store_->end_snapshot(ts_);
+  }
+}
+
+uint64_t VersionSnapshot::ts() const {
+  return ts_;
+}
+
+}  // namespace mini_db
@@ -0,0 +1,131 @@
+#include "db/Warmup.h"
+
+#include "db/Utils.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace mini_db {
+
+namespace {
+
+// 文件格式：魔数(4) + 项数(4)，每项为 表名长度(4) + 表名 + 分片(4) + 页数(4) + 页号数组(8 * 页数)，
+// 最后是魔数之后全部内容的 CRC32(4)。
+constexpr char kWarmupMagic[4] = {'W', 'R', 'M', '1'};
+constexpr size_t kWarmupHeaderSize = 8;
+
+void put_uint(std::vector<char>* out, uint64_t value, size_t bytes) {
+  for (size_t i = 0; i < bytes; ++i) {
+    out->push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+  }
+}
+
+uint64_t get_uint(const char* data, size_t bytes) {
+  uint64_t value = 0;
+  for (size_t i = 0; i < bytes; ++i) {
+    value |= static_cast<uint64_t>(static_cast<unsigned char>(data[i])) << (8 * i);
+  }
+  return value;
+}
+
+bool corrupt(const std::string& path, std::string* err) {
+  if (err) {
+    *err = "corrupt warm-up list: " + path;
+  }
+  return false;
+}
+
+}  // namespace
+
+bool save_warmup_list(const std::string& path, const std::vector<WarmupEntry>& entries,
+                      std::string* err) {
+  std::vector<char> data;
+  data.insert(data.end(), kWarmupMagic, kWarmupMagic + sizeof(kWarmupMagic));
+  put_uint(&data, entries.size(), 4);
+  for (const auto& entry : entries) {
+    put_uint(&data, entry.table.size(), 4);
+    data.insert(data.end(), entry.table.begin(), entry.table.end());
+    put_uint(&data, entry.shard, 4);
+    put_uint(&data, entry.pages.size(), 4);
+    data.reserve(data.size() + entry.pages.size() * 8);
+    for (size_t page_id : entry.pages) {
+      put_uint(&data, page_id, 8);
+    }
+  }
+  uint32_t crc = crc32(data.data() + sizeof(kWarmupMagic), data.size() - sizeof(kWarmupMagic));
+  put_uint(&data, crc, 4);
+  // 预热列表只是提示，不需要 fsync：丢失或损坏时下次打开从冷缓存开始。
+  std::string temp_path = path + ".tmp";
+  {
+    std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open() || !file.write(data.data(), static_cast<std::streamsize>(data.size()))) {
+      if (err) {
+        *err = "failed to write warm-up list: " + temp_path;
+      }
+      return false;
+    }
+  }
+  if (std::rename(temp_path.c_str(), path.c_str()) != 0) {
+    std::remove(temp_path.c_str());
+    if (err) {
+      *err = "failed to replace warm-up list: " + path;
+    }
+    return false;
+  }
+  return true;
+}
+
+bool load_warmup_list(const std::string& path, std::vector<WarmupEntry>* entries,
+                      std::string* err) {
+  entries->clear();
+  std::ifstream file(path, std::ios::binary);
+  if (!file.is_open()) {
+    return true;
+  }
+  std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  if (data.size() < kWarmupHeaderSize + 4 ||
+      std::memcmp(data.data(), kWarmupMagic, sizeof(kWarmupMagic)) != 0) {
+    return corrupt(path, err);
+  }
+  size_t body = data.size() - 4;
+  uint32_t crc = static_cast<uint32_t>(get_uint(data.data() + body, 4));
+  if (crc32(data.data() + sizeof(kWarmupMagic), body - sizeof(kWarmupMagic)) != crc) {
+    return corrupt(path, err);
+  }
+  uint64_t count = get_uint(data.data() + sizeof(kWarmupMagic), 4);
+  std::vector<WarmupEntry> loaded;
+  size_t pos = kWarmupHeaderSize;
+  for (uint64_t i = 0; i < count; ++i) {
+    if (pos + 4 > body) {
+      return corrupt(path, err);
+    }
+    size_t name_size = static_cast<size_t>(get_uint(data.data() + pos, 4));
+    pos += 4;
+    if (pos + name_size + 8 > body) {
+      return corrupt(path, err);
+    }
+    WarmupEntry entry;
+    entry.table.assign(data.data() + pos, name_size);
+    pos += name_size;
+    entry.shard = static_cast<uint32_t>(get_uint(data.data() + pos, 4));
+    size_t pages = static_cast<size_t>(get_uint(data.data() + pos + 4, 4));
+    pos += 8;
+    if (pages > (body - pos) / 8) {
+      return corrupt(path, err);
+    }
+    entry.pages.reserve(pages);
+    for (size_t p = 0; p < pages; ++p, pos += 8) {
+      entry.pages.push_back(static_cast<size_t>(get_uint(data.data() + pos, 8)));
+    }
+    loaded.push_back(std::move(entry));
+  }
+  if (pos != body) {
+    return corrupt(path, err);
+  }
+  *entries = std::move(loaded);
+  return true;
+}
+
+}  // namespace mini_db
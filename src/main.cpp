@@ -31,18 +31,25 @@ int main() {
     }
   }
   // NUMA 节点数默认 2，可通过环境变量覆盖，便于迁移到 4/8 路。
-  mini_db::Database db("./data", 4096, 64, numa_nodes);
+  // MINI_DB_READ_ONLY=1 以只读方式打开（表文件 mmap 直接读取，拒绝修改）。
+  mini_db::DatabaseOptions options;
+  const char* env_read_only = std::getenv("MINI_DB_READ_ONLY");
+  options.read_only.enabled = env_read_only && std::string(env_read_only) == "1";
+  mini_db::Database db("./data", 4096, 64, numa_nodes, options);
   std::string err;
   if (!db.open(&err)) {
     std::cerr << "Failed to open database: " << err << "\n";
     return 1;
   }
-  std::cout << "Buffer pool fixed at init. NUMA nodes: " << numa_nodes
-            << ", page->node: page_id % " << numa_nodes << "\n";
+  std::cout << "Buffer pool: " << mini_db::buffer_budget_name(options.buffer)
+            << ", NUMA nodes: " << numa_nodes << ", page placement: "
+            << mini_db::page_placement_name(options.cache.placement.policy) << "\n";
 
   // 交互式 REPL：解析 SQL 并执行。
   mini_db::SqlParser parser;
   mini_db::Executor executor;
+  // SELECT 结果按批直接写到标准输出。
+  executor.set_result_sink([](const std::string& text) { std::cout << text; });
   std::string buffer;
   print_prompt(false);
 
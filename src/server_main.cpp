@@ -0,0 +1,139 @@
+#include "db/Database.h"
+#include "db/Server.h"
+#include "db/Utils.h"
+
+#include <csignal>
+#include <iostream>
+#include <string>
+
+namespace {
+
+// 服务配置：数据库参数与网络参数。
+struct ServerConfig {
+  std::string data_dir = "./data";  // 数据目录
+  size_t cache_pages = 64;          // 缓存页数
+  int numa_nodes = 2;               // NUMA 节点数
+  mini_db::CommitMode commit_mode = mini_db::CommitMode::Group;  // 提交持久化模式
+  mini_db::ServerOptions server;
+};
+
+// 解析非负整数参数。
+bool parse_size(const std::string& value, size_t* out) {
+  if (!mini_db::is_number(value) || value[0] == '-') {
+    return false;
+  }
+  *out = static_cast<size_t>(std::stoull(value));
+  return true;
+}
+
+// 打印服务的使用说明。
+void print_usage() {
+  std::cout
+      << "mini_db_server usage:\n"
+      << "  --data=PATH          数据目录 (default ./data)\n"
+      << "  --host=ADDR          监听地址 (default 127.0.0.1)\n"
+      << "  --port=N             监听端口，0 由系统分配 (default 7878)\n"
+      << "  --cache=N            缓存页数 (default 64)\n"
+      << "  --numa=N             NUMA 节点数 (default 2)\n"
+      << "  --io-threads=N       网络线程数 (default 1)\n"
+      << "  --threads-per-node=N 每个 NUMA 节点的工作线程数 (default 1)\n"
+      << "  --max-connections=N  最大连接数 (default 1024)\n"
+      << "  --pipeline=N         每连接未完成请求上限 (default 128)\n"
+      << "  --commit=MODE        提交模式 sync|group|async (default group)\n";
+}
+
+bool parse_args(int argc, char** argv, ServerConfig* config) {
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--help" || arg == "-h") {
+      print_usage();
+      return false;
+    }
+    auto eq = arg.find('=');
+    if (eq == std::string::npos) {
+      std::cerr << "Unknown argument: " << arg << "\n";
+      return false;
+    }
+    std::string key = arg.substr(0, eq);
+    std::string value = arg.substr(eq + 1);
+    size_t number = 0;
+    if (key == "--data") {
+      config->data_dir = value;
+    } else if (key == "--host") {
+      config->server.host = value;
+    } else if (key == "--commit") {
+      if (value == "sync") {
+        config->commit_mode = mini_db::CommitMode::Sync;
+      } else if (value == "group") {
+        config->commit_mode = mini_db::CommitMode::Group;
+      } else if (value == "async") {
+        config->commit_mode = mini_db::CommitMode::Async;
+      } else {
+        std::cerr << "Unknown commit mode: " << value << "\n";
+        return false;
+      }
+    } else if (!parse_size(value, &number)) {
+      std::cerr << "Invalid value: " << arg << "\n";
+      return false;
+    } else if (key == "--port" && number <= 65535) {
+      config->server.port = static_cast<uint16_t>(number);
+    } else if (key == "--cache") {
+      config->cache_pages = number;
+    } else if (key == "--numa" && number > 0) {
+      config->numa_nodes = static_cast<int>(number);
+    } else if (key == "--io-threads" && number > 0) {
+      config->server.io_threads = static_cast<int>(number);
+    } else if (key == "--threads-per-node" && number > 0) {
+      config->server.threads_per_node = static_cast<int>(number);
+    } else if (key == "--max-connections" && number > 0) {
+      config->server.max_connections = number;
+    } else if (key == "--pipeline" && number > 0) {
+      config->server.max_pipeline = number;
+    } else {
+      std::cerr << "Unknown argument: " << arg << "\n";
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  ServerConfig config;
+  if (!parse_args(argc, argv, &config)) {
+    return 1;
+  }
+  // 在创建任何线程之前屏蔽退出信号，由主线程 sigwait 统一处理。
+  sigset_t signals;
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGINT);
+  sigaddset(&signals, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+  mini_db::DatabaseOptions options;
+  options.log.commit_mode = config.commit_mode;
+  mini_db::Database db(config.data_dir, 4096, config.cache_pages, config.numa_nodes, options);
+  std::string err;
+  if (!db.open(&err)) {
+    std::cerr << "Failed to open database: " << err << "\n";
+    return 1;
+  }
+  mini_db::Server server(&db, config.numa_nodes, config.server);
+  if (!server.start(&err)) {
+    std::cerr << "Failed to start server: " << err << "\n";
+    return 1;
+  }
+  std::cout << "mini_db_server listening on " << config.server.host << ":" << server.port()
+            << ", NUMA nodes: " << config.numa_nodes
+            << ", io threads: " << config.server.io_threads
+            << ", workers per node: " << config.server.threads_per_node << std::endl;
+
+  int received = 0;
+  sigwait(&signals, &received);
+  server.stop();
+  mini_db::ServerStats stats = server.stats();
+  std::cout << "mini_db_server stopped: connections=" << stats.accepted
+            << " rejected=" << stats.rejected << " requests=" << stats.requests << std::endl;
+  return 0;
+}
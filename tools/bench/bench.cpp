@@ -1,16 +1,26 @@
 #include "db/Database.h"
 #include "db/NumaExecutor.h"
+#include "db/Trace.h"
 #include "db/Types.h"
 #include "db/Utils.h"
 
+#include "bench_workload.h"
+
 #include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cstdio>
 #include <cstdlib>
 #include <deque>
+#include <fstream>
 #include <future>
 #include <iostream>
+#include <memory>
 #include <random>
+#include <set>
+#include <sstream>
 #include <string>
+#include <thread>
 #include <vector>
 
 namespace {
@@ -28,8 +38,92 @@ struct BenchConfig {
   int numa_nodes = 2;                      // NUMA 节点数
   size_t cache_pages = 256;                // 缓存页数
   int threads_per_node = 1;                // 每个节点的工作线程数
+  mini_db::CommitMode commit_mode = mini_db::CommitMode::Group;  // 提交持久化模式
+  int group_delay_us = 200;                // 组提交最大等待时间（微秒）
+  mini_db::CachePolicy cache_policy = mini_db::CachePolicy::Lru;  // 页缓存替换策略
+  bool page_writer = true;                 // 是否启用后台写页线程
+  bool shared_cache = true;                // 缓存页数是否为全库共享预算（按缺页压力在分片间调整）
+  bool optimistic_reads = true;            // 点读是否先做无锁乐观读
+  mini_db::IoBackend io_backend = mini_db::IoBackend::Pread;  // 页文件 I/O 后端
+  bool direct_io = false;                  // 页文件是否使用 O_DIRECT
+  size_t readahead_pages = 32;             // 顺序扫描预读窗口（页数，0 关闭预读）
+  size_t steal_threshold = 512;            // 远端线程队列积压超过该值才跨节点窃取（0 不跨节点）
+  size_t batch = 1;                        // 每个节点攒够多少次操作批量提交（1 为逐条提交）
+  mini_db::PagePlacement placement = mini_db::PagePlacement::Modulo;  // 页分布策略
+  size_t range_pages = 1024;               // range 策略每段连续页数
+  std::string trace_path;                  // 压测阶段的追踪输出文件（空表示不追踪）
+  int insert_ratio = 0;                    // 插入比例（追加新行，读写的键空间随之增长）
+  int scan_ratio = 0;                      // 短范围扫描比例
+  int rmw_ratio = 0;                       // 读改写比例（同一任务内读后更新）
+  size_t scan_length = 100;                // 扫描行数上限（每次在 [1, N] 中均匀选取）
+  std::string workload;                    // YCSB 预设 a-f（空表示按各比例参数）
+  bench::KeyDistributionOptions keys;      // 键分布
+  size_t rate = 0;                         // 开环模式的固定到达速率（ops/s，0 为闭环）
+  size_t inflight = 1024;                  // 最大在途任务数
+  size_t warmup_ops = 0;                   // 预热操作数（不计入结果）
+  size_t report_interval = 0;              // 周期报告间隔（秒，0 关闭）
+  std::string json_path;                   // JSON 结果输出文件
+  uint64_t seed = 0;                       // 随机种子（0 表示按时间选取）
+};
+
+// YCSB 核心负载预设（Cooper 等人，SoCC 2010）：各操作比例与键分布。
+struct WorkloadPreset {
+  const char* name;
+  int read;
+  int update;
+  int insert;
+  int scan;
+  int rmw;
+  bench::KeyDistribution dist;
+};
+
+const WorkloadPreset kWorkloadPresets[] = {
+    {"a", 50, 50, 0, 0, 0, bench::KeyDistribution::Zipfian},
+    {"b", 95, 5, 0, 0, 0, bench::KeyDistribution::Zipfian},
+    {"c", 100, 0, 0, 0, 0, bench::KeyDistribution::Zipfian},
+    {"d", 95, 0, 5, 0, 0, bench::KeyDistribution::Latest},
+    {"e", 0, 0, 5, 95, 0, bench::KeyDistribution::Zipfian},
+    {"f", 50, 0, 0, 0, 50, bench::KeyDistribution::Zipfian},
 };
 
+// 按预设设置比例与分布；命令行显式给出的参数优先。
+bool apply_workload(const std::set<std::string>& explicit_keys, BenchConfig* config) {
+  for (const auto& preset : kWorkloadPresets) {
+    if (config->workload != preset.name) {
+      continue;
+    }
+    auto apply = [&explicit_keys](const char* key, int value, int* field) {
+      if (explicit_keys.count(key) == 0) {
+        *field = value;
+      }
+    };
+    apply("--read", preset.read, &config->read_ratio);
+    apply("--update", preset.update, &config->update_ratio);
+    apply("--delete", 0, &config->delete_ratio);
+    apply("--insert", preset.insert, &config->insert_ratio);
+    apply("--scan", preset.scan, &config->scan_ratio);
+    apply("--rmw", preset.rmw, &config->rmw_ratio);
+    if (explicit_keys.count("--dist") == 0) {
+      config->keys.dist = preset.dist;
+    }
+    return true;
+  }
+  std::cerr << "Unknown workload: " << config->workload << " (expected a-f)\n";
+  return false;
+}
+
+const char* commit_mode_name(mini_db::CommitMode mode) {
+  switch (mode) {
+    case mini_db::CommitMode::Sync:
+      return "sync";
+    case mini_db::CommitMode::Group:
+      return "group";
+    case mini_db::CommitMode::Async:
+      return "async";
+  }
+  return "group";
+}
+
 // 解析 size_t 类型参数（只允许正整数）。
 bool parse_size(const std::string& value, size_t* out) {
   if (!out) {
@@ -60,6 +154,22 @@ bool parse_int(const std::string& value, int* out) {
   return true;
 }
 
+// 解析 (low, high] 或 [low, high] 区间内的小数参数。
+bool parse_fraction(const std::string& value, double low, double high, bool low_inclusive,
+                    double* out) {
+  if (value.empty()) {
+    return false;
+  }
+  char* end = nullptr;
+  double parsed = std::strtod(value.c_str(), &end);
+  if (end != value.c_str() + value.size() || parsed > high ||
+      (low_inclusive ? parsed < low : parsed <= low)) {
+    return false;
+  }
+  *out = parsed;
+  return true;
+}
+
 // 打印压测工具的使用说明。
 void print_usage() {
   std::cout
@@ -69,11 +179,40 @@ void print_usage() {
       << "  --read=PCT         读比例 (default 70)\n"
       << "  --update=PCT       更新比例 (default 20)\n"
       << "  --delete=PCT       删除比例 (default 10)\n"
+      << "  --insert=PCT       插入比例 (default 0)\n"
+      << "  --scan=PCT         短范围扫描比例 (default 0)\n"
+      << "  --rmw=PCT          读改写比例 (default 0)\n"
+      << "  --scan-length=N    每次扫描的最大行数 (default 100)\n"
+      << "  --workload=a-f     YCSB 预设负载，显式给出的比例与分布参数优先\n"
+      << "  --dist=NAME        键分布 uniform|zipfian|hotspot|latest (default uniform)\n"
+      << "  --zipf-theta=X     Zipf 偏斜度，0 < X < 1 (default 0.99)\n"
+      << "  --hot-set=X        hotspot 热点键占比 (default 0.2)\n"
+      << "  --hot-ops=X        hotspot 访问热点键的比例 (default 0.8)\n"
+      << "  --rate=N           开环模式按固定速率 N ops/s 提交，延迟从计划到达时间算起 (default 0，闭环)\n"
+      << "  --inflight=N       最大在途任务数 (default 1024)\n"
+      << "  --warmup-ops=N     正式计时前的预热操作数，不计入结果 (default 0)\n"
+      << "  --report-interval=SEC 每隔 SEC 秒输出一次区间吞吐与延迟 (default 0，关闭)\n"
+      << "  --json=FILE        把配置、结果与区间报告写成 JSON\n"
+      << "  --seed=N           随机种子 (default 按时间)\n"
       << "  --data=PATH        数据目录 (default ./data_bench)\n"
       << "  --table=NAME       表名 (default bench_table)\n"
       << "  --cache=N          缓存页数 (default 256)\n"
       << "  --numa=N           NUMA 节点数 (default 2)\n"
       << "  --threads-per-node=N 每个 NUMA 节点线程数 (default 1)\n"
+      << "  --commit=MODE      提交模式 sync|group|async (default group)\n"
+      << "  --group-delay-us=N 组提交最大等待微秒数 (default 200)\n"
+      << "  --policy=NAME      页缓存替换策略 lru|clock|2q (default lru)\n"
+      << "  --page-writer=0|1  后台写页线程 (default 1)\n"
+      << "  --shared-cache=0|1 缓存页数为全库共享预算并动态调整 (default 1)\n"
+      << "  --optimistic=0|1   点读先做按页版本校验的无锁乐观读 (default 1)\n"
+      << "  --io=NAME          页文件 I/O 后端 pread|uring (default pread)\n"
+      << "  --direct-io=0|1    页文件使用 O_DIRECT (default 0)\n"
+      << "  --readahead=N      顺序扫描预读窗口页数，0 关闭 (default 32)\n"
+      << "  --steal-threshold=N 远端线程队列积压超过 N 个任务才跨节点窃取，0 不跨节点 (default 512)\n"
+      << "  --placement=NAME   页分布策略 modulo|range|hash|adaptive (default modulo)\n"
+      << "  --range-pages=N    range 策略每段连续页数 (default 1024)\n"
+      << "  --batch=N          每个节点攒够 N 次操作后批量提交，1 为逐条提交 (default 1)\n"
+      << "  --trace=FILE       压测阶段的分段追踪写入 FILE（Chrome trace JSON，需 -DMINI_DB_TRACE=ON 构建）\n"
       << "  --no-reset         已废弃（请使用 mini_db_bench_prepare 预载数据）\n";
 }
 
@@ -82,6 +221,7 @@ bool parse_args(int argc, char** argv, BenchConfig* config) {
   if (!config) {
     return false;
   }
+  std::set<std::string> explicit_keys;
   for (int i = 1; i < argc; ++i) {
     std::string arg = argv[i];
     if (arg == "--help" || arg == "-h") {
@@ -99,6 +239,7 @@ bool parse_args(int argc, char** argv, BenchConfig* config) {
     }
     std::string key = arg.substr(0, eq);
     std::string value = arg.substr(eq + 1);
+    explicit_keys.insert(key);
     if (key == "--rows") {
       if (!parse_size(value, &config->rows)) {
         return false;
@@ -135,11 +276,173 @@ bool parse_args(int argc, char** argv, BenchConfig* config) {
       if (!parse_int(value, &config->threads_per_node)) {
         return false;
       }
+    } else if (key == "--commit") {
+      if (value == "sync") {
+        config->commit_mode = mini_db::CommitMode::Sync;
+      } else if (value == "group") {
+        config->commit_mode = mini_db::CommitMode::Group;
+      } else if (value == "async") {
+        config->commit_mode = mini_db::CommitMode::Async;
+      } else {
+        std::cerr << "Unknown commit mode: " << value << "\n";
+        return false;
+      }
+    } else if (key == "--group-delay-us") {
+      if (!parse_int(value, &config->group_delay_us)) {
+        return false;
+      }
+    } else if (key == "--page-writer") {
+      if (value == "0" || value == "1") {
+        config->page_writer = value == "1";
+      } else {
+        std::cerr << "Invalid --page-writer value: " << value << "\n";
+        return false;
+      }
+    } else if (key == "--shared-cache") {
+      if (value == "0" || value == "1") {
+        config->shared_cache = value == "1";
+      } else {
+        std::cerr << "Invalid --shared-cache value: " << value << "\n";
+        return false;
+      }
+    } else if (key == "--optimistic") {
+      if (value == "0" || value == "1") {
+        config->optimistic_reads = value == "1";
+      } else {
+        std::cerr << "Invalid --optimistic value: " << value << "\n";
+        return false;
+      }
+    } else if (key == "--io") {
+      if (!mini_db::parse_io_backend(value, &config->io_backend)) {
+        std::cerr << "Unknown io backend: " << value << "\n";
+        return false;
+      }
+    } else if (key == "--direct-io") {
+      if (value == "0" || value == "1") {
+        config->direct_io = value == "1";
+      } else {
+        std::cerr << "Invalid --direct-io value: " << value << "\n";
+        return false;
+      }
+    } else if (key == "--readahead") {
+      if (value == "0") {
+        config->readahead_pages = 0;
+      } else if (!parse_size(value, &config->readahead_pages)) {
+        return false;
+      }
+    } else if (key == "--steal-threshold") {
+      if (value == "0") {
+        config->steal_threshold = 0;
+      } else if (!parse_size(value, &config->steal_threshold)) {
+        return false;
+      }
+    } else if (key == "--placement") {
+      if (!mini_db::parse_page_placement(value, &config->placement)) {
+        std::cerr << "Unknown page placement: " << value << "\n";
+        return false;
+      }
+    } else if (key == "--range-pages") {
+      if (!parse_size(value, &config->range_pages)) {
+        return false;
+      }
+    } else if (key == "--batch") {
+      if (!parse_size(value, &config->batch)) {
+        return false;
+      }
+    } else if (key == "--insert") {
+      if (!parse_int(value, &config->insert_ratio)) {
+        return false;
+      }
+    } else if (key == "--scan") {
+      if (!parse_int(value, &config->scan_ratio)) {
+        return false;
+      }
+    } else if (key == "--rmw") {
+      if (!parse_int(value, &config->rmw_ratio)) {
+        return false;
+      }
+    } else if (key == "--scan-length") {
+      if (!parse_size(value, &config->scan_length) || config->scan_length == 0) {
+        return false;
+      }
+    } else if (key == "--workload") {
+      config->workload = mini_db::to_lower(value);
+    } else if (key == "--dist") {
+      if (!bench::parse_key_distribution(value, &config->keys.dist)) {
+        std::cerr << "Unknown key distribution: " << value << "\n";
+        return false;
+      }
+    } else if (key == "--zipf-theta") {
+      if (!parse_fraction(value, 0.0, 0.999999, false, &config->keys.zipf_theta)) {
+        std::cerr << "Invalid --zipf-theta value: " << value << "\n";
+        return false;
+      }
+    } else if (key == "--hot-set") {
+      if (!parse_fraction(value, 0.0, 1.0, false, &config->keys.hot_set)) {
+        std::cerr << "Invalid --hot-set value: " << value << "\n";
+        return false;
+      }
+    } else if (key == "--hot-ops") {
+      if (!parse_fraction(value, 0.0, 1.0, true, &config->keys.hot_ops)) {
+        std::cerr << "Invalid --hot-ops value: " << value << "\n";
+        return false;
+      }
+    } else if (key == "--rate") {
+      if (value == "0") {
+        config->rate = 0;
+      } else if (!parse_size(value, &config->rate)) {
+        return false;
+      }
+    } else if (key == "--inflight") {
+      if (!parse_size(value, &config->inflight) || config->inflight == 0) {
+        return false;
+      }
+    } else if (key == "--warmup-ops") {
+      if (value == "0") {
+        config->warmup_ops = 0;
+      } else if (!parse_size(value, &config->warmup_ops)) {
+        return false;
+      }
+    } else if (key == "--report-interval") {
+      if (value == "0") {
+        config->report_interval = 0;
+      } else if (!parse_size(value, &config->report_interval)) {
+        return false;
+      }
+    } else if (key == "--json") {
+      if (value.empty()) {
+        return false;
+      }
+      config->json_path = value;
+    } else if (key == "--seed") {
+      size_t seed = 0;
+      if (!parse_size(value, &seed)) {
+        return false;
+      }
+      config->seed = seed;
+    } else if (key == "--trace") {
+      if (value.empty()) {
+        std::cerr << "Invalid --trace value: " << value << "\n";
+        return false;
+      }
+      if (!mini_db::kTraceCompiled) {
+        std::cerr << "--trace requires a build configured with -DMINI_DB_TRACE=ON\n";
+        return false;
+      }
+      config->trace_path = value;
+    } else if (key == "--policy") {
+      if (!mini_db::parse_cache_policy(value, &config->cache_policy)) {
+        std::cerr << "Unknown cache policy: " << value << "\n";
+        return false;
+      }
     } else {
       std::cerr << "Unknown argument: " << arg << "\n";
       return false;
     }
   }
+  if (!config->workload.empty()) {
+    return apply_workload(explicit_keys, config);
+  }
   return true;
 }
 
@@ -148,11 +451,66 @@ mini_db::Value make_value(int id) {
   return mini_db::Value::Text("value_" + std::to_string(id));
 }
 
+using Clock = std::chrono::steady_clock;
+
+// 压测操作类型；删除为删除后按原行号回插，读改写在同一任务内先读后更新。
+enum class OpType : size_t { Read = 0, Update, Delete, Insert, Scan, ReadModifyWrite };
+constexpr size_t kOpTypes = 6;
+const char* const kOpNames[kOpTypes] = {"read", "update", "delete", "insert", "scan", "rmw"};
+// 每种操作折合的语句数（删除+回插、读改写各两条）。
+const size_t kOpQueries[kOpTypes] = {1, 1, 2, 1, 1, 2};
+
 struct TaskResult {
   bool ok = true;
   std::string err;
+  // 任务在工作线程上完成的时刻：延迟不包含主线程按提交顺序回收时的排队。
+  Clock::time_point finish;
+};
+
+// 一个统计区间的吞吐与延迟。
+struct IntervalReport {
+  double at_s = 0.0;
+  uint64_t ops = 0;
+  double ops_per_s = 0.0;
+  uint64_t p50_ns = 0;
+  uint64_t p99_ns = 0;
+  uint64_t max_ns = 0;
 };
 
+double ns_to_ms(uint64_t ns) {
+  return static_cast<double>(ns) / 1e6;
+}
+
+std::string format_number(double value) {
+  char buffer[64];
+  std::snprintf(buffer, sizeof(buffer), "%.3f", value);
+  return buffer;
+}
+
+// 延迟分位数的 JSON 对象（微秒）。
+std::string latency_json(const bench::LatencyRecorder& latency) {
+  std::ostringstream out;
+  out << "{\"count\":" << latency.count()
+      << ",\"mean\":" << format_number(latency.mean_ns() / 1e3)
+      << ",\"p50\":" << format_number(static_cast<double>(latency.percentile_ns(0.50)) / 1e3)
+      << ",\"p90\":" << format_number(static_cast<double>(latency.percentile_ns(0.90)) / 1e3)
+      << ",\"p99\":" << format_number(static_cast<double>(latency.percentile_ns(0.99)) / 1e3)
+      << ",\"p999\":" << format_number(static_cast<double>(latency.percentile_ns(0.999)) / 1e3)
+      << ",\"max\":" << format_number(static_cast<double>(latency.max_ns()) / 1e3) << "}";
+  return out.str();
+}
+
+// 延迟分位数的文本形式（毫秒）。
+std::string latency_text(const bench::LatencyRecorder& latency) {
+  std::ostringstream out;
+  out << "p50 " << ns_to_ms(latency.percentile_ns(0.50)) << " ms, p90 "
+      << ns_to_ms(latency.percentile_ns(0.90)) << " ms, p99 "
+      << ns_to_ms(latency.percentile_ns(0.99)) << " ms, p99.9 "
+      << ns_to_ms(latency.percentile_ns(0.999)) << " ms, max " << ns_to_ms(latency.max_ns())
+      << " ms";
+  return out.str();
+}
+
 }  // namespace
 
 int main(int argc, char** argv) {
@@ -163,11 +521,16 @@ int main(int argc, char** argv) {
   }
 
   // 2) 校验比例合法性。
-  int ratio_sum = config.read_ratio + config.update_ratio + config.delete_ratio;
+  int ratio_sum = config.read_ratio + config.update_ratio + config.delete_ratio +
+                  config.insert_ratio + config.scan_ratio + config.rmw_ratio;
   if (ratio_sum <= 0) {
     std::cerr << "Invalid ratios" << "\n";
     return 1;
   }
+  if (config.batch > 1 && (config.insert_ratio > 0 || config.scan_ratio > 0 || config.rmw_ratio > 0)) {
+    std::cerr << "--batch only supports read/update/delete mixes" << "\n";
+    return 1;
+  }
   if (config.numa_nodes <= 0) {
     config.numa_nodes = 1;
   }
@@ -176,15 +539,40 @@ int main(int argc, char** argv) {
   }
 
   // 3) 初始化数据库实例。
-  mini_db::Database db(config.data_dir, 4096, config.cache_pages, config.numa_nodes);
+  mini_db::DatabaseOptions options;
+  options.log.commit_mode = config.commit_mode;
+  options.log.group_delay_us = static_cast<uint32_t>(config.group_delay_us);
+  options.cache.policy = config.cache_policy;
+  options.cache.writer.enabled = config.page_writer;
+  options.buffer.shared = config.shared_cache;
+  options.cache.optimistic_reads = config.optimistic_reads;
+  options.cache.io.backend = config.io_backend;
+  options.cache.io.direct_io = config.direct_io;
+  options.cache.readahead.enabled = config.readahead_pages > 0;
+  if (config.readahead_pages > 0) {
+    options.cache.readahead.window_pages = config.readahead_pages;
+  }
+  options.cache.placement.policy = config.placement;
+  options.cache.placement.range_pages = config.range_pages;
+  mini_db::Database db(config.data_dir, 4096, config.cache_pages, config.numa_nodes, options);
   std::string err;
   if (!db.open(&err)) {
     std::cerr << "Failed to open database: " << err << "\n";
     return 1;
   }
-  std::cout << "Buffer pool fixed at init. NUMA nodes: " << config.numa_nodes
-            << ", page->node: page_id % " << config.numa_nodes << "\n";
-  std::cout << "Worker threads per node: " << config.threads_per_node << "\n";
+  std::cout << "Buffer pool: " << mini_db::buffer_budget_name(options.buffer)
+            << ", NUMA nodes: " << config.numa_nodes
+            << ", page placement: " << mini_db::page_placement_name(config.placement) << "\n";
+  std::cout << "Worker threads per node: " << config.threads_per_node
+            << ", remote steal threshold: " << config.steal_threshold
+            << ", batch: " << config.batch << "\n";
+  std::cout << "Cache policy: " << mini_db::cache_policy_name(config.cache_policy)
+            << ", page writer: " << (config.page_writer ? "on" : "off")
+            << ", shared cache: " << (config.shared_cache ? "on" : "off")
+            << ", optimistic reads: " << (config.optimistic_reads ? "on" : "off") << "\n";
+  std::cout << "Page I/O: " << mini_db::io_backend_name(config.io_backend)
+            << ", direct I/O: " << (config.direct_io ? "on" : "off")
+            << ", read-ahead: " << config.readahead_pages << " pages\n";
   {
     std::vector<size_t> pages = db.cached_pages_per_node();
     std::cout << "Buffer pool pages per NUMA node:";
@@ -203,159 +591,503 @@ int main(int argc, char** argv) {
   }
 
   // NUMA 执行器：每个节点一组固定工作线程，用于执行压测负载。
-  mini_db::NumaExecutor executor(config.numa_nodes, config.threads_per_node);
+  mini_db::NumaExecutorOptions executor_options;
+  executor_options.remote_steal_threshold = config.steal_threshold;
+  mini_db::NumaExecutor executor(config.numa_nodes, config.threads_per_node, executor_options);
   executor.start();
 
+
   // 6) 初始化随机数生成器与负载分布。
-  std::mt19937 rng(static_cast<unsigned int>(std::chrono::steady_clock::now()
-                                                 .time_since_epoch()
-                                                 .count()));
-  std::uniform_int_distribution<int> key_dist(1, static_cast<int>(config.rows));
+  uint64_t seed = config.seed != 0
+                      ? config.seed
+                      : static_cast<uint64_t>(Clock::now().time_since_epoch().count());
+  std::mt19937 rng(static_cast<unsigned int>(seed));
+  bench::KeyChooser key_chooser(config.keys, seed ^ 0x9E3779B97F4A7C15ULL);
   std::uniform_int_distribution<int> op_dist(1, ratio_sum);
+  // 各操作类型的累计比例上界，按 op_dist 的取值落在哪一段选择操作。
+  const int op_ratios[kOpTypes] = {config.read_ratio,   config.update_ratio, config.delete_ratio,
+                                   config.insert_ratio, config.scan_ratio,   config.rmw_ratio};
+  auto pick_op = [&op_dist, &rng, &op_ratios]() {
+    int value = op_dist(rng);
+    for (size_t type = 0; type < kOpTypes; ++type) {
+      if (value <= op_ratios[type]) {
+        return static_cast<OpType>(type);
+      }
+      value -= op_ratios[type];
+    }
+    return OpType::Read;
+  };
+  std::cout << "Workload: " << (config.workload.empty() ? "custom" : config.workload)
+            << ", keys: " << bench::key_distribution_name(config.keys.dist) << ", mix:";
+  for (size_t type = 0; type < kOpTypes; ++type) {
+    if (op_ratios[type] > 0) {
+      std::cout << " " << kOpNames[type] << "=" << op_ratios[type];
+    }
+  }
+  std::cout << ", load: "
+            << (config.rate > 0 ? "open loop " + std::to_string(config.rate) + " ops/s"
+                                : std::string("closed loop"))
+            << ", inflight: " << config.inflight << ", warm-up ops: " << config.warmup_ops
+            << "\n";
 
-  size_t read_count = 0;
-  size_t update_count = 0;
-  size_t delete_count = 0;
-  size_t query_count = 0;
-  std::vector<double> latencies_ms;
-  latencies_ms.reserve(config.ops);
+  // 已确认插入的行数：读写只选择其中的行号（插入完成前不访问新行）。
+  std::atomic<uint64_t> acked_rows{config.rows};
+  int next_insert_key = static_cast<int>(config.rows) + 1;
+
+  // 计量状态：预热阶段的操作不计数也不记录延迟。
+  bool measured = false;
+  size_t op_counts[kOpTypes] = {};
+  bench::LatencyRecorder total_latency;
+  bench::LatencyRecorder interval_latency;
+  std::vector<bench::LatencyRecorder> op_latency(kOpTypes);
+  std::vector<IntervalReport> intervals;
+  Clock::time_point measure_start;
+  Clock::time_point last_report;
+  Clock::time_point next_report;
+  const auto report_every = std::chrono::seconds(static_cast<int64_t>(config.report_interval));
+
+  auto record_latency = [&](OpType type, Clock::time_point start, Clock::time_point finish) {
+    if (!measured) {
+      return;
+    }
+    uint64_t ns = finish > start ? static_cast<uint64_t>(
+                                       std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                           finish - start)
+                                           .count())
+                                 : 0;
+    total_latency.record(ns);
+    op_latency[static_cast<size_t>(type)].record(ns);
+    if (config.report_interval > 0) {
+      interval_latency.record(ns);
+    }
+  };
+  // 周期报告：按回收时刻把完成的操作归入区间。
+  auto maybe_report = [&](Clock::time_point now) {
+    if (!measured || config.report_interval == 0 || now < next_report) {
+      return;
+    }
+    IntervalReport report;
+    report.at_s = std::chrono::duration<double>(now - measure_start).count();
+    double span = std::chrono::duration<double>(now - last_report).count();
+    report.ops = interval_latency.count();
+    report.ops_per_s = span > 0.0 ? static_cast<double>(report.ops) / span : 0.0;
+    report.p50_ns = interval_latency.percentile_ns(0.50);
+    report.p99_ns = interval_latency.percentile_ns(0.99);
+    report.max_ns = interval_latency.max_ns();
+    std::cout << "[" << format_number(report.at_s) << " s] ops " << report.ops << ", "
+              << report.ops_per_s << " ops/s, p50 " << ns_to_ms(report.p50_ns) << " ms, p99 "
+              << ns_to_ms(report.p99_ns) << " ms, max " << ns_to_ms(report.max_ns) << " ms\n";
+    intervals.push_back(report);
+    interval_latency.reset();
+    last_report = now;
+    while (next_report <= now) {
+      next_report += report_every;
+    }
+  };
 
   struct Pending {
     std::future<TaskResult> future;
-    std::chrono::steady_clock::time_point start;
+    Clock::time_point start;
+    OpType type;
   };
   std::deque<Pending> pending;
-  const size_t max_inflight = 1024;
-  size_t page_size = db.page_size();
-  size_t record_size = schema.record_size();
 
-  // 7) 压测执行：按比例随机执行读/更新/删除+回插（按页归属路由到节点队列）。
+  // 批量模式：每个节点累积读/更新行号与删除+回插操作，攒够 batch 次后用 read_rows / update_rows
+  // 合并为按页加锁的批操作，连同删除一起经 submit_batch 提交，整批只等待一次完成。
+  struct Batch {
+    std::vector<uint64_t> read_ids;
+    std::vector<uint64_t> update_ids;
+    mini_db::SetClause update_set;
+    std::vector<std::pair<uint64_t, int>> deletes;
+    std::vector<Clock::time_point> starts;
+    std::vector<OpType> types;
+  };
+  struct BatchPending {
+    std::future<void> future;
+    std::shared_ptr<TaskResult> result;
+    std::vector<Clock::time_point> starts;
+    std::vector<OpType> types;
+  };
+  std::vector<Batch> batches(static_cast<size_t>(config.numa_nodes));
+  std::deque<BatchPending> batch_pending;
+  const size_t max_inflight_batches =
+      std::max<size_t>(1, config.inflight / std::max<size_t>(1, config.batch));
+
+  // 7) 压测执行：按比例随机执行各类操作（按页归属路由到节点队列）。
   const std::string table_name = config.table;
-  auto start = std::chrono::steady_clock::now();    // 开始计时
-  for (size_t i = 0; i < config.ops; ++i) {
-    int key = key_dist(rng);
-    uint64_t row_id = static_cast<uint64_t>(key - 1);
-    size_t page_id = (page_size + row_id * record_size) / page_size;
-    int node = static_cast<int>(page_id % static_cast<size_t>(config.numa_nodes));
-    int op = op_dist(rng);
-    auto op_start = std::chrono::steady_clock::now();
-    if (op <= config.read_ratio) {
-      // 读操作：按行号读取，失效行视为成功。
-      auto future = executor.submit(node, [&db, table_name, row_id]() -> TaskResult {
-        TaskResult result;
-        std::vector<mini_db::Value> values;
-        bool valid = false;
+  auto submit_batch = [&db, &executor, &table_name](int node, Batch* batch) -> BatchPending {
+    auto result = std::make_shared<TaskResult>();
+    std::vector<mini_db::Task> tasks;
+    if (!batch->read_ids.empty()) {
+      tasks.emplace_back([&db, &table_name, result, ids = std::move(batch->read_ids)]() {
+        size_t valid = 0;
+        auto visit = [&valid](size_t, const mini_db::RecordView& view) { valid += view.valid(); };
         std::string err;
-        if (!db.read_row(table_name, row_id, &values, &valid, &err)) {
-          result.ok = false;
-          result.err = err;
-          return result;
+        if (!db.read_rows(table_name, ids, visit, &err)) {
+          result->ok = false;
+          result->err = err;
         }
-        return result;
       });
-      pending.push_back({std::move(future), op_start});
-      ++read_count;
-      query_count += 1;
-    } else if (op <= config.read_ratio + config.update_ratio) {
-      // 更新操作：按行号更新 value 列。
-      mini_db::SetClause set;
-      set.column = "value";
-      set.value = make_value(static_cast<int>(i));
-      auto future = executor.submit(node, [&db, table_name, row_id, set]() -> TaskResult {
-        TaskResult result;
+    }
+    if (!batch->update_ids.empty()) {
+      tasks.emplace_back([&db, &table_name, result, ids = std::move(batch->update_ids),
+                          set = batch->update_set]() {
         std::string err;
-        if (!db.update_row(table_name, row_id, {set}, &err)) {
-          if (err != "row is deleted") {
-            result.ok = false;
-            result.err = err;
-          }
+        if (result->ok && !db.update_rows(table_name, ids, {set}, nullptr, &err)) {
+          result->ok = false;
+          result->err = err;
         }
-        return result;
       });
-      pending.push_back({std::move(future), op_start});
-      ++update_count;
-      query_count += 1;
-    } else {
-      // 删除操作：删除后回插，保持数据规模稳定。
-      std::vector<mini_db::Value> values;
-      values.push_back(mini_db::Value::Int(key));
-      values.push_back(make_value(key));
-      auto future = executor.submit(node, [&db, table_name, row_id, values]() -> TaskResult {
-        TaskResult result;
+    }
+    for (const auto& entry : batch->deletes) {
+      uint64_t row_id = entry.first;
+      int key = entry.second;
+      tasks.emplace_back([&db, &table_name, result, row_id, key]() {
+        if (!result->ok) {
+          return;
+        }
         std::string err;
-        if (!db.delete_row(table_name, row_id, &err)) {
-          if (err != "row is deleted") {
-            result.ok = false;
-            result.err = err;
-            return result;
-          }
+        if (!db.delete_row(table_name, row_id, &err) && err != "row is deleted") {
+          result->ok = false;
+          result->err = err;
+          return;
         }
+        std::vector<mini_db::Value> values;
+        values.push_back(mini_db::Value::Int(key));
+        values.push_back(make_value(key));
         if (!db.write_row(table_name, row_id, values, true, &err)) {
-          result.ok = false;
-          result.err = err;
+          result->ok = false;
+          result->err = err;
         }
-        return result;
       });
-      pending.push_back({std::move(future), op_start});
-      ++delete_count;
-      query_count += 2;
     }
-
-    // 控制最大并发数，避免任务积压过多。当在途任务太多时，强制回收一个最早提交的任务，避免无限堆积
-    if (pending.size() >= max_inflight) {
-      Pending front = std::move(pending.front());
-      pending.pop_front();
-      TaskResult result = front.future.get();     // 等待该任务完成，并取得结果
-      auto finish = std::chrono::steady_clock::now();
-      std::chrono::duration<double, std::milli> op_elapsed = finish - front.start; // 计算这次操作的耗时，记录到 latencies_ms
-      latencies_ms.push_back(op_elapsed.count());
-      if (!result.ok) {
-        // 如果任务失败，立即输出错误并结束压测
-        std::cerr << "Operation failed: " << result.err << "\n";
-        return 1;
-      }
+    // 批内任务在同一工作线程上依次执行，最后一个任务记录整批的完成时刻。
+    tasks.emplace_back([result]() { result->finish = Clock::now(); });
+    BatchPending entry;
+    entry.future = executor.submit_batch(node, std::move(tasks));
+    entry.result = std::move(result);
+    entry.starts = std::move(batch->starts);
+    entry.types = std::move(batch->types);
+    *batch = Batch{};
+    return entry;
+  };
+  // 回收最早提交的一批：整批完成即记录批内每次操作的延迟。
+  auto collect_batch = [&]() -> bool {
+    BatchPending front = std::move(batch_pending.front());
+    batch_pending.pop_front();
+    front.future.get();
+    for (size_t k = 0; k < front.starts.size(); ++k) {
+      record_latency(front.types[k], front.starts[k], front.result->finish);
     }
-  }
-
-  // 把所有剩余的在途任务收尾，循环把 pending队列里还没有回收的任务全部 future.get() 掉，确保所有请求都执行完成
-  while (!pending.empty()) {
+    maybe_report(Clock::now());
+    if (!front.result->ok) {
+      std::cerr << "Operation failed: " << front.result->err << "\n";
+      return false;
+    }
+    return true;
+  };
+  // 回收最早提交的一个任务（阻塞等待）。
+  auto collect_front = [&]() -> bool {
     Pending front = std::move(pending.front());
     pending.pop_front();
     TaskResult result = front.future.get();
-    auto finish = std::chrono::steady_clock::now();
-    std::chrono::duration<double, std::milli> op_elapsed = finish - front.start; // 统计每个任务的延迟
-    latencies_ms.push_back(op_elapsed.count());
+    record_latency(front.type, front.start, result.finish);
+    maybe_report(Clock::now());
     if (!result.ok) {
       std::cerr << "Operation failed: " << result.err << "\n";
+      return false;
+    }
+    return true;
+  };
+  // 不阻塞地回收队首已完成的任务，使周期报告与在途数量及时更新。
+  auto collect_ready = [&]() -> bool {
+    while (!pending.empty() && pending.front().future.wait_for(std::chrono::seconds(0)) ==
+                                   std::future_status::ready) {
+      if (!collect_front()) {
+        return false;
+      }
+    }
+    while (!batch_pending.empty() && batch_pending.front().future.wait_for(
+                                         std::chrono::seconds(0)) == std::future_status::ready) {
+      if (!collect_batch()) {
+        return false;
+      }
+    }
+    return true;
+  };
+  // 提交单个操作：工作线程在任务结束时记下完成时刻。
+  auto submit_op = [&](int node, OpType type, Clock::time_point op_start, auto body) {
+    auto future = executor.submit(node, [body = std::move(body)]() mutable -> TaskResult {
+      TaskResult result = body();
+      result.finish = Clock::now();
+      return result;
+    });
+    pending.push_back({std::move(future), op_start, type});
+  };
+
+  // 执行一个阶段的 ops 次操作并等待全部完成；measure 为 false 时是预热阶段。
+  auto run_phase = [&](size_t ops, bool measure) -> bool {
+    measured = measure;
+    Clock::time_point phase_start = Clock::now();
+    if (measure) {
+      measure_start = phase_start;
+      last_report = phase_start;
+      next_report = phase_start + report_every;
+    }
+    for (size_t i = 0; i < ops; ++i) {
+      // 开环：第 i 次操作的计划到达时间固定，延迟从计划时间算起（提交被拖后的时间也计入，
+      // 即修正协调遗漏）；闭环：延迟从实际提交时算起。
+      Clock::time_point op_start;
+      if (config.rate > 0) {
+        op_start = phase_start + std::chrono::nanoseconds(static_cast<int64_t>(
+                                     static_cast<double>(i) * 1e9 / static_cast<double>(config.rate)));
+        if (!collect_ready()) {
+          return false;
+        }
+        if (Clock::now() < op_start) {
+          std::this_thread::sleep_until(op_start);
+        }
+      } else {
+        op_start = Clock::now();
+      }
+      if (!collect_ready()) {
+        return false;
+      }
+      OpType type = pick_op();
+      uint64_t rows_now = acked_rows.load(std::memory_order_acquire);
+      uint64_t row_id = key_chooser.next(rows_now);
+      if (type == OpType::Insert) {
+        // 新行追加在表尾：按当前表尾所在页路由。
+        row_id = rows_now;
+      }
+      int key = static_cast<int>(row_id + 1);
+      // 按页帧当前所在节点路由（由表的页分布策略决定，adaptive 下随页帧迁移变化）。
+      int node = 0;
+      if (!db.node_for_row(table_name, row_id, &node, &err)) {
+        std::cerr << "Failed to route row: " << err << "\n";
+        return false;
+      }
+      if (measured) {
+        ++op_counts[static_cast<size_t>(type)];
+      }
+      if (config.batch > 1) {
+        Batch& batch = batches[static_cast<size_t>(node)];
+        if (type == OpType::Read) {
+          batch.read_ids.push_back(row_id);
+        } else if (type == OpType::Update) {
+          if (batch.update_ids.empty()) {
+            batch.update_set.column = "value";
+            batch.update_set.value = make_value(static_cast<int>(i));
+          }
+          batch.update_ids.push_back(row_id);
+        } else {
+          batch.deletes.emplace_back(row_id, key);
+        }
+        batch.starts.push_back(op_start);
+        batch.types.push_back(type);
+        if (batch.starts.size() >= config.batch) {
+          batch_pending.push_back(submit_batch(node, &batch));
+        }
+        if (batch_pending.size() >= max_inflight_batches && !collect_batch()) {
+          return false;
+        }
+        continue;
+      }
+      if (type == OpType::Read) {
+        // 读操作：按行号零拷贝读取记录视图，失效行视为成功。
+        submit_op(node, type, op_start, [&db, table_name, row_id]() {
+          TaskResult result;
+          std::string err;
+          bool valid = false;
+          auto visit = [&valid](const mini_db::RecordView& view) { valid = view.valid(); };
+          if (!db.read_row(table_name, row_id, visit, &err)) {
+            result.ok = false;
+            result.err = err;
+          }
+          return result;
+        });
+      } else if (type == OpType::Update) {
+        // 更新操作：按行号更新 value 列。
+        mini_db::SetClause set;
+        set.column = "value";
+        set.value = make_value(static_cast<int>(i));
+        submit_op(node, type, op_start, [&db, table_name, row_id, set]() {
+          TaskResult result;
+          std::string err;
+          if (!db.update_row(table_name, row_id, {set}, &err) && err != "row is deleted") {
+            result.ok = false;
+            result.err = err;
+          }
+          return result;
+        });
+      } else if (type == OpType::Delete) {
+        // 删除操作：删除后回插，保持数据规模稳定。
+        std::vector<mini_db::Value> values;
+        values.push_back(mini_db::Value::Int(key));
+        values.push_back(make_value(key));
+        submit_op(node, type, op_start, [&db, table_name, row_id, values]() {
+          TaskResult result;
+          std::string err;
+          if (!db.delete_row(table_name, row_id, &err) && err != "row is deleted") {
+            result.ok = false;
+            result.err = err;
+            return result;
+          }
+          if (!db.write_row(table_name, row_id, values, true, &err)) {
+            result.ok = false;
+            result.err = err;
+          }
+          return result;
+        });
+      } else if (type == OpType::Insert) {
+        // 插入操作：追加新行，完成后把新行号计入可访问的键空间。
+        std::vector<mini_db::Value> values;
+        values.push_back(mini_db::Value::Int(next_insert_key));
+        values.push_back(make_value(next_insert_key));
+        ++next_insert_key;
+        submit_op(node, type, op_start, [&db, &acked_rows, table_name, values]() {
+          TaskResult result;
+          std::string err;
+          uint64_t inserted = 0;
+          if (!db.insert(table_name, values, &inserted, &err)) {
+            result.ok = false;
+            result.err = err;
+            return result;
+          }
+          uint64_t seen = acked_rows.load();
+          while (seen < inserted + 1 && !acked_rows.compare_exchange_weak(seen, inserted + 1)) {
+          }
+          return result;
+        });
+      } else if (type == OpType::Scan) {
+        // 短范围扫描：从选中的行起按行号连续读取若干行。
+        uint64_t length = key_chooser.uniform(1, config.scan_length);
+        std::vector<uint64_t> ids;
+        for (uint64_t id = row_id; id < rows_now && ids.size() < length; ++id) {
+          ids.push_back(id);
+        }
+        submit_op(node, type, op_start, [&db, table_name, ids = std::move(ids)]() {
+          TaskResult result;
+          std::string err;
+          size_t valid = 0;
+          auto visit = [&valid](size_t, const mini_db::RecordView& view) { valid += view.valid(); };
+          if (!db.read_rows(table_name, ids, visit, &err)) {
+            result.ok = false;
+            result.err = err;
+          }
+          return result;
+        });
+      } else {
+        // 读改写：同一任务内先读后更新。
+        mini_db::SetClause set;
+        set.column = "value";
+        set.value = make_value(static_cast<int>(i));
+        submit_op(node, type, op_start, [&db, table_name, row_id, set]() {
+          TaskResult result;
+          std::string err;
+          bool valid = false;
+          auto visit = [&valid](const mini_db::RecordView& view) { valid = view.valid(); };
+          if (!db.read_row(table_name, row_id, visit, &err)) {
+            result.ok = false;
+            result.err = err;
+            return result;
+          }
+          if (valid && !db.update_row(table_name, row_id, {set}, &err) &&
+              err != "row is deleted") {
+            result.ok = false;
+            result.err = err;
+          }
+          return result;
+        });
+      }
+
+      // 控制最大并发数，避免任务积压过多：在途任务太多时阻塞回收最早提交的任务。
+      if (pending.size() >= config.inflight && !collect_front()) {
+        return false;
+      }
+    }
+
+    // 提交各节点未攒满的批次，并回收全部在途批次与任务。
+    for (size_t node = 0; node < batches.size(); ++node) {
+      if (!batches[node].starts.empty()) {
+        batch_pending.push_back(submit_batch(static_cast<int>(node), &batches[node]));
+      }
+    }
+    while (!batch_pending.empty()) {
+      if (!collect_batch()) {
+        return false;
+      }
+    }
+    while (!pending.empty()) {
+      if (!collect_front()) {
+        return false;
+      }
+    }
+    return true;
+  };
+
+  if (config.warmup_ops > 0) {
+    if (!run_phase(config.warmup_ops, false)) {
       return 1;
     }
+    std::cout << "Warm-up finished: " << config.warmup_ops << " ops\n";
   }
-  auto end = std::chrono::steady_clock::now();  // 结束计时
+  if (!config.trace_path.empty() && !mini_db::trace_start(&err)) {
+    std::cerr << "Failed to start trace: " << err << "\n";
+    return 1;
+  }
+  if (!run_phase(config.ops, true)) {
+    return 1;
+  }
+  auto end = Clock::now();  // 结束计时
+  mini_db::NumaExecutorStats executor_stats = executor.stats();
   executor.stop(); // 停止工作线程组
+  if (!config.trace_path.empty()) {
+    mini_db::trace_stop();
+  }
 
   // 8) 汇总统计并输出结果。
-  std::chrono::duration<double> elapsed = end - start;
+  std::chrono::duration<double> elapsed = end - measure_start;
   double seconds = elapsed.count();
+  size_t query_count = 0;
+  for (size_t type = 0; type < kOpTypes; ++type) {
+    query_count += op_counts[type] * kOpQueries[type];
+  }
   double tps = seconds > 0.0 ? static_cast<double>(config.ops) / seconds : 0.0;
   double qps = seconds > 0.0 ? static_cast<double>(query_count) / seconds : 0.0;
-
-  double p99 = 0.0;
-  if (!latencies_ms.empty()) {
-    size_t idx = static_cast<size_t>(0.99 * (latencies_ms.size() - 1));
-    std::nth_element(latencies_ms.begin(), latencies_ms.begin() + idx, latencies_ms.end());
-    p99 = latencies_ms[idx];
-  }
+  double p99 = ns_to_ms(total_latency.percentile_ns(0.99));
 
   std::cout << "\nBenchmark finished:\n";
   std::cout << "  total_ops:   " << config.ops << "\n";
-  std::cout << "  read_ops:    " << read_count << "\n";
-  std::cout << "  update_ops:  " << update_count << "\n";
-  std::cout << "  delete_ops:  " << delete_count << "\n";
+  std::cout << "  read_ops:    " << op_counts[static_cast<size_t>(OpType::Read)] << "\n";
+  std::cout << "  update_ops:  " << op_counts[static_cast<size_t>(OpType::Update)] << "\n";
+  std::cout << "  delete_ops:  " << op_counts[static_cast<size_t>(OpType::Delete)] << "\n";
+  if (config.insert_ratio > 0 || config.scan_ratio > 0 || config.rmw_ratio > 0) {
+    std::cout << "  insert_ops:  " << op_counts[static_cast<size_t>(OpType::Insert)] << "\n";
+    std::cout << "  scan_ops:    " << op_counts[static_cast<size_t>(OpType::Scan)] << "\n";
+    std::cout << "  rmw_ops:     " << op_counts[static_cast<size_t>(OpType::ReadModifyWrite)]
+              << "\n";
+  }
   std::cout << "  total_qry:   " << query_count << "\n";
   std::cout << "  elapsed:     " << seconds << " s\n";
   std::cout << "  tps:         " << tps << " ops/s\n";
   std::cout << "  qps:         " << qps << " queries/s\n";
   std::cout << "  p99:         " << p99 << " ms\n";
+  std::cout << "  latency:     " << latency_text(total_latency)
+            << (config.rate > 0 ? " (from scheduled arrival)" : "") << "\n";
+  for (size_t type = 0; type < kOpTypes; ++type) {
+    if (op_latency[type].count() > 0) {
+      std::cout << "    " << kOpNames[type] << ": " << latency_text(op_latency[type]) << "\n";
+    }
+  }
+  std::cout << "  migrations:  " << db.page_migrations() << "\n";
+  mini_db::CacheStats cache = db.cache_stats();
+  uint64_t lookups = cache.hits + cache.misses;
+  double hit_rate = lookups > 0 ? static_cast<double>(cache.hits) * 100.0 / lookups : 0.0;
+  std::cout << "  cache:       hit " << hit_rate << "% (" << cache.hits << "/" << lookups
+            << "), pages " << cache.pages << "/" << cache.limit << "\n";
+  std::cout << "  tasks:       " << executor_stats.executed << " (stolen local "
+            << executor_stats.stolen_local << ", remote " << executor_stats.stolen_remote << ")\n";
   {
     std::vector<size_t> pages = db.cached_pages_per_node();
     std::cout << "Buffer pool pages per NUMA node after benchmark:";
@@ -364,6 +1096,65 @@ int main(int argc, char** argv) {
     }
     std::cout << "\n";
   }
+  if (!config.trace_path.empty()) {
+    if (mini_db::trace_export_chrome(config.trace_path, &err)) {
+      std::cout << "Trace written to " << config.trace_path << "\n";
+    } else {
+      std::cerr << "Failed to write trace: " << err << "\n";
+    }
+  }
+  if (!config.json_path.empty()) {
+    // 回归看板使用的结果文件：配置、总体与分操作延迟（微秒）、各区间报告。
+    std::ostringstream json;
+    json << "{\n  \"config\": {\"workload\":\""
+         << (config.workload.empty() ? "custom" : config.workload) << "\",\"distribution\":\""
+         << bench::key_distribution_name(config.keys.dist)
+         << "\",\"zipf_theta\":" << config.keys.zipf_theta << ",\"mix\":{";
+    for (size_t type = 0; type < kOpTypes; ++type) {
+      json << (type ? "," : "") << "\"" << kOpNames[type] << "\":" << op_ratios[type];
+    }
+    json << "},\"rows\":" << config.rows << ",\"ops\":" << config.ops
+         << ",\"warmup_ops\":" << config.warmup_ops << ",\"rate\":" << config.rate
+         << ",\"inflight\":" << config.inflight << ",\"batch\":" << config.batch
+         << ",\"numa_nodes\":" << config.numa_nodes
+         << ",\"threads_per_node\":" << config.threads_per_node << ",\"commit\":\""
+         << commit_mode_name(config.commit_mode) << "\",\"policy\":\""
+         << mini_db::cache_policy_name(config.cache_policy) << "\",\"placement\":\""
+         << mini_db::page_placement_name(config.placement) << "\",\"seed\":" << seed << "},\n";
+    json << "  \"results\": {\"ops\":" << config.ops << ",\"queries\":" << query_count
+         << ",\"elapsed_s\":" << format_number(seconds) << ",\"tps\":" << format_number(tps)
+         << ",\"qps\":" << format_number(qps) << ",\"latency_us\":" << latency_json(total_latency)
+         << ",\"by_op\":{";
+    bool first = true;
+    for (size_t type = 0; type < kOpTypes; ++type) {
+      if (op_latency[type].count() == 0) {
+        continue;
+      }
+      json << (first ? "" : ",") << "\"" << kOpNames[type]
+           << "\":" << latency_json(op_latency[type]);
+      first = false;
+    }
+    json << "},\"cache_hit_pct\":" << format_number(hit_rate)
+         << ",\"migrations\":" << db.page_migrations()
+         << ",\"tasks_stolen_local\":" << executor_stats.stolen_local
+         << ",\"tasks_stolen_remote\":" << executor_stats.stolen_remote << "},\n";
+    json << "  \"intervals\": [";
+    for (size_t k = 0; k < intervals.size(); ++k) {
+      const IntervalReport& report = intervals[k];
+      json << (k ? "," : "") << "\n    {\"t_s\":" << format_number(report.at_s)
+           << ",\"ops\":" << report.ops << ",\"ops_per_s\":" << format_number(report.ops_per_s)
+           << ",\"p50_us\":" << format_number(static_cast<double>(report.p50_ns) / 1e3)
+           << ",\"p99_us\":" << format_number(static_cast<double>(report.p99_ns) / 1e3)
+           << ",\"max_us\":" << format_number(static_cast<double>(report.max_ns) / 1e3) << "}";
+    }
+    json << (intervals.empty() ? "" : "\n  ") << "]\n}\n";
+    std::ofstream file(config.json_path, std::ios::trunc);
+    if (!file.is_open() || !(file << json.str())) {
+      std::cerr << "Failed to write JSON results: " << config.json_path << "\n";
+    } else {
+      std::cout << "Results written to " << config.json_path << "\n";
+    }
+  }
 
   // 9) 关闭数据库。
   db.close(&err);
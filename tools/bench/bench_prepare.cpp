@@ -1,7 +1,8 @@
+#include "db/Database.h"
+
 #include <cstdint>
+#include <cstdio>
 #include <cstdlib>
-#include <cstring>
-#include <fstream>
 #include <iostream>
 #include <string>
 #include <vector>
@@ -86,81 +87,34 @@ bool parse_args(int argc, char** argv, PrepareConfig* config) {
   return true;
 }
 
-void write_uint32(std::vector<char>* out, size_t offset, uint32_t value) {
-  (*out)[offset] = static_cast<char>(value & 0xFF);
-  (*out)[offset + 1] = static_cast<char>((value >> 8) & 0xFF);
-  (*out)[offset + 2] = static_cast<char>((value >> 16) & 0xFF);
-  (*out)[offset + 3] = static_cast<char>((value >> 24) & 0xFF);
-}
-
-void write_uint64(std::vector<char>* out, size_t offset, uint64_t value) {
-  for (size_t i = 0; i < 8; ++i) {
-    (*out)[offset + i] = static_cast<char>((value >> (8 * i)) & 0xFF);
-  }
-}
-
-std::vector<char> make_text32(int id) {
-  std::string text = "value_" + std::to_string(id);
-  std::vector<char> buffer(32, 0);
-  size_t copy_len = text.size() < buffer.size() ? text.size() : buffer.size();
-  std::memcpy(buffer.data(), text.data(), copy_len);
-  return buffer;
+// 固定表结构：id INT + value TEXT(32)。
+std::vector<mini_db::Column> bench_columns() {
+  mini_db::Column id;
+  id.name = "id";
+  id.type = mini_db::ColumnType::Int;
+  mini_db::Column value;
+  value.name = "value";
+  value.type = mini_db::ColumnType::Text;
+  value.length = 32;
+  return {id, value};
 }
 
-bool write_catalog(const std::string& path, const std::string& table) {
-  std::ofstream file(path, std::ios::out | std::ios::trunc);
-  if (!file.is_open()) {
-    return false;
-  }
-  file << table << "|id:INT|value:TEXT(32)\n";
-  return file.good();
-}
-
-bool write_table_file(const std::string& path, size_t rows) {
-  const size_t page_size = 4096;
-  const size_t record_size = 1 + sizeof(int32_t) + 32;
-  const size_t header_size = 32;
-  std::ofstream file(path, std::ios::out | std::ios::binary | std::ios::trunc);
-  if (!file.is_open()) {
-    return false;
-  }
-
-  std::vector<char> header(header_size, 0);
-  header[0] = 'T';
-  header[1] = 'B';
-  header[2] = 'L';
-  header[3] = '1';
-  write_uint32(&header, 4, static_cast<uint32_t>(record_size));
-  write_uint64(&header, 8, static_cast<uint64_t>(rows));
-  write_uint64(&header, 16, 0);
-  file.write(header.data(), static_cast<std::streamsize>(header.size()));
-  if (!file) {
-    return false;
-  }
-
-  if (page_size > header.size()) {
-    std::vector<char> padding(page_size - header.size(), 0);
-    file.write(padding.data(), static_cast<std::streamsize>(padding.size()));
-    if (!file) {
-      return false;
-    }
-  }
-
-  std::vector<char> record(record_size, 0);
+// 通过引擎的批量装载写入 rows 行（id 从 1 开始，value 为 value_<id>），每批一次顺序写页与日志落盘。
+bool load_rows(mini_db::Database* db, const std::string& table, size_t rows, std::string* err) {
+  const size_t batch_rows = 8192;
+  std::vector<std::vector<mini_db::Value>> batch;
+  batch.reserve(batch_rows);
   for (size_t i = 0; i < rows; ++i) {
-    record.assign(record_size, 0);
-    record[0] = 1;
     int32_t id = static_cast<int32_t>(i + 1);
-    write_uint32(&record, 1, static_cast<uint32_t>(id));
-    std::vector<char> text = make_text32(static_cast<int>(i + 1));
-    std::memcpy(record.data() + 1 + sizeof(int32_t), text.data(), text.size());
-    file.write(record.data(), static_cast<std::streamsize>(record.size()));
-    if (!file) {
-      return false;
+    batch.push_back({mini_db::Value::Int(id), mini_db::Value::Text("value_" + std::to_string(id))});
+    if (batch.size() == batch_rows || i + 1 == rows) {
+      if (!db->bulk_insert(table, batch, nullptr, err)) {
+        return false;
+      }
+      batch.clear();
     }
   }
-  file.flush();
-  return file.good();
+  return true;
 }
 
 std::string normalize_path(const std::string& path) {
@@ -224,25 +178,40 @@ int main(int argc, char** argv) {
   }
 
   const std::string data_dir = normalize_path(config.data_dir);
-  const std::string catalog_path = data_dir + "/catalog.meta";
-  const std::string table_path = data_dir + "/" + config.table + ".tbl";
-  if (!config.reset) {
-    std::ifstream table_file(table_path);
-    if (table_file.good()) {
+  // 装载期间不逐批等待 fdatasync，关闭时的检查点统一刷盘。
+  mini_db::DatabaseOptions options;
+  options.log.commit_mode = mini_db::CommitMode::Async;
+  mini_db::Database db(data_dir, 4096, 256, 1, options);
+  if (!db.open(&err)) {
+    std::cerr << "Failed to open database: " << err << "\n";
+    return 1;
+  }
+  mini_db::Schema schema;
+  if (db.get_schema(config.table, &schema, nullptr)) {
+    if (!config.reset) {
       std::cout << "Table already exists, skip prepare.\n";
+      db.close(&err);
       return 0;
     }
+    if (!db.drop_table(config.table, &err)) {
+      std::cerr << "Failed to drop table: " << err << "\n";
+      return 1;
+    }
   }
-
-  if (!write_catalog(catalog_path, config.table)) {
-    std::cerr << "Failed to write catalog.meta\n";
+  if (!db.create_table(config.table, bench_columns(), &err)) {
+    std::cerr << "Failed to create table: " << err << "\n";
     return 1;
   }
   std::cout << "Loading " << config.rows << " rows...\n";
-  if (!write_table_file(table_path, config.rows)) {
-    std::cerr << "Failed to write table file\n";
+  if (!load_rows(&db, config.table, config.rows, &err)) {
+    std::cerr << "Failed to load rows: " << err << "\n";
+    return 1;
+  }
+  db.close(&err);
+  if (!err.empty()) {
+    std::cerr << "Failed to close database: " << err << "\n";
     return 1;
   }
-  std::cout << "Prepare done: " << table_path << "\n";
+  std::cout << "Prepare done: " << data_dir << "/" << config.table << ".tbl\n";
   return 0;
 }
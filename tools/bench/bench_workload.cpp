@@ -0,0 +1,187 @@
+#include "bench_workload.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace bench {
+
+namespace {
+
+constexpr size_t kSubBucketBits = 6;
+constexpr size_t kSubBuckets = size_t{1} << kSubBucketBits;
+// 0..127 直接对应；之后每个 2^msb 区间（msb = 7..63）各 64 个子桶。
+constexpr size_t kLinearBuckets = kSubBuckets * 2;
+constexpr size_t kBucketCount = kLinearBuckets + (64 - 7) * kSubBuckets;
+
+size_t bucket_for(uint64_t ns) {
+  if (ns < kLinearBuckets) {
+    return static_cast<size_t>(ns);
+  }
+  int msb = 63 - __builtin_clzll(ns);
+  int shift = msb - static_cast<int>(kSubBucketBits);
+  uint64_t top = ns >> shift;  // [64, 128)
+  return kLinearBuckets + static_cast<size_t>(shift - 1) * kSubBuckets +
+         static_cast<size_t>(top - kSubBuckets);
+}
+
+uint64_t bucket_upper(size_t bucket) {
+  if (bucket < kLinearBuckets) {
+    return bucket;
+  }
+  size_t offset = bucket - kLinearBuckets;
+  int shift = static_cast<int>(offset / kSubBuckets) + 1;
+  uint64_t top = kSubBuckets + offset % kSubBuckets;
+  if (shift >= 57 && top == kSubBuckets * 2 - 1) {
+    return UINT64_MAX;
+  }
+  return ((top + 1) << shift) - 1;
+}
+
+uint64_t fnv1a64(uint64_t value) {
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for (int i = 0; i < 8; ++i) {
+    hash ^= value & 0xFF;
+    hash *= 0x100000001b3ULL;
+    value >>= 8;
+  }
+  return hash;
+}
+
+}  // namespace
+
+bool parse_key_distribution(const std::string& name, KeyDistribution* out) {
+  if (name == "uniform") {
+    *out = KeyDistribution::Uniform;
+  } else if (name == "zipfian") {
+    *out = KeyDistribution::Zipfian;
+  } else if (name == "hotspot") {
+    *out = KeyDistribution::Hotspot;
+  } else if (name == "latest") {
+    *out = KeyDistribution::Latest;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+const char* key_distribution_name(KeyDistribution dist) {
+  switch (dist) {
+    case KeyDistribution::Uniform:
+      return "uniform";
+    case KeyDistribution::Zipfian:
+      return "zipfian";
+    case KeyDistribution::Hotspot:
+      return "hotspot";
+    case KeyDistribution::Latest:
+      return "latest";
+  }
+  return "uniform";
+}
+
+KeyChooser::KeyChooser(const KeyDistributionOptions& options, uint64_t seed)
+    : options_(options), rng_(seed) {
+  alpha_ = 1.0 / (1.0 - options_.zipf_theta);
+  zeta2_ = 1.0 + std::pow(0.5, options_.zipf_theta);
+}
+
+uint64_t KeyChooser::uniform(uint64_t low, uint64_t high) {
+  return std::uniform_int_distribution<uint64_t>(low, high)(rng_);
+}
+
+uint64_t KeyChooser::next(uint64_t n) {
+  if (n <= 1) {
+    return 0;
+  }
+  switch (options_.dist) {
+    case KeyDistribution::Uniform:
+      return uniform(0, n - 1);
+    case KeyDistribution::Zipfian:
+      return fnv1a64(zipf_rank(n)) % n;
+    case KeyDistribution::Hotspot: {
+      uint64_t hot = std::max<uint64_t>(
+          1, static_cast<uint64_t>(options_.hot_set * static_cast<double>(n)));
+      if (hot >= n || unit_(rng_) < options_.hot_ops) {
+        return uniform(0, std::min(hot, n) - 1);
+      }
+      return uniform(hot, n - 1);
+    }
+    case KeyDistribution::Latest:
+      return n - 1 - zipf_rank(n);
+  }
+  return 0;
+}
+
+uint64_t KeyChooser::zipf_rank(uint64_t n) {
+  double theta = options_.zipf_theta;
+  if (n != zipf_items_) {
+    // 键空间只增不减（插入），按增量补算 zeta(n)；缩小时从头计算。
+    if (n < zipf_items_) {
+      zipf_items_ = 0;
+      zetan_ = 0.0;
+    }
+    for (uint64_t i = zipf_items_ + 1; i <= n; ++i) {
+      zetan_ += 1.0 / std::pow(static_cast<double>(i), theta);
+    }
+    zipf_items_ = n;
+    eta_ = (1.0 - std::pow(2.0 / static_cast<double>(n), 1.0 - theta)) / (1.0 - zeta2_ / zetan_);
+  }
+  double u = unit_(rng_);
+  double uz = u * zetan_;
+  if (uz < 1.0) {
+    return 0;
+  }
+  if (uz < 1.0 + std::pow(0.5, theta)) {
+    return 1;
+  }
+  uint64_t rank = static_cast<uint64_t>(static_cast<double>(n) *
+                                        std::pow(eta_ * u - eta_ + 1.0, alpha_));
+  return std::min(rank, n - 1);
+}
+
+LatencyRecorder::LatencyRecorder() : buckets_(kBucketCount, 0) {}
+
+void LatencyRecorder::record(uint64_t ns) {
+  ++buckets_[bucket_for(ns)];
+  ++count_;
+  max_ns_ = std::max(max_ns_, ns);
+  sum_ns_ += static_cast<double>(ns);
+}
+
+void LatencyRecorder::merge(const LatencyRecorder& other) {
+  for (size_t i = 0; i < kBucketCount; ++i) {
+    buckets_[i] += other.buckets_[i];
+  }
+  count_ += other.count_;
+  max_ns_ = std::max(max_ns_, other.max_ns_);
+  sum_ns_ += other.sum_ns_;
+}
+
+void LatencyRecorder::reset() {
+  std::fill(buckets_.begin(), buckets_.end(), 0);
+  count_ = 0;
+  max_ns_ = 0;
+  sum_ns_ = 0.0;
+}
+
+double LatencyRecorder::mean_ns() const {
+  return count_ > 0 ? sum_ns_ / static_cast<double>(count_) : 0.0;
+}
+
+uint64_t LatencyRecorder::percentile_ns(double q) const {
+  if (count_ == 0) {
+    return 0;
+  }
+  // 排名取 ceil(q * count)，q = 1 时即最大值所在桶。
+  uint64_t rank = static_cast<uint64_t>(std::ceil(q * static_cast<double>(count_)));
+  rank = std::max<uint64_t>(1, std::min(rank, count_));
+  uint64_t seen = 0;
+  for (size_t i = 0; i < kBucketCount; ++i) {
+    seen += buckets_[i];
+    if (seen >= rank) {
+      return std::min(bucket_upper(i), max_ns_);
+    }
+  }
+  return max_ns_;
+}
+
+}  // namespace bench
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace bench {
+
+// 压测的键分布。
+enum class KeyDistribution {
+  Uniform,
+  // YCSB 的 Zipfian：按排名服从 Zipf(theta)，排名经哈希打散到整个键空间（热点分散在各页）。
+  Zipfian,
+  // 热点：hot_ops 比例的访问落在前 hot_set 比例的键上，其余均匀落在剩余的键上。
+  Hotspot,
+  // 最新：越新插入的键越热（YCSB workload D），按 Zipf 排名从键空间末尾倒数。
+  Latest,
+};
+
+bool parse_key_distribution(const std::string& name, KeyDistribution* out);
+const char* key_distribution_name(KeyDistribution dist);
+
+struct KeyDistributionOptions {
+  KeyDistribution dist = KeyDistribution::Uniform;
+  double zipf_theta = 0.99;
+  double hot_set = 0.2;
+  double hot_ops = 0.8;
+};
+
+// 按分布在 [0, n) 中选键；n 可随插入增长（Zipf 的 zeta 常数按增量补算）。单线程使用。
+class KeyChooser {
+ public:
+  KeyChooser(const KeyDistributionOptions& options, uint64_t seed);
+
+  uint64_t next(uint64_t n);
+  // [low, high] 内的均匀整数（扫描长度等辅助随机数共用同一个生成器）。
+  uint64_t uniform(uint64_t low, uint64_t high);
+
+ private:
+  uint64_t zipf_rank(uint64_t n);
+
+  KeyDistributionOptions options_;
+  std::mt19937_64 rng_;
+  std::uniform_real_distribution<double> unit_{0.0, 1.0};
+  // Zipf 状态（Gray 等人的快速生成算法，与 YCSB ZipfianGenerator 相同）。
+  uint64_t zipf_items_ = 0;
+  double zeta2_ = 0.0;
+  double zetan_ = 0.0;
+  double alpha_ = 0.0;
+  double eta_ = 0.0;
+};
+
+// HDR 风格的延迟直方图（纳秒）：128 以下每个值一个桶，之上每个 2 的幂区间分 64 个等宽子桶，
+// 相对误差不超过 1/64。分位数取所在桶的上界（不超过记录到的最大值）。
+class LatencyRecorder {
+ public:
+  LatencyRecorder();
+
+  void record(uint64_t ns);
+  void merge(const LatencyRecorder& other);
+  void reset();
+
+  uint64_t count() const { return count_; }
+  uint64_t max_ns() const { return max_ns_; }
+  double mean_ns() const;
+  uint64_t percentile_ns(double q) const;
+
+ private:
+  std::vector<uint64_t> buckets_;
+  uint64_t count_ = 0;
+  uint64_t max_ns_ = 0;
+  double sum_ns_ = 0.0;
+};
+
+}  // namespace bench
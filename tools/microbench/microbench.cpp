@@ -0,0 +1,576 @@
+#include "db/BufferPool.h"
+#include "db/Cache.h"
+#include "db/LogManager.h"
+#include "db/Numa.h"
+#include "db/NumaExecutor.h"
+#include "db/PagedFile.h"
+#include "db/Pager.h"
+#include "db/Schema.h"
+#include "db/SqlParser.h"
+#include "db/Types.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t kPageSize = 4096;
+
+// 微基准配置。
+struct MicrobenchConfig {
+  std::string dir = "./data_microbench";  // 临时文件目录
+  std::string filter;                     // 只运行名称包含该子串的用例
+  uint64_t min_time_ms = 200;             // 每轮计时的最短时间
+  size_t repetitions = 3;                 // 计时轮数（报告中位数与最小值）
+  std::string json_path;                  // 结果 JSON 文件（空表示不写）
+  bool list = false;                      // 只列出用例名（仍会准备数据，但不执行用例）
+};
+
+// 阻止编译器把被测结果当作无用计算消除。
+template <typename T>
+void do_not_optimize(const T& value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// 单个用例的结果（每次操作的纳秒数）。
+struct CaseResult {
+  std::string name;
+  uint64_t iterations = 0;
+  double median_ns = 0.0;
+  double min_ns = 0.0;
+};
+
+// 极简基准框架：迭代次数按倍增校准到单轮不短于 min_time_ms，然后计时 repetitions 轮。
+// 用例体 body(n) 执行 n 次被测操作，失败时返回 false 并写入 err。
+class Harness {
+ public:
+  explicit Harness(const MicrobenchConfig& config) : config_(config) {}
+
+  using Body = std::function<bool(uint64_t iterations, std::string* err)>;
+
+  void run(const std::string& name, const Body& body) {
+    if (!config_.filter.empty() && name.find(config_.filter) == std::string::npos) {
+      return;
+    }
+    if (config_.list) {
+      std::cout << name << "\n";
+      return;
+    }
+    const double min_time_ns = static_cast<double>(config_.min_time_ms) * 1e6;
+    std::string err;
+    uint64_t iterations = 1;
+    double elapsed = 0.0;
+    while (true) {
+      if (!time_body(body, iterations, &elapsed, &err)) {
+        fail(name, err);
+        return;
+      }
+      if (elapsed >= min_time_ns || iterations >= (uint64_t{1} << 40)) {
+        break;
+      }
+      // 按已测速度估算所需次数，最多放大 10 倍，避免一次估算过头。
+      double scale = elapsed > 0.0 ? min_time_ns * 1.2 / elapsed : 10.0;
+      scale = std::min(10.0, std::max(2.0, scale));
+      iterations = static_cast<uint64_t>(static_cast<double>(iterations) * scale);
+    }
+    std::vector<double> samples;
+    samples.push_back(elapsed / static_cast<double>(iterations));
+    for (size_t i = 1; i < config_.repetitions; ++i) {
+      if (!time_body(body, iterations, &elapsed, &err)) {
+        fail(name, err);
+        return;
+      }
+      samples.push_back(elapsed / static_cast<double>(iterations));
+    }
+    std::sort(samples.begin(), samples.end());
+    CaseResult result;
+    result.name = name;
+    result.iterations = iterations;
+    result.median_ns = samples[samples.size() / 2];
+    result.min_ns = samples.front();
+    char line[160];
+    std::snprintf(line, sizeof(line), "%-44s %12llu %12.1f %12.1f", name.c_str(),
+                  static_cast<unsigned long long>(iterations), result.median_ns, result.min_ns);
+    std::cout << line << std::endl;
+    results_.push_back(result);
+  }
+
+  bool failed() const { return failed_; }
+  const std::vector<CaseResult>& results() const { return results_; }
+
+ private:
+  static bool time_body(const Body& body, uint64_t iterations, double* elapsed_ns,
+                        std::string* err) {
+    auto start = Clock::now();
+    bool ok = body(iterations, err);
+    auto end = Clock::now();
+    *elapsed_ns = static_cast<double>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+    return ok;
+  }
+
+  void fail(const std::string& name, const std::string& err) {
+    std::cerr << name << " failed: " << err << "\n";
+    failed_ = true;
+  }
+
+  MicrobenchConfig config_;
+  std::vector<CaseResult> results_;
+  bool failed_ = false;
+};
+
+// 准备 pages 页内容非零的页文件（每页首 8 字节为页号）。
+bool write_pages(const std::string& path, size_t pages, std::string* err) {
+  std::remove(path.c_str());
+  mini_db::Pager pager(path, kPageSize);
+  std::vector<char> page(kPageSize, 'x');
+  for (size_t i = 0; i < pages; ++i) {
+    uint64_t id = i;
+    std::copy(reinterpret_cast<const char*>(&id), reinterpret_cast<const char*>(&id) + sizeof(id),
+              page.begin());
+    if (!pager.write_page(i, page.data(), page.size(), err)) {
+      return false;
+    }
+  }
+  return pager.flush(err);
+}
+
+// 只测缓存本身：关闭后台写页线程与预读，避免后台线程干扰计时。
+mini_db::CacheOptions quiet_cache_options() {
+  mini_db::CacheOptions options;
+  options.writer.enabled = false;
+  options.readahead.enabled = false;
+  return options;
+}
+
+// PageCache::get_page：命中（工作集小于容量）与未命中（按页号循环访问 4 倍容量，LRU 下每次都换出）。
+void bench_page_cache(Harness* harness, const std::string& dir) {
+  const size_t capacity = 256;
+  const std::string path = dir + "/page_cache.dat";
+  std::string err;
+  if (!write_pages(path, capacity * 4, &err)) {
+    std::cerr << "page_cache setup failed: " << err << "\n";
+    return;
+  }
+  {
+    mini_db::Pager pager(path, kPageSize);
+    std::unique_ptr<mini_db::NumaAllocator> allocator = mini_db::create_numa_allocator();
+    mini_db::PageCache cache(&pager, capacity, kPageSize, 0, allocator.get(),
+                             quiet_cache_options());
+    const size_t hot_pages = capacity / 2;
+    for (size_t i = 0; i < hot_pages; ++i) {
+      cache.get_page(i, mini_db::PageGuard::Mode::Read, mini_db::PageAccess::Normal, &err);
+    }
+    size_t next = 0;
+    harness->run("page_cache/get_page_hit", [&](uint64_t n, std::string* e) {
+      for (uint64_t i = 0; i < n; ++i) {
+        mini_db::PageGuard page = cache.get_page(next, mini_db::PageGuard::Mode::Read,
+                                                 mini_db::PageAccess::Normal, e);
+        if (!page) {
+          return false;
+        }
+        do_not_optimize(page.data()[0]);
+        next = next + 1 == hot_pages ? 0 : next + 1;
+      }
+      return true;
+    });
+    harness->run("page_cache/get_page_hit_write", [&](uint64_t n, std::string* e) {
+      for (uint64_t i = 0; i < n; ++i) {
+        mini_db::PageGuard page = cache.get_page(next, mini_db::PageGuard::Mode::Write,
+                                                 mini_db::PageAccess::Normal, e);
+        if (!page) {
+          return false;
+        }
+        do_not_optimize(page.data()[0]);
+        next = next + 1 == hot_pages ? 0 : next + 1;
+      }
+      return true;
+    });
+    const size_t cold_pages = capacity * 4;
+    next = 0;
+    harness->run("page_cache/get_page_miss", [&](uint64_t n, std::string* e) {
+      for (uint64_t i = 0; i < n; ++i) {
+        mini_db::PageGuard page = cache.get_page(next, mini_db::PageGuard::Mode::Read,
+                                                 mini_db::PageAccess::Normal, e);
+        if (!page) {
+          return false;
+        }
+        do_not_optimize(page.data()[0]);
+        next = next + 1 == cold_pages ? 0 : next + 1;
+      }
+      return true;
+    });
+    char out[64];
+    next = 0;
+    for (size_t i = 0; i < hot_pages; ++i) {
+      cache.get_page(i, mini_db::PageGuard::Mode::Read, mini_db::PageAccess::Normal, &err);
+    }
+    harness->run("page_cache/read_optimistic_hit", [&](uint64_t n, std::string* e) {
+      for (uint64_t i = 0; i < n; ++i) {
+        if (!cache.read_optimistic(next, 128, sizeof(out), out)) {
+          *e = "optimistic read missed page " + std::to_string(next);
+          return false;
+        }
+        do_not_optimize(out[0]);
+        next = next + 1 == hot_pages ? 0 : next + 1;
+      }
+      return true;
+    });
+  }
+  std::remove(path.c_str());
+}
+
+// NumaBufferPool：按页分布策略路由到分片后命中，以及单独的路由查询。
+void bench_buffer_pool(Harness* harness, const std::string& dir) {
+  const size_t pages = 512;
+  const std::string path = dir + "/buffer_pool.dat";
+  std::string err;
+  if (!write_pages(path, pages, &err)) {
+    std::cerr << "buffer_pool setup failed: " << err << "\n";
+    return;
+  }
+  const mini_db::PagePlacement placements[] = {
+      mini_db::PagePlacement::Modulo, mini_db::PagePlacement::Range,
+      mini_db::PagePlacement::Hash, mini_db::PagePlacement::Adaptive};
+  for (mini_db::PagePlacement placement : placements) {
+    mini_db::Pager pager(path, kPageSize);
+    mini_db::CacheOptions options = quiet_cache_options();
+    options.placement.policy = placement;
+    options.placement.range_pages = 64;
+    // 容量足够放下全部页：两个分片各 pages 帧，range 策略下页集中在一个分片也不换出。
+    mini_db::NumaBufferPool pool(&pager, pages * 2, kPageSize, 2, options);
+    for (size_t i = 0; i < pages; ++i) {
+      pool.get_page(i, mini_db::PageGuard::Mode::Read, mini_db::PageAccess::Normal, &err);
+    }
+    const std::string suffix = mini_db::page_placement_name(placement);
+    size_t next = 0;
+    harness->run("buffer_pool/get_page_hit/" + suffix, [&](uint64_t n, std::string* e) {
+      for (uint64_t i = 0; i < n; ++i) {
+        mini_db::PageGuard page = pool.get_page(next, mini_db::PageGuard::Mode::Read,
+                                                mini_db::PageAccess::Normal, e);
+        if (!page) {
+          return false;
+        }
+        do_not_optimize(page.data()[0]);
+        // 跳跃访问，使相邻两次访问落在不同分片。
+        next = (next + 97) % pages;
+      }
+      return true;
+    });
+    harness->run("buffer_pool/frame_node_for_page/" + suffix, [&](uint64_t n, std::string*) {
+      int sum = 0;
+      for (uint64_t i = 0; i < n; ++i) {
+        sum += pool.frame_node_for_page(next);
+        next = (next + 97) % pages;
+      }
+      do_not_optimize(sum);
+      return true;
+    });
+  }
+  std::remove(path.c_str());
+}
+
+// Schema 编解码：INT + 两个 TEXT 列的定长记录。
+void bench_schema(Harness* harness) {
+  std::vector<mini_db::Column> columns(3);
+  columns[0].name = "id";
+  columns[0].type = mini_db::ColumnType::Int;
+  columns[1].name = "name";
+  columns[1].type = mini_db::ColumnType::Text;
+  columns[1].length = 32;
+  columns[2].name = "city";
+  columns[2].type = mini_db::ColumnType::Text;
+  columns[2].length = 64;
+  mini_db::Schema schema(columns);
+  std::vector<mini_db::Value> values;
+  values.push_back(mini_db::Value::Int(42));
+  values.push_back(mini_db::Value::Text("microbench_name"));
+  values.push_back(mini_db::Value::Text("microbench_city_value"));
+  harness->run("schema/encode_record", [&](uint64_t n, std::string* e) {
+    for (uint64_t i = 0; i < n; ++i) {
+      std::vector<char> record = schema.encode_record(values, true, e);
+      if (record.empty()) {
+        return false;
+      }
+      do_not_optimize(record[1]);
+    }
+    return true;
+  });
+  std::string err;
+  std::vector<char> record = schema.encode_record(values, true, &err);
+  std::vector<mini_db::Value> decoded;
+  harness->run("schema/decode_record", [&](uint64_t n, std::string* e) {
+    bool valid = false;
+    for (uint64_t i = 0; i < n; ++i) {
+      if (!schema.decode_record(record, &decoded, &valid, e)) {
+        return false;
+      }
+      do_not_optimize(decoded[0].int_value);
+    }
+    return true;
+  });
+}
+
+// PagedFile::read_item：页内读取与跨页边界读取（缓存全部命中）。
+void bench_paged_file(Harness* harness, const std::string& dir) {
+  const size_t pages = 64;
+  const std::string path = dir + "/paged_file.dat";
+  std::string err;
+  if (!write_pages(path, pages, &err)) {
+    std::cerr << "paged_file setup failed: " << err << "\n";
+    return;
+  }
+  {
+    mini_db::PagedFile file(path, kPageSize, pages * 2, 1, quiet_cache_options());
+    mini_db::DataItem item;
+    for (size_t i = 0; i < pages; ++i) {
+      file.read_item(i * kPageSize, 8, &item, &err);
+    }
+    size_t page = 0;
+    auto read_case = [&](size_t offset_in_page, size_t size) {
+      return [&file, &item, &page, pages, offset_in_page, size](uint64_t n, std::string* e) {
+        for (uint64_t i = 0; i < n; ++i) {
+          if (!file.read_item(page * kPageSize + offset_in_page, size, &item, e)) {
+            return false;
+          }
+          do_not_optimize(item.data[0]);
+          page = page + 2 >= pages ? 0 : page + 1;
+        }
+        return true;
+      };
+    };
+    harness->run("paged_file/read_item_in_page", read_case(1024, 128));
+    harness->run("paged_file/read_item_cross_page", read_case(kPageSize - 64, 128));
+    harness->run("paged_file/read_item_three_pages", read_case(kPageSize - 64, kPageSize + 128));
+  }
+  std::remove(path.c_str());
+}
+
+// LogManager::append：只进内存缓冲（异步提交，追加方不等待落盘）。
+void bench_log(Harness* harness, const std::string& dir) {
+  const std::string path = dir + "/microbench.log";
+  mini_db::LogOptions options;
+  options.commit_mode = mini_db::CommitMode::Async;
+  std::string err;
+  {
+    mini_db::LogManager log(path, 1, options);
+    // 与数据库打开时相同：恢复完成后由 clear 打开新的活动段。
+    log.clear(&err);
+    if (!err.empty()) {
+      std::cerr << "log setup failed: " << err << "\n";
+      return;
+    }
+    const size_t sizes[] = {64, 512};
+    for (size_t size : sizes) {
+      std::vector<char> data(size, 'l');
+      uint64_t row = 0;
+      harness->run("log/append/" + std::to_string(size), [&](uint64_t n, std::string* e) {
+        uint64_t lsn = 0;
+        for (uint64_t i = 0; i < n; ++i) {
+          if (!log.append(0, mini_db::LogOp::Update, 1, row++, data, &lsn, e)) {
+            return false;
+          }
+        }
+        do_not_optimize(lsn);
+        // 每轮结束后清空日志，避免文件无限增长。
+        log.clear(e);
+        return e->empty();
+      });
+    }
+    log.close();
+  }
+  std::remove((path + ".n0").c_str());
+}
+
+// SqlParser::parse：完整词法/语法分析（不缓存）与语句缓存命中。
+void bench_sql_parser(Harness* harness) {
+  const std::string select_sql = "SELECT * FROM bench_table WHERE id >= 100 LIMIT 10;";
+  const std::string insert_sql = "INSERT INTO bench_table VALUES (12345, \"value_12345\");";
+  const std::string update_sql = "UPDATE bench_table SET value = \"abc\" WHERE id = 77;";
+  mini_db::SqlParser uncached(0);
+  mini_db::SqlParser cached;
+  auto parse_case = [](const mini_db::SqlParser* parser, const std::string* sql) {
+    return [parser, sql](uint64_t n, std::string* e) {
+      mini_db::Statement statement;
+      for (uint64_t i = 0; i < n; ++i) {
+        if (!parser->parse(*sql, &statement, e)) {
+          return false;
+        }
+        do_not_optimize(statement.type);
+      }
+      return true;
+    };
+  };
+  harness->run("sql_parser/parse_select", parse_case(&uncached, &select_sql));
+  harness->run("sql_parser/parse_insert", parse_case(&uncached, &insert_sql));
+  harness->run("sql_parser/parse_update", parse_case(&uncached, &update_sql));
+  harness->run("sql_parser/parse_select_cached", parse_case(&cached, &select_sql));
+}
+
+// NumaExecutor::submit：提交一个空任务并等待 future 的往返（同节点与跨节点各一个工作线程）。
+void bench_executor(Harness* harness) {
+  mini_db::NumaExecutor executor(2, 1);
+  executor.start();
+  for (int node = 0; node < 2; ++node) {
+    harness->run("executor/submit_round_trip/node" + std::to_string(node),
+                 [&executor, node](uint64_t n, std::string*) {
+                   uint64_t sum = 0;
+                   for (uint64_t i = 0; i < n; ++i) {
+                     sum += executor.submit(node, [i]() { return i; }).get();
+                   }
+                   do_not_optimize(sum);
+                   return true;
+                 });
+  }
+  harness->run("executor/submit_batch_16", [&executor](uint64_t n, std::string*) {
+    for (uint64_t i = 0; i < n; ++i) {
+      std::vector<mini_db::Task> tasks;
+      for (int k = 0; k < 16; ++k) {
+        tasks.emplace_back([]() {});
+      }
+      executor.submit_batch(0, std::move(tasks)).get();
+    }
+    return true;
+  });
+  executor.stop();
+}
+
+bool parse_u64(const std::string& value, uint64_t* out) {
+  if (value.empty() || value.find_first_not_of("0123456789") != std::string::npos) {
+    return false;
+  }
+  *out = std::stoull(value);
+  return true;
+}
+
+void print_usage() {
+  std::cout << "mini_db_microbench usage:\n"
+            << "  --filter=TEXT      只运行名称包含 TEXT 的用例\n"
+            << "  --list             列出全部用例名\n"
+            << "  --min-time-ms=N    每轮计时的最短时间 (default 200)\n"
+            << "  --repetitions=N    计时轮数，报告中位数与最小值 (default 3)\n"
+            << "  --json=FILE        把结果写成 JSON（每次操作的纳秒数）\n"
+            << "  --dir=PATH         临时文件目录 (default ./data_microbench)\n";
+}
+
+bool parse_args(int argc, char** argv, MicrobenchConfig* config) {
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--help" || arg == "-h") {
+      print_usage();
+      return false;
+    }
+    if (arg == "--list") {
+      config->list = true;
+      continue;
+    }
+    auto eq = arg.find('=');
+    if (eq == std::string::npos) {
+      std::cerr << "Unknown argument: " << arg << "\n";
+      return false;
+    }
+    std::string key = arg.substr(0, eq);
+    std::string value = arg.substr(eq + 1);
+    uint64_t number = 0;
+    if (key == "--filter") {
+      config->filter = value;
+    } else if (key == "--min-time-ms") {
+      if (!parse_u64(value, &number) || number == 0) {
+        std::cerr << "Invalid --min-time-ms: " << value << "\n";
+        return false;
+      }
+      config->min_time_ms = number;
+    } else if (key == "--repetitions") {
+      if (!parse_u64(value, &number) || number == 0) {
+        std::cerr << "Invalid --repetitions: " << value << "\n";
+        return false;
+      }
+      config->repetitions = static_cast<size_t>(number);
+    } else if (key == "--json") {
+      config->json_path = value;
+    } else if (key == "--dir") {
+      config->dir = value;
+    } else {
+      std::cerr << "Unknown argument: " << arg << "\n";
+      return false;
+    }
+  }
+  return true;
+}
+
+bool write_json(const std::string& path, const MicrobenchConfig& config,
+                const std::vector<CaseResult>& results) {
+  std::ostringstream json;
+  json << "{\n  \"min_time_ms\": " << config.min_time_ms
+       << ",\n  \"repetitions\": " << config.repetitions << ",\n  \"benchmarks\": [";
+  char number[64];
+  for (size_t i = 0; i < results.size(); ++i) {
+    const CaseResult& result = results[i];
+    json << (i ? "," : "") << "\n    {\"name\":\"" << result.name
+         << "\",\"iterations\":" << result.iterations;
+    std::snprintf(number, sizeof(number), "%.3f", result.median_ns);
+    json << ",\"ns_per_op\":" << number;
+    std::snprintf(number, sizeof(number), "%.3f", result.min_ns);
+    json << ",\"min_ns_per_op\":" << number << "}";
+  }
+  json << (results.empty() ? "" : "\n  ") << "]\n}\n";
+  std::ofstream file(path, std::ios::trunc);
+  return file.is_open() && static_cast<bool>(file << json.str());
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  MicrobenchConfig config;
+  if (!parse_args(argc, argv, &config)) {
+    return 1;
+  }
+  if (mkdir(config.dir.c_str(), 0755) != 0 && errno != EEXIST) {
+    std::cerr << "Failed to create directory: " << config.dir << "\n";
+    return 1;
+  }
+
+  Harness harness(config);
+  if (!config.list) {
+    std::cout << "NUMA: " << (mini_db::is_numa_enabled() ? "on" : "off")
+              << ", min time " << config.min_time_ms << " ms x " << config.repetitions
+              << " repetitions\n";
+    char header[160];
+    std::snprintf(header, sizeof(header), "%-44s %12s %12s %12s", "benchmark", "iterations",
+                  "ns/op", "min ns/op");
+    std::cout << header << "\n";
+  }
+  bench_page_cache(&harness, config.dir);
+  bench_buffer_pool(&harness, config.dir);
+  bench_schema(&harness);
+  bench_paged_file(&harness, config.dir);
+  bench_log(&harness, config.dir);
+  bench_sql_parser(&harness);
+  bench_executor(&harness);
+
+  if (!config.json_path.empty()) {
+    if (write_json(config.json_path, config, harness.results())) {
+      std::cout << "Results written to " << config.json_path << "\n";
+    } else {
+      std::cerr << "Failed to write JSON results: " << config.json_path << "\n";
+      return 1;
+    }
+  }
+  rmdir(config.dir.c_str());
+  return harness.failed() ? 1 : 0;
+}
@@ -146,6 +146,8 @@ int main(int argc, char** argv) {
     return 1;
   }
   if (bench_pid == 0) {
+    // 让压测进程发布引擎 NUMA 计数，供监控进程与 /proc 数据并列显示（已显式设置时不覆盖）。
+    setenv("MINI_DB_NUMA_METRICS", "1", 0);
     std::vector<char*> bench_argv = build_argv(config.bench_path, config.bench_args);
     execvp(bench_argv[0], bench_argv.data());
     std::cerr << "Failed to exec bench: " << std::strerror(errno) << "\n";
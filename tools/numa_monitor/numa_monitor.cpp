@@ -11,8 +11,13 @@
 #include <unordered_map>
 #include <vector>
 
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
 #include <unistd.h>
 
+#include "db/NumaMetrics.h"
+
 namespace {
 
 // 配置参数：被监控的 PID 与刷新间隔。
@@ -213,6 +218,65 @@ std::vector<long long> normalize_vector(const std::vector<long long>& input, int
   return result;
 }
 
+// 引擎共享段中一个节点的计数快照。
+struct EngineNodeValues {
+  long long local_accesses = 0;
+  long long remote_accesses = 0;
+  long long alloc_bytes = 0;
+  long long alloc_checked_bytes = 0;
+  long long alloc_misplaced_bytes = 0;
+  long long submit_local = 0;
+  long long submit_remote = 0;
+};
+
+// 读取目标进程的引擎 NUMA 计数（见 db/NumaMetrics.h）；进程未开启 MINI_DB_NUMA_METRICS
+// 或段属于已退出的进程时返回 false。
+bool read_engine_metrics(int pid, std::vector<EngineNodeValues>* values, std::string* err) {
+  values->clear();
+  std::string name = mini_db::numa_metrics_shm_name(pid);
+  int fd = shm_open(name.c_str(), O_RDONLY, 0);
+  if (fd < 0) {
+    if (err) {
+      *err = "no shared segment /dev/shm" + name + " (start the engine with MINI_DB_NUMA_METRICS=1)";
+    }
+    return false;
+  }
+  void* addr = mmap(nullptr, sizeof(mini_db::NumaMetricsSegment), PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (addr == MAP_FAILED) {
+    if (err) {
+      *err = "failed to map " + name + ": " + std::strerror(errno);
+    }
+    return false;
+  }
+  const auto* segment = static_cast<const mini_db::NumaMetricsSegment*>(addr);
+  bool ok = segment->magic == mini_db::kNumaMetricsMagic &&
+            segment->version == mini_db::kNumaMetricsVersion && segment->pid == pid &&
+            kill(pid, 0) == 0;
+  if (ok) {
+    size_t nodes = segment->nodes.load(std::memory_order_relaxed);
+    if (nodes > mini_db::kNumaMetricsMaxNodes) {
+      nodes = mini_db::kNumaMetricsMaxNodes;
+    }
+    values->resize(nodes > 0 ? nodes : 1);
+    for (size_t i = 0; i < values->size(); ++i) {
+      const mini_db::NumaNodeMetrics& node = segment->node[i];
+      EngineNodeValues& out = (*values)[i];
+      out.local_accesses = static_cast<long long>(node.local_accesses.load());
+      out.remote_accesses = static_cast<long long>(node.remote_accesses.load());
+      out.alloc_bytes = static_cast<long long>(node.alloc_bytes.load());
+      out.alloc_checked_bytes = static_cast<long long>(node.alloc_checked_bytes.load());
+      out.alloc_misplaced_bytes = static_cast<long long>(node.alloc_misplaced_bytes.load());
+      out.submit_local = static_cast<long long>(node.submit_local.load());
+      out.submit_remote = static_cast<long long>(node.submit_remote.load());
+    }
+  } else if (err) {
+    *err = "stale or incompatible segment " + name;
+  }
+  munmap(addr, sizeof(mini_db::NumaMetricsSegment));
+  return ok;
+}
+
 // 格式化输出每节点数据。
 void print_node_values(const std::vector<double>& values, const std::string& suffix) {
   for (size_t i = 0; i < values.size(); ++i) {
@@ -221,6 +285,55 @@ void print_node_values(const std::vector<double>& values, const std::string& suf
   std::cout << "\n";
 }
 
+// 输出引擎计数：有上一轮快照时输出每秒增量，否则输出累计值。
+void print_engine_metrics(const std::vector<EngineNodeValues>& current,
+                          const std::vector<EngineNodeValues>& prev, bool has_prev,
+                          double interval_sec) {
+  size_t nodes = current.size();
+  auto field_line = [&](const char* label, long long EngineNodeValues::*field, double scale,
+                        const std::string& suffix) {
+    std::vector<double> line(nodes, 0.0);
+    for (size_t i = 0; i < nodes; ++i) {
+      long long value = current[i].*field;
+      if (has_prev && i < prev.size()) {
+        value -= prev[i].*field;
+      }
+      line[i] = static_cast<double>(value) / scale / (has_prev ? interval_sec : 1.0);
+    }
+    std::cout << "  " << label << ":";
+    print_node_values(line, has_prev ? suffix + "/s" : suffix);
+  };
+  auto ratio_line = [&](const char* label, long long EngineNodeValues::*part,
+                        long long EngineNodeValues::*other) {
+    std::vector<double> ratios(nodes, 0.0);
+    for (size_t i = 0; i < nodes; ++i) {
+      long long a = current[i].*part;
+      long long b = current[i].*other;
+      if (has_prev && i < prev.size()) {
+        a -= prev[i].*part;
+        b -= prev[i].*other;
+      }
+      ratios[i] = a + b > 0 ? static_cast<double>(a) * 100.0 / static_cast<double>(a + b) : 0.0;
+    }
+    std::cout << "  " << label << ":";
+    print_node_values(ratios, "%");
+  };
+  const double mb = 1024.0 * 1024.0;
+  std::cout << "Engine NUMA stats by frame/target node (" << (has_prev ? "delta per sec" : "total")
+            << "):\n";
+  field_line("frame_local", &EngineNodeValues::local_accesses, 1.0, "");
+  field_line("frame_remote", &EngineNodeValues::remote_accesses, 1.0, "");
+  ratio_line("frame_remote_ratio", &EngineNodeValues::remote_accesses,
+             &EngineNodeValues::local_accesses);
+  field_line("buffer_alloc", &EngineNodeValues::alloc_bytes, mb, "MB");
+  field_line("buffer_checked", &EngineNodeValues::alloc_checked_bytes, mb, "MB");
+  field_line("buffer_misplaced", &EngineNodeValues::alloc_misplaced_bytes, mb, "MB");
+  field_line("submit_local", &EngineNodeValues::submit_local, 1.0, "");
+  field_line("submit_remote", &EngineNodeValues::submit_remote, 1.0, "");
+  ratio_line("submit_remote_ratio", &EngineNodeValues::submit_remote,
+             &EngineNodeValues::submit_local);
+}
+
 }  // namespace
 
 int main(int argc, char** argv) {
@@ -236,6 +349,9 @@ int main(int argc, char** argv) {
   std::unordered_map<std::string, std::vector<long long>> prev_metrics;
   bool has_prev = false;
   bool numastat_warned = false;
+  std::vector<EngineNodeValues> prev_engine;
+  bool has_prev_engine = false;
+  double interval_sec = static_cast<double>(config.interval_ms) / 1000.0;
 
   while (true) {
     std::map<int, long long> pages_by_node;
@@ -292,7 +408,6 @@ int main(int argc, char** argv) {
 
       const std::vector<std::string> keys = {
           "numa_hit", "numa_miss", "numa_foreign", "interleave_hit", "local_node", "other_node"};
-      double interval_sec = static_cast<double>(config.interval_ms) / 1000.0;
       std::vector<long long> local_delta(nodes, 0);
       std::vector<long long> other_delta(nodes, 0);
 
@@ -344,6 +459,19 @@ int main(int argc, char** argv) {
       }
     }
 
+    // 引擎自身的计数：按帧所在分片区分本地/远端访问，与上面的内核页统计对照。
+    std::vector<EngineNodeValues> engine;
+    err.clear();
+    if (read_engine_metrics(config.pid, &engine, &err)) {
+      print_engine_metrics(engine, prev_engine, has_prev_engine, interval_sec);
+      prev_engine = std::move(engine);
+      has_prev_engine = true;
+    } else {
+      std::cout << "Engine NUMA stats: unavailable (" << err << ")\n";
+      prev_engine.clear();
+      has_prev_engine = false;
+    }
+
     std::cout << "----\n";
     if (!metrics.empty()) {
       prev_metrics = metrics;